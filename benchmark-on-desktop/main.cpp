@@ -0,0 +1,252 @@
+/******************************************************************************/
+/* File name        : main.cpp                                                */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Compiler         : Desktop C++ COMPILER (Visual Studio Code)               */
+/* Description      : Loopback benchmark scenarios on a simulated controller  */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation                                                        */
+/* ---------------------------------------------------------------------------*/
+
+// Usage: benchmark [poll period in us] [wake latency in us]  (defaults: 10 and 15)
+// Runs the scenarios of examples/LoopBackBenchmark (ACANBenchmarkScenario) against a simulated controller in
+// LoopBackMode and prints the same CSV lines (target "host"), so both outputs can be compared or plotted together.
+// The simulated controller is the virtual bus (exact stuffed frame durations) with the driver structures of
+// ESP32ACAN: one TX register, driver transmit buffer (16) and receive buffer (32), and in PollingControlled mode the
+// 64 byte controller receive FIFO (frame information, identifier and data bytes per frame), which overruns if the
+// application does not poll in time. The application model:
+//   - polling: the application polls every poll period (fixed grid, frames sent at random phases);
+//   - interrupt: the application task runs wake latency after each interrupt.
+// Interrupts take no time and the CPU load is not simulated (empty CSV field).
+// Exit status is 1 if a scenario loses frames or if interrupt mode does not keep the bus saturated.
+
+/*------------------------------- Include files ------------------------------*/
+#include <iostream>
+#include <deque>
+#include <stdlib.h>
+#include "../src/ACANBenchmark.cpp"
+#include "../src/ACANBuffer16.h"
+#include "../src/ACANBufferStatistics.cpp"
+#include "../simulation-on-desktop/VirtualCANBus.cpp"
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+using namespace std;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static const uint64_t kThroughputDuration = 1000ULL * 1000 * 1000 ; // 1 s
+static const uint32_t kLatencySampleCount = 1000 ;
+static const uint32_t kControllerFIFOSize = 64 ; // Bytes
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Simulated ESP32 controller and driver, in LoopBackMode: the controller receives the frames it sends
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+class SimulatedLoopBackController {
+
+  public: SimulatedLoopBackController (const uint32_t inBitRate, const ACANBenchmarkScenario::Mode inMode) :
+  mBus (inBitRate),
+  mController (1, 0), // TX register; own frames are received through the bus observer
+  mMode (inMode),
+  mTransmitBuffer (),
+  mReceiveBuffer (),
+  mFIFO (),
+  mFIFOByteCount (0),
+  mLostCount (0),
+  mLastReceptionDate (0) {
+    mBus.attach (mController) ;
+    mBus.setObserver (endOfFrame, this) ;
+    mTransmitBuffer.initWithSize (16) ;
+    mReceiveBuffer.initWithSize (32) ;
+  }
+
+  //--- Frame on the wire completed: receive (self reception) and transmit interrupts, or controller FIFO
+  private: static void endOfFrame (void * inContext,
+                                   const VirtualCANNode & /* inSender */,
+                                   const CANMessage & inFrame,
+                                   const uint64_t inEndDate) {
+    SimulatedLoopBackController * controller = (SimulatedLoopBackController *) inContext ;
+    controller->mLastReceptionDate = inEndDate ;
+    if (controller->mMode == ACANBenchmarkScenario::Interrupt) {
+      if (!controller->mReceiveBuffer.append (inFrame)) {
+        controller->mLostCount += 1 ;
+      }
+      CANMessage frame ;
+      if (controller->mTransmitBuffer.remove (frame)) {
+        controller->mController.tryToSend (frame) ;
+      }
+    }else{
+      const uint32_t bytes = fifoByteCount (inFrame) ;
+      if ((controller->mFIFOByteCount + bytes) <= kControllerFIFOSize) {
+        controller->mFIFO.push_back (inFrame) ;
+        controller->mFIFOByteCount += bytes ;
+      }else{
+        controller->mLostCount += 1 ; // Data overrun
+      }
+    }
+  }
+
+  private: static uint32_t fifoByteCount (const CANMessage & inFrame) {
+    return (inFrame.ext ? 5 : 3) + (inFrame.rtr ? 0 : inFrame.len) ;
+  }
+
+  //--- Same behaviour as ESP32ACAN::tryToSend and ESP32ACAN::receive
+  public: bool tryToSend (const CANMessage & inFrame) {
+    bool ok ;
+    if (mMode == ACANBenchmarkScenario::Polling) {
+      ok = mController.tryToSend (inFrame) ;
+    }else if (mController.transmitBufferCount () > 0) {
+      ok = mTransmitBuffer.append (inFrame) ;
+    }else{
+      ok = mController.tryToSend (inFrame) ;
+    }
+    return ok ;
+  }
+
+  public: bool receive (CANMessage & outFrame) {
+    while (!mFIFO.empty () && mReceiveBuffer.append (mFIFO.front ())) {
+      mFIFOByteCount -= fifoByteCount (mFIFO.front ()) ;
+      mFIFO.pop_front () ;
+    }
+    return mReceiveBuffer.remove (outFrame) ;
+  }
+
+  public: VirtualCANBus mBus ;
+  private: VirtualCANNode mController ;
+  private: const ACANBenchmarkScenario::Mode mMode ;
+  private: ACANBuffer16 mTransmitBuffer ;
+  private: ACANBuffer16 mReceiveBuffer ;
+  private: deque <CANMessage> mFIFO ;
+  private: uint32_t mFIFOByteCount ;
+  public: uint32_t mLostCount ;
+  public: uint64_t mLastReceptionDate ;
+} ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Pseudo random phases of the latency phase
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static uint32_t gSeed = 123456789 ;
+
+static uint32_t randomValue (void) {
+  gSeed = gSeed * 1103515245 + 12345 ;
+  return gSeed >> 8 ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Application model: next date the application runs after inDate
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static uint64_t gPollPeriod = 10 * 1000 ;
+static uint64_t gWakeLatency = 15 * 1000 ;
+
+static uint64_t nextApplicationDate (SimulatedLoopBackController & ioController,
+                                     const ACANBenchmarkScenario::Mode inMode,
+                                     const uint64_t inDate,
+                                     const uint64_t inLimit) {
+  uint64_t date ;
+  if (inMode == ACANBenchmarkScenario::Polling) {
+    date = (inDate / gPollPeriod + 1) * gPollPeriod ; // Polls on a fixed grid
+    ioController.mBus.runUntil (date) ;
+  }else{ // Sleeps until the next interrupt
+    date = ioController.mBus.runUntilNextFrameEnd (inLimit) ;
+    if (date < inLimit) {
+      date += gWakeLatency ;
+      ioController.mBus.runUntil (date) ;
+    }
+  }
+  return date ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Scenario: throughput phase (bus saturated during 1 s, then drained), latency phase (one frame at a time)
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static ACANBenchmarkResult runScenario (const ACANBenchmarkScenario & inScenario) {
+  ACANBenchmarkResult result ;
+  result.mActualBitRate = inScenario.mBitRate ;
+  const CANMessage frame = inScenario.frame () ;
+  SimulatedLoopBackController controller (inScenario.mBitRate, inScenario.mMode) ;
+//--- Throughput
+  uint64_t date = 0 ;
+  CANMessage received ;
+  while (date < kThroughputDuration) {
+    while (controller.receive (received)) {
+      result.mReceivedCount += 1 ;
+    }
+    while (controller.tryToSend (frame)) {
+      result.mSentCount += 1 ;
+    }
+    date = nextApplicationDate (controller, inScenario.mMode, date, kThroughputDuration) ;
+  }
+  const uint64_t drainLimit = date + 100ULL * 1000 * 1000 ;
+  while ((result.mReceivedCount + controller.mLostCount) < result.mSentCount) {
+    while (controller.receive (received)) {
+      result.mReceivedCount += 1 ;
+    }
+    date = nextApplicationDate (controller, inScenario.mMode, date, drainLimit) ;
+    if (date >= drainLimit) {
+      break ;
+    }
+  }
+  result.mDurationMicroseconds = uint32_t (controller.mLastReceptionDate / 1000) ;
+//--- Latency: from the end of the frame on the wire to its return by receive
+  static uint32_t samples [kLatencySampleCount] ;
+  uint32_t sampleCount = 0 ;
+  while (sampleCount < kLatencySampleCount) {
+    controller.mBus.runUntil (date) ;
+    controller.tryToSend (frame) ;
+    const uint64_t limit = date + 100ULL * 1000 * 1000 ;
+    bool done = false ;
+    while (!done && (date < limit)) {
+      date = nextApplicationDate (controller, inScenario.mMode, date, limit) ;
+      done = controller.receive (received) ;
+    }
+    samples [sampleCount] = uint32_t (date - controller.mLastReceptionDate) ;
+    sampleCount += 1 ;
+    date += randomValue () % gPollPeriod ; // Next frame at another phase relative to the polling
+  }
+  result.setLatencies (samples, sampleCount) ;
+  return result ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+int main (int argc, const char * argv []) {
+  if (argc > 1) {
+    gPollPeriod = uint64_t (atof (argv [1]) * 1000.0) ;
+  }
+  if (argc > 2) {
+    gWakeLatency = uint64_t (atof (argv [2]) * 1000.0) ;
+  }
+  bool ok = gPollPeriod > 0 ;
+  char line [256] ;
+  ACANBenchmarkReport::header (line, sizeof (line)) ;
+  cout << line << endl ;
+  for (uint16_t i=0 ; ok && (i<ACANBenchmarkScenario::count ()) ; i++) {
+    const ACANBenchmarkScenario scenario = ACANBenchmarkScenario::atIndex (i) ;
+    const ACANBenchmarkResult result = runScenario (scenario) ;
+    ACANBenchmarkReport::line (line, sizeof (line), "host", scenario, result) ;
+    cout << line << endl ;
+    const uint32_t maximum = scenario.theoreticalFramesPerSecond (result.mActualBitRate) ;
+    if (result.lostCount () != 0) {
+      cerr << "Scenario " << i << ": " << result.lostCount () << " frames lost" << endl ;
+      ok = false ;
+    }
+    if ((scenario.mMode == ACANBenchmarkScenario::Interrupt) && ((result.framesPerSecond () * 100ULL) < (maximum * 99ULL))) {
+      cerr << "Scenario " << i << ": bus not saturated in interrupt mode" << endl ;
+      ok = false ;
+    }
+  }
+  return ok ? 0 : 1 ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
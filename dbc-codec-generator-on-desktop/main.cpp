@@ -0,0 +1,415 @@
+/******************************************************************************/
+/* File name        : main.cpp                                                */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Compiler         : Desktop C++ COMPILER (Visual Studio Code)               */
+/* Description      : Generates a C++ signal codec header from a .dbc file    */
+/*                    usage: dbc-codec-generator input.dbc output.h namespace */
+/*                           [--include-prefix prefix]                        */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation                                                        */
+/* ---------------------------------------------------------------------------*/
+
+/*------------------------------- Include files ------------------------------*/
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <regex>
+#include <algorithm>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+using namespace std;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  DBC MODEL
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+class Signal {
+  public: string mName ;
+  public: string mMultiplexing ;   // "", "M" (multiplexor) or "mN"
+  public: uint32_t mStartBit ;
+  public: uint32_t mLength ;
+  public: bool mIntel ;            // @1: little endian, @0: big endian (Motorola)
+  public: bool mSigned ;
+  public: double mFactor ;
+  public: double mOffset ;
+  public: string mMinimum ;
+  public: string mMaximum ;
+  public: string mUnit ;
+  public: uint32_t mShift ;        // Shift in the Intel or Motorola 64-bit word
+} ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+class Message {
+  public: uint32_t mKey ;          // .dbc identifier: bit 31 set for an extended frame
+  public: string mName ;
+  public: uint32_t mLength ;
+  public: vector <Signal> mSignals ;
+} ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void fatal (const string & inMessage) {
+  cerr << "error: " << inMessage << endl ;
+  exit (1) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+// Motorola start bit is the most significant bit, in the sawtooth numbering of the .dbc (byte * 8 + bit, bit 7 is the
+// most significant bit of the byte). In the byte swapped word, this bit is at (7 - byte) * 8 + bit.
+
+static void computeShift (const Message & inMessage, Signal & ioSignal) {
+  int32_t shift ;
+  if (ioSignal.mIntel) {
+    shift = (int32_t) ioSignal.mStartBit ;
+    if ((ioSignal.mStartBit + ioSignal.mLength) > 64) {
+      shift = -1 ;
+    }
+  }else{
+    shift = (7 - (int32_t) (ioSignal.mStartBit / 8)) * 8 + (int32_t) (ioSignal.mStartBit % 8) - (int32_t) ioSignal.mLength + 1 ;
+  }
+  if ((shift < 0) || (ioSignal.mLength == 0) || (ioSignal.mLength > 64) || (ioSignal.mStartBit > 63)) {
+    fatal ("signal " + inMessage.mName + "." + ioSignal.mName + " does not fit in 8 bytes") ;
+  }
+  ioSignal.mShift = (uint32_t) shift ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static vector <Message> readDBC (const char * inPath) {
+  ifstream file (inPath) ;
+  if (!file.good ()) {
+    fatal (string ("cannot open ") + inPath) ;
+  }
+  const regex messageRegex ("^BO_\\s+(\\d+)\\s+(\\w+)\\s*:\\s*(\\d+)\\s+\\w+") ;
+  const regex signalRegex ("^\\s+SG_\\s+(\\w+)\\s*(M|m\\d+)?\\s*:\\s*(\\d+)\\|(\\d+)@([01])([+-])\\s*"
+                           "\\(([^,]+),([^)]+)\\)\\s*\\[([^|]*)\\|([^\\]]*)\\]\\s*\"([^\"]*)\"") ;
+  vector <Message> result ;
+  string line ;
+  bool inMessage = false ;
+  while (getline (file, line)) {
+    smatch m ;
+    if (regex_search (line, m, messageRegex)) {
+      Message message ;
+      message.mKey = (uint32_t) strtoul (m [1].str ().c_str (), NULL, 10) ;
+      message.mName = m [2] ;
+      message.mLength = (uint32_t) strtoul (m [3].str ().c_str (), NULL, 10) ;
+      inMessage = message.mKey != 0xC0000000UL ; // VECTOR__INDEPENDENT_SIG_MSG
+      if (inMessage) {
+        result.push_back (message) ;
+      }
+    }else if (inMessage && regex_search (line, m, signalRegex)) {
+      Signal signal ;
+      signal.mName = m [1] ;
+      signal.mMultiplexing = m [2] ;
+      signal.mStartBit = (uint32_t) strtoul (m [3].str ().c_str (), NULL, 10) ;
+      signal.mLength = (uint32_t) strtoul (m [4].str ().c_str (), NULL, 10) ;
+      signal.mIntel = m [5] == "1" ;
+      signal.mSigned = m [6] == "-" ;
+      signal.mFactor = strtod (m [7].str ().c_str (), NULL) ;
+      signal.mOffset = strtod (m [8].str ().c_str (), NULL) ;
+      signal.mMinimum = m [9] ;
+      signal.mMaximum = m [10] ;
+      signal.mUnit = m [11] ;
+      if (signal.mFactor == 0.0) {
+        fatal ("signal " + result.back ().mName + "." + signal.mName + " has a null factor") ;
+      }
+      computeShift (result.back (), signal) ;
+      result.back ().mSignals.push_back (signal) ;
+    }else if (line.find ("BO_") == 0) {
+      fatal ("cannot parse: " + line) ;
+    }else if (line.find_first_not_of (" \t\r") == string::npos) {
+      inMessage = false ;
+    }
+  }
+  sort (result.begin (), result.end (), [] (const Message & a, const Message & b) { return a.mKey < b.mKey ; }) ;
+  for (size_t i=1 ; i<result.size () ; i++) {
+    if (result [i].mKey == result [i-1].mKey) {
+      fatal ("duplicate identifier for " + result [i-1].mName + " and " + result [i].mName) ;
+    }
+  }
+  return result ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  CODE GENERATION
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+typedef enum {kRaw, kInteger, kFloat} ValueKind ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+// kRaw: factor 1, offset 0, the value is the raw field. kInteger: integral factor and offset. kFloat otherwise.
+
+static ValueKind valueKind (const Signal & inSignal) {
+  ValueKind result = kFloat ;
+  if ((inSignal.mFactor == 1.0) && (inSignal.mOffset == 0.0)) {
+    result = kRaw ;
+  }else if ((inSignal.mFactor == floor (inSignal.mFactor)) && (inSignal.mOffset == floor (inSignal.mOffset))
+         && (fabs (inSignal.mFactor) < 1.0e9) && (fabs (inSignal.mOffset) < 1.0e15)) {
+    result = kInteger ;
+  }
+  return result ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static string valueType (const Signal & inSignal) {
+  string result = "float" ;
+  const ValueKind kind = valueKind (inSignal) ;
+  if (kind == kRaw) {
+    const uint32_t bits = (inSignal.mLength <= 8) ? 8 : (inSignal.mLength <= 16) ? 16 : (inSignal.mLength <= 32) ? 32 : 64 ;
+    result = string (inSignal.mSigned ? "int" : "uint") + to_string (bits) + "_t" ;
+  }else if (kind == kInteger) {
+    result = (inSignal.mLength < 32) ? "int32_t" : "int64_t" ;
+  }
+  return result ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static string floatLiteral (const double inValue) {
+  char s [40] ;
+  snprintf (s, sizeof (s), "%.9g", inValue) ;
+  string result = s ;
+  if (result.find_first_of (".en") == string::npos) {
+    result += ".0" ;
+  }
+  return result + "f" ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static string integerLiteral (const double inValue) {
+  return to_string ((long long) inValue) + "LL" ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static string rawExpression (const Signal & inSignal) {
+  const string shift = to_string (inSignal.mShift) ;
+  const string length = to_string (inSignal.mLength) ;
+  string result = "ACANSignalCodec::extract (inWord, " + shift + ", " + length + ")" ;
+  if (inSignal.mSigned) {
+    result = "ACANSignalCodec::signExtend (" + result + ", " + length + ")" ;
+  }
+  return result ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void generateSignal (ostream & outCode, const Signal & inSignal) {
+  const string type = valueType (inSignal) ;
+  const string word = inSignal.mIntel ? "Intel" : "Motorola" ;
+  const ValueKind kind = valueKind (inSignal) ;
+  string decode ;
+  string encode ;
+  switch (kind) {
+  case kRaw :
+    decode = "(" + type + ") " + rawExpression (inSignal) ;
+    encode = "(uint64_t) inValue" ;
+    break ;
+  case kInteger :
+    decode = "(" + type + ") (" + rawExpression (inSignal) + " * " + integerLiteral (inSignal.mFactor)
+      + " + " + integerLiteral (inSignal.mOffset) + ")" ;
+    encode = "(uint64_t) (((int64_t) inValue - " + integerLiteral (inSignal.mOffset) + ") / "
+      + integerLiteral (inSignal.mFactor) + ")" ;
+    break ;
+  case kFloat :
+    decode = "(float) " + rawExpression (inSignal) + " * " + floatLiteral (inSignal.mFactor) ;
+    if (inSignal.mOffset != 0.0) {
+      decode += " + " + floatLiteral (inSignal.mOffset) ;
+    }
+    encode = "(uint64_t) ACANSignalCodec::toRaw (inValue, " + floatLiteral (1.0 / inSignal.mFactor) + ", "
+      + floatLiteral (inSignal.mOffset) + ")" ;
+    break ;
+  }
+  outCode << "  public: static constexpr " << type << " decode" << inSignal.mName
+          << " (const uint64_t inWord) { // " << word << " word\n"
+          << "    return " << decode << " ;\n"
+          << "  }\n\n"
+          << "  public: static constexpr uint64_t encode" << inSignal.mName << " (const " << type << " inValue) {\n"
+          << "    return ACANSignalCodec::insert (" << encode << ", " << inSignal.mShift << ", " << inSignal.mLength
+          << ") ;\n"
+          << "  }\n\n" ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static const string SEPARATOR =
+  "//----------------------------------------------------------------------------------------------------------------------\n" ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void generateMessage (ostream & outCode, const Message & inMessage) {
+  const bool extended = (inMessage.mKey & 0x80000000UL) != 0 ;
+  char identifier [16] ;
+  snprintf (identifier, sizeof (identifier), "0x%0*X", extended ? 8 : 3, (unsigned) (inMessage.mKey & 0x1FFFFFFFUL)) ;
+  bool hasIntel = false ;
+  bool hasMotorola = false ;
+  for (const Signal & s : inMessage.mSignals) {
+    hasIntel |= s.mIntel ;
+    hasMotorola |= !s.mIntel ;
+  }
+  outCode << SEPARATOR << "\nclass " << inMessage.mName << " {\n"
+          << "  public: static constexpr uint32_t kIdentifier = " << identifier << " ;\n"
+          << "  public: static constexpr bool kExtended = " << (extended ? "true" : "false") << " ;\n"
+          << "  public: static constexpr uint8_t kLength = " << inMessage.mLength << " ;\n\n" ;
+//--- Values
+  for (const Signal & s : inMessage.mSignals) {
+    string comment = s.mUnit.empty () ? "" : (" " + s.mUnit) ;
+    comment += " [" + s.mMinimum + " ... " + s.mMaximum + "]" ;
+    if (s.mMultiplexing == "M") {
+      comment += ", multiplexor" ;
+    }else if (!s.mMultiplexing.empty ()) {
+      comment += ", valid if multiplexor is " + s.mMultiplexing.substr (1) ;
+    }
+    outCode << "  public: " << valueType (s) << " " << s.mName << " = 0 ; //" << comment << "\n" ;
+  }
+  outCode << "\n" ;
+//--- Signal codecs
+  for (const Signal & s : inMessage.mSignals) {
+    generateSignal (outCode, s) ;
+  }
+//--- Unpack
+  outCode << "  public: static inline void unpack (const CANMessage & inFrame, " << inMessage.mName
+          << " & outMessage) {\n" ;
+  if (hasIntel) {
+    outCode << "    const uint64_t intel = ACANSignalCodec::intelWord (inFrame) ;\n" ;
+  }
+  if (hasMotorola) {
+    outCode << "    const uint64_t motorola = ACANSignalCodec::motorolaWord (inFrame) ;\n" ;
+  }
+  if (!hasIntel && !hasMotorola) {
+    outCode << "    (void) inFrame ; (void) outMessage ;\n" ;
+  }
+  for (const Signal & s : inMessage.mSignals) {
+    outCode << "    outMessage." << s.mName << " = decode" << s.mName << " (" << (s.mIntel ? "intel" : "motorola")
+            << ") ;\n" ;
+  }
+  outCode << "  }\n\n" ;
+//--- Pack
+  outCode << "  public: inline void pack (CANMessage & outFrame) const {\n" ;
+  string intel = "0" ;
+  string motorola = "0" ;
+  for (const Signal & s : inMessage.mSignals) {
+    string & word = s.mIntel ? intel : motorola ;
+    word = ((word == "0") ? "" : (word + "\n      | ")) + "encode" + s.mName + " (" + s.mName + ")" ;
+  }
+  outCode << "    outFrame.id = kIdentifier ;\n"
+          << "    outFrame.ext = kExtended ;\n"
+          << "    outFrame.rtr = false ;\n"
+          << "    outFrame.len = kLength ;\n"
+          << "    const uint64_t intel = " << intel << " ;\n"
+          << "    const uint64_t motorola = " << motorola << " ;\n"
+          << "    outFrame.data64 = intel | ACANSignalCodec::byteSwap (motorola) ;\n"
+          << "  }\n"
+          << "} ;\n\n" ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void generateDispatch (ostream & outCode, const vector <Message> & inMessages) {
+  outCode << SEPARATOR << "//   Identifier -> decoder dispatch: set the handlers of the messages to decode, then call dispatch\n"
+          << SEPARATOR << "\nclass Handlers {\n" ;
+  for (const Message & m : inMessages) {
+    outCode << "  public: void (*m" << m.mName << ") (const " << m.mName << " & inMessage) = nullptr ;\n" ;
+  }
+  outCode << "} ;\n\n" ;
+  for (const Message & m : inMessages) {
+    outCode << "static inline bool decode" << m.mName << " (const CANMessage & inFrame, const Handlers & inHandlers) {\n"
+            << "  const bool ok = (inFrame.len >= " << m.mName << "::kLength) && (inHandlers.m" << m.mName
+            << " != nullptr) ;\n"
+            << "  if (ok) {\n"
+            << "    " << m.mName << " message ;\n"
+            << "    " << m.mName << "::unpack (inFrame, message) ;\n"
+            << "    inHandlers.m" << m.mName << " (message) ;\n"
+            << "  }\n"
+            << "  return ok ;\n"
+            << "}\n\n" ;
+  }
+  outCode << "static const ACANSignalDispatchEntry <Handlers> kDispatchTable [" << inMessages.size () << "] = {\n" ;
+  for (const Message & m : inMessages) {
+    char key [16] ;
+    snprintf (key, sizeof (key), "0x%08X", (unsigned) m.mKey) ;
+    outCode << "  {" << key << "UL, decode" << m.mName << "},\n" ;
+  }
+  outCode << "} ;\n\n"
+          << "inline bool dispatch (const CANMessage & inFrame, const Handlers & inHandlers) {\n"
+          << "  return dispatchSignalFrame (kDispatchTable, " << inMessages.size () << ", inFrame, inHandlers) ;\n"
+          << "}\n\n" ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static string baseName (const string & inPath) {
+  const size_t slash = inPath.find_last_of ("/\\") ;
+  return (slash == string::npos) ? inPath : inPath.substr (slash + 1) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+// inIncludePrefix is prepended to ACANSignalCodec.h in the generated #include: empty for an Arduino sketch (the library
+// directory is in the include path), "../src/" for a desktop program built next to this repository without -I.
+
+static void generate (ostream & outCode, const string & inDBCPath, const string & inNamespace,
+                      const string & inIncludePrefix, const vector <Message> & inMessages) {
+  string guard = inNamespace ;
+  transform (guard.begin (), guard.end (), guard.begin (), ::toupper) ;
+  guard += "_SIGNAL_CODEC_DEFINED" ;
+  outCode << "// Generated by dbc-codec-generator-on-desktop from " << baseName (inDBCPath) << ", do not edit.\n"
+          << "// unpack / pack are branch free; every decodeXxx / encodeXxx signal routine is constexpr.\n"
+          << "// Multiplexed signals are always decoded, check the multiplexor value before using them.\n\n"
+          << "#ifndef " << guard << "\n#define " << guard << "\n\n"
+          << "#include \"" << inIncludePrefix << "ACANSignalCodec.h\"\n\n"
+          << "namespace " << inNamespace << " {\n\n" ;
+  for (const Message & m : inMessages) {
+    generateMessage (outCode, m) ;
+  }
+  generateDispatch (outCode, inMessages) ;
+  outCode << SEPARATOR << "\n} // namespace " << inNamespace << "\n\n#endif\n" ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   MAIN
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+int main (int argc, const char * argv []) {
+  const bool hasIncludePrefix = (argc == 6) && (string (argv [4]) == "--include-prefix") ;
+  if ((argc != 4) && !hasIncludePrefix) {
+    cerr << "usage: " << argv [0] << " input.dbc output.h namespace [--include-prefix prefix]" << endl ;
+    return 1 ;
+  }
+  const string includePrefix = hasIncludePrefix ? argv [5] : "" ;
+  const vector <Message> messages = readDBC (argv [1]) ;
+  if (messages.size () == 0) {
+    fatal ("no message in " + string (argv [1])) ;
+  }
+  ofstream output (argv [2]) ;
+  if (!output.good ()) {
+    fatal (string ("cannot create ") + argv [2]) ;
+  }
+  generate (output, argv [1], argv [3], includePrefix, messages) ;
+  uint32_t signalCount = 0 ;
+  for (const Message & m : messages) {
+    signalCount += (uint32_t) m.mSignals.size () ;
+  }
+  cout << messages.size () << " messages, " << signalCount << " signals -> " << argv [2] << endl ;
+  return 0 ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
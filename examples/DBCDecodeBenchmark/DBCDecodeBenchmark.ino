@@ -0,0 +1,144 @@
+/******************************************************************************/
+/* File name        : DBCDecodeBenchmark.ino                                  */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Description      : Cycles per frame of the signal codec generated from     */
+/*                    test-DBCCodec-on-desktop/vehicle.dbc                    */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+
+/*------------------------------- Board Check --------------------------------*/
+#ifndef ARDUINO_ARCH_ESP32
+  #error "Select an ESP32 board" 
+#endif
+
+/*------------------------------- Include files ------------------------------*/
+#include "ESP32ACAN.h"
+#include "vehicle.h"   // dbc-codec-generator vehicle.dbc vehicle.h vehicle
+
+//——————————————————————————————————————————————————————————————————————————————
+//  ESP32 CAN Driver
+//——————————————————————————————————————————————————————————————————————————————
+
+ESP32ACAN can ;
+
+static const uint32_t DESIRED_BIT_RATE = 500UL * 1000UL ; // 500 kb/s
+
+//——————————————————————————————————————————————————————————————————————————————
+//  Decoded values
+//——————————————————————————————————————————————————————————————————————————————
+
+static volatile float gEngineSpeed ;
+static volatile float gSteeringAngle ;
+static volatile float gWheelSpeed ;
+static volatile uint32_t gDecodedCount ;
+
+static void handleEEC1 (const vehicle::EEC1 & inMessage) {
+  gEngineSpeed = inMessage.EngineSpeed ;
+  gDecodedCount += 1 ;
+}
+
+static void handleChassis (const vehicle::Chassis & inMessage) {
+  gSteeringAngle = inMessage.SteeringAngle ;
+  gDecodedCount += 1 ;
+}
+
+static void handleWheelSpeeds (const vehicle::WheelSpeeds & inMessage) {
+  gWheelSpeed = inMessage.FrontLeft ;
+  gDecodedCount += 1 ;
+}
+
+static vehicle::Handlers gHandlers ;
+
+//——————————————————————————————————————————————————————————————————————————————
+//  Benchmark: dispatch and decode of frames in RAM
+//——————————————————————————————————————————————————————————————————————————————
+
+static const uint32_t FRAME_COUNT = 64 ;
+static CANMessage gFrames [FRAME_COUNT] ;
+
+static void benchmark (void) {
+  const uint32_t keys [4] = {
+    vehicle::EEC1::kIdentifier | 0x80000000UL, vehicle::Chassis::kIdentifier,
+    vehicle::WheelSpeeds::kIdentifier, 0x7DF  // Unknown identifier
+  } ;
+  for (uint32_t i=0 ; i<FRAME_COUNT ; i++) {
+    gFrames [i].id = keys [i % 4] & 0x1FFFFFFFUL ;
+    gFrames [i].ext = (keys [i % 4] & 0x80000000UL) != 0 ;
+    gFrames [i].len = 8 ;
+    gFrames [i].data32 [0] = esp_random () ;
+    gFrames [i].data32 [1] = esp_random () ;
+  }
+  const uint32_t start = ESP.getCycleCount () ;
+  for (uint32_t i=0 ; i<FRAME_COUNT ; i++) {
+    vehicle::dispatch (gFrames [i], gHandlers) ;
+  }
+  const uint32_t dispatchCycles = ESP.getCycleCount () - start ;
+  const uint32_t unpackStart = ESP.getCycleCount () ;
+  vehicle::EEC1 eec1 ;
+  for (uint32_t i=0 ; i<FRAME_COUNT ; i++) {
+    vehicle::EEC1::unpack (gFrames [i], eec1) ;
+    gEngineSpeed = eec1.EngineSpeed ;
+  }
+  const uint32_t unpackCycles = ESP.getCycleCount () - unpackStart ;
+  Serial.print ("Dispatch + decode: ") ;
+  Serial.print (dispatchCycles / FRAME_COUNT) ;
+  Serial.print (" cycles/frame, EEC1::unpack: ") ;
+  Serial.print (unpackCycles / FRAME_COUNT) ;
+  Serial.print (" cycles/frame (CPU ") ;
+  Serial.print (ESP.getCpuFreqMHz ()) ;
+  Serial.println (" MHz)") ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————
+//   SETUP
+//——————————————————————————————————————————————————————————————————————————————
+
+void setup () {
+//--- Start serial
+  Serial.begin (115200) ;
+  while (!Serial) {
+    delay (50) ;
+  }
+//--- Handlers of the decoded messages
+  gHandlers.mEEC1 = handleEEC1 ;
+  gHandlers.mChassis = handleChassis ;
+  gHandlers.mWheelSpeeds = handleWheelSpeeds ;
+//--- Configure ESP32 CAN, loop back: every packed frame is decoded on reception
+  ESP32ACANSettings settings (DESIRED_BIT_RATE) ;
+  settings.mRequestedCANMode = ESP32ACANSettings::LoopBackMode ;
+  const uint32_t errorCode = can.begin (settings) ;
+  if (errorCode != 0) {
+    Serial.print ("Configuration error 0x") ;
+    Serial.println (errorCode, HEX) ;
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————
+//   LOOP
+//——————————————————————————————————————————————————————————————————————————————
+
+static uint32_t gBenchmarkDate = 0 ;
+
+void loop () {
+  if (gBenchmarkDate <= millis ()) {
+    gBenchmarkDate += 2000 ;
+    benchmark () ;
+  //--- Pack a message, decode it back through the bus
+    vehicle::Chassis chassis ;
+    chassis.SteeringAngle = -123.4f ;
+    chassis.Gear = 3 ;
+    CANMessage frame ;
+    chassis.pack (frame) ;
+    can.tryToSend (frame) ;
+  }
+  CANMessage frame ;
+  if (can.receive (frame) && vehicle::dispatch (frame, gHandlers)) {
+    Serial.print ("Received steering angle: ") ;
+    Serial.println (gSteeringAngle) ;
+  }
+}
@@ -0,0 +1,698 @@
+// Generated by dbc-codec-generator-on-desktop from vehicle.dbc, do not edit.
+// unpack / pack are branch free; every decodeXxx / encodeXxx signal routine is constexpr.
+// Multiplexed signals are always decoded, check the multiplexor value before using them.
+
+#ifndef VEHICLE_SIGNAL_CODEC_DEFINED
+#define VEHICLE_SIGNAL_CODEC_DEFINED
+
+#include "ACANSignalCodec.h"
+
+namespace vehicle {
+
+//----------------------------------------------------------------------------------------------------------------------
+
+class WheelSpeeds {
+  public: static constexpr uint32_t kIdentifier = 0x123 ;
+  public: static constexpr bool kExtended = false ;
+  public: static constexpr uint8_t kLength = 8 ;
+
+  public: float FrontLeft = 0 ; // km/h [0 ... 655.35]
+  public: float FrontRight = 0 ; // km/h [0 ... 655.35]
+  public: float RearLeft = 0 ; // km/h [0 ... 655.35]
+  public: float RearRight = 0 ; // km/h [0 ... 655.35]
+
+  public: static constexpr float decodeFrontLeft (const uint64_t inWord) { // Motorola word
+    return (float) ACANSignalCodec::extract (inWord, 48, 16) * 0.01f ;
+  }
+
+  public: static constexpr uint64_t encodeFrontLeft (const float inValue) {
+    return ACANSignalCodec::insert ((uint64_t) ACANSignalCodec::toRaw (inValue, 100.0f, 0.0f), 48, 16) ;
+  }
+
+  public: static constexpr float decodeFrontRight (const uint64_t inWord) { // Motorola word
+    return (float) ACANSignalCodec::extract (inWord, 32, 16) * 0.01f ;
+  }
+
+  public: static constexpr uint64_t encodeFrontRight (const float inValue) {
+    return ACANSignalCodec::insert ((uint64_t) ACANSignalCodec::toRaw (inValue, 100.0f, 0.0f), 32, 16) ;
+  }
+
+  public: static constexpr float decodeRearLeft (const uint64_t inWord) { // Motorola word
+    return (float) ACANSignalCodec::extract (inWord, 16, 16) * 0.01f ;
+  }
+
+  public: static constexpr uint64_t encodeRearLeft (const float inValue) {
+    return ACANSignalCodec::insert ((uint64_t) ACANSignalCodec::toRaw (inValue, 100.0f, 0.0f), 16, 16) ;
+  }
+
+  public: static constexpr float decodeRearRight (const uint64_t inWord) { // Motorola word
+    return (float) ACANSignalCodec::extract (inWord, 0, 16) * 0.01f ;
+  }
+
+  public: static constexpr uint64_t encodeRearRight (const float inValue) {
+    return ACANSignalCodec::insert ((uint64_t) ACANSignalCodec::toRaw (inValue, 100.0f, 0.0f), 0, 16) ;
+  }
+
+  public: static inline void unpack (const CANMessage & inFrame, WheelSpeeds & outMessage) {
+    const uint64_t motorola = ACANSignalCodec::motorolaWord (inFrame) ;
+    outMessage.FrontLeft = decodeFrontLeft (motorola) ;
+    outMessage.FrontRight = decodeFrontRight (motorola) ;
+    outMessage.RearLeft = decodeRearLeft (motorola) ;
+    outMessage.RearRight = decodeRearRight (motorola) ;
+  }
+
+  public: inline void pack (CANMessage & outFrame) const {
+    outFrame.id = kIdentifier ;
+    outFrame.ext = kExtended ;
+    outFrame.rtr = false ;
+    outFrame.len = kLength ;
+    const uint64_t intel = 0 ;
+    const uint64_t motorola = encodeFrontLeft (FrontLeft)
+      | encodeFrontRight (FrontRight)
+      | encodeRearLeft (RearLeft)
+      | encodeRearRight (RearRight) ;
+    outFrame.data64 = intel | ACANSignalCodec::byteSwap (motorola) ;
+  }
+} ;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+class Chassis {
+  public: static constexpr uint32_t kIdentifier = 0x124 ;
+  public: static constexpr bool kExtended = false ;
+  public: static constexpr uint8_t kLength = 8 ;
+
+  public: float SteeringAngle = 0 ; // deg [-819.2 ... 819.1]
+  public: float YawRate = 0 ; // deg/s [-102.4 ... 102.35]
+  public: float LateralAcceleration = 0 ; // g [-5.12 ... 5.11]
+  public: uint8_t BrakePressed = 0 ; // [0 ... 1]
+  public: uint8_t ParkingBrake = 0 ; // [0 ... 1]
+  public: uint8_t Gear = 0 ; // [0 ... 7]
+  public: uint8_t RollingCounter = 0 ; // [0 ... 15]
+  public: uint8_t Checksum = 0 ; // [0 ... 255]
+
+  public: static constexpr float decodeSteeringAngle (const uint64_t inWord) { // Motorola word
+    return (float) ACANSignalCodec::signExtend (ACANSignalCodec::extract (inWord, 50, 14), 14) * 0.1f ;
+  }
+
+  public: static constexpr uint64_t encodeSteeringAngle (const float inValue) {
+    return ACANSignalCodec::insert ((uint64_t) ACANSignalCodec::toRaw (inValue, 10.0f, 0.0f), 50, 14) ;
+  }
+
+  public: static constexpr float decodeYawRate (const uint64_t inWord) { // Motorola word
+    return (float) ACANSignalCodec::signExtend (ACANSignalCodec::extract (inWord, 38, 12), 12) * 0.05f ;
+  }
+
+  public: static constexpr uint64_t encodeYawRate (const float inValue) {
+    return ACANSignalCodec::insert ((uint64_t) ACANSignalCodec::toRaw (inValue, 20.0f, 0.0f), 38, 12) ;
+  }
+
+  public: static constexpr float decodeLateralAcceleration (const uint64_t inWord) { // Motorola word
+    return (float) ACANSignalCodec::signExtend (ACANSignalCodec::extract (inWord, 28, 10), 10) * 0.01f ;
+  }
+
+  public: static constexpr uint64_t encodeLateralAcceleration (const float inValue) {
+    return ACANSignalCodec::insert ((uint64_t) ACANSignalCodec::toRaw (inValue, 100.0f, 0.0f), 28, 10) ;
+  }
+
+  public: static constexpr uint8_t decodeBrakePressed (const uint64_t inWord) { // Motorola word
+    return (uint8_t) ACANSignalCodec::extract (inWord, 27, 1) ;
+  }
+
+  public: static constexpr uint64_t encodeBrakePressed (const uint8_t inValue) {
+    return ACANSignalCodec::insert ((uint64_t) inValue, 27, 1) ;
+  }
+
+  public: static constexpr uint8_t decodeParkingBrake (const uint64_t inWord) { // Motorola word
+    return (uint8_t) ACANSignalCodec::extract (inWord, 26, 1) ;
+  }
+
+  public: static constexpr uint64_t encodeParkingBrake (const uint8_t inValue) {
+    return ACANSignalCodec::insert ((uint64_t) inValue, 26, 1) ;
+  }
+
+  public: static constexpr uint8_t decodeGear (const uint64_t inWord) { // Motorola word
+    return (uint8_t) ACANSignalCodec::extract (inWord, 23, 3) ;
+  }
+
+  public: static constexpr uint64_t encodeGear (const uint8_t inValue) {
+    return ACANSignalCodec::insert ((uint64_t) inValue, 23, 3) ;
+  }
+
+  public: static constexpr uint8_t decodeRollingCounter (const uint64_t inWord) { // Intel word
+    return (uint8_t) ACANSignalCodec::extract (inWord, 48, 4) ;
+  }
+
+  public: static constexpr uint64_t encodeRollingCounter (const uint8_t inValue) {
+    return ACANSignalCodec::insert ((uint64_t) inValue, 48, 4) ;
+  }
+
+  public: static constexpr uint8_t decodeChecksum (const uint64_t inWord) { // Motorola word
+    return (uint8_t) ACANSignalCodec::extract (inWord, 0, 8) ;
+  }
+
+  public: static constexpr uint64_t encodeChecksum (const uint8_t inValue) {
+    return ACANSignalCodec::insert ((uint64_t) inValue, 0, 8) ;
+  }
+
+  public: static inline void unpack (const CANMessage & inFrame, Chassis & outMessage) {
+    const uint64_t intel = ACANSignalCodec::intelWord (inFrame) ;
+    const uint64_t motorola = ACANSignalCodec::motorolaWord (inFrame) ;
+    outMessage.SteeringAngle = decodeSteeringAngle (motorola) ;
+    outMessage.YawRate = decodeYawRate (motorola) ;
+    outMessage.LateralAcceleration = decodeLateralAcceleration (motorola) ;
+    outMessage.BrakePressed = decodeBrakePressed (motorola) ;
+    outMessage.ParkingBrake = decodeParkingBrake (motorola) ;
+    outMessage.Gear = decodeGear (motorola) ;
+    outMessage.RollingCounter = decodeRollingCounter (intel) ;
+    outMessage.Checksum = decodeChecksum (motorola) ;
+  }
+
+  public: inline void pack (CANMessage & outFrame) const {
+    outFrame.id = kIdentifier ;
+    outFrame.ext = kExtended ;
+    outFrame.rtr = false ;
+    outFrame.len = kLength ;
+    const uint64_t intel = encodeRollingCounter (RollingCounter) ;
+    const uint64_t motorola = encodeSteeringAngle (SteeringAngle)
+      | encodeYawRate (YawRate)
+      | encodeLateralAcceleration (LateralAcceleration)
+      | encodeBrakePressed (BrakePressed)
+      | encodeParkingBrake (ParkingBrake)
+      | encodeGear (Gear)
+      | encodeChecksum (Checksum) ;
+    outFrame.data64 = intel | ACANSignalCodec::byteSwap (motorola) ;
+  }
+} ;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+class Battery {
+  public: static constexpr uint32_t kIdentifier = 0x125 ;
+  public: static constexpr bool kExtended = false ;
+  public: static constexpr uint8_t kLength = 6 ;
+
+  public: float Voltage = 0 ; // V [0 ... 65.535]
+  public: float Current = 0 ; // A [-1638.4 ... 1638.35]
+  public: float StateOfCharge = 0 ; // % [0 ... 127.5]
+  public: int8_t Temperature = 0 ; // degC [-128 ... 127]
+
+  public: static constexpr float decodeVoltage (const uint64_t inWord) { // Intel word
+    return (float) ACANSignalCodec::extract (inWord, 0, 16) * 0.001f ;
+  }
+
+  public: static constexpr uint64_t encodeVoltage (const float inValue) {
+    return ACANSignalCodec::insert ((uint64_t) ACANSignalCodec::toRaw (inValue, 1000.0f, 0.0f), 0, 16) ;
+  }
+
+  public: static constexpr float decodeCurrent (const uint64_t inWord) { // Intel word
+    return (float) ACANSignalCodec::signExtend (ACANSignalCodec::extract (inWord, 16, 16), 16) * 0.05f ;
+  }
+
+  public: static constexpr uint64_t encodeCurrent (const float inValue) {
+    return ACANSignalCodec::insert ((uint64_t) ACANSignalCodec::toRaw (inValue, 20.0f, 0.0f), 16, 16) ;
+  }
+
+  public: static constexpr float decodeStateOfCharge (const uint64_t inWord) { // Intel word
+    return (float) ACANSignalCodec::extract (inWord, 32, 8) * 0.5f ;
+  }
+
+  public: static constexpr uint64_t encodeStateOfCharge (const float inValue) {
+    return ACANSignalCodec::insert ((uint64_t) ACANSignalCodec::toRaw (inValue, 2.0f, 0.0f), 32, 8) ;
+  }
+
+  public: static constexpr int8_t decodeTemperature (const uint64_t inWord) { // Intel word
+    return (int8_t) ACANSignalCodec::signExtend (ACANSignalCodec::extract (inWord, 40, 8), 8) ;
+  }
+
+  public: static constexpr uint64_t encodeTemperature (const int8_t inValue) {
+    return ACANSignalCodec::insert ((uint64_t) inValue, 40, 8) ;
+  }
+
+  public: static inline void unpack (const CANMessage & inFrame, Battery & outMessage) {
+    const uint64_t intel = ACANSignalCodec::intelWord (inFrame) ;
+    outMessage.Voltage = decodeVoltage (intel) ;
+    outMessage.Current = decodeCurrent (intel) ;
+    outMessage.StateOfCharge = decodeStateOfCharge (intel) ;
+    outMessage.Temperature = decodeTemperature (intel) ;
+  }
+
+  public: inline void pack (CANMessage & outFrame) const {
+    outFrame.id = kIdentifier ;
+    outFrame.ext = kExtended ;
+    outFrame.rtr = false ;
+    outFrame.len = kLength ;
+    const uint64_t intel = encodeVoltage (Voltage)
+      | encodeCurrent (Current)
+      | encodeStateOfCharge (StateOfCharge)
+      | encodeTemperature (Temperature) ;
+    const uint64_t motorola = 0 ;
+    outFrame.data64 = intel | ACANSignalCodec::byteSwap (motorola) ;
+  }
+} ;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+class Diagnostics {
+  public: static constexpr uint32_t kIdentifier = 0x126 ;
+  public: static constexpr bool kExtended = false ;
+  public: static constexpr uint8_t kLength = 8 ;
+
+  public: uint8_t Page = 0 ; // [0 ... 255], multiplexor
+  public: float OdometerKm = 0 ; // km [0 ... 429496729.5], valid if multiplexor is 0
+  public: float EngineHours = 0 ; // h [0 ... 214748364.75], valid if multiplexor is 1
+  public: uint32_t FaultCode = 0 ; // [0 ... 16777215], valid if multiplexor is 1
+
+  public: static constexpr uint8_t decodePage (const uint64_t inWord) { // Intel word
+    return (uint8_t) ACANSignalCodec::extract (inWord, 0, 8) ;
+  }
+
+  public: static constexpr uint64_t encodePage (const uint8_t inValue) {
+    return ACANSignalCodec::insert ((uint64_t) inValue, 0, 8) ;
+  }
+
+  public: static constexpr float decodeOdometerKm (const uint64_t inWord) { // Intel word
+    return (float) ACANSignalCodec::extract (inWord, 8, 32) * 0.1f ;
+  }
+
+  public: static constexpr uint64_t encodeOdometerKm (const float inValue) {
+    return ACANSignalCodec::insert ((uint64_t) ACANSignalCodec::toRaw (inValue, 10.0f, 0.0f), 8, 32) ;
+  }
+
+  public: static constexpr float decodeEngineHours (const uint64_t inWord) { // Intel word
+    return (float) ACANSignalCodec::extract (inWord, 8, 32) * 0.05f ;
+  }
+
+  public: static constexpr uint64_t encodeEngineHours (const float inValue) {
+    return ACANSignalCodec::insert ((uint64_t) ACANSignalCodec::toRaw (inValue, 20.0f, 0.0f), 8, 32) ;
+  }
+
+  public: static constexpr uint32_t decodeFaultCode (const uint64_t inWord) { // Intel word
+    return (uint32_t) ACANSignalCodec::extract (inWord, 40, 24) ;
+  }
+
+  public: static constexpr uint64_t encodeFaultCode (const uint32_t inValue) {
+    return ACANSignalCodec::insert ((uint64_t) inValue, 40, 24) ;
+  }
+
+  public: static inline void unpack (const CANMessage & inFrame, Diagnostics & outMessage) {
+    const uint64_t intel = ACANSignalCodec::intelWord (inFrame) ;
+    outMessage.Page = decodePage (intel) ;
+    outMessage.OdometerKm = decodeOdometerKm (intel) ;
+    outMessage.EngineHours = decodeEngineHours (intel) ;
+    outMessage.FaultCode = decodeFaultCode (intel) ;
+  }
+
+  public: inline void pack (CANMessage & outFrame) const {
+    outFrame.id = kIdentifier ;
+    outFrame.ext = kExtended ;
+    outFrame.rtr = false ;
+    outFrame.len = kLength ;
+    const uint64_t intel = encodePage (Page)
+      | encodeOdometerKm (OdometerKm)
+      | encodeEngineHours (EngineHours)
+      | encodeFaultCode (FaultCode) ;
+    const uint64_t motorola = 0 ;
+    outFrame.data64 = intel | ACANSignalCodec::byteSwap (motorola) ;
+  }
+} ;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+class Timestamp {
+  public: static constexpr uint32_t kIdentifier = 0x700 ;
+  public: static constexpr bool kExtended = false ;
+  public: static constexpr uint8_t kLength = 8 ;
+
+  public: uint64_t Microseconds = 0 ; // us [0 ... 18446744073709551615]
+
+  public: static constexpr uint64_t decodeMicroseconds (const uint64_t inWord) { // Intel word
+    return (uint64_t) ACANSignalCodec::extract (inWord, 0, 64) ;
+  }
+
+  public: static constexpr uint64_t encodeMicroseconds (const uint64_t inValue) {
+    return ACANSignalCodec::insert ((uint64_t) inValue, 0, 64) ;
+  }
+
+  public: static inline void unpack (const CANMessage & inFrame, Timestamp & outMessage) {
+    const uint64_t intel = ACANSignalCodec::intelWord (inFrame) ;
+    outMessage.Microseconds = decodeMicroseconds (intel) ;
+  }
+
+  public: inline void pack (CANMessage & outFrame) const {
+    outFrame.id = kIdentifier ;
+    outFrame.ext = kExtended ;
+    outFrame.rtr = false ;
+    outFrame.len = kLength ;
+    const uint64_t intel = encodeMicroseconds (Microseconds) ;
+    const uint64_t motorola = 0 ;
+    outFrame.data64 = intel | ACANSignalCodec::byteSwap (motorola) ;
+  }
+} ;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+class Extended1000 {
+  public: static constexpr uint32_t kIdentifier = 0x00001000 ;
+  public: static constexpr bool kExtended = true ;
+  public: static constexpr uint8_t kLength = 8 ;
+
+  public: float Position = 0 ; // m [-8488.608 ... 8188.607]
+  public: float Speed = 0 ; // m/s [-5242.88 ... 5242.87]
+  public: uint8_t Status = 0 ; // [0 ... 15]
+
+  public: static constexpr float decodePosition (const uint64_t inWord) { // Intel word
+    return (float) ACANSignalCodec::signExtend (ACANSignalCodec::extract (inWord, 0, 24), 24) * 0.001f + -100.0f ;
+  }
+
+  public: static constexpr uint64_t encodePosition (const float inValue) {
+    return ACANSignalCodec::insert ((uint64_t) ACANSignalCodec::toRaw (inValue, 1000.0f, -100.0f), 0, 24) ;
+  }
+
+  public: static constexpr float decodeSpeed (const uint64_t inWord) { // Motorola word
+    return (float) ACANSignalCodec::signExtend (ACANSignalCodec::extract (inWord, 20, 20), 20) * 0.01f ;
+  }
+
+  public: static constexpr uint64_t encodeSpeed (const float inValue) {
+    return ACANSignalCodec::insert ((uint64_t) ACANSignalCodec::toRaw (inValue, 100.0f, 0.0f), 20, 20) ;
+  }
+
+  public: static constexpr uint8_t decodeStatus (const uint64_t inWord) { // Motorola word
+    return (uint8_t) ACANSignalCodec::extract (inWord, 0, 4) ;
+  }
+
+  public: static constexpr uint64_t encodeStatus (const uint8_t inValue) {
+    return ACANSignalCodec::insert ((uint64_t) inValue, 0, 4) ;
+  }
+
+  public: static inline void unpack (const CANMessage & inFrame, Extended1000 & outMessage) {
+    const uint64_t intel = ACANSignalCodec::intelWord (inFrame) ;
+    const uint64_t motorola = ACANSignalCodec::motorolaWord (inFrame) ;
+    outMessage.Position = decodePosition (intel) ;
+    outMessage.Speed = decodeSpeed (motorola) ;
+    outMessage.Status = decodeStatus (motorola) ;
+  }
+
+  public: inline void pack (CANMessage & outFrame) const {
+    outFrame.id = kIdentifier ;
+    outFrame.ext = kExtended ;
+    outFrame.rtr = false ;
+    outFrame.len = kLength ;
+    const uint64_t intel = encodePosition (Position) ;
+    const uint64_t motorola = encodeSpeed (Speed)
+      | encodeStatus (Status) ;
+    outFrame.data64 = intel | ACANSignalCodec::byteSwap (motorola) ;
+  }
+} ;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+class EEC1 {
+  public: static constexpr uint32_t kIdentifier = 0x0CF004FE ;
+  public: static constexpr bool kExtended = true ;
+  public: static constexpr uint8_t kLength = 8 ;
+
+  public: uint8_t EngineTorqueMode = 0 ; // [0 ... 15]
+  public: int32_t DriverDemandTorque = 0 ; // % [-125 ... 125]
+  public: int32_t ActualEngineTorque = 0 ; // % [-125 ... 125]
+  public: float EngineSpeed = 0 ; // rpm [0 ... 8031.875]
+  public: uint8_t SourceAddress = 0 ; // [0 ... 255]
+  public: uint8_t StarterMode = 0 ; // [0 ... 15]
+  public: int32_t DemandTorque = 0 ; // % [-125 ... 125]
+
+  public: static constexpr uint8_t decodeEngineTorqueMode (const uint64_t inWord) { // Intel word
+    return (uint8_t) ACANSignalCodec::extract (inWord, 0, 4) ;
+  }
+
+  public: static constexpr uint64_t encodeEngineTorqueMode (const uint8_t inValue) {
+    return ACANSignalCodec::insert ((uint64_t) inValue, 0, 4) ;
+  }
+
+  public: static constexpr int32_t decodeDriverDemandTorque (const uint64_t inWord) { // Intel word
+    return (int32_t) (ACANSignalCodec::extract (inWord, 8, 8) * 1LL + -125LL) ;
+  }
+
+  public: static constexpr uint64_t encodeDriverDemandTorque (const int32_t inValue) {
+    return ACANSignalCodec::insert ((uint64_t) (((int64_t) inValue - -125LL) / 1LL), 8, 8) ;
+  }
+
+  public: static constexpr int32_t decodeActualEngineTorque (const uint64_t inWord) { // Intel word
+    return (int32_t) (ACANSignalCodec::extract (inWord, 16, 8) * 1LL + -125LL) ;
+  }
+
+  public: static constexpr uint64_t encodeActualEngineTorque (const int32_t inValue) {
+    return ACANSignalCodec::insert ((uint64_t) (((int64_t) inValue - -125LL) / 1LL), 16, 8) ;
+  }
+
+  public: static constexpr float decodeEngineSpeed (const uint64_t inWord) { // Intel word
+    return (float) ACANSignalCodec::extract (inWord, 24, 16) * 0.125f ;
+  }
+
+  public: static constexpr uint64_t encodeEngineSpeed (const float inValue) {
+    return ACANSignalCodec::insert ((uint64_t) ACANSignalCodec::toRaw (inValue, 8.0f, 0.0f), 24, 16) ;
+  }
+
+  public: static constexpr uint8_t decodeSourceAddress (const uint64_t inWord) { // Intel word
+    return (uint8_t) ACANSignalCodec::extract (inWord, 40, 8) ;
+  }
+
+  public: static constexpr uint64_t encodeSourceAddress (const uint8_t inValue) {
+    return ACANSignalCodec::insert ((uint64_t) inValue, 40, 8) ;
+  }
+
+  public: static constexpr uint8_t decodeStarterMode (const uint64_t inWord) { // Intel word
+    return (uint8_t) ACANSignalCodec::extract (inWord, 48, 4) ;
+  }
+
+  public: static constexpr uint64_t encodeStarterMode (const uint8_t inValue) {
+    return ACANSignalCodec::insert ((uint64_t) inValue, 48, 4) ;
+  }
+
+  public: static constexpr int32_t decodeDemandTorque (const uint64_t inWord) { // Intel word
+    return (int32_t) (ACANSignalCodec::extract (inWord, 56, 8) * 1LL + -125LL) ;
+  }
+
+  public: static constexpr uint64_t encodeDemandTorque (const int32_t inValue) {
+    return ACANSignalCodec::insert ((uint64_t) (((int64_t) inValue - -125LL) / 1LL), 56, 8) ;
+  }
+
+  public: static inline void unpack (const CANMessage & inFrame, EEC1 & outMessage) {
+    const uint64_t intel = ACANSignalCodec::intelWord (inFrame) ;
+    outMessage.EngineTorqueMode = decodeEngineTorqueMode (intel) ;
+    outMessage.DriverDemandTorque = decodeDriverDemandTorque (intel) ;
+    outMessage.ActualEngineTorque = decodeActualEngineTorque (intel) ;
+    outMessage.EngineSpeed = decodeEngineSpeed (intel) ;
+    outMessage.SourceAddress = decodeSourceAddress (intel) ;
+    outMessage.StarterMode = decodeStarterMode (intel) ;
+    outMessage.DemandTorque = decodeDemandTorque (intel) ;
+  }
+
+  public: inline void pack (CANMessage & outFrame) const {
+    outFrame.id = kIdentifier ;
+    outFrame.ext = kExtended ;
+    outFrame.rtr = false ;
+    outFrame.len = kLength ;
+    const uint64_t intel = encodeEngineTorqueMode (EngineTorqueMode)
+      | encodeDriverDemandTorque (DriverDemandTorque)
+      | encodeActualEngineTorque (ActualEngineTorque)
+      | encodeEngineSpeed (EngineSpeed)
+      | encodeSourceAddress (SourceAddress)
+      | encodeStarterMode (StarterMode)
+      | encodeDemandTorque (DemandTorque) ;
+    const uint64_t motorola = 0 ;
+    outFrame.data64 = intel | ACANSignalCodec::byteSwap (motorola) ;
+  }
+} ;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+class ET1 {
+  public: static constexpr uint32_t kIdentifier = 0x18FEF1FE ;
+  public: static constexpr bool kExtended = true ;
+  public: static constexpr uint8_t kLength = 8 ;
+
+  public: int32_t CoolantTemperature = 0 ; // degC [-40 ... 210]
+  public: int32_t FuelTemperature = 0 ; // degC [-40 ... 210]
+  public: float OilTemperature = 0 ; // degC [-273 ... 1735]
+  public: float TurboOilTemperature = 0 ; // degC [-273 ... 1735]
+  public: int32_t IntercoolerTemperature = 0 ; // degC [-40 ... 210]
+
+  public: static constexpr int32_t decodeCoolantTemperature (const uint64_t inWord) { // Intel word
+    return (int32_t) (ACANSignalCodec::extract (inWord, 0, 8) * 1LL + -40LL) ;
+  }
+
+  public: static constexpr uint64_t encodeCoolantTemperature (const int32_t inValue) {
+    return ACANSignalCodec::insert ((uint64_t) (((int64_t) inValue - -40LL) / 1LL), 0, 8) ;
+  }
+
+  public: static constexpr int32_t decodeFuelTemperature (const uint64_t inWord) { // Intel word
+    return (int32_t) (ACANSignalCodec::extract (inWord, 8, 8) * 1LL + -40LL) ;
+  }
+
+  public: static constexpr uint64_t encodeFuelTemperature (const int32_t inValue) {
+    return ACANSignalCodec::insert ((uint64_t) (((int64_t) inValue - -40LL) / 1LL), 8, 8) ;
+  }
+
+  public: static constexpr float decodeOilTemperature (const uint64_t inWord) { // Intel word
+    return (float) ACANSignalCodec::extract (inWord, 16, 16) * 0.03125f + -273.0f ;
+  }
+
+  public: static constexpr uint64_t encodeOilTemperature (const float inValue) {
+    return ACANSignalCodec::insert ((uint64_t) ACANSignalCodec::toRaw (inValue, 32.0f, -273.0f), 16, 16) ;
+  }
+
+  public: static constexpr float decodeTurboOilTemperature (const uint64_t inWord) { // Intel word
+    return (float) ACANSignalCodec::extract (inWord, 32, 16) * 0.03125f + -273.0f ;
+  }
+
+  public: static constexpr uint64_t encodeTurboOilTemperature (const float inValue) {
+    return ACANSignalCodec::insert ((uint64_t) ACANSignalCodec::toRaw (inValue, 32.0f, -273.0f), 32, 16) ;
+  }
+
+  public: static constexpr int32_t decodeIntercoolerTemperature (const uint64_t inWord) { // Intel word
+    return (int32_t) (ACANSignalCodec::extract (inWord, 48, 8) * 1LL + -40LL) ;
+  }
+
+  public: static constexpr uint64_t encodeIntercoolerTemperature (const int32_t inValue) {
+    return ACANSignalCodec::insert ((uint64_t) (((int64_t) inValue - -40LL) / 1LL), 48, 8) ;
+  }
+
+  public: static inline void unpack (const CANMessage & inFrame, ET1 & outMessage) {
+    const uint64_t intel = ACANSignalCodec::intelWord (inFrame) ;
+    outMessage.CoolantTemperature = decodeCoolantTemperature (intel) ;
+    outMessage.FuelTemperature = decodeFuelTemperature (intel) ;
+    outMessage.OilTemperature = decodeOilTemperature (intel) ;
+    outMessage.TurboOilTemperature = decodeTurboOilTemperature (intel) ;
+    outMessage.IntercoolerTemperature = decodeIntercoolerTemperature (intel) ;
+  }
+
+  public: inline void pack (CANMessage & outFrame) const {
+    outFrame.id = kIdentifier ;
+    outFrame.ext = kExtended ;
+    outFrame.rtr = false ;
+    outFrame.len = kLength ;
+    const uint64_t intel = encodeCoolantTemperature (CoolantTemperature)
+      | encodeFuelTemperature (FuelTemperature)
+      | encodeOilTemperature (OilTemperature)
+      | encodeTurboOilTemperature (TurboOilTemperature)
+      | encodeIntercoolerTemperature (IntercoolerTemperature) ;
+    const uint64_t motorola = 0 ;
+    outFrame.data64 = intel | ACANSignalCodec::byteSwap (motorola) ;
+  }
+} ;
+
+//----------------------------------------------------------------------------------------------------------------------
+//   Identifier -> decoder dispatch: set the handlers of the messages to decode, then call dispatch
+//----------------------------------------------------------------------------------------------------------------------
+
+class Handlers {
+  public: void (*mWheelSpeeds) (const WheelSpeeds & inMessage) = nullptr ;
+  public: void (*mChassis) (const Chassis & inMessage) = nullptr ;
+  public: void (*mBattery) (const Battery & inMessage) = nullptr ;
+  public: void (*mDiagnostics) (const Diagnostics & inMessage) = nullptr ;
+  public: void (*mTimestamp) (const Timestamp & inMessage) = nullptr ;
+  public: void (*mExtended1000) (const Extended1000 & inMessage) = nullptr ;
+  public: void (*mEEC1) (const EEC1 & inMessage) = nullptr ;
+  public: void (*mET1) (const ET1 & inMessage) = nullptr ;
+} ;
+
+static inline bool decodeWheelSpeeds (const CANMessage & inFrame, const Handlers & inHandlers) {
+  const bool ok = (inFrame.len >= WheelSpeeds::kLength) && (inHandlers.mWheelSpeeds != nullptr) ;
+  if (ok) {
+    WheelSpeeds message ;
+    WheelSpeeds::unpack (inFrame, message) ;
+    inHandlers.mWheelSpeeds (message) ;
+  }
+  return ok ;
+}
+
+static inline bool decodeChassis (const CANMessage & inFrame, const Handlers & inHandlers) {
+  const bool ok = (inFrame.len >= Chassis::kLength) && (inHandlers.mChassis != nullptr) ;
+  if (ok) {
+    Chassis message ;
+    Chassis::unpack (inFrame, message) ;
+    inHandlers.mChassis (message) ;
+  }
+  return ok ;
+}
+
+static inline bool decodeBattery (const CANMessage & inFrame, const Handlers & inHandlers) {
+  const bool ok = (inFrame.len >= Battery::kLength) && (inHandlers.mBattery != nullptr) ;
+  if (ok) {
+    Battery message ;
+    Battery::unpack (inFrame, message) ;
+    inHandlers.mBattery (message) ;
+  }
+  return ok ;
+}
+
+static inline bool decodeDiagnostics (const CANMessage & inFrame, const Handlers & inHandlers) {
+  const bool ok = (inFrame.len >= Diagnostics::kLength) && (inHandlers.mDiagnostics != nullptr) ;
+  if (ok) {
+    Diagnostics message ;
+    Diagnostics::unpack (inFrame, message) ;
+    inHandlers.mDiagnostics (message) ;
+  }
+  return ok ;
+}
+
+static inline bool decodeTimestamp (const CANMessage & inFrame, const Handlers & inHandlers) {
+  const bool ok = (inFrame.len >= Timestamp::kLength) && (inHandlers.mTimestamp != nullptr) ;
+  if (ok) {
+    Timestamp message ;
+    Timestamp::unpack (inFrame, message) ;
+    inHandlers.mTimestamp (message) ;
+  }
+  return ok ;
+}
+
+static inline bool decodeExtended1000 (const CANMessage & inFrame, const Handlers & inHandlers) {
+  const bool ok = (inFrame.len >= Extended1000::kLength) && (inHandlers.mExtended1000 != nullptr) ;
+  if (ok) {
+    Extended1000 message ;
+    Extended1000::unpack (inFrame, message) ;
+    inHandlers.mExtended1000 (message) ;
+  }
+  return ok ;
+}
+
+static inline bool decodeEEC1 (const CANMessage & inFrame, const Handlers & inHandlers) {
+  const bool ok = (inFrame.len >= EEC1::kLength) && (inHandlers.mEEC1 != nullptr) ;
+  if (ok) {
+    EEC1 message ;
+    EEC1::unpack (inFrame, message) ;
+    inHandlers.mEEC1 (message) ;
+  }
+  return ok ;
+}
+
+static inline bool decodeET1 (const CANMessage & inFrame, const Handlers & inHandlers) {
+  const bool ok = (inFrame.len >= ET1::kLength) && (inHandlers.mET1 != nullptr) ;
+  if (ok) {
+    ET1 message ;
+    ET1::unpack (inFrame, message) ;
+    inHandlers.mET1 (message) ;
+  }
+  return ok ;
+}
+
+static const ACANSignalDispatchEntry <Handlers> kDispatchTable [8] = {
+  {0x00000123UL, decodeWheelSpeeds},
+  {0x00000124UL, decodeChassis},
+  {0x00000125UL, decodeBattery},
+  {0x00000126UL, decodeDiagnostics},
+  {0x00000700UL, decodeTimestamp},
+  {0x80001000UL, decodeExtended1000},
+  {0x8CF004FEUL, decodeEEC1},
+  {0x98FEF1FEUL, decodeET1},
+} ;
+
+inline bool dispatch (const CANMessage & inFrame, const Handlers & inHandlers) {
+  return dispatchSignalFrame (kDispatchTable, 8, inFrame, inHandlers) ;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+} // namespace vehicle
+
+#endif
@@ -0,0 +1,102 @@
+/******************************************************************************/
+/* File name        : DriverTrace.ino                                         */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Description      : Event trace of the driver internals, dumped on Serial   */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+// Build with ACAN_TRACE set to 1 (see ACANTrace.h). LoopBackMode traffic in bursts: every 2 s, the trace is detached,
+// dumped on Serial, cleared and attached again. Capture the serial monitor output to a file and decode it with
+// trace-decoder-on-desktop (trace-decoder capture.txt).
+
+/*------------------------------- Board Check --------------------------------*/
+#ifndef ARDUINO_ARCH_ESP32
+  #error "Select an ESP32 board"
+#endif
+
+/*------------------------------- Include files ------------------------------*/
+#include "ESP32ACAN.h"
+#include "ACANTrace.h"
+
+//——————————————————————————————————————————————————————————————————————————————
+//  ESP32 CAN Driver, trace
+//——————————————————————————————————————————————————————————————————————————————
+
+ESP32ACAN can ;
+
+ACANTrace trace ;
+
+static const uint32_t DESIRED_BIT_RATE = 1000UL * 1000UL ; // 1 Mb/s
+static const uint32_t TRACE_CAPACITY = 1024 ;              // Records (8 bytes each)
+static const uint32_t BURST_SIZE = 20 ;                    // Frames per burst, more than the transmit buffer
+
+//——————————————————————————————————————————————————————————————————————————————
+//   SETUP
+//——————————————————————————————————————————————————————————————————————————————
+
+void setup () {
+  pinMode (LED_BUILTIN, OUTPUT) ;
+  digitalWrite (LED_BUILTIN, HIGH) ;
+  Serial.begin (115200) ;
+  while (!Serial) {
+    delay (50) ;
+    digitalWrite (LED_BUILTIN, !digitalRead (LED_BUILTIN)) ;
+  }
+  trace.begin (TRACE_CAPACITY) ;
+  if (!can.setTrace (&trace)) {
+    Serial.println ("ACAN_TRACE is 0: no driver trace point compiled") ;
+  }
+  ESP32ACANSettings settings (DESIRED_BIT_RATE) ;
+  settings.mRequestedCANMode = ESP32ACANSettings::LoopBackMode ;
+  settings.mControlMessageByMethod = ESP32ACANSettings::InterruptControlled ;
+  settings.mDriverTransmitBufferSize = 8 ;
+  const uint32_t errorCode = can.begin (settings) ; // Its mode change is traced
+  if (errorCode != 0) {
+    Serial.print ("Configuration error 0x") ;
+    Serial.println (errorCode, HEX) ;
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————
+static uint32_t gBurstDate = 0 ;
+static uint32_t gDumpDate = 2000 ;
+static uint32_t gSentFrameCount = 0 ;
+static uint32_t gReceivedFrameCount = 0 ;
+//——————————————————————————————————————————————————————————————————————————————
+
+//——————————————————————————————————————————————————————————————————————————————
+//   LOOP
+//——————————————————————————————————————————————————————————————————————————————
+
+void loop () {
+  CANMessage frame ;
+  if ((millis () - gBurstDate) >= 100) {
+    gBurstDate += 100 ;
+    for (uint32_t i=0 ; i<BURST_SIZE ; i++) {
+      frame.id = 0x100 + i ;
+      frame.len = 8 ;
+      gSentFrameCount += can.tryToSend (frame) ; // Refusals are traced (TX_BUFFER_FULL)
+    }
+  }
+  while (can.receive (frame)) {
+    gReceivedFrameCount += 1 ;
+  }
+  if ((millis () - gDumpDate) >= 2000) {
+    gDumpDate += 2000 ;
+    digitalWrite (LED_BUILTIN, !digitalRead (LED_BUILTIN)) ;
+    Serial.print ("Sent: ") ;
+    Serial.print (gSentFrameCount) ;
+    Serial.print (", received: ") ;
+    Serial.println (gReceivedFrameCount) ;
+    can.setTrace (nullptr) ; // Exact dump: no record is written meanwhile
+    trace.dump (Serial) ;
+    trace.clear () ;
+    can.setTrace (&trace) ;
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————
@@ -0,0 +1,113 @@
+/******************************************************************************/
+/* File name        : ESP32ACAN2515Gateway.ino                                */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Description      : Gateway between the ESP32 CAN and a MCP2515 CAN bus     */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+
+/*------------------------------- Board Check --------------------------------*/
+#ifndef ARDUINO_ARCH_ESP32
+  #error "Select an ESP32 board" 
+#endif
+
+/*------------------------------- Include files ------------------------------*/
+#include "ESP32ACAN.h"
+#include "ACANGateway.h"
+#include <ACAN2515.h>
+
+static const byte MCP_SCK = 26 ; // SCK input of MCP2517
+static const byte MCP_SDI = 19 ; // SI input of MCP2517
+static const byte MCP_SDO = 18 ; // SO output of MCP2517
+
+static const byte MCP2515_CS  = 17 ; // CS input of MCP2515
+static const byte MCP2515_INT = 0 ; // INT output of MCP2515
+
+//——————————————————————————————————————————————————————————————————————————————
+//  Drivers and gateway
+//——————————————————————————————————————————————————————————————————————————————
+
+ACAN2515 can2515 (MCP2515_CS, SPI, MCP2515_INT) ;
+
+static const uint32_t MCP2515_QUARTZ_FREQUENCY = 20UL * 1000UL * 1000UL ; // 20 MHz
+
+ESP32ACAN canESP32 ;
+
+ACANGateway gateway ;
+
+static const uint32_t DESIRED_BIT_RATE = 1000UL * 1000UL ; // 1 Mb/s
+
+//——————————————————————————————————————————————————————————————————————————————
+//  Routes
+//——————————————————————————————————————————————————————————————————————————————
+
+static uint16_t gRouteESP32To2515 ;
+static uint16_t gRoute2515ToESP32 ;
+
+//——————————————————————————————————————————————————————————————————————————————
+//   SETUP
+//——————————————————————————————————————————————————————————————————————————————
+
+void setup () {
+//--- Start serial
+  Serial.begin (115200) ;
+  while (!Serial) {
+    delay (50) ;
+  }
+//--- Configure ESP32 CAN: interrupt driven, the gateway reads its receive buffer in place
+  ESP32ACANSettings settings (DESIRED_BIT_RATE) ;
+  settings.mControlMessageByMethod = ESP32ACANSettings::InterruptControlled ;
+  settings.mDriverReceiveBufferSize = 64 ;
+  const uint32_t errorCode = canESP32.begin (settings) ;
+  Serial.print ("ESP32 CAN configuration: 0x") ;
+  Serial.println (errorCode, HEX) ;
+//--- Configure ACAN2515
+  SPI.begin (MCP_SCK, MCP_SDO, MCP_SDI) ;
+  ACAN2515Settings settings2515 (MCP2515_QUARTZ_FREQUENCY, DESIRED_BIT_RATE) ;
+  const uint32_t errorCode2515 = can2515.begin (settings2515, [] { can2515.isr () ; }) ;
+  Serial.print ("ACAN2515 configuration: 0x") ;
+  Serial.println (errorCode2515, HEX) ;
+//--- Gateway: standard 0x100...0x1FF from ESP32 to MCP2515, extended 0x18FF0000...0x18FF00FF from MCP2515 to ESP32,
+//    rewritten to 0x18FE0000...0x18FE00FF; other identifiers are not forwarded
+  gateway.initWithCapacity (2) ;
+  const uint8_t esp = gateway.addPort (canESP32) ;
+  const uint8_t mcp = gateway.addPort (can2515) ;
+  gRouteESP32To2515 = gateway.addRoute (esp, mcp, 0x100, 0x1FF, false) ;
+  gRoute2515ToESP32 = gateway.addRoute (mcp, esp, 0x18FF0000, 0x18FF00FF, true, ACANGateway::key (0x18FE0000, true)) ;
+  gateway.setHoldTime (500) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————
+
+static uint32_t gDisplayDate = 0 ;
+
+static void printRoute (const char * inName, const uint16_t inRoute) {
+  const ACANGatewayRouteStatistics & s = gateway.routeStatistics (inRoute) ;
+  Serial.print (inName) ;
+  Serial.print (": forwarded ") ;
+  Serial.print (s.mForwardedCount) ;
+  Serial.print (", dropped ") ;
+  Serial.print (s.mDroppedCount) ;
+  Serial.print (", latency max ") ;
+  Serial.print (s.mMaxLatency) ;
+  Serial.print (" us, mean ") ;
+  Serial.print ((uint32_t) (s.mLatencySum / ((s.mForwardedCount > 0) ? s.mForwardedCount : 1))) ;
+  Serial.println (" us") ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————
+//   LOOP
+//——————————————————————————————————————————————————————————————————————————————
+
+void loop () {
+  gateway.poll (micros ()) ;
+  if (gDisplayDate < millis ()) {
+    gDisplayDate += 1000 ;
+    printRoute ("ESP32 -> 2515", gRouteESP32To2515) ;
+    printRoute ("2515 -> ESP32", gRoute2515ToESP32) ;
+  }
+}
@@ -0,0 +1,66 @@
+/******************************************************************************/
+/* File name        : HostLinkBridge.ino                                      */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Description      : USB-CAN adapter, binary host link (COBS, credits)       */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+// The board bridges a 1 Mbit/s bus and the host over Serial at 2 Mbaud with ACANHostLink (Linux side:
+// host-link-on-desktop, host-link /dev/ttyUSB0). A 100 % loaded bus of 8 byte standard frames takes about 16 bytes
+// per frame, two thirds of the link; frames wait in the driver receive buffer while the host gives no credit.
+// Serial carries the protocol only: the LED is on while the host gives credit.
+
+/*------------------------------- Board Check --------------------------------*/
+#ifndef ARDUINO_ARCH_ESP32
+  #error "Select an ESP32 board"
+#endif
+
+/*------------------------------- Include files ------------------------------*/
+#include "ESP32ACAN.h"
+#include "ACANHostLink.h"
+
+//——————————————————————————————————————————————————————————————————————————————
+//  ESP32 CAN Driver, host link
+//——————————————————————————————————————————————————————————————————————————————
+
+ESP32ACAN can ;
+
+ACANHostLink hostLink ;
+
+static const uint32_t CAN_BIT_RATE = 1000UL * 1000UL ;
+static const uint32_t SERIAL_BAUD_RATE = 2000000 ;
+
+//——————————————————————————————————————————————————————————————————————————————
+//   SETUP
+//——————————————————————————————————————————————————————————————————————————————
+
+void setup () {
+  Serial.setRxBufferSize (1024) ;
+  Serial.setTxBufferSize (2048) ;
+  Serial.begin (SERIAL_BAUD_RATE) ;
+  pinMode (LED_BUILTIN, OUTPUT) ;
+  hostLink.begin (64) ; // Frames from the host, waiting for the driver transmit buffer
+  ESP32ACANSettings settings (CAN_BIT_RATE) ;
+  settings.mControlMessageByMethod = ESP32ACANSettings::InterruptControlled ;
+  settings.mDriverReceiveBufferSize = 512 ;
+  const uint32_t errorCode = can.begin (settings) ;
+  digitalWrite (LED_BUILTIN, errorCode != 0) ; // Steady on: configuration error
+  while (errorCode != 0) {
+    delay (1000) ;
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————
+//   LOOP
+//——————————————————————————————————————————————————————————————————————————————
+
+void loop () {
+  hostLink.poll (can, Serial, micros ()) ;
+  digitalWrite (LED_BUILTIN, hostLink.hasCredit ()) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————
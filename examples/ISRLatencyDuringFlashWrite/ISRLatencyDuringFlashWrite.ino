@@ -0,0 +1,159 @@
+/******************************************************************************/
+/* File name        : ISRLatencyDuringFlashWrite.ino                          */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Description      : Frame loss and latency while the flash is written       */
+/*                    (IRAM interrupt handler or not)                         */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+// A task on core 0 sends numbered frames back to back (LoopBackMode), stamped with micros (); loop () on core 1
+// receives them. A third task writes the NVS flash every 20 ms: the flash cache is disabled during each write. With
+// IRAM_INTERRUPT false, the interrupt handler waits for the end of the write and the controller FIFO (64 bytes)
+// overruns; with true, frames keep flowing to the driver receive buffer. The driver receive buffer statistics give
+// the residence time percentiles of the frames (µs) and the overflow episodes.
+
+/*------------------------------- Board Check --------------------------------*/
+#ifndef ARDUINO_ARCH_ESP32
+  #error "Select an ESP32 board"
+#endif
+
+/*------------------------------- Include files ------------------------------*/
+#include "ESP32ACAN.h"
+#include <Preferences.h>
+
+//——————————————————————————————————————————————————————————————————————————————
+//  ESP32 CAN Driver
+//——————————————————————————————————————————————————————————————————————————————
+
+ESP32ACAN can ;
+ACANBufferStatistics receiveBufferStatistics ;
+
+static const uint32_t DESIRED_BIT_RATE = 1000UL * 1000UL ; // 1 Mb/s
+static const bool IRAM_INTERRUPT = true ;
+static const bool FLASH_WRITES = true ;
+
+//——————————————————————————————————————————————————————————————————————————————
+//  Sender and flash writer tasks
+//——————————————————————————————————————————————————————————————————————————————
+
+static void senderTask (void *) {
+  CANMessage frame ;
+  frame.len = 8 ;
+  uint32_t sequence = 0 ;
+  while (true) {
+    frame.data32 [0] = sequence ;
+    frame.data32 [1] = micros () ;
+    if (can.send (frame, portMAX_DELAY)) {
+      sequence += 1 ;
+    }
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————
+
+static volatile uint32_t gFlashWriteCount = 0 ;
+
+static void flashWriterTask (void *) {
+  Preferences preferences ;
+  preferences.begin ("canlatency", false) ;
+  while (true) {
+    vTaskDelay (pdMS_TO_TICKS (20)) ;
+    if (FLASH_WRITES) {
+      preferences.putUInt ("count", gFlashWriteCount) ;
+      gFlashWriteCount += 1 ;
+    }
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————
+//   SETUP
+//——————————————————————————————————————————————————————————————————————————————
+
+void setup () {
+  Serial.begin (115200) ;
+  while (!Serial) {
+    delay (50) ;
+  }
+  ESP32ACANSettings settings (DESIRED_BIT_RATE) ;
+  settings.mRequestedCANMode = ESP32ACANSettings::LoopBackMode ;
+  settings.mControlMessageByMethod = ESP32ACANSettings::InterruptControlled ;
+  settings.mInterruptInIRAM = IRAM_INTERRUPT ;
+  settings.mInterruptCore = ESP32ACANSettings::Core1 ;
+  settings.mInterruptLevel = 3 ;
+  settings.mDriverReceiveBufferSize = 256 ;
+  settings.mDriverTransmitBufferSize = 1 ;
+  const uint32_t errorCode = can.begin (settings) ;
+  if (errorCode != 0) {
+    Serial.print ("Configuration error 0x") ;
+    Serial.println (errorCode, HEX) ;
+  }
+  can.setDriverReceiveBufferStatistics (&receiveBufferStatistics) ;
+  xTaskCreatePinnedToCore (senderTask, "sender", 2048, nullptr, 2, nullptr, 0) ;
+  xTaskCreatePinnedToCore (flashWriterTask, "flash", 4096, nullptr, 1, nullptr, 0) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————
+//   LOOP: one report per second
+//——————————————————————————————————————————————————————————————————————————————
+
+static uint32_t gReportDate = 0 ;
+static uint32_t gExpectedSequence = 0 ;
+static uint32_t gReceivedCount = 0 ;
+static uint32_t gLostCount = 0 ;
+static uint32_t gMaxLatency = 0 ;
+
+void loop () {
+  CANMessage frame ;
+  if (can.receive (frame, pdMS_TO_TICKS (10))) {
+    gReceivedCount += 1 ;
+    gLostCount += frame.data32 [0] - gExpectedSequence ;
+    gExpectedSequence = frame.data32 [0] + 1 ;
+    const uint32_t latency = micros () - frame.data32 [1] ;
+    if (gMaxLatency < latency) {
+      gMaxLatency = latency ;
+    }
+  }
+  if (gReportDate < millis ()) {
+    gReportDate += 1000 ;
+    Serial.print (IRAM_INTERRUPT ? "IRAM handler" : "Flash handler") ;
+    Serial.print (", flash writes: ") ;
+    Serial.print (gFlashWriteCount) ;
+    Serial.print (", received: ") ;
+    Serial.print (gReceivedCount) ;
+    Serial.print (", lost: ") ;
+    Serial.print (gLostCount) ;
+    Serial.print (", overruns: ") ;
+    Serial.print (can.controllerOverrunCount ()) ;
+    Serial.print (", max latency: ") ;
+    Serial.print (gMaxLatency) ;
+    Serial.println (" us") ;
+    gMaxLatency = 0 ;
+  //--- Driver receive buffer: residence time percentiles and overflow episodes of the last second
+    portENTER_CRITICAL (&mux) ;
+    const uint32_t p50 = receiveBufferStatistics.residenceP50 () ;
+    const uint32_t p99 = receiveBufferStatistics.residenceP99 () ;
+    const uint32_t p999 = receiveBufferStatistics.residenceP999 () ;
+    const uint32_t episodes = receiveBufferStatistics.overflowEpisodeCount () ;
+    const uint32_t longestEpisode = receiveBufferStatistics.longestOverflowDuration () ;
+    const uint32_t occupancy = receiveBufferStatistics.occupancyPercentile (999) ;
+    portEXIT_CRITICAL (&mux) ;
+    can.resetDriverBufferStatistics () ;
+    Serial.print ("  residence p50 / p99 / p99.9: ") ;
+    Serial.print (p50) ;
+    Serial.print (" / ") ;
+    Serial.print (p99) ;
+    Serial.print (" / ") ;
+    Serial.print (p999) ;
+    Serial.print (" us, p99.9 occupancy: ") ;
+    Serial.print (occupancy) ;
+    Serial.print (", overflow episodes: ") ;
+    Serial.print (episodes) ;
+    Serial.print (", longest: ") ;
+    Serial.print (longestEpisode) ;
+    Serial.println (" us") ;
+  }
+}
@@ -0,0 +1,122 @@
+/******************************************************************************/
+/* File name        : ISRProfile.ino                                          */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Description      : Interrupt handler and critical section cycle counts     */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+// Build with ACAN_PROFILE set to 1 (see ACANProfiler.h). LoopBackMode traffic in bursts; every 5 s, the cycle count
+// statistics of every profiled section are printed (count, min, mean, p99, max, log2 histogram), then reset. The
+// interrupt critical section is the time the other core may spin on the driver lock.
+
+/*------------------------------- Board Check --------------------------------*/
+#ifndef ARDUINO_ARCH_ESP32
+  #error "Select an ESP32 board"
+#endif
+
+/*------------------------------- Include files ------------------------------*/
+#include "ESP32ACAN.h"
+#include "ACANProfiler.h"
+
+//——————————————————————————————————————————————————————————————————————————————
+//  ESP32 CAN Driver, profiler
+//——————————————————————————————————————————————————————————————————————————————
+
+ESP32ACAN can ;
+
+ACANProfiler profiler ;
+
+static const uint32_t DESIRED_BIT_RATE = 1000UL * 1000UL ; // 1 Mb/s
+static const uint32_t BURST_SIZE = 12 ;
+
+//——————————————————————————————————————————————————————————————————————————————
+//   SETUP
+//——————————————————————————————————————————————————————————————————————————————
+
+void setup () {
+  pinMode (LED_BUILTIN, OUTPUT) ;
+  digitalWrite (LED_BUILTIN, HIGH) ;
+  Serial.begin (115200) ;
+  while (!Serial) {
+    delay (50) ;
+    digitalWrite (LED_BUILTIN, !digitalRead (LED_BUILTIN)) ;
+  }
+  if (!can.setProfiler (&profiler)) {
+    Serial.println ("ACAN_PROFILE is 0: no driver profile point compiled") ;
+  }
+  ESP32ACANSettings settings (DESIRED_BIT_RATE) ;
+  settings.mRequestedCANMode = ESP32ACANSettings::LoopBackMode ;
+  settings.mControlMessageByMethod = ESP32ACANSettings::InterruptControlled ;
+  const uint32_t errorCode = can.begin (settings) ;
+  if (errorCode != 0) {
+    Serial.print ("Configuration error 0x") ;
+    Serial.println (errorCode, HEX) ;
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————
+
+static void printSection (const ACANProfiler::Section inSection) {
+  ACANProfileStatistics s ;
+  if (can.profileStatistics (inSection, s) && (s.count () > 0)) {
+    Serial.print (ACANProfiler::sectionName (inSection)) ;
+    Serial.print (": ") ;
+    Serial.print (s.count ()) ;
+    Serial.print (" runs, cycles min ") ;
+    Serial.print (s.minimum ()) ;
+    Serial.print (", mean ") ;
+    Serial.print (s.mean ()) ;
+    Serial.print (", p99 ") ;
+    Serial.print (s.percentile (990)) ;
+    Serial.print (", max ") ;
+    Serial.print (s.maximum ()) ;
+    Serial.print (" (") ;
+    Serial.print (s.maximum () / ACANProfiler::ticksPerMicrosecond ()) ;
+    Serial.println (" us)") ;
+    for (uint8_t i=0 ; i<ACANProfileStatistics::kBucketCount ; i++) {
+      if (s.bucketCount (i) > 0) {
+        Serial.print ("  >= ") ;
+        Serial.print (ACANProfileStatistics::bucketLowerBound (i)) ;
+        Serial.print (": ") ;
+        Serial.println (s.bucketCount (i)) ;
+      }
+    }
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————
+static uint32_t gBurstDate = 0 ;
+static uint32_t gPrintDate = 5000 ;
+//——————————————————————————————————————————————————————————————————————————————
+
+//——————————————————————————————————————————————————————————————————————————————
+//   LOOP
+//——————————————————————————————————————————————————————————————————————————————
+
+void loop () {
+  CANMessage frame ;
+  if ((millis () - gBurstDate) >= 20) {
+    gBurstDate += 20 ;
+    for (uint32_t i=0 ; i<BURST_SIZE ; i++) {
+      frame.id = 0x100 + i ;
+      frame.len = 8 ;
+      can.tryToSend (frame) ;
+    }
+  }
+  while (can.receive (frame)) {
+  }
+  if ((millis () - gPrintDate) >= 5000) {
+    gPrintDate += 5000 ;
+    digitalWrite (LED_BUILTIN, !digitalRead (LED_BUILTIN)) ;
+    for (uint8_t i=0 ; i<ACANProfiler::kSectionCount ; i++) {
+      printSection (ACANProfiler::Section (i)) ;
+    }
+    can.resetProfile () ;
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————
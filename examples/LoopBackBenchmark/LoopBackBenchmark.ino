@@ -0,0 +1,186 @@
+/******************************************************************************/
+/* File name        : LoopBackBenchmark.ino                                   */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Description      : Loopback throughput, latency and CPU load benchmark     */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+// Sweeps the ACANBenchmarkScenario list (bit rate, standard / extended, 0, 4, 8 data bytes, polling / interrupt) in
+// LoopBackMode and prints one CSV line per scenario (header first, comment lines start with '#'):
+//   - throughput: the bus is kept saturated for 1 s, then drained; frames per second, percent of the theoretical
+//     maximum (exact stuffed frame length), lost frames;
+//   - latency: one frame at a time on the idle bus, from the end of the frame (send date + frame duration) to its
+//     return by receive, p50 / p99 / p99.9 in ns;
+//   - CPU load: an idle counter task per core at the lowest priority, calibrated with the CAN controller idle.
+// In polling mode the application polls without sleeping, so it loads its core by design. The same scenarios run
+// on the desktop against a simulated controller (benchmark-on-desktop), with the same CSV format.
+
+/*------------------------------- Board Check --------------------------------*/
+#ifndef ARDUINO_ARCH_ESP32
+  #error "Select an ESP32 board"
+#endif
+
+/*------------------------------- Include files ------------------------------*/
+#include "ESP32ACAN.h"
+#include "ACANBenchmark.h"
+
+//——————————————————————————————————————————————————————————————————————————————
+//  ESP32 CAN Driver
+//——————————————————————————————————————————————————————————————————————————————
+
+ESP32ACAN can ;
+
+static const uint32_t THROUGHPUT_DURATION_MS = 1000 ;
+static const uint32_t DRAIN_TIMEOUT_MS = 20 ;
+static const uint32_t LATENCY_SAMPLE_COUNT = 500 ;
+
+//——————————————————————————————————————————————————————————————————————————————
+//  Idle counters: one task per core, lowest priority
+//——————————————————————————————————————————————————————————————————————————————
+
+static volatile uint32_t gIdleCount [2] = {0, 0} ;
+static uint32_t gIdleCountPerSecond [2] = {0, 0} ;
+
+static void idleCounterTask (void * inCore) {
+  volatile uint32_t * counter = & gIdleCount [(uintptr_t) inCore] ;
+  while (true) {
+    *counter += 1 ;
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————
+
+static uint16_t cpuLoadPermille (const uint32_t inIdleCount [2], const uint32_t inDurationMS) {
+  uint64_t idle = 0 ;
+  uint64_t available = 0 ;
+  for (uint32_t core=0 ; core<2 ; core++) {
+    idle += inIdleCount [core] ;
+    available += (uint64_t (gIdleCountPerSecond [core]) * inDurationMS) / 1000 ;
+  }
+  const uint64_t idlePermille = (available == 0) ? 1000 : ((idle * 1000) / available) ;
+  return (idlePermille >= 1000) ? 0 : uint16_t (1000 - idlePermille) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————
+//  Receive: busy polling, or blocking until the receive interrupt
+//——————————————————————————————————————————————————————————————————————————————
+
+static bool receiveFrame (const ACANBenchmarkScenario & inScenario, CANMessage & outFrame, const uint32_t inTimeoutMS) {
+  bool ok ;
+  if (inScenario.mMode == ACANBenchmarkScenario::Interrupt) {
+    ok = can.receive (outFrame, pdMS_TO_TICKS (inTimeoutMS)) ;
+  }else{
+    const uint32_t start = millis () ;
+    do{
+      ok = can.receive (outFrame) ;
+    }while (!ok && ((millis () - start) < inTimeoutMS)) ;
+  }
+  return ok ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————
+//  Scenario
+//——————————————————————————————————————————————————————————————————————————————
+
+static uint32_t gLatencies [LATENCY_SAMPLE_COUNT] ;
+
+static bool runScenario (const ACANBenchmarkScenario & inScenario, ACANBenchmarkResult & outResult) {
+  ESP32ACANSettings settings (inScenario.mBitRate) ;
+  settings.mRequestedCANMode = ESP32ACANSettings::LoopBackMode ;
+  settings.mControlMessageByMethod = (inScenario.mMode == ACANBenchmarkScenario::Interrupt)
+    ? ESP32ACANSettings::InterruptControlled
+    : ESP32ACANSettings::PollingControlled ;
+  const uint32_t errorCode = can.begin (settings) ;
+  if (errorCode != 0) {
+    Serial.print ("# configuration error 0x") ;
+    Serial.println (errorCode, HEX) ;
+  }else{
+    outResult = ACANBenchmarkResult () ;
+    outResult.mActualBitRate = settings.actualBitRate () ;
+    const CANMessage frame = inScenario.frame () ;
+    CANMessage received ;
+  //--- Throughput: saturated during THROUGHPUT_DURATION_MS, then drained
+    const uint32_t idleStart [2] = {gIdleCount [0], gIdleCount [1]} ;
+    const uint32_t startMS = millis () ;
+    const uint32_t start = micros () ;
+    uint32_t lastReception = start ;
+    while ((millis () - startMS) < THROUGHPUT_DURATION_MS) {
+      while (can.tryToSend (frame)) {
+        outResult.mSentCount += 1 ;
+      }
+      if (receiveFrame (inScenario, received, 1)) {
+        do{
+          outResult.mReceivedCount += 1 ;
+        }while (can.receive (received)) ;
+        lastReception = micros () ;
+      }
+    }
+    const uint32_t idleCount [2] = {gIdleCount [0] - idleStart [0], gIdleCount [1] - idleStart [1]} ;
+    outResult.mCPULoadPermille = cpuLoadPermille (idleCount, millis () - startMS) ;
+    while ((outResult.mReceivedCount < outResult.mSentCount) && receiveFrame (inScenario, received, DRAIN_TIMEOUT_MS)) {
+      outResult.mReceivedCount += 1 ;
+      lastReception = micros () ;
+    }
+    outResult.mDurationMicroseconds = lastReception - start ;
+  //--- Latency: one frame at a time; the frame ends frameNanoseconds after it is written to the TX registers
+    const uint32_t frameNanoseconds = uint32_t (
+      (uint64_t (ACANFrameLength::bitLength (frame, ACANFrameLength::ActualStuffing)) * 1000000000ULL)
+      / outResult.mActualBitRate) ;
+    const uint32_t cyclesPerMicrosecond = ESP.getCpuFreqMHz () ;
+    uint32_t sampleCount = 0 ;
+    for (uint32_t i=0 ; i<LATENCY_SAMPLE_COUNT ; i++) {
+      delayMicroseconds (50 + (esp_random () % 200)) ; // Random phase
+      const uint32_t sendDate = ESP.getCycleCount () ;
+      if (can.tryToSend (frame) && receiveFrame (inScenario, received, 100)) {
+        const uint32_t nanoseconds = uint32_t ((uint64_t (ESP.getCycleCount () - sendDate) * 1000) / cyclesPerMicrosecond) ;
+        gLatencies [sampleCount] = (nanoseconds > frameNanoseconds) ? (nanoseconds - frameNanoseconds) : 0 ;
+        sampleCount += 1 ;
+      }
+    }
+    outResult.setLatencies (gLatencies, sampleCount) ;
+  }
+  can.end () ;
+  return errorCode == 0 ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————
+//   SETUP: idle counter calibration, then every scenario
+//——————————————————————————————————————————————————————————————————————————————
+
+void setup () {
+  Serial.begin (115200) ;
+  while (!Serial) {
+    delay (50) ;
+  }
+  xTaskCreatePinnedToCore (idleCounterTask, "idle0", 1024, (void *) 0, tskIDLE_PRIORITY, nullptr, 0) ;
+  xTaskCreatePinnedToCore (idleCounterTask, "idle1", 1024, (void *) 1, tskIDLE_PRIORITY, nullptr, 1) ;
+  const uint32_t idleStart [2] = {gIdleCount [0], gIdleCount [1]} ;
+  delay (1000) ;
+  gIdleCountPerSecond [0] = gIdleCount [0] - idleStart [0] ;
+  gIdleCountPerSecond [1] = gIdleCount [1] - idleStart [1] ;
+  Serial.print ("# CPU ") ;
+  Serial.print (ESP.getCpuFreqMHz ()) ;
+  Serial.println (" MHz") ;
+  char line [256] ;
+  ACANBenchmarkReport::header (line, sizeof (line)) ;
+  Serial.println (line) ;
+  for (uint16_t i=0 ; i<ACANBenchmarkScenario::count () ; i++) {
+    const ACANBenchmarkScenario scenario = ACANBenchmarkScenario::atIndex (i) ;
+    ACANBenchmarkResult result ;
+    if (runScenario (scenario, result)) {
+      ACANBenchmarkReport::line (line, sizeof (line), "esp32", scenario, result) ;
+      Serial.println (line) ;
+    }
+  }
+  Serial.println ("# done") ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————
+
+void loop () {
+  delay (1000) ;
+}
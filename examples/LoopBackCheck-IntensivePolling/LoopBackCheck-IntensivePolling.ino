@@ -103,7 +103,11 @@ void loop() {
     Serial.print (" RXERR ") ;
     Serial.print (CAN_RX_ECR, HEX) ;
     Serial.print (" TXERR ") ;
-    Serial.println (CAN_TX_ECR, HEX) ;
+    Serial.print (CAN_TX_ECR, HEX) ;
+    Serial.print (" Dropped ") ;
+    Serial.print (can.driverReceiveDropCount ()) ;
+    Serial.print (" Overruns ") ;
+    Serial.println (can.controllerOverrunCount ()) ;
   }
   
   CANMessage frame ;
@@ -110,8 +110,13 @@ void loop() {
       gSentFrameCount += 1 ;
     }
   }
-  
-  while (can.receive (frame)) {
+//--- Sleep until a frame is received or the next blink date: no busy loop on an idle bus
+  const uint32_t now = millis () ;
+  const TickType_t timeout = (gBlinkLedDate > now) ? pdMS_TO_TICKS (gBlinkLedDate - now) : 0 ;
+  if (can.receive (frame, timeout)) {
     gReceivedFrameCount += 1 ;
+    while (can.receive (frame)) {
+      gReceivedFrameCount += 1 ;
+    }
   }
 }
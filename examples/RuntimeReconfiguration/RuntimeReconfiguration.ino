@@ -0,0 +1,113 @@
+/******************************************************************************/
+/* File name        : RuntimeReconfiguration.ino                              */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Description      : Bit rate and acceptance filter changes without begin    */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+// LoopBackMode, interrupt controlled. Every cycle queues a burst of frames (identifiers 0 ... BURST - 1), then at once
+// switches the bit rate (1 Mbit/s <-> 500 kbit/s, reconfigure) or the acceptance filter (all identifiers <-> even
+// identifiers, setFilter) while the burst is being sent. Queued frames survive the reconfiguration: every frame of
+// the burst that passes the filter in effect when it is received comes back (after a filter change, between the
+// frames passing the even filter and the whole burst). Prints the downtime of each reconfiguration.
+
+/*------------------------------- Board Check --------------------------------*/
+#ifndef ARDUINO_ARCH_ESP32
+  #error "Select an ESP32 board"
+#endif
+
+/*------------------------------- Include files ------------------------------*/
+#include "ESP32ACAN.h"
+
+//——————————————————————————————————————————————————————————————————————————————
+//  ESP32 CAN Driver
+//——————————————————————————————————————————————————————————————————————————————
+
+ESP32ACAN can ;
+
+static const uint32_t BURST = 12 ;
+
+static const ESP32ACANSettings SETTINGS [2] = {
+  ESP32ACANSettings (1000UL * 1000UL),
+  ESP32ACANSettings (500UL * 1000UL)
+} ;
+
+//——————————————————————————————————————————————————————————————————————————————
+//   SETUP
+//——————————————————————————————————————————————————————————————————————————————
+
+void setup () {
+  Serial.begin (115200) ;
+  while (!Serial) {
+    delay (50) ;
+  }
+  ESP32ACANSettings settings = SETTINGS [0] ;
+  settings.mRequestedCANMode = ESP32ACANSettings::LoopBackMode ;
+  settings.mControlMessageByMethod = ESP32ACANSettings::InterruptControlled ;
+  const uint32_t errorCode = can.begin (settings, acceptAllFilter ()) ;
+  if (errorCode != 0) {
+    Serial.print ("Configuration error 0x") ;
+    Serial.println (errorCode, HEX) ;
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————
+//   LOOP
+//——————————————————————————————————————————————————————————————————————————————
+
+static uint32_t gCycle = 0 ;
+static uint32_t gMaxDowntime = 0 ;
+static bool gEvenFilter = false ;
+
+void loop () {
+//--- Burst, then reconfiguration while it is being sent
+  CANMessage frame ;
+  frame.len = 8 ;
+  uint32_t sent = 0 ;
+  for (uint32_t id=0 ; id<BURST ; id++) {
+    frame.id = id ;
+    if (can.tryToSend (frame)) {
+      sent += 1 ;
+    }
+  }
+  const bool bitRateChange = (gCycle % 2) == 0 ;
+  if (bitRateChange) {
+    can.reconfigure (SETTINGS [(gCycle / 2) % 2]) ;
+  }else{
+    gEvenFilter = !gEvenFilter ;
+    can.setFilter (gEvenFilter
+      ? acceptSingleFilterStandard (0x000, 0x00, 0x00, 0x7FE, 0xFF, 0xFF) // Identifier bit 0 must be 0
+      : acceptAllFilter ()) ;
+  }
+//--- Frames of the burst received back
+  uint32_t received = 0 ;
+  while (can.receive (frame, pdMS_TO_TICKS (10))) {
+    received += 1 ;
+  }
+  const uint32_t evenCount = (sent + 1) / 2 ;
+  const bool ok = bitRateChange
+    ? (received == (gEvenFilter ? evenCount : sent))
+    : ((received >= evenCount) && (received <= sent)) ;
+  const uint32_t downtime = can.lastReconfigurationMicros () ;
+  if (gMaxDowntime < downtime) {
+    gMaxDowntime = downtime ;
+  }
+  Serial.print (bitRateChange ? "bit rate " : "filter   ") ;
+  Serial.print ("downtime: ") ;
+  Serial.print (downtime) ;
+  Serial.print (" us (max ") ;
+  Serial.print (gMaxDowntime) ;
+  Serial.print (" us), sent: ") ;
+  Serial.print (sent) ;
+  Serial.print (", received: ") ;
+  Serial.print (received) ;
+  Serial.println (ok ? "" : " (frames lost)") ;
+  gCycle += 1 ;
+  delay (500) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————
@@ -0,0 +1,56 @@
+/******************************************************************************/
+/* File name        : SLCANBridge.ino                                         */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Description      : USB-CAN adapter, SLCAN (Lawicel) protocol               */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+// The board is an SLCAN adapter on Serial: the host opens it (Linux: slcand -o -s8 -S 2000000 /dev/ttyUSB0 slcan0,
+// then ip link set up slcan0; or any Lawicel tool). The host sets the bit rate and opens the controller, so setup ()
+// does not call begin. A 100 % loaded 1 Mbit/s bus of 8 byte standard frames with timestamps needs about 2.2 Mbaud;
+// at 2 Mbaud, frames wait in the driver receive buffer (ESP32ACAN::kSLCANReceiveBufferSize) during bursts.
+// Serial carries the protocol only: the LED blinks while the bridge is open.
+
+/*------------------------------- Board Check --------------------------------*/
+#ifndef ARDUINO_ARCH_ESP32
+  #error "Select an ESP32 board"
+#endif
+
+/*------------------------------- Include files ------------------------------*/
+#include "ESP32ACAN.h"
+
+//——————————————————————————————————————————————————————————————————————————————
+//  ESP32 CAN Driver, SLCAN bridge
+//——————————————————————————————————————————————————————————————————————————————
+
+ESP32ACAN can ;
+
+ACANSLCAN bridge (can) ;
+
+static const uint32_t SERIAL_BAUD_RATE = 2000000 ;
+
+//——————————————————————————————————————————————————————————————————————————————
+//   SETUP
+//——————————————————————————————————————————————————————————————————————————————
+
+void setup () {
+  Serial.setRxBufferSize (1024) ;
+  Serial.setTxBufferSize (2048) ;
+  Serial.begin (SERIAL_BAUD_RATE) ;
+  pinMode (LED_BUILTIN, OUTPUT) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————
+//   LOOP
+//——————————————————————————————————————————————————————————————————————————————
+
+void loop () {
+  bridge.poll (Serial, millis ()) ;
+  digitalWrite (LED_BUILTIN, bridge.isOpen () && (((millis () / 250) % 2) == 0)) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————
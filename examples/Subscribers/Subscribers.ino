@@ -0,0 +1,133 @@
+/******************************************************************************/
+/* File name        : Subscribers.ino                                         */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Description      : Control loop and logger tasks subscribed to one driver  */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+// LoopBackMode, interrupt controlled. A sender task sends frames with identifiers 0x100 ... 0x10F (control) and
+// 0x200 ... 0x2FF (other traffic), their sequence number in data32 [0]. The control loop task subscribes to
+// 0x100 ... 0x10F and waits for its frames; the logger task subscribes to every frame but stalls 50 ms every 100
+// frames. Every second: frames received and dropped per subscriber, and the frames lost by the control loop
+// (sequence gaps): the logger drops, the control loop does not.
+
+/*------------------------------- Board Check --------------------------------*/
+#ifndef ARDUINO_ARCH_ESP32
+  #error "Select an ESP32 board"
+#endif
+
+/*------------------------------- Include files ------------------------------*/
+#include "ESP32ACAN.h"
+
+//——————————————————————————————————————————————————————————————————————————————
+//  ESP32 CAN Driver
+//——————————————————————————————————————————————————————————————————————————————
+
+ESP32ACAN can ;
+
+static ACANSubscriber gControlSubscriber ;
+static ACANSubscriber gLoggerSubscriber ;
+
+//——————————————————————————————————————————————————————————————————————————————
+//  Sender, control loop and logger tasks
+//——————————————————————————————————————————————————————————————————————————————
+
+static void senderTask (void *) {
+  CANMessage frame ;
+  frame.len = 8 ;
+  uint32_t sequence = 0 ;
+  while (true) {
+    frame.id = ((sequence % 4) == 0) ? (0x100 + ((sequence / 4) & 0xF)) : (0x200 + (sequence & 0xFF)) ;
+    frame.data32 [0] = sequence ;
+    if (can.send (frame, portMAX_DELAY)) {
+      sequence += 1 ;
+    }
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————
+
+static volatile uint32_t gControlReceivedCount = 0 ;
+static volatile uint32_t gControlLostCount = 0 ;
+
+static void controlLoopTask (void *) {
+  uint32_t expectedSequence = 0 ;
+  CANMessage frame ;
+  while (true) {
+    if (can.receive (gControlSubscriber, frame, portMAX_DELAY)) {
+      if ((expectedSequence != 0) && (frame.data32 [0] != expectedSequence)) {
+        gControlLostCount += (frame.data32 [0] - expectedSequence) / 4 ;
+      }
+      expectedSequence = frame.data32 [0] + 4 ;
+      gControlReceivedCount += 1 ;
+    }
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————
+
+static volatile uint32_t gLoggerReceivedCount = 0 ;
+
+static void loggerTask (void *) {
+  CANMessage frame ;
+  while (true) {
+    if (can.receive (gLoggerSubscriber, frame, portMAX_DELAY)) {
+      gLoggerReceivedCount += 1 ;
+      if ((gLoggerReceivedCount % 100) == 0) {
+        vTaskDelay (pdMS_TO_TICKS (50)) ; // Slow storage
+      }
+    }
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————
+//   SETUP
+//——————————————————————————————————————————————————————————————————————————————
+
+void setup () {
+  Serial.begin (115200) ;
+  while (!Serial) {
+    delay (50) ;
+  }
+  ESP32ACANSettings settings (1000UL * 1000UL) ;
+  settings.mRequestedCANMode = ESP32ACANSettings::LoopBackMode ;
+  settings.mControlMessageByMethod = ESP32ACANSettings::InterruptControlled ;
+  const uint32_t errorCode = can.begin (settings) ;
+  if (errorCode != 0) {
+    Serial.print ("Configuration error 0x") ;
+    Serial.println (errorCode, HEX) ;
+  }
+  gControlSubscriber.begin (64) ;
+  gControlSubscriber.addFilter (0x100, 0x7F0, false) ;
+  gLoggerSubscriber.begin (256) ;
+  can.subscribe (gControlSubscriber) ;
+  can.subscribe (gLoggerSubscriber) ;
+  xTaskCreatePinnedToCore (controlLoopTask, "control", 2048, nullptr, 3, nullptr, 1) ;
+  xTaskCreatePinnedToCore (loggerTask, "logger", 2048, nullptr, 1, nullptr, 1) ;
+  xTaskCreatePinnedToCore (senderTask, "sender", 2048, nullptr, 2, nullptr, 0) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————
+//   LOOP: one report per second
+//——————————————————————————————————————————————————————————————————————————————
+
+void loop () {
+  delay (1000) ;
+  Serial.print ("control: ") ;
+  Serial.print (gControlReceivedCount) ;
+  Serial.print (" received, ") ;
+  Serial.print (gControlSubscriber.dropCount ()) ;
+  Serial.print (" dropped, ") ;
+  Serial.print (gControlLostCount) ;
+  Serial.print (" lost; logger: ") ;
+  Serial.print (gLoggerReceivedCount) ;
+  Serial.print (" received, ") ;
+  Serial.print (gLoggerSubscriber.dropCount ()) ;
+  Serial.println (" dropped") ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————
@@ -0,0 +1,180 @@
+/******************************************************************************/
+/* File name        : ACANHostLinkHost.cpp                                    */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Compiler         : Desktop C++ COMPILER (Visual Studio Code)               */
+/* Description      : Linux side of the binary host link                      */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation                                                        */
+/* ---------------------------------------------------------------------------*/
+
+/*------------------------------- Include files ------------------------------*/
+#include "ACANHostLinkHost.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+ACANHostLinkPort::ACANHostLinkPort (void) :
+mLink (),
+mFileDescriptor (-1),
+mTimestampBase (0),
+mLastTimestamp (0) {
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+ACANHostLinkPort::~ ACANHostLinkPort (void) {
+  close () ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static bool termiosSpeed (const uint32_t inBaudRate, speed_t & outSpeed) {
+  static const struct { uint32_t mBaudRate ; speed_t mSpeed ; } kSpeeds [] = {
+    {9600, B9600}, {19200, B19200}, {38400, B38400}, {57600, B57600}, {115200, B115200}, {230400, B230400},
+    {460800, B460800}, {500000, B500000}, {921600, B921600}, {1000000, B1000000}, {1500000, B1500000},
+    {2000000, B2000000}, {2500000, B2500000}, {3000000, B3000000}, {4000000, B4000000}
+  } ;
+  bool found = false ;
+  for (const auto & entry : kSpeeds) {
+    if (entry.mBaudRate == inBaudRate) {
+      outSpeed = entry.mSpeed ;
+      found = true ;
+    }
+  }
+  return found ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+bool ACANHostLinkPort::openSerialPort (const char * inPath,
+                                       const uint32_t inBaudRate,
+                                       const uint16_t inReceiveCapacity) {
+  speed_t speed = B0 ;
+  bool ok = termiosSpeed (inBaudRate, speed) ;
+  if (!ok) {
+    errno = EINVAL ;
+  }
+  const int fd = ok ? ::open (inPath, O_RDWR | O_NOCTTY) : -1 ;
+  ok = fd >= 0 ;
+  if (ok) {
+    struct termios attributes ;
+    ok = tcgetattr (fd, &attributes) == 0 ;
+    if (ok) {
+      cfmakeraw (&attributes) ;
+      attributes.c_cflag &= ~ (CSTOPB | CRTSCTS) ;
+      attributes.c_cflag |= CLOCAL | CREAD ;
+      cfsetispeed (&attributes, speed) ;
+      cfsetospeed (&attributes, speed) ;
+      ok = tcsetattr (fd, TCSANOW, &attributes) == 0 ;
+    }
+    if (ok) {
+      tcflush (fd, TCIOFLUSH) ;
+      ok = attach (fd, inReceiveCapacity) ;
+    }else{
+      ::close (fd) ;
+    }
+  }
+  return ok ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+bool ACANHostLinkPort::attach (const int inFileDescriptor, const uint16_t inReceiveCapacity) {
+  close () ;
+  const bool ok = (fcntl (inFileDescriptor, F_SETFL, fcntl (inFileDescriptor, F_GETFL) | O_NONBLOCK) == 0)
+    && mLink.begin (inReceiveCapacity) ;
+  if (ok) {
+    mFileDescriptor = inFileDescriptor ;
+    mTimestampBase = 0 ;
+    mLastTimestamp = 0 ;
+  }
+  return ok ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ACANHostLinkPort::close (void) {
+  if (mFileDescriptor >= 0) {
+    ::close (mFileDescriptor) ;
+    mFileDescriptor = -1 ;
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+uint32_t ACANHostLinkPort::nowMicros (void) {
+  struct timespec now ;
+  clock_gettime (CLOCK_MONOTONIC, &now) ;
+  return uint32_t (uint64_t (now.tv_sec) * 1000000 + uint64_t (now.tv_nsec) / 1000) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+bool ACANHostLinkPort::poll (const int inTimeoutMillis) {
+  bool ok = mFileDescriptor >= 0 ;
+  if (ok) {
+    struct pollfd descriptor = {mFileDescriptor, POLLIN, 0} ;
+    if (mLink.outputLength () > 0) {
+      descriptor.events |= POLLOUT ;
+    }
+    ok = (::poll (&descriptor, 1, inTimeoutMillis) >= 0) || (errno == EINTR) ;
+  }
+  if (ok) {
+    uint8_t buffer [4096] ;
+    ssize_t n = read (mFileDescriptor, buffer, sizeof (buffer)) ;
+    while (n > 0) {
+      mLink.receiveBytes (buffer, size_t (n)) ;
+      n = read (mFileDescriptor, buffer, sizeof (buffer)) ;
+    }
+    ok = (n < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR)) ;
+  }
+  if (ok) {
+    mLink.flush () ;
+    mLink.update (nowMicros ()) ;
+    if (mLink.outputLength () > 0) {
+      const ssize_t n = write (mFileDescriptor, mLink.output (), mLink.outputLength ()) ;
+      if (n > 0) {
+        mLink.consumeOutput (uint16_t (n)) ;
+      }else{
+        ok = (n < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR)) ;
+      }
+    }
+  }
+  return ok ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+bool ACANHostLinkPort::send (const CANMessage & inFrame) {
+  return mLink.appendFrame (inFrame, nowMicros ()) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+bool ACANHostLinkPort::receive (CANMessage & outFrame, uint64_t & outTimestampMicros) {
+  uint32_t timestamp = 0 ;
+  const bool ok = mLink.receive (outFrame, timestamp) ;
+  if (ok) {
+    if (timestamp < mLastTimestamp) {
+      mTimestampBase += uint64_t (1) << 32 ;
+    }
+    mLastTimestamp = timestamp ;
+    outTimestampMicros = mTimestampBase + timestamp ;
+  }
+  return ok ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
@@ -0,0 +1,66 @@
+/******************************************************************************/
+/* File name        : ACANHostLinkHost.h                                      */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Compiler         : Desktop C++ COMPILER (Visual Studio Code)               */
+/* Description      : Linux side of the binary host link                      */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation                                                        */
+/* ---------------------------------------------------------------------------*/
+
+#pragma once
+
+/*------------------------------- Include files ------------------------------*/
+#include "../src/ACANHostLink.h"
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   An ACANHostLink endpoint on a file descriptor: a serial port (raw 8N1, no flow control), or any descriptor
+//   (pseudo terminal, socket pair). Call poll in a loop: it reads what the peer sent (waiting up to inTimeoutMillis),
+//   sends the frames appended by send, and the credits. Timestamps of sent frames are CLOCK_MONOTONIC µs; those of
+//   received frames are the 32 bit µs of the peer extended to 64 bits (a gap longer than 71 minutes is not seen).
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+class ACANHostLinkPort {
+
+  public: ACANHostLinkPort (void) ;
+
+  public: ~ ACANHostLinkPort (void) ;
+
+  //--- Baud rate: a termios rate (9600 ... 4000000); returns false on error (see errno)
+  public: bool openSerialPort (const char * inPath, const uint32_t inBaudRate, const uint16_t inReceiveCapacity) ;
+
+  //--- Any descriptor, made non blocking; closed by close
+  public: bool attach (const int inFileDescriptor, const uint16_t inReceiveCapacity) ;
+
+  public: void close (void) ;
+
+  //--- false on an I/O error or end of file
+  public: bool poll (const int inTimeoutMillis) ;
+
+  //--- false without credit (or output room): poll, then send again
+  public: bool send (const CANMessage & inFrame) ;
+
+  public: bool receive (CANMessage & outFrame, uint64_t & outTimestampMicros) ;
+
+  public: inline const ACANHostLink & link (void) const { return mLink ; }
+
+  public: static uint32_t nowMicros (void) ; // CLOCK_MONOTONIC
+
+  private: ACANHostLink mLink ;
+  private: int mFileDescriptor ;
+  private: uint64_t mTimestampBase ;   // High part of the extended timestamps
+  private: uint32_t mLastTimestamp ;
+
+//--- No copy
+  private: ACANHostLinkPort (const ACANHostLinkPort &) = delete ;
+  private: ACANHostLinkPort & operator = (const ACANHostLinkPort &) = delete ;
+} ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
@@ -0,0 +1,83 @@
+/******************************************************************************/
+/* File name        : main.cpp                                                */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Compiler         : Desktop C++ COMPILER (Visual Studio Code)               */
+/* Description      : Dump of the frames received through the host link       */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation                                                        */
+/* ---------------------------------------------------------------------------*/
+
+// Usage: host-link <serial device> [baud rate, default 2000000]
+// Linux. The board runs examples/HostLinkBridge. Received frames are printed on stdout, one per line:
+//   (seconds.micros) identifier [length] data bytes      (identifier: 3 hex digits standard, 8 extended; R: remote)
+// Link statistics are printed on stderr every second. Build: g++ -std=c++11 -O2 main.cpp -o host-link
+
+/*------------------------------- Include files ------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "ACANHostLinkHost.cpp"
+#include "../src/ACANHostLink.cpp"
+#include "../src/ACANE2E.cpp"
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static const uint16_t kReceiveCapacity = 4096 ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+int main (int argc, const char * argv []) {
+  if ((argc != 2) && (argc != 3)) {
+    fprintf (stderr, "Usage: %s <serial device> [baud rate]\n", argv [0]) ;
+    return 2 ;
+  }
+  const uint32_t baudRate = (argc == 3) ? uint32_t (strtoul (argv [2], nullptr, 10)) : 2000000 ;
+  ACANHostLinkPort port ;
+  if (!port.openSerialPort (argv [1], baudRate, kReceiveCapacity)) {
+    fprintf (stderr, "Cannot open %s at %u baud: %s\n", argv [1], unsigned (baudRate), strerror (errno)) ;
+    return 2 ;
+  }
+  uint32_t statisticsDate = ACANHostLinkPort::nowMicros () ;
+  uint32_t frameCount = 0 ;
+  while (port.poll (100)) {
+    CANMessage frame ;
+    uint64_t timestamp = 0 ;
+    while (port.receive (frame, timestamp)) {
+      frameCount += 1 ;
+      printf ("(%llu.%06llu) ", (unsigned long long) (timestamp / 1000000), (unsigned long long) (timestamp % 1000000)) ;
+      printf (frame.ext ? "%08X" : "%03X", unsigned (frame.id)) ;
+      printf ("   [%u] ", unsigned (frame.len)) ;
+      if (frame.rtr) {
+        printf (" R") ;
+      }else{
+        for (uint8_t i=0 ; i<frame.len ; i++) {
+          printf (" %02X", unsigned (frame.data [i])) ;
+        }
+      }
+      printf ("\n") ;
+    }
+    const uint32_t now = ACANHostLinkPort::nowMicros () ;
+    if ((now - statisticsDate) >= 1000000) {
+      statisticsDate = now ;
+      const ACANHostLink & link = port.link () ;
+      fprintf (stderr, "%u frames/s, packets: %u received, %u corrupted, %u lost; frames lost: %u\n",
+               unsigned (frameCount), unsigned (link.receivedPacketCount ()), unsigned (link.corruptedPacketCount ()),
+               unsigned (link.lostPacketCount ()), unsigned (link.lostFrameCount ())) ;
+      frameCount = 0 ;
+      fflush (stdout) ;
+    }
+  }
+  fprintf (stderr, "%s: %s\n", argv [1], strerror (errno)) ;
+  return 1 ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
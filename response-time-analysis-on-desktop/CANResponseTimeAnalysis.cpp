@@ -0,0 +1,197 @@
+/******************************************************************************/
+/* File name        : CANResponseTimeAnalysis.cpp                             */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Compiler         : Desktop C++ COMPILER (Visual Studio Code)               */
+/* Description      : Worst-case response time analysis of a CAN message set  */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation                                                        */
+/* ---------------------------------------------------------------------------*/
+
+/*------------------------------- Include files ------------------------------*/
+#include "CANResponseTimeAnalysis.h"
+#include "../src/ACANBusLoad.h"
+#include <algorithm>
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+using namespace std ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static inline uint64_t ceilDiv (const uint64_t inA, const uint64_t inB) {
+  return (inA + inB - 1) / inB ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+// Bits sent during arbitration, dominant (0) wins: the lowest key wins (as VirtualCANBus).
+//   standard: ID[10:0] RTR IDE=0
+//   extended: ID[28:18] SRR=1 IDE=1 ID[17:0] RTR
+
+uint64_t CANResponseTimeAnalysis::arbitrationKey (const CANAnalysedMessage & inMessage) {
+  uint64_t key ;
+  if (inMessage.mExtended) {
+    key = ((uint64_t) ((inMessage.mIdentifier >> 18) & 0x7FF) << 21)
+        | (1ULL << 20) | (1ULL << 19)
+        | ((uint64_t) (inMessage.mIdentifier & 0x3FFFF) << 1)
+        | (inMessage.mRemote ? 1 : 0) ;
+  }else{
+    key = ((uint64_t) (inMessage.mIdentifier & 0x7FF) << 21) | ((inMessage.mRemote ? 1ULL : 0ULL) << 20) ;
+  }
+  return key ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+int32_t CANResponseTimeAnalysis::duplicateIdentifierIndex (const vector <CANAnalysedMessage> & inMessages) {
+  int32_t result = -1 ;
+  for (size_t i=1 ; (i<inMessages.size ()) && (result < 0) ; i++) {
+    const CANAnalysedMessage & a = inMessages [i-1] ;
+    const CANAnalysedMessage & b = inMessages [i] ;
+    if ((a.mIdentifier == b.mIdentifier) && (a.mExtended == b.mExtended)) {
+      result = (int32_t) i ;
+    }
+  }
+  return result ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   Interference classes: messages with the same period and jitter, sorted by slack (period - jitter)
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+// A class whose slack is >= the window (plus offset) sends exactly one instance in it: classes are visited in slack
+// order until this holds, the remaining ones add their transmission time sums, without any division.
+
+class InterferenceClass {
+  public: uint64_t mSlack ;
+  public: uint64_t mPeriod ;
+  public: uint64_t mJitter ;
+  public: uint64_t mTransmissionTimeSum ;   // Of the higher priority messages of this class
+} ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static bool slackOrder (const InterferenceClass & inA, const InterferenceClass & inB) {
+  return (inA.mSlack < inB.mSlack) || ((inA.mSlack == inB.mSlack) && (inA.mPeriod < inB.mPeriod)) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void addToClass (vector <InterferenceClass> & ioClasses,
+                        const uint64_t inPeriod,
+                        const uint64_t inJitter,
+                        const uint64_t inTransmissionTime) {
+  InterferenceClass ic ;
+  ic.mSlack = (inJitter < inPeriod) ? (inPeriod - inJitter) : 0 ;
+  ic.mPeriod = inPeriod ;
+  ic.mJitter = inJitter ;
+  ic.mTransmissionTimeSum = inTransmissionTime ;
+  vector <InterferenceClass>::iterator it = lower_bound (ioClasses.begin (), ioClasses.end (), ic, slackOrder) ;
+  if ((it != ioClasses.end ()) && (it->mPeriod == inPeriod) && (it->mJitter == inJitter)) {
+    it->mTransmissionTimeSum += inTransmissionTime ;
+  }else{
+    ioClasses.insert (it, ic) ;
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static uint64_t interference (const vector <InterferenceClass> & inClasses,
+                              const uint64_t inTransmissionTimeSum, // Of all classes
+                              const uint64_t inWindow,
+                              const uint64_t inOffset) {
+  const uint64_t window = inWindow + inOffset ;
+  uint64_t sum = 0 ;
+  uint64_t visitedSum = 0 ;
+  for (size_t c=0 ; (c<inClasses.size ()) && (inClasses [c].mSlack < window) ; c++) {
+    const InterferenceClass & ic = inClasses [c] ;
+    sum += ceilDiv (window + ic.mJitter, ic.mPeriod) * ic.mTransmissionTimeSum ;
+    visitedSum += ic.mTransmissionTimeSum ;
+  }
+  return sum + (inTransmissionTimeSum - visitedSum) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   ANALYSIS
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+uint32_t CANResponseTimeAnalysis::analyse (vector <CANAnalysedMessage> & ioMessages, const uint32_t inBitRate) {
+  const size_t n = ioMessages.size () ;
+  sort (ioMessages.begin (), ioMessages.end (),
+        [] (const CANAnalysedMessage & a, const CANAnalysedMessage & b) { return arbitrationKey (a) < arbitrationKey (b) ; }) ;
+//--- Transmission times (rounded up to the ns), blocking from the lower priority messages
+  const uint64_t bitTime = ceilDiv (1000000000ULL, inBitRate) ;
+  for (size_t m=0 ; m<n ; m++) {
+    CANAnalysedMessage & message = ioMessages [m] ;
+    CANMessage frame ;
+    frame.ext = message.mExtended ;
+    frame.rtr = message.mRemote ;
+    frame.len = message.mLength ;
+    message.mFrameBits = ACANFrameLength::bitLength (frame, ACANFrameLength::WorstCaseStuffing) ;
+    message.mTransmissionTime = ceilDiv ((uint64_t) message.mFrameBits * 1000000000ULL, inBitRate) ;
+  }
+  uint64_t blocking = 0 ;
+  for (size_t m=n ; m>0 ; m--) {
+    ioMessages [m-1].mBlockingTime = blocking ;
+    blocking = max (blocking, ioMessages [m-1].mTransmissionTime) ;
+  }
+//--- Messages in priority order: classes hold the higher priority messages
+  vector <InterferenceClass> classes ;
+  uint64_t hpTransmissionTimeSum = 0 ;
+  double utilisation = 0.0 ; // Of the higher priority messages
+  uint32_t unschedulableCount = 0 ;
+  for (size_t m=0 ; m<n ; m++) {
+    CANAnalysedMessage & message = ioMessages [m] ;
+    const uint64_t C = message.mTransmissionTime ;
+    const uint64_t B = message.mBlockingTime ;
+    const uint64_t T = message.mPeriod ;
+    const uint64_t J = message.mJitter ;
+    utilisation += (double) C / (double) T ;
+    if (utilisation >= 1.0) { // Level-m busy period does not end
+      message.mBusyPeriod = kUnbounded ;
+      message.mInstanceCount = 0 ;
+      message.mResponseTime = kUnbounded ;
+    }else{
+    //--- Busy period, over hp(m) and m itself
+      uint64_t t = C ;
+      uint64_t next = B + interference (classes, hpTransmissionTimeSum, t, 0) + ceilDiv (t + J, T) * C ;
+      while (next != t) {
+        t = next ;
+        next = B + interference (classes, hpTransmissionTimeSum, t, 0) + ceilDiv (t + J, T) * C ;
+      }
+      message.mBusyPeriod = t ;
+      message.mInstanceCount = (uint32_t) ceilDiv (t + J, T) ;
+    //--- Queuing delay of each instance
+      uint64_t response = 0 ;
+      uint64_t w = B ;
+      for (uint32_t q=0 ; q<message.mInstanceCount ; q++) {
+        if (q > 0) {
+          w += C ;
+        }
+        uint64_t wNext = B + q * C + interference (classes, hpTransmissionTimeSum, w, bitTime) ;
+        while (wNext != w) {
+          w = wNext ;
+          wNext = B + q * C + interference (classes, hpTransmissionTimeSum, w, bitTime) ;
+        }
+        response = max (response, J + w + C - q * T) ;
+      }
+      message.mResponseTime = response ;
+    }
+    message.mSchedulable = message.mResponseTime <= message.deadline () ;
+    if (!message.mSchedulable) {
+      unschedulableCount += 1 ;
+    }
+  //--- m becomes a higher priority message
+    addToClass (classes, T, J, C) ;
+    hpTransmissionTimeSum += C ;
+  }
+  return unschedulableCount ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
@@ -0,0 +1,80 @@
+/******************************************************************************/
+/* File name        : CANResponseTimeAnalysis.h                               */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Compiler         : Desktop C++ COMPILER (Visual Studio Code)               */
+/* Description      : Worst-case response time analysis of a CAN message set  */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation                                                        */
+/* ---------------------------------------------------------------------------*/
+
+#pragma once
+
+/*------------------------------- Include files ------------------------------*/
+#include <stdint.h>
+#include <vector>
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   A message of the matrix: identifier, length, timing, and the analysis results. Times are in ns.
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+class CANAnalysedMessage {
+  public: uint32_t mIdentifier = 0 ;
+  public: bool mExtended = false ;
+  public: bool mRemote = false ;
+  public: uint8_t mLength = 8 ;
+  public: uint64_t mPeriod = 0 ;             // Minimum inter-arrival time
+  public: uint64_t mJitter = 0 ;             // Queuing jitter
+  public: uint64_t mDeadline = 0 ;           // 0: equal to the period
+
+//--- Results
+  public: uint32_t mFrameBits = 0 ;          // Worst case stuffed length, including intermission
+  public: uint64_t mTransmissionTime = 0 ;   // C
+  public: uint64_t mBlockingTime = 0 ;       // B: longest lower priority frame
+  public: uint64_t mBusyPeriod = 0 ;         // t: level-m busy period
+  public: uint32_t mInstanceCount = 0 ;      // Q: instances in the busy period
+  public: uint64_t mResponseTime = 0 ;       // R, kUnbounded if the level-m utilisation is >= 1
+  public: bool mSchedulable = false ;        // R <= deadline
+
+  public: inline uint64_t deadline (void) const { return (mDeadline == 0) ? mPeriod : mDeadline ; }
+} ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   Analysis
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+// Classic CAN schedulability analysis, revised form (Davis, Burns, Bril, Lukkien, "Controller Area Network (CAN)
+// schedulability analysis: Refuted, revisited and revised", Real-Time Systems 35, 2007), with the exact worst case
+// stuffed frame length (ACANFrameLength):
+//   B_m      = max C_k, k lower priority
+//   t_m      = B_m + sum_{k in hep(m)} ceil ((t_m + J_k) / T_k) C_k
+//   Q_m      = ceil ((t_m + J_m) / T_m)
+//   w_m (q)  = B_m + q C_m + sum_{k in hp(m)} ceil ((w_m (q) + J_k + tau_bit) / T_k) C_k,   q = 0 ... Q_m - 1
+//   R_m      = max_q (J_m + w_m (q) - q T_m + C_m)
+// Priority is the arbitration order (identifier bits on the wire, standard before extended with the same base).
+// Interference is summed by (period, jitter) class, each class holding the transmission times of its higher priority
+// messages: an iteration costs at most O(number of classes), not O(number of messages), and only the classes that
+// can send more than one instance in the window are divided. w_m (q) starts from w_m (q-1) + C_m, which is below its
+// fixed point.
+
+class CANResponseTimeAnalysis {
+
+  public: static const uint64_t kUnbounded = UINT64_MAX ;
+
+  //--- Sorts ioMessages by priority, fills the results; returns the number of unschedulable messages.
+  //    Identifiers must be unique (see duplicateIdentifierIndex).
+  public: static uint32_t analyse (std::vector <CANAnalysedMessage> & ioMessages, const uint32_t inBitRate) ;
+
+  //--- Index of a message whose identifier is used twice in inMessages (sorted by analyse), or -1
+  public: static int32_t duplicateIdentifierIndex (const std::vector <CANAnalysedMessage> & inMessages) ;
+
+  public: static uint64_t arbitrationKey (const CANAnalysedMessage & inMessage) ;
+} ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
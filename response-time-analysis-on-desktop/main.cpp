@@ -0,0 +1,166 @@
+/******************************************************************************/
+/* File name        : main.cpp                                                */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Compiler         : Desktop C++ COMPILER (Visual Studio Code)               */
+/* Description      : Worst-case response time analysis of a message matrix   */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation                                                        */
+/* ---------------------------------------------------------------------------*/
+
+// Usage: response-time-analysis <matrix file> <desired bit rate in bit/s>
+// The bit rate actually used is the one of the ESP32ACANSettings computed for the desired bit rate (APB 80 MHz).
+// Matrix file, one message per line, '#' starts a comment:
+//   identifier  S|X  length  period_ms  jitter_ms  [deadline_ms]
+// identifier is decimal or 0x hexadecimal, S: standard, X: extended; append R to S or X for a remote frame.
+// Exit status is 1 if a message is not schedulable, 2 on a usage or matrix error.
+
+/*------------------------------- Include files ------------------------------*/
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <stdlib.h>
+#include "CANResponseTimeAnalysis.cpp"
+#include "../test-ESP32CANSettings-on-desktop/ESP32ACANSettings.cpp"
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+using namespace std;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static const uint32_t kSourceClockAPB = 80 * 1000 * 1000 ;  // CAN Controller Source Clock (APB 80 MHz)
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static uint64_t nsFromMilliseconds (const double inMilliseconds) {
+  return (uint64_t) (inMilliseconds * 1.0e6 + 0.5) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static bool readMatrix (const char * inFileName, vector <CANAnalysedMessage> & outMessages) {
+  ifstream file (inFileName) ;
+  bool ok = file.good () ;
+  if (!ok) {
+    cout << "Cannot open " << inFileName << endl ;
+  }
+  string line ;
+  uint32_t lineNumber = 0 ;
+  while (ok && getline (file, line)) {
+    lineNumber += 1 ;
+    const size_t comment = line.find ('#') ;
+    if (comment != string::npos) {
+      line.erase (comment) ;
+    }
+    istringstream fields (line) ;
+    string identifier ;
+    if (fields >> identifier) {
+      CANAnalysedMessage message ;
+      string format ;
+      unsigned length = 0 ;
+      double period = 0.0 ;
+      double jitter = 0.0 ;
+      double deadline = 0.0 ;
+      ok = bool (fields >> format >> length >> period >> jitter) ;
+      if (ok && !(fields >> deadline)) {
+        deadline = 0.0 ;
+      }
+      char * end = NULL ;
+      message.mIdentifier = (uint32_t) strtoul (identifier.c_str (), &end, 0) ;
+      ok = ok && (*end == '\0') ;
+      ok = ok && ((format == "S") || (format == "X") || (format == "SR") || (format == "XR")) ;
+      message.mExtended = ok && (format [0] == 'X') ;
+      message.mRemote = ok && (format.size () == 2) ;
+      ok = ok && (message.mIdentifier <= (message.mExtended ? 0x1FFFFFFFUL : 0x7FFUL)) ;
+      ok = ok && (length <= 8) && (period > 0.0) && (jitter >= 0.0) && (deadline >= 0.0) ;
+      message.mLength = (uint8_t) length ;
+      message.mPeriod = nsFromMilliseconds (period) ;
+      message.mJitter = nsFromMilliseconds (jitter) ;
+      message.mDeadline = nsFromMilliseconds (deadline) ;
+      if (ok) {
+        outMessages.push_back (message) ;
+      }else{
+        cout << inFileName << ":" << lineNumber << ": invalid message" << endl ;
+      }
+    }
+  }
+  return ok ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void printTime (const uint64_t inNanoseconds) {
+  if (inNanoseconds == CANResponseTimeAnalysis::kUnbounded) {
+    cout << setw (12) << "unbounded" ;
+  }else{
+    cout << setw (12) << fixed << setprecision (3) << (double) inNanoseconds / 1000.0 ;
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+int main (int argc, const char * argv []) {
+  if (argc != 3) {
+    cout << "Usage: " << argv [0] << " <matrix file> <desired bit rate in bit/s>" << endl ;
+    return 2 ;
+  }
+  const uint32_t desiredBitRate = (uint32_t) strtoul (argv [2], NULL, 10) ;
+  if (desiredBitRate == 0) {
+    cout << "Invalid bit rate " << argv [2] << endl ;
+    return 2 ;
+  }
+  const ESP32ACANSettings settings (kSourceClockAPB, desiredBitRate) ;
+  if (!settings.mBitRateClosedToDesiredRate) {
+    cout << "No ESP32 bit setting for " << desiredBitRate << " bit/s" << endl ;
+    return 2 ;
+  }
+  const uint32_t bitRate = settings.actualBitRate () ;
+  vector <CANAnalysedMessage> messages ;
+  if (!readMatrix (argv [1], messages)) {
+    return 2 ;
+  }
+  const auto start = chrono::steady_clock::now () ;
+  const uint32_t unschedulableCount = CANResponseTimeAnalysis::analyse (messages, bitRate) ;
+  const auto duration = chrono::duration_cast <chrono::microseconds> (chrono::steady_clock::now () - start) ;
+  const int32_t duplicate = CANResponseTimeAnalysis::duplicateIdentifierIndex (messages) ;
+  if (duplicate >= 0) {
+    cout << "Identifier 0x" << hex << messages [duplicate].mIdentifier << dec << " is used twice" << endl ;
+    return 2 ;
+  }
+//--- Results, in priority order; times in µs
+  double utilisation = 0.0 ;
+  cout << "Bit rate " << bitRate << " bit/s (desired " << desiredBitRate << " bit/s)" << endl ;
+  cout << "  Identifier   Len  Bits      Period      Jitter    Deadline           C           B           R" << endl ;
+  for (size_t m=0 ; m<messages.size () ; m++) {
+    const CANAnalysedMessage & message = messages [m] ;
+    utilisation += (double) message.mTransmissionTime / (double) message.mPeriod ;
+    cout << (message.mSchedulable ? "  " : "! ")
+         << (message.mExtended ? "X " : "S ")
+         << "0x" << hex << setfill ('0') << setw (message.mExtended ? 8 : 3) << message.mIdentifier
+         << setfill (' ') << dec << setw (message.mExtended ? 1 : 6) << (message.mRemote ? "R" : " ")
+         << setw (4) << (unsigned) message.mLength << setw (6) << message.mFrameBits ;
+    printTime (message.mPeriod) ;
+    printTime (message.mJitter) ;
+    printTime (message.deadline ()) ;
+    printTime (message.mTransmissionTime) ;
+    printTime (message.mBlockingTime) ;
+    printTime (message.mResponseTime) ;
+    cout << endl ;
+  }
+  cout << messages.size () << " messages, bus utilisation " << setprecision (1) << (utilisation * 100.0) << "%, "
+       << unschedulableCount << " unschedulable (marked !), analysed in "
+       << setprecision (3) << (double) duration.count () / 1000.0 << " ms" << endl ;
+  return (unschedulableCount > 0) ? 1 : 0 ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
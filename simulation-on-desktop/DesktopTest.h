@@ -0,0 +1,44 @@
+/******************************************************************************/
+/* File name        : DesktopTest.h                                           */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Compiler         : Desktop C++ COMPILER (Visual Studio Code)               */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation                                                        */
+/* ---------------------------------------------------------------------------*/
+
+#pragma once
+
+/*------------------------------- Include files ------------------------------*/
+#include <iostream>
+#include <stdint.h>
+#include <stdlib.h>
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Shared by the desktop tests: check exits on the first failure, randomValue is a reproducible 24 bit LCG sequence
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static inline void check (const bool inCondition, const char * inMessage) {
+  if (!inCondition) {
+    std::cout << "  ERROR: " << inMessage << std::endl ;
+    exit (1) ;
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static uint32_t gSeed = 123456789 ;
+
+static inline uint32_t randomValue (void) {
+  gSeed = gSeed * 1103515245 + 12345 ;
+  return gSeed >> 8 ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
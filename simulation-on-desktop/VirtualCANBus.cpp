@@ -0,0 +1,192 @@
+/******************************************************************************/
+/* File name        : VirtualCANBus.cpp                                       */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Compiler         : Desktop C++ COMPILER (Visual Studio Code)               */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation                                                        */
+/* ---------------------------------------------------------------------------*/
+
+/*------------------------------- Include files ------------------------------*/
+#include "VirtualCANBus.h"
+#include "../src/ACANBusLoad.h"
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  VIRTUAL NODE
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+VirtualCANNode::VirtualCANNode (const size_t inTransmitBufferSize,
+                                const size_t inReceiveBufferSize) :
+mTransmitBufferSize (inTransmitBufferSize),
+mReceiveBufferSize (inReceiveBufferSize),
+mTransmitBuffer (),
+mReceiveBuffer () {
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+bool VirtualCANNode::tryToSend (const CANMessage & inMessage) {
+  const bool ok = mTransmitBuffer.size () < mTransmitBufferSize ;
+  if (ok) {
+    mTransmitBuffer.push_back (inMessage) ;
+  }
+  return ok ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+bool VirtualCANNode::receive (CANMessage & outMessage) {
+  const bool ok = !mReceiveBuffer.empty () ;
+  if (ok) {
+    outMessage = mReceiveBuffer.front () ;
+    mReceiveBuffer.pop_front () ;
+  }
+  return ok ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+bool VirtualCANNode::peekReceivedFrame (const CANMessage * & outFrame) {
+  outFrame = mReceiveBuffer.empty () ? NULL : & mReceiveBuffer.front () ;
+  return outFrame != NULL ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void VirtualCANNode::releaseReceivedFrame (void) {
+  if (!mReceiveBuffer.empty ()) {
+    mReceiveBuffer.pop_front () ;
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  VIRTUAL BUS
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+VirtualCANBus::VirtualCANBus (const uint32_t inBitRate) :
+mBitRate (inBitRate),
+mDate (0),
+mBusyTime (0),
+mFrameCount (0),
+mCurrentSender (NULL),
+mCurrentFrameEnd (0),
+mNodes (),
+mObserver (NULL),
+mObserverContext (NULL) {
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void VirtualCANBus::attach (VirtualCANNode & inNode) {
+  mNodes.push_back (&inNode) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void VirtualCANBus::setObserver (VirtualCANBusObserver inObserver, void * inContext) {
+  mObserver = inObserver ;
+  mObserverContext = inContext ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+// Length on the wire with the stuff bits this frame actually needs, including the 3 bit intermission
+
+uint32_t VirtualCANBus::frameBitLength (const CANMessage & inMessage) {
+  return ACANFrameLength::bitLength (inMessage, ACANFrameLength::ActualStuffing) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+// Bits sent during arbitration, dominant (0) wins: the lowest key wins.
+//   standard: ID[10:0] RTR IDE=0
+//   extended: ID[28:18] SRR=1 IDE=1 ID[17:0] RTR
+
+uint64_t VirtualCANBus::arbitrationKey (const CANMessage & inMessage) {
+  uint64_t key ;
+  if (inMessage.ext) {
+    key = ((uint64_t) ((inMessage.id >> 18) & 0x7FF) << 21)
+        | (1ULL << 20) | (1ULL << 19)
+        | ((uint64_t) (inMessage.id & 0x3FFFF) << 1)
+        | (inMessage.rtr ? 1 : 0) ;
+  }else{
+    key = ((uint64_t) (inMessage.id & 0x7FF) << 21) | ((inMessage.rtr ? 1ULL : 0ULL) << 20) ;
+  }
+  return key ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+uint64_t VirtualCANBus::frameDuration (const CANMessage & inMessage) const {
+  return ((uint64_t) frameBitLength (inMessage) * 1000000000ULL) / mBitRate ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void VirtualCANBus::runUntil (const uint64_t inDate) {
+  bool loop = true ;
+  while (loop) {
+  //--- Arbitration among the head frames of the node transmit buffers
+    if (mCurrentSender == NULL) {
+      uint64_t bestKey = UINT64_MAX ;
+      for (size_t i=0 ; i<mNodes.size () ; i++) {
+        VirtualCANNode * node = mNodes [i] ;
+        if (node->mConnected && !node->mTransmitBuffer.empty ()) {
+          const uint64_t key = arbitrationKey (node->mTransmitBuffer.front ()) ;
+          if (key < bestKey) {
+            bestKey = key ;
+            mCurrentSender = node ;
+          }
+        }
+      }
+      if (mCurrentSender != NULL) {
+        mCurrentFrameEnd = mDate + frameDuration (mCurrentSender->mTransmitBuffer.front ()) ;
+      }
+    }
+  //--- Complete the frame in progress, or leave the bus idle
+    if ((mCurrentSender != NULL) && (mCurrentFrameEnd <= inDate)) {
+      const CANMessage frame = mCurrentSender->mTransmitBuffer.front () ;
+      mCurrentSender->mTransmitBuffer.pop_front () ;
+      mCurrentSender->mSentFrameCount += 1 ;
+      for (size_t i=0 ; i<mNodes.size () ; i++) {
+        VirtualCANNode * node = mNodes [i] ;
+        if ((node != mCurrentSender) && node->mConnected) {
+          if (node->mReceiveBuffer.size () < node->mReceiveBufferSize) {
+            node->mReceiveBuffer.push_back (frame) ;
+            node->mReceivedFrameCount += 1 ;
+          }else{
+            node->mReceiveOverflowCount += 1 ;
+          }
+        }
+      }
+      if (mObserver != NULL) {
+        mObserver (mObserverContext, *mCurrentSender, frame, mCurrentFrameEnd) ;
+      }
+      mBusyTime += mCurrentFrameEnd - mDate ;
+      mFrameCount += 1 ;
+      mDate = mCurrentFrameEnd ;
+      mCurrentSender = NULL ;
+    }else{
+      if (mCurrentSender == NULL) {
+        mDate = inDate ;
+      }
+      loop = false ;
+    }
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+uint64_t VirtualCANBus::runUntilNextFrameEnd (const uint64_t inLimit) {
+  runUntil (mDate) ; // Arbitration among the frames queued at the current date
+  const uint64_t date = ((mCurrentSender != NULL) && (mCurrentFrameEnd < inLimit)) ? mCurrentFrameEnd : inLimit ;
+  runUntil (date) ;
+  return date ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
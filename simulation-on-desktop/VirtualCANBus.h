@@ -0,0 +1,106 @@
+/******************************************************************************/
+/* File name        : VirtualCANBus.h                                         */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Compiler         : Desktop C++ COMPILER (Visual Studio Code)               */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation                                                        */
+/* ---------------------------------------------------------------------------*/
+
+#pragma once
+
+/*------------------------------- Include files ------------------------------*/
+#include <stdint.h>
+#include <deque>
+#include <vector>
+#include "../src/CANMessage.h"
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Virtual CAN node: same transmit / receive interface as ESP32ACAN
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+// A node models one controller with its driver buffers: frames are sent in FIFO order (single TX buffer of the ESP32
+// controller), received frames are kept in a bounded receive buffer, overflowing frames are counted and lost.
+
+class VirtualCANNode {
+
+  public: VirtualCANNode (const size_t inTransmitBufferSize = 16,
+                          const size_t inReceiveBufferSize = 32) ;
+
+  public: bool tryToSend (const CANMessage & inMessage) ;
+  public: bool receive (CANMessage & outMessage) ;
+
+  //--- In place access to the receive buffer, as ESP32ACAN
+  public: bool peekReceivedFrame (const CANMessage * & outFrame) ;
+  public: void releaseReceivedFrame (void) ;
+
+  public: inline size_t transmitBufferCount (void) const { return mTransmitBuffer.size () ; }
+  public: inline size_t receiveBufferCount (void) const { return mReceiveBuffer.size () ; }
+
+  public: uint64_t mSentFrameCount = 0 ;
+  public: uint64_t mReceivedFrameCount = 0 ;
+  public: uint64_t mReceiveOverflowCount = 0 ;
+  public: bool mConnected = true ;   // false: the node neither sends nor acknowledges
+
+  private: size_t mTransmitBufferSize ;
+  private: size_t mReceiveBufferSize ;
+  private: std::deque <CANMessage> mTransmitBuffer ;
+  private: std::deque <CANMessage> mReceiveBuffer ;
+
+  friend class VirtualCANBus ;
+} ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Virtual CAN bus
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+// Time is in nanoseconds. Arbitration is bitwise (lowest identifier wins, standard before extended with the same
+// base identifier); the frame duration is its exact stuffed length on the wire (ACANFrameLength), including intermission.
+
+typedef void (*VirtualCANBusObserver) (void * inContext,
+                                       const VirtualCANNode & inSender,
+                                       const CANMessage & inFrame,
+                                       const uint64_t inEndDate) ;
+
+class VirtualCANBus {
+
+  public: VirtualCANBus (const uint32_t inBitRate) ;
+
+  public: void attach (VirtualCANNode & inNode) ;
+
+  //--- Called at the end of every frame on the bus (NULL: none)
+  public: void setObserver (VirtualCANBusObserver inObserver, void * inContext) ;
+
+  //--- Transmit every frame that completes before inDate; the bus date advances to inDate when the bus is idle
+  public: void runUntil (const uint64_t inDate) ;
+
+  //--- Runs until the end of the next frame, or inLimit if it is earlier or the bus is idle; returns the date reached
+  public: uint64_t runUntilNextFrameEnd (const uint64_t inLimit) ;
+
+  public: inline uint64_t date (void) const { return mDate ; }
+  public: inline uint32_t bitRate (void) const { return mBitRate ; }
+  public: inline uint64_t busyTime (void) const { return mBusyTime ; }
+  public: inline uint64_t frameCount (void) const { return mFrameCount ; }
+
+  public: static uint32_t frameBitLength (const CANMessage & inMessage) ;
+  public: static uint64_t arbitrationKey (const CANMessage & inMessage) ;
+
+  private: uint64_t frameDuration (const CANMessage & inMessage) const ;
+
+  private: uint32_t mBitRate ;
+  private: uint64_t mDate ;
+  private: uint64_t mBusyTime ;
+  private: uint64_t mFrameCount ;
+  private: VirtualCANNode * mCurrentSender ;   // Frame in progress, NULL if bus idle
+  private: uint64_t mCurrentFrameEnd ;
+  private: std::vector <VirtualCANNode *> mNodes ;
+  private: VirtualCANBusObserver mObserver ;
+  private: void * mObserverContext ;
+} ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
@@ -0,0 +1,353 @@
+/******************************************************************************/
+/* File name        : ACANAsync.cpp                                           */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Description      : Single threaded event loop, asynchronous receive / send */
+/*                    (callbacks, C++20 coroutine awaitables when available)  */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation                                                        */
+/* ---------------------------------------------------------------------------*/
+
+/*------------------------------- Include files ------------------------------*/
+#include "ACANAsync.h"
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   PORT
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+ACANAsyncPort::ACANAsyncPort (ACANEventLoop & inLoop,
+                              ACANAsyncReceiveRoutine inReceiveRoutine,
+                              ACANAsyncSendRoutine inSendRoutine,
+                              void * inDriver) :
+mLoop (inLoop),
+mReceiveRoutine (inReceiveRoutine),
+mSendRoutine (inSendRoutine),
+mDriver (inDriver),
+mReceiveHead (nullptr),
+mReceiveTail (nullptr),
+mSendHead (nullptr),
+mSendTail (nullptr),
+mReceiveCount (0),
+mSendCount (0),
+mNextPort (inLoop.mPorts) {
+  inLoop.mPorts = this ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+ACANAsyncPort::~ ACANAsyncPort (void) {
+  ACANAsyncPort * * p = &mLoop.mPorts ;
+  while ((*p != nullptr) && (*p != this)) {
+    p = &(*p)->mNextPort ;
+  }
+  if (*p == this) {
+    *p = mNextPort ;
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ACANAsyncPort::append (ACANAsyncOperation * & ioHead,
+                            ACANAsyncOperation * & ioTail,
+                            ACANAsyncOperation & inOperation) {
+  inOperation.mNext = nullptr ;
+  inOperation.mPending = true ;
+  if (ioTail == nullptr) {
+    ioHead = &inOperation ;
+  }else{
+    ioTail->mNext = &inOperation ;
+  }
+  ioTail = &inOperation ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+bool ACANAsyncPort::remove (ACANAsyncOperation * & ioHead,
+                            ACANAsyncOperation * & ioTail,
+                            ACANAsyncOperation & inOperation) {
+  ACANAsyncOperation * previous = nullptr ;
+  ACANAsyncOperation * p = ioHead ;
+  while ((p != nullptr) && (p != &inOperation)) {
+    previous = p ;
+    p = p->mNext ;
+  }
+  const bool found = p != nullptr ;
+  if (found) {
+    if (previous == nullptr) {
+      ioHead = p->mNext ;
+    }else{
+      previous->mNext = p->mNext ;
+    }
+    if (ioTail == p) {
+      ioTail = previous ;
+    }
+    p->mNext = nullptr ;
+    p->mPending = false ;
+  }
+  return found ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ACANAsyncPort::receive (ACANAsyncOperation & ioOperation) {
+  append (mReceiveHead, mReceiveTail, ioOperation) ;
+  mReceiveCount += 1 ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ACANAsyncPort::send (ACANAsyncOperation & ioOperation) {
+  append (mSendHead, mSendTail, ioOperation) ;
+  mSendCount += 1 ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ACANAsyncPort::cancel (ACANAsyncOperation & ioOperation) {
+  if (remove (mReceiveHead, mReceiveTail, ioOperation)) {
+    mReceiveCount -= 1 ;
+  }else if (remove (mSendHead, mSendTail, ioOperation)) {
+    mSendCount -= 1 ;
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+bool ACANAsyncPort::receiveNow (CANMessage & outFrame) {
+  return (mReceiveHead == nullptr) && mReceiveRoutine (mDriver, outFrame) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+bool ACANAsyncPort::sendNow (const CANMessage & inFrame) {
+  return (mSendHead == nullptr) && mSendRoutine (mDriver, inFrame) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+// The operation leaves its queue before its completion routine is called: the routine may queue new operations, or
+// (coroutine) destroy the operation.
+
+bool ACANAsyncPort::pump (void) {
+  bool progress = false ;
+  while ((mReceiveHead != nullptr) && mReceiveRoutine (mDriver, mReceiveHead->mFrame)) {
+    ACANAsyncOperation & operation = *mReceiveHead ;
+    remove (mReceiveHead, mReceiveTail, operation) ;
+    mReceiveCount -= 1 ;
+    mLoop.complete (operation) ;
+    progress = true ;
+  }
+  while ((mSendHead != nullptr) && mSendRoutine (mDriver, mSendHead->mFrame)) {
+    ACANAsyncOperation & operation = *mSendHead ;
+    remove (mSendHead, mSendTail, operation) ;
+    mSendCount -= 1 ;
+    mLoop.complete (operation) ;
+    progress = true ;
+  }
+  return progress ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+#ifdef ACAN_ASYNC_COROUTINES
+  void ACANAsyncPort::resumeCoroutine (void * inHandle, ACANAsyncOperation & /* inOperation */) {
+    std::coroutine_handle <>::from_address (inHandle).resume () ;
+  }
+#endif
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   EVENT LOOP
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+ACANEventLoop::ACANEventLoop (void) :
+mPorts (nullptr),
+mTimers (nullptr),
+mTimerCapacity (0),
+mTimerCount (0),
+mTimerSequence (0),
+mNow (0),
+mAdvanceRoutine (nullptr),
+mAdvanceContext (nullptr),
+mCompletedOperationCount (0),
+mTimerOverflowCount (0) {
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+ACANEventLoop::~ ACANEventLoop (void) {
+  delete [] mTimers ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+bool ACANEventLoop::begin (const uint32_t inTimerCapacity) {
+  delete [] mTimers ;
+  mTimers = (inTimerCapacity > 0) ? new ACANAsyncOperation * [inTimerCapacity] : nullptr ;
+  const bool ok = (inTimerCapacity == 0) || (mTimers != nullptr) ;
+  mTimerCapacity = ok ? inTimerCapacity : 0 ;
+  mTimerCount = 0 ;
+  return ok ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ACANEventLoop::setAdvanceRoutine (ACANAsyncAdvanceRoutine inRoutine, void * inContext) {
+  mAdvanceRoutine = inRoutine ;
+  mAdvanceContext = inContext ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ACANEventLoop::complete (ACANAsyncOperation & ioOperation) {
+  mCompletedOperationCount += 1 ;
+  if (ioOperation.mCompletion != nullptr) {
+    ioOperation.mCompletion (ioOperation.mContext, ioOperation) ;
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+// Until nothing more completes: a completion may make another operation ready (a frame sent frees the driver, ...)
+
+bool ACANEventLoop::runReady (void) {
+  bool progress = false ;
+  bool loop = true ;
+  while (loop) {
+    loop = false ;
+    while ((mTimerCount > 0) && (mTimers [0]->mDate <= mNow)) {
+      ACANAsyncOperation & timer = *mTimers [0] ;
+      removeTimerAt (0) ;
+      complete (timer) ;
+      loop = true ;
+    }
+    for (ACANAsyncPort * port = mPorts ; port != nullptr ; port = port->mNextPort) {
+      if (port->pump ()) {
+        loop = true ;
+      }
+    }
+    progress |= loop ;
+  }
+  return progress ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ACANEventLoop::poll (const uint64_t inNow) {
+  if (mNow < inNow) {
+    mNow = inNow ;
+  }
+  runReady () ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ACANEventLoop::runUntil (const uint64_t inDate) {
+  runReady () ;
+  while (mNow < inDate) {
+    uint64_t limit = inDate ;
+    if ((mTimerCount > 0) && (mTimers [0]->mDate < limit)) {
+      limit = mTimers [0]->mDate ;
+    }
+    uint64_t reached = (mAdvanceRoutine != nullptr) ? mAdvanceRoutine (mAdvanceContext, limit) : limit ;
+    if (reached > limit) {
+      reached = limit ;
+    }
+    if (mNow < reached) {
+      mNow = reached ;
+    }
+    runReady () ;
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   TIMER HEAP (ordered by date, then by start order)
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+bool ACANEventLoop::timerBefore (const uint32_t inA, const uint32_t inB) const {
+  const ACANAsyncOperation * a = mTimers [inA] ;
+  const ACANAsyncOperation * b = mTimers [inB] ;
+  return (a->mDate < b->mDate) || ((a->mDate == b->mDate) && ((int32_t) (a->mSequence - b->mSequence) < 0)) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ACANEventLoop::siftUp (uint32_t inIndex) {
+  while ((inIndex > 0) && timerBefore (inIndex, (inIndex - 1) / 2)) {
+    const uint32_t parent = (inIndex - 1) / 2 ;
+    ACANAsyncOperation * t = mTimers [inIndex] ;
+    mTimers [inIndex] = mTimers [parent] ;
+    mTimers [parent] = t ;
+    inIndex = parent ;
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ACANEventLoop::siftDown (uint32_t inIndex) {
+  bool loop = true ;
+  while (loop) {
+    const uint32_t left = 2 * inIndex + 1 ;
+    uint32_t smallest = inIndex ;
+    if ((left < mTimerCount) && timerBefore (left, smallest)) {
+      smallest = left ;
+    }
+    if (((left + 1) < mTimerCount) && timerBefore (left + 1, smallest)) {
+      smallest = left + 1 ;
+    }
+    loop = smallest != inIndex ;
+    if (loop) {
+      ACANAsyncOperation * t = mTimers [inIndex] ;
+      mTimers [inIndex] = mTimers [smallest] ;
+      mTimers [smallest] = t ;
+      inIndex = smallest ;
+    }
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ACANEventLoop::removeTimerAt (const uint32_t inIndex) {
+  mTimers [inIndex]->mPending = false ;
+  mTimerCount -= 1 ;
+  if (inIndex < mTimerCount) {
+    mTimers [inIndex] = mTimers [mTimerCount] ;
+    siftDown (inIndex) ;
+    siftUp (inIndex) ;
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+bool ACANEventLoop::startTimer (ACANAsyncOperation & ioOperation, const uint64_t inDate) {
+  const bool ok = mTimerCount < mTimerCapacity ;
+  if (ok) {
+    ioOperation.mDate = inDate ;
+    ioOperation.mSequence = mTimerSequence ;
+    ioOperation.mPending = true ;
+    mTimerSequence += 1 ;
+    mTimers [mTimerCount] = &ioOperation ;
+    mTimerCount += 1 ;
+    siftUp (mTimerCount - 1) ;
+  }else{
+    mTimerOverflowCount += 1 ;
+  }
+  return ok ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ACANEventLoop::cancelTimer (ACANAsyncOperation & ioOperation) {
+  for (uint32_t i=0 ; i<mTimerCount ; i++) {
+    if (mTimers [i] == &ioOperation) {
+      removeTimerAt (i) ;
+      break ;
+    }
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
@@ -0,0 +1,323 @@
+/******************************************************************************/
+/* File name        : ACANAsync.h                                             */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Description      : Single threaded event loop, asynchronous receive / send */
+/*                    (callbacks, C++20 coroutine awaitables when available)  */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation                                                        */
+/* ---------------------------------------------------------------------------*/
+
+#ifndef ACAN_ASYNC_CLASS_DEFINED
+#define ACAN_ASYNC_CLASS_DEFINED
+
+/*------------------------------- Include files ------------------------------*/
+#include "CANMessage.h"
+
+//--- Coroutine awaitables need C++20; otherwise (ESP32 toolchains) only the callback API is available
+#if defined (__cpp_impl_coroutine) && defined (__has_include)
+  #if __has_include (<coroutine>)
+    #define ACAN_ASYNC_COROUTINES
+    #include <coroutine>
+    #include <exception>
+  #endif
+#endif
+
+class ACANEventLoop ;
+class ACANAsyncOperation ;
+
+//----------------------------------------------------------------------------------------------------------------------
+//   Asynchronous operation: receive, send or timer (storage provided by the caller, it must stay valid until the
+//   completion routine is called or the operation is cancelled)
+//----------------------------------------------------------------------------------------------------------------------
+
+typedef void (*ACANAsyncCompletion) (void * inContext, ACANAsyncOperation & inOperation) ;
+
+class ACANAsyncOperation {
+  public: CANMessage mFrame ;                           // Frame to send, or received frame
+  public: ACANAsyncCompletion mCompletion = nullptr ;
+  public: void * mContext = nullptr ;
+  public: uint64_t mDate = 0 ;                          // Timer expiry date
+  public: ACANAsyncOperation * mNext = nullptr ;        // Port queue link
+  public: uint32_t mSequence = 0 ;                      // Timers expiring at the same date complete in start order
+  public: bool mPending = false ;                       // Queued in a port or a timer
+} ;
+
+//----------------------------------------------------------------------------------------------------------------------
+//   Driver port: FIFO queues of receive and send operations on one driver (ESP32ACAN, VirtualCANNode, ...)
+//----------------------------------------------------------------------------------------------------------------------
+// The event loop pumps every port: queued receives get the frames of the driver receive buffer in order (frames stay
+// in the driver while no receive is queued), queued sends go to tryToSend in order as long as the driver accepts them.
+
+typedef bool (*ACANAsyncReceiveRoutine) (void * inDriver, CANMessage & outFrame) ;
+typedef bool (*ACANAsyncSendRoutine) (void * inDriver, const CANMessage & inFrame) ;
+
+class ACANAsyncPort {
+
+//······················································································································
+//   CONSTRUCTORS: the port attaches itself to the event loop
+//······················································································································
+
+  public: ACANAsyncPort (ACANEventLoop & inLoop,
+                         ACANAsyncReceiveRoutine inReceiveRoutine,
+                         ACANAsyncSendRoutine inSendRoutine,
+                         void * inDriver) ;
+
+  public: template <typename DRIVER> ACANAsyncPort (ACANEventLoop & inLoop, DRIVER & inDriver) :
+  ACANAsyncPort (inLoop, receiveThroughDriver <DRIVER>, sendThroughDriver <DRIVER>, &inDriver) {
+  }
+
+  public: ~ ACANAsyncPort (void) ;
+
+//······················································································································
+//   Callback API: the completion routine is called by the event loop (never from receive or send)
+//······················································································································
+
+  public: void receive (ACANAsyncOperation & ioOperation) ;
+  public: void send (ACANAsyncOperation & ioOperation) ;
+  public: void cancel (ACANAsyncOperation & ioOperation) ;
+
+//······················································································································
+//   Immediate attempts, only if no operation of the same kind is queued (keeps the FIFO order)
+//······················································································································
+
+  public: bool receiveNow (CANMessage & outFrame) ;
+  public: bool sendNow (const CANMessage & inFrame) ;
+
+//······················································································································
+//   Coroutine API: CANMessage frame = co_await port.receiveAsync () ; co_await port.sendAsync (frame) ;
+//   An operation that can complete at once does not suspend.
+//······················································································································
+
+#ifdef ACAN_ASYNC_COROUTINES
+  public: class ReceiveAwaiter : public ACANAsyncOperation {
+    public: ReceiveAwaiter (ACANAsyncPort & inPort) : mPort (inPort) {}
+    public: ~ ReceiveAwaiter (void) { if (mPending) { mPort.cancel (*this) ; } }
+    public: bool await_ready (void) { return mPort.receiveNow (mFrame) ; }
+    public: void await_suspend (std::coroutine_handle <> inHandle) {
+      mCompletion = resumeCoroutine ;
+      mContext = inHandle.address () ;
+      mPort.receive (*this) ;
+    }
+    public: CANMessage await_resume (void) { return mFrame ; }
+    private: ACANAsyncPort & mPort ;
+  } ;
+
+  public: class SendAwaiter : public ACANAsyncOperation {
+    public: SendAwaiter (ACANAsyncPort & inPort, const CANMessage & inFrame) : mPort (inPort) { mFrame = inFrame ; }
+    public: ~ SendAwaiter (void) { if (mPending) { mPort.cancel (*this) ; } }
+    public: bool await_ready (void) { return mPort.sendNow (mFrame) ; }
+    public: void await_suspend (std::coroutine_handle <> inHandle) {
+      mCompletion = resumeCoroutine ;
+      mContext = inHandle.address () ;
+      mPort.send (*this) ;
+    }
+    public: void await_resume (void) {}
+    private: ACANAsyncPort & mPort ;
+  } ;
+
+  public: inline ReceiveAwaiter receiveAsync (void) { return ReceiveAwaiter (*this) ; }
+  public: inline SendAwaiter sendAsync (const CANMessage & inFrame) { return SendAwaiter (*this, inFrame) ; }
+
+  public: static void resumeCoroutine (void * inHandle, ACANAsyncOperation & inOperation) ;
+#endif
+
+//······················································································································
+//   Event loop side: completes what the driver allows, returns true if an operation completed
+//······················································································································
+
+  public: bool pump (void) ;
+
+  public: inline uint32_t queuedReceiveCount (void) const { return mReceiveCount ; }
+  public: inline uint32_t queuedSendCount (void) const { return mSendCount ; }
+
+//······················································································································
+//   Private
+//······················································································································
+
+  private: template <typename DRIVER> static bool receiveThroughDriver (void * inDriver, CANMessage & outFrame) {
+    return ((DRIVER *) inDriver)->receive (outFrame) ;
+  }
+
+  private: template <typename DRIVER> static bool sendThroughDriver (void * inDriver, const CANMessage & inFrame) {
+    return ((DRIVER *) inDriver)->tryToSend (inFrame) ;
+  }
+
+  private: static void append (ACANAsyncOperation * & ioHead, ACANAsyncOperation * & ioTail, ACANAsyncOperation & inOperation) ;
+  private: static bool remove (ACANAsyncOperation * & ioHead, ACANAsyncOperation * & ioTail, ACANAsyncOperation & inOperation) ;
+
+  private: ACANEventLoop & mLoop ;
+  private: ACANAsyncReceiveRoutine mReceiveRoutine ;
+  private: ACANAsyncSendRoutine mSendRoutine ;
+  private: void * mDriver ;
+  private: ACANAsyncOperation * mReceiveHead ;
+  private: ACANAsyncOperation * mReceiveTail ;
+  private: ACANAsyncOperation * mSendHead ;
+  private: ACANAsyncOperation * mSendTail ;
+  private: uint32_t mReceiveCount ;
+  private: uint32_t mSendCount ;
+  private: ACANAsyncPort * mNextPort ;
+
+  friend class ACANEventLoop ;
+
+//······················································································································
+//   No copy
+//······················································································································
+
+  private: ACANAsyncPort (const ACANAsyncPort &) = delete ;
+  private: ACANAsyncPort & operator = (const ACANAsyncPort &) = delete ;
+} ;
+
+//----------------------------------------------------------------------------------------------------------------------
+//   Event loop
+//----------------------------------------------------------------------------------------------------------------------
+// One thread runs every port and timer: no lock, no per node thread. Timers are in a binary heap of capacity given to
+// begin. Dates are in the unit of the caller (µs with micros () on the ESP32, ns with the virtual bus).
+// On the ESP32:
+//   loop.poll (micros ()) ;
+// With simulated time, the advance routine moves the simulation forward, up to a limit, and returns the date it
+// reached; returning early (at the end of the next frame on a virtual bus) lets waiting operations complete on time:
+//   loop.setAdvanceRoutine (advanceBus, &bus) ;   // bus.runUntilNextFrameEnd (inLimit)
+//   loop.runUntil (date) ;
+
+typedef uint64_t (*ACANAsyncAdvanceRoutine) (void * inContext, const uint64_t inLimit) ;
+
+class ACANEventLoop {
+
+//······················································································································
+//   CONSTRUCTOR
+//······················································································································
+
+  public: ACANEventLoop (void) ;
+
+  public: ~ ACANEventLoop (void) ;
+
+//······················································································································
+//   Initialisation: returns false if the timer heap cannot be allocated
+//······················································································································
+
+  public: bool begin (const uint32_t inTimerCapacity) ;
+
+//······················································································································
+//   Time
+//······················································································································
+
+  public: inline uint64_t now (void) const { return mNow ; }
+
+  public: void setAdvanceRoutine (ACANAsyncAdvanceRoutine inRoutine, void * inContext) ;
+
+  //--- Real time: completes everything ready at inNow
+  public: void poll (const uint64_t inNow) ;
+
+  //--- Simulated time: completes everything ready up to inDate, through the advance routine
+  public: void runUntil (const uint64_t inDate) ;
+
+//······················································································································
+//   Timers (callback API): returns false if the heap is full
+//······················································································································
+
+  public: bool startTimer (ACANAsyncOperation & ioOperation, const uint64_t inDate) ;
+  public: void cancelTimer (ACANAsyncOperation & ioOperation) ;
+
+//······················································································································
+//   Timers (coroutine API): co_await loop.sleepFor (delay) ; co_await loop.sleepUntil (date) ;
+//   If the heap is full, the coroutine does not suspend (see timerOverflowCount)
+//······················································································································
+
+#ifdef ACAN_ASYNC_COROUTINES
+  public: class SleepAwaiter : public ACANAsyncOperation {
+    public: SleepAwaiter (ACANEventLoop & inLoop, const uint64_t inDate) : mLoop (inLoop) { mDate = inDate ; }
+    public: ~ SleepAwaiter (void) { if (mPending) { mLoop.cancelTimer (*this) ; } }
+    public: bool await_ready (void) { return mDate <= mLoop.mNow ; }
+    public: bool await_suspend (std::coroutine_handle <> inHandle) {
+      mCompletion = ACANAsyncPort::resumeCoroutine ;
+      mContext = inHandle.address () ;
+      return mLoop.startTimer (*this, mDate) ;
+    }
+    public: void await_resume (void) {}
+    private: ACANEventLoop & mLoop ;
+  } ;
+
+  public: inline SleepAwaiter sleepUntil (const uint64_t inDate) { return SleepAwaiter (*this, inDate) ; }
+  public: inline SleepAwaiter sleepFor (const uint64_t inDelay) { return SleepAwaiter (*this, mNow + inDelay) ; }
+#endif
+
+//······················································································································
+//   Statistics
+//······················································································································
+
+  public: inline uint64_t completedOperationCount (void) const { return mCompletedOperationCount ; }
+  public: inline uint32_t timerOverflowCount (void) const { return mTimerOverflowCount ; }
+  public: inline uint32_t timerCount (void) const { return mTimerCount ; }
+
+//······················································································································
+//   Private
+//······················································································································
+
+  private: bool runReady (void) ;
+  private: void complete (ACANAsyncOperation & ioOperation) ;
+  private: bool timerBefore (const uint32_t inA, const uint32_t inB) const ;
+  private: void siftUp (uint32_t inIndex) ;
+  private: void siftDown (uint32_t inIndex) ;
+  private: void removeTimerAt (const uint32_t inIndex) ;
+
+  private: ACANAsyncPort * mPorts ;
+  private: ACANAsyncOperation * * mTimers ;
+  private: uint32_t mTimerCapacity ;
+  private: uint32_t mTimerCount ;
+  private: uint32_t mTimerSequence ;
+  private: uint64_t mNow ;
+  private: ACANAsyncAdvanceRoutine mAdvanceRoutine ;
+  private: void * mAdvanceContext ;
+  private: uint64_t mCompletedOperationCount ;
+  private: uint32_t mTimerOverflowCount ;
+
+  friend class ACANAsyncPort ;
+
+//······················································································································
+//   No copy
+//······················································································································
+
+  private: ACANEventLoop (const ACANEventLoop &) = delete ;
+  private: ACANEventLoop & operator = (const ACANEventLoop &) = delete ;
+} ;
+
+//----------------------------------------------------------------------------------------------------------------------
+//   Coroutine task: starts at once, runs until its first suspension; the frame is destroyed with the task object
+//   (a suspended task is cancelled: its pending operation leaves its port or the timer heap).
+//----------------------------------------------------------------------------------------------------------------------
+
+#ifdef ACAN_ASYNC_COROUTINES
+class ACANTask {
+  public: class promise_type {
+    public: ACANTask get_return_object (void) {
+      return ACANTask (std::coroutine_handle <promise_type>::from_promise (*this)) ;
+    }
+    public: std::suspend_never initial_suspend (void) noexcept { return {} ; }
+    public: std::suspend_always final_suspend (void) noexcept { return {} ; }
+    public: void return_void (void) {}
+    public: void unhandled_exception (void) { std::terminate () ; }
+  } ;
+
+  public: ACANTask (ACANTask && ioTask) noexcept : mHandle (ioTask.mHandle) { ioTask.mHandle = nullptr ; }
+  public: ~ ACANTask (void) { if (mHandle) { mHandle.destroy () ; } }
+  public: inline bool done (void) const { return !mHandle || mHandle.done () ; }
+
+  private: explicit ACANTask (std::coroutine_handle <promise_type> inHandle) : mHandle (inHandle) {}
+  private: std::coroutine_handle <promise_type> mHandle ;
+
+  private: ACANTask (const ACANTask &) = delete ;
+  private: ACANTask & operator = (const ACANTask &) = delete ;
+} ;
+#endif
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#endif
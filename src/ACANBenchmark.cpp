@@ -0,0 +1,159 @@
+/******************************************************************************/
+/* File name        : ACANBenchmark.cpp                                       */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Description      : Loopback benchmark scenarios and results, shared by     */
+/*                    examples/LoopBackBenchmark and benchmark-on-desktop     */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation                                                        */
+/* ---------------------------------------------------------------------------*/
+
+/*------------------------------- Include files ------------------------------*/
+#include "ACANBenchmark.h"
+#include <stdio.h>
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   SWEEP
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static const uint32_t kBitRates [] = {125 * 1000, 250 * 1000, 500 * 1000, 1000 * 1000} ;
+static const uint8_t kLengths [] = {0, 4, 8} ;
+
+static const uint16_t kBitRateCount = sizeof (kBitRates) / sizeof (kBitRates [0]) ;
+static const uint16_t kLengthCount = sizeof (kLengths) / sizeof (kLengths [0]) ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+uint16_t ACANBenchmarkScenario::count (void) {
+  return kBitRateCount * 2 * kLengthCount * 2 ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+ACANBenchmarkScenario ACANBenchmarkScenario::atIndex (const uint16_t inIndex) {
+  ACANBenchmarkScenario scenario ;
+  uint16_t index = inIndex ;
+  scenario.mMode = ((index % 2) == 0) ? Polling : Interrupt ;
+  index /= 2 ;
+  scenario.mLength = kLengths [index % kLengthCount] ;
+  index /= kLengthCount ;
+  scenario.mExtended = (index % 2) != 0 ;
+  index /= 2 ;
+  scenario.mBitRate = kBitRates [index % kBitRateCount] ;
+  return scenario ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   FRAME
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+CANMessage ACANBenchmarkScenario::frame (void) const {
+  CANMessage frame ;
+  frame.ext = mExtended ;
+  frame.id = mExtended ? 0x12345678 : 0x123 ;
+  frame.len = mLength ;
+  for (uint8_t i=0 ; i<mLength ; i++) {
+    frame.data [i] = uint8_t (0x11 * (i + 1)) ;
+  }
+  return frame ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+uint32_t ACANBenchmarkScenario::theoreticalFramesPerSecond (const uint32_t inActualBitRate) const {
+  return inActualBitRate / ACANFrameLength::bitLength (frame (), ACANFrameLength::ActualStuffing) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   RESULT
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+uint32_t ACANBenchmarkResult::framesPerSecond (void) const {
+  return (mDurationMicroseconds == 0)
+    ? 0
+    : uint32_t ((uint64_t (mReceivedCount) * 1000000) / mDurationMicroseconds) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ACANBenchmarkResult::setLatencies (uint32_t ioSamples [], const uint32_t inCount) {
+  //--- Shell sort (Ciura gaps): no heap, a few thousand samples
+  static const uint32_t kGaps [] = {701, 301, 132, 57, 23, 10, 4, 1} ;
+  for (uint32_t g=0 ; g<(sizeof (kGaps) / sizeof (kGaps [0])) ; g++) {
+    const uint32_t gap = kGaps [g] ;
+    for (uint32_t i=gap ; i<inCount ; i++) {
+      const uint32_t value = ioSamples [i] ;
+      uint32_t j = i ;
+      while ((j >= gap) && (ioSamples [j - gap] > value)) {
+        ioSamples [j] = ioSamples [j - gap] ;
+        j -= gap ;
+      }
+      ioSamples [j] = value ;
+    }
+  }
+  //--- Percentile: sample of rank ceil (count * p / 1000)
+  const uint32_t perThousand [3] = {500, 990, 999} ;
+  uint32_t * percentiles [3] = {&mLatencyP50, &mLatencyP99, &mLatencyP999} ;
+  for (uint32_t p=0 ; p<3 ; p++) {
+    const uint32_t rank = uint32_t ((uint64_t (inCount) * perThousand [p] + 999) / 1000) ;
+    *(percentiles [p]) = (inCount == 0) ? 0 : ioSamples [(rank > 0) ? (rank - 1) : 0] ;
+  }
+  mLatencySampleCount = inCount ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   REPORT
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+size_t ACANBenchmarkReport::header (char * outBuffer, const size_t inBufferSize) {
+  const int length = snprintf (outBuffer, inBufferSize,
+    "target,bit_rate,format,dlc,mode,duration_us,sent,received,lost,frames_per_s,max_frames_per_s,"
+    "percent_of_max,latency_p50_ns,latency_p99_ns,latency_p999_ns,cpu_load_percent") ;
+  return (length < 0) ? 0 : size_t (length) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+size_t ACANBenchmarkReport::line (char * outBuffer,
+                                  const size_t inBufferSize,
+                                  const char * inTarget,
+                                  const ACANBenchmarkScenario & inScenario,
+                                  const ACANBenchmarkResult & inResult) {
+  const uint32_t maximum = inScenario.theoreticalFramesPerSecond (inResult.mActualBitRate) ;
+  const uint32_t permilleOfMaximum = (maximum == 0)
+    ? 0
+    : uint32_t ((uint64_t (inResult.framesPerSecond ()) * 1000 + maximum / 2) / maximum) ;
+  char cpuLoad [8] = "" ; // Empty field if not measured
+  if (inResult.mCPULoadPermille != ACANBenchmarkResult::kNotMeasured) {
+    snprintf (cpuLoad, sizeof (cpuLoad), "%u.%u",
+              unsigned (inResult.mCPULoadPermille / 10), unsigned (inResult.mCPULoadPermille % 10)) ;
+  }
+  const int length = snprintf (outBuffer, inBufferSize,
+    "%s,%lu,%s,%u,%s,%lu,%lu,%lu,%lu,%lu,%lu,%lu.%lu,%lu,%lu,%lu,%s",
+    inTarget,
+    (unsigned long) inResult.mActualBitRate,
+    inScenario.mExtended ? "extended" : "standard",
+    unsigned (inScenario.mLength),
+    (inScenario.mMode == ACANBenchmarkScenario::Polling) ? "polling" : "interrupt",
+    (unsigned long) inResult.mDurationMicroseconds,
+    (unsigned long) inResult.mSentCount,
+    (unsigned long) inResult.mReceivedCount,
+    (unsigned long) inResult.lostCount (),
+    (unsigned long) inResult.framesPerSecond (),
+    (unsigned long) maximum,
+    (unsigned long) (permilleOfMaximum / 10), (unsigned long) (permilleOfMaximum % 10),
+    (unsigned long) inResult.mLatencyP50,
+    (unsigned long) inResult.mLatencyP99,
+    (unsigned long) inResult.mLatencyP999,
+    cpuLoad) ;
+  return (length < 0) ? 0 : size_t (length) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
@@ -0,0 +1,101 @@
+/******************************************************************************/
+/* File name        : ACANBenchmark.h                                         */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Description      : Loopback benchmark scenarios and results, shared by     */
+/*                    examples/LoopBackBenchmark and benchmark-on-desktop     */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation                                                        */
+/* ---------------------------------------------------------------------------*/
+
+#ifndef ACAN_BENCHMARK_CLASS_DEFINED
+#define ACAN_BENCHMARK_CLASS_DEFINED
+
+/*------------------------------- Include files ------------------------------*/
+#include "CANMessage.h"
+#include "ACANBusLoad.h"
+#include <stddef.h>
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   Scenario: bit rate x frame format x data length x polling / interrupt. The sweep is 4 bit rates (125 kbit/s ...
+//   1 Mbit/s), standard and extended, 0, 4 and 8 data bytes, both modes: 48 scenarios, in a fixed order.
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+class ACANBenchmarkScenario {
+
+  public: typedef enum : uint8_t {
+    Polling,
+    Interrupt
+  } Mode ;
+
+  public: uint32_t mBitRate ;
+  public: bool mExtended ;
+  public: uint8_t mLength ;
+  public: Mode mMode ;
+
+  //--- Sweep
+  public: static uint16_t count (void) ;
+  public: static ACANBenchmarkScenario atIndex (const uint16_t inIndex) ;
+
+  //--- Frame sent by every scenario (fixed content, so its stuffed length is known)
+  public: CANMessage frame (void) const ;
+
+  //--- Frames per second on a saturated bus at inActualBitRate, from the exact stuffed frame length
+  public: uint32_t theoreticalFramesPerSecond (const uint32_t inActualBitRate) const ;
+} ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   Result of a scenario:
+//   - throughput phase: the bus is kept saturated during mDuration; sent, received and lost frames;
+//   - latency phase: one frame at a time on an idle bus; latency is from the end of the frame on the wire (send date
+//     + frame duration) to its return by receive in the application, in ns;
+//   - CPU load: permille of the CPU time not left to idle tasks during the throughput phase (kNotMeasured if none).
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+class ACANBenchmarkResult {
+
+  public: static const uint16_t kNotMeasured = 0xFFFF ;
+
+  public: uint32_t mActualBitRate = 0 ;
+  public: uint32_t mDurationMicroseconds = 0 ;
+  public: uint32_t mSentCount = 0 ;
+  public: uint32_t mReceivedCount = 0 ;
+  public: uint32_t mLatencySampleCount = 0 ;
+  public: uint32_t mLatencyP50 = 0 ;
+  public: uint32_t mLatencyP99 = 0 ;
+  public: uint32_t mLatencyP999 = 0 ;
+  public: uint16_t mCPULoadPermille = kNotMeasured ;
+
+  public: uint32_t framesPerSecond (void) const ;
+  public: inline uint32_t lostCount (void) const { return mSentCount - mReceivedCount ; }
+
+  //--- Latency percentiles from the samples (sorted in place)
+  public: void setLatencies (uint32_t ioSamples [], const uint32_t inCount) ;
+} ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   Machine readable output: one CSV line per scenario, after a header line. Returns the string length (truncated
+//   to inBufferSize - 1 characters, like snprintf).
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+class ACANBenchmarkReport {
+
+  public: static size_t header (char * outBuffer, const size_t inBufferSize) ;
+
+  public: static size_t line (char * outBuffer,
+                              const size_t inBufferSize,
+                              const char * inTarget, // "esp32", "host"
+                              const ACANBenchmarkScenario & inScenario,
+                              const ACANBenchmarkResult & inResult) ;
+} ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+#endif
@@ -0,0 +1,104 @@
+/******************************************************************************/
+/* File name        : ACANBitRateDetector.cpp                                 */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Description      : Bit rate detection by listen only scanning              */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation                                                        */
+/* ---------------------------------------------------------------------------*/
+
+/*------------------------------- Include files ------------------------------*/
+#include "ACANBitRateDetector.h"
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   STANDARD BIT RATES
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+const uint32_t ACANBitRateDetector::kStandardBitRates [kStandardBitRateCount] = {
+  1000 * 1000, 800 * 1000, 500 * 1000, 250 * 1000, 125 * 1000, 100 * 1000,
+  83333, 50 * 1000, 33333, 25 * 1000, 20 * 1000, 10 * 1000
+} ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   DWELL: the first round listens 4 frames of 160 bits (the longest stuffed frame) at each candidate
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static const uint32_t kFrameBitCount = 160 ;
+static const uint32_t kFirstRoundFrameCount = 4 ;
+static const uint32_t kMaxDwellFrameCount = 1 << 16 ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static uint32_t dwellMillis (const uint32_t inBitRate, const uint32_t inFrameCount) {
+  const uint64_t bits = uint64_t (inFrameCount) * kFrameBitCount ;
+  return uint32_t ((bits * 1000 + inBitRate - 1) / inBitRate) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   DETECT
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+uint32_t ACANBitRateDetector::detect (const uint32_t inCandidates [],
+                                      const uint8_t inCandidateCount,
+                                      const uint32_t inTimeoutMS) {
+  mListenCount = 0 ;
+  mBusErrorCount = 0 ;
+  const uint8_t candidateCount = (inCandidateCount < kMaxCandidateCount) ? inCandidateCount : kMaxCandidateCount ;
+  bool rejected [kMaxCandidateCount] ;   // Not reachable by the controller: never tried again
+  bool eliminated [kMaxCandidateCount] ; // Bus error: not tried again until every candidate is eliminated
+  for (uint8_t i=0 ; i<candidateCount ; i++) {
+    rejected [i] = (inCandidates [i] == 0) ;
+    eliminated [i] = false ;
+  }
+  const uint32_t start = mMillis (mController) ;
+  uint32_t dwellFrameCount = kFirstRoundFrameCount ;
+  uint32_t detectedBitRate = 0 ;
+  bool candidateLeft = true ;
+  while ((detectedBitRate == 0) && candidateLeft && ((mMillis (mController) - start) < inTimeoutMS)) {
+    bool listened = false ;
+    for (uint8_t i=0 ; (i<candidateCount) && (detectedBitRate == 0) ; i++) {
+      if (!rejected [i] && !eliminated [i] && ((mMillis (mController) - start) < inTimeoutMS)) {
+        if (!mListen (mController, inCandidates [i])) {
+          rejected [i] = true ;
+        }else{
+          listened = true ;
+          mListenCount += 1 ;
+          const uint32_t dwell = dwellMillis (inCandidates [i], dwellFrameCount) ;
+          const uint32_t listenStart = mMillis (mController) ;
+          Event event = NoEvent ;
+          while ((event == NoEvent)
+              && ((mMillis (mController) - listenStart) <= dwell) // <=: at least dwell ms with a ms clock
+              && ((mMillis (mController) - start) < inTimeoutMS)) {
+            event = mEvent (mController) ;
+          }
+          if (event == ValidFrame) {
+            detectedBitRate = inCandidates [i] ;
+          }else if (event == BusError) {
+            eliminated [i] = true ;
+            mBusErrorCount += 1 ;
+          }
+        }
+      }
+    }
+  //--- Every reachable candidate eliminated (noise, or a bit rate not in the list): all of them again
+    if (!listened) {
+      candidateLeft = false ;
+      for (uint8_t i=0 ; i<candidateCount ; i++) {
+        eliminated [i] = false ;
+        candidateLeft |= !rejected [i] ;
+      }
+    }else if (dwellFrameCount < kMaxDwellFrameCount) {
+      dwellFrameCount *= 2 ;
+    }
+  }
+  return detectedBitRate ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
@@ -0,0 +1,114 @@
+/******************************************************************************/
+/* File name        : ACANBitRateDetector.h                                   */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Description      : Bit rate detection by listen only scanning              */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation                                                        */
+/* ---------------------------------------------------------------------------*/
+
+#ifndef ACAN_BIT_RATE_DETECTOR_CLASS_DEFINED
+#define ACAN_BIT_RATE_DETECTOR_CLASS_DEFINED
+
+/*------------------------------- Include files ------------------------------*/
+#include <stdint.h>
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   Bit rate detection. The controller listens (no acknowledge, no error frame: the bus is not disturbed) at each
+//   candidate bit rate in turn. A valid frame (the controller checked its CRC) selects the candidate; a bus error
+//   (stuff, form or CRC error: wrong bit rate) eliminates it at once. Without traffic, the candidate is left after its
+//   dwell time: the first round dwells 4 frames of 160 bits per candidate, every round doubles it, so a busy bus is
+//   detected in a few ms and a sparse one (a frame every 100 ms) in a few rounds. If every candidate is eliminated
+//   (noise), they are all tried again.
+//   The controller is reached through an adaptor; the CONTROLLER class provides:
+//     bool listenAtBitRate (const uint32_t inBitRate) ;  // Timing only, listen only mode; false if not reachable
+//     ACANBitRateDetector::Event bitRateEvent (void) ;    // Event since listenAtBitRate (frame, error, none)
+//     uint32_t bitRateDetectionMillis (void) ;            // Date in ms
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+class ACANBitRateDetector {
+
+  public: typedef enum : uint8_t {
+    NoEvent,
+    ValidFrame,
+    BusError
+  } Event ;
+
+//······················································································································
+//   Standard bit rates, highest first
+//······················································································································
+
+  public: static const uint8_t kStandardBitRateCount = 12 ;
+  public: static const uint32_t kStandardBitRates [kStandardBitRateCount] ;
+
+  public: static const uint8_t kMaxCandidateCount = 32 ;
+
+//······················································································································
+//   Constructor
+//······················································································································
+
+  public: template <typename CONTROLLER> ACANBitRateDetector (CONTROLLER & inController) :
+  mController (&inController),
+  mListen (listenThroughController <CONTROLLER>),
+  mEvent (eventThroughController <CONTROLLER>),
+  mMillis (millisThroughController <CONTROLLER>),
+  mListenCount (0),
+  mBusErrorCount (0) {
+  }
+
+//······················································································································
+//   Detection: returns the detected candidate, 0 if none within inTimeoutMS (at most kMaxCandidateCount candidates).
+//   On success, the controller listens at the detected bit rate.
+//······················································································································
+
+  public: uint32_t detect (const uint32_t inCandidates [], const uint8_t inCandidateCount, const uint32_t inTimeoutMS) ;
+
+  //--- Statistics of the last detect
+  public: inline uint32_t listenCount (void) const { return mListenCount ; }
+  public: inline uint32_t busErrorCount (void) const { return mBusErrorCount ; }
+
+//······················································································································
+//   Adaptor
+//······················································································································
+
+  private: typedef bool (*ListenRoutine) (void * inController, const uint32_t inBitRate) ;
+  private: typedef Event (*EventRoutine) (void * inController) ;
+  private: typedef uint32_t (*MillisRoutine) (void * inController) ;
+
+  private: template <typename CONTROLLER> static bool listenThroughController (void * inController, const uint32_t inBitRate) {
+    return ((CONTROLLER *) inController)->listenAtBitRate (inBitRate) ;
+  }
+
+  private: template <typename CONTROLLER> static Event eventThroughController (void * inController) {
+    return ((CONTROLLER *) inController)->bitRateEvent () ;
+  }
+
+  private: template <typename CONTROLLER> static uint32_t millisThroughController (void * inController) {
+    return ((CONTROLLER *) inController)->bitRateDetectionMillis () ;
+  }
+
+  private: void * mController ;
+  private: const ListenRoutine mListen ;
+  private: const EventRoutine mEvent ;
+  private: const MillisRoutine mMillis ;
+  private: uint32_t mListenCount ;
+  private: uint32_t mBusErrorCount ;
+
+//······················································································································
+//    No copy
+//······················································································································
+
+  private: ACANBitRateDetector (const ACANBitRateDetector &) = delete ;
+  private: ACANBitRateDetector & operator = (const ACANBitRateDetector &) = delete ;
+} ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+#endif
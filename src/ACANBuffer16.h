@@ -17,6 +17,8 @@
 
 /*------------------------------- Include files ------------------------------*/
 #include "CANMessage.h"
+#include "ACANInternalRAM.h"
+#include "ACANBufferStatistics.h"
 
 //----------------------------------------------------------------------------------------------------------------------
 
@@ -31,7 +33,9 @@ class ACANBuffer16 {
   mSize (0),
   mReadIndex (0),
   mCount (0),
-  mPeakCount (0) {
+  mPeakCount (0),
+  mOwnsBuffer (false),
+  mStatistics (nullptr) {
   }
 
 //······················································································································
@@ -39,7 +43,7 @@ class ACANBuffer16 {
 //······················································································································
 
   public: ~ ACANBuffer16 (void) {
-    delete [] mBuffer ;
+    free () ;
   }
 
 //······················································································································
@@ -51,6 +55,8 @@ class ACANBuffer16 {
   private: uint16_t mReadIndex ;
   private: uint16_t mCount ;
   private: uint16_t mPeakCount ; // > mSize if overflow did occur
+  private: bool mOwnsBuffer ;    // false: storage provided by initWithStorage
+  private: ACANBufferStatistics * mStatistics ; // nullptr: no recording
 
 //······················································································································
 // Accessors
@@ -65,21 +71,67 @@ class ACANBuffer16 {
 //······················································································································
 
   public: bool initWithSize (const uint16_t inSize) {
-    delete [] mBuffer ;
-    mBuffer = new CANMessage [inSize] ;
-    const bool ok = mBuffer != NULL ;
+    const bool reuse = mOwnsBuffer && (mBuffer != NULL) && (mSize == inSize) ; // No reallocation on re-init
+    if (!reuse) {
+      free () ;
+      mBuffer = (inSize > 0) ? allocateInternalRAMArray <CANMessage> (inSize) : NULL ; // heap_caps_malloc (0): NULL
+      mOwnsBuffer = true ;
+    }
+    const bool ok = (inSize == 0) || (mBuffer != NULL) ;
     mSize = ok ? inSize : 0 ;
     mReadIndex = 0 ;
     mCount = 0 ;
     mPeakCount = 0 ;
+    resizeStatistics () ;
     return ok ;
   }
 
 //······················································································································
-// append
+// initWithStorage: inSize messages at inStorage, in any memory region; the buffer does not free them
+//······················································································································
+
+  public: void initWithStorage (CANMessage * inStorage, const uint16_t inSize) {
+    free () ;
+    mBuffer = inStorage ;
+    mOwnsBuffer = false ;
+    mSize = (inStorage != NULL) ? inSize : 0 ;
+    resizeStatistics () ;
+  }
+
+//······················································································································
+// Statistics (nullptr: none). prepareStatistics allocates the enqueue dates for the current size, not in critical
+// section; attachStatistics then resets them and starts recording (in critical section if an interrupt uses the
+// buffer). The statistics follow later size changes (initWithSize, initWithStorage).
 //······················································································································
 
-  public: bool append (const CANMessage & inMessage) {
+  public: bool prepareStatistics (ACANBufferStatistics * inStatistics) const {
+    return (inStatistics == nullptr) || inStatistics->setCapacity (mSize) ;
+  }
+
+  public: void attachStatistics (ACANBufferStatistics * inStatistics) {
+    mStatistics = ((inStatistics != nullptr) && (inStatistics->capacity () == mSize)) ? inStatistics : nullptr ;
+    resetStatistics () ;
+  }
+
+  public: void resetStatistics (void) {
+    if (mStatistics != nullptr) {
+      mStatistics->reset (mReadIndex, mCount) ;
+    }
+  }
+
+  public: inline const ACANBufferStatistics * statistics (void) const { return mStatistics ; }
+
+  private: void resizeStatistics (void) {
+    if ((mStatistics != nullptr) && !mStatistics->setCapacity (mSize)) {
+      mStatistics = nullptr ; // Enqueue dates not allocated
+    }
+  }
+
+//······················································································································
+// append (receive interrupt: in IRAM, so is remove for the transmit interrupt)
+//······················································································································
+
+  public: IRAM_ATTR bool append (const CANMessage & inMessage) {
     const bool ok = mCount < mSize ;
     if (ok) {
       uint16_t writeIndex = mReadIndex + mCount ;
@@ -91,6 +143,11 @@ class ACANBuffer16 {
       if (mPeakCount < mCount) {
         mPeakCount = mCount ;
       }
+      if (mStatistics != nullptr) {
+        mStatistics->didAppend (writeIndex, mCount) ;
+      }
+    }else if (mStatistics != nullptr) {
+      mStatistics->didReject () ;
     }
     return ok ;
   }
@@ -99,10 +156,13 @@ class ACANBuffer16 {
 // Remove
 //······················································································································
 
-  public: bool remove (CANMessage & outMessage) {
+  public: IRAM_ATTR bool remove (CANMessage & outMessage) {
     const bool ok = mCount > 0 ;
     if (ok) {
       outMessage = mBuffer [mReadIndex] ;
+      if (mStatistics != nullptr) {
+        mStatistics->didRemove (mReadIndex) ;
+      }
       mCount -= 1 ;
       mReadIndex += 1 ;
       if (mReadIndex == mSize) {
@@ -112,12 +172,38 @@ class ACANBuffer16 {
     return ok ;
   }
 
+//······················································································································
+// first / dropFirst: read the oldest message in place, then remove it (zero copy consumer). The slot is not written
+// by append until dropFirst, so the pointer stays valid while the producer runs.
+//······················································································································
+
+  public: const CANMessage * first (void) const {
+    return (mCount > 0) ? & mBuffer [mReadIndex] : nullptr ;
+  }
+
+  public: void dropFirst (void) {
+    if (mCount > 0) {
+      if (mStatistics != nullptr) {
+        mStatistics->didRemove (mReadIndex) ;
+      }
+      mCount -= 1 ;
+      mReadIndex += 1 ;
+      if (mReadIndex == mSize) {
+        mReadIndex = 0 ;
+      }
+    }
+  }
+
 //······················································································································
 // Free
 //······················································································································
 
   public: void free (void) {
-    delete [] mBuffer ; mBuffer = nullptr ;
+    if (mOwnsBuffer) {
+      freeInternalRAMArray (mBuffer) ;
+    }
+    mBuffer = nullptr ;
+    mOwnsBuffer = false ;
     mSize = 0 ;
     mReadIndex = 0 ;
     mCount = 0 ;
@@ -0,0 +1,195 @@
+/******************************************************************************/
+/* File name        : ACANBufferStatistics.cpp                                */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Description      : Occupancy, residence time and overflow statistics of    */
+/*                    a driver buffer (ACANBuffer16)                          */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation                                                        */
+/* ---------------------------------------------------------------------------*/
+
+/*------------------------------- Include files ------------------------------*/
+#include "ACANBufferStatistics.h"
+#ifdef ARDUINO
+  #include <esp_timer.h>
+#else
+  #include <chrono>
+#endif
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   DEFAULT DATE: esp_timer microseconds (ESP32), nanoseconds (desktop). Not the CPU cycle counter: it is per core, and
+//   didAppend (interrupt core) and didRemove (task core) may run on different cores
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+IRAM_ATTR uint32_t ACANBufferStatistics::defaultDate (void) {
+  #ifdef ARDUINO
+    return uint32_t (esp_timer_get_time ()) ;
+  #else
+    return uint32_t (std::chrono::duration_cast <std::chrono::nanoseconds> (
+      std::chrono::steady_clock::now ().time_since_epoch ()).count ()) ;
+  #endif
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   CONSTRUCTOR, DESTRUCTOR
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+ACANBufferStatistics::ACANBufferStatistics (DateFunction inDateFunction) :
+mDateFunction (inDateFunction),
+mEnqueueDates (nullptr),
+mCapacity (0),
+mOccupancyShift (0),
+mOccupancy (),
+mOccupancySampleCount (0),
+mResidence (),
+mResidenceSampleCount (0),
+mResidenceMax (0),
+mDroppedCount (0),
+mEpisodes (),
+mEpisodeCount (0),
+mLongestEpisode (0),
+mTotalEpisodeDuration (0),
+mEpisodeStart (0),
+mEpisodeDroppedCount (0),
+mInOverflow (false) {
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+ACANBufferStatistics::~ ACANBufferStatistics (void) {
+  freeInternalRAMArray (mEnqueueDates) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   CAPACITY
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+bool ACANBufferStatistics::setCapacity (const uint16_t inBufferSize) {
+  bool ok = true ;
+  if ((mEnqueueDates == nullptr) || (mCapacity != inBufferSize)) {
+    freeInternalRAMArray (mEnqueueDates) ;
+    mEnqueueDates = (inBufferSize > 0) ? allocateInternalRAMArray <uint32_t> (inBufferSize) : nullptr ;
+    ok = (inBufferSize == 0) || (mEnqueueDates != nullptr) ;
+  }
+  mCapacity = ok ? inBufferSize : 0 ;
+  mOccupancyShift = 0 ;
+  while ((mCapacity >> mOccupancyShift) >= kOccupancyBucketCount) {
+    mOccupancyShift += 1 ;
+  }
+  reset () ;
+  return ok ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   RESET
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ACANBufferStatistics::reset (const uint16_t inFirstSlot, const uint16_t inCount) {
+  const uint32_t now = mDateFunction () ;
+  uint16_t slot = inFirstSlot ;
+  for (uint16_t i=0 ; i<inCount ; i++) {
+    mEnqueueDates [slot] = now ;
+    slot += 1 ;
+    if (slot == mCapacity) {
+      slot = 0 ;
+    }
+  }
+  for (uint16_t i=0 ; i<kOccupancyBucketCount ; i++) {
+    mOccupancy [i] = 0 ;
+  }
+  mOccupancySampleCount = 0 ;
+  for (uint16_t i=0 ; i<kResidenceBucketCount ; i++) {
+    mResidence [i] = 0 ;
+  }
+  mResidenceSampleCount = 0 ;
+  mResidenceMax = 0 ;
+  mDroppedCount = 0 ;
+  mEpisodeCount = 0 ;
+  mLongestEpisode = 0 ;
+  mTotalEpisodeDuration = 0 ;
+  mInOverflow = false ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   OVERFLOW EPISODES
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+IRAM_ATTR void ACANBufferStatistics::endOverflowEpisode (const uint32_t inNow) {
+  const uint32_t duration = inNow - mEpisodeStart ;
+  OverflowEpisode & episode = mEpisodes [mEpisodeCount % kRecentEpisodeCount] ;
+  episode.mStart = mEpisodeStart ;
+  episode.mDuration = duration ;
+  episode.mDroppedCount = mEpisodeDroppedCount ;
+  mEpisodeCount += 1 ;
+  mTotalEpisodeDuration += duration ;
+  if (mLongestEpisode < duration) {
+    mLongestEpisode = duration ;
+  }
+  mInOverflow = false ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+bool ACANBufferStatistics::recentOverflowEpisode (const uint8_t inIndex, OverflowEpisode & outEpisode) const {
+  const bool ok = (inIndex < kRecentEpisodeCount) && (inIndex < mEpisodeCount) ;
+  if (ok) {
+    outEpisode = mEpisodes [(mEpisodeCount - 1 - inIndex) % kRecentEpisodeCount] ;
+  }
+  return ok ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   PERCENTILES
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+uint32_t ACANBufferStatistics::percentile (const uint32_t * inHistogram,
+                                           const uint16_t inBucketCount,
+                                           const uint32_t inSampleCount,
+                                           const uint32_t inPerThousand) {
+  //--- Rank of the sample, rounded up: at least inPerThousand / 1000 of the samples are lower or equal
+  const uint64_t rank = (uint64_t (inSampleCount) * inPerThousand + 999) / 1000 ;
+  uint64_t cumulated = 0 ;
+  uint16_t bucket = 0 ;
+  while ((bucket < (inBucketCount - 1)) && ((cumulated + inHistogram [bucket]) < rank)) {
+    cumulated += inHistogram [bucket] ;
+    bucket += 1 ;
+  }
+  return bucket ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+uint32_t ACANBufferStatistics::occupancyPercentile (const uint32_t inPerThousand) const {
+  const uint32_t bucket = percentile (mOccupancy, kOccupancyBucketCount, mOccupancySampleCount, inPerThousand) ;
+  const uint32_t upperBound = ((bucket + 1) << mOccupancyShift) - 1 ;
+  return (upperBound < mCapacity) ? upperBound : mCapacity ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+uint32_t ACANBufferStatistics::residencePercentile (const uint32_t inPerThousand) const {
+  const uint32_t bucket = percentile (mResidence, kResidenceBucketCount, mResidenceSampleCount, inPerThousand) ;
+  const uint32_t upperBound = residenceBucketUpperBound (uint16_t (bucket)) ;
+  return (upperBound < mResidenceMax) ? upperBound : mResidenceMax ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+uint32_t ACANBufferStatistics::residenceBucketUpperBound (const uint16_t inIndex) {
+  uint32_t upperBound = inIndex ;
+  if (inIndex >= 8) {
+    const uint32_t exponent = uint32_t (inIndex / 8) + 2 ;
+    const uint32_t lowerBound = (8 + uint32_t (inIndex % 8)) << (exponent - 3) ;
+    upperBound = lowerBound + ((1UL << (exponent - 3)) - 1) ;
+  }
+  return upperBound ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
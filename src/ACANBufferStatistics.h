@@ -0,0 +1,201 @@
+/******************************************************************************/
+/* File name        : ACANBufferStatistics.h                                  */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Description      : Occupancy, residence time and overflow statistics of    */
+/*                    a driver buffer (ACANBuffer16)                          */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation                                                        */
+/* ---------------------------------------------------------------------------*/
+
+#ifndef ACAN_BUFFER_STATISTICS_CLASS_DEFINED
+#define ACAN_BUFFER_STATISTICS_CLASS_DEFINED
+
+/*------------------------------- Include files ------------------------------*/
+#include "CANMessage.h"
+#include "ACANInternalRAM.h"
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   Buffer statistics, recorded by ACANBuffer16 once attached (ACANBuffer16::attachStatistics):
+//   - occupancy histogram, one sample per append (count after the append, or the size if the buffer is full);
+//   - residence time of every frame, from append to remove, in a log bucketed histogram: 8 buckets per power of two,
+//     a percentile is the upper bound of its bucket (at most 12.5 % above the exact value);
+//   - overflow episodes: from the first rejected append to the next remove, with their duration and dropped count.
+//   Dates come from a date function, in its own unit: esp_timer microseconds on the ESP32 (one clock for both cores,
+//   append and remove may run on different cores), nanoseconds (steady clock) on the desktop. Differences are
+//   computed modulo 2^32 (ESP32: residence times up to 71 minutes).
+//   Recording is O(1): a few loads and increments per append and per remove, no division.
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+class ACANBufferStatistics {
+
+//······················································································································
+//   Constructor, destructor
+//······················································································································
+
+  public: typedef uint32_t (* DateFunction) (void) ;
+
+  public: ACANBufferStatistics (DateFunction inDateFunction = defaultDate) ;
+
+  public: ~ ACANBufferStatistics (void) ;
+
+  public: static uint32_t defaultDate (void) ;
+
+//······················································································································
+//   Capacity: one enqueue date per buffer slot, allocated in internal RAM. Called by ACANBuffer16 (prepareStatistics,
+//   initWithSize, initWithStorage), not in critical section. Resets the statistics.
+//······················································································································
+
+  public: bool setCapacity (const uint16_t inBufferSize) ;
+
+  public: inline uint16_t capacity (void) const { return mCapacity ; }
+
+//······················································································································
+//   Reset (in critical section if the buffer is used by an interrupt, see ESP32ACAN::resetDriverBufferStatistics).
+//   inFirstSlot / inCount: frames currently in the buffer, their residence time is counted from now.
+//······················································································································
+
+  public: void reset (const uint16_t inFirstSlot = 0, const uint16_t inCount = 0) ;
+
+//······················································································································
+//   Recording, called by ACANBuffer16
+//······················································································································
+
+  public: inline IRAM_ATTR void didAppend (const uint16_t inSlot, const uint16_t inCount) {
+    mEnqueueDates [inSlot] = mDateFunction () ;
+    mOccupancy [inCount >> mOccupancyShift] += 1 ;
+    mOccupancySampleCount += 1 ;
+  }
+
+  public: inline IRAM_ATTR void didReject (void) {
+    const uint32_t now = mDateFunction () ;
+    mOccupancy [mCapacity >> mOccupancyShift] += 1 ;
+    mOccupancySampleCount += 1 ;
+    mDroppedCount += 1 ;
+    if (!mInOverflow) {
+      mInOverflow = true ;
+      mEpisodeStart = now ;
+      mEpisodeDroppedCount = 0 ;
+    }
+    mEpisodeDroppedCount += 1 ;
+  }
+
+  public: inline IRAM_ATTR void didRemove (const uint16_t inSlot) {
+    const uint32_t now = mDateFunction () ;
+    const uint32_t residence = now - mEnqueueDates [inSlot] ;
+    mResidence [residenceBucket (residence)] += 1 ;
+    mResidenceSampleCount += 1 ;
+    if (mResidenceMax < residence) {
+      mResidenceMax = residence ;
+    }
+    if (mInOverflow) {
+      endOverflowEpisode (now) ;
+    }
+  }
+
+//······················································································································
+//   Occupancy histogram: bucket i counts the samples in [occupancyBucketLowerBound (i), lower bound of i + 1)
+//······················································································································
+
+  public: static const uint16_t kOccupancyBucketCount = 33 ; // Last one: full buffer with a power of two size
+
+  public: inline uint32_t occupancyBucket (const uint16_t inIndex) const { return mOccupancy [inIndex] ; }
+  public: inline uint32_t occupancyBucketLowerBound (const uint16_t inIndex) const { return uint32_t (inIndex) << mOccupancyShift ; }
+  public: inline uint32_t occupancySampleCount (void) const { return mOccupancySampleCount ; }
+
+  //--- Smallest occupancy such that inPerThousand / 1000 of the samples are lower or equal (bucket upper bound)
+  public: uint32_t occupancyPercentile (const uint32_t inPerThousand) const ;
+
+//······················································································································
+//   Residence time histogram (date function unit)
+//······················································································································
+
+  public: static const uint16_t kResidenceBucketCount = 240 ;
+
+  public: static inline IRAM_ATTR uint32_t residenceBucket (const uint32_t inDuration) {
+    uint32_t bucket = inDuration ;
+    if (inDuration >= 8) {
+      const uint32_t exponent = 31 - uint32_t (__builtin_clz (inDuration)) ; // 3 ... 31
+      bucket = (exponent - 2) * 8 + ((inDuration >> (exponent - 3)) & 7) ;
+    }
+    return bucket ;
+  }
+
+  public: static uint32_t residenceBucketUpperBound (const uint16_t inIndex) ;
+
+  public: inline uint32_t residenceBucketCount (const uint16_t inIndex) const { return mResidence [inIndex] ; }
+  public: inline uint32_t residenceSampleCount (void) const { return mResidenceSampleCount ; }
+  public: inline uint32_t residenceMax (void) const { return mResidenceMax ; }
+
+  public: uint32_t residencePercentile (const uint32_t inPerThousand) const ;
+  public: inline uint32_t residenceP50 (void) const { return residencePercentile (500) ; }
+  public: inline uint32_t residenceP99 (void) const { return residencePercentile (990) ; }
+  public: inline uint32_t residenceP999 (void) const { return residencePercentile (999) ; }
+
+//······················································································································
+//   Overflow episodes: the last kRecentEpisodeCount are kept, recentOverflowEpisode (0) is the newest
+//······················································································································
+
+  public: class OverflowEpisode {
+    public: uint32_t mStart ;
+    public: uint32_t mDuration ;
+    public: uint32_t mDroppedCount ;
+  } ;
+
+  public: static const uint8_t kRecentEpisodeCount = 8 ;
+
+  public: inline uint32_t droppedCount (void) const { return mDroppedCount ; }
+  public: inline uint32_t overflowEpisodeCount (void) const { return mEpisodeCount ; }
+  public: inline uint32_t longestOverflowDuration (void) const { return mLongestEpisode ; }
+  public: inline uint64_t totalOverflowDuration (void) const { return mTotalEpisodeDuration ; }
+  public: inline bool inOverflow (void) const { return mInOverflow ; }
+
+  public: bool recentOverflowEpisode (const uint8_t inIndex, OverflowEpisode & outEpisode) const ;
+
+//······················································································································
+//   Private
+//······················································································································
+
+  private: void endOverflowEpisode (const uint32_t inNow) ;
+
+  private: static uint32_t percentile (const uint32_t * inHistogram,
+                                       const uint16_t inBucketCount,
+                                       const uint32_t inSampleCount,
+                                       const uint32_t inPerThousand) ;
+
+  private: const DateFunction mDateFunction ;
+  private: uint32_t * mEnqueueDates ;
+  private: uint16_t mCapacity ;
+  private: uint8_t mOccupancyShift ; // (capacity >> shift) < kOccupancyBucketCount
+  private: uint32_t mOccupancy [kOccupancyBucketCount] ;
+  private: uint32_t mOccupancySampleCount ;
+  private: uint32_t mResidence [kResidenceBucketCount] ;
+  private: uint32_t mResidenceSampleCount ;
+  private: uint32_t mResidenceMax ;
+  private: uint32_t mDroppedCount ;
+  private: OverflowEpisode mEpisodes [kRecentEpisodeCount] ;
+  private: uint32_t mEpisodeCount ;
+  private: uint32_t mLongestEpisode ;
+  private: uint64_t mTotalEpisodeDuration ;
+  private: uint32_t mEpisodeStart ;
+  private: uint32_t mEpisodeDroppedCount ;
+  private: bool mInOverflow ;
+
+//······················································································································
+//    No copy
+//······················································································································
+
+  private: ACANBufferStatistics (const ACANBufferStatistics &) = delete ;
+  private: ACANBufferStatistics & operator = (const ACANBufferStatistics &) = delete ;
+} ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+#endif
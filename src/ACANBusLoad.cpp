@@ -0,0 +1,255 @@
+/******************************************************************************/
+/* File name        : ACANBusLoad.cpp                                         */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Description      : Frame length on the wire and bus load meter             */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation                                                        */
+/* ---------------------------------------------------------------------------*/
+
+/*------------------------------- Include files ------------------------------*/
+#include "ACANBusLoad.h"
+
+/*------------------------------- Local defines ------------------------------*/
+#define EXTENDED_BIT     (0x80000000UL)
+#define HASH_MULTIPLIER  (2654435761UL)   // Knuth multiplicative hash
+#define SECOND_WINDOW    (2)              // 10 s window: 1 s buckets, its bucket index is the current second
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   CONSTRUCTOR
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+ACANBusLoad::ACANBusLoad (void) :
+mIdentifiers (nullptr),
+mIndexes (nullptr),
+mOther (),
+mWindows (),
+mBitCount (0),
+mFrameCount (0),
+mBitRate (0),
+mIdentifierCapacity (0),
+mIdentifierCount (0),
+mHashShift (32),
+mStuffing (ACANFrameLength::ActualStuffing),
+mStarted (false) {
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+ACANBusLoad::~ ACANBusLoad (void) {
+  freeInternalRAMArray (mIdentifiers) ;
+  freeInternalRAMArray (mIndexes) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   INITIALISATION
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+bool ACANBusLoad::begin (const uint32_t inBitRate,
+                         const uint16_t inIdentifierCapacity,
+                         const ACANFrameLength::Stuffing inStuffing) {
+  freeInternalRAMArray (mIdentifiers) ;
+  freeInternalRAMArray (mIndexes) ;
+  mIdentifiers = nullptr ;
+  mIndexes = nullptr ;
+  uint32_t indexCount = 2 ;
+  uint8_t hashShift = 31 ;
+  while (indexCount < (2 * uint32_t (inIdentifierCapacity))) {
+    indexCount *= 2 ;
+    hashShift -= 1 ;
+  }
+  if ((inIdentifierCapacity > 0) && (inIdentifierCapacity < kNoIdentifier)) {
+    mIdentifiers = allocateInternalRAMArray <ACANBusLoadIdentifier> (inIdentifierCapacity) ;
+    mIndexes = allocateInternalRAMArray <uint16_t> (indexCount) ;
+  }
+  const bool ok = (inIdentifierCapacity == 0) || ((mIdentifiers != nullptr) && (mIndexes != nullptr)) ;
+  if (!ok) {
+    freeInternalRAMArray (mIdentifiers) ;
+    freeInternalRAMArray (mIndexes) ;
+    mIdentifiers = nullptr ;
+    mIndexes = nullptr ;
+  }
+  mIdentifierCapacity = (ok && (mIdentifiers != nullptr)) ? inIdentifierCapacity : 0 ;
+  mHashShift = (mIdentifierCapacity > 0) ? hashShift : 32 ;
+  mBitRate = inBitRate ;
+  mStuffing = inStuffing ;
+  mWindows [0].mBucketDuration = 10 * 1000 ;
+  mWindows [1].mBucketDuration = 100 * 1000 ;
+  mWindows [2].mBucketDuration = 1000 * 1000 ;
+  mStarted = false ; // Windows start at the first recordFrame or loadPermille call
+  return ok ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void IRAM_ATTR ACANBusLoad::reset (const uint32_t inNowMicros) {
+  for (uint8_t w=0 ; w<3 ; w++) {
+    SlidingWindow & window = mWindows [w] ;
+    for (uint8_t b=0 ; b<kBucketCount ; b++) {
+      window.mBuckets [b] = 0 ;
+    }
+    window.mSum = 0 ;
+    window.mBucketStart = inNowMicros ;
+    window.mBucketIndex = 0 ;
+  }
+  for (uint16_t i=0 ; i<mIdentifierCapacity ; i++) {
+    mIdentifiers [i] = ACANBusLoadIdentifier () ;
+  }
+  if (mIdentifierCapacity > 0) {
+    const uint32_t indexCount = 1UL << (32 - mHashShift) ;
+    for (uint32_t i=0 ; i<indexCount ; i++) {
+      mIndexes [i] = kNoIdentifier ;
+    }
+  }
+  mOther = ACANBusLoadIdentifier () ;
+  mIdentifierCount = 0 ;
+  mBitCount = 0 ;
+  mFrameCount = 0 ;
+  mStarted = true ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   SLIDING WINDOWS
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void IRAM_ATTR ACANBusLoad::advance (SlidingWindow & ioWindow, const uint32_t inNowMicros) {
+  const uint32_t elapsed = inNowMicros - ioWindow.mBucketStart ;
+  if (elapsed >= ioWindow.mBucketDuration) {
+    const uint32_t steps = elapsed / ioWindow.mBucketDuration ;
+    if (steps >= kBucketCount) {
+      for (uint8_t b=0 ; b<kBucketCount ; b++) {
+        ioWindow.mBuckets [b] = 0 ;
+      }
+      ioWindow.mSum = 0 ;
+    }else{
+      for (uint32_t s=1 ; s<=steps ; s++) {
+        const uint32_t b = (ioWindow.mBucketIndex + s) % kBucketCount ;
+        ioWindow.mSum -= ioWindow.mBuckets [b] ;
+        ioWindow.mBuckets [b] = 0 ;
+      }
+    }
+    ioWindow.mBucketIndex += steps ;
+    ioWindow.mBucketStart += steps * ioWindow.mBucketDuration ;
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+uint16_t ACANBusLoad::loadPermille (const Window inWindow, const uint32_t inNowMicros) {
+  if (!mStarted) {
+    reset (inNowMicros) ;
+  }
+  SlidingWindow & window = mWindows [inWindow] ;
+  advance (window, inNowMicros) ;
+//--- Complete buckets still in the ring, plus the current one
+  const uint32_t completeBuckets = (window.mBucketIndex < (kBucketCount - 1)) ? window.mBucketIndex : (kBucketCount - 1) ;
+  const uint64_t span = (uint64_t) completeBuckets * window.mBucketDuration + (inNowMicros - window.mBucketStart) ;
+  uint64_t load = 0 ;
+  if ((span > 0) && (mBitRate > 0)) {
+    load = (window.mSum * 1000000000ULL) / ((uint64_t) mBitRate * span) ;
+  }
+  return (uint16_t) ((load < 1000) ? load : 1000) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   RECORDING
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void IRAM_ATTR ACANBusLoad::recordFrame (const CANMessage & inFrame, const uint32_t inNowMicros) {
+  if (!mStarted) {
+    reset (inNowMicros) ;
+  }
+  const uint32_t bits = ACANFrameLength::bitLength (inFrame, mStuffing) ;
+  mFrameCount += 1 ;
+  mBitCount += bits ;
+  for (uint8_t w=0 ; w<3 ; w++) {
+    SlidingWindow & window = mWindows [w] ;
+    advance (window, inNowMicros) ;
+    window.mBuckets [window.mBucketIndex % kBucketCount] += bits ;
+    window.mSum += bits ;
+  }
+//--- Identifier entry, lazy roll over of its last complete second
+  const uint32_t key = inFrame.id | (inFrame.ext ? EXTENDED_BIT : 0) ;
+  const uint32_t second = mWindows [SECOND_WINDOW].mBucketIndex ;
+  ACANBusLoadIdentifier & entry = entryForKey (key, second) ;
+  if (entry.mPeriod != second) {
+    entry.mPreviousPeriodBits = (entry.mPeriod + 1 == second) ? entry.mPeriodBits : 0 ;
+    entry.mPeriodBits = 0 ;
+    entry.mPeriod = second ;
+  }
+  entry.mFrameCount += 1 ;
+  entry.mBitCount += bits ;
+  entry.mPeriodBits += bits ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   Entry of a key: linear probing from the multiplicative hash (high bits), at most kMaxProbeCount indexes; a new key
+//   takes the next pool entry. The other entry when the pool is full or the probing too long.
+
+ACANBusLoadIdentifier & IRAM_ATTR ACANBusLoad::entryForKey (const uint32_t inKey, const uint32_t inSecond) {
+  ACANBusLoadIdentifier * result = & mOther ;
+  if (mIdentifierCapacity > 0) {
+    const uint32_t mask = (1UL << (32 - mHashShift)) - 1 ;
+    uint32_t h = uint32_t (inKey * HASH_MULTIPLIER) >> mHashShift ;
+    bool done = false ;
+    for (uint8_t probe=0 ; (probe<kMaxProbeCount) && !done ; probe++) {
+      const uint16_t index = mIndexes [h] ;
+      if (index == kNoIdentifier) { // Free index: new key, if the pool has room
+        done = true ;
+        if (mIdentifierCount < mIdentifierCapacity) {
+          result = & mIdentifiers [mIdentifierCount] ;
+          result->mKey = inKey ;
+          result->mPeriod = inSecond ;
+          mIndexes [h] = mIdentifierCount ;
+          mIdentifierCount += 1 ;
+        }
+      }else if (mIdentifiers [index].mKey == inKey) {
+        done = true ;
+        result = & mIdentifiers [index] ;
+      }
+      h = (h + 1) & mask ;
+    }
+  }
+  return *result ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+uint16_t ACANBusLoad::identifierLoadPermille (const uint16_t inIndex, const uint32_t inNowMicros) {
+  return loadPermilleOf (mIdentifiers [inIndex], inNowMicros) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+uint16_t ACANBusLoad::otherLoadPermille (const uint32_t inNowMicros) {
+  return loadPermilleOf (mOther, inNowMicros) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+uint16_t ACANBusLoad::loadPermilleOf (const ACANBusLoadIdentifier & inEntry, const uint32_t inNowMicros) {
+  if (!mStarted) {
+    reset (inNowMicros) ;
+  }
+  SlidingWindow & window = mWindows [SECOND_WINDOW] ;
+  advance (window, inNowMicros) ;
+  const uint32_t second = window.mBucketIndex ;
+  uint32_t bits = 0 ;
+  if (inEntry.mFrameCount > 0) {
+    if (inEntry.mPeriod == second) {
+      bits = inEntry.mPreviousPeriodBits ;
+    }else if (inEntry.mPeriod + 1 == second) {
+      bits = inEntry.mPeriodBits ;
+    }
+  }
+  return (mBitRate > 0) ? (uint16_t) (((uint64_t) bits * 1000) / mBitRate) : 0 ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
@@ -0,0 +1,285 @@
+/******************************************************************************/
+/* File name        : ACANBusLoad.h                                           */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Description      : Frame length on the wire and bus load meter             */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation                                                        */
+/* ---------------------------------------------------------------------------*/
+
+#ifndef ACAN_BUS_LOAD_CLASS_DEFINED
+#define ACAN_BUS_LOAD_CLASS_DEFINED
+
+/*------------------------------- Include files ------------------------------*/
+#include "CANMessage.h"
+#include "ACANInternalRAM.h"
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   Frame length on the wire (bits, from start of frame to the end of the 3 bit intermission)
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+// Stuffing applies from start of frame to the end of the CRC sequence. With actual stuffing, the frame bits and the
+// CRC-15 are computed, and a stuff bit is counted after every 5 equal bits (stuff bits included in the runs). Worst
+// case: one stuff bit every 4 bits after the first one (ISO 11898-1, as used by response time analysis).
+// The fixed tail is CRC delimiter, ACK slot, ACK delimiter, 7 bit EOF and 3 bit intermission: 13 bits.
+
+class ACANFrameLength {
+
+  public: typedef enum : uint8_t {
+    NoStuffing,
+    ActualStuffing,
+    WorstCaseStuffing
+  } Stuffing ;
+
+  public: static inline IRAM_ATTR uint32_t bitLength (const CANMessage & inFrame, const Stuffing inStuffing) {
+    uint32_t length ;
+    switch (inStuffing) {
+    case NoStuffing :
+      length = stuffableBitCount (inFrame) + 13 ;
+      break ;
+    case WorstCaseStuffing :
+      length = stuffableBitCount (inFrame) + 13 + (stuffableBitCount (inFrame) - 1) / 4 ;
+      break ;
+    default :
+      length = stuffableBitCount (inFrame) + 13 + actualStuffBitCount (inFrame) ;
+      break ;
+    }
+    return length ;
+  }
+
+  //--- SOF ... CRC sequence: 34 + 8n (standard), 54 + 8n (extended)
+  public: static inline uint32_t stuffableBitCount (const CANMessage & inFrame) {
+    return (inFrame.ext ? 54 : 34) + 8 * dataByteCount (inFrame) ;
+  }
+
+  public: static inline uint32_t dataByteCount (const CANMessage & inFrame) {
+    return inFrame.rtr ? 0 : ((inFrame.len <= 8) ? inFrame.len : 8) ;
+  }
+
+//······················································································································
+//   Actual stuffing: the frame is fed 4 bits at a time (MSB first) through two nibble tables, CRC-15 (polynomial
+//   0x4599) and the stuffing state machine. State: bit 2 is the last bit on the wire, bits 1..0 the run length - 1
+//   (1 ... 4, a fifth equal bit is stuffed); a table entry is the next state, bit 3 set if a stuff bit was inserted
+//   (at most one per nibble).
+//······················································································································
+
+  private: class BitStream {
+    public: uint32_t mStuffBits = 0 ;
+    public: uint16_t mCRC = 0 ;
+    public: uint8_t mState = 0 ;
+
+    public: inline IRAM_ATTR void stuffNibble (const uint32_t inNibble) {
+      static const DRAM_ATTR uint8_t kStuffTable [8 * 16] = {
+        0x0C, 0x04, 0x00, 0x05, 0x01, 0x04, 0x00, 0x06, 0x02, 0x04, 0x00, 0x05, 0x01, 0x04, 0x00, 0x07,
+        0x08, 0x0D, 0x00, 0x05, 0x01, 0x04, 0x00, 0x06, 0x02, 0x04, 0x00, 0x05, 0x01, 0x04, 0x00, 0x07,
+        0x09, 0x0C, 0x08, 0x0E, 0x01, 0x04, 0x00, 0x06, 0x02, 0x04, 0x00, 0x05, 0x01, 0x04, 0x00, 0x07,
+        0x0A, 0x0C, 0x08, 0x0D, 0x09, 0x0C, 0x08, 0x0F, 0x02, 0x04, 0x00, 0x05, 0x01, 0x04, 0x00, 0x07,
+        0x03, 0x04, 0x00, 0x05, 0x01, 0x04, 0x00, 0x06, 0x02, 0x04, 0x00, 0x05, 0x01, 0x04, 0x00, 0x08,
+        0x03, 0x04, 0x00, 0x05, 0x01, 0x04, 0x00, 0x06, 0x02, 0x04, 0x00, 0x05, 0x01, 0x04, 0x09, 0x0C,
+        0x03, 0x04, 0x00, 0x05, 0x01, 0x04, 0x00, 0x06, 0x02, 0x04, 0x00, 0x05, 0x0A, 0x0C, 0x08, 0x0D,
+        0x03, 0x04, 0x00, 0x05, 0x01, 0x04, 0x00, 0x06, 0x0B, 0x0C, 0x08, 0x0D, 0x09, 0x0C, 0x08, 0x0E
+      } ;
+      const uint8_t next = kStuffTable [(mState << 4) | (inNibble & 0xF)] ;
+      mStuffBits += next >> 3 ;
+      mState = next & 7 ;
+    }
+
+    public: inline IRAM_ATTR void appendNibble (const uint32_t inNibble) {
+      static const DRAM_ATTR uint16_t kCRCTable [16] = {
+        0x0000, 0x4599, 0x4EAB, 0x0B32, 0x58CF, 0x1D56, 0x1664, 0x53FD,
+        0x7407, 0x319E, 0x3AAC, 0x7F35, 0x2CC8, 0x6951, 0x6263, 0x27FA
+      } ;
+      mCRC = (uint16_t) (((mCRC << 4) & 0x7FFF) ^ kCRCTable [((mCRC >> 11) ^ inNibble) & 0xF]) ;
+      stuffNibble (inNibble) ;
+    }
+
+    //--- inBitCount is a multiple of 4
+    public: inline IRAM_ATTR void append (const uint64_t inValue, const uint8_t inBitCount) {
+      for (uint8_t i=inBitCount ; i>0 ; i-=4) {
+        appendNibble ((uint32_t) (inValue >> (i - 4))) ;
+      }
+    }
+
+    public: inline IRAM_ATTR void stuffBit (const uint32_t inBit) {
+      const uint8_t last = mState >> 2 ;
+      const uint8_t run = mState & 3 ;
+      if (inBit != last) {
+        mState = (uint8_t) (inBit << 2) ;
+      }else if (run < 3) {
+        mState += 1 ;
+      }else{ // Fifth equal bit: stuff bit of opposite level
+        mStuffBits += 1 ;
+        mState = (uint8_t) ((inBit ^ 1) << 2) ;
+      }
+    }
+  } ;
+
+//--- A recessive idle bit is put before SOF so that the header is a whole number of nibbles: 20 bits (standard),
+//    40 bits (extended). The CRC starts at 0x4000, which this bit brings to 0; the state starts recessive, run 1.
+
+  public: static IRAM_ATTR uint32_t actualStuffBitCount (const CANMessage & inFrame) {
+    BitStream s ;
+    s.mCRC = 0x4000 ;
+    s.mState = 4 ;
+    const uint64_t dlc = (inFrame.len <= 15) ? inFrame.len : 15 ;
+    const uint64_t rtr = inFrame.rtr ? 1 : 0 ;
+    if (inFrame.ext) { // Idle, SOF, ID28...ID18, SRR, IDE, ID17...ID0, RTR, r1, r0, DLC
+      s.append ((1ULL << 39) | ((uint64_t) (inFrame.id >> 18) << 27) | (3ULL << 25)
+                | ((uint64_t) (inFrame.id & 0x3FFFF) << 7) | (rtr << 6) | dlc, 40) ;
+    }else{ // Idle, SOF, ID10...ID0, RTR, IDE, r0, DLC
+      s.append ((1ULL << 19) | ((uint64_t) (inFrame.id & 0x7FF) << 7) | (rtr << 6) | dlc, 20) ;
+    }
+    const uint32_t n = dataByteCount (inFrame) ;
+    for (uint32_t i=0 ; i<n ; i++) {
+      s.append (inFrame.data [i], 8) ;
+    }
+  //--- CRC sequence: stuffed, not added to the CRC
+    const uint16_t crc = s.mCRC ;
+    s.stuffNibble (crc >> 11) ;
+    s.stuffNibble (crc >> 7) ;
+    s.stuffNibble (crc >> 3) ;
+    s.stuffBit ((crc >> 2) & 1) ;
+    s.stuffBit ((crc >> 1) & 1) ;
+    s.stuffBit (crc & 1) ;
+    return s.mStuffBits ;
+  }
+} ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   Load of an identifier
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+class ACANBusLoadIdentifier {
+  public: uint32_t mKey = 0 ;               // Identifier, bit 31 set for an extended frame
+  public: uint32_t mFrameCount = 0 ;        // Since begin or reset
+  public: uint64_t mBitCount = 0 ;          // Since begin or reset
+  public: uint32_t mPeriod = 0 ;            // Second of mPeriodBits
+  public: uint32_t mPeriodBits = 0 ;        // Bits during second mPeriod
+  public: uint32_t mPreviousPeriodBits = 0 ; // Bits during second mPeriod - 1
+} ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   Bus load meter
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+// Every frame seen on the bus (received, or sent by this node) is recorded with its length on the wire. Three
+// sliding windows (100 ms, 1 s, 10 s) are rings of 10 buckets: recording adds to the current bucket of each window,
+// and the running sums make reading O(1). The per identifier breakdown is a pool of entries sized by begin, found by
+// an open addressing index table (power of two, at least twice the pool) whose probing stops after kMaxProbeCount
+// entries; frames of identifiers that find no entry go to the "other" entry. Each entry keeps the bits of the last
+// complete second, rolled over lazily when the entry is touched.
+// Everything is O(1) per frame, so ESP32ACAN records from the receive and transmit interrupts.
+// No locking here: ESP32ACAN calls it in critical sections.
+
+class ACANBusLoad {
+
+//······················································································································
+//   CONSTRUCTOR
+//······················································································································
+
+  public: ACANBusLoad (void) ;
+
+  public: ~ ACANBusLoad (void) ;
+
+//······················································································································
+//   Initialisation: inBitRate is the actual bit rate (ESP32ACANSettings::actualBitRate ()), room for
+//   inIdentifierCapacity (< 65535) distinct identifiers. Returns false on allocation failure.
+//······················································································································
+
+  public: bool begin (const uint32_t inBitRate,
+                      const uint16_t inIdentifierCapacity,
+                      const ACANFrameLength::Stuffing inStuffing = ACANFrameLength::ActualStuffing) ;
+
+  public: void reset (const uint32_t inNowMicros) ;
+
+//······················································································································
+//   Recording
+//······················································································································
+
+  public: void recordFrame (const CANMessage & inFrame, const uint32_t inNowMicros) ; // In IRAM (CAN interrupt)
+
+//······················································································································
+//   Bus load in ‰ of the window (or of the time since begin / reset if shorter)
+//······················································································································
+
+  public: typedef enum : uint8_t {
+    Window100ms,
+    Window1s,
+    Window10s
+  } Window ;
+
+  public: uint16_t loadPermille (const Window inWindow, const uint32_t inNowMicros) ;
+
+  public: inline uint32_t frameCount (void) const { return mFrameCount ; }
+  public: inline uint64_t bitCount (void) const { return mBitCount ; }
+  public: inline uint32_t bitRate (void) const { return mBitRate ; }
+
+//······················································································································
+//   Per identifier load: entries 0 ... identifierCount () - 1, in order of first frame. Frames of identifiers beyond
+//   the capacity, or whose probing is too long, are counted by the other entry (its mKey is meaningless).
+//······················································································································
+
+  public: inline uint16_t identifierCapacity (void) const { return mIdentifierCapacity ; }
+  public: inline uint16_t identifierCount (void) const { return mIdentifierCount ; }
+  public: inline uint32_t untrackedFrameCount (void) const { return mOther.mFrameCount ; }
+
+  public: inline const ACANBusLoadIdentifier & identifierAtIndex (const uint16_t inIndex) const {
+    return mIdentifiers [inIndex] ;
+  }
+
+  public: inline const ACANBusLoadIdentifier & otherIdentifiers (void) const { return mOther ; }
+
+  //--- Load of the identifier (or of the other entry) during the last complete second (‰)
+  public: uint16_t identifierLoadPermille (const uint16_t inIndex, const uint32_t inNowMicros) ;
+  public: uint16_t otherLoadPermille (const uint32_t inNowMicros) ;
+
+//······················································································································
+//   Private
+//······················································································································
+
+  private: static const uint8_t kBucketCount = 10 ;
+  private: static const uint16_t kNoIdentifier = 0xFFFF ;
+  private: static const uint8_t kMaxProbeCount = 8 ;
+
+  private: class SlidingWindow {
+    public: uint32_t mBuckets [kBucketCount] ;
+    public: uint64_t mSum ;
+    public: uint32_t mBucketDuration ;  // µs
+    public: uint32_t mBucketStart ;     // µs
+    public: uint32_t mBucketIndex ;     // Buckets elapsed since begin / reset
+  } ;
+
+  private: void advance (SlidingWindow & ioWindow, const uint32_t inNowMicros) ;
+  private: uint16_t loadPermilleOf (const ACANBusLoadIdentifier & inEntry, const uint32_t inNowMicros) ;
+  private: ACANBusLoadIdentifier & entryForKey (const uint32_t inKey, const uint32_t inSecond) ;
+
+  private: ACANBusLoadIdentifier * mIdentifiers ;
+  private: uint16_t * mIndexes ;           // Power of two, at least 2 x mIdentifierCapacity entries
+  private: ACANBusLoadIdentifier mOther ;
+  private: SlidingWindow mWindows [3] ;
+  private: uint64_t mBitCount ;
+  private: uint32_t mFrameCount ;
+  private: uint32_t mBitRate ;
+  private: uint16_t mIdentifierCapacity ;
+  private: uint16_t mIdentifierCount ;
+  private: uint8_t mHashShift ;            // 32 - log2 (index count)
+  private: ACANFrameLength::Stuffing mStuffing ;
+  private: bool mStarted ;
+
+//······················································································································
+//    No Copy
+//······················································································································
+
+  private: ACANBusLoad (const ACANBusLoad &) = delete ;
+  private: ACANBusLoad & operator = (const ACANBusLoad &) = delete ;
+
+} ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+#endif
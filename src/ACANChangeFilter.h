@@ -0,0 +1,273 @@
+/******************************************************************************/
+/* File name        : ACANChangeFilter.h                                      */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Description      : Payload change detection: unchanged frames suppressed   */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation                                                        */
+/* ---------------------------------------------------------------------------*/
+
+#ifndef ACAN_CHANGE_FILTER_CLASS_DEFINED
+#define ACAN_CHANGE_FILTER_CLASS_DEFINED
+
+/*------------------------------- Include files ------------------------------*/
+#include "CANMessage.h"
+#include "ACANInternalRAM.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+// Keeps the last payload (data64 and length) of every identifier, and tells whether a received frame carries new
+// information: the first frame of an identifier, and every frame whose length or data bytes differ, are delivered;
+// unchanged frames are suppressed (Suppress mode) or only counted (CountOnly mode: every frame delivered, the counters
+// tell what Suppress would save). Optionally, an unchanged frame is delivered anyway after inForceEveryFrames - 1
+// suppressed frames of its identifier, or inForceAfterMillis after the last delivery (0: never).
+// Identifiers get a slot of a pool of inCapacity slots, on their first frame; standard identifiers find their slot by
+// a direct table (2048 entries), extended ones by an open addressing hash table. When the pool is full, frames of new
+// identifiers are delivered (untracked). Remote frames are always delivered. Data bytes beyond the length are ignored.
+// As ACANMailboxes, no locking here: the driver calls it from the receive path in critical section.
+//----------------------------------------------------------------------------------------------------------------------
+
+class ACANChangeFilter {
+
+  public: typedef enum : uint8_t {
+    Suppress,
+    CountOnly
+  } Mode ;
+
+  public: static const uint16_t kNoSlot = 0xFFFF ;
+  public: static const uint16_t kStandardIdentifierCount = 2048 ;
+
+//······················································································································
+// Default constructor, destructor
+//······················································································································
+
+  public: ACANChangeFilter (void) :
+  mSlots (nullptr),
+  mStandardIndexes (nullptr),
+  mExtendedIndexes (nullptr),
+  mCapacity (0),
+  mSlotCount (0),
+  mHashShift (32),
+  mMode (Suppress),
+  mForceEveryFrames (0),
+  mForceAfterMillis (0) {
+    resetCounters () ;
+  }
+
+  public: ~ ACANChangeFilter (void) {
+    free () ;
+  }
+
+//······················································································································
+// Slot of an identifier
+//······················································································································
+
+  private: class Slot {
+    public: uint64_t mData ;
+    public: uint32_t mKey ;            // Identifier, bit 31 set for an extended frame
+    public: uint32_t mDeliveryDate ;   // ms
+    public: uint32_t mSuppressedCount ; // Since the last delivery
+    public: uint8_t mLength ;
+  } ;
+
+//······················································································································
+// Private properties
+//······················································································································
+
+  private: Slot * mSlots ;
+  private: uint16_t * mStandardIndexes ;  // kStandardIdentifierCount entries
+  private: uint16_t * mExtendedIndexes ;  // Power of two, at least 2 x mCapacity entries
+  private: uint16_t mCapacity ;
+  private: uint16_t mSlotCount ;
+  private: uint8_t mHashShift ;           // 32 - log2 (extended index count)
+  private: Mode mMode ;
+  private: uint32_t mForceEveryFrames ;
+  private: uint32_t mForceAfterMillis ;
+
+  private: uint32_t mFrameCount ;
+  private: uint32_t mChangedCount ;
+  private: uint32_t mUnchangedCount ;
+  private: uint32_t mSuppressedCount ;
+  private: uint32_t mForcedCount ;
+  private: uint32_t mUntrackedCount ;
+
+//······················································································································
+// Counters, since begin or reset. Delivered frames: changed + forced + untracked (Suppress mode)
+//······················································································································
+
+  public: inline uint32_t frameCount (void) const { return mFrameCount ; }
+  public: inline uint32_t changedCount (void) const { return mChangedCount ; }     // First frames included
+  public: inline uint32_t unchangedCount (void) const { return mUnchangedCount ; } // Suppressed + forced
+  public: inline uint32_t suppressedCount (void) const { return mSuppressedCount ; }
+  public: inline uint32_t forcedCount (void) const { return mForcedCount ; }
+  public: inline uint32_t untrackedCount (void) const { return mUntrackedCount ; } // Pool full, remote frames
+  public: inline uint32_t deliveredCount (void) const { return mFrameCount - mSuppressedCount ; }
+
+  public: inline uint16_t capacity (void) const { return mCapacity ; }
+  public: inline uint16_t trackedIdentifierCount (void) const { return mSlotCount ; }
+  public: inline Mode mode (void) const { return mMode ; }
+
+//······················································································································
+// begin: allocates the tables, forgets every payload and resets the counters
+//······················································································································
+
+  public: bool begin (const uint16_t inCapacity,
+                      const Mode inMode = Suppress,
+                      const uint32_t inForceEveryFrames = 0,
+                      const uint32_t inForceAfterMillis = 0) {
+    free () ;
+    uint32_t extendedIndexCount = 2 ;
+    uint8_t hashShift = 31 ;
+    while (extendedIndexCount < (2 * uint32_t (inCapacity))) {
+      extendedIndexCount *= 2 ;
+      hashShift -= 1 ;
+    }
+    mSlots = allocateInternalRAMArray <Slot> (inCapacity) ;
+    mStandardIndexes = allocateInternalRAMArray <uint16_t> (kStandardIdentifierCount) ;
+    mExtendedIndexes = allocateInternalRAMArray <uint16_t> (extendedIndexCount) ;
+    const bool ok = (inCapacity > 0) && (inCapacity < kNoSlot)
+      && (mSlots != nullptr) && (mStandardIndexes != nullptr) && (mExtendedIndexes != nullptr) ;
+    if (!ok) {
+      free () ;
+    }else{
+      mCapacity = inCapacity ;
+      mHashShift = hashShift ;
+      mMode = inMode ;
+      mForceEveryFrames = inForceEveryFrames ;
+      mForceAfterMillis = inForceAfterMillis ;
+      reset () ;
+    }
+    return ok ;
+  }
+
+//······················································································································
+// reset: forgets every payload (the next frame of every identifier is delivered), resets the counters
+//······················································································································
+
+  public: void reset (void) {
+    if (mStandardIndexes != nullptr) {
+      for (uint16_t i=0 ; i<kStandardIdentifierCount ; i++) {
+        mStandardIndexes [i] = kNoSlot ;
+      }
+      const uint32_t extendedIndexCount = 1UL << (32 - mHashShift) ;
+      for (uint32_t i=0 ; i<extendedIndexCount ; i++) {
+        mExtendedIndexes [i] = kNoSlot ;
+      }
+    }
+    mSlotCount = 0 ;
+    resetCounters () ;
+  }
+
+//······················································································································
+// deliver (receive path): returns true if the frame should be delivered to the application
+//······················································································································
+
+  public: IRAM_ATTR bool deliver (const CANMessage & inFrame, const uint32_t inNowMillis) {
+    mFrameCount += 1 ;
+    const uint16_t index = inFrame.rtr ? kNoSlot : slotIndex (inFrame) ;
+    bool deliverFrame = true ;
+    if (index == kNoSlot) {
+      mUntrackedCount += 1 ;
+    }else{
+      Slot & slot = mSlots [index] ;
+      const uint8_t length = (inFrame.len < 8) ? inFrame.len : 8 ;
+      const uint64_t data = inFrame.data64 & payloadMask (length) ;
+      if ((slot.mSuppressedCount != kNewSlot) && (slot.mLength == length) && (slot.mData == data)) {
+        mUnchangedCount += 1 ;
+        deliverFrame = ((mForceEveryFrames > 0) && ((slot.mSuppressedCount + 1) >= mForceEveryFrames))
+                    || ((mForceAfterMillis > 0) && ((inNowMillis - slot.mDeliveryDate) >= mForceAfterMillis)) ;
+        mForcedCount += deliverFrame ;
+      }else{
+        mChangedCount += 1 ;
+        slot.mData = data ;
+        slot.mLength = length ;
+      }
+      if (deliverFrame) {
+        slot.mSuppressedCount = 0 ;
+        slot.mDeliveryDate = inNowMillis ;
+      }else{
+        slot.mSuppressedCount += 1 ;
+        mSuppressedCount += 1 ;
+      }
+    }
+    return deliverFrame || (mMode == CountOnly) ;
+  }
+
+//······················································································································
+// Free
+//······················································································································
+
+  public: void free (void) {
+    freeInternalRAMArray (mSlots) ; mSlots = nullptr ;
+    freeInternalRAMArray (mStandardIndexes) ; mStandardIndexes = nullptr ;
+    freeInternalRAMArray (mExtendedIndexes) ; mExtendedIndexes = nullptr ;
+    mCapacity = 0 ;
+    mSlotCount = 0 ;
+    mHashShift = 32 ;
+  }
+
+//······················································································································
+// Private methods
+//······················································································································
+
+  private: static const uint32_t kNewSlot = 0xFFFFFFFF ; // mSuppressedCount of a slot without payload yet
+
+  private: void resetCounters (void) {
+    mFrameCount = 0 ;
+    mChangedCount = 0 ;
+    mUnchangedCount = 0 ;
+    mSuppressedCount = 0 ;
+    mForcedCount = 0 ;
+    mUntrackedCount = 0 ;
+  }
+
+  //--- Data bytes 0 ... inLength - 1 of data64 (little endian, as the ESP32)
+  private: static inline IRAM_ATTR uint64_t payloadMask (const uint8_t inLength) {
+    return (inLength >= 8) ? ~ 0ULL : ((1ULL << (8 * inLength)) - 1) ;
+  }
+
+  //--- Slot of the frame identifier, allocated on its first frame; kNoSlot if the pool is full (or not allocated)
+  private: IRAM_ATTR uint16_t slotIndex (const CANMessage & inFrame) {
+    uint16_t index = kNoSlot ;
+    if (mCapacity > 0) {
+      uint16_t * entry ;
+      const uint32_t key = inFrame.id | (inFrame.ext ? 0x80000000UL : 0) ;
+      if (!inFrame.ext) {
+        entry = & mStandardIndexes [inFrame.id & (kStandardIdentifierCount - 1)] ;
+      }else{ //--- Linear probing; multiplicative hash, high bits
+        const uint32_t mask = (1UL << (32 - mHashShift)) - 1 ;
+        uint32_t h = uint32_t (key * 0x9E3779B1UL) >> mHashShift ;
+        while ((mExtendedIndexes [h] != kNoSlot) && (mSlots [mExtendedIndexes [h]].mKey != key)) {
+          h = (h + 1) & mask ;
+        }
+        entry = & mExtendedIndexes [h] ;
+      }
+      index = *entry ;
+      if ((index == kNoSlot) && (mSlotCount < mCapacity)) {
+        index = mSlotCount ;
+        mSlotCount += 1 ;
+        *entry = index ;
+        mSlots [index].mKey = key ;
+        mSlots [index].mSuppressedCount = kNewSlot ;
+      }
+    }
+    return index ;
+  }
+
+//······················································································································
+// No copy
+//······················································································································
+
+  private: ACANChangeFilter (const ACANChangeFilter &) = delete ;
+  private: ACANChangeFilter & operator = (const ACANChangeFilter &) = delete ;
+} ;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,477 @@
+/******************************************************************************/
+/* File name        : ACANE2E.cpp                                             */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Description      : End-to-end protection (AUTOSAR E2E profiles 1, 2, 5)    */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation                                                        */
+/* ---------------------------------------------------------------------------*/
+
+/*------------------------------- Include files ------------------------------*/
+#include "ACANE2E.h"
+
+/*------------------------------- Local defines ------------------------------*/
+#define EXTENDED_BIT     (0x80000000UL)
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   CRC TABLES
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static uint8_t gCRC8SAEJ1850Table [4][256] ;
+static uint8_t gCRC8H2FTable [4][256] ;
+static uint16_t gCRC16CCITTTable [4][256] ;
+static bool gCRCTablesReady = false ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void buildCRC8Table (uint8_t ioTable [4][256], const uint8_t inPolynomial) {
+  for (uint32_t b=0 ; b<256 ; b++) {
+    uint8_t crc = (uint8_t) b ;
+    for (uint8_t bit=0 ; bit<8 ; bit++) {
+      crc = (crc & 0x80) ? (uint8_t) ((crc << 1) ^ inPolynomial) : (uint8_t) (crc << 1) ;
+    }
+    ioTable [0][b] = crc ;
+  }
+  for (uint32_t k=1 ; k<4 ; k++) {
+    for (uint32_t b=0 ; b<256 ; b++) {
+      ioTable [k][b] = ioTable [0][ioTable [k-1][b]] ; // One more zero byte
+    }
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void buildCRC16Table (uint16_t ioTable [4][256], const uint16_t inPolynomial) {
+  for (uint32_t b=0 ; b<256 ; b++) {
+    uint16_t crc = (uint16_t) (b << 8) ;
+    for (uint8_t bit=0 ; bit<8 ; bit++) {
+      crc = (crc & 0x8000) ? (uint16_t) ((crc << 1) ^ inPolynomial) : (uint16_t) (crc << 1) ;
+    }
+    ioTable [0][b] = crc ;
+  }
+  for (uint32_t k=1 ; k<4 ; k++) {
+    for (uint32_t b=0 ; b<256 ; b++) {
+      const uint16_t previous = ioTable [k-1][b] ;
+      ioTable [k][b] = (uint16_t) ((previous << 8) ^ ioTable [0][previous >> 8]) ;
+    }
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ACANCRC::begin (void) {
+  if (!gCRCTablesReady) {
+    buildCRC8Table (gCRC8SAEJ1850Table, 0x1D) ;
+    buildCRC8Table (gCRC8H2FTable, 0x2F) ;
+    buildCRC16Table (gCRC16CCITTTable, 0x1021) ;
+    gCRCTablesReady = true ;
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   SLICE-BY-4
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static inline uint8_t crc8 (const uint8_t inTable [4][256],
+                            const uint8_t * inData,
+                            const uint32_t inLength,
+                            const uint8_t inCRC) {
+  uint8_t crc = inCRC ;
+  uint32_t length = inLength ;
+  while (length >= 4) {
+    crc = inTable [3][inData [0] ^ crc] ^ inTable [2][inData [1]] ^ inTable [1][inData [2]] ^ inTable [0][inData [3]] ;
+    inData += 4 ;
+    length -= 4 ;
+  }
+  while (length > 0) {
+    crc = inTable [0][*inData ^ crc] ;
+    inData += 1 ;
+    length -= 1 ;
+  }
+  return crc ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+uint8_t ACANCRC::crc8SAEJ1850 (const uint8_t * inData, const uint32_t inLength, const uint8_t inCRC) {
+  return crc8 (gCRC8SAEJ1850Table, inData, inLength, inCRC) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+uint8_t ACANCRC::crc8H2F (const uint8_t * inData, const uint32_t inLength, const uint8_t inCRC) {
+  return crc8 (gCRC8H2FTable, inData, inLength, inCRC) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+uint16_t ACANCRC::crc16CCITT (const uint8_t * inData, const uint32_t inLength, const uint16_t inCRC) {
+  const uint16_t (* table) [256] = gCRC16CCITTTable ;
+  uint16_t crc = inCRC ;
+  uint32_t length = inLength ;
+  while (length >= 4) {
+    crc = table [3][inData [0] ^ (crc >> 8)] ^ table [2][inData [1] ^ (crc & 0xFF)]
+        ^ table [1][inData [2]] ^ table [0][inData [3]] ;
+    inData += 4 ;
+    length -= 4 ;
+  }
+  while (length > 0) {
+    crc = (uint16_t) ((crc << 8) ^ table [0][*inData ^ (crc >> 8)]) ;
+    inData += 1 ;
+    length -= 1 ;
+  }
+  return crc ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   PROFILE LAYOUT HELPERS
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static inline uint32_t channelKey (const ACANE2EChannel & inChannel) {
+  return inChannel.mIdentifier | (inChannel.mExtended ? EXTENDED_BIT : 0) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static inline uint16_t counterModulus (const ACANE2EChannel & inChannel) {
+  uint16_t result = 256 ;
+  switch (inChannel.mProfile) {
+  case ACANE2EChannel::kProfile01 : result = 15 ; break ;
+  case ACANE2EChannel::kProfile02 : result = 16 ; break ;
+  case ACANE2EChannel::kProfile05 : result = 256 ; break ;
+  }
+  return result ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static inline uint8_t counterByteIndex (const ACANE2EChannel & inChannel) {
+  uint8_t result = 1 ;
+  switch (inChannel.mProfile) {
+  case ACANE2EChannel::kProfile01 : result = inChannel.mCounterOffset ; break ;
+  case ACANE2EChannel::kProfile02 : result = 1 ; break ;
+  case ACANE2EChannel::kProfile05 : result = (uint8_t) (inChannel.mCRCOffset + 2) ; break ;
+  }
+  return result ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static inline uint8_t readCounter (const ACANE2EChannel & inChannel, const CANMessage & inFrame) {
+  const uint8_t byte = inFrame.data [counterByteIndex (inChannel)] ;
+  return (inChannel.mProfile == ACANE2EChannel::kProfile05) ? byte : (byte & 0x0F) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   CONSTRUCTOR
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+ACANE2E::ACANE2E (void) :
+mChannels (nullptr),
+mChannelCount (0),
+mSettings () {
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   INITIALISATION
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+uint32_t ACANE2E::begin (ACANE2EChannel * inChannels,
+                         const uint16_t inChannelCount,
+                         const ACANE2EStateMachineSettings & inSettings) {
+  uint32_t errorCode = 0 ;
+  ACANCRC::begin () ;
+//--- Insertion sort by identifier, for binary search
+  for (uint16_t i=1 ; i<inChannelCount ; i++) {
+    const ACANE2EChannel channel = inChannels [i] ;
+    uint16_t j = i ;
+    while ((j > 0) && (channelKey (inChannels [j-1]) > channelKey (channel))) {
+      inChannels [j] = inChannels [j-1] ;
+      j -= 1 ;
+    }
+    inChannels [j] = channel ;
+  }
+//--- Check layouts, reset sequence state
+  for (uint16_t i=0 ; i<inChannelCount ; i++) {
+    ACANE2EChannel & channel = inChannels [i] ;
+    if ((i > 0) && (channelKey (inChannels [i-1]) == channelKey (channel))) {
+      errorCode |= kDuplicateIdentifier ;
+    }
+    if (channel.mLength > 8) {
+      errorCode |= kInvalidLength ;
+    }
+    switch (channel.mProfile) {
+    case ACANE2EChannel::kProfile01 :
+      if ((channel.mCRCOffset >= channel.mLength) || (channel.mCounterOffset >= channel.mLength)
+       || (channel.mCRCOffset == channel.mCounterOffset)) {
+        errorCode |= kInvalidOffset ;
+      }
+      break ;
+    case ACANE2EChannel::kProfile02 :
+      if (channel.mLength < 2) {
+        errorCode |= kInvalidLength ;
+      }
+      if (channel.mDataIDList == nullptr) {
+        errorCode |= kNoDataIDList ;
+      }
+      break ;
+    case ACANE2EChannel::kProfile05 :
+      if ((channel.mCRCOffset + 3) > channel.mLength) {
+        errorCode |= kInvalidOffset ;
+      }
+      break ;
+    }
+    if ((channel.mMaxDeltaCounter == 0) || (channel.mMaxDeltaCounter >= counterModulus (channel))) {
+      errorCode |= kInvalidMaxDeltaCounter ;
+    }
+    channel.mSendCounter = 0 ;
+    channel.mLastCounter = (uint8_t) (counterModulus (channel) - 1) ; // Profile 5: a first counter 0 is ok
+    channel.mAllowedDelta = channel.mMaxDeltaCounter ;
+    channel.mWaitForFirstData = channel.mProfile != ACANE2EChannel::kProfile05 ;
+    channel.mStatus = kE2ENoNewData ;
+    channel.mLostCount = 0 ;
+    channel.mState = kE2EStateNoData ;
+    channel.mOkWindow = 0 ;
+    channel.mErrorWindow = 0 ;
+    channel.mCheckCount = 0 ;
+    channel.mErrorCount = 0 ;
+  }
+  if ((inSettings.mWindowSize == 0) || (inSettings.mWindowSize > 32)) {
+    errorCode |= kInvalidWindowSize ;
+  }
+  if (errorCode == 0) {
+    mChannels = inChannels ;
+    mChannelCount = inChannelCount ;
+    mSettings = inSettings ;
+  }else{
+    mChannels = nullptr ;
+    mChannelCount = 0 ;
+  }
+  return errorCode ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   CHANNEL LOOKUP (binary search)
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+uint16_t ACANE2E::channelIndex (const uint32_t inIdentifier, const bool inExtended) const {
+  const uint32_t key = inIdentifier | (inExtended ? EXTENDED_BIT : 0) ;
+  uint16_t low = 0 ;
+  uint16_t high = mChannelCount ;
+  while (low < high) {
+    const uint16_t middle = (low + high) / 2 ;
+    if (channelKey (mChannels [middle]) < key) {
+      low = middle + 1 ;
+    }else{
+      high = middle ;
+    }
+  }
+  return ((low < mChannelCount) && (channelKey (mChannels [low]) == key)) ? low : kNoChannel ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   CRC OF A FRAME
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+// Profile 1: CRC-8 SAE J1850 with start value 0 and no final XOR (AUTOSAR Crc_CalculateCRC8 chained from 0xFF, the
+// result XORed with 0xFF). Profile 2: CRC8H2F, start value 0xFF, final XOR 0xFF.
+
+uint8_t ACANE2E::computeCRC8 (const ACANE2EChannel & inChannel,
+                              const CANMessage & inFrame,
+                              const uint8_t inCounter) const {
+  uint8_t crc ;
+  if (inChannel.mProfile == ACANE2EChannel::kProfile01) {
+    const uint8_t dataID [2] = {(uint8_t) inChannel.mDataID, (uint8_t) (inChannel.mDataID >> 8)} ;
+    switch (inChannel.mDataIDMode) {
+    case ACANE2EChannel::kDataIDBoth :
+      crc = ACANCRC::crc8SAEJ1850 (dataID, 2, 0x00) ;
+      break ;
+    case ACANE2EChannel::kDataIDAlternating :
+      crc = ACANCRC::crc8SAEJ1850 (&dataID [inCounter & 1], 1, 0x00) ;
+      break ;
+    default : // kDataIDLow
+      crc = ACANCRC::crc8SAEJ1850 (dataID, 1, 0x00) ;
+      break ;
+    }
+    const uint8_t offset = inChannel.mCRCOffset ;
+    crc = ACANCRC::crc8SAEJ1850 (inFrame.data, offset, crc) ;
+    crc = ACANCRC::crc8SAEJ1850 (&inFrame.data [offset + 1], inChannel.mLength - offset - 1U, crc) ;
+  }else{ // Profile 2
+    crc = ACANCRC::crc8H2F (&inFrame.data [1], inChannel.mLength - 1U, 0xFF) ;
+    crc = ACANCRC::crc8H2F (&inChannel.mDataIDList [inCounter], 1, crc) ;
+    crc ^= 0xFF ;
+  }
+  return crc ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+// Profile 5: CRC-16 CCITT, start value 0xFFFF, no final XOR
+
+uint16_t ACANE2E::computeCRC16 (const ACANE2EChannel & inChannel, const CANMessage & inFrame) const {
+  const uint8_t offset = inChannel.mCRCOffset ;
+  const uint8_t dataID [2] = {(uint8_t) inChannel.mDataID, (uint8_t) (inChannel.mDataID >> 8)} ;
+  uint16_t crc = ACANCRC::crc16CCITT (inFrame.data, offset, 0xFFFF) ;
+  crc = ACANCRC::crc16CCITT (&inFrame.data [offset + 2], inChannel.mLength - offset - 2U, crc) ;
+  return ACANCRC::crc16CCITT (dataID, 2, crc) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   PROTECTION
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+uint16_t ACANE2E::protect (CANMessage & ioFrame) const {
+  const uint16_t index = channelIndex (ioFrame.id, ioFrame.ext) ;
+  if (index != kNoChannel) {
+    const ACANE2EChannel & channel = mChannels [index] ;
+    const uint8_t counter = channel.mSendCounter ;
+    ioFrame.len = channel.mLength ;
+    ioFrame.rtr = false ;
+    switch (channel.mProfile) {
+    case ACANE2EChannel::kProfile01 :
+      ioFrame.data [channel.mCounterOffset] = (uint8_t) ((ioFrame.data [channel.mCounterOffset] & 0xF0) | counter) ;
+      ioFrame.data [channel.mCRCOffset] = computeCRC8 (channel, ioFrame, counter) ;
+      break ;
+    case ACANE2EChannel::kProfile02 :
+      ioFrame.data [1] = (uint8_t) ((ioFrame.data [1] & 0xF0) | counter) ;
+      ioFrame.data [0] = computeCRC8 (channel, ioFrame, counter) ;
+      break ;
+    case ACANE2EChannel::kProfile05 :
+      { ioFrame.data [channel.mCRCOffset + 2] = counter ;
+        const uint16_t crc = computeCRC16 (channel, ioFrame) ;
+        ioFrame.data [channel.mCRCOffset] = (uint8_t) crc ;
+        ioFrame.data [channel.mCRCOffset + 1] = (uint8_t) (crc >> 8) ;
+      }
+      break ;
+    }
+  }
+  return index ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ACANE2E::advanceCounter (const uint16_t inChannelIndex) {
+  ACANE2EChannel & channel = mChannels [inChannelIndex] ;
+  const uint16_t next = channel.mSendCounter + 1U ;
+  channel.mSendCounter = (uint8_t) ((next < counterModulus (channel)) ? next : 0) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   CHECK
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+// Unprotected identifiers: outChannelIndex is kNoChannel and the returned status is kE2EOk.
+
+ACANE2EStatus ACANE2E::check (const CANMessage & inFrame, uint16_t & outChannelIndex) {
+  const uint16_t index = channelIndex (inFrame.id, inFrame.ext) ;
+  outChannelIndex = index ;
+  ACANE2EStatus status = kE2EOk ;
+  if (index != kNoChannel) {
+    ACANE2EChannel & channel = mChannels [index] ;
+    channel.mCheckCount += 1 ;
+    if ((inFrame.len != channel.mLength) || inFrame.rtr) {
+      status = kE2EWrongLength ;
+    }else{
+      const uint8_t counter = readCounter (channel, inFrame) ;
+      bool crcOk ;
+      if (channel.mProfile == ACANE2EChannel::kProfile05) {
+        const uint16_t crc = (uint16_t) (inFrame.data [channel.mCRCOffset] | (inFrame.data [channel.mCRCOffset + 1] << 8)) ;
+        crcOk = crc == computeCRC16 (channel, inFrame) ;
+      }else{
+        const uint8_t crcOffset = (channel.mProfile == ACANE2EChannel::kProfile01) ? channel.mCRCOffset : 0 ;
+        crcOk = (counter < counterModulus (channel)) && (inFrame.data [crcOffset] == computeCRC8 (channel, inFrame, counter)) ;
+      }
+      if (!crcOk) {
+        status = kE2EWrongCRC ;
+      }else if (channel.mWaitForFirstData) {
+        status = kE2EInitial ;
+        channel.mWaitForFirstData = false ;
+      }else{
+        const uint16_t modulus = counterModulus (channel) ;
+        const uint16_t delta = (uint16_t) ((counter + modulus - channel.mLastCounter) % modulus) ;
+        if (delta == 0) {
+          status = kE2ERepeated ;
+        }else if (delta == 1) {
+          status = kE2EOk ;
+        }else if (delta <= channel.mAllowedDelta) {
+          status = kE2EOkSomeLost ;
+          channel.mLostCount = (uint8_t) (delta - 1) ;
+        }else{
+          status = kE2EWrongSequence ;
+        }
+        if ((status == kE2EOk) || (status == kE2EOkSomeLost)) {
+          channel.mAllowedDelta = channel.mMaxDeltaCounter ;
+        }
+      }
+      if (crcOk) {
+        channel.mLastCounter = counter ;
+      }
+    }
+    if ((status == kE2EWrongCRC) || (status == kE2EWrongLength)) {
+      channel.mErrorCount += 1 ;
+    }
+    updateStateMachine (channel, status) ;
+  }
+  return status ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ACANE2E::noNewData (const uint16_t inChannelIndex) {
+  ACANE2EChannel & channel = mChannels [inChannelIndex] ;
+  const uint16_t maxDelta = counterModulus (channel) - 1U ;
+  if (channel.mAllowedDelta < maxDelta) {
+    channel.mAllowedDelta += 1 ;
+  }
+  updateStateMachine (channel, kE2ENoNewData) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   STATE MACHINE
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+// Ok and ok-some-lost count as ok, wrong CRC and wrong length as errors; repeated, wrong sequence, initial and no new
+// data as neither.
+
+void ACANE2E::updateStateMachine (ACANE2EChannel & ioChannel, const ACANE2EStatus inStatus) {
+  ioChannel.mStatus = inStatus ;
+  const bool error = (inStatus == kE2EWrongCRC) || (inStatus == kE2EWrongLength) ;
+  if (ioChannel.mState == kE2EStateNoData) {
+    if (!error && (inStatus != kE2ENoNewData)) {
+      ioChannel.mState = kE2EStateInit ;
+    }
+  }else{
+    const bool ok = (inStatus == kE2EOk) || (inStatus == kE2EOkSomeLost) ;
+    const uint32_t mask = (mSettings.mWindowSize < 32) ? ((1UL << mSettings.mWindowSize) - 1) : UINT32_MAX ;
+    ioChannel.mOkWindow = ((ioChannel.mOkWindow << 1) | (ok ? 1 : 0)) & mask ;
+    ioChannel.mErrorWindow = ((ioChannel.mErrorWindow << 1) | (error ? 1 : 0)) & mask ;
+    const uint32_t okCount = (uint32_t) __builtin_popcount (ioChannel.mOkWindow) ;
+    const uint32_t errorCount = (uint32_t) __builtin_popcount (ioChannel.mErrorWindow) ;
+    switch (ioChannel.mState) {
+    case kE2EStateInit :
+      if ((errorCount <= mSettings.mMaxErrorStateInit) && (okCount >= mSettings.mMinOkStateInit)) {
+        ioChannel.mState = kE2EStateValid ;
+      }else if (errorCount > mSettings.mMaxErrorStateInit) {
+        ioChannel.mState = kE2EStateInvalid ;
+      }
+      break ;
+    case kE2EStateValid :
+      if ((errorCount > mSettings.mMaxErrorStateValid) || (okCount < mSettings.mMinOkStateValid)) {
+        ioChannel.mState = kE2EStateInvalid ;
+      }
+      break ;
+    case kE2EStateInvalid :
+      if ((errorCount <= mSettings.mMaxErrorStateInvalid) && (okCount >= mSettings.mMinOkStateInvalid)) {
+        ioChannel.mState = kE2EStateValid ;
+      }
+      break ;
+    default :
+      break ;
+    }
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
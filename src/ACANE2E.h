@@ -0,0 +1,244 @@
+/******************************************************************************/
+/* File name        : ACANE2E.h                                               */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Description      : End-to-end protection (AUTOSAR E2E profiles 1, 2, 5)    */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation                                                        */
+/* ---------------------------------------------------------------------------*/
+
+#ifndef ACAN_E2E_CLASS_DEFINED
+#define ACAN_E2E_CLASS_DEFINED
+
+/*------------------------------- Include files ------------------------------*/
+#include "CANMessage.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+//   CRC, slice-by-4
+//----------------------------------------------------------------------------------------------------------------------
+// Four 256-entry tables per polynomial: table k gives the CRC of a byte followed by k zero bytes, so four bytes are
+// folded with four independent lookups instead of four dependent ones (or 32 bit steps). The tables are built in RAM by
+// begin (4 KB), flash reads would go through the cache. All CRCs are MSB first; the functions take and return the
+// raw register (no initial value, no final XOR), so that calls can be chained.
+
+class ACANCRC {
+
+  public: static void begin (void) ;
+
+  //--- CRC-8 SAE J1850, polynomial 0x1D (E2E profile 1)
+  public: static uint8_t crc8SAEJ1850 (const uint8_t * inData, const uint32_t inLength, const uint8_t inCRC) ;
+
+  //--- CRC-8 0x2F (AUTOSAR CRC8H2F, E2E profile 2)
+  public: static uint8_t crc8H2F (const uint8_t * inData, const uint32_t inLength, const uint8_t inCRC) ;
+
+  //--- CRC-16 CCITT, polynomial 0x1021 (E2E profile 5)
+  public: static uint16_t crc16CCITT (const uint8_t * inData, const uint32_t inLength, const uint16_t inCRC) ;
+} ;
+
+//----------------------------------------------------------------------------------------------------------------------
+//   Check status of a received frame
+//----------------------------------------------------------------------------------------------------------------------
+
+typedef enum : uint8_t {
+  kE2EOk,               // Counter incremented by 1
+  kE2EOkSomeLost,       // Counter incremented by 2 ... max delta counter
+  kE2EInitial,          // First frame (profiles 1 and 2): counter accepted without check
+  kE2ERepeated,         // Same counter as the previous frame
+  kE2EWrongSequence,    // Counter incremented by more than the allowed delta (the counter is resynchronised)
+  kE2EWrongCRC,
+  kE2EWrongLength,
+  kE2ENoNewData         // No frame received since the previous cycle (see ACANE2E::noNewData)
+} ACANE2EStatus ;
+
+//----------------------------------------------------------------------------------------------------------------------
+//   State machine (AUTOSAR E2E_SM): validity of a data stream from the statuses of the last frames
+//----------------------------------------------------------------------------------------------------------------------
+
+typedef enum : uint8_t {
+  kE2EStateNoData,      // Nothing valid received yet
+  kE2EStateInit,        // Collecting the first statuses
+  kE2EStateValid,
+  kE2EStateInvalid
+} ACANE2EState ;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+class ACANE2EStateMachineSettings {
+  public: uint8_t mWindowSize = 3 ;           // 1 ... 32 last statuses
+  public: uint8_t mMinOkStateInit = 2 ;
+  public: uint8_t mMaxErrorStateInit = 0 ;
+  public: uint8_t mMinOkStateValid = 1 ;
+  public: uint8_t mMaxErrorStateValid = 1 ;
+  public: uint8_t mMinOkStateInvalid = 2 ;
+  public: uint8_t mMaxErrorStateInvalid = 0 ;
+} ;
+
+//----------------------------------------------------------------------------------------------------------------------
+//   Protected identifier: configuration and sequence state (storage provided by the application)
+//----------------------------------------------------------------------------------------------------------------------
+// Layouts, offsets in bytes of CANMessage::data:
+//   profile 1: CRC-8 SAE J1850 at mCRCOffset, 4-bit counter (0 ... 14) in the low nibble of mCounterOffset. The CRC
+//              covers the data identifier (both bytes, alternating by counter parity or low byte only, mDataIDMode)
+//              and the data bytes except the CRC.
+//   profile 2: CRC-8 0x2F at byte 0, 4-bit counter (0 ... 15) in the low nibble of byte 1. The CRC covers bytes
+//              1 ... mLength-1 and mDataIDList [counter].
+//   profile 5: CRC-16 CCITT at mCRCOffset (little endian), 8-bit counter at mCRCOffset + 2. The CRC covers the data
+//              bytes except the CRC, and the data identifier (low byte, then high byte).
+
+class ACANE2EChannel {
+  public: typedef enum : uint8_t {
+    kProfile01,
+    kProfile02,
+    kProfile05
+  } Profile ;
+
+  public: typedef enum : uint8_t {
+    kDataIDBoth,
+    kDataIDAlternating,
+    kDataIDLow
+  } DataIDMode ;
+
+//--- Configuration
+  public: uint32_t mIdentifier = 0 ;
+  public: bool mExtended = false ;
+  public: Profile mProfile = kProfile05 ;
+  public: uint8_t mLength = 8 ;                     // Protected frames have exactly this length
+  public: uint8_t mCRCOffset = 0 ;                  // Profiles 1 and 5
+  public: uint8_t mCounterOffset = 1 ;              // Profile 1
+  public: uint16_t mDataID = 0 ;                    // Profiles 1 and 5
+  public: DataIDMode mDataIDMode = kDataIDBoth ;    // Profile 1
+  public: const uint8_t * mDataIDList = nullptr ;   // Profile 2: 16 entries, indexed by counter
+  public: uint8_t mMaxDeltaCounter = 1 ;            // Accepted counter increment, 1: no frame may be lost
+
+//--- Sender state
+  public: uint8_t mSendCounter = 0 ;
+
+//--- Receiver state
+  public: uint8_t mLastCounter = 0 ;
+  public: uint8_t mAllowedDelta = 1 ;               // Grows by one on every cycle without a frame (noNewData)
+  public: bool mWaitForFirstData = true ;
+  public: ACANE2EStatus mStatus = kE2ENoNewData ;   // Of the last check
+  public: uint8_t mLostCount = 0 ;                  // Frames lost before the last kE2EOkSomeLost one
+  public: ACANE2EState mState = kE2EStateNoData ;
+  public: uint32_t mOkWindow = 0 ;                  // Bit 0: last status, set if ok
+  public: uint32_t mErrorWindow = 0 ;               // Bit 0: last status, set if error
+  public: uint32_t mCheckCount = 0 ;
+  public: uint32_t mErrorCount = 0 ;                // Wrong CRC or length
+} ;
+
+//----------------------------------------------------------------------------------------------------------------------
+//   E2E engine
+//----------------------------------------------------------------------------------------------------------------------
+// Channels are sorted by identifier by begin, frames are matched by binary search. Protection and check work on
+// CANMessage::data, inline with the driver:
+//   e2e.tryToSend (can, frame) ;            // Writes counter and CRC, the counter advances only if the frame is sent
+//   ACANE2EStatus status ;
+//   uint16_t channel ;
+//   while (e2e.receive (can, frame, channel, status)) {
+//     if (channel != ACANE2E::kNoChannel) {
+//       ... e2e.channel (channel).mState == kE2EStateValid ...
+//     }
+//   }
+// Frames with an unprotected identifier go through unchanged. A cycle without a frame is reported with noNewData.
+
+class ACANE2E {
+
+//······················································································································
+//   CONSTRUCTOR
+//······················································································································
+
+  public: ACANE2E (void) ;
+
+//······················································································································
+//   Initialisation: returns 0 if ok, otherwise see error codes below
+//······················································································································
+
+  public: uint32_t begin (ACANE2EChannel * inChannels,
+                          const uint16_t inChannelCount,
+                          const ACANE2EStateMachineSettings & inSettings = ACANE2EStateMachineSettings ()) ;
+
+  public: static const uint32_t kDuplicateIdentifier      = 1 << 0 ;
+  public: static const uint32_t kInvalidLength            = 1 << 1 ;
+  public: static const uint32_t kInvalidOffset            = 1 << 2 ;
+  public: static const uint32_t kNoDataIDList             = 1 << 3 ;
+  public: static const uint32_t kInvalidWindowSize        = 1 << 4 ;
+  public: static const uint32_t kInvalidMaxDeltaCounter   = 1 << 5 ;
+
+//······················································································································
+//   Channels
+//······················································································································
+
+  public: static const uint16_t kNoChannel = 0xFFFF ;
+
+  public: uint16_t channelIndex (const uint32_t inIdentifier, const bool inExtended) const ;
+
+  public: inline uint16_t channelCount (void) const { return mChannelCount ; }
+  public: inline ACANE2EChannel & channel (const uint16_t inIndex) { return mChannels [inIndex] ; }
+  public: inline const ACANE2EChannel & channel (const uint16_t inIndex) const { return mChannels [inIndex] ; }
+
+//······················································································································
+//   Protection: protect writes the current counter and the CRC, advanceCounter moves to the next counter
+//······················································································································
+
+  public: uint16_t protect (CANMessage & ioFrame) const ; // Returns the channel index, or kNoChannel
+
+  public: void advanceCounter (const uint16_t inChannelIndex) ;
+
+  public: template <typename DRIVER> bool tryToSend (DRIVER & inDriver, CANMessage & ioFrame) {
+    const uint16_t index = protect (ioFrame) ;
+    const bool sent = inDriver.tryToSend (ioFrame) ;
+    if (sent && (index != kNoChannel)) {
+      advanceCounter (index) ;
+    }
+    return sent ;
+  }
+
+//······················································································································
+//   Check: updates the sequence state and the state machine of the channel
+//······················································································································
+
+  public: ACANE2EStatus check (const CANMessage & inFrame, uint16_t & outChannelIndex) ;
+
+  public: void noNewData (const uint16_t inChannelIndex) ;
+
+  public: template <typename DRIVER> bool receive (DRIVER & inDriver,
+                                                   CANMessage & outFrame,
+                                                   uint16_t & outChannelIndex,
+                                                   ACANE2EStatus & outStatus) {
+    const bool received = inDriver.receive (outFrame) ;
+    if (received) {
+      outStatus = check (outFrame, outChannelIndex) ;
+    }
+    return received ;
+  }
+
+//······················································································································
+//   Private
+//······················································································································
+
+  private: uint8_t computeCRC8 (const ACANE2EChannel & inChannel, const CANMessage & inFrame, const uint8_t inCounter) const ;
+  private: uint16_t computeCRC16 (const ACANE2EChannel & inChannel, const CANMessage & inFrame) const ;
+  private: void updateStateMachine (ACANE2EChannel & ioChannel, const ACANE2EStatus inStatus) ;
+
+  private: ACANE2EChannel * mChannels ;
+  private: uint16_t mChannelCount ;
+  private: ACANE2EStateMachineSettings mSettings ;
+
+//······················································································································
+//   No copy
+//······················································································································
+
+  private: ACANE2E (const ACANE2E &) = delete ;
+  private: ACANE2E & operator = (const ACANE2E &) = delete ;
+} ;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,251 @@
+/******************************************************************************/
+/* File name        : ACANGateway.cpp                                         */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Description      : CAN gateway between two (or more) CAN drivers           */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation                                                        */
+/* ---------------------------------------------------------------------------*/
+
+/*------------------------------- Include files ------------------------------*/
+#include "ACANGateway.h"
+
+/*------------------------------- Local defines ------------------------------*/
+#define EXTENDED_BIT      (0x80000000UL)
+#define DEFAULT_HOLD_TIME (1000)   // µs
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   CONSTRUCTOR
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+ACANGateway::ACANGateway (void) :
+mPorts (),
+mRoutes (nullptr),
+mStatistics (nullptr),
+mRouteCapacity (0),
+mRouteCount (0),
+mPortCount (0),
+mPolled (false),
+mPreviousPollDate (0),
+mHoldTime (DEFAULT_HOLD_TIME) {
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+ACANGateway::~ ACANGateway (void) {
+  delete [] mRoutes ;
+  delete [] mStatistics ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   INITIALISATION
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+bool ACANGateway::initWithCapacity (const uint16_t inRouteCapacity) {
+  delete [] mRoutes ;
+  delete [] mStatistics ;
+  mRoutes = new Route [inRouteCapacity] ;
+  mStatistics = new ACANGatewayRouteStatistics [inRouteCapacity] ;
+  const bool ok = (mRoutes != nullptr) && (mStatistics != nullptr) ;
+  if (!ok) {
+    delete [] mRoutes ; mRoutes = nullptr ;
+    delete [] mStatistics ; mStatistics = nullptr ;
+  }
+  mRouteCapacity = ok ? inRouteCapacity : 0 ;
+  mRouteCount = 0 ;
+  return ok ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   PORTS
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+uint8_t ACANGateway::addPort (void * inDriver,
+                              ACANGatewayPeekRoutine inPeek,
+                              ACANGatewayReleaseRoutine inRelease,
+                              ACANGatewaySendRoutine inSend) {
+  uint8_t port = kInvalidPort ;
+  if (mPortCount < kMaxPortCount) {
+    port = mPortCount ;
+    mPortCount += 1 ;
+    ACANGatewayPort & p = mPorts [port] ;
+    p.mDriver = inDriver ;
+    p.mPeek = inPeek ;
+    p.mRelease = inRelease ;
+    p.mSend = inSend ;
+    p.mHolding = false ;
+    p.mBlocked = false ;
+    p.mUnroutedCount = 0 ;
+  }
+  return port ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ACANGateway::releaseHeldFrame (ACANGatewayPort & ioPort) {
+  ioPort.mHolding = false ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   ROUTES
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+uint16_t ACANGateway::addRoute (const uint8_t inSource,
+                                const uint8_t inDestination,
+                                const uint32_t inFirst,
+                                const uint32_t inLast,
+                                const bool inExtended,
+                                const uint32_t inRewriteKey) {
+  const uint32_t first = key (inFirst, inExtended) ;
+  const uint32_t last = key (inLast, inExtended) ;
+  const uint32_t identifierMask = inExtended ? 0x1FFFFFFFUL : 0x7FFUL ;
+  bool ok = (mRouteCount < mRouteCapacity)
+    && (inSource < mPortCount) && (inDestination < mPortCount) && (inSource != inDestination)
+    && ((inFirst & ~identifierMask) == 0) && ((inLast & ~identifierMask) == 0) && (first <= last) ;
+  if (ok && (inRewriteKey != kNoRewrite)) {
+    const uint32_t rewriteMask = ((inRewriteKey & EXTENDED_BIT) != 0) ? 0x1FFFFFFFUL : 0x7FFUL ;
+    const uint32_t rewriteLast = (inRewriteKey & ~EXTENDED_BIT) + (inLast - inFirst) ;
+    ok = rewriteLast <= rewriteMask ;
+  }
+//--- Insertion place, ranges of a source must not overlap
+  uint16_t place = 0 ;
+  while (ok && (place < mRouteCount)
+              && ((mRoutes [place].mSource < inSource)
+              || ((mRoutes [place].mSource == inSource) && (mRoutes [place].mLast < first)))) {
+    place += 1 ;
+  }
+  if (ok && (place < mRouteCount) && (mRoutes [place].mSource == inSource)) {
+    ok = last < mRoutes [place].mFirst ;
+  }
+  uint16_t result = kInvalidRoute ;
+  if (ok) {
+    for (uint16_t i=mRouteCount ; i>place ; i--) {
+      mRoutes [i] = mRoutes [i-1] ;
+    }
+    Route & route = mRoutes [place] ;
+    route.mFirst = first ;
+    route.mLast = last ;
+    route.mRewriteKey = inRewriteKey ;
+    route.mIndex = mRouteCount ;
+    route.mSource = inSource ;
+    route.mDestination = inDestination ;
+    mStatistics [mRouteCount] = ACANGatewayRouteStatistics () ;
+    result = mRouteCount ;
+    mRouteCount += 1 ;
+  }
+  return result ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+// Binary search of the last route whose (source, first) is lower than or equal to (inSource, inKey)
+
+uint16_t ACANGateway::findRoute (const uint8_t inSource, const uint32_t inKey) const {
+  uint16_t low = 0 ;
+  uint16_t high = mRouteCount ;
+  while (low < high) {
+    const uint16_t middle = (low + high) / 2 ;
+    const Route & route = mRoutes [middle] ;
+    if ((route.mSource < inSource) || ((route.mSource == inSource) && (route.mFirst <= inKey))) {
+      low = middle + 1 ;
+    }else{
+      high = middle ;
+    }
+  }
+  uint16_t result = kInvalidRoute ;
+  if (low > 0) {
+    const Route & route = mRoutes [low - 1] ;
+    if ((route.mSource == inSource) && (inKey <= route.mLast)) {
+      result = low - 1 ;
+    }
+  }
+  return result ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   STATISTICS
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+const ACANGatewayRouteStatistics & ACANGateway::routeStatistics (const uint16_t inRoute) const {
+  return mStatistics [inRoute] ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ACANGateway::resetStatistics (void) {
+  for (uint16_t i=0 ; i<mRouteCount ; i++) {
+    mStatistics [i] = ACANGatewayRouteStatistics () ;
+  }
+  for (uint8_t p=0 ; p<mPortCount ; p++) {
+    mPorts [p].mUnroutedCount = 0 ;
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   FORWARDING
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ACANGateway::poll (const uint32_t inNowMicros) {
+  const uint32_t arrivalDate = mPolled ? mPreviousPollDate : inNowMicros ;
+  for (uint8_t p=0 ; p<mPortCount ; p++) {
+    ACANGatewayPort & port = mPorts [p] ;
+  //--- Frames queued behind a blocked frame may have arrived since it arrived
+    const uint32_t arrival = port.mBlocked ? port.mArrivalDate : arrivalDate ;
+    bool loop = true ;
+    while (loop) {
+      const CANMessage * frame = port.mPeek (port) ;
+      loop = frame != nullptr ;
+      if (loop) {
+        const uint32_t frameKey = key (frame->id, frame->ext) ;
+        const uint16_t r = findRoute (p, frameKey) ;
+        if (r == kInvalidRoute) {
+          port.mUnroutedCount += 1 ;
+          port.mRelease (port) ;
+        }else{
+          const Route & route = mRoutes [r] ;
+          ACANGatewayRouteStatistics & statistics = mStatistics [route.mIndex] ;
+          ACANGatewayPort & destination = mPorts [route.mDestination] ;
+          bool sent ;
+          if (route.mRewriteKey == kNoRewrite) {
+            sent = destination.mSend (destination.mDriver, *frame) ;
+          }else{
+            CANMessage rewritten = *frame ;
+            const uint32_t rewrittenKey = route.mRewriteKey + (frameKey - route.mFirst) ;
+            rewritten.id = rewrittenKey & ~EXTENDED_BIT ;
+            rewritten.ext = (rewrittenKey & EXTENDED_BIT) != 0 ;
+            sent = destination.mSend (destination.mDriver, rewritten) ;
+          }
+          const uint32_t latency = inNowMicros - arrival ;
+          if (sent) {
+            port.mRelease (port) ;
+            port.mBlocked = false ;
+            statistics.mForwardedCount += 1 ;
+            statistics.mLatencySum += latency ;
+            if (statistics.mMaxLatency < latency) {
+              statistics.mMaxLatency = latency ;
+            }
+          }else if (latency >= mHoldTime) {
+            port.mRelease (port) ;
+            port.mBlocked = false ;
+            statistics.mDroppedCount += 1 ;
+          }else{ // Wait for the destination, the frame stays at the head of the port
+            port.mBlocked = true ;
+            port.mArrivalDate = arrival ;
+            statistics.mBackpressureCount += 1 ;
+            loop = false ;
+          }
+        }
+      }
+    }
+  }
+  mPreviousPollDate = inNowMicros ;
+  mPolled = true ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
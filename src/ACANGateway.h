@@ -0,0 +1,235 @@
+/******************************************************************************/
+/* File name        : ACANGateway.h                                           */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Description      : CAN gateway between two (or more) CAN drivers           */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation                                                        */
+/* ---------------------------------------------------------------------------*/
+
+#ifndef ACAN_GATEWAY_CLASS_DEFINED
+#define ACAN_GATEWAY_CLASS_DEFINED
+
+/*------------------------------- Include files ------------------------------*/
+#include "CANMessage.h"
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   Statistics of a route
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+class ACANGatewayRouteStatistics {
+  public: uint32_t mForwardedCount = 0 ;     // Frames accepted by the destination driver
+  public: uint32_t mDroppedCount = 0 ;       // Frames refused by the destination for longer than the hold time
+  public: uint32_t mBackpressureCount = 0 ;  // Polls that found the destination driver full
+  public: uint32_t mMaxLatency = 0 ;         // µs, see ACANGateway::poll
+  public: uint64_t mLatencySum = 0 ;         // µs, mean = mLatencySum / mForwardedCount
+} ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   Gateway port: one CAN driver
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+class ACANGatewayPort ;
+
+typedef const CANMessage * (*ACANGatewayPeekRoutine) (ACANGatewayPort & ioPort) ;
+typedef void (*ACANGatewayReleaseRoutine) (ACANGatewayPort & ioPort) ;
+typedef bool (*ACANGatewaySendRoutine) (void * inDriver, const CANMessage & inMessage) ;
+
+class ACANGatewayPort {
+  public: void * mDriver = nullptr ;
+  public: ACANGatewayPeekRoutine mPeek = nullptr ;
+  public: ACANGatewayReleaseRoutine mRelease = nullptr ;
+  public: ACANGatewaySendRoutine mSend = nullptr ;
+  public: CANMessage mHeldFrame ;            // Drivers without in place access: frame taken by receive
+  public: bool mHolding = false ;
+  public: bool mBlocked = false ;            // Head frame refused by its destination
+  public: uint32_t mArrivalDate = 0 ;        // Of the blocked head frame (µs)
+  public: uint32_t mUnroutedCount = 0 ;      // Frames matching no route, discarded
+} ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   CAN gateway
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+// Frames received on a port are looked up in a routing table (identifier ranges, binary search) and sent to the
+// destination port, with an optional identifier rewrite. Drivers that provide peekReceivedFrame / releaseReceivedFrame
+// (ESP32ACAN) are read in place: the frame goes from their receive buffer straight into the destination transmit
+// buffer, and is released only once the destination accepted it. Other drivers (ACAN2515, ...) are read with receive
+// into a one frame holding slot of the port.
+// Backpressure: a frame refused by its destination stays at the head of its source port, so the source receive buffer
+// absorbs the burst and the frame order of a source is kept. A frame refused for longer than the hold time is dropped,
+// which bounds the latency.
+//
+//   ACANGateway gateway ;
+//   gateway.initWithCapacity (8) ;
+//   const uint8_t esp = gateway.addPort (canESP32) ;
+//   const uint8_t mcp = gateway.addPort (can2515) ;
+//   gateway.addRoute (esp, mcp, 0x100, 0x1FF, false) ;
+//   gateway.addRoute (mcp, esp, 0x18FF0000, 0x18FF00FF, true, ACANGateway::key (0x18FE0000, true)) ;
+//   loop: gateway.poll (micros ()) ;
+
+class ACANGateway {
+
+//······················································································································
+//   CONSTRUCTOR
+//······················································································································
+
+  public: ACANGateway (void) ;
+
+  public: ~ ACANGateway (void) ;
+
+//······················································································································
+//   Initialisation: room for inRouteCapacity routes, returns false on allocation failure
+//······················································································································
+
+  public: bool initWithCapacity (const uint16_t inRouteCapacity) ;
+
+//······················································································································
+//   Ports: returns the port index, kInvalidPort if there are already kMaxPortCount ports
+//······················································································································
+
+  public: static const uint8_t kMaxPortCount = 4 ;
+  public: static const uint8_t kInvalidPort = 0xFF ;
+
+  public: template <typename DRIVER> uint8_t addPort (DRIVER & inDriver) {
+    return addPort (&inDriver, peekRoutine <DRIVER> (0), releaseRoutine <DRIVER> (0), sendThroughDriver <DRIVER>) ;
+  }
+
+  public: uint8_t addPort (void * inDriver,
+                           ACANGatewayPeekRoutine inPeek,
+                           ACANGatewayReleaseRoutine inRelease,
+                           ACANGatewaySendRoutine inSend) ;
+
+  public: inline uint8_t portCount (void) const { return mPortCount ; }
+  public: inline uint32_t unroutedCount (const uint8_t inPort) const { return mPorts [inPort].mUnroutedCount ; }
+
+//······················································································································
+//   Routes: identifiers inFirst ... inLast (same format) of inSource go to inDestination. With a rewrite, the
+//   identifier becomes inRewriteKey + (identifier - inFirst), inRewriteKey also gives the format. Returns the route
+//   index, or kInvalidRoute (table full, bad port, empty range, or range overlapping a route of the same source).
+//······················································································································
+
+  public: static const uint16_t kInvalidRoute = 0xFFFF ;
+  public: static const uint32_t kNoRewrite = 0xFFFFFFFF ;
+
+  public: static constexpr uint32_t key (const uint32_t inIdentifier, const bool inExtended) {
+    return inIdentifier | (inExtended ? 0x80000000UL : 0) ;
+  }
+
+  public: uint16_t addRoute (const uint8_t inSource,
+                             const uint8_t inDestination,
+                             const uint32_t inFirst,
+                             const uint32_t inLast,
+                             const bool inExtended,
+                             const uint32_t inRewriteKey = kNoRewrite) ;
+
+  public: inline uint16_t routeCount (void) const { return mRouteCount ; }
+
+  //--- Route indexes are the ones returned by addRoute
+  public: const ACANGatewayRouteStatistics & routeStatistics (const uint16_t inRoute) const ;
+  public: void resetStatistics (void) ;
+
+//······················································································································
+//   Hold time: a frame refused by its destination for longer is dropped (µs, default 1000)
+//······················································································································
+
+  public: inline void setHoldTime (const uint32_t inMicros) { mHoldTime = inMicros ; }
+
+//······················································································································
+//   Forwarding: call from loop with micros (). Every frame waiting on every port is forwarded, or left at the head of
+//   its port if the destination is full. The latency of a frame is counted from the previous poll (the frame arrived
+//   after it): it is an upper bound of the time spent in the source receive buffer and in the gateway.
+//······················································································································
+
+  public: void poll (const uint32_t inNowMicros) ;
+
+//······················································································································
+//   Driver adaptors
+//······················································································································
+
+  private: template <typename DRIVER> static bool sendThroughDriver (void * inDriver, const CANMessage & inMessage) {
+    return ((DRIVER *) inDriver)->tryToSend (inMessage) ;
+  }
+
+  //--- In place access if the driver has peekReceivedFrame / releaseReceivedFrame
+  private: template <typename DRIVER> static const CANMessage * peekInPlace (ACANGatewayPort & ioPort) {
+    const CANMessage * frame = nullptr ;
+    ((DRIVER *) ioPort.mDriver)->peekReceivedFrame (frame) ;
+    return frame ;
+  }
+
+  private: template <typename DRIVER> static void releaseInPlace (ACANGatewayPort & ioPort) {
+    ((DRIVER *) ioPort.mDriver)->releaseReceivedFrame () ;
+  }
+
+  private: template <typename DRIVER>
+           static auto peekRoutine (int) -> decltype (&DRIVER::peekReceivedFrame, ACANGatewayPeekRoutine ()) {
+    return peekInPlace <DRIVER> ;
+  }
+
+  private: template <typename DRIVER>
+           static auto releaseRoutine (int) -> decltype (&DRIVER::releaseReceivedFrame, ACANGatewayReleaseRoutine ()) {
+    return releaseInPlace <DRIVER> ;
+  }
+
+  //--- Otherwise receive into the holding slot of the port
+  private: template <typename DRIVER> static const CANMessage * peekByReceive (ACANGatewayPort & ioPort) {
+    if (!ioPort.mHolding) {
+      ioPort.mHolding = ((DRIVER *) ioPort.mDriver)->receive (ioPort.mHeldFrame) ;
+    }
+    return ioPort.mHolding ? & ioPort.mHeldFrame : nullptr ;
+  }
+
+  private: static void releaseHeldFrame (ACANGatewayPort & ioPort) ;
+
+  private: template <typename DRIVER> static ACANGatewayPeekRoutine peekRoutine (long) {
+    return peekByReceive <DRIVER> ;
+  }
+
+  private: template <typename DRIVER> static ACANGatewayReleaseRoutine releaseRoutine (long) {
+    return releaseHeldFrame ;
+  }
+
+//······················································································································
+//   Private properties
+//······················································································································
+
+  private: class Route {
+    public: uint32_t mFirst ;
+    public: uint32_t mLast ;
+    public: uint32_t mRewriteKey ;
+    public: uint16_t mIndex ;      // Returned by addRoute, index of the statistics
+    public: uint8_t mSource ;
+    public: uint8_t mDestination ;
+  } ;
+
+  private: uint16_t findRoute (const uint8_t inSource, const uint32_t inKey) const ;
+
+  private: ACANGatewayPort mPorts [kMaxPortCount] ;
+  private: Route * mRoutes ;                          // Sorted by source, then first key
+  private: ACANGatewayRouteStatistics * mStatistics ;
+  private: uint16_t mRouteCapacity ;
+  private: uint16_t mRouteCount ;
+  private: uint8_t mPortCount ;
+  private: bool mPolled ;
+  private: uint32_t mPreviousPollDate ;
+  private: uint32_t mHoldTime ;
+
+//······················································································································
+//    No Copy
+//······················································································································
+
+  private: ACANGateway (const ACANGateway &) = delete ;
+  private: ACANGateway & operator = (const ACANGateway &) = delete ;
+
+} ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+#endif
@@ -0,0 +1,486 @@
+/******************************************************************************/
+/* File name        : ACANHostLink.cpp                                        */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Description      : Binary host link: COBS packets, CRC, credits            */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation                                                        */
+/* ---------------------------------------------------------------------------*/
+
+/*------------------------------- Include files ------------------------------*/
+#include "ACANHostLink.h"
+#include "ACANE2E.h"
+#include <string.h>
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static const uint16_t kCRCInitialValue = 0xFFFF ;
+static const uint8_t kPacketHeaderLength = 2 ;  // Type, sequence number
+static const uint8_t kCRCLength = 2 ;
+static const uint8_t kFramesHeaderLength = kPacketHeaderLength + 8 ; // First frame index, base timestamp
+static const uint8_t kCreditPacketLength = kPacketHeaderLength + 9 + kCRCLength ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static inline void writeUInt16 (uint8_t outBytes [], const uint16_t inValue) {
+  outBytes [0] = uint8_t (inValue) ;
+  outBytes [1] = uint8_t (inValue >> 8) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static inline void writeUInt32 (uint8_t outBytes [], const uint32_t inValue) {
+  outBytes [0] = uint8_t (inValue) ;
+  outBytes [1] = uint8_t (inValue >> 8) ;
+  outBytes [2] = uint8_t (inValue >> 16) ;
+  outBytes [3] = uint8_t (inValue >> 24) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static inline uint16_t readUInt16 (const uint8_t inBytes []) {
+  return uint16_t (inBytes [0] | (inBytes [1] << 8)) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static inline uint32_t readUInt32 (const uint8_t inBytes []) {
+  return uint32_t (inBytes [0]) | (uint32_t (inBytes [1]) << 8) | (uint32_t (inBytes [2]) << 16)
+       | (uint32_t (inBytes [3]) << 24) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   COBS: each block is a code byte (1 + count of the non zero bytes that follow, 0xFF: 254 bytes, no zero after)
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+uint16_t ACANHostLink::cobsEncode (const uint8_t inData [], const uint16_t inLength, uint8_t outEncoded []) {
+  uint16_t codeIndex = 0 ;
+  uint16_t length = 1 ;
+  uint8_t code = 1 ;
+  for (uint16_t i=0 ; i<inLength ; i++) {
+    if (inData [i] == 0) {
+      outEncoded [codeIndex] = code ;
+      codeIndex = length ;
+      length += 1 ;
+      code = 1 ;
+    }else{
+      outEncoded [length] = inData [i] ;
+      length += 1 ;
+      code += 1 ;
+      if (code == 0xFF) {
+        outEncoded [codeIndex] = code ;
+        codeIndex = length ;
+        length += 1 ;
+        code = 1 ;
+      }
+    }
+  }
+  outEncoded [codeIndex] = code ;
+  return length ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+bool ACANHostLink::cobsDecode (const uint8_t inEncoded [], const uint16_t inLength,
+                               uint8_t outData [], uint16_t & outLength) {
+  uint16_t i = 0 ;
+  uint16_t length = 0 ;
+  bool ok = true ;
+  while (ok && (i < inLength)) {
+    const uint8_t code = inEncoded [i] ;
+    i += 1 ;
+    ok = (code != 0) && ((i + code - 1) <= inLength) ;
+    for (uint8_t j=1 ; ok && (j<code) ; j++) {
+      const uint8_t byte = inEncoded [i] ;
+      i += 1 ;
+      ok = byte != 0 ;
+      outData [length] = byte ;
+      length += 1 ;
+    }
+    if (ok && (code != 0xFF) && (i < inLength)) {
+      outData [length] = 0 ;
+      length += 1 ;
+    }
+  }
+  outLength = length ;
+  return ok ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   Frame records
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+uint8_t ACANHostLink::encodeFrameRecord (const CANMessage & inFrame,
+                                         const uint16_t inTimestampDelta,
+                                         uint8_t outRecord [kMaxFrameRecordLength]) {
+  const uint8_t length = (inFrame.len > 8) ? 8 : inFrame.len ;
+  outRecord [0] = uint8_t ((inFrame.ext ? 0x80 : 0) | (inFrame.rtr ? 0x40 : 0) | length) ;
+  uint8_t idx = 1 ;
+  if (inFrame.ext) {
+    writeUInt32 (&outRecord [idx], inFrame.id & 0x1FFFFFFF) ;
+    idx += 4 ;
+  }else{
+    writeUInt16 (&outRecord [idx], uint16_t (inFrame.id & 0x7FF)) ;
+    idx += 2 ;
+  }
+  writeUInt16 (&outRecord [idx], inTimestampDelta) ;
+  idx += 2 ;
+  if (!inFrame.rtr) {
+    memcpy (&outRecord [idx], inFrame.data, length) ;
+    idx += length ;
+  }
+  return idx ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+uint8_t ACANHostLink::decodeFrameRecord (const uint8_t inRecord [], const uint16_t inAvailable,
+                                         CANMessage & outFrame, uint16_t & outTimestampDelta) {
+  uint8_t result = 0 ;
+  if (inAvailable > 0) {
+    const uint8_t flags = inRecord [0] ;
+    const bool ext = (flags & 0x80) != 0 ;
+    const bool rtr = (flags & 0x40) != 0 ;
+    const uint8_t length = flags & 0x0F ;
+    const uint8_t recordLength = uint8_t (1 + (ext ? 4 : 2) + 2 + (rtr ? 0 : length)) ;
+    if (((flags & 0x30) == 0) && (length <= 8) && (recordLength <= inAvailable)) {
+      uint8_t idx = 1 ;
+      const uint32_t identifier = ext ? readUInt32 (&inRecord [idx]) : readUInt16 (&inRecord [idx]) ;
+      idx += ext ? 4 : 2 ;
+      if (identifier <= (ext ? 0x1FFFFFFFU : 0x7FFU)) {
+        outFrame.id = identifier ;
+        outFrame.ext = ext ;
+        outFrame.rtr = rtr ;
+        outFrame.len = length ;
+        outFrame.data64 = 0 ;
+        outTimestampDelta = readUInt16 (&inRecord [idx]) ;
+        idx += 2 ;
+        if (!rtr) {
+          memcpy (outFrame.data, &inRecord [idx], length) ;
+        }
+        result = recordLength ;
+      }
+    }
+  }
+  return result ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   Constructor, destructor, begin
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+ACANHostLink::ACANHostLink (void) :
+mReceiveRing (nullptr),
+mReceiveCapacity (0),
+mReceiveIndex (0),
+mReceiveCount (0),
+mOutput (),
+mOutputLength (0),
+mPacket (),
+mPacketLength (0),
+mPacketBaseTimestamp (0),
+mPacketTimestamp (0),
+mSendSequence (0),
+mStreamRoom (0),
+mInput (),
+mInputLength (0),
+mInputOverflow (false),
+mReceiveSequence (0),
+mReceiveSequenceKnown (false),
+mSendLimit (0),
+mNextFrameIndex (0),
+mSynchronized (false),
+mGrantedLimit (0),
+mCreditDate (0),
+mCreditSent (false),
+mSentFrameCount (0),
+mSentPacketCount (0),
+mReceivedFrameCount (0),
+mReceivedPacketCount (0),
+mCorruptedPacketCount (0),
+mLostPacketCount (0),
+mLostFrameCount (0),
+mOverflowFrameCount (0) {
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+ACANHostLink::~ ACANHostLink (void) {
+  delete [] mReceiveRing ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+bool ACANHostLink::begin (const uint16_t inReceiveCapacity) {
+  ACANCRC::begin () ;
+  delete [] mReceiveRing ;
+  mReceiveRing = (inReceiveCapacity > 0) ? new ReceivedFrame [inReceiveCapacity] : nullptr ;
+  mReceiveCapacity = inReceiveCapacity ;
+  mReceiveIndex = 0 ;
+  mReceiveCount = 0 ;
+  mOutputLength = 0 ;
+  mPacketLength = 0 ;
+  mInputLength = 0 ;
+  mInputOverflow = false ;
+  mReceiveSequenceKnown = false ;
+  mSendLimit = mSentFrameCount ;
+  mSynchronized = false ;
+  mCreditSent = false ; // Sent by the next update
+  return mReceiveRing != nullptr ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   Sending
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+bool ACANHostLink::appendFrame (const CANMessage & inFrame, const uint32_t inTimestampMicros) {
+  const bool ok = canAppendFrame () ;
+  if (ok && (mPacketLength > 0)) {
+    const uint32_t delta = inTimestampMicros - mPacketTimestamp ;
+    if ((delta > 0xFFFF) || ((mPacketLength + kMaxFrameRecordLength + kCRCLength) > kMaxPacketLength)) {
+      closePacket () ;
+    }
+  }
+  if (ok) {
+    if (mPacketLength == 0) {
+      mPacket [0] = kFramesPacket ;
+      writeUInt32 (&mPacket [2], mSentFrameCount) ;
+      writeUInt32 (&mPacket [6], inTimestampMicros) ;
+      mPacketLength = kFramesHeaderLength ;
+      mPacketBaseTimestamp = inTimestampMicros ;
+      mPacketTimestamp = inTimestampMicros ;
+    }
+    const uint16_t delta = uint16_t (inTimestampMicros - mPacketTimestamp) ;
+    mPacketLength += encodeFrameRecord (inFrame, delta, &mPacket [mPacketLength]) ;
+    mPacketTimestamp = inTimestampMicros ;
+    mSentFrameCount += 1 ;
+  }
+  return ok ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ACANHostLink::flush (void) {
+  if (mPacketLength > 0) {
+    closePacket () ;
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ACANHostLink::closePacket (void) {
+  emitPacket (mPacket, mPacketLength) ;
+  mPacketLength = 0 ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   Sequence numbers are given when packets are emitted: a credit packet may be emitted while a frames packet is open
+
+void ACANHostLink::emitPacket (uint8_t ioPacket [kMaxPacketLength], const uint8_t inLength) {
+  ioPacket [1] = mSendSequence ;
+  mSendSequence += 1 ;
+  const uint16_t crc = ACANCRC::crc16CCITT (ioPacket, inLength, kCRCInitialValue) ;
+  ioPacket [inLength] = uint8_t (crc >> 8) ;
+  ioPacket [inLength + 1] = uint8_t (crc) ;
+  mOutputLength += cobsEncode (ioPacket, inLength + kCRCLength, &mOutput [mOutputLength]) ;
+  mOutput [mOutputLength] = 0 ;
+  mOutputLength += 1 ;
+  mSentPacketCount += 1 ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ACANHostLink::consumeOutput (const uint16_t inCount) {
+  const uint16_t count = (inCount < mOutputLength) ? inCount : mOutputLength ;
+  memmove (mOutput, &mOutput [count], mOutputLength - count) ;
+  mOutputLength -= count ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   Credits
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ACANHostLink::update (const uint32_t inNowMicros) {
+  const uint32_t limit = mNextFrameIndex + (mReceiveCapacity - mReceiveCount) ;
+  const bool send = !mCreditSent
+    || ((inNowMicros - mCreditDate) >= kCreditPeriod)
+    || (mSynchronized && ((limit - mGrantedLimit) >= uint32_t ((mReceiveCapacity + 3) / 4))) ;
+  if (send) {
+    sendCredit (inNowMicros) ;
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   The open frames packet is emitted first, as the credit packet gives the index of the next frame sent. Without
+//   room, the credit is sent by a next update.
+
+void ACANHostLink::sendCredit (const uint32_t inNowMicros) {
+  flush () ;
+  if ((mOutputLength + kCreditPacketLength + 2) <= kOutputBufferSize) {
+    const uint32_t limit = mNextFrameIndex + (mReceiveCapacity - mReceiveCount) ;
+    uint8_t packet [kCreditPacketLength] ;
+    packet [0] = kCreditPacket ;
+    writeUInt32 (&packet [2], mSentFrameCount) ;
+    writeUInt32 (&packet [6], limit) ;
+    packet [10] = mSynchronized ? kCreditSynchronizedFlag : 0 ;
+    emitPacket (packet, kCreditPacketLength - kCRCLength) ;
+    mGrantedLimit = limit ;
+    mCreditDate = inNowMicros ;
+    mCreditSent = true ;
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   Receiving
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ACANHostLink::receiveBytes (const uint8_t inBytes [], const size_t inCount) {
+  for (size_t i=0 ; i<inCount ; i++) {
+    const uint8_t byte = inBytes [i] ;
+    if (byte != 0) {
+      if (mInputLength < sizeof (mInput)) {
+        mInput [mInputLength] = byte ;
+        mInputLength += 1 ;
+      }else{
+        mInputOverflow = true ;
+      }
+    }else if (mInputOverflow) {
+      mCorruptedPacketCount += 1 ;
+      mInputOverflow = false ;
+      mInputLength = 0 ;
+    }else if (mInputLength > 0) { // Empty packets (repeated 0x00) are ignored
+      uint8_t packet [sizeof (mInput)] ;
+      uint16_t length = 0 ;
+      if (cobsDecode (mInput, mInputLength, packet, length)) {
+        handlePacket (packet, length) ;
+      }else{
+        mCorruptedPacketCount += 1 ;
+      }
+      mInputLength = 0 ;
+    }
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ACANHostLink::handlePacket (uint8_t ioPacket [], const uint16_t inLength) {
+  bool ok = inLength >= (kPacketHeaderLength + kCRCLength) ;
+  if (ok) {
+    const uint16_t crc = ACANCRC::crc16CCITT (ioPacket, inLength - kCRCLength, kCRCInitialValue) ;
+    ok = crc == ((ioPacket [inLength - 2] << 8) | ioPacket [inLength - 1]) ;
+  }
+  const uint16_t payloadLength = ok ? uint16_t (inLength - kPacketHeaderLength - kCRCLength) : 0 ;
+  const uint8_t * payload = &ioPacket [kPacketHeaderLength] ;
+  if (ok) {
+    switch (ioPacket [0]) {
+    case kFramesPacket :
+      ok = payloadLength >= 8 ;
+      break ;
+    case kCreditPacket :
+      ok = payloadLength == 9 ;
+      break ;
+    default :
+      ok = false ;
+      break ;
+    }
+  }
+  if (!ok) {
+    mCorruptedPacketCount += 1 ;
+  }else{
+    const uint8_t sequence = ioPacket [1] ;
+    if (mReceiveSequenceKnown) {
+      mLostPacketCount += uint8_t (sequence - mReceiveSequence) ;
+    }
+    mReceiveSequence = uint8_t (sequence + 1) ;
+    mReceiveSequenceKnown = true ;
+    mReceivedPacketCount += 1 ;
+    if (ioPacket [0] == kFramesPacket) {
+      handleFrames (payload, payloadLength) ;
+    }else{
+      synchronize (readUInt32 (&payload [0])) ;
+      const uint32_t limit = readUInt32 (&payload [4]) ;
+      if (((payload [8] & kCreditSynchronizedFlag) != 0) && (int32_t (limit - mSendLimit) > 0)) {
+        mSendLimit = limit ;
+      }
+    }
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   The first frame index of the peer is adopted, later indexes only skip the frames of lost packets
+
+void ACANHostLink::synchronize (const uint32_t inFrameIndex) {
+  if (!mSynchronized) {
+    mNextFrameIndex = inFrameIndex ;
+    mGrantedLimit = inFrameIndex ;
+    mSynchronized = true ;
+    mCreditSent = false ; // Credit in the index space of the peer sent by the next update
+  }else if (int32_t (inFrameIndex - mNextFrameIndex) > 0) {
+    mLostFrameCount += inFrameIndex - mNextFrameIndex ;
+    mNextFrameIndex = inFrameIndex ;
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ACANHostLink::handleFrames (const uint8_t inPayload [], const uint16_t inLength) {
+  synchronize (readUInt32 (&inPayload [0])) ;
+  uint32_t timestamp = readUInt32 (&inPayload [4]) ;
+  uint16_t idx = 8 ;
+  while (idx < inLength) {
+    CANMessage frame ;
+    uint16_t delta = 0 ;
+    const uint8_t recordLength = decodeFrameRecord (&inPayload [idx], uint16_t (inLength - idx), frame, delta) ;
+    if (recordLength == 0) { // Valid CRC, invalid record: the rest of the packet is dropped
+      mCorruptedPacketCount += 1 ;
+      idx = inLength ;
+    }else{
+      idx += recordLength ;
+      timestamp += delta ;
+      mNextFrameIndex += 1 ;
+      if (mReceiveCount < mReceiveCapacity) {
+        uint32_t writeIndex = uint32_t (mReceiveIndex) + mReceiveCount ;
+        if (writeIndex >= mReceiveCapacity) {
+          writeIndex -= mReceiveCapacity ;
+        }
+        mReceiveRing [writeIndex].mFrame = frame ;
+        mReceiveRing [writeIndex].mTimestamp = timestamp ;
+        mReceiveCount += 1 ;
+        mReceivedFrameCount += 1 ;
+      }else{
+        mOverflowFrameCount += 1 ;
+      }
+    }
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+bool ACANHostLink::receive (CANMessage & outFrame, uint32_t & outTimestampMicros) {
+  const bool ok = mReceiveCount > 0 ;
+  if (ok) {
+    outFrame = mReceiveRing [mReceiveIndex].mFrame ;
+    outTimestampMicros = mReceiveRing [mReceiveIndex].mTimestamp ;
+    dropReceivedFrame () ;
+  }
+  return ok ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ACANHostLink::dropReceivedFrame (void) {
+  mReceiveIndex += 1 ;
+  if (mReceiveIndex == mReceiveCapacity) {
+    mReceiveIndex = 0 ;
+  }
+  mReceiveCount -= 1 ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
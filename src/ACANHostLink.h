@@ -0,0 +1,243 @@
+/******************************************************************************/
+/* File name        : ACANHostLink.h                                          */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Description      : Binary host link: COBS packets, CRC, credits            */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation                                                        */
+/* ---------------------------------------------------------------------------*/
+
+#ifndef ACAN_HOST_LINK_CLASS_DEFINED
+#define ACAN_HOST_LINK_CLASS_DEFINED
+
+/*------------------------------- Include files ------------------------------*/
+#include "CANMessage.h"
+#include <stddef.h>
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   Binary host link. Packets are COBS encoded and end with a 0x00 byte; before encoding (at most kMaxPacketLength):
+//     type (1 byte), sequence number (1 byte, per direction, counts lost packets), payload, CRC-16 CCITT (init 0xFFFF,
+//     ACANCRC, 2 bytes big endian) of type, sequence number and payload. Multi-byte payload fields are little endian.
+//   Frames packet payload: index of its first frame (4 bytes, frames sent before it), base timestamp (4 bytes, µs),
+//     then one record per frame: flags (bit 7: extended, bit 6: remote, bits 0-3: length), identifier (2 bytes
+//     standard, 4 bytes extended), timestamp (2 bytes, µs since the previous record, since the base for the first),
+//     data (length bytes, data frames): 5 ... 15 bytes per frame.
+//   Credit packet payload: index of the next frame the sender of the credit sends (4 bytes), frame index the peer
+//     may send up to, excluded (4 bytes: index of the next frame expected + free room), flags (1 byte, bit 0: the
+//     index expected is known, from a frames or credit packet of the peer; credit without it is not applied).
+//   Flow control: frames are sent only while the peer gives credit, so the receive ring of the peer never overflows;
+//   frames wait at the sender (in the driver receive buffer on the device). Credits are given in the index space of
+//   the sender: a lost credit packet is repaired by the next one (sent after a quarter of the ring is consumed, or
+//   every kCreditPeriod µs), frames of a lost frames packet are skipped by the next one and do not consume credit.
+//   The same endpoint runs on both sides: poll (driver, stream) on the device, see host-link-on-desktop for Linux.
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+class ACANHostLink {
+
+  public: static const uint8_t kMaxPacketLength = 250 ;        // Before COBS: at most 251 bytes encoded, then 0x00
+  public: static const uint8_t kMaxFrameRecordLength = 15 ;
+  public: static const uint16_t kOutputBufferSize = 1024 ;
+  public: static const uint16_t kMaxEncodedPacketLength = kMaxPacketLength + 2 ; // COBS code, 0x00 delimiter
+  public: static const uint32_t kCreditPeriod = 10 * 1000 ;   // µs
+  public: static const uint32_t kBatchPeriod = 500 ;          // µs, see poll
+
+  public: static const uint8_t kFramesPacket = 0x01 ;
+  public: static const uint8_t kCreditPacket = 0x02 ;
+
+  public: static const uint8_t kCreditSynchronizedFlag = 1 << 0 ;
+
+//······················································································································
+//   Codec
+//······················································································································
+
+  //--- COBS: returns the encoded length (at most inLength + 1 + inLength / 254), without the 0x00 delimiter
+  public: static uint16_t cobsEncode (const uint8_t inData [], const uint16_t inLength, uint8_t outEncoded []) ;
+
+  //--- COBS: returns false if malformed (a 0x00 byte, a code beyond the end)
+  public: static bool cobsDecode (const uint8_t inEncoded [], const uint16_t inLength,
+                                  uint8_t outData [], uint16_t & outLength) ;
+
+  //--- Frame record: returns its length
+  public: static uint8_t encodeFrameRecord (const CANMessage & inFrame,
+                                            const uint16_t inTimestampDelta,
+                                            uint8_t outRecord [kMaxFrameRecordLength]) ;
+
+  //--- Frame record: returns its length, 0 if malformed or longer than inAvailable
+  public: static uint8_t decodeFrameRecord (const uint8_t inRecord [], const uint16_t inAvailable,
+                                            CANMessage & outFrame, uint16_t & outTimestampDelta) ;
+
+//······················································································································
+//   Constructor, begin: receive ring of inReceiveCapacity frames (the credit given to the peer)
+//······················································································································
+
+  public: ACANHostLink (void) ;
+
+  public: ~ ACANHostLink (void) ;
+
+  public: bool begin (const uint16_t inReceiveCapacity) ;
+
+//······················································································································
+//   Sending: frames go into the current frames packet (closed when full, by flush, or when the timestamp delta does
+//   not fit 16 bits). Returns false without credit or output room (see canAppendFrame): the frame stays with the
+//   caller.
+//······················································································································
+
+  public: bool appendFrame (const CANMessage & inFrame, const uint32_t inTimestampMicros) ;
+
+  public: void flush (void) ;
+
+  public: inline bool hasCredit (void) const { return int32_t (mSendLimit - mSentFrameCount) > 0 ; }
+
+  public: inline uint32_t credit (void) const { return hasCredit () ? (mSendLimit - mSentFrameCount) : 0 ; }
+
+  //--- Room for the open frames packet and a new one: appendFrame succeeds
+  public: inline bool canAppendFrame (void) const {
+    return hasCredit ()
+      && ((mOutputLength + kMaxEncodedPacketLength * ((mPacketLength > 0) ? 2 : 1)) <= kOutputBufferSize) ;
+  }
+
+//······················································································································
+//   Receiving: bytes from the peer, then received frames in order with their timestamp (µs)
+//······················································································································
+
+  public: void receiveBytes (const uint8_t inBytes [], const size_t inCount) ;
+
+  public: bool receive (CANMessage & outFrame, uint32_t & outTimestampMicros) ;
+
+  public: inline uint16_t receiveCount (void) const { return mReceiveCount ; }
+
+//······················································································································
+//   Output to the peer, and credits: call update on every poll
+//······················································································································
+
+  public: void update (const uint32_t inNowMicros) ;
+
+  public: inline const uint8_t * output (void) const { return mOutput ; }
+  public: inline uint16_t outputLength (void) const { return mOutputLength ; }
+  public: void consumeOutput (const uint16_t inCount) ; // Bytes written to the peer
+
+//······················································································································
+//   Device bridge: frames received by the driver go to the host while it gives credit (stamped with inNowMicros,
+//   the driver has no receive date), frames from the host go to the driver. The open frames packet is closed when
+//   its first frame is kBatchPeriod old and nothing is queued in the stream (availableForWrite back to the largest
+//   value seen): while the link is busy, frames accumulate in it, so batching follows the load. One read and one
+//   write per poll.
+//   DRIVER: tryToSend (frame), receive (frame). STREAM: Arduino Stream (available, readBytes, availableForWrite, write)
+//······················································································································
+
+  public: template <typename DRIVER, typename STREAM>
+  void poll (DRIVER & ioDriver, STREAM & ioStream, const uint32_t inNowMicros) {
+    uint8_t input [128] ;
+    int available = ioStream.available () ;
+    while (available > 0) {
+      const size_t count = ioStream.readBytes ((char *) input, (available < 128) ? size_t (available) : 128) ;
+      receiveBytes (input, count) ;
+      available -= int (count) ;
+    }
+  //--- Host -> CAN: a frame refused by the driver stays at the head of the receive ring
+    while ((mReceiveCount > 0) && ioDriver.tryToSend (mReceiveRing [mReceiveIndex].mFrame)) {
+      dropReceivedFrame () ;
+    }
+  //--- CAN -> host
+    CANMessage frame ;
+    while (canAppendFrame () && ioDriver.receive (frame)) {
+      appendFrame (frame, inNowMicros) ;
+    }
+    const int room = ioStream.availableForWrite () ;
+    if (mStreamRoom < room) {
+      mStreamRoom = room ;
+    }
+    if ((room == mStreamRoom) && (mOutputLength == 0) && ((inNowMicros - mPacketBaseTimestamp) >= kBatchPeriod)) {
+      flush () ;
+    }
+    update (inNowMicros) ;
+    const uint16_t count = (room < int (mOutputLength)) ? uint16_t (room) : mOutputLength ;
+    if (count > 0) {
+      consumeOutput (uint16_t (ioStream.write (mOutput, count))) ;
+    }
+  }
+
+//······················································································································
+//   Counters
+//······················································································································
+
+  public: inline uint32_t sentFrameCount (void) const { return mSentFrameCount ; }
+  public: inline uint32_t sentPacketCount (void) const { return mSentPacketCount ; }
+  public: inline uint32_t receivedFrameCount (void) const { return mReceivedFrameCount ; }
+  public: inline uint32_t receivedPacketCount (void) const { return mReceivedPacketCount ; }
+  public: inline uint32_t corruptedPacketCount (void) const { return mCorruptedPacketCount ; } // COBS, CRC, format
+  public: inline uint32_t lostPacketCount (void) const { return mLostPacketCount ; }           // Sequence gaps
+  public: inline uint32_t lostFrameCount (void) const { return mLostFrameCount ; }             // Frame index gaps
+  public: inline uint32_t overflowFrameCount (void) const { return mOverflowFrameCount ; }     // Beyond the credit
+
+//······················································································································
+//   Private
+//······················································································································
+
+  private: class ReceivedFrame {
+    public: CANMessage mFrame ;
+    public: uint32_t mTimestamp ;
+  } ;
+
+  private: void closePacket (void) ;
+  private: void emitPacket (uint8_t ioPacket [kMaxPacketLength], const uint8_t inLength) ; // Sets sequence and CRC
+  private: void sendCredit (const uint32_t inNowMicros) ;
+  private: void handlePacket (uint8_t ioPacket [], const uint16_t inLength) ;
+  private: void handleFrames (const uint8_t inPayload [], const uint16_t inLength) ;
+  private: void synchronize (const uint32_t inFrameIndex) ;
+  private: void dropReceivedFrame (void) ;
+
+  private: ReceivedFrame * mReceiveRing ;
+  private: uint16_t mReceiveCapacity ;
+  private: uint16_t mReceiveIndex ;    // Oldest frame
+  private: uint16_t mReceiveCount ;
+
+  private: uint8_t mOutput [kOutputBufferSize] ;
+  private: uint16_t mOutputLength ;
+  private: uint8_t mPacket [kMaxPacketLength] ;  // Frames packet being built (CRC added when closed)
+  private: uint8_t mPacketLength ;               // 0: no packet open
+  private: uint32_t mPacketBaseTimestamp ;       // Of its first record
+  private: uint32_t mPacketTimestamp ;           // Of its last record
+  private: uint8_t mSendSequence ;
+  private: int mStreamRoom ;                     // Largest availableForWrite seen by poll
+
+  private: uint8_t mInput [kMaxPacketLength + 1] ; // COBS bytes of the packet being received
+  private: uint16_t mInputLength ;
+  private: bool mInputOverflow ;                  // Bytes discarded until the next 0x00
+  private: uint8_t mReceiveSequence ;             // Expected
+  private: bool mReceiveSequenceKnown ;
+
+  private: uint32_t mSendLimit ;                  // Frame index, from the credit of the peer
+  private: uint32_t mNextFrameIndex ;             // Of the next frame expected from the peer
+  private: bool mSynchronized ;                   // mNextFrameIndex is known
+  private: uint32_t mGrantedLimit ;               // Sent in the last credit packet
+  private: uint32_t mCreditDate ;
+  private: bool mCreditSent ;
+
+  private: uint32_t mSentFrameCount ;             // Also the index of the next frame sent
+  private: uint32_t mSentPacketCount ;
+  private: uint32_t mReceivedFrameCount ;
+  private: uint32_t mReceivedPacketCount ;
+  private: uint32_t mCorruptedPacketCount ;
+  private: uint32_t mLostPacketCount ;
+  private: uint32_t mLostFrameCount ;
+  private: uint32_t mOverflowFrameCount ;
+
+//······················································································································
+//    No copy
+//······················································································································
+
+  private: ACANHostLink (const ACANHostLink &) = delete ;
+  private: ACANHostLink & operator = (const ACANHostLink &) = delete ;
+} ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+#endif
@@ -0,0 +1,508 @@
+/******************************************************************************/
+/* File name        : ACANISOTP.cpp                                           */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Description      : ISO 15765-2 (ISO-TP) transport layer                    */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation                                                        */
+/* ---------------------------------------------------------------------------*/
+
+/*------------------------------- Include files ------------------------------*/
+#include "ACANISOTP.h"
+#include <string.h>
+
+/*------------------------------- Local defines ------------------------------*/
+//--- Protocol control information (high nibble of the first data byte)
+#define PCI_SINGLE_FRAME         (0x00)
+#define PCI_FIRST_FRAME          (0x10)
+#define PCI_CONSECUTIVE_FRAME    (0x20)
+#define PCI_FLOW_CONTROL         (0x30)
+
+//--- Flow status
+#define FLOW_STATUS_CTS          (0)
+#define FLOW_STATUS_WAIT         (1)
+#define FLOW_STATUS_OVERFLOW     (2)
+
+#define SINGLE_FRAME_MAX_LEN     (7)
+#define FIRST_FRAME_MAX_LEN_12   (4095)
+#define MAX_POOL_BUFFERS         (32)
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   Date comparison, correct across micros () wrap around
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static inline bool dateReached (const uint32_t inNow, const uint32_t inDate) {
+  return (int32_t) (inNow - inDate) >= 0 ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   CONSTRUCTOR, DESTRUCTOR
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+ACANISOTP::ACANISOTP (ACANISOTPSendRoutine inSendRoutine, void * inDriver) :
+mSendRoutine (inSendRoutine),
+mDriver (inDriver),
+mChannels (NULL),
+mChannelCapacity (0),
+mChannelCount (0),
+mPool (NULL),
+mPoolBufferSize (0),
+mPoolBufferCount (0),
+mFreePoolBuffers (0),
+mTransmittedMessageCount (0),
+mReceivedMessageCount (0),
+mTransmittedByteCount (0),
+mReceivedByteCount (0),
+mReceiveErrorCount (0),
+mReceiveOverflowCount (0) {
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+ACANISOTP::~ ACANISOTP (void) {
+  delete [] mChannels ;
+  delete [] mPool ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   BEGIN
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+uint32_t ACANISOTP::begin (const uint8_t inChannelCount,
+                           const uint8_t inReceiveBufferCount,
+                           const uint32_t inReceiveBufferSize) {
+  uint32_t errorCode = 0 ;
+  delete [] mChannels ;
+  mChannels = new Channel [inChannelCount] ;
+  if (mChannels == NULL) {
+    errorCode |= kCannotAllocateChannels ;
+  }
+  mChannelCapacity = (mChannels != NULL) ? inChannelCount : 0 ;
+  mChannelCount = 0 ;
+  delete [] mPool ;
+  mPool = NULL ;
+  if (inReceiveBufferCount > MAX_POOL_BUFFERS) {
+    errorCode |= kTooManyReceiveBuffers ;
+  }else{
+    mPool = new uint8_t [(size_t) inReceiveBufferCount * inReceiveBufferSize] ;
+    if (mPool == NULL) {
+      errorCode |= kCannotAllocateReceiveBuffers ;
+    }
+  }
+  mPoolBufferCount = (mPool != NULL) ? inReceiveBufferCount : 0 ;
+  mPoolBufferSize = (mPool != NULL) ? inReceiveBufferSize : 0 ;
+  mFreePoolBuffers = (mPoolBufferCount == 32) ? UINT32_MAX : ((1UL << mPoolBufferCount) - 1) ;
+  return errorCode ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+uint8_t ACANISOTP::addChannel (const ACANISOTPChannelSettings & inSettings) {
+  uint8_t result = kInvalidChannel ;
+  if (mChannelCount < mChannelCapacity) {
+    result = mChannelCount ;
+    mChannelCount += 1 ;
+    Channel & channel = mChannels [result] ;
+    channel.mSettings = inSettings ;
+    channel.mTxState = kTxIdle ;
+    channel.mTxStatus = kIdle ;
+    channel.mRxState = kRxIdle ;
+    channel.mRxFlowControlPending = false ;
+  }
+  return result ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   Frame helpers
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ACANISOTP::initFrame (const Channel & inChannel, CANMessage & outFrame) const {
+  outFrame.id = inChannel.mSettings.mTransmitIdentifier ;
+  outFrame.ext = inChannel.mSettings.mExtended ;
+  outFrame.rtr = false ;
+  outFrame.len = 8 ;
+  if (inChannel.mSettings.mPadding) {
+    memset (outFrame.data, inChannel.mSettings.mPaddingByte, 8) ;
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+// STmin: 0x00 ... 0x7F in ms, 0xF1 ... 0xF9 in 100 µs units, reserved values are handled as 0x7F
+
+uint32_t ACANISOTP::separationTimeMicros (const uint8_t inSTmin) {
+  uint32_t result ;
+  if (inSTmin <= 0x7F) {
+    result = 1000UL * inSTmin ;
+  }else if ((inSTmin >= 0xF1) && (inSTmin <= 0xF9)) {
+    result = 100UL * (inSTmin - 0xF0) ;
+  }else{
+    result = 1000UL * 0x7F ;
+  }
+  return result ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+bool ACANISOTP::sendFlowControl (Channel & ioChannel, const uint8_t inFlowStatus) {
+  CANMessage frame ;
+  initFrame (ioChannel, frame) ;
+  frame.data [0] = PCI_FLOW_CONTROL | inFlowStatus ;
+  frame.data [1] = ioChannel.mSettings.mBlockSize ;
+  frame.data [2] = ioChannel.mSettings.mSeparationTime ;
+  if (!ioChannel.mSettings.mPadding) {
+    frame.len = 3 ;
+  }
+  return mSendRoutine (mDriver, frame) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   Receive buffer pool
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+bool ACANISOTP::acquireReceiveBuffer (Channel & ioChannel, const uint32_t inLength) {
+  const bool ok = (inLength <= mPoolBufferSize) && (mFreePoolBuffers != 0) ;
+  if (ok) {
+    uint8_t buffer = 0 ;
+    while ((mFreePoolBuffers & (1UL << buffer)) == 0) {
+      buffer += 1 ;
+    }
+    mFreePoolBuffers &= ~ (1UL << buffer) ;
+    ioChannel.mRxBuffer = buffer ;
+  }
+  return ok ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ACANISOTP::releaseReceiveBuffer (Channel & ioChannel) {
+  if (ioChannel.mRxState != kRxIdle) {
+    mFreePoolBuffers |= 1UL << ioChannel.mRxBuffer ;
+    ioChannel.mRxState = kRxIdle ;
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   TRANSMISSION
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+bool ACANISOTP::send (const uint8_t inChannel, const uint8_t * inData, const uint32_t inLength,
+                      const uint32_t inNowMicros) {
+  const bool ok = (inChannel < mChannelCount)
+    && (inLength > 0)
+    && (mChannels [inChannel].mTxState == kTxIdle) ;
+  if (ok) {
+    Channel & channel = mChannels [inChannel] ;
+    channel.mTxData = inData ;
+    channel.mTxLength = inLength ;
+    channel.mTxOffset = 0 ;
+    channel.mTxSequenceNumber = 1 ;
+    channel.mTxWaitCount = 0 ;
+    channel.mTxState = kTxFirstFrame ;
+    channel.mTxStatus = kInProgress ;
+    channel.mTxDeadline = inNowMicros + channel.mSettings.mTimeout ; // Single or first frame still refused: kTimeout
+    transmit (channel, inNowMicros) ;
+  }
+  return ok ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+ACANISOTP::TransmitStatus ACANISOTP::transmitStatus (const uint8_t inChannel) const {
+  return (inChannel < mChannelCount) ? mChannels [inChannel].mTxStatus : kIdle ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+// Emits as many frames as allowed: with STmin = 0 and no block limit, consecutive frames are pushed until the driver
+// transmit buffer is full, so the bus never waits for the application between two frames.
+
+void ACANISOTP::transmit (Channel & ioChannel, const uint32_t inNowMicros) {
+  bool loop = true ;
+  while (loop) {
+    CANMessage frame ;
+    initFrame (ioChannel, frame) ;
+    if (ioChannel.mTxState == kTxFirstFrame) {
+      const uint32_t length = ioChannel.mTxLength ;
+      uint32_t copied ;
+      if (length <= SINGLE_FRAME_MAX_LEN) { //--- Single frame
+        frame.data [0] = PCI_SINGLE_FRAME | (uint8_t) length ;
+        memcpy (&frame.data [1], ioChannel.mTxData, length) ;
+        copied = length ;
+        if (!ioChannel.mSettings.mPadding) {
+          frame.len = (uint8_t) (length + 1) ;
+        }
+      }else if (length <= FIRST_FRAME_MAX_LEN_12) { //--- First frame, 12-bit length
+        frame.data [0] = PCI_FIRST_FRAME | (uint8_t) (length >> 8) ;
+        frame.data [1] = (uint8_t) length ;
+        memcpy (&frame.data [2], ioChannel.mTxData, 6) ;
+        copied = 6 ;
+      }else{ //--- First frame, escape sequence and 32-bit length
+        frame.data [0] = PCI_FIRST_FRAME ;
+        frame.data [1] = 0 ;
+        frame.data [2] = (uint8_t) (length >> 24) ;
+        frame.data [3] = (uint8_t) (length >> 16) ;
+        frame.data [4] = (uint8_t) (length >> 8) ;
+        frame.data [5] = (uint8_t) length ;
+        memcpy (&frame.data [6], ioChannel.mTxData, 2) ;
+        copied = 2 ;
+      }
+      loop = mSendRoutine (mDriver, frame) ;
+      if (loop) {
+        ioChannel.mTxOffset = copied ;
+        if (copied == length) {
+          ioChannel.mTxState = kTxIdle ;
+          ioChannel.mTxStatus = kDone ;
+          mTransmittedMessageCount += 1 ;
+          mTransmittedByteCount += length ;
+          loop = false ;
+        }else{
+          ioChannel.mTxState = kTxWaitFlowControl ;
+          ioChannel.mTxDeadline = inNowMicros + ioChannel.mSettings.mTimeout ;
+          loop = false ;
+        }
+      }
+    }else if ((ioChannel.mTxState == kTxConsecutiveFrames) && dateReached (inNowMicros, ioChannel.mTxNextFrameDate)) {
+      const uint32_t remaining = ioChannel.mTxLength - ioChannel.mTxOffset ;
+      const uint32_t count = (remaining < 7) ? remaining : 7 ;
+      frame.data [0] = PCI_CONSECUTIVE_FRAME | ioChannel.mTxSequenceNumber ;
+      memcpy (&frame.data [1], ioChannel.mTxData + ioChannel.mTxOffset, count) ;
+      if (!ioChannel.mSettings.mPadding) {
+        frame.len = (uint8_t) (count + 1) ;
+      }
+      loop = mSendRoutine (mDriver, frame) ;
+      if (loop) {
+        ioChannel.mTxOffset += count ;
+        ioChannel.mTxSequenceNumber = (ioChannel.mTxSequenceNumber + 1) & 0x0F ;
+        if (ioChannel.mTxOffset == ioChannel.mTxLength) {
+          ioChannel.mTxState = kTxIdle ;
+          ioChannel.mTxStatus = kDone ;
+          mTransmittedMessageCount += 1 ;
+          mTransmittedByteCount += ioChannel.mTxLength ;
+          loop = false ;
+        }else if ((ioChannel.mTxBlockRemaining > 0) && (--ioChannel.mTxBlockRemaining == 0)) {
+          ioChannel.mTxState = kTxWaitFlowControl ;
+          ioChannel.mTxDeadline = inNowMicros + ioChannel.mSettings.mTimeout ;
+          loop = false ;
+        }else if (ioChannel.mTxSeparationTime > 0) {
+          ioChannel.mTxNextFrameDate = inNowMicros + ioChannel.mTxSeparationTime ;
+          loop = false ;
+        }
+      }
+    }else{
+      loop = false ;
+    }
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ACANISOTP::handleFlowControl (Channel & ioChannel, const CANMessage & inFrame, const uint32_t inNowMicros) {
+  if ((ioChannel.mTxState == kTxWaitFlowControl) && (inFrame.len >= 3)) {
+    switch (inFrame.data [0] & 0x0F) {
+    case FLOW_STATUS_CTS :
+      ioChannel.mTxState = kTxConsecutiveFrames ;
+      ioChannel.mTxBlockRemaining = inFrame.data [1] ;
+      ioChannel.mTxSeparationTime = separationTimeMicros (inFrame.data [2]) ;
+      ioChannel.mTxNextFrameDate = inNowMicros ;
+      ioChannel.mTxWaitCount = 0 ;
+      transmit (ioChannel, inNowMicros) ;
+      break ;
+    case FLOW_STATUS_WAIT :
+      ioChannel.mTxWaitCount += 1 ;
+      if (ioChannel.mTxWaitCount > ioChannel.mSettings.mMaxWaitFrameCount) {
+        ioChannel.mTxState = kTxIdle ;
+        ioChannel.mTxStatus = kAborted ;
+      }else{
+        ioChannel.mTxDeadline = inNowMicros + ioChannel.mSettings.mTimeout ;
+      }
+      break ;
+    case FLOW_STATUS_OVERFLOW :
+      ioChannel.mTxState = kTxIdle ;
+      ioChannel.mTxStatus = kReceiverOverflow ;
+      break ;
+    default :
+      ioChannel.mTxState = kTxIdle ;
+      ioChannel.mTxStatus = kAborted ;
+      break ;
+    }
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   RECEPTION
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ACANISOTP::handleFirstFrame (Channel & ioChannel, const CANMessage & inFrame, const uint32_t inNowMicros) {
+  uint32_t length = ((uint32_t) (inFrame.data [0] & 0x0F) << 8) | inFrame.data [1] ;
+  uint8_t firstDataIndex = 2 ;
+  uint32_t minimumLength = SINGLE_FRAME_MAX_LEN + 1 ;
+  if (length == 0) { //--- Escape sequence: 32-bit length, only for lengths above the 12-bit range
+    length = ((uint32_t) inFrame.data [2] << 24) | ((uint32_t) inFrame.data [3] << 16)
+           | ((uint32_t) inFrame.data [4] << 8) | inFrame.data [5] ;
+    firstDataIndex = 6 ;
+    minimumLength = FIRST_FRAME_MAX_LEN_12 + 1 ;
+  }
+  if ((inFrame.len < 8) || (length < minimumLength)) {
+    mReceiveErrorCount += 1 ;
+  }else{
+  //--- A first frame while receiving restarts the reception (ISO 15765-2, 9.8.3)
+    if (ioChannel.mRxState == kRxReceiving) {
+      releaseReceiveBuffer (ioChannel) ;
+      mReceiveErrorCount += 1 ;
+    }
+    if ((ioChannel.mRxState == kRxComplete) || !acquireReceiveBuffer (ioChannel, length)) {
+      mReceiveOverflowCount += 1 ;
+      sendFlowControl (ioChannel, FLOW_STATUS_OVERFLOW) ;
+    }else{
+      uint8_t * buffer = mPool + (size_t) ioChannel.mRxBuffer * mPoolBufferSize ;
+      const uint32_t count = 8 - firstDataIndex ;
+      memcpy (buffer, &inFrame.data [firstDataIndex], count) ;
+      ioChannel.mRxLength = length ;
+      ioChannel.mRxOffset = count ;
+      ioChannel.mRxSequenceNumber = 1 ;
+      ioChannel.mRxBlockCounter = ioChannel.mSettings.mBlockSize ;
+      ioChannel.mRxDeadline = inNowMicros + ioChannel.mSettings.mTimeout ;
+      ioChannel.mRxState = kRxReceiving ;
+      ioChannel.mRxFlowControlPending = !sendFlowControl (ioChannel, FLOW_STATUS_CTS) ;
+    }
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ACANISOTP::handleConsecutiveFrame (Channel & ioChannel, const CANMessage & inFrame, const uint32_t inNowMicros) {
+  if (ioChannel.mRxState == kRxReceiving) {
+    if ((inFrame.data [0] & 0x0F) != ioChannel.mRxSequenceNumber) { //--- Wrong sequence number: abort
+      releaseReceiveBuffer (ioChannel) ;
+      mReceiveErrorCount += 1 ;
+    }else{
+      const uint32_t remaining = ioChannel.mRxLength - ioChannel.mRxOffset ;
+      const uint32_t count = (remaining < 7) ? remaining : 7 ;
+      if ((uint32_t) inFrame.len < (count + 1)) {
+        releaseReceiveBuffer (ioChannel) ;
+        mReceiveErrorCount += 1 ;
+      }else{
+        uint8_t * buffer = mPool + (size_t) ioChannel.mRxBuffer * mPoolBufferSize ;
+        memcpy (buffer + ioChannel.mRxOffset, &inFrame.data [1], count) ;
+        ioChannel.mRxOffset += count ;
+        ioChannel.mRxSequenceNumber = (ioChannel.mRxSequenceNumber + 1) & 0x0F ;
+        ioChannel.mRxDeadline = inNowMicros + ioChannel.mSettings.mTimeout ;
+        if (ioChannel.mRxOffset == ioChannel.mRxLength) {
+          ioChannel.mRxState = kRxComplete ;
+          mReceivedMessageCount += 1 ;
+          mReceivedByteCount += ioChannel.mRxLength ;
+        }else if ((ioChannel.mRxBlockCounter > 0) && (--ioChannel.mRxBlockCounter == 0)) {
+          ioChannel.mRxBlockCounter = ioChannel.mSettings.mBlockSize ;
+          ioChannel.mRxFlowControlPending = !sendFlowControl (ioChannel, FLOW_STATUS_CTS) ;
+        }
+      }
+    }
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+bool ACANISOTP::handleReceivedFrame (const CANMessage & inFrame, const uint32_t inNowMicros) {
+  Channel * channel = NULL ;
+  for (uint8_t i=0 ; (i<mChannelCount) && (channel == NULL) ; i++) {
+    if ((mChannels [i].mSettings.mReceiveIdentifier == inFrame.id) && (mChannels [i].mSettings.mExtended == inFrame.ext)) {
+      channel = &mChannels [i] ;
+    }
+  }
+  const bool accepted = (channel != NULL) && !inFrame.rtr && (inFrame.len > 0) ;
+  if (accepted) {
+    switch (inFrame.data [0] & 0xF0) {
+    case PCI_SINGLE_FRAME :
+      {
+        const uint8_t length = inFrame.data [0] & 0x0F ;
+        if ((length == 0) || (length > SINGLE_FRAME_MAX_LEN) || (length >= inFrame.len)) {
+          mReceiveErrorCount += 1 ;
+        }else{
+          if (channel->mRxState == kRxReceiving) { //--- A single frame while receiving aborts the reception
+            releaseReceiveBuffer (*channel) ;
+            mReceiveErrorCount += 1 ;
+          }
+          if ((channel->mRxState == kRxComplete) || !acquireReceiveBuffer (*channel, length)) {
+            mReceiveOverflowCount += 1 ;
+          }else{
+            memcpy (mPool + (size_t) channel->mRxBuffer * mPoolBufferSize, &inFrame.data [1], length) ;
+            channel->mRxLength = length ;
+            channel->mRxOffset = length ;
+            channel->mRxState = kRxComplete ;
+            mReceivedMessageCount += 1 ;
+            mReceivedByteCount += length ;
+          }
+        }
+      }
+      break ;
+    case PCI_FIRST_FRAME :
+      handleFirstFrame (*channel, inFrame, inNowMicros) ;
+      break ;
+    case PCI_CONSECUTIVE_FRAME :
+      handleConsecutiveFrame (*channel, inFrame, inNowMicros) ;
+      break ;
+    case PCI_FLOW_CONTROL :
+      handleFlowControl (*channel, inFrame, inNowMicros) ;
+      break ;
+    default :
+      mReceiveErrorCount += 1 ;
+      break ;
+    }
+  }
+  return accepted ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+bool ACANISOTP::receive (const uint8_t inChannel, const uint8_t * & outData, uint32_t & outLength) const {
+  const bool ok = (inChannel < mChannelCount) && (mChannels [inChannel].mRxState == kRxComplete) ;
+  if (ok) {
+    const Channel & channel = mChannels [inChannel] ;
+    outData = mPool + (size_t) channel.mRxBuffer * mPoolBufferSize ;
+    outLength = channel.mRxLength ;
+  }
+  return ok ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ACANISOTP::release (const uint8_t inChannel) {
+  if ((inChannel < mChannelCount) && (mChannels [inChannel].mRxState == kRxComplete)) {
+    releaseReceiveBuffer (mChannels [inChannel]) ;
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   POLL
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ACANISOTP::poll (const uint32_t inNowMicros) {
+  for (uint8_t i=0 ; i<mChannelCount ; i++) {
+    Channel & channel = mChannels [i] ;
+  //--- Transmit side
+    const bool waiting = (channel.mTxState == kTxFirstFrame) || (channel.mTxState == kTxWaitFlowControl) ;
+    if (waiting && dateReached (inNowMicros, channel.mTxDeadline)) {
+      channel.mTxState = kTxIdle ;
+      channel.mTxStatus = kTimeout ;
+    }else{
+      transmit (channel, inNowMicros) ;
+    }
+  //--- Receive side
+    if (channel.mRxState == kRxReceiving) {
+      if (dateReached (inNowMicros, channel.mRxDeadline)) {
+        releaseReceiveBuffer (channel) ;
+        mReceiveErrorCount += 1 ;
+      }else if (channel.mRxFlowControlPending) {
+        channel.mRxFlowControlPending = !sendFlowControl (channel, FLOW_STATUS_CTS) ;
+      }
+    }
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
@@ -0,0 +1,227 @@
+/******************************************************************************/
+/* File name        : ACANISOTP.h                                             */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Description      : ISO 15765-2 (ISO-TP) transport layer                    */
+/*                    Works on top of any driver with tryToSend / receive     */
+/*                    (ESP32ACAN, ACAN2515, desktop VirtualCANNode)           */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation                                                        */
+/* ---------------------------------------------------------------------------*/
+
+#ifndef ACAN_ISOTP_CLASS_DEFINED
+#define ACAN_ISOTP_CLASS_DEFINED
+
+/*------------------------------- Include files ------------------------------*/
+#include "CANMessage.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+//   Channel settings (normal addressing: one transmit and one receive identifier per channel)
+//----------------------------------------------------------------------------------------------------------------------
+
+class ACANISOTPChannelSettings {
+  public: uint32_t mTransmitIdentifier = 0x7E0 ;
+  public: uint32_t mReceiveIdentifier = 0x7E8 ;
+  public: bool mExtended = false ;             // Identifier format of both identifiers
+  public: uint8_t mBlockSize = 0 ;             // BS sent in our flow control frames (0: no further flow control)
+  public: uint8_t mSeparationTime = 0 ;        // STmin sent in our flow control frames (ISO-TP encoding)
+  public: bool mPadding = true ;               // Pad every frame to 8 bytes
+  public: uint8_t mPaddingByte = 0xCC ;
+  public: uint32_t mTimeout = 1000UL * 1000UL ;// N_As / N_Bs / N_Cr timeout, in µs
+  public: uint8_t mMaxWaitFrameCount = 16 ;    // WFTmax: FC.WAIT frames accepted before aborting
+} ;
+
+//----------------------------------------------------------------------------------------------------------------------
+//   Send routine: called for every frame the engine emits, returns false if the driver transmit buffer is full
+//----------------------------------------------------------------------------------------------------------------------
+
+typedef bool (*ACANISOTPSendRoutine) (void * inDriver, const CANMessage & inMessage) ;
+
+//----------------------------------------------------------------------------------------------------------------------
+//   ISO-TP engine
+//----------------------------------------------------------------------------------------------------------------------
+// Transmission is zero-copy: send () keeps a pointer to the caller buffer, that must stay valid until transmitStatus ()
+// is no longer kInProgress. Segmented messages are received into a fixed pool of buffers allocated by begin;
+// receive () returns a pointer into the pool, the buffer is given back with release ().
+// Driving the engine:
+//   CANMessage frame ;
+//   while (can.receive (frame)) {
+//     isotp.handleReceivedFrame (frame, micros ()) ;
+//   }
+//   isotp.send (channel, data, length, micros ()) ; // A message to send
+//   isotp.poll (micros ()) ;
+// Messages longer than 4095 bytes use the 32-bit first frame length escape (ISO 15765-2:2016); a received escape with
+// a length that fits in 12 bits is not canonical, and is rejected as a receive error.
+
+class ACANISOTP {
+
+//······················································································································
+//   CONSTRUCTORS
+//······················································································································
+
+  public: ACANISOTP (ACANISOTPSendRoutine inSendRoutine, void * inDriver) ;
+
+  public: template <typename DRIVER> ACANISOTP (DRIVER & inDriver) :
+  ACANISOTP (sendThroughDriver <DRIVER>, &inDriver) {
+  }
+
+  public: ~ ACANISOTP (void) ;
+
+//······················································································································
+//   Initialisation: returns 0 if ok, otherwise see error codes below
+//······················································································································
+
+  public: uint32_t begin (const uint8_t inChannelCount,
+                          const uint8_t inReceiveBufferCount,
+                          const uint32_t inReceiveBufferSize) ;
+
+  public: static const uint32_t kCannotAllocateChannels        = 1 << 0 ;
+  public: static const uint32_t kCannotAllocateReceiveBuffers  = 1 << 1 ;
+  public: static const uint32_t kTooManyReceiveBuffers         = 1 << 2 ;
+
+//······················································································································
+//   Channels: returns the channel index, or kInvalidChannel if all channels are configured
+//······················································································································
+
+  public: static const uint8_t kInvalidChannel = 0xFF ;
+
+  public: uint8_t addChannel (const ACANISOTPChannelSettings & inSettings) ;
+
+//······················································································································
+//   Transmission
+//······················································································································
+
+  public: typedef enum : uint8_t {
+    kIdle,
+    kInProgress,
+    kDone,
+    kTimeout,          // First frame not sent, or no flow control frame, within mTimeout
+    kReceiverOverflow, // Receiver answered FC.OVFLW
+    kAborted           // Too many FC.WAIT, or invalid flow status
+  } TransmitStatus ;
+
+  //--- Returns false if the channel is already transmitting, or the length is 0. inNowMicros dates the first frame
+  //    (flow control timeout), as in handleReceivedFrame and poll.
+  public: bool send (const uint8_t inChannel, const uint8_t * inData, const uint32_t inLength,
+                     const uint32_t inNowMicros) ;
+
+  public: TransmitStatus transmitStatus (const uint8_t inChannel) const ;
+
+//······················································································································
+//   Reception
+//······················································································································
+
+  public: bool handleReceivedFrame (const CANMessage & inFrame, const uint32_t inNowMicros) ;
+
+  //--- Returns true if a complete message is available; outData points into the receive buffer pool
+  public: bool receive (const uint8_t inChannel, const uint8_t * & outData, uint32_t & outLength) const ;
+
+  public: void release (const uint8_t inChannel) ;
+
+//······················································································································
+//   Timing: sends pending consecutive and flow control frames, handles timeouts
+//······················································································································
+
+  public: void poll (const uint32_t inNowMicros) ;
+
+//······················································································································
+//   Statistics
+//······················································································································
+
+  public: inline uint32_t transmittedMessageCount (void) const { return mTransmittedMessageCount ; }
+  public: inline uint32_t receivedMessageCount (void) const { return mReceivedMessageCount ; }
+  public: inline uint64_t transmittedByteCount (void) const { return mTransmittedByteCount ; }
+  public: inline uint64_t receivedByteCount (void) const { return mReceivedByteCount ; }
+  public: inline uint32_t receiveErrorCount (void) const { return mReceiveErrorCount ; }
+  public: inline uint32_t receiveOverflowCount (void) const { return mReceiveOverflowCount ; }
+
+//······················································································································
+//   Private
+//······················································································································
+
+  private: template <typename DRIVER> static bool sendThroughDriver (void * inDriver, const CANMessage & inMessage) {
+    return ((DRIVER *) inDriver)->tryToSend (inMessage) ;
+  }
+
+  private: typedef enum : uint8_t {
+    kTxIdle,
+    kTxFirstFrame,         // Single or first frame not accepted by the driver yet
+    kTxWaitFlowControl,
+    kTxConsecutiveFrames
+  } TransmitState ;
+
+  private: typedef enum : uint8_t {
+    kRxIdle,
+    kRxReceiving,
+    kRxComplete
+  } ReceiveState ;
+
+  private: class Channel {
+    public: ACANISOTPChannelSettings mSettings ;
+  //--- Transmit side
+    public: const uint8_t * mTxData ;
+    public: uint32_t mTxLength ;
+    public: uint32_t mTxOffset ;
+    public: uint32_t mTxNextFrameDate ;
+    public: uint32_t mTxDeadline ;
+    public: uint32_t mTxSeparationTime ;  // µs
+    public: uint8_t mTxSequenceNumber ;
+    public: uint8_t mTxBlockRemaining ;   // 0: no further flow control
+    public: uint8_t mTxWaitCount ;
+    public: TransmitState mTxState ;
+    public: TransmitStatus mTxStatus ;
+  //--- Receive side
+    public: uint32_t mRxLength ;
+    public: uint32_t mRxOffset ;
+    public: uint32_t mRxDeadline ;
+    public: uint8_t mRxBuffer ;
+    public: uint8_t mRxSequenceNumber ;
+    public: uint8_t mRxBlockCounter ;
+    public: bool mRxFlowControlPending ;
+    public: ReceiveState mRxState ;
+  } ;
+
+  private: void initFrame (const Channel & inChannel, CANMessage & outFrame) const ;
+  private: bool sendFlowControl (Channel & ioChannel, const uint8_t inFlowStatus) ;
+  private: void transmit (Channel & ioChannel, const uint32_t inNowMicros) ;
+  private: void handleFlowControl (Channel & ioChannel, const CANMessage & inFrame, const uint32_t inNowMicros) ;
+  private: void handleFirstFrame (Channel & ioChannel, const CANMessage & inFrame, const uint32_t inNowMicros) ;
+  private: void handleConsecutiveFrame (Channel & ioChannel, const CANMessage & inFrame, const uint32_t inNowMicros) ;
+  private: bool acquireReceiveBuffer (Channel & ioChannel, const uint32_t inLength) ;
+  private: void releaseReceiveBuffer (Channel & ioChannel) ;
+  private: static uint32_t separationTimeMicros (const uint8_t inSTmin) ;
+
+  private: ACANISOTPSendRoutine mSendRoutine ;
+  private: void * mDriver ;
+  private: Channel * mChannels ;
+  private: uint8_t mChannelCapacity ;
+  private: uint8_t mChannelCount ;
+  private: uint8_t * mPool ;
+  private: uint32_t mPoolBufferSize ;
+  private: uint8_t mPoolBufferCount ;
+  private: uint32_t mFreePoolBuffers ;   // Bit i set: buffer i is free
+  private: uint32_t mTransmittedMessageCount ;
+  private: uint32_t mReceivedMessageCount ;
+  private: uint64_t mTransmittedByteCount ;
+  private: uint64_t mReceivedByteCount ;
+  private: uint32_t mReceiveErrorCount ;
+  private: uint32_t mReceiveOverflowCount ;
+
+//······················································································································
+//   No copy
+//······················································································································
+
+  private: ACANISOTP (const ACANISOTP &) = delete ;
+  private: ACANISOTP & operator = (const ACANISOTP &) = delete ;
+} ;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#endif
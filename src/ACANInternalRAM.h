@@ -0,0 +1,61 @@
+/******************************************************************************/
+/* File name        : ACANInternalRAM.h                                       */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Description      : Arrays used by the CAN interrupt, in internal RAM       */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation                                                        */
+/* ---------------------------------------------------------------------------*/
+
+#ifndef ACAN_INTERNAL_RAM_DEFINED
+#define ACAN_INTERNAL_RAM_DEFINED
+
+/*------------------------------- Include files ------------------------------*/
+#include "CANMessage.h"
+#include <new>
+#ifdef ARDUINO
+  #include <esp_heap_caps.h>
+#endif
+
+//----------------------------------------------------------------------------------------------------------------------
+// On the ESP32, the CAN interrupt may run while the flash cache is disabled (flash writes), and external PSRAM is
+// reached through this cache: the arrays it reads or writes are allocated in internal RAM, whatever the malloc
+// settings. On the desktop, operator new. Element types have a trivial destructor.
+// A null count returns nullptr on both, as heap_caps_malloc (0) does: callers accept it for an empty array.
+//----------------------------------------------------------------------------------------------------------------------
+
+template <typename T> T * allocateInternalRAMArray (const uint32_t inCount) {
+  if (inCount == 0) {
+    return nullptr ;
+  }
+  #ifdef ARDUINO
+    T * array = (T *) heap_caps_malloc (inCount * sizeof (T), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT) ;
+    for (uint32_t i=0 ; (array != nullptr) && (i<inCount) ; i++) {
+      new (&array [i]) T () ;
+    }
+    return array ;
+  #else
+    return new (std::nothrow) T [inCount] ;
+  #endif
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <typename T> void freeInternalRAMArray (T * inArray) {
+  #ifdef ARDUINO
+    heap_caps_free (inArray) ;
+  #else
+    delete [] inArray ;
+  #endif
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,702 @@
+/******************************************************************************/
+/* File name        : ACANJ1939.cpp                                           */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Description      : SAE J1939 PGN routing, transport protocol (BAM and      */
+/*                    RTS/CTS) and address claim                              */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation                                                        */
+/* ---------------------------------------------------------------------------*/
+
+/*------------------------------- Include files ------------------------------*/
+#include "ACANJ1939.h"
+#include <string.h>
+
+/*------------------------------- Local defines ------------------------------*/
+//--- Parameter group numbers
+#define PGN_REQUEST              (0xEA00)
+#define PGN_ADDRESS_CLAIMED      (0xEE00)
+#define PGN_TP_CM                (0xEC00)
+#define PGN_TP_DT                (0xEB00)
+
+//--- TP.CM control bytes
+#define TP_CM_RTS                (16)
+#define TP_CM_CTS                (17)
+#define TP_CM_EOMA               (19)
+#define TP_CM_BAM                (32)
+#define TP_CM_ABORT              (255)
+
+//--- TP.CM abort reasons
+#define ABORT_ALREADY_IN_SESSION (1)
+#define ABORT_NO_RESOURCES       (2)
+#define ABORT_TIMEOUT            (3)
+
+//--- Addresses
+#define GLOBAL_ADDRESS           (0xFF)
+#define NULL_ADDRESS             (0xFE)
+#define FIRST_ARBITRARY_ADDRESS  (128)
+#define LAST_ARBITRARY_ADDRESS   (247)
+
+//--- Timeouts (ms, SAE J1939-21)
+#define TIMEOUT_T1               (750)   // Between BAM data packets
+#define TIMEOUT_T2               (1250)  // After CTS, waiting for data
+#define TIMEOUT_T3               (1250)  // After last data packet, waiting for CTS or EOMA
+#define TIMEOUT_T4               (1050)  // After CTS (hold), waiting for the next CTS
+#define ADDRESS_CLAIM_DELAY      (250)
+
+#define TP_PRIORITY              (7)
+#define ADDRESS_CLAIM_PRIORITY   (6)
+#define NO_SESSION               (0xFF)
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static inline bool dateReached (const uint32_t inNow, const uint32_t inDate) {
+  return (int32_t) (inNow - inDate) >= 0 ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static inline uint32_t readPGN (const uint8_t * inData) {
+  return (uint32_t) inData [0] | ((uint32_t) inData [1] << 8) | ((uint32_t) inData [2] << 16) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   CONSTRUCTOR
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+ACANJ1939::ACANJ1939 (ACANJ1939SendRoutine inSendRoutine, void * inDriver) :
+mSendRoutine (inSendRoutine),
+mDriver (inDriver),
+mRoutes (NULL),
+mRouteMask (0),
+mDefaultHandler (NULL),
+mDefaultContext (NULL),
+mSessions (NULL),
+mSessionCount (0),
+mName (0),
+mAddress (NULL_ADDRESS),
+mAddressState (kNoAddress),
+mClaimPending (false),
+mClaimDeadline (0),
+mRoutedMessageCount (0),
+mUnroutedMessageCount (0),
+mSessionOverflowCount (0),
+mAbortedSessionCount (0),
+mCompletedTransmitCount (0) {
+  memset (mBAMSessionOfSource, NO_SESSION, sizeof (mBAMSessionOfSource)) ;
+  memset (mRTSSessionOfSource, NO_SESSION, sizeof (mRTSSessionOfSource)) ;
+  memset (mAddressInUse, 0, sizeof (mAddressInUse)) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   BEGIN
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+bool ACANJ1939::begin (ACANJ1939Route * inRoutes,
+                       const uint16_t inRouteCapacity,
+                       ACANJ1939Session * inSessions,
+                       const uint8_t inSessionCount) {
+  const bool ok = (inRoutes != NULL)
+    && (inRouteCapacity > 1)
+    && ((inRouteCapacity & (inRouteCapacity - 1)) == 0)
+    && ((inSessions != NULL) || (inSessionCount == 0))
+    && (inSessionCount < NO_SESSION) ;
+  if (ok) {
+    mRoutes = inRoutes ;
+    mRouteMask = inRouteCapacity - 1 ;
+    for (uint32_t i=0 ; i<inRouteCapacity ; i++) {
+      mRoutes [i] = ACANJ1939Route () ;
+    }
+    mSessions = inSessions ;
+    mSessionCount = inSessionCount ;
+    for (uint8_t i=0 ; i<inSessionCount ; i++) {
+      mSessions [i].mKind = ACANJ1939Session::kFree ;
+    }
+    memset (mBAMSessionOfSource, NO_SESSION, sizeof (mBAMSessionOfSource)) ;
+    memset (mRTSSessionOfSource, NO_SESSION, sizeof (mRTSSessionOfSource)) ;
+    memset (mAddressInUse, 0, sizeof (mAddressInUse)) ;
+    mAddressState = kNoAddress ;
+    mAddress = NULL_ADDRESS ;
+  }
+  return ok ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   Identifiers
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  28 ... 26 | 25  | 24 | 23 ... 16 | 15 ... 8 | 7 ... 0
+//  Priority  | EDP | DP |    PF     |    PS    |   SA
+//  PS is the destination address if PF < 240 (PDU1), the group extension otherwise (PDU2)
+
+uint32_t ACANJ1939::pgnOfIdentifier (const uint32_t inIdentifier) {
+  const uint32_t pf = (inIdentifier >> 16) & 0xFF ;
+  uint32_t pgn = (inIdentifier >> 8) & 0x3FF00 ;
+  if (pf >= 240) {
+    pgn |= (inIdentifier >> 8) & 0xFF ;
+  }
+  return pgn ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+uint32_t ACANJ1939::identifier (const uint32_t inPGN,
+                                const uint8_t inPriority,
+                                const uint8_t inDestination,
+                                const uint8_t inSource) {
+  const uint32_t pf = (inPGN >> 8) & 0xFF ;
+  const uint32_t ps = (pf < 240) ? inDestination : (inPGN & 0xFF) ;
+  return ((uint32_t) (inPriority & 7) << 26) | ((inPGN & 0x3FF00) << 8) | (ps << 8) | inSource ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   PGN ROUTING (open addressing, multiplicative hash, linear probing)
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static inline uint16_t routeHash (const uint32_t inPGN) {
+  return (uint16_t) ((inPGN * 2654435761UL) >> 16) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+ACANJ1939Route * ACANJ1939::findRoute (const uint32_t inPGN) const {
+  ACANJ1939Route * result = NULL ;
+  if (mRoutes != NULL) {
+    uint16_t index = routeHash (inPGN) & mRouteMask ;
+    while ((result == NULL) && (mRoutes [index].mPGN != UINT32_MAX)) {
+      if (mRoutes [index].mPGN == inPGN) {
+        result = &mRoutes [index] ;
+      }
+      index = (index + 1) & mRouteMask ;
+    }
+  }
+  return result ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+bool ACANJ1939::addRoute (const uint32_t inPGN, ACANJ1939Handler inHandler, void * inContext) {
+  bool ok = (mRoutes != NULL) && (inPGN <= 0x3FFFF) ;
+  if (ok) {
+    ACANJ1939Route * route = findRoute (inPGN) ;
+    if (route == NULL) {
+    //--- Keep at least one free slot, so that probing always terminates
+      uint32_t used = 0 ;
+      for (uint32_t i=0 ; i<=mRouteMask ; i++) {
+        used += mRoutes [i].mPGN != UINT32_MAX ;
+      }
+      ok = used < mRouteMask ;
+      if (ok) {
+        uint16_t index = routeHash (inPGN) & mRouteMask ;
+        while (mRoutes [index].mPGN != UINT32_MAX) {
+          index = (index + 1) & mRouteMask ;
+        }
+        route = &mRoutes [index] ;
+        route->mPGN = inPGN ;
+      }
+    }
+    if (ok) {
+      route->mHandler = inHandler ;
+      route->mContext = inContext ;
+    }
+  }
+  return ok ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ACANJ1939::setDefaultHandler (ACANJ1939Handler inHandler, void * inContext) {
+  mDefaultHandler = inHandler ;
+  mDefaultContext = inContext ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ACANJ1939::route (const ACANJ1939Message & inMessage) {
+  const ACANJ1939Route * route = findRoute (inMessage.mPGN) ;
+  if (route != NULL) {
+    mRoutedMessageCount += 1 ;
+    route->mHandler (route->mContext, inMessage) ;
+  }else{
+    mUnroutedMessageCount += 1 ;
+    if (mDefaultHandler != NULL) {
+      mDefaultHandler (mDefaultContext, inMessage) ;
+    }
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   FRAME TRANSMISSION
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+bool ACANJ1939::sendFrame (const uint32_t inPGN, const uint8_t inPriority, const uint8_t inDestination,
+                           const uint8_t inSource, const uint8_t * inData, const uint8_t inLength) {
+  CANMessage frame ;
+  frame.id = identifier (inPGN, inPriority, inDestination, inSource) ;
+  frame.ext = true ;
+  frame.len = inLength ;
+  memcpy (frame.data, inData, inLength) ;
+  return mSendRoutine (mDriver, frame) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+bool ACANJ1939::sendConnectionManagement (ACANJ1939Session & ioSession, const uint8_t inControlByte) {
+  uint8_t data [8] ;
+  data [0] = inControlByte ;
+  if (inControlByte == TP_CM_CTS) {
+    const uint8_t remaining = (uint8_t) (ioSession.mPacketCount - ioSession.mNextPacket + 1) ;
+    uint8_t window = (remaining < mPacketsPerCTS) ? remaining : mPacketsPerCTS ;
+    if (window > ioSession.mMaxPacketsPerCTS) {
+      window = ioSession.mMaxPacketsPerCTS ;
+    }
+    ioSession.mWindowEnd = ioSession.mNextPacket + window - 1 ;
+    data [1] = window ;
+    data [2] = (uint8_t) ioSession.mNextPacket ;
+    data [3] = 0xFF ;
+    data [4] = 0xFF ;
+  }else{ //--- RTS, BAM, EOMA
+    data [1] = (uint8_t) ioSession.mSize ;
+    data [2] = (uint8_t) (ioSession.mSize >> 8) ;
+    data [3] = ioSession.mPacketCount ;
+    data [4] = 0xFF ;
+  }
+  data [5] = (uint8_t) ioSession.mPGN ;
+  data [6] = (uint8_t) (ioSession.mPGN >> 8) ;
+  data [7] = (uint8_t) (ioSession.mPGN >> 16) ;
+  const uint8_t destination = (ioSession.mKind == ACANJ1939Session::kTransmitBAM) ? GLOBAL_ADDRESS : ioSession.mPeerAddress ;
+  const bool ok = sendFrame (PGN_TP_CM, TP_PRIORITY, destination, mAddress, data, 8) ;
+  ioSession.mControlPending = !ok ;
+  ioSession.mControlByte = inControlByte ;
+  return ok ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ACANJ1939::sendAbort (const uint8_t inDestination, const uint32_t inPGN, const uint8_t inReason) {
+  const uint8_t data [8] = {
+    TP_CM_ABORT, inReason, 0xFF, 0xFF, 0xFF,
+    (uint8_t) inPGN, (uint8_t) (inPGN >> 8), (uint8_t) (inPGN >> 16)
+  } ;
+  sendFrame (PGN_TP_CM, TP_PRIORITY, inDestination, mAddress, data, 8) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   SESSIONS
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+ACANJ1939Session * ACANJ1939::allocateSession (void) {
+  ACANJ1939Session * result = NULL ;
+  for (uint8_t i=0 ; (i<mSessionCount) && (result == NULL) ; i++) {
+    if (mSessions [i].mKind == ACANJ1939Session::kFree) {
+      result = &mSessions [i] ;
+      result->mControlPending = false ;
+    }
+  }
+  if (result == NULL) {
+    mSessionOverflowCount += 1 ;
+  }
+  return result ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ACANJ1939::freeSession (ACANJ1939Session & ioSession) {
+  if (ioSession.mKind == ACANJ1939Session::kReceiveBAM) {
+    mBAMSessionOfSource [ioSession.mPeerAddress] = NO_SESSION ;
+  }else if (ioSession.mKind == ACANJ1939Session::kReceiveRTS) {
+    mRTSSessionOfSource [ioSession.mPeerAddress] = NO_SESSION ;
+  }
+  ioSession.mKind = ACANJ1939Session::kFree ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+uint8_t ACANJ1939::transmitSessionCount (void) const {
+  uint8_t result = 0 ;
+  for (uint8_t i=0 ; i<mSessionCount ; i++) {
+    const ACANJ1939Session::Kind kind = mSessions [i].mKind ;
+    result += (kind == ACANJ1939Session::kTransmitBAM) || (kind == ACANJ1939Session::kTransmitRTS) ;
+  }
+  return result ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   TRANSMISSION
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+bool ACANJ1939::send (const uint32_t inPGN,
+                      const uint8_t inPriority,
+                      const uint8_t inDestination,
+                      const uint8_t * inData,
+                      const uint16_t inLength,
+                      const uint32_t inNowMillis) {
+  bool ok = (mAddressState == kAddressClaimed) && (inLength <= ACANJ1939Session::kMaxMessageSize) ;
+  if (ok && (inLength <= 8)) {
+    ok = sendFrame (inPGN, inPriority, inDestination, mAddress, inData, (uint8_t) inLength) ;
+  }else if (ok) {
+    ACANJ1939Session * session = allocateSession () ;
+    ok = session != NULL ;
+    if (ok) {
+      const bool broadcast = (inDestination == GLOBAL_ADDRESS) || (((inPGN >> 8) & 0xFF) >= 240) ;
+      session->mKind = broadcast ? ACANJ1939Session::kTransmitBAM : ACANJ1939Session::kTransmitRTS ;
+      session->mPeerAddress = broadcast ? GLOBAL_ADDRESS : inDestination ;
+      session->mPriority = inPriority ;
+      session->mPGN = inPGN ;
+      session->mSize = inLength ;
+      session->mPacketCount = (uint8_t) ((inLength + 6) / 7) ;
+      session->mNextPacket = 1 ;
+      session->mWindowEnd = 0 ;
+      session->mTransmitData = inData ;
+      session->mDeadline = inNowMillis ;
+      sendConnectionManagement (*session, broadcast ? TP_CM_BAM : TP_CM_RTS) ;
+      if (!session->mControlPending) {
+        session->mDeadline = inNowMillis + (broadcast ? mBAMPacketInterval : TIMEOUT_T3) ;
+      }
+    }
+  }
+  return ok ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+// BAM: one data packet every mBAMPacketInterval. RTS/CTS: every packet of the window granted by the last CTS is pushed
+// to the driver at once, then the session waits (T3) for the next CTS or the end of message acknowledge.
+
+void ACANJ1939::transmit (ACANJ1939Session & ioSession, const uint32_t inNowMillis) {
+  const bool broadcast = ioSession.mKind == ACANJ1939Session::kTransmitBAM ;
+  if (ioSession.mControlPending) {
+    sendConnectionManagement (ioSession, ioSession.mControlByte) ;
+    if (!ioSession.mControlPending) {
+      ioSession.mDeadline = inNowMillis + (broadcast ? mBAMPacketInterval : TIMEOUT_T3) ;
+    }
+  }else{
+    const uint16_t lastPacket = broadcast ? ioSession.mNextPacket : ioSession.mWindowEnd ;
+    bool loop = (ioSession.mNextPacket <= lastPacket)
+      && (ioSession.mNextPacket <= ioSession.mPacketCount)
+      && (!broadcast || dateReached (inNowMillis, ioSession.mDeadline)) ;
+    while (loop) {
+      uint8_t data [8] ;
+      const uint32_t offset = 7UL * (ioSession.mNextPacket - 1) ;
+      const uint32_t count = ((ioSession.mSize - offset) < 7) ? (ioSession.mSize - offset) : 7 ;
+      data [0] = (uint8_t) ioSession.mNextPacket ;
+      memset (&data [1], 0xFF, 7) ;
+      memcpy (&data [1], ioSession.mTransmitData + offset, count) ;
+      loop = sendFrame (PGN_TP_DT, TP_PRIORITY, ioSession.mPeerAddress, mAddress, data, 8) ;
+      if (loop) {
+        ioSession.mNextPacket += 1 ;
+        if (broadcast && (ioSession.mNextPacket > ioSession.mPacketCount)) {
+          mCompletedTransmitCount += 1 ;
+          freeSession (ioSession) ;
+          loop = false ;
+        }else if (broadcast) {
+          ioSession.mDeadline = inNowMillis + mBAMPacketInterval ;
+          loop = false ;
+        }else if ((ioSession.mNextPacket > ioSession.mWindowEnd) || (ioSession.mNextPacket > ioSession.mPacketCount)) {
+          ioSession.mDeadline = inNowMillis + TIMEOUT_T3 ;
+          loop = false ;
+        }
+      }
+    }
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   ADDRESS CLAIM
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+bool ACANJ1939::sendAddressClaimed (void) {
+  uint8_t data [8] ;
+  for (uint8_t i=0 ; i<8 ; i++) {
+    data [i] = (uint8_t) (mName >> (8 * i)) ;
+  }
+  const uint8_t source = (mAddressState == kCannotClaim) ? NULL_ADDRESS : mAddress ;
+  const bool ok = sendFrame (PGN_ADDRESS_CLAIMED, ADDRESS_CLAIM_PRIORITY, GLOBAL_ADDRESS, source, data, 8) ;
+  mClaimPending = !ok ;
+  return ok ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ACANJ1939::claimAddress (const uint64_t inName, const uint8_t inPreferredAddress, const uint32_t inNowMillis) {
+  mName = inName ;
+  mAddress = inPreferredAddress ;
+  mAddressState = kClaiming ;
+  mClaimDeadline = inNowMillis + ADDRESS_CLAIM_DELAY ;
+  sendAddressClaimed () ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+// Address lost: an arbitrary address capable node (NAME bit 63) claims a free address in 128 ... 247, otherwise it
+// sends a cannot claim address message (source address 254).
+
+void ACANJ1939::selectNewAddress (const uint32_t inNowMillis) {
+  const bool arbitraryAddressCapable = (mName >> 63) != 0 ;
+  uint16_t newAddress = NULL_ADDRESS ;
+  if (arbitraryAddressCapable) {
+    for (uint16_t a = FIRST_ARBITRARY_ADDRESS ; (a <= LAST_ARBITRARY_ADDRESS) && (newAddress == NULL_ADDRESS) ; a++) {
+      if ((a != mAddress) && ((mAddressInUse [a >> 5] & (1UL << (a & 31))) == 0)) {
+        newAddress = a ;
+      }
+    }
+  }
+  if (newAddress != NULL_ADDRESS) {
+    claimAddress (mName, (uint8_t) newAddress, inNowMillis) ;
+  }else{
+    mAddressState = kCannotClaim ;
+    mAddress = NULL_ADDRESS ;
+    sendAddressClaimed () ;
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ACANJ1939::handleAddressClaimed (const CANMessage & inFrame, const uint8_t inSource, const uint32_t inNowMillis) {
+  if ((inFrame.len == 8) && (inSource != NULL_ADDRESS)) {
+    mAddressInUse [inSource >> 5] |= 1UL << (inSource & 31) ;
+    uint64_t name = 0 ;
+    for (uint8_t i=0 ; i<8 ; i++) {
+      name |= (uint64_t) inFrame.data [i] << (8 * i) ;
+    }
+    const bool contention = ((mAddressState == kClaiming) || (mAddressState == kAddressClaimed))
+      && (inSource == mAddress)
+      && (name != mName) ;
+    if (contention) {
+      if (mName < name) { //--- Lower NAME has priority: defend the address
+        sendAddressClaimed () ;
+      }else{
+        selectNewAddress (inNowMillis) ;
+      }
+    }
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   TRANSPORT PROTOCOL RECEPTION
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ACANJ1939::handleConnectionManagement (const CANMessage & inFrame,
+                                            const uint8_t inSource,
+                                            const uint8_t inDestination,
+                                            const uint32_t inNowMillis) {
+  if (inFrame.len == 8) {
+    const uint8_t control = inFrame.data [0] ;
+    const uint32_t pgn = readPGN (&inFrame.data [5]) ;
+    const uint16_t size = (uint16_t) (inFrame.data [1] | (inFrame.data [2] << 8)) ;
+    const uint8_t packetCount = inFrame.data [3] ;
+    const bool validSize = (size > 8) && (size <= ACANJ1939Session::kMaxMessageSize) && (packetCount == ((size + 6) / 7)) ;
+    const bool toUs = (inDestination == mAddress) && (mAddressState == kAddressClaimed) ;
+    switch (control) {
+    case TP_CM_BAM :
+    case TP_CM_RTS :
+      if (validSize && ((control == TP_CM_BAM) ? (inDestination == GLOBAL_ADDRESS) : toUs)) {
+        uint8_t * sessionTable = (control == TP_CM_BAM) ? mBAMSessionOfSource : mRTSSessionOfSource ;
+        if (sessionTable [inSource] != NO_SESSION) { //--- A new announce replaces the session in progress
+          freeSession (mSessions [sessionTable [inSource]]) ;
+          mAbortedSessionCount += 1 ;
+        }
+        ACANJ1939Session * session = allocateSession () ;
+        if (session == NULL) {
+          if (control == TP_CM_RTS) {
+            sendAbort (inSource, pgn, ABORT_NO_RESOURCES) ;
+          }
+        }else{
+          session->mKind = (control == TP_CM_BAM) ? ACANJ1939Session::kReceiveBAM : ACANJ1939Session::kReceiveRTS ;
+          session->mPeerAddress = inSource ;
+          session->mPriority = (uint8_t) ((inFrame.id >> 26) & 7) ;
+          session->mPGN = pgn ;
+          session->mSize = size ;
+          session->mPacketCount = packetCount ;
+          session->mNextPacket = 1 ;
+          session->mMaxPacketsPerCTS = inFrame.data [4] ;
+          sessionTable [inSource] = (uint8_t) (session - mSessions) ;
+          if (control == TP_CM_BAM) {
+            session->mDeadline = inNowMillis + TIMEOUT_T1 ;
+          }else{
+            sendConnectionManagement (*session, TP_CM_CTS) ;
+            session->mDeadline = inNowMillis + TIMEOUT_T2 ;
+          }
+        }
+      }
+      break ;
+    case TP_CM_CTS :
+    case TP_CM_EOMA :
+    case TP_CM_ABORT :
+      if (toUs) {
+        ACANJ1939Session * session = NULL ;
+        for (uint8_t i=0 ; (i<mSessionCount) && (session == NULL) ; i++) {
+          ACANJ1939Session & s = mSessions [i] ;
+          const bool match = (s.mPeerAddress == inSource) && (s.mPGN == pgn) ;
+          if (match && (s.mKind == ACANJ1939Session::kTransmitRTS)) {
+            session = &s ;
+          }else if (match && (control == TP_CM_ABORT) && (s.mKind == ACANJ1939Session::kReceiveRTS)) {
+            session = &s ;
+          }
+        }
+        if (session == NULL) {
+        }else if (control == TP_CM_ABORT) {
+          freeSession (*session) ;
+          mAbortedSessionCount += 1 ;
+        }else if (control == TP_CM_EOMA) {
+          mCompletedTransmitCount += 1 ;
+          freeSession (*session) ;
+        }else if (inFrame.data [1] == 0) { //--- CTS hold
+          session->mDeadline = inNowMillis + TIMEOUT_T4 ;
+        }else if ((inFrame.data [2] >= 1) && (inFrame.data [2] <= session->mPacketCount)) {
+          session->mNextPacket = inFrame.data [2] ;
+          const uint16_t windowEnd = (uint16_t) inFrame.data [2] + inFrame.data [1] - 1 ;
+          session->mWindowEnd = (windowEnd < session->mPacketCount) ? windowEnd : session->mPacketCount ;
+          transmit (*session, inNowMillis) ;
+        }
+      }
+      break ;
+    default :
+      break ;
+    }
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ACANJ1939::handleDataTransfer (const CANMessage & inFrame,
+                                    const uint8_t inSource,
+                                    const uint8_t inDestination,
+                                    const uint32_t inNowMillis) {
+  uint8_t index = NO_SESSION ;
+  if (inDestination == GLOBAL_ADDRESS) {
+    index = mBAMSessionOfSource [inSource] ;
+  }else if ((inDestination == mAddress) && (mAddressState == kAddressClaimed)) {
+    index = mRTSSessionOfSource [inSource] ;
+  }
+  if ((index != NO_SESSION) && (inFrame.len == 8)) {
+    ACANJ1939Session & session = mSessions [index] ;
+    const bool broadcast = session.mKind == ACANJ1939Session::kReceiveBAM ;
+    const uint8_t sequence = inFrame.data [0] ;
+    if (sequence != session.mNextPacket) {
+      if (broadcast) { //--- Lost packet: the message cannot be completed
+        freeSession (session) ;
+        mAbortedSessionCount += 1 ;
+      }else{ //--- Ask again from the expected packet
+        sendConnectionManagement (session, TP_CM_CTS) ;
+        session.mDeadline = inNowMillis + TIMEOUT_T2 ;
+      }
+    }else{
+      const uint32_t offset = 7UL * (sequence - 1) ;
+      const uint32_t count = ((session.mSize - offset) < 7) ? (session.mSize - offset) : 7 ;
+      memcpy (&session.mBuffer [offset], &inFrame.data [1], count) ;
+      session.mNextPacket += 1 ;
+      session.mDeadline = inNowMillis + (broadcast ? TIMEOUT_T1 : TIMEOUT_T2) ;
+      if (sequence == session.mPacketCount) {
+        if (!broadcast) {
+          sendConnectionManagement (session, TP_CM_EOMA) ;
+        }
+        ACANJ1939Message message ;
+        message.mPGN = session.mPGN ;
+        message.mPriority = session.mPriority ;
+        message.mSourceAddress = inSource ;
+        message.mDestinationAddress = inDestination ;
+        message.mLength = session.mSize ;
+        message.mData = session.mBuffer ;
+        freeSession (session) ;
+        route (message) ;
+      }else if (!broadcast && (sequence == session.mWindowEnd)) {
+        sendConnectionManagement (session, TP_CM_CTS) ;
+      }
+    }
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   RECEPTION
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+bool ACANJ1939::handleReceivedFrame (const CANMessage & inFrame, const uint32_t inNowMillis) {
+  const bool accepted = inFrame.ext && !inFrame.rtr ;
+  if (accepted) {
+    const uint8_t source = (uint8_t) inFrame.id ;
+    const uint32_t pgn = pgnOfIdentifier (inFrame.id) ;
+    const uint8_t destination = (((pgn >> 8) & 0xFF) < 240) ? (uint8_t) (inFrame.id >> 8) : GLOBAL_ADDRESS ;
+    switch (pgn) {
+    case PGN_TP_CM :
+      handleConnectionManagement (inFrame, source, destination, inNowMillis) ;
+      break ;
+    case PGN_TP_DT :
+      handleDataTransfer (inFrame, source, destination, inNowMillis) ;
+      break ;
+    default :
+      if (pgn == PGN_ADDRESS_CLAIMED) {
+        handleAddressClaimed (inFrame, source, inNowMillis) ;
+      }else if ((pgn == PGN_REQUEST) && (inFrame.len >= 3) && (readPGN (inFrame.data) == PGN_ADDRESS_CLAIMED)
+             && ((destination == GLOBAL_ADDRESS) || (destination == mAddress)) && (mAddressState != kNoAddress)) {
+        sendAddressClaimed () ;
+      }
+      if (mPromiscuous || (destination == GLOBAL_ADDRESS) || (destination == mAddress)) {
+        ACANJ1939Message message ;
+        message.mPGN = pgn ;
+        message.mPriority = (uint8_t) ((inFrame.id >> 26) & 7) ;
+        message.mSourceAddress = source ;
+        message.mDestinationAddress = destination ;
+        message.mLength = (inFrame.len <= 8) ? inFrame.len : 8 ;
+        message.mData = inFrame.data ;
+        route (message) ;
+      }
+      break ;
+    }
+  }
+  return accepted ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   POLL
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ACANJ1939::poll (const uint32_t inNowMillis) {
+//--- Address claim
+  if (mClaimPending) {
+    sendAddressClaimed () ;
+  }
+  if ((mAddressState == kClaiming) && !mClaimPending && dateReached (inNowMillis, mClaimDeadline)) {
+    mAddressState = kAddressClaimed ;
+  }
+//--- Sessions
+  for (uint8_t i=0 ; i<mSessionCount ; i++) {
+    ACANJ1939Session & session = mSessions [i] ;
+    switch (session.mKind) {
+    case ACANJ1939Session::kFree :
+      break ;
+    case ACANJ1939Session::kTransmitBAM :
+      transmit (session, inNowMillis) ;
+      break ;
+    case ACANJ1939Session::kTransmitRTS :
+      transmit (session, inNowMillis) ;
+      if (!session.mControlPending
+       && ((session.mNextPacket > session.mWindowEnd) || (session.mNextPacket > session.mPacketCount))
+       && dateReached (inNowMillis, session.mDeadline)) {
+        sendAbort (session.mPeerAddress, session.mPGN, ABORT_TIMEOUT) ;
+        freeSession (session) ;
+        mAbortedSessionCount += 1 ;
+      }
+      break ;
+    case ACANJ1939Session::kReceiveBAM :
+    case ACANJ1939Session::kReceiveRTS :
+      if (session.mControlPending) {
+        sendConnectionManagement (session, session.mControlByte) ;
+      }
+      if (dateReached (inNowMillis, session.mDeadline)) {
+        if (session.mKind == ACANJ1939Session::kReceiveRTS) {
+          sendAbort (session.mPeerAddress, session.mPGN, ABORT_TIMEOUT) ;
+        }
+        freeSession (session) ;
+        mAbortedSessionCount += 1 ;
+      }
+      break ;
+    }
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
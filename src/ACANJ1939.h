@@ -0,0 +1,247 @@
+/******************************************************************************/
+/* File name        : ACANJ1939.h                                             */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Description      : SAE J1939 PGN routing, transport protocol (BAM and      */
+/*                    RTS/CTS) and address claim                              */
+/*                    Works on top of any driver with tryToSend / receive     */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation                                                        */
+/* ---------------------------------------------------------------------------*/
+
+#ifndef ACAN_J1939_CLASS_DEFINED
+#define ACAN_J1939_CLASS_DEFINED
+
+/*------------------------------- Include files ------------------------------*/
+#include "CANMessage.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+//   J1939 message, as delivered to PGN handlers (single frame or reassembled transport protocol message)
+//----------------------------------------------------------------------------------------------------------------------
+
+class ACANJ1939Message {
+  public: uint32_t mPGN = 0 ;
+  public: uint8_t mPriority = 6 ;
+  public: uint8_t mSourceAddress = 0xFE ;
+  public: uint8_t mDestinationAddress = 0xFF ;  // 0xFF: global (and every PDU2 message)
+  public: uint16_t mLength = 0 ;
+  public: const uint8_t * mData = nullptr ;
+} ;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+typedef void (*ACANJ1939Handler) (void * inContext, const ACANJ1939Message & inMessage) ;
+
+typedef bool (*ACANJ1939SendRoutine) (void * inDriver, const CANMessage & inMessage) ;
+
+//----------------------------------------------------------------------------------------------------------------------
+//   PGN route: slot of the PGN hash table (storage provided by the application)
+//----------------------------------------------------------------------------------------------------------------------
+
+class ACANJ1939Route {
+  public: uint32_t mPGN = UINT32_MAX ;   // UINT32_MAX: free slot
+  public: ACANJ1939Handler mHandler = nullptr ;
+  public: void * mContext = nullptr ;
+} ;
+
+//----------------------------------------------------------------------------------------------------------------------
+//   Transport protocol session (storage provided by the application)
+//----------------------------------------------------------------------------------------------------------------------
+
+class ACANJ1939Session {
+  public: static const uint16_t kMaxMessageSize = 1785 ;   // 255 packets of 7 bytes
+
+  public: typedef enum : uint8_t {
+    kFree,
+    kReceiveBAM,
+    kReceiveRTS,
+    kTransmitBAM,
+    kTransmitRTS
+  } Kind ;
+
+  public: Kind mKind = kFree ;
+  public: uint8_t mPeerAddress = 0 ;      // Sender of a received message, destination of a transmitted one
+  public: uint8_t mPriority = 7 ;
+  public: uint8_t mPacketCount = 0 ;
+  public: uint16_t mNextPacket = 0 ;      // 1 ... mPacketCount + 1 (16 bits: 255 packets do not wrap)
+  public: uint16_t mWindowEnd = 0 ;       // Last packet of the current CTS window
+  public: uint8_t mMaxPacketsPerCTS = 0 ;
+  public: bool mControlPending = false ;  // A TP.CM frame could not be sent yet
+  public: uint8_t mControlByte = 0 ;      // ... and its control byte
+  public: uint32_t mPGN = 0 ;
+  public: uint16_t mSize = 0 ;
+  public: uint32_t mDeadline = 0 ;        // ms
+  public: const uint8_t * mTransmitData = nullptr ;
+  public: uint8_t mBuffer [kMaxMessageSize] ;
+} ;
+
+//----------------------------------------------------------------------------------------------------------------------
+//   J1939 engine
+//----------------------------------------------------------------------------------------------------------------------
+// PGN lookup is O(1): open addressing hash table of routes. Transport sessions are found through two 256-entry tables
+// indexed by source address (one BAM and one RTS/CTS session per source, SAE J1939-21). No dynamic allocation: the
+// route table and the session pool are arrays provided to begin, they can be static.
+// Driving the engine (dates in ms):
+//   while (can.receive (frame)) {
+//     j1939.handleReceivedFrame (frame, millis ()) ;
+//   }
+//   j1939.poll (millis ()) ;
+
+class ACANJ1939 {
+
+//······················································································································
+//   CONSTRUCTORS
+//······················································································································
+
+  public: ACANJ1939 (ACANJ1939SendRoutine inSendRoutine, void * inDriver) ;
+
+  public: template <typename DRIVER> ACANJ1939 (DRIVER & inDriver) :
+  ACANJ1939 (sendThroughDriver <DRIVER>, &inDriver) {
+  }
+
+//······················································································································
+//   Initialisation: inRouteCapacity should be a power of 2, at least twice the number of routes
+//······················································································································
+
+  public: bool begin (ACANJ1939Route * inRoutes,
+                      const uint16_t inRouteCapacity,
+                      ACANJ1939Session * inSessions,
+                      const uint8_t inSessionCount) ;
+
+//······················································································································
+//   PGN routing
+//······················································································································
+
+  public: bool addRoute (const uint32_t inPGN, ACANJ1939Handler inHandler, void * inContext) ;
+  public: void setDefaultHandler (ACANJ1939Handler inHandler, void * inContext) ;
+
+  //--- false: destination specific messages for other nodes are not routed
+  public: bool mPromiscuous = false ;
+
+//······················································································································
+//   Address claim
+//······················································································································
+
+  public: typedef enum : uint8_t {
+    kNoAddress,
+    kClaiming,         // Address claimed sent, waiting 250 ms for contention
+    kAddressClaimed,
+    kCannotClaim
+  } AddressState ;
+
+  public: void claimAddress (const uint64_t inName, const uint8_t inPreferredAddress, const uint32_t inNowMillis) ;
+
+  public: inline AddressState addressState (void) const { return mAddressState ; }
+  public: inline uint8_t address (void) const { return mAddress ; }
+  public: inline uint64_t name (void) const { return mName ; }
+
+//······················································································································
+//   Transmission: up to 8 bytes in a single frame, up to 1785 with BAM (inDestination = 0xFF) or RTS/CTS.
+//   Transport messages are sent from the caller buffer (zero-copy): keep it until transmitSessionCount () drops.
+//   Returns false if no address is claimed, the driver is full, or no session is free.
+//······················································································································
+
+  public: bool send (const uint32_t inPGN,
+                     const uint8_t inPriority,
+                     const uint8_t inDestination,
+                     const uint8_t * inData,
+                     const uint16_t inLength,
+                     const uint32_t inNowMillis) ;
+
+  public: uint32_t mBAMPacketInterval = 50 ;   // ms, SAE J1939-21: 50 ... 200 ms
+  public: uint8_t mPacketsPerCTS = 16 ;        // Window granted to RTS/CTS senders
+
+//······················································································································
+//   Reception and timing
+//······················································································································
+
+  public: bool handleReceivedFrame (const CANMessage & inFrame, const uint32_t inNowMillis) ;
+
+  public: void poll (const uint32_t inNowMillis) ;
+
+//······················································································································
+//   Identifier helpers
+//······················································································································
+
+  public: static uint32_t pgnOfIdentifier (const uint32_t inIdentifier) ;
+  public: static uint32_t identifier (const uint32_t inPGN,
+                                      const uint8_t inPriority,
+                                      const uint8_t inDestination,
+                                      const uint8_t inSource) ;
+
+//······················································································································
+//   Statistics
+//······················································································································
+
+  public: inline uint32_t routedMessageCount (void) const { return mRoutedMessageCount ; }
+  public: inline uint32_t unroutedMessageCount (void) const { return mUnroutedMessageCount ; }
+  public: inline uint32_t sessionOverflowCount (void) const { return mSessionOverflowCount ; }
+  public: inline uint32_t abortedSessionCount (void) const { return mAbortedSessionCount ; }
+  public: inline uint32_t completedTransmitCount (void) const { return mCompletedTransmitCount ; }
+  public: uint8_t transmitSessionCount (void) const ;
+
+//······················································································································
+//   Private
+//······················································································································
+
+  private: template <typename DRIVER> static bool sendThroughDriver (void * inDriver, const CANMessage & inMessage) {
+    return ((DRIVER *) inDriver)->tryToSend (inMessage) ;
+  }
+
+  private: ACANJ1939Route * findRoute (const uint32_t inPGN) const ;
+  private: void route (const ACANJ1939Message & inMessage) ;
+  private: bool sendFrame (const uint32_t inPGN, const uint8_t inPriority, const uint8_t inDestination,
+                           const uint8_t inSource, const uint8_t * inData, const uint8_t inLength) ;
+  private: bool sendConnectionManagement (ACANJ1939Session & ioSession, const uint8_t inControlByte) ;
+  private: void sendAbort (const uint8_t inDestination, const uint32_t inPGN, const uint8_t inReason) ;
+  private: bool sendAddressClaimed (void) ;
+  private: ACANJ1939Session * allocateSession (void) ;
+  private: void freeSession (ACANJ1939Session & ioSession) ;
+  private: void handleConnectionManagement (const CANMessage & inFrame, const uint8_t inSource,
+                                            const uint8_t inDestination, const uint32_t inNowMillis) ;
+  private: void handleDataTransfer (const CANMessage & inFrame, const uint8_t inSource,
+                                    const uint8_t inDestination, const uint32_t inNowMillis) ;
+  private: void handleAddressClaimed (const CANMessage & inFrame, const uint8_t inSource, const uint32_t inNowMillis) ;
+  private: void transmit (ACANJ1939Session & ioSession, const uint32_t inNowMillis) ;
+  private: void selectNewAddress (const uint32_t inNowMillis) ;
+
+  private: ACANJ1939SendRoutine mSendRoutine ;
+  private: void * mDriver ;
+  private: ACANJ1939Route * mRoutes ;
+  private: uint16_t mRouteMask ;
+  private: ACANJ1939Handler mDefaultHandler ;
+  private: void * mDefaultContext ;
+  private: ACANJ1939Session * mSessions ;
+  private: uint8_t mSessionCount ;
+  private: uint8_t mBAMSessionOfSource [256] ;   // Session index, 0xFF: none
+  private: uint8_t mRTSSessionOfSource [256] ;
+  private: uint32_t mAddressInUse [8] ;          // Bit map of source addresses seen in address claims
+  private: uint64_t mName ;
+  private: uint8_t mAddress ;
+  private: AddressState mAddressState ;
+  private: bool mClaimPending ;
+  private: uint32_t mClaimDeadline ;
+  private: uint32_t mRoutedMessageCount ;
+  private: uint32_t mUnroutedMessageCount ;
+  private: uint32_t mSessionOverflowCount ;
+  private: uint32_t mAbortedSessionCount ;
+  private: uint32_t mCompletedTransmitCount ;
+
+//······················································································································
+//   No copy
+//······················································································································
+
+  private: ACANJ1939 (const ACANJ1939 &) = delete ;
+  private: ACANJ1939 & operator = (const ACANJ1939 &) = delete ;
+} ;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#endif
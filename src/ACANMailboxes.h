@@ -0,0 +1,219 @@
+/******************************************************************************/
+/* File name        : ACANMailboxes.h                                         */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Description      : Latest value receive mailboxes, one per identifier      */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation                                                        */
+/* ---------------------------------------------------------------------------*/
+
+#ifndef ACAN_MAILBOXES_CLASS_DEFINED
+#define ACAN_MAILBOXES_CLASS_DEFINED
+
+/*------------------------------- Include files ------------------------------*/
+#include "CANMessage.h"
+#include "ACANInternalRAM.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+// Each registered identifier owns one slot, overwritten by every received frame with this identifier: memory is
+// bounded by the number of identifiers, not by the burst length. A slot has a sequence number (incremented on every
+// write, a gap tells how many values the consumer missed) and a dirty bit, set on write and cleared on read, so the
+// consumer only visits updated slots. As ACANBuffer16, no locking here: the driver calls it in critical sections.
+//----------------------------------------------------------------------------------------------------------------------
+
+class ACANMailboxes {
+
+//······················································································································
+// Identifier key: identifier, bit 31 set for an extended frame
+//······················································································································
+
+  public: static constexpr uint32_t key (const uint32_t inIdentifier, const bool inExtended) {
+    return inIdentifier | (inExtended ? 0x80000000UL : 0) ;
+  }
+
+  public: static const uint16_t kNoMailbox = 0xFFFF ;
+
+//······················································································································
+// Default constructor
+//······················································································································
+
+  public: ACANMailboxes (void) :
+  mKeys (nullptr),
+  mMessages (nullptr),
+  mSequences (nullptr),
+  mDirty (nullptr),
+  mCount (0),
+  mScanWord (0),
+  mOverwriteCount (0) {
+  }
+
+//······················································································································
+// Destructor
+//······················································································································
+
+  public: ~ ACANMailboxes (void) {
+    free () ;
+  }
+
+//······················································································································
+// Private properties
+//······················································································································
+
+  private: uint32_t * mKeys ;          // Sorted, for binary search in the receive interrupt
+  private: CANMessage * mMessages ;
+  private: uint32_t * mSequences ;
+  private: uint32_t * mDirty ;         // Bit i set: mailbox i updated since last read
+  private: uint16_t mCount ;
+  private: uint16_t mScanWord ;        // Dirty word where the next scan starts (round robin)
+  private: uint32_t mOverwriteCount ;  // Writes to a mailbox not read yet
+
+//······················································································································
+// Accessors
+//······················································································································
+
+  public: inline uint16_t count (void) const { return mCount ; }
+  public: inline uint32_t overwriteCount (void) const { return mOverwriteCount ; }
+  public: inline uint32_t keyAtIndex (const uint16_t inIndex) const { return mKeys [inIndex] ; }
+
+//······················································································································
+// initWithKeys: keys are copied and sorted, duplicates are removed
+//······················································································································
+
+  public: bool initWithKeys (const uint32_t * inKeys, const uint16_t inCount) {
+    free () ;
+    const uint16_t wordCount = (inCount + 31) / 32 ;
+    mKeys = allocateInternalRAMArray <uint32_t> (inCount) ;
+    mMessages = allocateInternalRAMArray <CANMessage> (inCount) ;
+    mSequences = allocateInternalRAMArray <uint32_t> (inCount) ;
+    mDirty = allocateInternalRAMArray <uint32_t> (wordCount) ;
+    const bool ok = (mKeys != nullptr) && (mMessages != nullptr) && (mSequences != nullptr) && (mDirty != nullptr) ;
+    if (!ok) {
+      free () ;
+    }else{
+    //--- Insertion sort, without duplicates
+      for (uint16_t i=0 ; i<inCount ; i++) {
+        const uint32_t k = inKeys [i] ;
+        uint16_t j = mCount ;
+        while ((j > 0) && (mKeys [j-1] > k)) {
+          j -= 1 ;
+        }
+        if ((j == 0) || (mKeys [j-1] != k)) {
+          for (uint16_t m=mCount ; m>j ; m--) {
+            mKeys [m] = mKeys [m-1] ;
+          }
+          mKeys [j] = k ;
+          mCount += 1 ;
+        }
+      }
+      for (uint16_t i=0 ; i<mCount ; i++) {
+        mMessages [i].id = mKeys [i] & 0x1FFFFFFFUL ;
+        mMessages [i].ext = (mKeys [i] & 0x80000000UL) != 0 ;
+        mSequences [i] = 0 ;
+      }
+      for (uint16_t i=0 ; i<wordCount ; i++) {
+        mDirty [i] = 0 ;
+      }
+    }
+    return ok ;
+  }
+
+//······················································································································
+// indexOfKey: binary search, kNoMailbox if the key is not registered
+//······················································································································
+
+  public: IRAM_ATTR uint16_t indexOfKey (const uint32_t inKey) const {
+    uint16_t low = 0 ;
+    uint16_t high = mCount ;
+    while (low < high) {
+      const uint16_t middle = (low + high) / 2 ;
+      if (mKeys [middle] < inKey) {
+        low = middle + 1 ;
+      }else{
+        high = middle ;
+      }
+    }
+    return ((low < mCount) && (mKeys [low] == inKey)) ? low : kNoMailbox ;
+  }
+
+//······················································································································
+// store (receive interrupt): returns false if the identifier has no mailbox
+//······················································································································
+
+  public: IRAM_ATTR bool store (const CANMessage & inMessage) {
+    const uint16_t index = indexOfKey (key (inMessage.id, inMessage.ext)) ;
+    const bool ok = index != kNoMailbox ;
+    if (ok) {
+      const uint32_t bit = 1UL << (index & 31) ;
+      mOverwriteCount += (mDirty [index >> 5] & bit) != 0 ;
+      mDirty [index >> 5] |= bit ;
+      mMessages [index] = inMessage ;
+      mSequences [index] += 1 ;
+    }
+    return ok ;
+  }
+
+//······················································································································
+// read: latest value of a mailbox; returns true if it was updated since the last read
+//······················································································································
+
+  public: bool read (const uint16_t inIndex, CANMessage & outMessage, uint32_t & outSequence) {
+    const uint32_t bit = 1UL << (inIndex & 31) ;
+    const bool updated = (mDirty [inIndex >> 5] & bit) != 0 ;
+    mDirty [inIndex >> 5] &= ~ bit ;
+    outMessage = mMessages [inIndex] ;
+    outSequence = mSequences [inIndex] ;
+    return updated ;
+  }
+
+//······················································································································
+// readNextUpdated: next dirty mailbox, scanning the bitmap a word at a time from where the last scan stopped
+//······················································································································
+
+  public: bool readNextUpdated (uint16_t & outIndex, CANMessage & outMessage, uint32_t & outSequence) {
+    const uint16_t wordCount = (mCount + 31) / 32 ;
+    bool found = false ;
+    for (uint16_t n=0 ; (n<wordCount) && !found ; n++) {
+      const uint16_t w = (mScanWord + n < wordCount) ? (mScanWord + n) : (mScanWord + n - wordCount) ;
+      const uint32_t dirty = mDirty [w] ;
+      if (dirty != 0) {
+        outIndex = (uint16_t) (w * 32 + __builtin_ctz (dirty)) ;
+        read (outIndex, outMessage, outSequence) ;
+        mScanWord = ((w + 1) < wordCount) ? (w + 1) : 0 ;
+        found = true ;
+      }
+    }
+    return found ;
+  }
+
+//······················································································································
+// Free
+//······················································································································
+
+  public: void free (void) {
+    freeInternalRAMArray (mKeys) ; mKeys = nullptr ;
+    freeInternalRAMArray (mMessages) ; mMessages = nullptr ;
+    freeInternalRAMArray (mSequences) ; mSequences = nullptr ;
+    freeInternalRAMArray (mDirty) ; mDirty = nullptr ;
+    mCount = 0 ;
+    mScanWord = 0 ;
+    mOverwriteCount = 0 ;
+  }
+
+//······················································································································
+// No copy
+//······················································································································
+
+  private: ACANMailboxes (const ACANMailboxes &) = delete ;
+  private: ACANMailboxes & operator = (const ACANMailboxes &) = delete ;
+} ;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#endif
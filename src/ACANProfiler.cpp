@@ -0,0 +1,92 @@
+/******************************************************************************/
+/* File name        : ACANProfiler.cpp                                        */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Description      : Cycle count profile of the interrupt handler and of the */
+/*                    critical sections of the driver                         */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation                                                        */
+/* ---------------------------------------------------------------------------*/
+
+/*------------------------------- Include files ------------------------------*/
+#include "ACANProfiler.h"
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   DURATION STATISTICS
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ACANProfileStatistics::reset (void) {
+  for (uint8_t i=0 ; i<kBucketCount ; i++) {
+    mHistogram [i] = 0 ;
+  }
+  mCount = 0 ;
+  mMin = UINT32_MAX ;
+  mMax = 0 ;
+  mTotal = 0 ;
+}
+
+//······················································································································
+
+uint32_t ACANProfileStatistics::bucketLowerBound (const uint8_t inIndex) {
+  return (inIndex == 0) ? 0 : (uint32_t (1) << (inIndex - 1)) ;
+}
+
+//······················································································································
+
+uint32_t ACANProfileStatistics::bucketUpperBound (const uint8_t inIndex) {
+  return uint32_t ((uint64_t (1) << inIndex) - 1) ;
+}
+
+//······················································································································
+
+uint32_t ACANProfileStatistics::percentile (const uint32_t inPerThousand) const {
+  uint32_t result = 0 ;
+  if (mCount > 0) {
+    const uint64_t rank = (uint64_t (mCount) * inPerThousand + 999) / 1000 ; // At least this many samples
+    uint64_t cumulated = 0 ;
+    uint8_t i = 0 ;
+    while ((i < (kBucketCount - 1)) && ((cumulated + mHistogram [i]) < rank)) {
+      cumulated += mHistogram [i] ;
+      i += 1 ;
+    }
+    result = bucketUpperBound (i) ;
+    if (result > mMax) {
+      result = mMax ;
+    }
+  }
+  return result ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   PROFILER
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ACANProfiler::reset (void) {
+  for (uint8_t i=0 ; i<kSectionCount ; i++) {
+    mSections [i].reset () ;
+  }
+}
+
+//······················································································································
+
+const char * ACANProfiler::sectionName (const Section inSection) {
+  const char * result = "?" ;
+  switch (inSection) {
+  case InterruptHandler : result = "interrupt handler" ; break ;
+  case InterruptCriticalSection : result = "interrupt critical section" ; break ;
+  case RXHandler : result = "RX handler" ; break ;
+  case TXHandler : result = "TX handler" ; break ;
+  case ReceiveCriticalSection : result = "receive critical section" ; break ;
+  case SendCriticalSection : result = "tryToSend critical section" ; break ;
+  }
+  return result ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
@@ -0,0 +1,142 @@
+/******************************************************************************/
+/* File name        : ACANProfiler.h                                          */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Description      : Cycle count profile of the interrupt handler and of the */
+/*                    critical sections of the driver                         */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation                                                        */
+/* ---------------------------------------------------------------------------*/
+
+#ifndef ACAN_PROFILER_CLASS_DEFINED
+#define ACAN_PROFILER_CLASS_DEFINED
+
+/*------------------------------- Include files ------------------------------*/
+#include "ACANTrace.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+// Compile time switch of the driver profile points: build with -DACAN_PROFILE=1, as ACAN_TRACE (see ACANTrace.h), or
+// change the default below. With 0, ESP32ACAN reads no cycle counter and ESP32ACAN::setProfiler returns false.
+//----------------------------------------------------------------------------------------------------------------------
+
+#ifndef ACAN_PROFILE
+  #define ACAN_PROFILE 0
+#endif
+
+//----------------------------------------------------------------------------------------------------------------------
+//   Duration statistics, in date unit (ACANTrace::date: CPU cycles on the ESP32, ns on the desktop): count, min, max,
+//   total, and a log2 histogram: bucket 0 counts the null durations, bucket i > 0 the durations in [2^(i-1), 2^i).
+//   Recording is a few loads and increments, no division.
+//----------------------------------------------------------------------------------------------------------------------
+
+class ACANProfileStatistics {
+
+  public: static const uint8_t kBucketCount = 33 ;
+
+  public: ACANProfileStatistics (void) { reset () ; }
+
+  public: void reset (void) ;
+
+  public: static inline IRAM_ATTR uint8_t bucket (const uint32_t inDuration) {
+    return (inDuration == 0) ? 0 : uint8_t (32 - __builtin_clz (inDuration)) ;
+  }
+
+  public: inline IRAM_ATTR void add (const uint32_t inDuration) {
+    mHistogram [bucket (inDuration)] += 1 ;
+    mCount += 1 ;
+    mTotal += inDuration ;
+    if (mMin > inDuration) {
+      mMin = inDuration ;
+    }
+    if (mMax < inDuration) {
+      mMax = inDuration ;
+    }
+  }
+
+  public: inline uint32_t count (void) const { return mCount ; }
+  public: inline uint32_t minimum (void) const { return (mCount > 0) ? mMin : 0 ; }
+  public: inline uint32_t maximum (void) const { return mMax ; }
+  public: inline uint64_t total (void) const { return mTotal ; }
+  public: inline uint32_t mean (void) const { return (mCount > 0) ? uint32_t (mTotal / mCount) : 0 ; }
+
+  public: inline uint32_t bucketCount (const uint8_t inIndex) const { return mHistogram [inIndex] ; }
+  public: static uint32_t bucketLowerBound (const uint8_t inIndex) ;
+  public: static uint32_t bucketUpperBound (const uint8_t inIndex) ; // Included
+
+  //--- Upper bound of the bucket of the duration such that inPerThousand / 1000 of the samples are lower or equal,
+  //    at most maximum (): within a factor 2 of the exact value
+  public: uint32_t percentile (const uint32_t inPerThousand) const ;
+
+  private: uint32_t mHistogram [kBucketCount] ;
+  private: uint32_t mCount ;
+  private: uint32_t mMin ;
+  private: uint32_t mMax ;
+  private: uint64_t mTotal ;
+} ;
+
+//----------------------------------------------------------------------------------------------------------------------
+//   Profile of the driver, recorded by ESP32ACAN once attached (ESP32ACAN::setProfiler), in critical section:
+//   - InterruptHandler: interrupt handler, from entry to exit, semaphore gives included.
+//     Recorded by the next interrupt (the handler exit is outside the critical section);
+//   - InterruptCriticalSection: spinlock hold time of the interrupt handler, the other core waiting for it meanwhile;
+//   - RXHandler, TXHandler: handleRXInterrupt, handleTXInterrupt, within InterruptCriticalSection;
+//   - ReceiveCriticalSection: spinlock hold time of receive (controller FIFO drain in PollingControlled mode);
+//   - SendCriticalSection: spinlock hold time of tryToSend and tryToSendFixed.
+//   Read it through ESP32ACAN::profileStatistics (copied in critical section).
+//----------------------------------------------------------------------------------------------------------------------
+
+class ACANProfiler {
+
+  public: typedef enum : uint8_t {
+    InterruptHandler,
+    InterruptCriticalSection,
+    RXHandler,
+    TXHandler,
+    ReceiveCriticalSection,
+    SendCriticalSection
+  } Section ;
+
+  public: static const uint8_t kSectionCount = 6 ;
+
+  public: ACANProfiler (void) : mSections () {}
+
+  public: static inline IRAM_ATTR uint32_t date (void) { return ACANTrace::date () ; }
+
+  public: static inline uint32_t ticksPerMicrosecond (void) { return ACANTrace::ticksPerMicrosecond () ; }
+
+  public: inline IRAM_ATTR void record (const Section inSection, const uint32_t inStartDate) {
+    mSections [inSection].add (date () - inStartDate) ;
+  }
+
+  public: inline IRAM_ATTR void recordDuration (const Section inSection, const uint32_t inDuration) {
+    mSections [inSection].add (inDuration) ;
+  }
+
+  public: inline const ACANProfileStatistics & statistics (const Section inSection) const {
+    return mSections [inSection] ;
+  }
+
+  public: void reset (void) ;
+
+  public: static const char * sectionName (const Section inSection) ;
+
+  private: ACANProfileStatistics mSections [kSectionCount] ;
+
+//······················································································································
+//    No copy
+//······················································································································
+
+  private: ACANProfiler (const ACANProfiler &) = delete ;
+  private: ACANProfiler & operator = (const ACANProfiler &) = delete ;
+} ;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#endif
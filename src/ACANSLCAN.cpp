@@ -0,0 +1,333 @@
+/******************************************************************************/
+/* File name        : ACANSLCAN.cpp                                           */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Description      : SLCAN (Lawicel) serial bridge                           */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation                                                        */
+/* ---------------------------------------------------------------------------*/
+
+/*------------------------------- Include files ------------------------------*/
+#include "ACANSLCAN.h"
+#include <string.h>
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   HEX TABLES: two digits per byte for encoding, nibble value per character for decoding (0xFF: not a hex digit)
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static const char kHexPairs [513] =
+  "000102030405060708090A0B0C0D0E0F101112131415161718191A1B1C1D1E1F"
+  "202122232425262728292A2B2C2D2E2F303132333435363738393A3B3C3D3E3F"
+  "404142434445464748494A4B4C4D4E4F505152535455565758595A5B5C5D5E5F"
+  "606162636465666768696A6B6C6D6E6F707172737475767778797A7B7C7D7E7F"
+  "808182838485868788898A8B8C8D8E8F909192939495969798999A9B9C9D9E9F"
+  "A0A1A2A3A4A5A6A7A8A9AAABACADAEAFB0B1B2B3B4B5B6B7B8B9BABBBCBDBEBF"
+  "C0C1C2C3C4C5C6C7C8C9CACBCCCDCECFD0D1D2D3D4D5D6D7D8D9DADBDCDDDEDF"
+  "E0E1E2E3E4E5E6E7E8E9EAEBECEDEEEFF0F1F2F3F4F5F6F7F8F9FAFBFCFDFEFF" ;
+
+static const uint8_t kHexValues [256] = {
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF
+} ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static const uint32_t kBitRates [9] = {
+  10 * 1000, 20 * 1000, 50 * 1000, 100 * 1000, 125 * 1000, 250 * 1000, 500 * 1000, 800 * 1000, 1000 * 1000
+} ;
+
+static const uint16_t kTimestampModulo = 60000 ; // ms
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static inline uint8_t * appendByte (uint8_t * ioText, const uint8_t inByte) {
+  memcpy (ioText, &kHexPairs [2 * inByte], 2) ;
+  return ioText + 2 ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   Hex value of inDigitCount digits, false if a character is not a hex digit
+
+static bool hexValue (const uint8_t inText [], const uint8_t inDigitCount, uint32_t & outValue) {
+  uint32_t value = 0 ;
+  uint8_t invalid = 0 ;
+  for (uint8_t i=0 ; i<inDigitCount ; i++) {
+    const uint8_t nibble = kHexValues [inText [i]] ;
+    invalid |= nibble ;
+    value = (value << 4) | (nibble & 0x0F) ;
+  }
+  outValue = value ;
+  return (invalid & 0xF0) == 0 ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   ENCODE
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+uint8_t ACANSLCAN::encodeFrame (const CANMessage & inFrame,
+                                const uint16_t inTimestamp,
+                                uint8_t outText [kMaxEncodedFrameLength]) {
+  const uint8_t length = (inFrame.len < 8) ? inFrame.len : 8 ;
+  uint8_t * p = outText ;
+  if (inFrame.ext) {
+    *p = inFrame.rtr ? 'R' : 'T' ;
+    p = appendByte (p + 1, uint8_t ((inFrame.id >> 24) & 0x1F)) ;
+    p = appendByte (p, uint8_t (inFrame.id >> 16)) ;
+    p = appendByte (p, uint8_t (inFrame.id >> 8)) ;
+  }else{
+    *p = inFrame.rtr ? 'r' : 't' ;
+    p [1] = uint8_t (kHexPairs [2 * ((inFrame.id >> 8) & 0x7) + 1]) ;
+    p += 2 ;
+  }
+  p = appendByte (p, uint8_t (inFrame.id)) ;
+  *p = uint8_t ('0' + length) ;
+  p += 1 ;
+  if (!inFrame.rtr) {
+    for (uint8_t i=0 ; i<length ; i++) {
+      p = appendByte (p, inFrame.data [i]) ;
+    }
+  }
+  if (inTimestamp < kTimestampModulo) {
+    p = appendByte (p, uint8_t (inTimestamp >> 8)) ;
+    p = appendByte (p, uint8_t (inTimestamp)) ;
+  }
+  *p = '\r' ;
+  return uint8_t (p + 1 - outText) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   DECODE
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+bool ACANSLCAN::decodeFrame (const uint8_t inText [], const uint8_t inLength, CANMessage & outFrame) {
+  bool ok = inLength > 0 ;
+  if (ok) {
+    const uint8_t command = inText [0] ;
+    const bool extended = (command == 'T') || (command == 'R') ;
+    const bool remote = (command == 'r') || (command == 'R') ;
+    const uint8_t idDigits = extended ? 8 : 3 ;
+    ok = ((command == 't') || (command == 'r') || extended) && (inLength >= (idDigits + 2)) ;
+    uint32_t identifier = 0 ;
+    if (ok) {
+      ok = hexValue (&inText [1], idDigits, identifier) && (identifier <= (extended ? 0x1FFFFFFFUL : 0x7FFUL)) ;
+    }
+    const uint8_t length = ok ? uint8_t (inText [idDigits + 1] - '0') : 0xFF ;
+    ok = ok && (length <= 8) && (inLength == (idDigits + 2 + (remote ? 0 : 2 * length))) ;
+    if (ok) {
+      outFrame.id = identifier ;
+      outFrame.ext = extended ;
+      outFrame.rtr = remote ;
+      outFrame.len = length ;
+      outFrame.data64 = 0 ;
+      const uint8_t * data = &inText [idDigits + 2] ;
+      for (uint8_t i=0 ; (i<length) && ok && !remote ; i++) {
+        uint32_t value ;
+        ok = hexValue (&data [2 * i], 2, value) ;
+        outFrame.data [i] = uint8_t (value) ;
+      }
+    }
+  }
+  return ok ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   STATE
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ACANSLCAN::resetState (void) {
+  mOutputLength = 0 ;
+  mCommandLength = 0 ;
+  mCommandOverflow = false ;
+  mOpened = false ;
+  mListenOnly = false ;
+  mTimestamps = false ;
+  mStatusFlags = 0 ;
+  mReportedDropCount = 0 ;
+  mBitRate = 500 * 1000 ;
+  mEncodedFrameCount = 0 ;
+  mSentFrameCount = 0 ;
+  mRefusedFrameCount = 0 ;
+  mCommandErrorCount = 0 ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   HOST -> CAN: commands end with CR (LF ignored)
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ACANSLCAN::receiveFromHost (const uint8_t inBytes [], const size_t inCount) {
+  for (size_t i=0 ; i<inCount ; i++) {
+    const uint8_t c = inBytes [i] ;
+    if (c == '\r') {
+      if (mCommandOverflow) {
+        mCommandOverflow = false ;
+        mStatusFlags |= kCommandOverflowFlag ;
+        replyError () ;
+      }else{
+        handleCommand () ;
+      }
+      mCommandLength = 0 ;
+    }else if (c == '\n') {
+    }else if (mCommandLength < kMaxCommandLength) {
+      mCommand [mCommandLength] = c ;
+      mCommandLength += 1 ;
+    }else{
+      mCommandOverflow = true ;
+    }
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ACANSLCAN::handleCommand (void) {
+  const uint8_t command = (mCommandLength > 0) ? mCommand [0] : '\r' ;
+  uint32_t value = 0 ;
+  switch (command) {
+  case '\r' : // Empty command
+    replyOk () ;
+    break ;
+  case 't' : case 'T' : case 'r' : case 'R' :
+    { CANMessage frame ;
+      if (!mOpened || mListenOnly || !decodeFrame (mCommand, mCommandLength, frame)) {
+        replyError () ;
+      }else if (!mSend (mDriver, frame)) {
+        mRefusedFrameCount += 1 ;
+        mStatusFlags |= kTransmitFullFlag ;
+        replyError () ;
+      }else{
+        mSentFrameCount += 1 ;
+        reply ((const uint8_t *) (frame.ext ? "Z\r" : "z\r"), 2) ;
+      }
+    }
+    break ;
+  case 'S' :
+    value = uint32_t (mCommand [1] - '0') ;
+    if (mOpened || (mCommandLength != 2) || (value > 8)) {
+      replyError () ;
+    }else{
+      mBitRate = kBitRates [value] ;
+      replyOk () ;
+    }
+    break ;
+  case 's' : //--- SJA1000 BTR0 / BTR1, 16 MHz clock: tq = 2 (BRP + 1) / 16 MHz, TSEG1 + TSEG2 + 3 tq per bit
+    if (mOpened || (mCommandLength != 5) || !hexValue (&mCommand [1], 4, value)) {
+      replyError () ;
+    }else{
+      const uint32_t brp = ((value >> 8) & 0x3F) + 1 ;
+      const uint32_t tq = (value & 0x0F) + ((value >> 4) & 0x07) + 3 ;
+      mBitRate = (8UL * 1000 * 1000) / (brp * tq) ;
+      replyOk () ;
+    }
+    break ;
+  case 'O' : case 'L' :
+    if (mOpened || (mCommandLength != 1) || !mOpen (mDriver, mBitRate, command == 'L')) {
+      replyError () ;
+    }else{
+      mOpened = true ;
+      mListenOnly = command == 'L' ;
+      mReportedDropCount = mReceiveDropCount (mDriver) ;
+      replyOk () ;
+    }
+    break ;
+  case 'C' :
+    if (!mOpened || (mCommandLength != 1)) {
+      replyError () ;
+    }else{
+      mClose (mDriver) ;
+      mOpened = false ;
+      replyOk () ;
+    }
+    break ;
+  case 'F' : //--- Receive drops are read from the driver: no count in its receive path
+    { const uint32_t dropCount = mReceiveDropCount (mDriver) ;
+      if (dropCount != mReportedDropCount) {
+        mReportedDropCount = dropCount ;
+        mStatusFlags |= kReceiveFullFlag ;
+      }
+      uint8_t text [4] = {'F', 0, 0, '\r'} ;
+      appendByte (&text [1], mStatusFlags) ;
+      mStatusFlags = 0 ;
+      reply (text, 4) ;
+    }
+    break ;
+  case 'V' :
+    reply ((const uint8_t *) "V1013\r", 6) ;
+    break ;
+  case 'N' :
+    reply ((const uint8_t *) "NE32A\r", 6) ;
+    break ;
+  case 'Z' :
+    if ((mCommandLength != 2) || ((mCommand [1] != '0') && (mCommand [1] != '1'))) {
+      replyError () ;
+    }else{
+      mTimestamps = mCommand [1] == '1' ;
+      replyOk () ;
+    }
+    break ;
+  case 'M' : case 'm' : //--- Acceptance code and mask: the ESP32ACAN filter is set by the application
+    if ((mCommandLength != 9) || !hexValue (&mCommand [1], 8, value)) {
+      replyError () ;
+    }else{
+      replyOk () ;
+    }
+    break ;
+  default :
+    replyError () ;
+    break ;
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   Replies go to the output buffer with the frames; a reply that does not fit is lost (the host times out)
+
+void ACANSLCAN::reply (const uint8_t inText [], const uint8_t inLength) {
+  if ((mOutputLength + inLength) <= kOutputBufferSize) {
+    memcpy (&mOutput [mOutputLength], inText, inLength) ;
+    mOutputLength += inLength ;
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   CAN -> HOST: frames are taken from the driver only while the output buffer has room for the longest frame
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ACANSLCAN::fillOutput (const uint32_t inNowMillis) {
+  if (mOpened) {
+    const uint16_t timestamp = mTimestamps ? uint16_t (inNowMillis % kTimestampModulo) : kNoTimestamp ;
+    CANMessage frame ;
+    while (((mOutputLength + kMaxEncodedFrameLength) <= kOutputBufferSize) && mReceive (mDriver, frame)) {
+      mOutputLength += encodeFrame (frame, timestamp, &mOutput [mOutputLength]) ;
+      mEncodedFrameCount += 1 ;
+    }
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ACANSLCAN::consumeOutput (const uint16_t inCount) {
+  const uint16_t count = (inCount < mOutputLength) ? inCount : mOutputLength ;
+  mOutputLength -= count ;
+  memmove (mOutput, &mOutput [count], mOutputLength) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
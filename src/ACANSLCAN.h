@@ -0,0 +1,207 @@
+/******************************************************************************/
+/* File name        : ACANSLCAN.h                                             */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Description      : SLCAN (Lawicel) serial bridge                           */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation                                                        */
+/* ---------------------------------------------------------------------------*/
+
+#ifndef ACAN_SLCAN_CLASS_DEFINED
+#define ACAN_SLCAN_CLASS_DEFINED
+
+/*------------------------------- Include files ------------------------------*/
+#include "CANMessage.h"
+#include <stddef.h>
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   SLCAN (Lawicel) bridge between a CAN driver and a serial link.
+//   CAN -> host: received frames are encoded (table driven hex, no printf) into an output buffer, as many as it holds,
+//   and written to the link in one write per poll; a frame waits in the driver receive buffer while the output buffer
+//   is full. Host -> CAN: commands are decoded from the bytes read, frames are sent with tryToSend.
+//   Commands: Sn (bit rate 0 ... 8: 10k, 20k, 50k, 100k, 125k, 250k, 500k, 800k, 1M), sxxyy (SJA1000 BTR0 BTR1 at
+//   16 MHz, converted to a bit rate), O (open), L (open listen only), C (close), tiiildd..., Tiiiiiiiildd..., riiil,
+//   Riiiiiiiil (send, reply z / Z), F (status flags, cleared on read), V (version), N (serial number), Zn (timestamps
+//   off / on: 4 hex digits, ms modulo 60000, taken when the frame is encoded), Mxxxxxxxx and mxxxxxxxx (acceptance
+//   code and mask: accepted, ignored). Reply CR on success, BEL on error.
+//   The driver is reached through an adaptor; the DRIVER class provides:
+//     bool tryToSend (const CANMessage & inFrame) ;
+//     bool receive (CANMessage & outFrame) ;
+//     bool slcanOpen (const uint32_t inBitRate, const bool inListenOnly) ; // Starts the controller
+//     void slcanClose (void) ;                                             // Stops it
+//     uint32_t slcanReceiveDropCount (void) ;     // Received frames lost, driver receive buffer full (F bit 0)
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+class ACANSLCAN {
+
+//······················································································································
+//   Encoding and decoding of a frame. Encoded: t / T / r / R, identifier (3 or 8 hex digits), length, data (2 hex
+//   digits per byte, data frames), timestamp (4 hex digits, if inTimestamp < 60000), CR.
+//······················································································································
+
+  public: static const uint8_t kMaxEncodedFrameLength = 31 ; // T + 8 + 1 + 16 + 4 + CR
+  public: static const uint16_t kNoTimestamp = 0xFFFF ;
+
+  public: static uint8_t encodeFrame (const CANMessage & inFrame,
+                                      const uint16_t inTimestamp,
+                                      uint8_t outText [kMaxEncodedFrameLength]) ;
+
+  //--- A transmit command (without CR): false if malformed
+  public: static bool decodeFrame (const uint8_t inText [], const uint8_t inLength, CANMessage & outFrame) ;
+
+//······················································································································
+//   Constructor
+//······················································································································
+
+  public: template <typename DRIVER> ACANSLCAN (DRIVER & inDriver) :
+  mDriver (&inDriver),
+  mSend (sendThroughDriver <DRIVER>),
+  mReceive (receiveThroughDriver <DRIVER>),
+  mOpen (openThroughDriver <DRIVER>),
+  mClose (closeThroughDriver <DRIVER>),
+  mReceiveDropCount (receiveDropCountThroughDriver <DRIVER>) {
+    resetState () ;
+  }
+
+//······················································································································
+//   Bridge, byte level: bytes read from the host, then output filled with the received frames
+//······················································································································
+
+  public: static const uint16_t kOutputBufferSize = 1024 ;
+  public: static const uint8_t kMaxCommandLength = 32 ;
+
+  public: void receiveFromHost (const uint8_t inBytes [], const size_t inCount) ;
+
+  public: void fillOutput (const uint32_t inNowMillis) ;
+
+  public: inline const uint8_t * output (void) const { return mOutput ; }
+  public: inline uint16_t outputLength (void) const { return mOutputLength ; }
+  public: void consumeOutput (const uint16_t inCount) ; // Bytes written to the host
+
+//······················································································································
+//   Bridge, stream level (Arduino Stream: Serial, USB CDC; see the desktop test for a pseudo terminal): the available
+//   bytes read, the received frames encoded, one write of what the link accepts. Call it from loop () or a task.
+//······················································································································
+
+  public: template <typename STREAM> void poll (STREAM & ioStream, const uint32_t inNowMillis) {
+    uint8_t input [128] ;
+    int available = ioStream.available () ;
+    while (available > 0) {
+      const size_t count = ioStream.readBytes ((char *) input, (available < 128) ? size_t (available) : 128) ;
+      receiveFromHost (input, count) ;
+      available = (count > 0) ? (available - int (count)) : 0 ; // readBytes timed out: read again at next poll
+    }
+    fillOutput (inNowMillis) ;
+    const int room = ioStream.availableForWrite () ;
+    const uint16_t count = (room < int (mOutputLength)) ? uint16_t (room) : mOutputLength ;
+    if (count > 0) {
+      consumeOutput (uint16_t (ioStream.write (mOutput, count))) ;
+    }
+  }
+
+//······················································································································
+//   State and counters
+//······················································································································
+
+  public: inline bool isOpen (void) const { return mOpened ; }
+  public: inline bool timestamps (void) const { return mTimestamps ; }
+  public: inline uint32_t bitRate (void) const { return mBitRate ; }
+
+  public: inline uint32_t encodedFrameCount (void) const { return mEncodedFrameCount ; } // CAN -> host
+  public: inline uint32_t sentFrameCount (void) const { return mSentFrameCount ; }       // Host -> CAN
+  public: inline uint32_t refusedFrameCount (void) const { return mRefusedFrameCount ; } // Driver transmit buffer full
+  public: inline uint32_t commandErrorCount (void) const { return mCommandErrorCount ; } // BEL replies
+
+  //--- Status flags (F command), Lawicel bits; bit 4 is not used by Lawicel
+  public: static const uint8_t kReceiveFullFlag     = 1 << 0 ; // Received frames lost, driver receive buffer full
+  public: static const uint8_t kTransmitFullFlag    = 1 << 1 ; // A frame refused by the driver
+  public: static const uint8_t kCommandOverflowFlag = 1 << 4 ; // A command longer than kMaxCommandLength
+
+//······················································································································
+//   Private methods
+//······················································································································
+
+  private: void resetState (void) ;
+  private: void handleCommand (void) ;
+  private: void reply (const uint8_t inText [], const uint8_t inLength) ;
+  private: inline void replyOk (void) { reply ((const uint8_t *) "\r", 1) ; }
+  private: inline void replyError (void) { mCommandErrorCount += 1 ; reply ((const uint8_t *) "\a", 1) ; }
+
+//······················································································································
+//   Adaptor
+//······················································································································
+
+  private: typedef bool (*SendRoutine) (void * inDriver, const CANMessage & inFrame) ;
+  private: typedef bool (*ReceiveRoutine) (void * inDriver, CANMessage & outFrame) ;
+  private: typedef bool (*OpenRoutine) (void * inDriver, const uint32_t inBitRate, const bool inListenOnly) ;
+  private: typedef void (*CloseRoutine) (void * inDriver) ;
+  private: typedef uint32_t (*ReceiveDropCountRoutine) (void * inDriver) ;
+
+  private: template <typename DRIVER> static bool sendThroughDriver (void * inDriver, const CANMessage & inFrame) {
+    return ((DRIVER *) inDriver)->tryToSend (inFrame) ;
+  }
+
+  private: template <typename DRIVER> static bool receiveThroughDriver (void * inDriver, CANMessage & outFrame) {
+    return ((DRIVER *) inDriver)->receive (outFrame) ;
+  }
+
+  private: template <typename DRIVER> static bool openThroughDriver (void * inDriver,
+                                                                      const uint32_t inBitRate,
+                                                                      const bool inListenOnly) {
+    return ((DRIVER *) inDriver)->slcanOpen (inBitRate, inListenOnly) ;
+  }
+
+  private: template <typename DRIVER> static void closeThroughDriver (void * inDriver) {
+    ((DRIVER *) inDriver)->slcanClose () ;
+  }
+
+  private: template <typename DRIVER> static uint32_t receiveDropCountThroughDriver (void * inDriver) {
+    return ((DRIVER *) inDriver)->slcanReceiveDropCount () ;
+  }
+
+//······················································································································
+//   Private properties
+//······················································································································
+
+  private: void * mDriver ;
+  private: const SendRoutine mSend ;
+  private: const ReceiveRoutine mReceive ;
+  private: const OpenRoutine mOpen ;
+  private: const CloseRoutine mClose ;
+  private: const ReceiveDropCountRoutine mReceiveDropCount ;
+
+  private: uint8_t mOutput [kOutputBufferSize] ;
+  private: uint16_t mOutputLength ;
+  private: uint8_t mCommand [kMaxCommandLength] ;
+  private: uint8_t mCommandLength ;
+  private: bool mCommandOverflow ;  // Bytes discarded until the next CR
+  private: bool mOpened ;
+  private: bool mListenOnly ;
+  private: bool mTimestamps ;
+  private: uint8_t mStatusFlags ;
+  private: uint32_t mReportedDropCount ; // Driver receive drop count at open or at the last F
+  private: uint32_t mBitRate ;
+
+  private: uint32_t mEncodedFrameCount ;
+  private: uint32_t mSentFrameCount ;
+  private: uint32_t mRefusedFrameCount ;
+  private: uint32_t mCommandErrorCount ;
+
+//······················································································································
+//    No copy
+//······················································································································
+
+  private: ACANSLCAN (const ACANSLCAN &) = delete ;
+  private: ACANSLCAN & operator = (const ACANSLCAN &) = delete ;
+} ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+#endif
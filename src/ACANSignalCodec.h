@@ -0,0 +1,101 @@
+/******************************************************************************/
+/* File name        : ACANSignalCodec.h                                       */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Description      : Bit field primitives used by the signal codecs          */
+/*                    generated from .dbc files                               */
+/*                    (see dbc-codec-generator-on-desktop)                    */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation                                                        */
+/* ---------------------------------------------------------------------------*/
+
+#ifndef ACAN_SIGNAL_CODEC_DEFINED
+#define ACAN_SIGNAL_CODEC_DEFINED
+
+/*------------------------------- Include files ------------------------------*/
+#include "CANMessage.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+// The 8 data bytes are handled as one 64-bit word: CANMessage::data64 for Intel (little endian) signals, its byte
+// swapped value for Motorola (big endian) signals. A signal is then a shift and a mask of this word. Every length and
+// shift is a constant of the generated code, so the conditional expressions below are resolved at compile time.
+//----------------------------------------------------------------------------------------------------------------------
+
+#if defined (__BYTE_ORDER__) && (__BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__)
+  #error "ACANSignalCodec requires a little endian target (data64 is the Intel word)"
+#endif
+
+//----------------------------------------------------------------------------------------------------------------------
+
+class ACANSignalCodec {
+
+  public: static constexpr uint64_t mask (const uint32_t inLength) {
+    return (inLength >= 64) ? ~ 0ULL : ((1ULL << inLength) - 1) ;
+  }
+
+  public: static constexpr uint64_t extract (const uint64_t inWord, const uint32_t inShift, const uint32_t inLength) {
+    return (inWord >> inShift) & mask (inLength) ;
+  }
+
+  public: static constexpr int64_t signExtend (const uint64_t inRaw, const uint32_t inLength) {
+    return (int64_t) (inRaw << (64 - inLength)) >> (64 - inLength) ;
+  }
+
+  public: static constexpr uint64_t insert (const uint64_t inRaw, const uint32_t inShift, const uint32_t inLength) {
+    return (inRaw & mask (inLength)) << inShift ;
+  }
+
+  //--- Scaled value to raw value, rounded to nearest
+  public: static constexpr int64_t toRaw (const float inValue, const float inInverseFactor, const float inOffset) {
+    return (int64_t) ((inValue - inOffset) * inInverseFactor + ((inValue >= inOffset) ? 0.5f : -0.5f)) ;
+  }
+
+  public: static constexpr uint64_t byteSwap (const uint64_t inWord) {
+    return __builtin_bswap64 (inWord) ;
+  }
+
+  public: static inline uint64_t intelWord (const CANMessage & inFrame) { return inFrame.data64 ; }
+
+  public: static inline uint64_t motorolaWord (const CANMessage & inFrame) { return byteSwap (inFrame.data64) ; }
+} ;
+
+//----------------------------------------------------------------------------------------------------------------------
+//   Identifier -> decoder dispatch table entry (key: identifier, bit 31 set for an extended frame, as in .dbc files)
+//----------------------------------------------------------------------------------------------------------------------
+
+template <typename HANDLERS> class ACANSignalDispatchEntry {
+  public: uint32_t mKey ;
+  public: bool (*mDecode) (const CANMessage & inFrame, const HANDLERS & inHandlers) ;
+} ;
+
+//----------------------------------------------------------------------------------------------------------------------
+// Binary search in a table sorted by key; returns false if the frame is unknown, too short or a remote frame
+
+template <typename HANDLERS> inline bool dispatchSignalFrame (const ACANSignalDispatchEntry <HANDLERS> * inTable,
+                                                              const uint32_t inCount,
+                                                              const CANMessage & inFrame,
+                                                              const HANDLERS & inHandlers) {
+  const uint32_t key = inFrame.id | (inFrame.ext ? 0x80000000UL : 0) ;
+  uint32_t low = 0 ;
+  uint32_t high = inCount ;
+  while (low < high) {
+    const uint32_t middle = (low + high) / 2 ;
+    if (inTable [middle].mKey < key) {
+      low = middle + 1 ;
+    }else{
+      high = middle ;
+    }
+  }
+  return (low < inCount) && (inTable [low].mKey == key) && !inFrame.rtr && inTable [low].mDecode (inFrame, inHandlers) ;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#endif
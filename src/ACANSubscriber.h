@@ -0,0 +1,263 @@
+/******************************************************************************/
+/* File name        : ACANSubscriber.h                                        */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Description      : Received frame fan-out to several subscribers           */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation                                                        */
+/* ---------------------------------------------------------------------------*/
+
+#ifndef ACAN_SUBSCRIBER_CLASS_DEFINED
+#define ACAN_SUBSCRIBER_CLASS_DEFINED
+
+/*------------------------------- Include files ------------------------------*/
+#include "CANMessage.h"
+#include "ACANInternalRAM.h"
+#include <atomic>
+
+//----------------------------------------------------------------------------------------------------------------------
+// A subscriber owns identifier filters and a bounded ring of received frames. The ring has one producer (the receive
+// path, ACANFanOut::dispatch) and one consumer (the subscriber task, receive): no lock, the producer only writes the
+// head index, the consumer only the tail index (release / acquire ordering, so producer and consumer may run on
+// different cores). A full ring drops the frame and counts it: a slow subscriber loses its own frames, it never
+// delays the receive path nor the other subscribers.
+// Set up (begin, addFilter) before subscribing.
+//----------------------------------------------------------------------------------------------------------------------
+
+class ACANSubscriber {
+
+  public: static const uint8_t kMaxFilterCount = 8 ;
+
+//······················································································································
+// Default constructor, destructor
+//······················································································································
+
+  public: ACANSubscriber (void) :
+  mFrames (nullptr),
+  mMask (0),
+  mHead (0),
+  mTail (0),
+  mDropCount (0),
+  mFilterCount (0),
+  mWakeSemaphore (nullptr),
+  mWaiting (false) {
+  }
+
+  public: ~ ACANSubscriber (void) {
+    free () ;
+  }
+
+//······················································································································
+// begin: ring of inCapacity frames, rounded up to a power of two (at most 32768)
+//······················································································································
+
+  public: bool begin (const uint16_t inCapacity) {
+    free () ;
+    uint32_t size = 1 ;
+    while ((size < inCapacity) && (size < 32768)) {
+      size *= 2 ;
+    }
+    mFrames = allocateInternalRAMArray <CANMessage> (size) ;
+    const bool ok = mFrames != nullptr ;
+    if (ok) {
+      mMask = uint16_t (size - 1) ;
+    }
+    return ok ;
+  }
+
+//······················································································································
+// Filters: a frame matches a filter if its format is the filter format and (id & mask) == (identifier & mask).
+// Without filter, every frame matches. Returns false if there are already kMaxFilterCount filters.
+//······················································································································
+
+  public: bool addFilter (const uint32_t inIdentifier, const uint32_t inMask, const bool inExtended) {
+    const bool ok = mFilterCount < kMaxFilterCount ;
+    if (ok) {
+      mFilterMasks [mFilterCount] = inMask & 0x1FFFFFFFUL ;
+      mFilterKeys [mFilterCount] = (inIdentifier & inMask & 0x1FFFFFFFUL) | (inExtended ? 0x80000000UL : 0) ;
+      mFilterCount += 1 ;
+    }
+    return ok ;
+  }
+
+  public: inline bool addIdentifier (const uint32_t inIdentifier, const bool inExtended) {
+    return addFilter (inIdentifier, inExtended ? 0x1FFFFFFFUL : 0x7FFUL, inExtended) ;
+  }
+
+  public: IRAM_ATTR bool matches (const CANMessage & inFrame) const {
+    const uint32_t format = inFrame.ext ? 0x80000000UL : 0 ;
+    bool match = mFilterCount == 0 ;
+    for (uint8_t i=0 ; (i<mFilterCount) && !match ; i++) {
+      match = ((inFrame.id & mFilterMasks [i]) | format) == mFilterKeys [i] ;
+    }
+    return match ;
+  }
+
+//······················································································································
+// Producer (receive path): false if the ring is full, the frame is dropped
+//······················································································································
+
+  public: IRAM_ATTR bool push (const CANMessage & inFrame) {
+    const uint32_t head = mHead.load (std::memory_order_relaxed) ;
+    const bool ok = (head - mTail.load (std::memory_order_acquire)) <= mMask ;
+    if (ok) {
+      mFrames [head & mMask] = inFrame ;
+      mHead.store (head + 1, std::memory_order_release) ;
+    }else{
+      mDropCount += 1 ;
+    }
+    return ok ;
+  }
+
+//······················································································································
+// Consumer (the subscriber task): oldest frame, false if none
+//······················································································································
+
+  public: bool receive (CANMessage & outFrame) {
+    const uint32_t tail = mTail.load (std::memory_order_relaxed) ;
+    const bool ok = tail != mHead.load (std::memory_order_acquire) ;
+    if (ok) {
+      outFrame = mFrames [tail & mMask] ;
+      mTail.store (tail + 1, std::memory_order_release) ;
+    }
+    return ok ;
+  }
+
+//······················································································································
+// Accessors (from any task: approximate while frames arrive)
+//······················································································································
+
+  public: inline uint16_t capacity (void) const { return (mFrames == nullptr) ? 0 : uint16_t (mMask + 1) ; }
+  public: inline uint32_t count (void) const { return mHead.load () - mTail.load () ; }
+  public: inline uint32_t deliveredCount (void) const { return mHead.load () ; } // Pushed to the ring
+  public: inline uint32_t dropCount (void) const { return mDropCount ; }
+  public: inline uint8_t filterCount (void) const { return mFilterCount ; }
+
+//······················································································································
+// Free
+//······················································································································
+
+  public: void free (void) {
+    freeInternalRAMArray (mFrames) ; mFrames = nullptr ;
+    mMask = 0 ;
+    mHead.store (0) ;
+    mTail.store (0) ;
+  }
+
+//······················································································································
+// Private properties
+//······················································································································
+
+  private: CANMessage * mFrames ;
+  private: uint16_t mMask ;                // Ring size - 1
+  private: std::atomic <uint32_t> mHead ;  // Frames pushed (written by the producer only)
+  private: std::atomic <uint32_t> mTail ;  // Frames received (written by the consumer only)
+  private: uint32_t mDropCount ;           // Written by the producer only
+  private: uint32_t mFilterMasks [kMaxFilterCount] ;
+  private: uint32_t mFilterKeys [kMaxFilterCount] ;  // Identifier & mask, bit 31 set for extended format
+  private: uint8_t mFilterCount ;
+  private: void * mWakeSemaphore ;         // Binary semaphore of ESP32ACAN::receive with timeout (while subscribed)
+  private: bool mWaiting ;                 // A task waits in ESP32ACAN::receive with timeout
+
+  friend class ESP32ACAN ;
+
+//······················································································································
+// No copy
+//······················································································································
+
+  private: ACANSubscriber (const ACANSubscriber &) = delete ;
+  private: ACANSubscriber & operator = (const ACANSubscriber &) = delete ;
+} ;
+
+//----------------------------------------------------------------------------------------------------------------------
+// Fan-out: every received frame is pushed to the ring of every matching subscriber (at most kMaxSubscriberCount).
+// As ACANMailboxes, no locking here: ESP32ACAN calls subscribe / unsubscribe and dispatch in critical section.
+//----------------------------------------------------------------------------------------------------------------------
+
+class ACANFanOut {
+
+  public: static const uint8_t kMaxSubscriberCount = 8 ;
+
+  public: ACANFanOut (void) :
+  mSubscriberCount (0) {
+  }
+
+//······················································································································
+// Subscription: false if the subscriber has no ring, is already subscribed, or if there are kMaxSubscriberCount
+//······················································································································
+
+  public: bool subscribe (ACANSubscriber * inSubscriber) {
+    bool ok = (inSubscriber != nullptr) && (inSubscriber->capacity () > 0)
+      && (mSubscriberCount < kMaxSubscriberCount) ;
+    for (uint8_t i=0 ; (i<mSubscriberCount) && ok ; i++) {
+      ok = mSubscribers [i] != inSubscriber ;
+    }
+    if (ok) {
+      mSubscribers [mSubscriberCount] = inSubscriber ;
+      mSubscriberCount += 1 ;
+    }
+    return ok ;
+  }
+
+  public: bool unsubscribe (ACANSubscriber * inSubscriber) {
+    bool found = false ;
+    for (uint8_t i=0 ; i<mSubscriberCount ; i++) {
+      if (found) {
+        mSubscribers [i - 1] = mSubscribers [i] ;
+      }else{
+        found = mSubscribers [i] == inSubscriber ;
+      }
+    }
+    if (found) {
+      mSubscriberCount -= 1 ;
+    }
+    return found ;
+  }
+
+//······················································································································
+// dispatch (receive path): returns true if a subscriber matches the frame (pushed or dropped);
+// ioPushed: bit i set if the frame was pushed to subscriber i
+//······················································································································
+
+  public: IRAM_ATTR bool dispatch (const CANMessage & inFrame, uint32_t & ioPushed) {
+    bool matched = false ;
+    for (uint8_t i=0 ; i<mSubscriberCount ; i++) {
+      ACANSubscriber * subscriber = mSubscribers [i] ;
+      if (subscriber->matches (inFrame)) {
+        matched = true ;
+        if (subscriber->push (inFrame)) {
+          ioPushed |= 1UL << i ;
+        }
+      }
+    }
+    return matched ;
+  }
+
+  public: inline uint8_t subscriberCount (void) const { return mSubscriberCount ; }
+  public: inline ACANSubscriber * subscriberAtIndex (const uint8_t inIndex) const { return mSubscribers [inIndex] ; }
+
+//······················································································································
+// Private properties
+//······················································································································
+
+  private: ACANSubscriber * mSubscribers [kMaxSubscriberCount] ;
+  private: uint8_t mSubscriberCount ;
+
+//······················································································································
+// No copy
+//······················································································································
+
+  private: ACANFanOut (const ACANFanOut &) = delete ;
+  private: ACANFanOut & operator = (const ACANFanOut &) = delete ;
+} ;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#endif
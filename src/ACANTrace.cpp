@@ -0,0 +1,183 @@
+/******************************************************************************/
+/* File name        : ACANTrace.cpp                                           */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Description      : Event trace ring of the driver internals                */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation                                                        */
+/* ---------------------------------------------------------------------------*/
+
+/*------------------------------- Include files ------------------------------*/
+#include "ACANTrace.h"
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   DATE UNIT
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+uint32_t ACANTrace::ticksPerMicrosecond (void) {
+  #ifdef ARDUINO
+    return ESP.getCpuFreqMHz () ;
+  #else
+    return 1000 ;
+  #endif
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   READING
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+uint32_t ACANTrace::firstIndex (uint32_t & outLostCount) const {
+  const uint32_t count = recordCount () ;
+  const uint32_t capacity = this->capacity () ;
+  outLostCount = (count > capacity) ? (count - capacity) : 0 ;
+  return outLostCount ;
+}
+
+//······················································································································
+
+uint32_t ACANTrace::snapshot (ACANTraceRecord outRecords [],
+                              const uint32_t inMaxCount,
+                              uint32_t & outLostCount) const {
+  uint32_t copied = 0 ;
+  uint32_t first = firstIndex (outLostCount) ;
+  const uint32_t last = recordCount () ;
+  if ((last - first) > inMaxCount) {
+    outLostCount += (last - first) - inMaxCount ;
+    first = last - inMaxCount ;
+  }
+  for (uint32_t i=first ; (i != last) && (capacity () > 0) ; i++) {
+    outRecords [copied] = mRecords [i & mMask] ;
+    copied += 1 ;
+  }
+//--- Records overwritten during the copy (by records made after last) are not valid: drop them
+  const uint32_t after = recordCount () ;
+  if ((after - first) > capacity ()) {
+    uint32_t overwritten = (after - first) - capacity () ;
+    if (overwritten > copied) {
+      overwritten = copied ;
+    }
+    for (uint32_t i=overwritten ; i<copied ; i++) {
+      outRecords [i - overwritten] = outRecords [i] ;
+    }
+    copied -= overwritten ;
+    outLostCount += overwritten ;
+  }
+  return copied ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   DUMP CODING
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static const char gHexDigits [] = "0123456789ABCDEF" ;
+
+//······················································································································
+
+static void encodeHex (const uint32_t inValue, const uint8_t inDigitCount, char outText []) {
+  for (uint8_t i=0 ; i<inDigitCount ; i++) {
+    outText [i] = gHexDigits [(inValue >> (4 * (inDigitCount - 1 - i))) & 0x0F] ;
+  }
+}
+
+//······················································································································
+
+static bool decodeHex (const char inText [], const uint8_t inDigitCount, uint32_t & outValue) {
+  bool ok = true ;
+  outValue = 0 ;
+  for (uint8_t i=0 ; (i<inDigitCount) && ok ; i++) {
+    const char c = inText [i] ;
+    uint32_t digit = 0 ;
+    if ((c >= '0') && (c <= '9')) {
+      digit = uint32_t (c - '0') ;
+    }else if ((c >= 'A') && (c <= 'F')) {
+      digit = uint32_t (c - 'A' + 10) ;
+    }else if ((c >= 'a') && (c <= 'f')) {
+      digit = uint32_t (c - 'a' + 10) ;
+    }else{
+      ok = false ;
+    }
+    outValue = (outValue << 4) | digit ;
+  }
+  return ok ;
+}
+
+//······················································································································
+
+void ACANTrace::encodeHeader (const uint32_t inRecordCount,
+                              const uint32_t inLostCount,
+                              char outLine [kDumpHeaderLength]) {
+  const char prefix [] = "ACANTRACE 01 " ;
+  for (uint8_t i=0 ; i<13 ; i++) {
+    outLine [i] = prefix [i] ;
+  }
+  encodeHex (ticksPerMicrosecond (), 8, outLine + 13) ;
+  outLine [21] = ' ' ;
+  encodeHex (inRecordCount, 8, outLine + 22) ;
+  outLine [30] = ' ' ;
+  encodeHex (inLostCount, 8, outLine + 31) ;
+  outLine [39] = '\n' ;
+}
+
+//······················································································································
+
+void ACANTrace::encodeRecord (const ACANTraceRecord & inRecord, char outLine [kDumpLineLength]) {
+  encodeHex (inRecord.mDate, 8, outLine) ;
+  encodeHex (inRecord.mPayload, 4, outLine + 8) ;
+  encodeHex (inRecord.mEvent, 2, outLine + 12) ;
+  encodeHex (inRecord.mCore, 2, outLine + 14) ;
+  outLine [16] = '\n' ;
+}
+
+//······················································································································
+
+bool ACANTrace::decodeRecord (const char inLine [], ACANTraceRecord & outRecord) {
+  uint32_t date = 0 ;
+  uint32_t payload = 0 ;
+  uint32_t event = 0 ;
+  uint32_t core = 0 ;
+  const bool ok = decodeHex (inLine, 8, date)
+    && decodeHex (inLine + 8, 4, payload)
+    && decodeHex (inLine + 12, 2, event)
+    && decodeHex (inLine + 14, 2, core)
+    && (event != 0) ;
+  if (ok) {
+    outRecord.mDate = date ;
+    outRecord.mPayload = uint16_t (payload) ;
+    outRecord.mEvent = uint8_t (event) ;
+    outRecord.mCore = uint8_t (core) ;
+  }
+  return ok ;
+}
+
+//······················································································································
+
+const char * ACANTrace::eventName (const uint8_t inEvent) {
+  const char * result = "?" ;
+  if (inEvent >= kTraceUser) {
+    result = "USER" ;
+  }else{
+    switch (inEvent) {
+    case kTraceISREntry : result = "ISR_ENTRY" ; break ;
+    case kTraceISRExit : result = "ISR_EXIT" ; break ;
+    case kTraceRXDrain : result = "RX_DRAIN" ; break ;
+    case kTraceTXLoad : result = "TX_LOAD" ; break ;
+    case kTraceTXComplete : result = "TX_COMPLETE" ; break ;
+    case kTraceTXQueued : result = "TX_QUEUED" ; break ;
+    case kTraceTXBufferFull : result = "TX_BUFFER_FULL" ; break ;
+    case kTraceReceiveBufferFull : result = "RX_BUFFER_FULL" ; break ;
+    case kTraceDataOverrun : result = "DATA_OVERRUN" ; break ;
+    case kTraceModeChange : result = "MODE_CHANGE" ; break ;
+    default : break ;
+    }
+  }
+  return result ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
@@ -0,0 +1,208 @@
+/******************************************************************************/
+/* File name        : ACANTrace.h                                             */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Description      : Event trace ring of the driver internals                */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation                                                        */
+/* ---------------------------------------------------------------------------*/
+
+#ifndef ACAN_TRACE_CLASS_DEFINED
+#define ACAN_TRACE_CLASS_DEFINED
+
+/*------------------------------- Include files ------------------------------*/
+#include "ACANInternalRAM.h"
+#include <atomic>
+#ifndef ARDUINO
+  #include <chrono>
+#endif
+
+//----------------------------------------------------------------------------------------------------------------------
+// Compile time switch of the driver trace points: build with -DACAN_TRACE=1 (platformio.ini build_flags; Arduino IDE:
+// compiler.cpp.extra_flags in platform.local.txt), or change the default below. With 0, the trace points of ESP32ACAN
+// are not compiled and ESP32ACAN::setTrace returns false.
+//----------------------------------------------------------------------------------------------------------------------
+
+#ifndef ACAN_TRACE
+  #define ACAN_TRACE 0
+#endif
+
+//----------------------------------------------------------------------------------------------------------------------
+//   Events, and their payload
+//----------------------------------------------------------------------------------------------------------------------
+
+typedef enum : uint8_t {
+  kTraceISREntry = 1,          // Interrupt flags (CAN_INTERRUPT)
+  kTraceISRExit,               // Frames in the driver receive buffer
+  kTraceRXDrain,               // Frames read from the controller receive FIFO
+  kTraceTXLoad,                // Identifier (low 16 bits) of the frame written to the TX registers
+  kTraceTXComplete,            // Frames waiting in the driver transmit buffer
+  kTraceTXQueued,              // Frames in the driver transmit buffer, after tryToSend appended one
+  kTraceTXBufferFull,          // Frames in the driver transmit buffer, tryToSend refused the frame
+  kTraceReceiveBufferFull,     // Identifier (low 16 bits) of the dropped frame
+  kTraceDataOverrun,           // Controller overrun count (low 16 bits)
+  kTraceModeChange,            // CAN_MODE written (CAN_MODE_RESET: stopped)
+  kTraceUser = 0x80            // 0x80 ... 0xFF: application events
+} ACANTraceEvent ;
+
+//----------------------------------------------------------------------------------------------------------------------
+//   Record: 8 bytes. Date in CPU cycles (ESP32), ns (desktop): see ticksPerMicrosecond.
+//----------------------------------------------------------------------------------------------------------------------
+
+class ACANTraceRecord {
+  public: uint32_t mDate ;
+  public: uint16_t mPayload ;
+  public: uint8_t mEvent ;
+  public: uint8_t mCore ;
+} ;
+
+//----------------------------------------------------------------------------------------------------------------------
+//   Trace ring. Recording is lock free (one atomic increment reserves the slot) and never blocks: the oldest records
+//   are overwritten. A record being written while a snapshot is taken may be copied incomplete; detach the trace
+//   (ESP32ACAN::setTrace (nullptr)) before a snapshot or a dump for an exact copy.
+//   Dump: text lines, so that the trace can be captured from a serial monitor among other output and decoded by
+//   trace-decoder-on-desktop:
+//     ACANTRACE 01 <ticks per µs> <record count> <lost count>     (8 hex digits each)
+//     <date 8 hex digits><payload 4><event 2><core 2>             (one line per record, oldest first)
+//     ACANTRACE END
+//----------------------------------------------------------------------------------------------------------------------
+
+class ACANTrace {
+
+  public: ACANTrace (void) :
+  mRecords (nullptr),
+  mMask (0),
+  mRecordCount (0) {
+  }
+
+  public: ~ ACANTrace (void) {
+    freeInternalRAMArray (mRecords) ;
+  }
+
+//······················································································································
+// begin: ring of inCapacity records (internal RAM), rounded up to a power of two (at most 65536)
+//······················································································································
+
+  public: bool begin (const uint32_t inCapacity) {
+    freeInternalRAMArray (mRecords) ;
+    uint32_t size = 1 ;
+    while ((size < inCapacity) && (size < 65536)) {
+      size *= 2 ;
+    }
+    mRecords = allocateInternalRAMArray <ACANTraceRecord> (size) ;
+    mMask = (mRecords != nullptr) ? (size - 1) : 0 ;
+    mRecordCount.store (0, std::memory_order_relaxed) ;
+    return mRecords != nullptr ;
+  }
+
+//······················································································································
+// Recording (ISR and tasks, any core)
+//······················································································································
+
+  public: inline IRAM_ATTR void record (const uint8_t inEvent, const uint16_t inPayload) {
+    const uint32_t index = mRecordCount.fetch_add (1, std::memory_order_relaxed) ;
+    ACANTraceRecord & r = mRecords [index & mMask] ;
+    r.mDate = date () ;
+    r.mPayload = inPayload ;
+    r.mEvent = inEvent ;
+    r.mCore = core () ;
+  }
+
+  public: static inline IRAM_ATTR uint32_t date (void) {
+    #ifdef ARDUINO
+      return ESP.getCycleCount () ;
+    #else
+      return uint32_t (std::chrono::duration_cast <std::chrono::nanoseconds> (
+        std::chrono::steady_clock::now ().time_since_epoch ()).count ()) ;
+    #endif
+  }
+
+  public: static inline IRAM_ATTR uint8_t core (void) {
+    #ifdef ARDUINO
+      return uint8_t (xPortGetCoreID ()) ;
+    #else
+      return 0 ;
+    #endif
+  }
+
+  public: static uint32_t ticksPerMicrosecond (void) ;
+
+//······················································································································
+// Reading
+//······················································································································
+
+  public: inline uint32_t capacity (void) const { return (mRecords != nullptr) ? (mMask + 1) : 0 ; }
+
+  public: inline uint32_t recordCount (void) const { return mRecordCount.load (std::memory_order_relaxed) ; }
+
+  public: void clear (void) { mRecordCount.store (0, std::memory_order_relaxed) ; }
+
+  //--- Copies the latest records, oldest first; records overwritten before or during the copy are counted in
+  //    outLostCount. Returns the number of records copied.
+  public: uint32_t snapshot (ACANTraceRecord outRecords [], const uint32_t inMaxCount, uint32_t & outLostCount) const ;
+
+//······················································································································
+// Dump: text lines (see above) written with ioStream.write (bytes, length) (Arduino Print: Serial)
+//······················································································································
+
+  public: static const uint8_t kDumpLineLength = 17 ;   // Record line, with '\n'
+  public: static const uint8_t kDumpHeaderLength = 40 ; // With '\n'
+
+  public: template <typename STREAM> uint32_t dump (STREAM & ioStream) const {
+    const uint32_t capacity = this->capacity () ;
+    uint32_t lostCount = 0 ;
+    const uint32_t first = firstIndex (lostCount) ;
+    const uint32_t last = recordCount () ;
+    char line [kDumpHeaderLength] ;
+    encodeHeader (last - first, lostCount, line) ;
+    ioStream.write ((const uint8_t *) line, kDumpHeaderLength) ;
+    for (uint32_t i=first ; (i != last) && (capacity > 0) ; i++) {
+      encodeRecord (mRecords [i & mMask], line) ;
+      ioStream.write ((const uint8_t *) line, kDumpLineLength) ;
+    }
+    ioStream.write ((const uint8_t *) "ACANTRACE END\n", 14) ;
+    return last - first ;
+  }
+
+//······················································································································
+// Dump coding, also used by the host decoder
+//······················································································································
+
+  public: static void encodeHeader (const uint32_t inRecordCount, const uint32_t inLostCount,
+                                    char outLine [kDumpHeaderLength]) ;
+
+  public: static void encodeRecord (const ACANTraceRecord & inRecord, char outLine [kDumpLineLength]) ;
+
+  //--- 16 hex digits (the '\n' is not read); false if malformed
+  public: static bool decodeRecord (const char inLine [], ACANTraceRecord & outRecord) ;
+
+  public: static const char * eventName (const uint8_t inEvent) ; // "USER" for 0x80 ... 0xFF, "?" if unknown
+
+//······················································································································
+// Private
+//······················································································································
+
+  private: uint32_t firstIndex (uint32_t & outLostCount) const ;
+
+  private: ACANTraceRecord * mRecords ;
+  private: uint32_t mMask ;
+  private: std::atomic <uint32_t> mRecordCount ; // Records ever made since begin or clear
+
+//······················································································································
+//    No copy
+//······················································································································
+
+  private: ACANTrace (const ACANTrace &) = delete ;
+  private: ACANTrace & operator = (const ACANTrace &) = delete ;
+} ;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#endif
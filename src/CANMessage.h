@@ -16,7 +16,15 @@
 #define GENERIC_CAN_MESSAGE_DEFINED
 
 /*------------------------------- Include files ------------------------------*/
-#include <Arduino.h>
+#ifdef ARDUINO
+  #include <Arduino.h>
+#else
+  #include <stdint.h> // Desktop build (see test-*-on-desktop)
+  #ifndef IRAM_ATTR
+    #define IRAM_ATTR // ESP32 interrupt code and data placement, nothing on the desktop
+    #define DRAM_ATTR
+  #endif
+#endif
 
 //——————————————————————————————————————————————————————————————————————————————
 
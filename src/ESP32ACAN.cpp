@@ -16,10 +16,26 @@
 /*   V1.2   | Handling Standard Frames                                        */
 /*   V1.3   | Added Interrupt Handlers                                        */
 /*   V2.0   | Acceptance Filter Settings                                      */
+/*   V2.1   | Fixed format send path, TX command cached by begin              */
+/*          | Latest value mailbox receive mode                               */
+/*          | In place access to the driver receive buffer                    */
+/*          | Bus load meter                                                  */
+/*          | Blocking receive / send with timeout                            */
+/*          | Lossless polling: controller FIFO drained to the receive buffer */
+/*          | IRAM interrupt path, interrupt level and core, end              */
+/*          | Caller provided driver buffer storage                           */
+/*          | Driver buffer statistics                                        */
+/*          | Bit rate detection                                              */
+/*          | Runtime bit timing and filter reconfiguration                   */
+/*          | Payload change detection                                        */
+/*          | Event trace                                                     */
+/*          | Interrupt handler and critical section profile                  */
 /* ---------------------------------------------------------------------------*/
 
 /*------------------------------- Include files ------------------------------*/
 #include "ESP32ACAN.h"
+#include "esp_ipc.h"
+#include "soc/soc_memory_layout.h"
 
 /*------------------------------- Local defines ------------------------------*/
 #define ENABLE_ALL_INTERRUPTS    0xFF
@@ -37,24 +53,35 @@
 //------- https://esp32.com/viewtopic.php?t=1703
 portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
 
-
-//static void myESP32Task (void * pData) {
-//    ESP32ACAN * canDriver = (ESP32ACAN *) pData ;
-//    while (1) {
-//      xSemaphoreTake (canDriver->mISRSemaphore, portMAX_DELAY) ;
-//    }
-//}
-
 //——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
 //   CONSTRUCTOR,
 //——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
 
 ESP32ACAN::ESP32ACAN (void) :
   
+  mReconfigurationMicros(0),
   mDriverReceiveBuffer(),
+  mDriverReceiveDropCount(0),
+  mControllerOverrunCount(0),
+  mMailboxes(),
+  mReceiveMode(ESP32ACANSettings::FIFOReceive),
   mDriverTransmitBuffer(),
   mDriverSending(false),
-  mISRSemaphore (xSemaphoreCreateCounting (10, 0))
+  mTXCommand(CAN_CMD_TX_REQ),
+  mBusLoad(nullptr),
+  mChangeFilter(nullptr),
+  mFanOut(),
+  mSubscriberPushes(0),
+  mSubscriberGivesInFlight(0),
+  mTrace(nullptr),
+  mProfiler(nullptr),
+  mInterruptHandlerCycles(0),
+  mInterruptHandle(nullptr),
+  mInterruptCoreID(0),
+  mReceiveSemaphore (xSemaphoreCreateBinary ()),
+  mTransmitSemaphore (xSemaphoreCreateBinary ()),
+  mReceiveWaiting (false),
+  mTransmitWaiting (false)
   {}
 
 //——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
@@ -113,6 +140,7 @@ void ESP32ACAN::setRequestedCANMode(const ESP32ACANSettings &inSettings, const E
   do{
     CAN_MODE = requestedMode;
   }while ((CAN_MODE & CAN_MODE_RESET) != 0) ;
+  trace (kTraceModeChange, requestedMode) ;
 }
 
 //——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
@@ -180,6 +208,9 @@ uint16_t ESP32ACAN::internalBeginConfiguration (const ESP32ACANSettings &inSetti
                                                 const ESP32ACANFilter inFilterSettings) {
   uint16_t errorCode = 0; // Ok be default
 
+  //--- A previous begin may have allocated the interrupt
+  releaseInterrupt () ;
+
   //Enable CAN module
   //----Access the CAN Peripheral registers and initialize the CLOCK
   //https://github.com/ThomasBarth/ESP32-CAN-Driver/blob/master/components/can/CAN.c
@@ -216,13 +247,38 @@ uint16_t ESP32ACAN::internalBeginConfiguration (const ESP32ACANSettings &inSetti
   if (inSettings.CANBitSettingConsistency() != 0) {
     errorCode |= kInconsistentBitRateSettings;
   }
-    //----------------------------------- Allocate buffer
-  if (!mDriverReceiveBuffer.initWithSize (inSettings.mDriverReceiveBufferSize)) {
+    //----------------------------------- Allocate buffer (none in MailboxReceive mode: memory bounded by the mailboxes)
+  mReceiveMode = inSettings.mReceiveMode ;
+  const uint16_t receiveBufferSize = (mReceiveMode == ESP32ACANSettings::MailboxReceive)
+    ? 0
+    : inSettings.mDriverReceiveBufferSize ;
+  if (inSettings.mDriverReceiveBufferStorage != nullptr) {
+    mDriverReceiveBuffer.initWithStorage (inSettings.mDriverReceiveBufferStorage, receiveBufferSize) ;
+  }else if (!mDriverReceiveBuffer.initWithSize (receiveBufferSize)) {
     errorCode |= kCannotAllocateDriverReceiveBuffer ;
   }
-  if (!mDriverTransmitBuffer.initWithSize (inSettings.mDriverTransmitBufferSize)) {
+  mDriverReceiveDropCount = 0 ;
+  mControllerOverrunCount = 0 ;
+  if (mReceiveMode == ESP32ACANSettings::FIFOReceive) {
+    mMailboxes.free () ;
+  }else if ((inSettings.mMailboxIdentifiers == nullptr) || (inSettings.mMailboxCount == 0)) {
+    errorCode |= kNoMailboxIdentifier ;
+  }else if (!mMailboxes.initWithKeys (inSettings.mMailboxIdentifiers, inSettings.mMailboxCount)) {
+    errorCode |= kCannotAllocateMailboxes ;
+  }
+  if (inSettings.mDriverTransmitBufferStorage != nullptr) {
+    mDriverTransmitBuffer.initWithStorage (inSettings.mDriverTransmitBufferStorage, inSettings.mDriverTransmitBufferSize) ;
+  }else if (!mDriverTransmitBuffer.initWithSize (inSettings.mDriverTransmitBufferSize)) {
     errorCode |= kCannotAllocateDriverTransmitBuffer ;
   }
+  //--- The IRAM interrupt handler runs with the flash cache disabled: PSRAM is not reachable then
+  const bool externalStorage =
+    ((inSettings.mDriverReceiveBufferStorage != nullptr) && esp_ptr_external_ram (inSettings.mDriverReceiveBufferStorage))
+    || ((inSettings.mDriverTransmitBufferStorage != nullptr) && esp_ptr_external_ram (inSettings.mDriverTransmitBufferStorage)) ;
+  if (externalStorage && inSettings.mInterruptInIRAM
+   && (inSettings.mControlMessageByMethod == ESP32ACANSettings::InterruptControlled)) {
+    errorCode |= kExternalRAMBufferWithIRAMInterrupt ;
+  }
   if (errorCode == 0) {
     //--------------------------------- Set Bustiming Registers
     setBitTimingSettings(inSettings);
@@ -242,6 +298,10 @@ uint16_t ESP32ACAN::internalBeginConfiguration (const ESP32ACANSettings &inSetti
   //--------------------------------- Set to Requested Mode
   setRequestedCANMode(inSettings,inFilterSettings);
 
+  //--------------------------------- Transmit command: in LoopBackMode, the controller receives its own frames
+  mTXCommand = (inSettings.mRequestedCANMode == ESP32ACANSettings::LoopBackMode)
+    ? CAN_CMD_SELF_RX_REQ
+    : CAN_CMD_TX_REQ ;
   
   switch(inSettings.mControlMessageByMethod) {
     case ESP32ACANSettings::PollingControlled :
@@ -257,36 +317,273 @@ uint16_t ESP32ACAN::internalBeginConfiguration (const ESP32ACANSettings &inSetti
       
       //--------------------------------- Clear the Interrupt Registers
       const uint8_t unusedVariable __attribute__((unused)) = CAN_INTERRUPT;
-      esp_intr_alloc(ETS_CAN_INTR_SOURCE, 0, isr, this, NULL);
+      if ((inSettings.mInterruptLevel < 1) || (inSettings.mInterruptLevel > 3)) {
+        errorCode |= kInvalidInterruptLevel ;
+      }else if (!allocateInterrupt (inSettings)) {
+        errorCode |= kCannotAllocateInterrupt ;
+      }
     break;
   }
   return errorCode;
 }
 
 //——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
-//   Interrupt Handler
+//   END
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ESP32ACAN::end (void) {
+  releaseInterrupt () ;
+  CAN_MODE = CAN_MODE_RESET ;
+  trace (kTraceModeChange, CAN_MODE_RESET) ;
+  portENTER_CRITICAL (&mux) ;
+  mDriverReceiveBuffer.free () ;
+  mDriverTransmitBuffer.free () ;
+  mMailboxes.free () ;
+  mDriverSending = false ;
+  portEXIT_CRITICAL (&mux) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   RUNTIME RECONFIGURATION. Reset mode aborts the frame being sent, clears the controller receive FIFO and the
+//   interrupt flags. So the controller is reset only when its TX buffer is free, in critical section (the interrupt
+//   handler waits), after the receive FIFO has been drained; the interrupt flags are read before (the handler will
+//   not see them) and the transmit interrupt of the last frame is handled after: it sends the next queued frame.
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static const uint32_t kTransmitWaitMicros = 20 * 1000 ; // Then the frame is aborted (no acknowledge, bus off)
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ESP32ACAN::reconfigureInResetMode (const ESP32ACANSettings * inSettings, const ESP32ACANFilter * inFilter) {
+  //--- Wait for the end of the frame being sent, the interrupt handler may run between two attempts
+  const uint32_t waitStart = micros () ;
+  bool aborted = false ;
+  portENTER_CRITICAL (&mux) ;
+  while ((CAN_STATUS & CAN_STATUS_TXB) == 0) {
+    if (!aborted && ((micros () - waitStart) >= kTransmitWaitMicros)) {
+      CAN_CMD = CAN_CMD_ABORT_TX ;
+      aborted = true ;
+    }
+    portEXIT_CRITICAL (&mux) ;
+    portENTER_CRITICAL (&mux) ;
+  }
+  //--- Interrupt flags and receive FIFO, as the interrupt handler would
+  const uint8_t unusedVariable __attribute__((unused)) = CAN_INTERRUPT ;
+  drainReceiveRegisters () ;
+  //--- Downtime
+  const uint32_t start = micros () ;
+  const uint32_t mode = CAN_MODE & ~CAN_MODE_RESET ;
+  do{
+    CAN_MODE = mode | CAN_MODE_RESET ;
+  }while ((CAN_MODE & CAN_MODE_RESET) == 0) ;
+  uint32_t requestedMode = mode ;
+  if (inSettings != nullptr) {
+    setBitTimingSettings (*inSettings) ;
+  }
+  if (inFilter != nullptr) {
+    setAcceptanceFilter (*inFilter) ;
+    requestedMode = (mode & ~CAN_MODE_ACCFILTER) | (inFilter->mAMFSingle ? CAN_MODE_ACCFILTER : 0) ;
+  }
+  do{
+    CAN_MODE = requestedMode ;
+  }while ((CAN_MODE & CAN_MODE_RESET) != 0) ;
+  mReconfigurationMicros = micros () - start ;
+  trace (kTraceModeChange, uint16_t (requestedMode)) ;
+  //--- TX buffer free while sending: the transmit interrupt of the last frame was not handled
+  const bool transmitInterrupt = !mSendbyPoll && mDriverSending ;
+  if (transmitInterrupt) {
+    handleTXInterrupt () ;
+  }
+  const bool wakeReceiver = mReceiveWaiting && (mDriverReceiveBuffer.count () > 0) ;
+  if (wakeReceiver) {
+    mReceiveWaiting = false ;
+  }
+  const bool wakeSender = mTransmitWaiting && transmitInterrupt ;
+  if (wakeSender) {
+    mTransmitWaiting = false ;
+  }
+  //--- xSemaphoreGive may yield, so not in critical section: unsubscribe waits for these gives before deleting
+  SemaphoreHandle_t subscriberSemaphores [ACANFanOut::kMaxSubscriberCount] ;
+  const uint8_t subscriberWakeCount = takeSubscriberWakes (subscriberSemaphores) ;
+  if (subscriberWakeCount > 0) {
+    mSubscriberGivesInFlight += 1 ;
+  }
+  portEXIT_CRITICAL (&mux) ;
+  if (wakeReceiver) {
+    xSemaphoreGive (mReceiveSemaphore) ;
+  }
+  if (wakeSender) {
+    xSemaphoreGive (mTransmitSemaphore) ;
+  }
+  if (subscriberWakeCount > 0) {
+    for (uint8_t i=0 ; i<subscriberWakeCount ; i++) {
+      xSemaphoreGive (subscriberSemaphores [i]) ;
+    }
+    portENTER_CRITICAL (&mux) ;
+    mSubscriberGivesInFlight -= 1 ;
+    portEXIT_CRITICAL (&mux) ;
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+uint32_t ESP32ACAN::reconfigure (const ESP32ACANSettings & inSettings) {
+  uint32_t errorCode = 0 ;
+  if (!inSettings.mBitRateClosedToDesiredRate) {
+    errorCode |= kTooFarFromDesiredBitRate ;
+  }
+  if (inSettings.CANBitSettingConsistency () != 0) {
+    errorCode |= kInconsistentBitRateSettings ;
+  }
+  if (errorCode == 0) {
+    reconfigureInResetMode (&inSettings, nullptr) ;
+  }
+  return errorCode ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ESP32ACAN::setFilter (const ESP32ACANFilter inFilter) {
+  reconfigureInResetMode (nullptr, &inFilter) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   Interrupt allocation: esp_intr_alloc binds the handler to the core it runs on, esp_intr_free must run there too
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+class InterruptAllocation {
+  public: int mFlags ;
+  public: void * mDriver ;
+  public: intr_handle_t * mHandle ;
+  public: bool mOk ;
+} ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void allocateInterruptOnThisCore (void * ioAllocation) {
+  InterruptAllocation * allocation = (InterruptAllocation *) ioAllocation ;
+  allocation->mOk = esp_intr_alloc (ETS_CAN_INTR_SOURCE,
+                                    allocation->mFlags,
+                                    ESP32ACAN::isr,
+                                    allocation->mDriver,
+                                    allocation->mHandle) == ESP_OK ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void freeInterruptOnThisCore (void * inHandle) {
+  esp_intr_free (*((intr_handle_t *) inHandle)) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+bool ESP32ACAN::allocateInterrupt (const ESP32ACANSettings & inSettings) {
+  InterruptAllocation allocation ;
+  allocation.mFlags = (ESP_INTR_FLAG_LEVEL1 << (inSettings.mInterruptLevel - 1))
+                    | (inSettings.mInterruptInIRAM ? ESP_INTR_FLAG_IRAM : 0) ;
+  allocation.mDriver = this ;
+  allocation.mHandle = &mInterruptHandle ;
+  allocation.mOk = false ;
+  switch (inSettings.mInterruptCore) {
+    case ESP32ACANSettings::Core0 : mInterruptCoreID = 0 ; break ;
+    case ESP32ACANSettings::Core1 : mInterruptCoreID = 1 ; break ;
+    default : mInterruptCoreID = xPortGetCoreID () ; break ;
+  }
+  if (mInterruptCoreID == xPortGetCoreID ()) {
+    allocateInterruptOnThisCore (&allocation) ;
+  }else if (esp_ipc_call_blocking (mInterruptCoreID, allocateInterruptOnThisCore, &allocation) != ESP_OK) {
+    allocation.mOk = false ;
+  }
+  if (!allocation.mOk) {
+    mInterruptHandle = nullptr ;
+  }
+  return allocation.mOk ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ESP32ACAN::releaseInterrupt (void) {
+  if (mInterruptHandle != nullptr) {
+    CAN_IER = 0 ;
+    if (mInterruptCoreID == xPortGetCoreID ()) {
+      freeInterruptOnThisCore (&mInterruptHandle) ;
+    }else{
+      esp_ipc_call_blocking (mInterruptCoreID, freeInterruptOnThisCore, &mInterruptHandle) ;
+    }
+    mInterruptHandle = nullptr ;
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   Interrupt Handler (IRAM: runs while the flash cache is disabled if mInterruptInIRAM; so do all the functions
+//   it calls, and the data it reads is in DRAM)
 //——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
 
-void ESP32ACAN::isr(void *arg) {
+void IRAM_ATTR ESP32ACAN::isr(void *arg) {
 
+    const uint32_t entryDate = profileDate () ;
     ESP32ACAN *myDriver = (ESP32ACAN *)arg;
-    //BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
    
     portENTER_CRITICAL(&mux);
+    const uint32_t lockDate = profileDate () ;
+    #if ACAN_PROFILE
+      if ((myDriver->mProfiler != nullptr) && (myDriver->mInterruptHandlerCycles != 0)) {
+        myDriver->mProfiler->recordDuration (ACANProfiler::InterruptHandler, myDriver->mInterruptHandlerCycles) ;
+      }
+    #endif
     uint32_t interrupt = CAN_INTERRUPT;
+    myDriver->trace (kTraceISREntry, uint16_t (interrupt)) ;
       if((interrupt & CAN_INTERRUPT_RX) != 0) {
+        const uint32_t handlerDate = profileDate () ;
         myDriver->handleRXInterrupt();
+        myDriver->profile (ACANProfiler::RXHandler, handlerDate) ;
       }
       if((interrupt & CAN_INTERRUPT_TX) != 0) {
+        const uint32_t handlerDate = profileDate () ;
         myDriver->handleTXInterrupt();
+        myDriver->profile (ACANProfiler::TXHandler, handlerDate) ;
+      }
+      if((interrupt & CAN_INTERRUPT_DATAOVERRUN) != 0) {
+        myDriver->clearDataOverrun();
+      }
+    //--- Wake a waiting task only if its buffer state changed: a frame to read, a transmit slot freed
+      const bool wakeReceiver = myDriver->mReceiveWaiting && (myDriver->mDriverReceiveBuffer.count () > 0) ;
+      if (wakeReceiver) {
+        myDriver->mReceiveWaiting = false ;
+      }
+      const bool wakeSender = myDriver->mTransmitWaiting && ((interrupt & CAN_INTERRUPT_TX) != 0) ;
+      if (wakeSender) {
+        myDriver->mTransmitWaiting = false ;
       }
+    //--- Subscriber semaphores given in critical section: unsubscribe deletes them once out of the fan out
+      SemaphoreHandle_t subscriberSemaphores [ACANFanOut::kMaxSubscriberCount] ;
+      const uint8_t subscriberWakeCount = myDriver->takeSubscriberWakes (subscriberSemaphores) ;
+      for (uint8_t i=0 ; i<subscriberWakeCount ; i++) {
+        xSemaphoreGiveFromISR(subscriberSemaphores [i], &xHigherPriorityTaskWoken);
+      }
+    myDriver->trace (kTraceISRExit, myDriver->mDriverReceiveBuffer.count ()) ;
+    myDriver->profile (ACANProfiler::InterruptCriticalSection, lockDate) ;
     portEXIT_CRITICAL(&mux);
 
-    //xSemaphoreGiveFromISR(myDriver->mISRSemaphore, &xHigherPriorityTaskWoken);
-    portYIELD_FROM_ISR();
+    if (wakeReceiver) {
+      xSemaphoreGiveFromISR(myDriver->mReceiveSemaphore, &xHigherPriorityTaskWoken);
+    }
+    if (wakeSender) {
+      xSemaphoreGiveFromISR(myDriver->mTransmitSemaphore, &xHigherPriorityTaskWoken);
+    }
+    #if ACAN_PROFILE
+      const uint32_t cycles = profileDate () - entryDate ;
+      myDriver->mInterruptHandlerCycles = (cycles != 0) ? cycles : 1 ; // Only written here, outside critical section
+    #else
+      (void) entryDate ;
+    #endif
+    if (xHigherPriorityTaskWoken) {
+      portYIELD_FROM_ISR();
+    }
 }
 
-void ESP32ACAN::handleTXInterrupt() {
+void IRAM_ATTR ESP32ACAN::handleTXInterrupt() {
   CANMessage message ;
   const bool sendmsg = mDriverTransmitBuffer.remove (message);
   
@@ -295,18 +592,77 @@ void ESP32ACAN::handleTXInterrupt() {
   }else {
     mDriverSending = false;
   }
+  trace (kTraceTXComplete, mDriverTransmitBuffer.count ()) ;
 }
 
-void ESP32ACAN::handleRXInterrupt(void) {
+void IRAM_ATTR ESP32ACAN::handleRXInterrupt(void) {
   
   CANMessage outFrame;
   
   uint8_t RXMcount = CAN_RXM_COUNTER;
   for(uint32_t i=0 ; i< RXMcount; i++) {
     handleMessages(outFrame);
-    mDriverReceiveBuffer.append(outFrame);  
+    storeReceivedFrame(outFrame);
+  }
+  trace (kTraceRXDrain, RXMcount) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   Received frame, unless the change filter suppresses it, to the matching subscribers, otherwise to its mailbox or to
+//   the driver receive buffer (called in critical section)
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void IRAM_ATTR ESP32ACAN::storeReceivedFrame (const CANMessage & inFrame) {
+  recordFrame (inFrame) ;
+  const bool store = (mChangeFilter == nullptr) || mChangeFilter->deliver (inFrame, uint32_t (esp_timer_get_time () / 1000)) ;
+  if (store && !mFanOut.dispatch (inFrame, mSubscriberPushes)) {
+    switch (mReceiveMode) {
+      case ESP32ACANSettings::FIFOReceive :
+        if (!mDriverReceiveBuffer.append (inFrame)) {
+          mDriverReceiveDropCount += 1 ;
+          trace (kTraceReceiveBufferFull, uint16_t (inFrame.id)) ;
+        }
+        break ;
+      case ESP32ACANSettings::MailboxReceive :
+        mMailboxes.store (inFrame) ;
+        break ;
+      case ESP32ACANSettings::MailboxAndFIFOReceive :
+        if (!mMailboxes.store (inFrame) && !mDriverReceiveBuffer.append (inFrame)) {
+          mDriverReceiveDropCount += 1 ;
+          trace (kTraceReceiveBufferFull, uint16_t (inFrame.id)) ;
+        }
+        break ;
+    }
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   Polling: every frame of the controller receive FIFO goes to the driver receive buffer or the mailboxes before
+//   reading them, so no frame is lost while the buffer has room (called in critical section)
+
+void ESP32ACAN::drainReceiveRegisters (void) {
+  if ((CAN_STATUS & CAN_STATUS_DATAOVERRUN) != 0) {
+    clearDataOverrun () ;
+  }
+  CANMessage frame ;
+  uint16_t count = 0 ;
+  while ((CAN_STATUS & CAN_STATUS_RXB) != 0) {
+    handleMessages (frame) ;
+    storeReceivedFrame (frame) ;
+    count += 1 ;
+  }
+  if (count > 0) {
+    trace (kTraceRXDrain, count) ;
   }
 }
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void IRAM_ATTR ESP32ACAN::clearDataOverrun (void) {
+  mControllerOverrunCount += 1 ;
+  CAN_CMD = CAN_CMD_CLEAR_DATAOVERRUN ;
+  trace (kTraceDataOverrun, uint16_t (mControllerOverrunCount)) ;
+}
   
 //——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
 //   RECEPTION
@@ -314,12 +670,10 @@ void ESP32ACAN::handleRXInterrupt(void) {
 
 bool ESP32ACAN::receivebypolling(CANMessage &outMessage) {
   portENTER_CRITICAL(&mux);
-  bool hasReceivedMessage = (CAN_STATUS & CAN_STATUS_RXB) != 0;
-  if (hasReceivedMessage) {
-    for (uint32_t i = 0; i < CAN_RXM_COUNTER; i++){
-      handleMessages(outMessage);
-    }
-  }
+  const uint32_t lockDate = profileDate () ;
+  drainReceiveRegisters () ;
+  const bool hasReceivedMessage = mDriverReceiveBuffer.remove(outMessage);
+  profile (ACANProfiler::ReceiveCriticalSection, lockDate) ;
   portEXIT_CRITICAL(&mux);
   return hasReceivedMessage;
 }
@@ -327,14 +681,14 @@ bool ESP32ACAN::receivebypolling(CANMessage &outMessage) {
 //——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
 
 bool ESP32ACAN::receive(CANMessage &outMessage) {
-
-  static bool hasReceivedMessage;
-  
-  if(mReceivebyPoll) {
+  bool hasReceivedMessage ;
+  if (mReceivebyPoll) {
     hasReceivedMessage = receivebypolling(outMessage);
   }else {
     portENTER_CRITICAL(&mux);
+    const uint32_t lockDate = profileDate () ;
     hasReceivedMessage = mDriverReceiveBuffer.remove(outMessage);
+    profile (ACANProfiler::ReceiveCriticalSection, lockDate) ;
     portEXIT_CRITICAL(&mux);
   }
   return hasReceivedMessage;
@@ -342,7 +696,111 @@ bool ESP32ACAN::receive(CANMessage &outMessage) {
 
 //——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
 
-void ESP32ACAN::handleMessages(CANMessage &outFrame) {
+uint16_t ESP32ACAN::receive (CANMessage outMessages [], const uint16_t inMaxCount) {
+  uint16_t count = 0 ;
+  portENTER_CRITICAL (&mux) ;
+  const uint32_t lockDate = profileDate () ;
+  if (mReceivebyPoll) {
+    drainReceiveRegisters () ;
+  }
+  while ((count < inMaxCount) && mDriverReceiveBuffer.remove (outMessages [count])) {
+    count += 1 ;
+  }
+  profile (ACANProfiler::ReceiveCriticalSection, lockDate) ;
+  portEXIT_CRITICAL (&mux) ;
+  return count ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+// The waiting flag is set before the last attempt: a frame stored by the interrupt after this attempt gives the
+// semaphore. A stale give (frame read by the attempt) only causes one more attempt.
+
+bool ESP32ACAN::receive (CANMessage & outMessage, const TickType_t inTimeoutTicks) {
+  bool received = receive (outMessage) ;
+  if (!received && (inTimeoutTicks > 0)) {
+    TimeOut_t timeOut ;
+    vTaskSetTimeOutState (&timeOut) ;
+    TickType_t remainingTicks = inTimeoutTicks ;
+    while (!received && (xTaskCheckForTimeOut (&timeOut, &remainingTicks) == pdFALSE)) {
+      if (mReceivebyPoll) {
+        vTaskDelay (1) ;
+        received = receive (outMessage) ;
+      }else{
+        portENTER_CRITICAL (&mux) ;
+        mReceiveWaiting = true ;
+        portEXIT_CRITICAL (&mux) ;
+        received = receive (outMessage) ;
+        if (!received) {
+          xSemaphoreTake (mReceiveSemaphore, remainingTicks) ;
+          received = receive (outMessage) ;
+        }
+      }
+    }
+    portENTER_CRITICAL (&mux) ;
+    mReceiveWaiting = false ;
+    portEXIT_CRITICAL (&mux) ;
+  }
+  return received ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+bool ESP32ACAN::peekReceivedFrame (const CANMessage * & outFrame) {
+  portENTER_CRITICAL (&mux) ;
+  if (mReceivebyPoll) {
+    drainReceiveRegisters () ;
+  }
+  outFrame = mDriverReceiveBuffer.first () ;
+  portEXIT_CRITICAL (&mux) ;
+  return outFrame != nullptr ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ESP32ACAN::releaseReceivedFrame (void) {
+  portENTER_CRITICAL (&mux) ;
+  mDriverReceiveBuffer.dropFirst () ;
+  portEXIT_CRITICAL (&mux) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   MAILBOXES
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+uint16_t ESP32ACAN::mailboxIndex (const uint32_t inIdentifier, const bool inExtended) const {
+  return mMailboxes.indexOfKey (ACANMailboxes::key (inIdentifier, inExtended)) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+bool ESP32ACAN::receiveMailbox (const uint16_t inIndex, CANMessage & outMessage, uint32_t & outSequence) {
+  bool updated = false ;
+  if (inIndex < mMailboxes.count ()) {
+    portENTER_CRITICAL (&mux) ;
+    if (mReceivebyPoll) {
+      drainReceiveRegisters () ;
+    }
+    updated = mMailboxes.read (inIndex, outMessage, outSequence) ;
+    portEXIT_CRITICAL (&mux) ;
+  }
+  return updated ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+bool ESP32ACAN::receiveUpdatedMailbox (uint16_t & outIndex, CANMessage & outMessage, uint32_t & outSequence) {
+  portENTER_CRITICAL (&mux) ;
+  if (mReceivebyPoll) {
+    drainReceiveRegisters () ;
+  }
+  const bool updated = mMailboxes.readNextUpdated (outIndex, outMessage, outSequence) ;
+  portEXIT_CRITICAL (&mux) ;
+  return updated ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void IRAM_ATTR ESP32ACAN::handleMessages(CANMessage &outFrame) {
 
   const uint32_t FrameInfo = CAN_FRAME_INFO;
   
@@ -386,11 +844,13 @@ void ESP32ACAN::handleMessages(CANMessage &outFrame) {
 
 bool ESP32ACAN::tryToSendbypolling (const CANMessage &inMessage) {
   portENTER_CRITICAL(&mux);
+  const uint32_t lockDate = profileDate () ;
   const uint8_t txstatus = (uint8_t)CAN_STATUS;
   const bool sendMessage = (txstatus & CAN_STATUS_TXB) != 0;
   if(sendMessage) {
     internalSendMessage(inMessage);
   }
+  profile (ACANProfiler::SendCriticalSection, lockDate) ;
   portEXIT_CRITICAL(&mux);
   return sendMessage;
 }
@@ -404,21 +864,58 @@ bool ESP32ACAN::tryToSend(const CANMessage &inMessage) {
     sendMessage = tryToSendbypolling(inMessage);
   }else if(mDriverSending) {
     portENTER_CRITICAL(&mux);
+    const uint32_t lockDate = profileDate () ;
     sendMessage = mDriverTransmitBuffer.append(inMessage);
+    trace (sendMessage ? kTraceTXQueued : kTraceTXBufferFull, mDriverTransmitBuffer.count ()) ;
+    profile (ACANProfiler::SendCriticalSection, lockDate) ;
     portEXIT_CRITICAL(&mux);
   }else {
     portENTER_CRITICAL(&mux);
+    const uint32_t lockDate = profileDate () ;
     internalSendMessage(inMessage);
     mDriverSending = true;
     sendMessage = true;
+    profile (ACANProfiler::SendCriticalSection, lockDate) ;
     portEXIT_CRITICAL(&mux);
   }
   return sendMessage;
 }
 
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+// Same waiting scheme as receive: any transmit interrupt either frees a slot of the driver transmit buffer or ends
+// the sending.
+
+bool ESP32ACAN::send (const CANMessage & inMessage, const TickType_t inTimeoutTicks) {
+  bool sent = tryToSend (inMessage) ;
+  if (!sent && (inTimeoutTicks > 0)) {
+    TimeOut_t timeOut ;
+    vTaskSetTimeOutState (&timeOut) ;
+    TickType_t remainingTicks = inTimeoutTicks ;
+    while (!sent && (xTaskCheckForTimeOut (&timeOut, &remainingTicks) == pdFALSE)) {
+      if (mSendbyPoll) {
+        vTaskDelay (1) ;
+        sent = tryToSend (inMessage) ;
+      }else{
+        portENTER_CRITICAL (&mux) ;
+        mTransmitWaiting = true ;
+        portEXIT_CRITICAL (&mux) ;
+        sent = tryToSend (inMessage) ;
+        if (!sent) {
+          xSemaphoreTake (mTransmitSemaphore, remainingTicks) ;
+          sent = tryToSend (inMessage) ;
+        }
+      }
+    }
+    portENTER_CRITICAL (&mux) ;
+    mTransmitWaiting = false ;
+    portEXIT_CRITICAL (&mux) ;
+  }
+  return sent ;
+}
+
 //——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
 
-void ESP32ACAN::internalSendMessage(const CANMessage &inFrame) {
+void IRAM_ATTR ESP32ACAN::internalSendMessage(const CANMessage &inFrame) {
 
   //--- DLC
   const uint8_t dlc = (inFrame.len <= 8) ? inFrame.len : 8;
@@ -432,27 +929,395 @@ void ESP32ACAN::internalSendMessage(const CANMessage &inFrame) {
   //--- Set Frame Information
   CAN_FRAME_INFO = id | rtr | CAN_DLC(dlc);
 
+  vuint32_t * dataRegister ;
   if (!inFrame.ext) { //-------Standard Frame
   //--- Set ID
-  CAN_ID_SFF(0)  = (uint8_t)((inFrame.id) >> 3) ;
-  CAN_ID_SFF(1)  = (uint8_t)((inFrame.id) << 5) ;
-
-  //--- Set data
-    for (uint8_t i=0 ; (i<dlc) && (i<CAN_DATA_MAX_LEN) ; i++) {
-      CAN_DATA_SFF(i) = inFrame.data[i];
-    }
+    CAN_ID_SFF(0)  = (uint8_t)((inFrame.id) >> 3) ;
+    CAN_ID_SFF(1)  = (uint8_t)((inFrame.id) << 5) ;
+    dataRegister = &CAN_DATA_SFF(0) ;
   } else { //-------Extended Frame
   //--- Set ID
-   CAN_ID_EFF(0) = (uint8_t)((inFrame.id) >> 21);
-   CAN_ID_EFF(1) = (uint8_t)((inFrame.id) >> 13);
-   CAN_ID_EFF(2) = (uint8_t)((inFrame.id) >> 5);
-   CAN_ID_EFF(3) = (uint8_t)((inFrame.id) << 3);
-
-  //--- Set data
-    for (uint8_t i=0 ; (i<dlc) && (i<CAN_DATA_MAX_LEN) ; i++) {
-      CAN_DATA_EFF(i) = inFrame.data[i];
+    CAN_ID_EFF(0) = (uint8_t)((inFrame.id) >> 21);
+    CAN_ID_EFF(1) = (uint8_t)((inFrame.id) >> 13);
+    CAN_ID_EFF(2) = (uint8_t)((inFrame.id) >> 5);
+    CAN_ID_EFF(3) = (uint8_t)((inFrame.id) << 3);
+    dataRegister = &CAN_DATA_EFF(0) ;
+  }
+
+  //--- Set data, unrolled (no loop counter in the TX interrupt path); no switch, its jump table would be in flash
+  if (dlc > 0) { dataRegister [0] = inFrame.data [0] ; }
+  if (dlc > 1) { dataRegister [1] = inFrame.data [1] ; }
+  if (dlc > 2) { dataRegister [2] = inFrame.data [2] ; }
+  if (dlc > 3) { dataRegister [3] = inFrame.data [3] ; }
+  if (dlc > 4) { dataRegister [4] = inFrame.data [4] ; }
+  if (dlc > 5) { dataRegister [5] = inFrame.data [5] ; }
+  if (dlc > 6) { dataRegister [6] = inFrame.data [6] ; }
+  if (dlc > 7) { dataRegister [7] = inFrame.data [7] ; }
+
+  //--- Command cached by begin, CAN_MODE is not read on every send
+  CAN_CMD = mTXCommand ;
+  trace (kTraceTXLoad, uint16_t (inFrame.id)) ;
+
+  //--- In LoopBackMode, the frame is recorded when received back
+  if (mTXCommand == CAN_CMD_TX_REQ) {
+    recordFrame (inFrame) ;
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   BUS LOAD
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ESP32ACAN::setBusLoadMeter (ACANBusLoad * inMeter) {
+  portENTER_CRITICAL (&mux) ;
+  mBusLoad = inMeter ;
+  portEXIT_CRITICAL (&mux) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+uint16_t ESP32ACAN::busLoadPermille (const ACANBusLoad::Window inWindow) {
+  uint16_t load = 0 ;
+  portENTER_CRITICAL (&mux) ;
+  if (mBusLoad != nullptr) {
+    load = mBusLoad->loadPermille (inWindow, uint32_t (esp_timer_get_time ())) ;
+  }
+  portEXIT_CRITICAL (&mux) ;
+  return load ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   PAYLOAD CHANGE DETECTION
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ESP32ACAN::setChangeFilter (ACANChangeFilter * inFilter) {
+  portENTER_CRITICAL (&mux) ;
+  mChangeFilter = inFilter ;
+  portEXIT_CRITICAL (&mux) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   EVENT TRACE
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+bool ESP32ACAN::setTrace (ACANTrace * inTrace) {
+  #if ACAN_TRACE
+    portENTER_CRITICAL (&mux) ;
+    mTrace = inTrace ;
+    portEXIT_CRITICAL (&mux) ;
+    return true ;
+  #else
+    (void) inTrace ;
+    return false ;
+  #endif
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   PROFILE
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+bool ESP32ACAN::setProfiler (ACANProfiler * inProfiler) {
+  #if ACAN_PROFILE
+    portENTER_CRITICAL (&mux) ;
+    mProfiler = inProfiler ;
+    mInterruptHandlerCycles = 0 ;
+    portEXIT_CRITICAL (&mux) ;
+    return true ;
+  #else
+    (void) inProfiler ;
+    return false ;
+  #endif
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+bool ESP32ACAN::profileStatistics (const ACANProfiler::Section inSection, ACANProfileStatistics & outStatistics) {
+  portENTER_CRITICAL (&mux) ;
+  const bool ok = mProfiler != nullptr ;
+  if (ok) {
+    outStatistics = mProfiler->statistics (inSection) ;
+  }
+  portEXIT_CRITICAL (&mux) ;
+  return ok ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ESP32ACAN::resetProfile (void) {
+  portENTER_CRITICAL (&mux) ;
+  if (mProfiler != nullptr) {
+    mProfiler->reset () ;
+  }
+  mInterruptHandlerCycles = 0 ;
+  portEXIT_CRITICAL (&mux) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   SUBSCRIBERS
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+// The wake semaphore is created outside the critical section, and deleted again if this call created it and the
+// subscription failed (an already subscribed subscriber keeps its own)
+
+bool ESP32ACAN::subscribe (ACANSubscriber & ioSubscriber) {
+  SemaphoreHandle_t createdSemaphore = nullptr ;
+  if (ioSubscriber.mWakeSemaphore == nullptr) {
+    createdSemaphore = xSemaphoreCreateBinary () ;
+  }
+  bool ok = (ioSubscriber.mWakeSemaphore != nullptr) || (createdSemaphore != nullptr) ;
+  if (ok) {
+    portENTER_CRITICAL (&mux) ;
+    ok = mFanOut.subscribe (&ioSubscriber) ;
+    if (ok && (createdSemaphore != nullptr)) {
+      ioSubscriber.mWakeSemaphore = createdSemaphore ;
+      createdSemaphore = nullptr ;
+    }
+    portEXIT_CRITICAL (&mux) ;
+  }
+  if (createdSemaphore != nullptr) {
+    vSemaphoreDelete (createdSemaphore) ;
+  }
+  return ok ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+// The subscriber indexes change: pending wakes are forgotten (a waiting task wakes at its timeout at worst). No task
+// may wait on the subscriber: its wake semaphore is deleted, once no reconfiguration still gives a semaphore it took
+// before (the interrupt handler gives them in critical section).
+
+bool ESP32ACAN::unsubscribe (ACANSubscriber & ioSubscriber) {
+  SemaphoreHandle_t semaphore = nullptr ;
+  portENTER_CRITICAL (&mux) ;
+  const bool ok = mFanOut.unsubscribe (&ioSubscriber) ;
+  if (ok) {
+    mSubscriberPushes = 0 ;
+    ioSubscriber.mWaiting = false ;
+    semaphore = (SemaphoreHandle_t) ioSubscriber.mWakeSemaphore ;
+    ioSubscriber.mWakeSemaphore = nullptr ;
+  }
+  portEXIT_CRITICAL (&mux) ;
+  if (semaphore != nullptr) {
+    bool inFlight = true ;
+    while (inFlight) {
+      portENTER_CRITICAL (&mux) ;
+      inFlight = mSubscriberGivesInFlight > 0 ;
+      portEXIT_CRITICAL (&mux) ;
+      if (inFlight) {
+        vTaskDelay (1) ; // Lets a lower priority reconfiguring task end its gives
+      }
+    }
+    vSemaphoreDelete (semaphore) ;
+  }
+  return ok ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+// The subscriber ring is read without critical section: the receive path is its only producer
+
+bool ESP32ACAN::receive (ACANSubscriber & ioSubscriber, CANMessage & outMessage) {
+  if (mReceivebyPoll) {
+    portENTER_CRITICAL (&mux) ;
+    drainReceiveRegisters () ;
+    portEXIT_CRITICAL (&mux) ;
+  }
+  return ioSubscriber.receive (outMessage) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+// As receive with timeout: the waiting state is set before the last attempt, a frame pushed after this attempt gives
+// the wake semaphore. A stale give (frame read by the attempt) only causes one more attempt.
+
+bool ESP32ACAN::receive (ACANSubscriber & ioSubscriber, CANMessage & outMessage, const TickType_t inTimeoutTicks) {
+  bool received = receive (ioSubscriber, outMessage) ;
+  if (!received && (inTimeoutTicks > 0)) {
+    TimeOut_t timeOut ;
+    vTaskSetTimeOutState (&timeOut) ;
+    TickType_t remainingTicks = inTimeoutTicks ;
+    while (!received && (xTaskCheckForTimeOut (&timeOut, &remainingTicks) == pdFALSE)) {
+      if (mReceivebyPoll) {
+        vTaskDelay (1) ;
+        received = receive (ioSubscriber, outMessage) ;
+      }else{
+        portENTER_CRITICAL (&mux) ;
+        ioSubscriber.mWaiting = true ;
+        portEXIT_CRITICAL (&mux) ;
+        received = ioSubscriber.receive (outMessage) ;
+        if (!received) {
+          xSemaphoreTake ((SemaphoreHandle_t) ioSubscriber.mWakeSemaphore, remainingTicks) ;
+          received = ioSubscriber.receive (outMessage) ;
+        }
+      }
     }
+    portENTER_CRITICAL (&mux) ;
+    ioSubscriber.mWaiting = false ;
+    portEXIT_CRITICAL (&mux) ;
+  }
+  return received ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+uint8_t IRAM_ATTR ESP32ACAN::takeSubscriberWakes (SemaphoreHandle_t outSemaphores [ACANFanOut::kMaxSubscriberCount]) {
+  uint8_t count = 0 ;
+  uint32_t pushes = mSubscriberPushes ;
+  mSubscriberPushes = 0 ;
+  while (pushes != 0) {
+    const uint8_t index = uint8_t (__builtin_ctz (pushes)) ;
+    pushes &= pushes - 1 ;
+    ACANSubscriber * subscriber = mFanOut.subscriberAtIndex (index) ;
+    if (subscriber->mWaiting) {
+      outSemaphores [count] = (SemaphoreHandle_t) subscriber->mWakeSemaphore ;
+      subscriber->mWaiting = false ;
+      count += 1 ;
+    }
+  }
+  return count ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   DRIVER BUFFER STATISTICS: detached while the enqueue dates are (re)allocated, outside the critical section
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+bool ESP32ACAN::setBufferStatistics (ACANBuffer16 & ioBuffer, ACANBufferStatistics * inStatistics) {
+  portENTER_CRITICAL (&mux) ;
+  ioBuffer.attachStatistics (nullptr) ;
+  portEXIT_CRITICAL (&mux) ;
+  const bool ok = ioBuffer.prepareStatistics (inStatistics) ;
+  if (ok) {
+    portENTER_CRITICAL (&mux) ;
+    ioBuffer.attachStatistics (inStatistics) ;
+    portEXIT_CRITICAL (&mux) ;
   }
- 
-  CAN_CMD = ((CAN_MODE & CAN_MODE_SELFTEST) !=0)?CAN_CMD_SELF_RX_REQ : CAN_CMD_TX_REQ;
+  return ok ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+bool ESP32ACAN::setDriverReceiveBufferStatistics (ACANBufferStatistics * inStatistics) {
+  return setBufferStatistics (mDriverReceiveBuffer, inStatistics) ;
 }
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+bool ESP32ACAN::setDriverTransmitBufferStatistics (ACANBufferStatistics * inStatistics) {
+  return setBufferStatistics (mDriverTransmitBuffer, inStatistics) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ESP32ACAN::resetDriverBufferStatistics (void) {
+  portENTER_CRITICAL (&mux) ;
+  mDriverReceiveBuffer.resetStatistics () ;
+  mDriverTransmitBuffer.resetStatistics () ;
+  portEXIT_CRITICAL (&mux) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   BIT RATE DETECTION: the bit timing registers are written in reset mode, then the controller listens. In listen
+//   only mode the error counters do not change: a wrong bit rate is seen on the bus error interrupt flag, enabled in
+//   CAN_IER while the CPU interrupt is masked (the interrupt handler would clear the flags).
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+uint32_t ESP32ACAN::autoDetectBitRate (const uint32_t inCandidates [],
+                                       const uint8_t inCandidateCount,
+                                       const uint32_t inTimeoutMS) {
+  if (mInterruptHandle != nullptr) {
+    esp_intr_disable (mInterruptHandle) ;
+  }
+  const uint32_t mode = CAN_MODE & ~CAN_MODE_RESET ;
+  const uint32_t interruptEnable = CAN_IER ;
+  const uint32_t btr0 = CAN_BTR0 ;
+  const uint32_t btr1 = CAN_BTR1 ;
+  ACANBitRateDetector detector (*this) ;
+  const uint32_t bitRate = detector.detect (inCandidates, inCandidateCount, inTimeoutMS) ;
+  while ((CAN_MODE & CAN_MODE_RESET) == 0) {
+    CAN_MODE = CAN_MODE_RESET ;
+  }
+  if (bitRate == 0) {
+    CAN_BTR0 = btr0 ;
+    CAN_BTR1 = btr1 ;
+  }
+  CAN_IER = interruptEnable ;
+  const uint8_t unusedVariable __attribute__((unused)) = CAN_INTERRUPT ;
+  do{
+    CAN_MODE = mode ;
+  }while ((CAN_MODE & CAN_MODE_RESET) != 0) ;
+  trace (kTraceModeChange, uint16_t (mode)) ;
+  if (mInterruptHandle != nullptr) {
+    esp_intr_enable (mInterruptHandle) ;
+  }
+  return bitRate ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+uint32_t ESP32ACAN::autoDetectBitRate (const uint32_t inTimeoutMS) {
+  return autoDetectBitRate (ACANBitRateDetector::kStandardBitRates,
+                            ACANBitRateDetector::kStandardBitRateCount,
+                            inTimeoutMS) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+bool ESP32ACAN::listenAtBitRate (const uint32_t inBitRate) {
+  const ESP32ACANSettings settings (inBitRate) ;
+  const bool ok = settings.mBitRateClosedToDesiredRate && (settings.CANBitSettingConsistency () == 0) ;
+  if (ok) {
+    const uint32_t filterMode = CAN_MODE & CAN_MODE_ACCFILTER ;
+    while ((CAN_MODE & CAN_MODE_RESET) == 0) {
+      CAN_MODE = CAN_MODE_RESET ;
+    }
+    setBitTimingSettings (settings) ;
+    CAN_IER = CAN_INTERRUPT_BUS_ERR ;
+    do{
+      CAN_MODE = filterMode | CAN_MODE_LISTENONLY ;
+    }while ((CAN_MODE & CAN_MODE_RESET) != 0) ;
+    trace (kTraceModeChange, uint16_t (filterMode | CAN_MODE_LISTENONLY)) ;
+  //--- Forget what was received at the previous candidate
+    while ((CAN_STATUS & CAN_STATUS_RXB) != 0) {
+      CAN_CMD = CAN_CMD_RELEASE_RXB ;
+    }
+    const uint8_t unusedErrorCode __attribute__((unused)) = CAN_ECC ; // Unlocks the error code capture
+    const uint8_t unusedVariable __attribute__((unused)) = CAN_INTERRUPT ;
+  }
+  return ok ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+ACANBitRateDetector::Event ESP32ACAN::bitRateEvent (void) {
+  ACANBitRateDetector::Event event = ACANBitRateDetector::NoEvent ;
+  if ((CAN_STATUS & CAN_STATUS_RXB) != 0) { // The controller checked the CRC
+    CAN_CMD = CAN_CMD_RELEASE_RXB ;
+    event = ACANBitRateDetector::ValidFrame ;
+  }else if ((CAN_INTERRUPT & CAN_INTERRUPT_BUS_ERR) != 0) { // Reading clears the flags
+    event = ACANBitRateDetector::BusError ;
+  }
+  return event ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+uint32_t ESP32ACAN::bitRateDetectionMillis (void) {
+  return millis () ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   SLCAN BRIDGE
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+bool ESP32ACAN::slcanOpen (const uint32_t inBitRate, const bool inListenOnly) {
+  ESP32ACANSettings settings (inBitRate) ;
+  settings.mRequestedCANMode = inListenOnly ? ESP32ACANSettings::ListenOnlyMode : ESP32ACANSettings::NormalMode ;
+  settings.mControlMessageByMethod = ESP32ACANSettings::InterruptControlled ;
+  settings.mDriverReceiveBufferSize = kSLCANReceiveBufferSize ;
+  return settings.mBitRateClosedToDesiredRate && (begin (settings) == 0) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ESP32ACAN::slcanClose (void) {
+  end () ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
@@ -16,16 +16,46 @@
 /*   V1.2   | Handling Standard Frames                                        */
 /*   V1.3   | Added Interrupt Handlers                                        */
 /*   V2.0   | Acceptance Filter Settings                                      */
+/*   V2.1   | Fixed format send path, TX command cached by begin              */
+/*          | Latest value mailbox receive mode                               */
+/*          | In place access to the driver receive buffer                    */
+/*          | Bus load meter                                                  */
+/*          | Blocking receive / send with timeout                            */
+/*          | Lossless polling: controller FIFO drained to the receive buffer */
+/*          | IRAM interrupt path, interrupt level and core, end              */
+/*          | Caller provided and statically sized driver buffers             */
+/*          | Driver buffer statistics                                        */
+/*          | Bit rate detection                                              */
+/*          | Runtime bit timing and filter reconfiguration                   */
+/*          | Payload change detection                                        */
+/*          | Multi-subscriber fan-out of received frames                     */
+/*          | SLCAN bridge adaptor                                            */
+/*          | Event trace                                                     */
+/*          | Interrupt handler and critical section profile                  */
 /* ---------------------------------------------------------------------------*/
 
 #pragma once
 
 /*------------------------------- Include files ------------------------------*/
+#include <esp_timer.h>
 #include "ESP32CANRegisters.h"
 #include "ESP32ACANSettings.h"
 #include "CANMessage.h"
 #include "ACANBuffer16.h"
+#include "ACANMailboxes.h"
+#include "ACANBusLoad.h"
 #include "ESP32AcceptanceFilters.h"
+#include "ESP32ACANFixedFrame.h"
+#include "ACANBitRateDetector.h"
+#include "ACANChangeFilter.h"
+#include "ACANSubscriber.h"
+#include "ACANSLCAN.h"
+#include "ACANTrace.h"
+#include "ACANProfiler.h"
+
+//------- ESP32 Critical Section, defined in ESP32ACAN.cpp
+extern portMUX_TYPE mux ;
+
 //——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
 //   ESP32 CAN class
 //——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
@@ -48,6 +78,27 @@ class ESP32ACAN {
   public: uint32_t begin (const ESP32ACANSettings & inSettings,
                           const ESP32ACANFilter inFilterSettings) ;
 
+    /* Stops the controller (reset mode), frees the interrupt and the driver buffers; begin may be called again */
+  public: void end (void) ;
+
+//······················································································································
+//    Runtime reconfiguration, after begin, without begin: the controller enters reset mode between two frames it
+//    sends, only the bit timing registers (reconfigure) or the acceptance filter registers (setFilter) are written,
+//    then it returns to its mode. Driver buffers, queued frames and the interrupt stay in place; the controller receive
+//    FIFO (cleared by reset mode) is moved to the driver receive buffer first. A frame on the bus during the downtime
+//    is not received. lastReconfigurationMicros is the last downtime, from reset mode entry to exit.
+//    reconfigure uses only the bit timing of inSettings, and returns 0 or the bit timing error codes of begin; a bus
+//    load meter should be given the new actualBitRate.
+//······················································································································
+
+  public: uint32_t reconfigure (const ESP32ACANSettings & inSettings) ;
+  public: void setFilter (const ESP32ACANFilter inFilter) ;
+
+  public: inline uint32_t lastReconfigurationMicros (void) const { return mReconfigurationMicros ; }
+
+  private: uint32_t mReconfigurationMicros ;
+  private: void reconfigureInResetMode (const ESP32ACANSettings * inSettings, const ESP32ACANFilter * inFilter) ;
+
 
 //······················································································································
 //    CAN  Configuration Private Methods
@@ -65,9 +116,17 @@ class ESP32ACAN {
 
  //--- Handling messages to send and receiving messages
   public: bool mReceivebyPoll = false;
-  public: bool receivebypoll (CANMessage &outMessage) ;
+  public: bool receivebypolling (CANMessage &outMessage) ;
   public: bool receive (CANMessage &outMessage) ;
   public: static void handleMessages (CANMessage &outFrame) ;
+
+  //--- Up to inMaxCount frames in one critical section, returns the number of frames written to outMessages
+  public: uint16_t receive (CANMessage outMessages [], const uint16_t inMaxCount) ;
+
+  //--- Waits at most inTimeoutTicks (portMAX_DELAY: forever) for a frame of the driver receive buffer. If a frame is
+  //    there, no RTOS call; otherwise the task sleeps until the receive interrupt signals a frame. In PollingControlled
+  //    mode, the controller is polled once per tick.
+  public: bool receive (CANMessage & outMessage, const TickType_t inTimeoutTicks) ;
   
 //······················································································································
 //    Receive buffer
@@ -79,13 +138,69 @@ class ESP32ACAN {
   public: inline uint16_t driverreceiveBufferCount (void) const { return mDriverReceiveBuffer.count() ;  }
   public: inline uint16_t driverreceiveBufferPeakCount (void) const { return mDriverReceiveBuffer.peakCount () ; }
 
+  //--- Oldest received frame, read in place in the driver receive buffer (no copy), then released. The frame stays
+  //    valid until releaseReceivedFrame, the receive interrupt does not write its slot.
+  public: bool peekReceivedFrame (const CANMessage * & outFrame) ;
+  public: void releaseReceivedFrame (void) ;
+
+  //--- Lost frames: driver receive buffer full (FIFOReceive, MailboxAndFIFOReceive), controller FIFO overrun (frames
+  //    not read in time from the 64 byte hardware FIFO; the controller does not tell how many)
+  private: uint32_t mDriverReceiveDropCount ;
+  private: uint32_t mControllerOverrunCount ;
+
+  public: inline uint32_t driverReceiveDropCount (void) const { return mDriverReceiveDropCount ; }
+  public: inline uint32_t controllerOverrunCount (void) const { return mControllerOverrunCount ; }
+
+//······················································································································
+//    Latest value mailboxes (ESP32ACANSettings::mReceiveMode)
+//······················································································································
+//  Reading returns the newest frame of an identifier; outSequence counts the frames received with this identifier,
+//  a gap between two reads is the number of overwritten values. Drain the updated mailboxes with:
+//     while (can.receiveUpdatedMailbox (index, frame, sequence)) { ... }
+
+  private: ACANMailboxes mMailboxes ;
+  private: ESP32ACANSettings::ReceiveMode mReceiveMode ;
+
+  public: uint16_t mailboxIndex (const uint32_t inIdentifier, const bool inExtended) const ; // ACANMailboxes::kNoMailbox if none
+  public: bool receiveMailbox (const uint16_t inIndex, CANMessage & outMessage, uint32_t & outSequence) ; // true if updated
+  public: bool receiveUpdatedMailbox (uint16_t & outIndex, CANMessage & outMessage, uint32_t & outSequence) ;
+
+  public: inline uint16_t mailboxCount (void) const { return mMailboxes.count () ; }
+  public: inline uint32_t mailboxOverwriteCount (void) const { return mMailboxes.overwriteCount () ; }
+
+  private: void storeReceivedFrame (const CANMessage & inFrame) ;
+  private: void drainReceiveRegisters (void) ;
+  private: void clearDataOverrun (void) ;
+
 
 //······················································································································
 //    Transmitting messages
 //······················································································································
-  public: bool tryToSendbypoll (const CANMessage & inMessage) ;
+  public: bool tryToSendbypolling (const CANMessage & inMessage) ;
   public: bool tryToSend (const CANMessage & inMessage) ;
-  public: static void internalSendMessage (const CANMessage & inFrame);
+  public: void internalSendMessage (const CANMessage & inFrame);
+
+  //--- Waits at most inTimeoutTicks (portMAX_DELAY: forever) for room in the driver transmit buffer. No RTOS call if
+  //    the frame is accepted at once; otherwise the task sleeps until the transmit interrupt frees a slot.
+  public: bool send (const CANMessage & inMessage, const TickType_t inTimeoutTicks) ;
+
+//······················································································································
+//    Transmitting fixed format data frames (format and length known at compile time)
+//······················································································································
+//  Frame information, identifier layout and data register writes are resolved at compile time:
+//     can.tryToSendFixed <true, 8> (0x18FEF100, data) ;   // Extended frame, 8 data bytes
+//     can.tryToSendFixed <false, 2, 0x123> (data) ;       // Standard frame 0x123, 2 data bytes
+//  If the driver is already sending, the frame is appended to the driver transmit buffer as a CANMessage.
+
+  public: template <bool EXT, uint8_t DLC>
+          bool tryToSendFixed (const uint32_t inIdentifier, const uint8_t * inData) ;
+
+  public: template <bool EXT, uint8_t DLC, uint32_t IDENTIFIER>
+          inline bool tryToSendFixed (const uint8_t * inData) {
+    static_assert ((IDENTIFIER & ~ESP32ACANFixedFrame <EXT, DLC>::kIdentifierMask) == 0,
+                   "Identifier does not fit in the frame format") ;
+    return tryToSendFixed <EXT, DLC> (IDENTIFIER, inData) ;
+  }
 
 //······················································································································
 //    Transmit buffer
@@ -93,6 +208,7 @@ class ESP32ACAN {
 
   private: ACANBuffer16 mDriverTransmitBuffer ;
   private: bool mDriverSending;
+  private: uint32_t mTXCommand ; // CAN_CMD_TX_REQ, or CAN_CMD_SELF_RX_REQ in LoopBackMode; set by begin
   public: bool mSendbyPoll = false;
 
   public: inline uint16_t driverTransmitBufferSize (void) const { return mDriverTransmitBuffer.size () ; }
@@ -100,6 +216,163 @@ class ESP32ACAN {
   public: inline uint16_t driverTransmitBufferPeakCount (void) const { return mDriverTransmitBuffer.peakCount () ; }
 
 
+//······················································································································
+//    Bus load meter: every received frame, and every frame written to the TX registers (not in LoopBackMode, the
+//    frame is received back), is recorded from the receive / transmit paths. Initialize the meter with
+//    settings.actualBitRate (). The meter is read in critical section through busLoadPermille, or by
+//    the application between portENTER_CRITICAL (&mux) and portEXIT_CRITICAL (&mux).
+//······················································································································
+
+  private: ACANBusLoad * mBusLoad ;
+
+  public: void setBusLoadMeter (ACANBusLoad * inMeter) ; // nullptr: no recording
+  public: uint16_t busLoadPermille (const ACANBusLoad::Window inWindow) ;
+
+  private: inline IRAM_ATTR void recordFrame (const CANMessage & inFrame) {
+    if (mBusLoad != nullptr) {
+      mBusLoad->recordFrame (inFrame, uint32_t (esp_timer_get_time ())) ; // micros () is not in IRAM
+    }
+  }
+
+//······················································································································
+//    Payload change detection: every received frame (after the bus load meter, before the driver receive buffer
+//    and the mailboxes) goes through the change filter, frames without new payload are not stored (see
+//    ACANChangeFilter: Suppress or CountOnly mode, forced delivery every N frames or T ms). Initialize the filter
+//    with begin before. Read its counters like the bus load meter, between portENTER_CRITICAL (&mux) and
+//    portEXIT_CRITICAL (&mux).
+//······················································································································
+
+  private: ACANChangeFilter * mChangeFilter ;
+
+  public: void setChangeFilter (ACANChangeFilter * inFilter) ; // nullptr: every frame is stored
+
+//······················································································································
+//    Subscribers: every received frame (after the change filter) is pushed to the ring of every matching subscriber
+//    (see ACANSubscriber: identifier filters, one ring per subscriber, dropped frames counted per subscriber). Frames
+//    matching no subscriber go to the driver receive buffer or the mailboxes, as without subscriber. Set up the
+//    subscriber (begin, addFilter) before subscribe. A subscriber is read by one task, outside any critical section:
+//    a slow subscriber only fills its own ring.
+//······················································································································
+
+  private: ACANFanOut mFanOut ;
+  private: uint32_t mSubscriberPushes ; // Bit i: a frame was pushed to subscriber i
+  private: uint8_t mSubscriberGivesInFlight ; // Tasks giving wake semaphores taken in critical section
+
+  public: bool subscribe (ACANSubscriber & ioSubscriber) ;   // false: no ring, already subscribed, or too many
+  public: bool unsubscribe (ACANSubscriber & ioSubscriber) ; // false: not subscribed
+
+  //--- Oldest frame of the subscriber ring (in PollingControlled mode, the controller is polled before)
+  public: bool receive (ACANSubscriber & ioSubscriber, CANMessage & outMessage) ;
+
+  //--- As receive with timeout: the waiting task blocks on a binary semaphore of the subscriber (created by subscribe,
+  //    deleted by unsubscribe), given by the receive interrupt. Not a task notification, so the task notification
+  //    value of the calling task stays free for the application.
+  public: bool receive (ACANSubscriber & ioSubscriber, CANMessage & outMessage, const TickType_t inTimeoutTicks) ;
+
+  //--- Semaphores of the waiting subscribers that got a frame, their waiting state cleared (called in critical section)
+  private: uint8_t takeSubscriberWakes (SemaphoreHandle_t outSemaphores [ACANFanOut::kMaxSubscriberCount]) ;
+
+//······················································································································
+//    Driver buffer statistics (occupancy, residence time percentiles, overflow episodes), recorded by the driver
+//    buffers from the receive / transmit paths; they follow the buffer sizes set by begin. Read them like the bus
+//    load meter, between portENTER_CRITICAL (&mux) and portEXIT_CRITICAL (&mux) for a consistent snapshot.
+//······················································································································
+
+  public: bool setDriverReceiveBufferStatistics (ACANBufferStatistics * inStatistics) ; // nullptr: no recording
+  public: bool setDriverTransmitBufferStatistics (ACANBufferStatistics * inStatistics) ; // false: cannot allocate
+  public: void resetDriverBufferStatistics (void) ;
+
+  private: bool setBufferStatistics (ACANBuffer16 & ioBuffer, ACANBufferStatistics * inStatistics) ;
+
+//······················································································································
+//    Bit rate detection (ACANBitRateDetector): call after begin, while no frame is being sent. The controller listens
+//    at each candidate bit rate (ListenOnlyMode: the bus is not disturbed), only the bit timing registers are
+//    written. On the first valid frame, the controller keeps this bit timing and returns to the mode set by begin.
+//    Returns the detected bit rate, 0 if none within inTimeoutMS (the bit timing of begin is restored). Frames
+//    received meanwhile are discarded; the CAN interrupt is masked, a wrong bit rate is seen on the bus error flag.
+//······················································································································
+
+  public: uint32_t autoDetectBitRate (const uint32_t inCandidates [],
+                                      const uint8_t inCandidateCount,
+                                      const uint32_t inTimeoutMS) ;
+
+  //--- Candidates: ACANBitRateDetector::kStandardBitRates
+  public: uint32_t autoDetectBitRate (const uint32_t inTimeoutMS) ;
+
+  //--- Controller adaptor of ACANBitRateDetector
+  friend class ACANBitRateDetector ;
+  private: bool listenAtBitRate (const uint32_t inBitRate) ;
+  private: ACANBitRateDetector::Event bitRateEvent (void) ;
+  private: uint32_t bitRateDetectionMillis (void) ;
+
+//······················································································································
+//    SLCAN bridge (ACANSLCAN): the host opens and closes the controller. Open is begin at the bit rate set by the
+//    host, NormalMode or ListenOnlyMode, InterruptControlled, accept all filter, and a driver receive buffer of
+//    kSLCANReceiveBufferSize frames (it absorbs the serial link stalls); close is end. Receive drops: F status bit 0.
+//······················································································································
+
+  public: static const uint16_t kSLCANReceiveBufferSize = 512 ;
+
+  friend class ACANSLCAN ;
+  private: bool slcanOpen (const uint32_t inBitRate, const bool inListenOnly) ;
+  private: void slcanClose (void) ;
+  private: inline uint32_t slcanReceiveDropCount (void) const { return mDriverReceiveDropCount ; }
+
+//······················································································································
+//    Event trace (ACANTrace), compiled only with ACAN_TRACE set to 1: interrupt entry (interrupt flags) and exit,
+//    frames read from the controller FIFO, frames written to the TX registers, transmit interrupts, transmit buffer
+//    appends and refusals, receive buffer drops, data overruns, mode changes. A trace point is one test when no
+//    trace is attached, nothing when ACAN_TRACE is 0. Detach the trace (nullptr) before reading or dumping it.
+//······················································································································
+
+  private: ACANTrace * mTrace ;
+
+  public: bool setTrace (ACANTrace * inTrace) ; // nullptr: no recording; false: ACAN_TRACE is 0
+
+  private: inline IRAM_ATTR void trace (const ACANTraceEvent inEvent, const uint16_t inPayload) {
+    #if ACAN_TRACE
+      if (mTrace != nullptr) {
+        mTrace->record (inEvent, inPayload) ;
+      }
+    #else
+      (void) inEvent ;
+      (void) inPayload ;
+    #endif
+  }
+
+//······················································································································
+//    Profile (ACANProfiler), compiled only with ACAN_PROFILE set to 1: cycle counts of the interrupt handler, of its
+//    spinlock hold time and of handleRXInterrupt / handleTXInterrupt, spinlock hold times of receive and tryToSend.
+//    Recorded in critical section; profileStatistics copies a section in critical section.
+//······················································································································
+
+  private: ACANProfiler * mProfiler ;
+  private: uint32_t mInterruptHandlerCycles ; // Of the last interrupt, recorded by the next one; 0: none
+
+  public: bool setProfiler (ACANProfiler * inProfiler) ; // nullptr: no recording; false: ACAN_PROFILE is 0
+  public: bool profileStatistics (const ACANProfiler::Section inSection,
+                                  ACANProfileStatistics & outStatistics) ; // false: no profiler attached
+  public: void resetProfile (void) ;
+
+  private: static inline IRAM_ATTR uint32_t profileDate (void) {
+    #if ACAN_PROFILE
+      return ACANProfiler::date () ;
+    #else
+      return 0 ;
+    #endif
+  }
+
+  private: inline IRAM_ATTR void profile (const ACANProfiler::Section inSection, const uint32_t inStartDate) {
+    #if ACAN_PROFILE
+      if (mProfiler != nullptr) {
+        mProfiler->record (inSection, inStartDate) ;
+      }
+    #else
+      (void) inSection ;
+      (void) inStartDate ;
+    #endif
+  }
+
 //······················································································································
 //    Error codes returned by begin
 //······················································································································
@@ -109,6 +382,11 @@ class ESP32ACAN {
   public: static const uint32_t kInconsistentBitRateSettings              = 1 <<  3 ;
   public: static const uint32_t kCannotAllocateDriverReceiveBuffer        = 1 <<  4 ;
   public: static const uint32_t kCannotAllocateDriverTransmitBuffer       = 1 <<  5 ;
+  public: static const uint32_t kCannotAllocateMailboxes                  = 1 <<  6 ;
+  public: static const uint32_t kNoMailboxIdentifier                      = 1 <<  7 ;
+  public: static const uint32_t kInvalidInterruptLevel                    = 1 <<  8 ;
+  public: static const uint32_t kCannotAllocateInterrupt                  = 1 <<  9 ;
+  public: static const uint32_t kExternalRAMBufferWithIRAMInterrupt       = 1 << 10 ;
 
 //······················································································································
 //    Interrupt Handler
@@ -116,14 +394,24 @@ class ESP32ACAN {
 
   public: static void isr (void *arg) ;
 
+  //--- Handle kept for end; the interrupt is allocated and freed on mInterruptCore (through esp_ipc if needed)
+  private: intr_handle_t mInterruptHandle ;
+  private: BaseType_t mInterruptCoreID ; // As xPortGetCoreID
+
+  private: bool allocateInterrupt (const ESP32ACANSettings & inSettings) ;
+  private: void releaseInterrupt (void) ;
+
   public: void handleTXInterrupt(void) ;
   public: void handleRXInterrupt(void) ;
 
 //······················································································································
-//    Properties
+//    Blocking receive / send: the interrupt gives a semaphore only if a task waits (flags set in critical section)
 //······················································································································
- 
-  public: SemaphoreHandle_t mISRSemaphore ;
+
+  private: SemaphoreHandle_t mReceiveSemaphore ;
+  private: SemaphoreHandle_t mTransmitSemaphore ;
+  private: bool mReceiveWaiting ;
+  private: bool mTransmitWaiting ;
 
 //······················································································································
 //    No Copy
@@ -133,3 +421,73 @@ class ESP32ACAN {
   private: ESP32ACAN & operator = (const ESP32ACAN &) = delete ;
 
 };
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   Fixed format transmission
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+template <bool EXT, uint8_t DLC>
+bool ESP32ACAN::tryToSendFixed (const uint32_t inIdentifier, const uint8_t * inData) {
+  portENTER_CRITICAL (&mux) ;
+  const uint32_t lockDate = profileDate () ;
+  bool sendMessage = mSendbyPoll ? ((CAN_STATUS & CAN_STATUS_TXB) != 0) : !mDriverSending ;
+  const bool sentNow = sendMessage ;
+  if (sentNow) {
+    ESP32ACANFixedFrame <EXT, DLC>::writeRegisters (inIdentifier, inData) ;
+    CAN_CMD = mTXCommand ;
+    mDriverSending = !mSendbyPoll ;
+    trace (kTraceTXLoad, uint16_t (inIdentifier)) ;
+  }
+  if ((!sentNow && !mSendbyPoll) || (sentNow && (mBusLoad != nullptr) && (mTXCommand == CAN_CMD_TX_REQ))) {
+    CANMessage frame ;
+    frame.id = inIdentifier ;
+    frame.ext = EXT ;
+    frame.len = DLC ;
+    for (uint8_t i=0 ; i<DLC ; i++) {
+      frame.data [i] = inData [i] ;
+    }
+    if (sentNow) {
+      recordFrame (frame) ;
+    }else{
+      sendMessage = mDriverTransmitBuffer.append (frame) ;
+      trace (sendMessage ? kTraceTXQueued : kTraceTXBufferFull, mDriverTransmitBuffer.count ()) ;
+    }
+  }
+  profile (ACANProfiler::SendCriticalSection, lockDate) ;
+  portEXIT_CRITICAL (&mux) ;
+  return sendMessage ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   Driver with statically sized buffers: no heap allocation by begin, RAM usage known at link time
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+template <uint16_t RECEIVE_SIZE, uint16_t TRANSMIT_SIZE>
+class ESP32ACANWithBuffers : public ESP32ACAN {
+
+  static_assert (RECEIVE_SIZE > 0, "RECEIVE_SIZE should be > 0") ;
+  static_assert (TRANSMIT_SIZE > 0, "TRANSMIT_SIZE should be > 0") ;
+
+//······················································································································
+//    begin: the buffer sizes and storage of inSettings are overridden
+//······················································································································
+
+  public: uint32_t begin (const ESP32ACANSettings & inSettings,
+                          const ESP32ACANFilter inFilterSettings = ESP32ACANFilter ()) {
+    ESP32ACANSettings settings = inSettings ;
+    settings.mDriverReceiveBufferSize = RECEIVE_SIZE ;
+    settings.mDriverReceiveBufferStorage = mReceiveStorage ;
+    settings.mDriverTransmitBufferSize = TRANSMIT_SIZE ;
+    settings.mDriverTransmitBufferStorage = mTransmitStorage ;
+    return ESP32ACAN::begin (settings, inFilterSettings) ;
+  }
+
+//······················································································································
+//    Storage
+//······················································································································
+
+  private: CANMessage mReceiveStorage [RECEIVE_SIZE] ;
+  private: CANMessage mTransmitStorage [TRANSMIT_SIZE] ;
+} ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
@@ -0,0 +1,81 @@
+/******************************************************************************/
+/* File name        : ESP32ACANFixedFrame.h                                   */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Description      : Compile-time frame layout for fixed-format messages     */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation                                                        */
+/* ---------------------------------------------------------------------------*/
+
+#pragma once
+
+/*------------------------------- Include files ------------------------------*/
+#include "ESP32CANRegisters.h"
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   Unrolled data register writes
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+// The data registers of a standard frame start at 0x04C, the ones of an extended frame at 0x054. COUNT is the DLC,
+// the recursion is resolved by the compiler: one store per data byte, no loop counter, no bound check.
+
+template <uint32_t FIRST_DATA_REGISTER, uint8_t COUNT> class ESP32ACANDataWriter {
+  public: static inline void write (const uint8_t * inData) {
+    ESP32ACANDataWriter <FIRST_DATA_REGISTER, COUNT - 1>::write (inData) ;
+    *((vuint32_t *) (ESP32CAN_BASE + FIRST_DATA_REGISTER + 4 * (COUNT - 1))) = inData [COUNT - 1] ;
+  }
+} ;
+
+//······················································································································
+
+template <uint32_t FIRST_DATA_REGISTER> class ESP32ACANDataWriter <FIRST_DATA_REGISTER, 0> {
+  public: static inline void write (const uint8_t *) {}
+} ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   Fixed frame format: standard (EXT = false) or extended (EXT = true) data frame of DLC bytes
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+template <bool EXT, uint8_t DLC> class ESP32ACANFixedFrame ;
+
+//······················································································································
+
+template <uint8_t DLC> class ESP32ACANFixedFrame <false, DLC> {
+  static_assert (DLC <= 8, "DLC of a fixed frame should be 0 ... 8") ;
+
+  public: static const uint32_t kFrameInfo = CAN_FRAME_FORMAT_SFF | CAN_DLC (DLC) ;
+  public: static const uint32_t kIdentifierMask = CAN_MSG_STD_ID ;
+
+  public: static inline void writeRegisters (const uint32_t inIdentifier, const uint8_t * inData) {
+    CAN_FRAME_INFO = kFrameInfo ;
+    CAN_ID_SFF(0) = (uint8_t) (inIdentifier >> 3) ;
+    CAN_ID_SFF(1) = (uint8_t) (inIdentifier << 5) ;
+    ESP32ACANDataWriter <0x04C, DLC>::write (inData) ;
+  }
+} ;
+
+//······················································································································
+
+template <uint8_t DLC> class ESP32ACANFixedFrame <true, DLC> {
+  static_assert (DLC <= 8, "DLC of a fixed frame should be 0 ... 8") ;
+
+  public: static const uint32_t kFrameInfo = CAN_FRAME_FORMAT_EFF | CAN_DLC (DLC) ;
+  public: static const uint32_t kIdentifierMask = CAN_MSG_EXT_ID ;
+
+  public: static inline void writeRegisters (const uint32_t inIdentifier, const uint8_t * inData) {
+    CAN_FRAME_INFO = kFrameInfo ;
+    CAN_ID_EFF(0) = (uint8_t) (inIdentifier >> 21) ;
+    CAN_ID_EFF(1) = (uint8_t) (inIdentifier >> 13) ;
+    CAN_ID_EFF(2) = (uint8_t) (inIdentifier >> 5) ;
+    CAN_ID_EFF(3) = (uint8_t) (inIdentifier << 3) ;
+    ESP32ACANDataWriter <0x054, DLC>::write (inData) ;
+  }
+} ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
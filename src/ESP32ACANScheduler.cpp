@@ -0,0 +1,420 @@
+/******************************************************************************/
+/* File name        : ESP32ACANScheduler.cpp                                  */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Description      : Cyclic transmission scheduler                           */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation                                                        */
+/* ---------------------------------------------------------------------------*/
+
+/*------------------------------- Include files ------------------------------*/
+#include "ESP32ACANScheduler.h"
+
+/*------------------------------- Local defines ------------------------------*/
+#define MAX_OFFSET_CANDIDATES    (256)
+
+//------- Scheduler Critical Section (payload updates from application tasks, ticks from the timer task)
+#ifdef ARDUINO
+  static portMUX_TYPE schedulerMux = portMUX_INITIALIZER_UNLOCKED;
+#else
+  #include <mutex>
+  static std::mutex schedulerMux ; // Desktop build: the tick and the application may run in different threads
+  #define portENTER_CRITICAL(inMutex) (inMutex)->lock ()
+  #define portEXIT_CRITICAL(inMutex) (inMutex)->unlock ()
+#endif
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static uint32_t greatestCommonDivisor (uint32_t inA, uint32_t inB) {
+  while (inB != 0) {
+    const uint32_t r = inA % inB ;
+    inA = inB ;
+    inB = r ;
+  }
+  return inA ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   CONSTRUCTOR, DESTRUCTOR
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+#ifdef ARDUINO
+
+ESP32ACANScheduler::ESP32ACANScheduler (ESP32ACAN & inDriver) :
+  ESP32ACANScheduler (&inDriver, sendThroughDriver)
+  {}
+
+#endif
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+ESP32ACANScheduler::ESP32ACANScheduler (void * inDriver, ESP32ACANSchedulerSendRoutine inSendRoutine) :
+  mDriver (inDriver),
+  mSendRoutine (inSendRoutine),
+  mEntries (NULL),
+  mHeap (NULL),
+  mCapacity (0),
+  mHeapCount (0),
+  mStarted (false),
+  mStartDate (0),
+  mLastTick (0),
+  mMissedDeadlineCount (0)
+#ifdef ARDUINO
+  , mTimer (NULL)
+#endif
+  {}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+ESP32ACANScheduler::~ ESP32ACANScheduler (void) {
+  #ifdef ARDUINO
+    stopTickTimer () ;
+  #endif
+  delete [] mEntries ;
+  delete [] mHeap ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   Initialisation
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+bool ESP32ACANScheduler::initWithCapacity (const uint16_t inCapacity) {
+  delete [] mEntries ;
+  delete [] mHeap ;
+  mEntries = new Entry [inCapacity] ;
+  mHeap = new uint16_t [inCapacity] ;
+  const bool ok = (mEntries != NULL) && (mHeap != NULL) ;
+  mCapacity = ok ? inCapacity : 0 ;
+  for (uint16_t i=0 ; i<mCapacity ; i++) {
+    mEntries [i].mHeapIndex = kInvalidHandle ;
+    mEntries [i].mGeneration = 0 ;
+  }
+  mHeapCount = 0 ;
+  mStarted = false ;
+  mMissedDeadlineCount = 0 ;
+  return ok ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   Heap handling (mHeap [0] holds the entry with the earliest release date)
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+bool ESP32ACANScheduler::isBefore (const uint16_t inEntryA, const uint16_t inEntryB) const {
+  //--- Signed difference: correct across millis () wrap around
+  return (int32_t) (mEntries [inEntryA].mNextRelease - mEntries [inEntryB].mNextRelease) < 0 ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ESP32ACANScheduler::swapHeapItems (const uint16_t inIndexA, const uint16_t inIndexB) {
+  const uint16_t entryA = mHeap [inIndexA] ;
+  mHeap [inIndexA] = mHeap [inIndexB] ;
+  mHeap [inIndexB] = entryA ;
+  mEntries [mHeap [inIndexA]].mHeapIndex = inIndexA ;
+  mEntries [mHeap [inIndexB]].mHeapIndex = inIndexB ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ESP32ACANScheduler::siftUp (uint16_t inIndex) {
+  while (inIndex > 0) {
+    const uint16_t parent = (inIndex - 1) / 2 ;
+    if (!isBefore (mHeap [inIndex], mHeap [parent])) {
+      break ;
+    }
+    swapHeapItems (inIndex, parent) ;
+    inIndex = parent ;
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ESP32ACANScheduler::siftDown (uint16_t inIndex) {
+  while (true) {
+    const uint32_t left = 2 * (uint32_t) inIndex + 1 ;
+    const uint32_t right = left + 1 ;
+    uint16_t smallest = inIndex ;
+    if ((left < mHeapCount) && isBefore (mHeap [left], mHeap [smallest])) {
+      smallest = (uint16_t) left ;
+    }
+    if ((right < mHeapCount) && isBefore (mHeap [right], mHeap [smallest])) {
+      smallest = (uint16_t) right ;
+    }
+    if (smallest == inIndex) {
+      break ;
+    }
+    swapHeapItems (inIndex, smallest) ;
+    inIndex = smallest ;
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ESP32ACANScheduler::removeHeapItem (const uint16_t inIndex) {
+  mEntries [mHeap [inIndex]].mHeapIndex = kInvalidHandle ;
+  mHeapCount -= 1 ;
+  if (inIndex < mHeapCount) {
+    mHeap [inIndex] = mHeap [mHeapCount] ;
+    mEntries [mHeap [inIndex]].mHeapIndex = inIndex ;
+    siftDown (inIndex) ;
+    siftUp (inIndex) ;
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   Periodic messages
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+uint16_t ESP32ACANScheduler::insertEntry (const CANMessage & inMessage,
+                                          const uint32_t inPeriod,
+                                          const uint32_t inOffset) {
+  uint16_t handle = kInvalidHandle ;
+  for (uint16_t i=0 ; (i<mCapacity) && (handle == kInvalidHandle) ; i++) {
+    if (mEntries [i].mHeapIndex == kInvalidHandle) {
+      handle = i ;
+    }
+  }
+  if (handle != kInvalidHandle) {
+    Entry & entry = mEntries [handle] ;
+    entry.mMessage = inMessage ;
+    entry.mPeriod = inPeriod ;
+    entry.mOffset = inOffset % inPeriod ;
+    entry.mStatistics = ESP32ACANPeriodicStatistics () ;
+    entry.mGeneration += 1 ;
+    if (mStarted) { //--- Next date of the grid mStartDate + offset + k * period
+      const uint32_t phase = (mLastTick - mStartDate) % inPeriod ;
+      entry.mNextRelease = mLastTick + ((entry.mOffset + inPeriod - phase) % inPeriod) ;
+    }else{ //--- Relative to the first tick
+      entry.mNextRelease = entry.mOffset ;
+    }
+    entry.mHeapIndex = mHeapCount ;
+    mHeap [mHeapCount] = handle ;
+    mHeapCount += 1 ;
+    siftUp (entry.mHeapIndex) ;
+  }
+  return handle ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+uint16_t ESP32ACANScheduler::addPeriodicMessage (const CANMessage & inMessage,
+                                                 const uint32_t inPeriod,
+                                                 const uint32_t inOffset) {
+  uint16_t handle = kInvalidHandle ;
+  if (inPeriod > 0) {
+    portENTER_CRITICAL (&schedulerMux) ;
+    handle = insertEntry (inMessage, inPeriod, inOffset) ;
+    portEXIT_CRITICAL (&schedulerMux) ;
+  }
+  return handle ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+// Two messages of periods P1, P2 and offsets O1, O2 are released on the same date at least once iff
+// O1 ≡ O2 (mod gcd (P1, P2)). The chosen offset is the one colliding with the fewest registered messages.
+// ioGrids is a private copy: each period is replaced by its gcd with inPeriod, so the candidate loop has no division
+// by a gcd computed again.
+
+uint32_t ESP32ACANScheduler::leastLoadedOffset (const uint32_t inPeriod, Grid * ioGrids, const uint16_t inGridCount) {
+  for (uint16_t i=0 ; i<inGridCount ; i++) {
+    ioGrids [i].mPeriod = greatestCommonDivisor (inPeriod, ioGrids [i].mPeriod) ;
+    ioGrids [i].mOffset %= ioGrids [i].mPeriod ;
+  }
+  const uint32_t step = (inPeriod + MAX_OFFSET_CANDIDATES - 1) / MAX_OFFSET_CANDIDATES ;
+  uint32_t bestOffset = 0 ;
+  uint32_t fewestCollisions = UINT32_MAX ;
+  for (uint32_t offset = 0 ; (offset < inPeriod) && (fewestCollisions > 0) ; offset += step) {
+    uint32_t collisions = 0 ;
+    for (uint16_t i=0 ; i<inGridCount ; i++) {
+      if ((offset % ioGrids [i].mPeriod) == ioGrids [i].mOffset) {
+        collisions += 1 ;
+      }
+    }
+    if (collisions < fewestCollisions) {
+      fewestCollisions = collisions ;
+      bestOffset = offset ;
+    }
+  }
+  return bestOffset ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+// The registered grids are copied in critical section (O (capacity)), the offset is chosen outside of it (up to
+// MAX_OFFSET_CANDIDATES x capacity iterations), and the lock is taken again only to insert. A message added by another
+// task in between is not taken into account: the offset is a spreading heuristic, not a guarantee.
+
+uint16_t ESP32ACANScheduler::addPeriodicMessage (const CANMessage & inMessage,
+                                                 const uint32_t inPeriod) {
+  uint16_t handle = kInvalidHandle ;
+  Grid * grids = (inPeriod > 0) ? new Grid [mCapacity] : NULL ;
+  if (grids != NULL) {
+    uint16_t gridCount = 0 ;
+    portENTER_CRITICAL (&schedulerMux) ;
+    for (uint16_t i=0 ; i<mCapacity ; i++) {
+      const Entry & entry = mEntries [i] ;
+      if (entry.mHeapIndex != kInvalidHandle) {
+        grids [gridCount].mPeriod = entry.mPeriod ;
+        grids [gridCount].mOffset = entry.mOffset ;
+        gridCount += 1 ;
+      }
+    }
+    portEXIT_CRITICAL (&schedulerMux) ;
+    const uint32_t offset = leastLoadedOffset (inPeriod, grids, gridCount) ;
+    delete [] grids ;
+    portENTER_CRITICAL (&schedulerMux) ;
+    handle = insertEntry (inMessage, inPeriod, offset) ;
+    portEXIT_CRITICAL (&schedulerMux) ;
+  }
+  return handle ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+bool ESP32ACANScheduler::updateMessage (const uint16_t inHandle, const CANMessage & inMessage) {
+  portENTER_CRITICAL (&schedulerMux) ;
+  const bool ok = (inHandle < mCapacity) && (mEntries [inHandle].mHeapIndex != kInvalidHandle) ;
+  if (ok) {
+    mEntries [inHandle].mMessage = inMessage ;
+  }
+  portEXIT_CRITICAL (&schedulerMux) ;
+  return ok ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+bool ESP32ACANScheduler::removePeriodicMessage (const uint16_t inHandle) {
+  portENTER_CRITICAL (&schedulerMux) ;
+  const bool ok = (inHandle < mCapacity) && (mEntries [inHandle].mHeapIndex != kInvalidHandle) ;
+  if (ok) {
+    removeHeapItem (mEntries [inHandle].mHeapIndex) ;
+  }
+  portEXIT_CRITICAL (&schedulerMux) ;
+  return ok ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   Tick
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+// A release that is late by one period or more counts as missed deadlines and is not caught up: the frame is sent
+// once, on the current grid date. Frames are handed to the driver outside the scheduler critical section: meanwhile the
+// message may be removed, and its slot given to a new message, so the entry is looked up again by handle and
+// generation before its statistics are updated.
+
+void ESP32ACANScheduler::tick (const uint32_t inNowMillis) {
+  portENTER_CRITICAL (&schedulerMux) ;
+  if (!mStarted) {
+    mStarted = true ;
+    mStartDate = inNowMillis ;
+    for (uint16_t i=0 ; i<mHeapCount ; i++) {
+      mEntries [mHeap [i]].mNextRelease += inNowMillis ;
+    }
+  }
+  mLastTick = inNowMillis ;
+  bool due = (mHeapCount > 0) && ((int32_t) (inNowMillis - mEntries [mHeap [0]].mNextRelease) >= 0) ;
+  while (due) {
+    const uint16_t handle = mHeap [0] ;
+    Entry & entry = mEntries [handle] ;
+    uint32_t lateness = inNowMillis - entry.mNextRelease ;
+    if (lateness >= entry.mPeriod) {
+      const uint32_t missedPeriods = lateness / entry.mPeriod ;
+      entry.mStatistics.mMissedDeadlineCount += missedPeriods ;
+      mMissedDeadlineCount += missedPeriods ;
+      entry.mNextRelease += missedPeriods * entry.mPeriod ;
+      lateness -= missedPeriods * entry.mPeriod ;
+    }
+    entry.mNextRelease += entry.mPeriod ;
+    entry.mStatistics.mJitterSum += lateness ;
+    if (entry.mStatistics.mMaxJitter < lateness) {
+      entry.mStatistics.mMaxJitter = lateness ;
+    }
+    const CANMessage frame = entry.mMessage ;
+    const uint32_t generation = entry.mGeneration ;
+    siftDown (0) ;
+    portEXIT_CRITICAL (&schedulerMux) ;
+    const bool sent = mSendRoutine (mDriver, frame) ;
+    portENTER_CRITICAL (&schedulerMux) ;
+    Entry & sentEntry = mEntries [handle] ;
+    if ((sentEntry.mHeapIndex != kInvalidHandle) && (sentEntry.mGeneration == generation)) {
+      if (sent) {
+        sentEntry.mStatistics.mReleaseCount += 1 ;
+      }else{
+        sentEntry.mStatistics.mMissedDeadlineCount += 1 ;
+        mMissedDeadlineCount += 1 ;
+      }
+    }
+    due = (mHeapCount > 0) && ((int32_t) (inNowMillis - mEntries [mHeap [0]].mNextRelease) >= 0) ;
+  }
+  portEXIT_CRITICAL (&schedulerMux) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   ESP32ACAN driver, FreeRTOS software timer tick source
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+#ifdef ARDUINO
+
+bool ESP32ACANScheduler::sendThroughDriver (void * inDriver, const CANMessage & inMessage) {
+  return ((ESP32ACAN *) inDriver)->tryToSend (inMessage) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ESP32ACANScheduler::timerCallback (TimerHandle_t inTimer) {
+  ESP32ACANScheduler * scheduler = (ESP32ACANScheduler *) pvTimerGetTimerID (inTimer) ;
+  scheduler->tick ((uint32_t) (xTaskGetTickCount () * portTICK_PERIOD_MS)) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+bool ESP32ACANScheduler::startTickTimer (const uint32_t inTickPeriodMillis) {
+  stopTickTimer () ;
+  const TickType_t period = (inTickPeriodMillis / portTICK_PERIOD_MS) > 0 ? (inTickPeriodMillis / portTICK_PERIOD_MS) : 1 ;
+  mTimer = xTimerCreate ("ESP32ACANScheduler", period, pdTRUE, this, timerCallback) ;
+  return (mTimer != NULL) && (xTimerStart (mTimer, 0) == pdPASS) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ESP32ACANScheduler::stopTickTimer (void) {
+  if (mTimer != NULL) {
+    xTimerStop (mTimer, portMAX_DELAY) ;
+    xTimerDelete (mTimer, portMAX_DELAY) ;
+    mTimer = NULL ;
+  }
+}
+
+#endif
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   Statistics
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+bool ESP32ACANScheduler::statistics (const uint16_t inHandle, ESP32ACANPeriodicStatistics & outStatistics) const {
+  portENTER_CRITICAL (&schedulerMux) ;
+  const bool ok = (inHandle < mCapacity) && (mEntries [inHandle].mHeapIndex != kInvalidHandle) ;
+  if (ok) {
+    outStatistics = mEntries [inHandle].mStatistics ;
+  }
+  portEXIT_CRITICAL (&schedulerMux) ;
+  return ok ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+void ESP32ACANScheduler::resetStatistics (void) {
+  portENTER_CRITICAL (&schedulerMux) ;
+  for (uint16_t i=0 ; i<mCapacity ; i++) {
+    mEntries [i].mStatistics = ESP32ACANPeriodicStatistics () ;
+  }
+  mMissedDeadlineCount = 0 ;
+  portEXIT_CRITICAL (&schedulerMux) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
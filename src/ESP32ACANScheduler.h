@@ -0,0 +1,170 @@
+/******************************************************************************/
+/* File name        : ESP32ACANScheduler.h                                    */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Description      : Cyclic transmission scheduler                           */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation                                                        */
+/* ---------------------------------------------------------------------------*/
+
+#pragma once
+
+/*------------------------------- Include files ------------------------------*/
+#ifdef ARDUINO
+  #include "ESP32ACAN.h"
+  #include "freertos/timers.h"
+#else
+  #include "CANMessage.h" // Desktop build (see test-ESP32ACANScheduler-on-desktop): no tick timer
+#endif
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   Statistics of a periodic message
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+class ESP32ACANPeriodicStatistics {
+  public: uint32_t mReleaseCount = 0 ;          // Frames handed to the driver
+  public: uint32_t mMissedDeadlineCount = 0 ;   // Periods skipped, or frames refused by the driver transmit buffer
+  public: uint32_t mMaxJitter = 0 ;             // Largest release lateness (ms)
+  public: uint32_t mJitterSum = 0 ;             // Sum of release lateness (ms), mean = mJitterSum / mReleaseCount
+} ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   Send routine: hands a released frame to a driver, returns false if the driver refused it
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+typedef bool (*ESP32ACANSchedulerSendRoutine) (void * inDriver, const CANMessage & inMessage) ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   ESP32 CAN cyclic transmission scheduler
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+// Periodic messages are kept in a binary min-heap ordered by next release date, so a tick only looks at the heap
+// top: O(1) when nothing is due, O(log n) per released frame. Released frames go through ESP32ACAN::tryToSend, that is
+// into the TX registers or into the driver transmit buffer; or through a send routine for another driver.
+// A single tick source drives all messages: either call tick (millis ()) from loop, or call startTickTimer to have a
+// FreeRTOS software timer call it.
+
+class ESP32ACANScheduler {
+
+//······················································································································
+//   CONSTRUCTOR
+//······················································································································
+
+#ifdef ARDUINO
+  public: ESP32ACANScheduler (ESP32ACAN & inDriver) ;
+#endif
+
+  public: ESP32ACANScheduler (void * inDriver, ESP32ACANSchedulerSendRoutine inSendRoutine) ;
+
+  public: ~ ESP32ACANScheduler (void) ;
+
+//······················································································································
+//   Initialisation: allocates room for inCapacity periodic messages, returns false on allocation failure
+//······················································································································
+
+  public: bool initWithCapacity (const uint16_t inCapacity) ;
+
+//······················································································································
+//   Periodic messages: a handle is returned, or kInvalidHandle if the scheduler is full or the period is zero
+//······················································································································
+
+  public: static const uint16_t kInvalidHandle = 0xFFFF ;
+
+  //--- Phase offset given explicitly (ms, relative to the first tick)
+  public: uint16_t addPeriodicMessage (const CANMessage & inMessage,
+                                       const uint32_t inPeriod,
+                                       const uint32_t inOffset) ;
+
+  //--- Phase offset chosen so that the release dates coincide with as few existing messages as possible
+  public: uint16_t addPeriodicMessage (const CANMessage & inMessage,
+                                       const uint32_t inPeriod) ;
+
+  //--- Update the payload sent at the next releases
+  public: bool updateMessage (const uint16_t inHandle, const CANMessage & inMessage) ;
+
+  public: bool removePeriodicMessage (const uint16_t inHandle) ;
+
+//······················································································································
+//   Tick source
+//······················································································································
+
+  public: void tick (const uint32_t inNowMillis) ;
+
+#ifdef ARDUINO
+  public: bool startTickTimer (const uint32_t inTickPeriodMillis) ;
+  public: void stopTickTimer (void) ;
+#endif
+
+//······················································································································
+//   Statistics
+//······················································································································
+
+  public: bool statistics (const uint16_t inHandle, ESP32ACANPeriodicStatistics & outStatistics) const ;
+  public: void resetStatistics (void) ;
+
+  public: inline uint16_t capacity (void) const { return mCapacity ; }
+  public: inline uint16_t count (void) const { return mHeapCount ; }
+  public: inline uint32_t missedDeadlineCount (void) const { return mMissedDeadlineCount ; }
+
+//······················································································································
+//   Private
+//······················································································································
+
+  private: class Entry {
+    public: CANMessage mMessage ;
+    public: uint32_t mPeriod ;
+    public: uint32_t mOffset ;
+    public: uint32_t mNextRelease ;
+    public: uint16_t mHeapIndex ;  // kInvalidHandle when the entry is free
+    public: uint32_t mGeneration ; // Incremented each time the slot is given to a message
+    public: ESP32ACANPeriodicStatistics mStatistics ;
+  } ;
+
+  //--- Release grid of a registered message, copied in critical section for leastLoadedOffset
+  private: class Grid {
+    public: uint32_t mPeriod ;
+    public: uint32_t mOffset ;
+  } ;
+
+  private: uint16_t insertEntry (const CANMessage & inMessage, const uint32_t inPeriod, const uint32_t inOffset) ;
+  private: static uint32_t leastLoadedOffset (const uint32_t inPeriod, Grid * ioGrids, const uint16_t inGridCount) ;
+  private: bool isBefore (const uint16_t inEntryA, const uint16_t inEntryB) const ;
+  private: void swapHeapItems (const uint16_t inIndexA, const uint16_t inIndexB) ;
+  private: void siftUp (uint16_t inIndex) ;
+  private: void siftDown (uint16_t inIndex) ;
+  private: void removeHeapItem (const uint16_t inIndex) ;
+#ifdef ARDUINO
+  private: static bool sendThroughDriver (void * inDriver, const CANMessage & inMessage) ;
+  private: static void timerCallback (TimerHandle_t inTimer) ;
+#endif
+
+  private: void * mDriver ;
+  private: const ESP32ACANSchedulerSendRoutine mSendRoutine ;
+  private: Entry * mEntries ;
+  private: uint16_t * mHeap ;         // Entry indexes, mHeap [0] is the next release
+  private: uint16_t mCapacity ;
+  private: uint16_t mHeapCount ;
+  private: bool mStarted ;            // Release dates are set from the first tick
+  private: uint32_t mStartDate ;
+  private: uint32_t mLastTick ;
+  private: uint32_t mMissedDeadlineCount ;
+#ifdef ARDUINO
+  private: TimerHandle_t mTimer ;
+#endif
+
+//······················································································································
+//    No Copy
+//······················································································································
+
+  private: ESP32ACANScheduler (const ESP32ACANScheduler &) = delete ;
+  private: ESP32ACANScheduler & operator = (const ESP32ACANScheduler &) = delete ;
+
+} ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
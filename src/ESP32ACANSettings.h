@@ -18,6 +18,9 @@
 /*   V1.4   | 04 Jun 2019 | Added CAN operating Mode                          */
 /*   V1.5   | 15 Jul 2019 | Added driver buffers                              */
 /*   V2.0   | 08 Aug 2019 | Message Control types                             */
+/*   V2.1   |             | Latest value mailbox receive mode                 */
+/*          |             | Interrupt level, core and IRAM placement          */
+/*          |             | Caller provided driver buffer storage             */
 /* ---------------------------------------------------------------------------*/
 
 #pragma once
@@ -25,6 +28,8 @@
 /*------------------------------- Include files ------------------------------*/
 #include <stdint.h>
 #include "soc/soc.h"
+
+class CANMessage ;
 //——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
 //  ESP32 ACANSettings class
 //——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
@@ -93,6 +98,44 @@ class ESP32ACANSettings {
      
     public: CANProcess mControlMessageByMethod = PollingControlled ;
 
+//······················································································································
+//    Interrupt allocation (InterruptControlled)
+//······················································································································
+//  mInterruptLevel: 1 ... 3.
+//  mInterruptCore: core that runs the interrupt handler; CurrentCore: the core of the task calling begin.
+//  mInterruptInIRAM: the handler keeps running while the flash cache is disabled (NVS, OTA, SPIFFS writes); the
+//  receive and transmit paths, driver buffers, mailboxes and bus load meter are in IRAM / internal RAM. With false,
+//  the handler is deferred during flash writes.
+
+    public: typedef enum : uint8_t {
+        CurrentCore,
+        Core0,
+        Core1,
+    } InterruptCore;
+
+    public: uint8_t mInterruptLevel = 1 ;
+    public: InterruptCore mInterruptCore = CurrentCore ;
+    public: bool mInterruptInIRAM = true ;
+
+//······················································································································
+//    Receive mode
+//······················································································································
+//  FIFOReceive: every frame goes to the driver receive buffer (mDriverReceiveBufferSize).
+//  MailboxReceive: one latest value mailbox per identifier of mMailboxIdentifiers, other frames are dropped, and no
+//  driver receive buffer is allocated.
+//  MailboxAndFIFOReceive: frames with a mailbox go to it, other frames go to the driver receive buffer.
+//  mMailboxIdentifiers: ACANMailboxes::key (identifier, extended) values, copied by begin.
+
+    public: typedef enum : uint8_t {
+        FIFOReceive,
+        MailboxReceive,
+        MailboxAndFIFOReceive,
+    } ReceiveMode;
+
+    public: ReceiveMode mReceiveMode = FIFOReceive ;
+    public: const uint32_t * mMailboxIdentifiers = nullptr ;
+    public: uint16_t mMailboxCount = 0 ;
+
 //······················································································································
 //    Receive buffer size
 //······················································································································
@@ -104,6 +147,15 @@ class ESP32ACANSettings {
 //······················································································································
 
     public: uint16_t mDriverTransmitBufferSize = 16 ;
+
+//······················································································································
+//    Driver buffer storage: nullptr, allocated in internal RAM by begin; otherwise an array of the buffer size
+//    entries, provided by the application (static array, heap_caps_malloc in any region). It must stay valid until
+//    end or the next begin. External PSRAM is reached through the flash cache: it requires mInterruptInIRAM false.
+//······················································································································
+
+    public: CANMessage * mDriverReceiveBufferStorage = nullptr ;
+    public: CANMessage * mDriverTransmitBufferStorage = nullptr ;
   
 //······················································································································
 //    Compute actual bit rate
@@ -0,0 +1,420 @@
+/******************************************************************************/
+/* File name        : main.cpp                                                */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Compiler         : Desktop C++ COMPILER (Visual Studio Code)               */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation: event loop, callback and coroutine node models        */
+/* ---------------------------------------------------------------------------*/
+// Build with -std=c++20 for the coroutine tests; with an older standard only the callback API is tested.
+
+/*------------------------------- Include files ------------------------------*/
+#include <iostream>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <chrono>
+#include <stdlib.h>
+#include "../src/ACANAsync.cpp"
+#include "../simulation-on-desktop/VirtualCANBus.cpp"
+#include "../simulation-on-desktop/DesktopTest.h"
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+using namespace std;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   Driver stub: receive buffer filled by the test, bounded transmit buffer emptied by the test
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+class StubDriver {
+  public: bool receive (CANMessage & outFrame) {
+    const bool ok = !mReceiveBuffer.empty () ;
+    if (ok) {
+      outFrame = mReceiveBuffer.front () ;
+      mReceiveBuffer.pop_front () ;
+    }
+    return ok ;
+  }
+
+  public: bool tryToSend (const CANMessage & inFrame) {
+    const bool ok = mTransmitBuffer.size () < mTransmitCapacity ;
+    if (ok) {
+      mTransmitBuffer.push_back (inFrame) ;
+    }
+    return ok ;
+  }
+
+  public: deque <CANMessage> mReceiveBuffer ;
+  public: deque <CANMessage> mTransmitBuffer ;
+  public: size_t mTransmitCapacity = 2 ;
+} ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static vector <uint32_t> gCompletions ;
+
+static void recordCompletion (void * inContext, ACANAsyncOperation & inOperation) {
+  gCompletions.push_back ((uint32_t) (uintptr_t) inContext) ;
+  gCompletions.push_back (inOperation.mFrame.id) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void testCallbackAPI (void) {
+  cout << "Callback API" << endl ;
+  ACANEventLoop loop ;
+  check (loop.begin (3), "begin") ;
+  StubDriver driver ;
+  ACANAsyncPort port (loop, driver) ;
+//--- Receives complete in FIFO order, only when frames are available, and never from receive
+  ACANAsyncOperation rx [3] ;
+  for (uint32_t i=0 ; i<3 ; i++) {
+    rx [i].mCompletion = recordCompletion ;
+    rx [i].mContext = (void *) (uintptr_t) (10 + i) ;
+    port.receive (rx [i]) ;
+  }
+  CANMessage frame ;
+  frame.id = 0x123 ;
+  driver.mReceiveBuffer.push_back (frame) ;
+  check (gCompletions.empty (), "completion from receive") ;
+  check (!port.receiveNow (frame), "receiveNow bypasses queued receives") ;
+  loop.poll (0) ;
+  check ((gCompletions.size () == 2) && (gCompletions [0] == 10) && (gCompletions [1] == 0x123), "first receive") ;
+  port.cancel (rx [1]) ;
+  check (!rx [1].mPending && (port.queuedReceiveCount () == 1), "cancel receive") ;
+  frame.id = 0x456 ;
+  driver.mReceiveBuffer.push_back (frame) ;
+  driver.mReceiveBuffer.push_back (frame) ;
+  loop.poll (0) ;
+  check ((gCompletions.size () == 4) && (gCompletions [2] == 12) && (gCompletions [3] == 0x456), "receive after cancel") ;
+  check (driver.mReceiveBuffer.size () == 1, "frame left in the driver") ;
+  check (port.receiveNow (frame) && (frame.id == 0x456), "receiveNow") ;
+//--- Sends wait for room in the driver, in FIFO order
+  gCompletions.clear () ;
+  ACANAsyncOperation tx [4] ;
+  for (uint32_t i=0 ; i<4 ; i++) {
+    tx [i].mFrame.id = 0x200 + i ;
+    tx [i].mCompletion = recordCompletion ;
+    tx [i].mContext = (void *) (uintptr_t) (20 + i) ;
+    port.send (tx [i]) ;
+  }
+  loop.poll (0) ;
+  check ((gCompletions.size () == 4) && (port.queuedSendCount () == 2), "send backpressure") ;
+  check (!port.sendNow (frame), "sendNow bypasses queued sends") ;
+  driver.mTransmitBuffer.pop_front () ;
+  loop.poll (0) ;
+  check ((gCompletions.size () == 6) && (gCompletions [4] == 22) && (driver.mTransmitBuffer.back ().id == 0x202), "send order") ;
+  driver.mTransmitBuffer.clear () ;
+  loop.poll (0) ;
+  check ((gCompletions.size () == 8) && (gCompletions [6] == 23), "last send") ;
+//--- Timers: date order, start order for equal dates, bounded heap
+  gCompletions.clear () ;
+  ACANAsyncOperation timer [4] ;
+  const uint64_t dates [4] = {300, 100, 300, 200} ;
+  for (uint32_t i=0 ; i<4 ; i++) {
+    timer [i].mFrame.id = i ;
+    timer [i].mCompletion = recordCompletion ;
+    timer [i].mContext = (void *) (uintptr_t) (uint32_t) dates [i] ;
+  }
+  check (loop.startTimer (timer [0], dates [0]), "timer 0") ;
+  check (loop.startTimer (timer [1], dates [1]), "timer 1") ;
+  check (loop.startTimer (timer [2], dates [2]), "timer 2") ;
+  check (!loop.startTimer (timer [3], dates [3]) && (loop.timerOverflowCount () == 1), "timer heap overflow") ;
+  loop.runUntil (250) ;
+  check ((gCompletions.size () == 2) && (gCompletions [1] == 1) && (loop.now () == 250), "first timer") ;
+  check (loop.startTimer (timer [3], dates [3]), "timer 3") ;
+  loop.poll (250) ;
+  check ((gCompletions.size () == 4) && (gCompletions [3] == 3), "past timer") ;
+  loop.runUntil (1000) ;
+  check ((gCompletions.size () == 8) && (gCompletions [5] == 0) && (gCompletions [7] == 2), "equal dates") ;
+  check (loop.startTimer (timer [0], 2000) && loop.startTimer (timer [1], 1500), "restart") ;
+  loop.cancelTimer (timer [1]) ;
+  check ((loop.timerCount () == 1) && !timer [1].mPending, "cancel timer") ;
+  loop.runUntil (3000) ;
+  check ((gCompletions.size () == 10) && (gCompletions [9] == 0), "timer after cancel") ;
+  cout << "  Ok" << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   Request / response node models on a virtual bus
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+// Every client sends a request (extended identifier kRequestBase + index) every kPeriod, with a per client offset,
+// waits for the response of its server (kResponseBase + index), and checks it. Servers answer with the request data
+// plus one. Every node receives every frame and ignores the ones that are not its own.
+
+static const uint32_t kPairCount     = 600 ;
+static const uint32_t kRoundCount    = 10 ;
+static const uint32_t kBitRate       = 1000 * 1000 ;
+static const uint64_t kPeriod        = 500 * 1000 * 1000 ; // 500 ms, in ns
+static const uint32_t kRequestBase   = 0x1000000 ;
+static const uint32_t kResponseBase  = 0x0800000 ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static uint64_t advanceBus (void * inBus, const uint64_t inLimit) {
+  return ((VirtualCANBus *) inBus)->runUntilNextFrameEnd (inLimit) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static uint32_t requestData (const uint32_t inIndex, const uint32_t inRound) {
+  return inIndex * 1000 + inRound ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+class Bench {
+  public: Bench (void) : mBus (kBitRate) {
+    check (mLoop.begin (2 * kPairCount), "loop begin") ;
+    mLoop.setAdvanceRoutine (advanceBus, &mBus) ;
+    for (uint32_t i=0 ; i<2 * kPairCount ; i++) {
+    //--- A sleeping client does not receive: its buffer holds the frames of a whole period
+      mNodes.push_back (unique_ptr <VirtualCANNode> (new VirtualCANNode (4, 4 * kPairCount))) ;
+      mBus.attach (*mNodes.back ()) ;
+      mPorts.push_back (unique_ptr <ACANAsyncPort> (new ACANAsyncPort (mLoop, *mNodes.back ()))) ;
+    }
+  }
+
+  public: ACANAsyncPort & clientPort (const uint32_t inIndex) { return *mPorts [2 * inIndex] ; }
+  public: ACANAsyncPort & serverPort (const uint32_t inIndex) { return *mPorts [2 * inIndex + 1] ; }
+  public: uint64_t startDate (const uint32_t inIndex, const uint32_t inRound) const {
+    return inRound * kPeriod + inIndex * (kPeriod / kPairCount) ;
+  }
+
+  public: void report (const char * inTitle, const double inSeconds) {
+    uint64_t overflows = 0 ;
+    for (size_t i=0 ; i<mNodes.size () ; i++) {
+      overflows += mNodes [i]->mReceiveOverflowCount ;
+    }
+    check (overflows == 0, "receive buffer overflow") ;
+    check (mBus.frameCount () == 2 * kPairCount * kRoundCount, "frame count") ;
+    check (mResponseErrorCount == 0, "response data") ;
+    check (mCompletedClientCount == kPairCount, "clients completed") ;
+    cout << "  " << inTitle << ": " << mNodes.size () << " nodes, " << mBus.frameCount () << " frames, "
+         << mLoop.completedOperationCount () << " operations in " << (int) (inSeconds * 1000.0) << " ms ("
+         << (int) (mLoop.completedOperationCount () / inSeconds / 1.0e6) << " M switches/s), bus load "
+         << (int) (100.0 * mBus.busyTime () / mBus.date ()) << "%" << endl ;
+  }
+
+  public: ACANEventLoop mLoop ;
+  public: VirtualCANBus mBus ;
+  public: vector <unique_ptr <VirtualCANNode> > mNodes ;
+  public: vector <unique_ptr <ACANAsyncPort> > mPorts ;
+  public: uint32_t mCompletedClientCount = 0 ;
+  public: uint32_t mResponseErrorCount = 0 ;
+} ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   Callback node models: explicit state machines
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+class CallbackClient {
+  public: void start (Bench & inBench, const uint32_t inIndex) {
+    mBench = &inBench ;
+    mIndex = inIndex ;
+    mTimer.mCompletion = timerExpired ;
+    mTimer.mContext = this ;
+    mSend.mCompletion = nullptr ;
+    mReceive.mCompletion = frameReceived ;
+    mReceive.mContext = this ;
+    check (inBench.mLoop.startTimer (mTimer, inBench.startDate (inIndex, 0)), "client timer") ;
+  }
+
+  private: static void timerExpired (void * inClient, ACANAsyncOperation &) {
+    CallbackClient * client = (CallbackClient *) inClient ;
+    CANMessage & frame = client->mSend.mFrame ;
+    frame.ext = true ;
+    frame.id = kRequestBase + client->mIndex ;
+    frame.len = 4 ;
+    frame.data32 [0] = requestData (client->mIndex, client->mRound) ;
+    client->mBench->clientPort (client->mIndex).send (client->mSend) ;
+    client->mBench->clientPort (client->mIndex).receive (client->mReceive) ;
+  }
+
+  private: static void frameReceived (void * inClient, ACANAsyncOperation & inOperation) {
+    CallbackClient * client = (CallbackClient *) inClient ;
+    Bench & bench = *client->mBench ;
+    const CANMessage & frame = inOperation.mFrame ;
+    if (!frame.ext || (frame.id != (kResponseBase + client->mIndex))) {
+      bench.clientPort (client->mIndex).receive (client->mReceive) ;
+    }else{
+      if (frame.data32 [0] != (requestData (client->mIndex, client->mRound) + 1)) {
+        bench.mResponseErrorCount += 1 ;
+      }
+      client->mRound += 1 ;
+      if (client->mRound < kRoundCount) {
+        check (bench.mLoop.startTimer (client->mTimer, bench.startDate (client->mIndex, client->mRound)), "client timer") ;
+      }else{
+        bench.mCompletedClientCount += 1 ;
+      }
+    }
+  }
+
+  private: Bench * mBench = nullptr ;
+  private: uint32_t mIndex = 0 ;
+  private: uint32_t mRound = 0 ;
+  private: ACANAsyncOperation mTimer ;
+  private: ACANAsyncOperation mSend ;
+  private: ACANAsyncOperation mReceive ;
+} ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+class CallbackServer {
+  public: void start (Bench & inBench, const uint32_t inIndex) {
+    mBench = &inBench ;
+    mIndex = inIndex ;
+    mReceive.mCompletion = frameReceived ;
+    mReceive.mContext = this ;
+    mSend.mCompletion = responseSent ;
+    mSend.mContext = this ;
+    inBench.serverPort (inIndex).receive (mReceive) ;
+  }
+
+  public: void stop (void) {
+    mBench->serverPort (mIndex).cancel (mReceive) ;
+    mBench->serverPort (mIndex).cancel (mSend) ;
+  }
+
+  private: static void frameReceived (void * inServer, ACANAsyncOperation & inOperation) {
+    CallbackServer * server = (CallbackServer *) inServer ;
+    ACANAsyncPort & port = server->mBench->serverPort (server->mIndex) ;
+    const CANMessage & frame = inOperation.mFrame ;
+    if (!frame.ext || (frame.id != (kRequestBase + server->mIndex))) {
+      port.receive (server->mReceive) ;
+    }else{
+      server->mSend.mFrame = frame ;
+      server->mSend.mFrame.id = kResponseBase + server->mIndex ;
+      server->mSend.mFrame.data32 [0] += 1 ;
+      port.send (server->mSend) ;
+    }
+  }
+
+  private: static void responseSent (void * inServer, ACANAsyncOperation &) {
+    CallbackServer * server = (CallbackServer *) inServer ;
+    server->mBench->serverPort (server->mIndex).receive (server->mReceive) ;
+  }
+
+  private: Bench * mBench = nullptr ;
+  private: uint32_t mIndex = 0 ;
+  private: ACANAsyncOperation mReceive ;
+  private: ACANAsyncOperation mSend ;
+} ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void testCallbackNodes (void) {
+  cout << "Callback node models on a virtual bus" << endl ;
+  Bench bench ;
+  vector <CallbackClient> clients (kPairCount) ;
+  vector <CallbackServer> servers (kPairCount) ;
+  for (uint32_t i=0 ; i<kPairCount ; i++) {
+    clients [i].start (bench, i) ;
+    servers [i].start (bench, i) ;
+  }
+  const auto start = chrono::steady_clock::now () ;
+  bench.mLoop.runUntil (kRoundCount * kPeriod) ;
+  const double seconds = chrono::duration <double> (chrono::steady_clock::now () - start).count () ;
+  bench.report ("callbacks", seconds) ;
+//--- Servers still wait for a request: their operations leave the ports before they are destroyed
+  for (uint32_t i=0 ; i<kPairCount ; i++) {
+    check (bench.serverPort (i).queuedReceiveCount () == 1, "server waiting") ;
+    servers [i].stop () ;
+    check (bench.serverPort (i).queuedReceiveCount () == 0, "server stopped") ;
+  }
+  cout << "  Ok" << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   Coroutine node models: the same behaviour, written as sequential code
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+#ifdef ACAN_ASYNC_COROUTINES
+
+static ACANTask coroutineClient (Bench & inBench, const uint32_t inIndex) {
+  ACANAsyncPort & port = inBench.clientPort (inIndex) ;
+  CANMessage request ;
+  request.ext = true ;
+  request.id = kRequestBase + inIndex ;
+  request.len = 4 ;
+  for (uint32_t round=0 ; round<kRoundCount ; round++) {
+    co_await inBench.mLoop.sleepUntil (inBench.startDate (inIndex, round)) ;
+    request.data32 [0] = requestData (inIndex, round) ;
+    co_await port.sendAsync (request) ;
+    bool received = false ;
+    while (!received) {
+      const CANMessage frame = co_await port.receiveAsync () ;
+      received = frame.ext && (frame.id == (kResponseBase + inIndex)) ;
+      if (received && (frame.data32 [0] != (request.data32 [0] + 1))) {
+        inBench.mResponseErrorCount += 1 ;
+      }
+    }
+  }
+  inBench.mCompletedClientCount += 1 ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static ACANTask coroutineServer (Bench & inBench, const uint32_t inIndex) {
+  ACANAsyncPort & port = inBench.serverPort (inIndex) ;
+  while (true) {
+    CANMessage frame = co_await port.receiveAsync () ;
+    if (frame.ext && (frame.id == (kRequestBase + inIndex))) {
+      frame.id = kResponseBase + inIndex ;
+      frame.data32 [0] += 1 ;
+      co_await port.sendAsync (frame) ;
+    }
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void testCoroutineNodes (void) {
+  cout << "Coroutine node models on a virtual bus" << endl ;
+  Bench bench ;
+  vector <ACANTask> tasks ;
+  for (uint32_t i=0 ; i<kPairCount ; i++) {
+    tasks.push_back (coroutineClient (bench, i)) ;
+    tasks.push_back (coroutineServer (bench, i)) ;
+  }
+  const auto start = chrono::steady_clock::now () ;
+  bench.mLoop.runUntil (kRoundCount * kPeriod) ;
+  const double seconds = chrono::duration <double> (chrono::steady_clock::now () - start).count () ;
+  bench.report ("coroutines", seconds) ;
+  for (uint32_t i=0 ; i<kPairCount ; i++) {
+    check (tasks [2 * i].done () && !tasks [2 * i + 1].done (), "task states") ;
+    check (bench.serverPort (i).queuedReceiveCount () == 1, "server waiting") ;
+  }
+//--- Destroying a suspended task cancels its pending receive
+  tasks.clear () ;
+  for (uint32_t i=0 ; i<kPairCount ; i++) {
+    check (bench.serverPort (i).queuedReceiveCount () == 0, "cancelled by destruction") ;
+  }
+  cout << "  Ok" << endl ;
+}
+
+#endif
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+int main (int /* argc */, const char * /* argv */ []) {
+  testCallbackAPI () ;
+  testCallbackNodes () ;
+  #ifdef ACAN_ASYNC_COROUTINES
+    testCoroutineNodes () ;
+  #else
+    cout << "Coroutine node models: C++20 coroutines not available, skipped" << endl ;
+  #endif
+  cout << "All async tests Ok" << endl ;
+  return 0 ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
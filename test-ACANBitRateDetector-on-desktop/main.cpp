@@ -0,0 +1,227 @@
+/******************************************************************************/
+/* File name        : main.cpp                                                */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Compiler         : Desktop C++ COMPILER (Visual Studio Code)               */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation: bit rate detection                                    */
+/* ---------------------------------------------------------------------------*/
+
+/*------------------------------- Include files ------------------------------*/
+#include <iostream>
+#include <stdlib.h>
+#include "../src/ACANBitRateDetector.cpp"
+#include "../simulation-on-desktop/VirtualCANBus.cpp"
+#include "../simulation-on-desktop/DesktopTest.h"
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+using namespace std;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Simulated listen only controller. The traffic runs on the virtual bus at the true bit rate; the controller sees
+//  the frames that start after it was configured:
+//    - at the true bit rate, a valid frame at the end of each frame;
+//    - at another bit rate, a bus error (stuff or form error, no error frame in listen only mode), reported at the
+//      end of the frame at the latest.
+//  As the ESP32 controller (bit rate prescaler up to 128, 25 time quanta at most), bit rates under 25 kbit/s are
+//  not reachable. Every poll of the event takes kPollStep of simulated time.
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static const uint64_t kPollStep = 50 * 1000 ; // 50 µs
+static const uint32_t kMinimumBitRate = 25 * 1000 ;
+
+class SimulatedListenOnlyController {
+
+  public: SimulatedListenOnlyController (const uint32_t inBusBitRate, const uint64_t inTrafficPeriod) :
+  mBus (inBusBitRate),
+  mDate (0),
+  mTrafficNode (),
+  mTrafficPeriod (inTrafficPeriod),
+  mNextTrafficDate (randomValue () % 1000000),
+  mBitRate (0),
+  mListenDate (0),
+  mPendingEvent (ACANBitRateDetector::NoEvent),
+  mFrameCount (0),
+  mValidFrameCount (0) {
+    mBus.attach (mTrafficNode) ;
+    mBus.setObserver (endOfFrame, this) ;
+  }
+
+  //--- Controller interface of ACANBitRateDetector
+  public: bool listenAtBitRate (const uint32_t inBitRate) {
+    const bool ok = inBitRate >= kMinimumBitRate ;
+    if (ok) {
+      mBitRate = inBitRate ;
+      mListenDate = mDate ;
+      mPendingEvent = ACANBitRateDetector::NoEvent ;
+    }
+    return ok ;
+  }
+
+  public: ACANBitRateDetector::Event bitRateEvent (void) {
+    mDate += kPollStep ;
+    runUntil (mDate) ;
+    const ACANBitRateDetector::Event event = mPendingEvent ;
+    mPendingEvent = ACANBitRateDetector::NoEvent ;
+    return event ;
+  }
+
+  public: uint32_t bitRateDetectionMillis (void) {
+    return uint32_t (mDate / (1000 * 1000)) ;
+  }
+
+  //--- Traffic: one frame every mTrafficPeriod (none if 0), random identifier and data
+  private: void runUntil (const uint64_t inDate) {
+    while ((mTrafficPeriod > 0) && (mNextTrafficDate <= inDate)) {
+      mBus.runUntil (mNextTrafficDate) ;
+      CANMessage frame ;
+      frame.id = randomValue () & 0x7FF ;
+      frame.len = uint8_t (randomValue () % 9) ;
+      for (uint8_t i=0 ; i<frame.len ; i++) {
+        frame.data [i] = uint8_t (randomValue ()) ;
+      }
+      mTrafficNode.tryToSend (frame) ;
+      mNextTrafficDate += mTrafficPeriod ;
+    }
+    mBus.runUntil (inDate) ;
+  }
+
+  private: static void endOfFrame (void * inContext,
+                                   const VirtualCANNode & /* inSender */,
+                                   const CANMessage & inFrame,
+                                   const uint64_t inEndDate) {
+    SimulatedListenOnlyController * controller = (SimulatedListenOnlyController *) inContext ;
+    const uint64_t duration = (uint64_t (VirtualCANBus::frameBitLength (inFrame)) * 1000000000ULL) / controller->mBus.bitRate () ;
+    controller->mFrameCount += 1 ;
+    if ((controller->mBitRate != 0) && ((inEndDate - duration) >= controller->mListenDate)) {
+      if (controller->mBitRate == controller->mBus.bitRate ()) {
+        controller->mPendingEvent = ACANBitRateDetector::ValidFrame ;
+        controller->mValidFrameCount += 1 ;
+      }else if (controller->mPendingEvent == ACANBitRateDetector::NoEvent) {
+        controller->mPendingEvent = ACANBitRateDetector::BusError ;
+      }
+    }
+  }
+
+  public: inline uint32_t listeningBitRate (void) const { return mBitRate ; }
+  public: inline uint64_t date (void) const { return mDate ; }
+
+  private: VirtualCANBus mBus ;
+  private: uint64_t mDate ; // The bus date stays at the end of the last frame while the bus is busy
+  private: VirtualCANNode mTrafficNode ;
+  private: const uint64_t mTrafficPeriod ;
+  private: uint64_t mNextTrafficDate ;
+  private: uint32_t mBitRate ;
+  private: uint64_t mListenDate ;
+  private: ACANBitRateDetector::Event mPendingEvent ;
+  public: uint32_t mFrameCount ;
+  public: uint32_t mValidFrameCount ;
+} ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Every reachable standard bit rate is detected on a busy bus (a frame every 20 bits: back to back frames)
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void busyBus (void) {
+  cout << "Busy bus" << endl ;
+  for (uint8_t i=0 ; i<ACANBitRateDetector::kStandardBitRateCount ; i++) {
+    const uint32_t bitRate = ACANBitRateDetector::kStandardBitRates [i] ;
+    SimulatedListenOnlyController controller (bitRate, (20ULL * 1000000000ULL) / bitRate) ;
+    ACANBitRateDetector detector (controller) ;
+    const uint32_t detected = detector.detect (ACANBitRateDetector::kStandardBitRates,
+                                               ACANBitRateDetector::kStandardBitRateCount,
+                                               1000) ;
+    cout << "  " << bitRate << " bit/s: " ;
+    if (bitRate < kMinimumBitRate) {
+      check (detected == 0, "unreachable bit rate detected") ;
+      cout << "not reachable" << endl ;
+    }else{
+      check (detected == bitRate, "wrong bit rate") ;
+      check (controller.listeningBitRate () == bitRate, "controller not left at the detected bit rate") ;
+      check (detector.busErrorCount () <= i, "more bus errors than higher candidates") ;
+      check (detector.listenCount () > i, "higher candidates not listened") ;
+      const double ms = controller.date () / 1.0e6 ;
+      cout << ms << " ms, " << detector.listenCount () << " candidates listened" << endl ;
+      check (ms < (10.0 + 1.0e6 / bitRate), "too slow on a busy bus") ;
+    }
+  }
+  cout << "  Ok" << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Sparse traffic: a frame every 100 ms, the dwell time grows round after round
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void sparseTraffic (void) {
+  cout << "Sparse traffic, a frame every 100 ms" << endl ;
+  const uint32_t bitRates [] = {500 * 1000, 125 * 1000, 33333} ;
+  for (uint32_t i=0 ; i<3 ; i++) {
+    SimulatedListenOnlyController controller (bitRates [i], 100ULL * 1000 * 1000) ;
+    ACANBitRateDetector detector (controller) ;
+    const uint32_t detected = detector.detect (ACANBitRateDetector::kStandardBitRates,
+                                               ACANBitRateDetector::kStandardBitRateCount,
+                                               20 * 1000) ;
+    check (detected == bitRates [i], "sparse traffic: wrong bit rate") ;
+    cout << "  " << bitRates [i] << " bit/s: " << (controller.date () / 1.0e6) << " ms, "
+         << detector.listenCount () << " candidates listened" << endl ;
+  }
+  cout << "  Ok" << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  No detection: idle bus, bit rate not in the candidates, no reachable candidate
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void noDetection (void) {
+  cout << "No detection" << endl ;
+  { SimulatedListenOnlyController controller (500 * 1000, 0) ;
+    ACANBitRateDetector detector (controller) ;
+    const uint32_t detected = detector.detect (ACANBitRateDetector::kStandardBitRates,
+                                               ACANBitRateDetector::kStandardBitRateCount,
+                                               500) ;
+    check (detected == 0, "idle bus: bit rate detected") ;
+    check (controller.bitRateDetectionMillis () == 500, "idle bus: timeout not respected") ;
+    check (detector.busErrorCount () == 0, "idle bus: bus error") ;
+  }
+  { const uint32_t candidates [] = {1000 * 1000, 250 * 1000, 125 * 1000} ;
+    SimulatedListenOnlyController controller (500 * 1000, 100 * 1000) ;
+    ACANBitRateDetector detector (controller) ;
+    const uint32_t detected = detector.detect (candidates, 3, 300) ;
+    check (detected == 0, "bit rate not in the candidates detected") ;
+    check (controller.bitRateDetectionMillis () <= 301, "bit rate not in the candidates: timeout not respected") ;
+    check (detector.busErrorCount () > 3, "candidates should be tried again after elimination") ;
+  }
+  { const uint32_t candidates [] = {20 * 1000, 10 * 1000, 0} ;
+    SimulatedListenOnlyController controller (500 * 1000, 100 * 1000) ;
+    ACANBitRateDetector detector (controller) ;
+    const uint32_t detected = detector.detect (candidates, 3, 1000) ;
+    check (detected == 0, "unreachable candidates: bit rate detected") ;
+    check (controller.bitRateDetectionMillis () == 0, "unreachable candidates: should return at once") ;
+    check (detector.listenCount () == 0, "unreachable candidates listened") ;
+  }
+  { SimulatedListenOnlyController controller (500 * 1000, 100 * 1000) ;
+    ACANBitRateDetector detector (controller) ;
+    check (detector.detect (nullptr, 0, 1000) == 0, "no candidate: bit rate detected") ;
+  }
+  cout << "  Ok" << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+int main (int /* argc */, const char * /* argv */ []) {
+  busyBus () ;
+  sparseTraffic () ;
+  noDetection () ;
+  cout << "All bit rate detection tests Ok" << endl ;
+  return 0 ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
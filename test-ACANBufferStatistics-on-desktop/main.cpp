@@ -0,0 +1,363 @@
+/******************************************************************************/
+/* File name        : main.cpp                                                */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Compiler         : Desktop C++ COMPILER (Visual Studio Code)               */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation: driver buffer statistics                              */
+/* ---------------------------------------------------------------------------*/
+
+/*------------------------------- Include files ------------------------------*/
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include <stdlib.h>
+#include "../src/ACANBuffer16.h"
+#include "../src/ACANBufferStatistics.cpp"
+#include "../simulation-on-desktop/VirtualCANBus.cpp"
+#include "../simulation-on-desktop/DesktopTest.h"
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+using namespace std;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Simulated date (ns), used as date function of the statistics
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static uint64_t gDate = 0 ;
+
+static uint32_t simulatedDate (void) {
+  return uint32_t (gDate) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Residence buckets: every duration is in its bucket, bucket width at most 1/8 of its lower bound
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void checkDuration (const uint32_t inDuration) {
+  const uint32_t bucket = ACANBufferStatistics::residenceBucket (inDuration) ;
+  check (bucket < ACANBufferStatistics::kResidenceBucketCount, "bucket out of range") ;
+  const uint32_t upperBound = ACANBufferStatistics::residenceBucketUpperBound (uint16_t (bucket)) ;
+  check (inDuration <= upperBound, "duration above its bucket") ;
+  check ((bucket == 0) || (inDuration > ACANBufferStatistics::residenceBucketUpperBound (uint16_t (bucket - 1))),
+         "duration below its bucket") ;
+  check ((upperBound - inDuration) <= (inDuration / 8), "bucket too wide") ;
+}
+
+static void residenceBuckets (void) {
+  cout << "Residence buckets" << endl ;
+  for (uint32_t d=0 ; d<(1 << 16) ; d++) {
+    checkDuration (d) ;
+  }
+  for (uint32_t i=0 ; i<1000000 ; i++) {
+    checkDuration ((randomValue () << 8) ^ randomValue ()) ;
+  }
+  checkDuration (0xFFFFFFFF) ;
+  check (ACANBufferStatistics::residenceBucket (0xFFFFFFFF) == ACANBufferStatistics::kResidenceBucketCount - 1,
+         "last bucket unused") ;
+  cout << "  Ok" << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Occupancy: random appends and removes, histogram against a reference
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void occupancy (const uint16_t inBufferSize) {
+  cout << "Occupancy, buffer size " << inBufferSize << endl ;
+  ACANBuffer16 buffer ;
+  ACANBufferStatistics statistics (simulatedDate) ;
+  check (buffer.initWithSize (inBufferSize), "buffer allocation") ;
+  check (buffer.prepareStatistics (&statistics), "statistics allocation") ;
+  buffer.attachStatistics (&statistics) ;
+  check (buffer.statistics () == &statistics, "statistics not attached") ;
+  vector <uint32_t> counts (inBufferSize + 1) ;
+  uint32_t rejected = 0 ;
+  CANMessage frame ;
+  for (uint32_t i=0 ; i<200000 ; i++) {
+    gDate += 1 ;
+    if ((randomValue () % 100) < 52) { // Slowly fills up, then overflows
+      const bool ok = buffer.append (frame) ;
+      counts [buffer.count ()] += 1 ;
+      rejected += ok ? 0 : 1 ;
+    }else{
+      buffer.remove (frame) ;
+    }
+  }
+  uint32_t shift = 0 ;
+  while ((inBufferSize >> shift) >= ACANBufferStatistics::kOccupancyBucketCount) {
+    shift += 1 ;
+  }
+  uint32_t sampleCount = 0 ;
+  for (uint16_t b=0 ; b<ACANBufferStatistics::kOccupancyBucketCount ; b++) {
+    uint32_t expected = 0 ;
+    for (uint32_t c=0 ; c<=inBufferSize ; c++) {
+      expected += ((c >> shift) == b) ? counts [c] : 0 ;
+    }
+    check (statistics.occupancyBucket (b) == expected, "occupancy bucket") ;
+    check (statistics.occupancyBucketLowerBound (b) == (uint32_t (b) << shift), "occupancy lower bound") ;
+    sampleCount += expected ;
+  }
+  check (statistics.occupancySampleCount () == sampleCount, "occupancy sample count") ;
+  check (statistics.droppedCount () == rejected, "dropped count") ;
+  check (rejected > 0, "no overflow") ;
+  //--- Exact p99 occupancy lies in the reported bucket
+  const uint64_t rank = (uint64_t (sampleCount) * 990 + 999) / 1000 ;
+  uint64_t cumulated = 0 ;
+  uint32_t exact = 0 ;
+  while ((cumulated + counts [exact]) < rank) {
+    cumulated += counts [exact] ;
+    exact += 1 ;
+  }
+  const uint32_t reported = statistics.occupancyPercentile (990) ;
+  check ((reported >= exact) && ((reported >> shift) == (exact >> shift)), "occupancy p99") ;
+  cout << "  p99 occupancy: " << exact << " (reported " << reported << "), dropped: " << rejected << endl ;
+  cout << "  Ok" << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Zero size buffer (MailboxReceive mode, no transmit buffer): allocation of 0 elements returns nullptr, as
+//  heap_caps_malloc (0) on the ESP32; initWithSize (0) succeeds, every append is rejected
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void zeroSize (void) {
+  cout << "Zero size buffer" << endl ;
+  check (allocateInternalRAMArray <CANMessage> (0) == nullptr, "allocation of 0 elements") ;
+  ACANBuffer16 buffer ;
+  check (buffer.initWithSize (0), "initWithSize (0) fails") ;
+  check ((buffer.size () == 0) && (buffer.count () == 0), "zero size buffer size") ;
+  ACANBufferStatistics statistics (simulatedDate) ;
+  check (buffer.prepareStatistics (&statistics), "zero size statistics") ;
+  buffer.attachStatistics (&statistics) ;
+  CANMessage frame ;
+  check (!buffer.append (frame), "append to a zero size buffer") ;
+  check (!buffer.remove (frame) && (buffer.first () == nullptr), "remove from a zero size buffer") ;
+  check (statistics.droppedCount () == 1, "rejected append not counted") ;
+//--- Re-init: 8 -> 0 -> 0 -> 8
+  check (buffer.initWithSize (8) && (buffer.size () == 8), "initWithSize (8)") ;
+  check (buffer.append (frame), "append") ;
+  check (buffer.initWithSize (0) && (buffer.size () == 0) && (buffer.count () == 0), "re-init to 0") ;
+  check (buffer.initWithSize (0), "second initWithSize (0)") ;
+  check (buffer.initWithSize (8) && buffer.append (frame) && (buffer.count () == 1), "re-init to 8") ;
+  cout << "  Ok" << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Residence time on the virtual bus: frames back to back at 1 Mbit/s are appended at their end of frame (receive
+//  interrupt) in an 8 frame buffer; a task reads it every 400 us ... 1.2 ms. Percentiles against the exact residence
+//  times, overflow episodes when the task is late.
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+class ResidenceBench {
+  public: ACANBuffer16 mBuffer ;
+  public: vector <uint64_t> mAppendDates ;
+  public: uint32_t mSequence = 0 ;
+} ;
+
+static void appendAtEndOfFrame (void * inContext,
+                                const VirtualCANNode & /* inSender */,
+                                const CANMessage & inFrame,
+                                const uint64_t inEndDate) {
+  ResidenceBench * bench = (ResidenceBench *) inContext ;
+  gDate = inEndDate ;
+  CANMessage frame = inFrame ;
+  frame.data32 [0] = bench->mSequence ;
+  if (bench->mBuffer.append (frame)) {
+    bench->mAppendDates.push_back (inEndDate) ;
+  }
+  bench->mSequence += 1 ;
+}
+
+static uint32_t exactPercentile (const vector <uint32_t> & inSorted, const uint32_t inPerThousand) {
+  const uint64_t rank = (uint64_t (inSorted.size ()) * inPerThousand + 999) / 1000 ;
+  return inSorted [(rank > 0) ? (rank - 1) : 0] ;
+}
+
+static void residenceOnVirtualBus (void) {
+  cout << "Residence time on the virtual bus, 1 Mbit/s" << endl ;
+  gDate = 0 ;
+  VirtualCANBus bus (1000 * 1000) ;
+  VirtualCANNode sender ;
+  bus.attach (sender) ;
+  ResidenceBench bench ;
+  ACANBufferStatistics statistics (simulatedDate) ;
+  check (bench.mBuffer.initWithSize (8), "buffer allocation") ;
+  check (bench.mBuffer.prepareStatistics (&statistics), "statistics allocation") ;
+  bench.mBuffer.attachStatistics (&statistics) ;
+  bus.setObserver (appendAtEndOfFrame, &bench) ;
+  vector <uint32_t> residences ;
+  uint64_t pollDate = 0 ;
+  CANMessage frame ;
+  frame.len = 8 ;
+  size_t removedCount = 0 ;
+  while (pollDate < 1000ULL * 1000 * 1000) { // 1 s
+    while (sender.tryToSend (frame)) {}
+    pollDate += 400 * 1000 + (randomValue () % (800 * 1000)) ;
+    bus.runUntil (pollDate) ;
+    gDate = pollDate ;
+    CANMessage received ;
+    while (bench.mBuffer.remove (received)) {
+      residences.push_back (uint32_t (pollDate - bench.mAppendDates [removedCount])) ;
+      removedCount += 1 ;
+    }
+  }
+  check (residences.size () == statistics.residenceSampleCount (), "residence sample count") ;
+  sort (residences.begin (), residences.end ()) ;
+  check (statistics.residenceMax () == residences.back (), "residence max") ;
+  const uint32_t perThousand [3] = {500, 990, 999} ;
+  const uint32_t reported [3] = {statistics.residenceP50 (), statistics.residenceP99 (), statistics.residenceP999 ()} ;
+  for (uint32_t i=0 ; i<3 ; i++) {
+    const uint32_t exact = exactPercentile (residences, perThousand [i]) ;
+    cout << "  p" << (perThousand [i] / 10.0) << ": " << (exact / 1000) << " us (reported " << (reported [i] / 1000) << " us)" << endl ;
+    check ((reported [i] >= exact) && ((reported [i] - exact) <= (exact / 8)), "residence percentile") ;
+  }
+  cout << "  " << residences.size () << " frames, " << statistics.droppedCount () << " dropped, "
+       << statistics.overflowEpisodeCount () << " overflow episodes" << endl ;
+  check (statistics.droppedCount () == (bench.mSequence - bench.mAppendDates.size ()), "dropped count") ;
+  check (statistics.overflowEpisodeCount () > 0, "no overflow episode") ;
+  cout << "  Ok" << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Overflow episodes: from the first rejected append to the next remove
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void overflowEpisodes (void) {
+  cout << "Overflow episodes" << endl ;
+  gDate = 0 ;
+  ACANBuffer16 buffer ;
+  ACANBufferStatistics statistics (simulatedDate) ;
+  check (buffer.initWithSize (4), "buffer allocation") ;
+  check (buffer.prepareStatistics (&statistics), "statistics allocation") ;
+  buffer.attachStatistics (&statistics) ;
+  CANMessage frame ;
+  for (uint32_t i=0 ; i<4 ; i++) {
+    check (buffer.append (frame), "append") ;
+  }
+  gDate = 100 ;
+  check (!buffer.append (frame), "append to full buffer") ;
+  check (statistics.inOverflow (), "overflow not started") ;
+  gDate = 150 ;
+  buffer.append (frame) ;
+  gDate = 400 ;
+  buffer.remove (frame) ;
+  check (!statistics.inOverflow (), "overflow not ended") ;
+  buffer.append (frame) ;
+  gDate = 1000 ;
+  buffer.append (frame) ;
+  gDate = 1600 ;
+  const CANMessage * first ;
+  first = buffer.first () ;
+  check (first != nullptr, "first") ;
+  buffer.dropFirst () ; // In place consumer ends the episode too
+  check (statistics.overflowEpisodeCount () == 2, "episode count") ;
+  check (statistics.droppedCount () == 3, "dropped count") ;
+  check (statistics.longestOverflowDuration () == 600, "longest episode") ;
+  check (statistics.totalOverflowDuration () == 900, "total duration") ;
+  ACANBufferStatistics::OverflowEpisode episode ;
+  check (statistics.recentOverflowEpisode (0, episode), "newest episode") ;
+  check ((episode.mStart == 1000) && (episode.mDuration == 600) && (episode.mDroppedCount == 1), "newest episode values") ;
+  check (statistics.recentOverflowEpisode (1, episode), "previous episode") ;
+  check ((episode.mStart == 100) && (episode.mDuration == 300) && (episode.mDroppedCount == 2), "previous episode values") ;
+  check (!statistics.recentOverflowEpisode (2, episode), "unknown episode") ;
+  //--- Only the last kRecentEpisodeCount are kept
+  for (uint32_t e=0 ; e<20 ; e++) {
+    gDate += 10 ;
+    buffer.append (frame) ;
+    buffer.append (frame) ;
+    gDate += e + 1 ;
+    buffer.remove (frame) ;
+  }
+  check (statistics.overflowEpisodeCount () == 22, "episode count after 20 more") ;
+  for (uint8_t i=0 ; i<ACANBufferStatistics::kRecentEpisodeCount ; i++) {
+    check (statistics.recentOverflowEpisode (i, episode), "recent episode") ;
+    check (episode.mDuration == (20U - i), "recent episode order") ;
+  }
+  check (!statistics.recentOverflowEpisode (ACANBufferStatistics::kRecentEpisodeCount, episode), "episode beyond the ring") ;
+  //--- Reset: frames still in the buffer are dated from the reset
+  gDate = 5000 ;
+  buffer.resetStatistics () ;
+  check ((statistics.overflowEpisodeCount () == 0) && (statistics.droppedCount () == 0)
+      && (statistics.residenceSampleCount () == 0) && (statistics.occupancySampleCount () == 0), "reset") ;
+  gDate = 5100 ;
+  buffer.remove (frame) ;
+  check ((statistics.residenceSampleCount () == 1) && (statistics.residenceMax () == 100), "residence after reset") ;
+  //--- Statistics follow a new buffer size; detached, nothing is recorded
+  check (buffer.initWithSize (300), "buffer reallocation") ;
+  check (statistics.capacity () == 300, "statistics capacity") ;
+  buffer.attachStatistics (nullptr) ;
+  buffer.append (frame) ;
+  check (statistics.occupancySampleCount () == 0, "recorded while detached") ;
+  cout << "  Ok" << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Cost: append + remove, with and without statistics (counter as date function, to time the recording only)
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static uint32_t gCounter = 0 ;
+
+static uint32_t counterDate (void) {
+  gCounter += 1 ;
+  return gCounter ;
+}
+
+static double nanosecondsPerFrame (const bool inWithStatistics) {
+  static const uint32_t FRAME_COUNT = 20 * 1000 * 1000 ;
+  ACANBuffer16 buffer ;
+  ACANBufferStatistics statistics (counterDate) ;
+  check (buffer.initWithSize (256), "buffer allocation") ;
+  if (inWithStatistics) {
+    check (buffer.prepareStatistics (&statistics), "statistics allocation") ;
+    buffer.attachStatistics (&statistics) ;
+  }
+  CANMessage frame ;
+  uint32_t checksum = 0 ;
+  const auto start = chrono::steady_clock::now () ;
+  for (uint32_t i=0 ; i<FRAME_COUNT ; i++) {
+    frame.id = i ;
+    buffer.append (frame) ;
+    if ((i & 3) == 3) {
+      for (uint32_t j=0 ; j<4 ; j++) {
+        buffer.remove (frame) ;
+        checksum += frame.id ;
+      }
+    }
+  }
+  const double seconds = chrono::duration <double> (chrono::steady_clock::now () - start).count () ;
+  check (checksum != 0, "checksum") ;
+  return seconds * 1.0e9 / FRAME_COUNT ;
+}
+
+static void cost (void) {
+  cout << "Cost per frame (append + remove)" << endl ;
+  const double without = nanosecondsPerFrame (false) ;
+  const double with = nanosecondsPerFrame (true) ;
+  cout << "  without statistics: " << without << " ns, with: " << with << " ns" << endl ;
+  cout << "  Ok" << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+int main (int /* argc */, const char * /* argv */ []) {
+  residenceBuckets () ;
+  occupancy (20) ;
+  occupancy (100) ;
+  occupancy (1000) ;
+  zeroSize () ;
+  residenceOnVirtualBus () ;
+  overflowEpisodes () ;
+  cost () ;
+  cout << "All buffer statistics tests Ok" << endl ;
+  return 0 ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
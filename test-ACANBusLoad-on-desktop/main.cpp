@@ -0,0 +1,307 @@
+/******************************************************************************/
+/* File name        : main.cpp                                                */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Compiler         : Desktop C++ COMPILER (Visual Studio Code)               */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation: frame length and bus load meter                       */
+/* ---------------------------------------------------------------------------*/
+
+/*------------------------------- Include files ------------------------------*/
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <stdlib.h>
+#include "../src/ACANBusLoad.cpp"
+#include "../simulation-on-desktop/VirtualCANBus.cpp"
+#include "../simulation-on-desktop/DesktopTest.h"
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+using namespace std;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Reference: frame written bit by bit in a vector, CRC over the vector, then stuffed into a second vector
+
+static void appendBits (vector <bool> & ioBits, const uint32_t inValue, const uint32_t inCount) {
+  for (uint32_t i=0 ; i<inCount ; i++) {
+    ioBits.push_back (((inValue >> (inCount - 1 - i)) & 1) != 0) ;
+  }
+}
+
+static uint32_t referenceBitLength (const CANMessage & inFrame) {
+  vector <bool> bits ;
+  bits.push_back (false) ; // SOF
+  if (inFrame.ext) {
+    appendBits (bits, inFrame.id >> 18, 11) ;
+    bits.push_back (true) ;   // SRR
+    bits.push_back (true) ;   // IDE
+    appendBits (bits, inFrame.id, 18) ;
+    bits.push_back (inFrame.rtr) ;
+    bits.push_back (false) ;  // r1
+    bits.push_back (false) ;  // r0
+  }else{
+    appendBits (bits, inFrame.id, 11) ;
+    bits.push_back (inFrame.rtr) ;
+    bits.push_back (false) ;  // IDE
+    bits.push_back (false) ;  // r0
+  }
+  appendBits (bits, inFrame.len, 4) ;
+  const uint32_t n = inFrame.rtr ? 0 : inFrame.len ;
+  for (uint32_t i=0 ; i<n ; i++) {
+    appendBits (bits, inFrame.data [i], 8) ;
+  }
+  uint32_t crc = 0 ;
+  for (size_t i=0 ; i<bits.size () ; i++) {
+    const bool next = bits [i] ^ (((crc >> 14) & 1) != 0) ;
+    crc = (crc << 1) & 0x7FFF ;
+    if (next) {
+      crc ^= 0x4599 ;
+    }
+  }
+  appendBits (bits, crc, 15) ;
+  vector <bool> stuffed ;
+  uint32_t run = 0 ;
+  for (size_t i=0 ; i<bits.size () ; i++) {
+    if (!stuffed.empty () && (stuffed.back () == bits [i])) {
+      run += 1 ;
+    }else{
+      run = 1 ;
+    }
+    stuffed.push_back (bits [i]) ;
+    if (run == 5) {
+      stuffed.push_back (!bits [i]) ;
+      run = 1 ;
+    }
+  }
+  return (uint32_t) stuffed.size () + 13 ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static uint32_t randomWord (void) { // randomValue has 24 bits
+  return (randomValue () << 8) ^ randomValue () ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static CANMessage randomFrame (void) {
+  CANMessage frame ;
+  frame.ext = (randomValue () & 1) != 0 ;
+  frame.id = randomWord () & (frame.ext ? 0x1FFFFFFF : 0x7FF) ;
+  frame.rtr = (randomValue () % 8) == 0 ;
+  frame.len = randomValue () % 9 ;
+  frame.data32 [0] = randomWord () ;
+  frame.data32 [1] = randomWord () ;
+  if ((randomValue () % 4) == 0) { // Long runs
+    frame.data32 [0] = 0 ;
+    frame.data32 [1] = 0xFFFFFFFF ;
+  }
+  return frame ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  FRAME LENGTH
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void frameLength (void) {
+  cout << "Frame length" << endl ;
+//--- Worst case of 8 byte frames: 135 bits (standard), 160 bits (extended)
+  CANMessage frame ;
+  frame.len = 8 ;
+  check (ACANFrameLength::bitLength (frame, ACANFrameLength::WorstCaseStuffing) == 135, "worst case standard") ;
+  check (ACANFrameLength::bitLength (frame, ACANFrameLength::NoStuffing) == 111, "no stuffing standard") ;
+  frame.ext = true ;
+  check (ACANFrameLength::bitLength (frame, ACANFrameLength::WorstCaseStuffing) == 160, "worst case extended") ;
+  check (ACANFrameLength::bitLength (frame, ACANFrameLength::NoStuffing) == 131, "no stuffing extended") ;
+//--- Actual stuffing against the bit by bit reference
+  uint32_t minStuff = 1000 ;
+  uint32_t maxStuff = 0 ;
+  for (uint32_t i=0 ; i<200 * 1000 ; i++) {
+    frame = randomFrame () ;
+    const uint32_t actual = ACANFrameLength::bitLength (frame, ACANFrameLength::ActualStuffing) ;
+    const uint32_t nominal = ACANFrameLength::bitLength (frame, ACANFrameLength::NoStuffing) ;
+    check (actual == referenceBitLength (frame), "actual length differs from reference") ;
+    check (actual <= ACANFrameLength::bitLength (frame, ACANFrameLength::WorstCaseStuffing), "over worst case") ;
+    minStuff = min (minStuff, actual - nominal) ;
+    maxStuff = max (maxStuff, actual - nominal) ;
+  }
+  cout << "  200000 random frames match the reference, " << minStuff << " ... " << maxStuff << " stuff bits" << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  LOAD ON A VIRTUAL BUS
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+// A monitoring node records every frame it receives. Phase 1 (0 ... 3 s): one frame every 1 ms, phase 2 (3 ... 4 s):
+// saturated bus. The meter is compared with the bits really sent on the bus during each window.
+
+class Sample {
+  public: uint64_t mDate ;  // ns
+  public: uint32_t mBits ;
+  public: uint32_t mKey ;
+} ;
+
+static double expectedLoad (const vector <Sample> & inSamples, const uint64_t inNow, const uint64_t inWindow,
+                            const uint32_t inBitRate) {
+  const uint64_t start = (inNow > inWindow) ? (inNow - inWindow) : 0 ;
+  uint64_t bits = 0 ;
+  for (size_t i=0 ; i<inSamples.size () ; i++) {
+    if ((inSamples [i].mDate > start) && (inSamples [i].mDate <= inNow)) {
+      bits += inSamples [i].mBits ;
+    }
+  }
+  return (1000.0 * bits * 1.0e9) / ((double) inBitRate * (inNow - start)) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static CANMessage busFrame (void) { // 64 identifiers
+  CANMessage frame = randomFrame () ;
+  frame.id &= 0x1F ;
+  return frame ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void loadOnVirtualBus (const uint32_t inBitRate) {
+  cout << "Bus load at " << (inBitRate / 1000) << " kbit/s" << endl ;
+  static const uint64_t STEP = 100 * 1000 ;                       // 100 µs
+  static const uint64_t MS = 1000 * 1000 ;
+  VirtualCANBus bus (inBitRate) ;
+  VirtualCANNode generator (1000, 1) ;
+  VirtualCANNode monitor (16, 1000) ;
+  bus.attach (generator) ;
+  bus.attach (monitor) ;
+  ACANBusLoad meter ;
+  check (meter.begin (inBitRate, 48), "allocation") ;   // Less than the 64 identifiers
+  vector <Sample> samples ;
+  uint64_t now = 0 ;
+  uint64_t nextFrameDate = 0 ;
+  const uint64_t windows [3] = {100 * MS, 1000 * MS, 10000 * MS} ;
+  double maxError [3] = {0.0, 0.0, 0.0} ;
+  while (now < 4000 * MS) {
+    if (now < 3000 * MS) {
+      if (now >= nextFrameDate) {
+        generator.tryToSend (busFrame ()) ;
+        nextFrameDate += MS ;
+      }
+    }else{
+      while (generator.tryToSend (busFrame ())) {}
+    }
+    now += STEP ;
+    bus.runUntil (now) ;
+    CANMessage frame ;
+    while (monitor.receive (frame)) {
+      meter.recordFrame (frame, (uint32_t) (now / 1000)) ;
+      Sample s ;
+      s.mDate = now ;
+      s.mBits = VirtualCANBus::frameBitLength (frame) ;
+      s.mKey = frame.id | (frame.ext ? 0x80000000 : 0) ;
+      samples.push_back (s) ;
+    }
+  //--- Compare every 50 ms, after the first window is filled
+    if ((now % (50 * MS)) == 0) {
+      for (uint32_t w=0 ; w<3 ; w++) {
+        const uint16_t load = meter.loadPermille ((ACANBusLoad::Window) w, (uint32_t) (now / 1000)) ;
+        const double expected = expectedLoad (samples, now, windows [w], inBitRate) ;
+        if (now >= min (windows [w], (uint64_t) 3000 * MS)) {
+          const double error = (load > expected) ? (load - expected) : (expected - load) ;
+          maxError [w] = max (maxError [w], error) ;
+        }
+      }
+    }
+  }
+  const uint32_t nowMicros = (uint32_t) (now / 1000) ;
+  cout << "  " << samples.size () << " frames, load after saturation: 100 ms "
+       << meter.loadPermille (ACANBusLoad::Window100ms, nowMicros) << " ‰, 1 s "
+       << meter.loadPermille (ACANBusLoad::Window1s, nowMicros) << " ‰, 10 s "
+       << meter.loadPermille (ACANBusLoad::Window10s, nowMicros) << " ‰" << endl ;
+  cout << "  max deviation from the bits on the bus: 100 ms " << maxError [0] << " ‰, 1 s " << maxError [1]
+       << " ‰, 10 s " << maxError [2] << " ‰" << endl ;
+//--- The recorded bits are the bits on the bus
+  check (meter.frameCount () == bus.frameCount (), "frame count") ;
+  const uint64_t busBits = (bus.busyTime () * inBitRate + 500000000ULL) / 1000000000ULL ;
+  check ((meter.bitCount () + meter.frameCount () >= busBits) && (busBits + meter.frameCount () >= meter.bitCount ()),
+         "bit count differs from bus busy time") ;
+//--- Windows: bucket granularity is 1/10 of the window
+  check (meter.loadPermille (ACANBusLoad::Window100ms, nowMicros) >= 990, "saturated bus not seen") ;
+  check ((maxError [0] < 110.0) && (maxError [1] < 60.0) && (maxError [2] < 60.0), "window load error") ;
+//--- Per identifier: bits of the last complete second, seconds count from the first recorded frame
+  const uint64_t meterStart = samples [0].mDate ;
+  const uint64_t secondEnd = meterStart + ((now - meterStart) / (1000 * MS)) * 1000 * MS ;
+  uint32_t tracked = 0 ;
+  uint64_t expectedOther = 0 ;
+  for (size_t s=0 ; s<samples.size () ; s++) {
+    if ((samples [s].mDate >= secondEnd - 1000 * MS) && (samples [s].mDate < secondEnd)) {
+      expectedOther += samples [s].mBits ;
+    }
+  }
+  for (uint16_t i=0 ; i<meter.identifierCount () ; i++) {
+    const ACANBusLoadIdentifier & entry = meter.identifierAtIndex (i) ;
+    check (entry.mFrameCount > 0, "identifier entry without frame") ;
+    tracked += entry.mFrameCount ;
+    uint64_t expected = 0 ;
+    for (size_t s=0 ; s<samples.size () ; s++) {
+      if ((samples [s].mKey == entry.mKey) && (samples [s].mDate >= secondEnd - 1000 * MS) && (samples [s].mDate < secondEnd)) {
+        expected += samples [s].mBits ;
+      }
+    }
+    expectedOther -= expected ;
+    check (meter.identifierLoadPermille (i, nowMicros) == (expected * 1000) / inBitRate, "identifier load") ;
+  }
+  check (tracked + meter.untrackedFrameCount () == meter.frameCount (), "identifier frame count") ;
+  check (meter.otherLoadPermille (nowMicros) == (expectedOther * 1000) / inBitRate, "other identifiers load") ;
+  check ((meter.identifierCount () == 48) && (meter.untrackedFrameCount () > 0), "identifier capacity") ;
+  cout << "  " << meter.identifierCount () << " identifiers tracked, " << meter.untrackedFrameCount ()
+       << " frames untracked" << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  COST PER FRAME
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void costPerFrame (const ACANFrameLength::Stuffing inStuffing, const char * inName) {
+  static const uint32_t FRAME_COUNT = 4096 ;
+  static const uint32_t ROUNDS = 500 ;
+  vector <CANMessage> frames ;
+  for (uint32_t i=0 ; i<FRAME_COUNT ; i++) {
+    CANMessage frame = randomFrame () ;
+    frame.id &= 0x3F ; // 64 identifiers
+    frames.push_back (frame) ;
+  }
+  ACANBusLoad meter ;
+  meter.begin (1000 * 1000, 128, inStuffing) ;
+  const auto start = chrono::steady_clock::now () ;
+  uint32_t date = 0 ;
+  for (uint32_t r=0 ; r<ROUNDS ; r++) {
+    for (uint32_t i=0 ; i<FRAME_COUNT ; i++) {
+      date += 130 ;
+      meter.recordFrame (frames [i], date) ;
+    }
+  }
+  const double seconds = chrono::duration <double> (chrono::steady_clock::now () - start).count () ;
+  cout << "  " << inName << ": " << (seconds * 1.0e9 / (FRAME_COUNT * ROUNDS)) << " ns per frame ("
+       << meter.loadPermille (ACANBusLoad::Window1s, date) << " ‰)" << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+int main (int /* argc */, const char * /* argv */ []) {
+  frameLength () ;
+  loadOnVirtualBus (500 * 1000) ;
+  loadOnVirtualBus (1000 * 1000) ;
+  cout << "Cost of recordFrame on host" << endl ;
+  costPerFrame (ACANFrameLength::ActualStuffing, "actual stuffing") ;
+  costPerFrame (ACANFrameLength::WorstCaseStuffing, "worst case stuffing") ;
+  cout << "All bus load tests Ok" << endl ;
+  return 0 ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
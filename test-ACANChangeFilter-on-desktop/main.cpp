@@ -0,0 +1,302 @@
+/******************************************************************************/
+/* File name        : main.cpp                                                */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Compiler         : Desktop C++ COMPILER (Visual Studio Code)               */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation: payload change detection                              */
+/* ---------------------------------------------------------------------------*/
+
+// Usage: main [recorded traffic]  (default: ../test-ACANJ1939-on-desktop/recorded-traffic.log, candump format)
+
+/*------------------------------- Include files ------------------------------*/
+#include <iostream>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <map>
+#include <vector>
+#include <stdlib.h>
+#include "../src/ACANChangeFilter.h"
+#include "../src/ACANSignalCodec.h"
+#include "../simulation-on-desktop/DesktopTest.h"
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+using namespace std;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static CANMessage dataFrame (const uint32_t inIdentifier, const bool inExtended, const uint8_t inLength, const uint64_t inData) {
+  CANMessage frame ;
+  frame.id = inIdentifier ;
+  frame.ext = inExtended ;
+  frame.len = inLength ;
+  frame.data64 = inData ;
+  return frame ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Payload comparison
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void payloadComparison (void) {
+  cout << "Payload comparison" << endl ;
+  ACANChangeFilter filter ;
+  check (filter.begin (16), "cannot allocate") ;
+  check (filter.deliver (dataFrame (0x123, false, 8, 0x1122334455667788ULL), 0), "first frame suppressed") ;
+  check (!filter.deliver (dataFrame (0x123, false, 8, 0x1122334455667788ULL), 0), "same payload delivered") ;
+  check (filter.deliver (dataFrame (0x123, false, 8, 0x1122334455667789ULL), 0), "changed data suppressed") ;
+  check (filter.deliver (dataFrame (0x123, false, 7, 0x1122334455667789ULL), 0), "changed length suppressed") ;
+  check (!filter.deliver (dataFrame (0x123, false, 7, 0xFF22334455667789ULL), 0), "byte beyond the length compared") ;
+  check (filter.deliver (dataFrame (0x123, true, 7, 0x0022334455667789ULL), 0), "extended frame with a standard slot") ;
+  check (!filter.deliver (dataFrame (0x123, true, 7, 0x0022334455667789ULL), 0), "extended: same payload delivered") ;
+  check (filter.deliver (dataFrame (0x7FF, false, 0, 0), 0), "empty frame: first frame suppressed") ;
+  check (!filter.deliver (dataFrame (0x7FF, false, 0, 0xFF), 0), "empty frame: data compared") ;
+  CANMessage remote = dataFrame (0x123, false, 8, 0x1122334455667789ULL) ;
+  remote.rtr = true ;
+  check (filter.deliver (remote, 0) && filter.deliver (remote, 0), "remote frame suppressed") ;
+  check (filter.frameCount () == 11, "frame count") ;
+  check (filter.suppressedCount () == 4, "suppressed count") ;
+  check (filter.changedCount () == 5, "changed count") ;
+  check (filter.untrackedCount () == 2, "untracked count") ;
+  check (filter.trackedIdentifierCount () == 3, "tracked identifier count") ;
+  filter.reset () ;
+  check (filter.deliver (dataFrame (0x123, false, 7, 0x1122334455667789ULL), 0), "reset: first frame suppressed") ;
+  check (filter.frameCount () == 1, "reset: counters") ;
+  cout << "  Ok" << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Forced delivery: every N frames, after T ms
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void forcedDelivery (void) {
+  cout << "Forced delivery" << endl ;
+  ACANChangeFilter filter ;
+  check (filter.begin (4, ACANChangeFilter::Suppress, 5, 0), "cannot allocate") ;
+  for (uint32_t i=0 ; i<100 ; i++) {
+    const bool delivered = filter.deliver (dataFrame (0x18FEF100, true, 8, 42), i) ;
+    check (delivered == ((i % 5) == 0), "every 5 frames") ;
+  }
+  check (filter.forcedCount () == 19, "every 5 frames: forced count") ;
+  check (filter.begin (4, ACANChangeFilter::Suppress, 0, 100), "cannot allocate") ;
+  uint32_t lastDelivery = 0 ;
+  for (uint32_t date=0 ; date<1000 ; date+=30) {
+    const bool delivered = filter.deliver (dataFrame (0x100, false, 2, 7), date) ;
+    check (delivered == ((date == 0) || ((date - lastDelivery) >= 100)), "every 100 ms") ;
+    if (delivered) {
+      lastDelivery = date ;
+    }
+  }
+  check (filter.begin (4, ACANChangeFilter::Suppress, 3, 100), "cannot allocate") ;
+  check (filter.deliver (dataFrame (0x100, false, 2, 7), 0), "both: first frame") ;
+  check (!filter.deliver (dataFrame (0x100, false, 2, 7), 99), "both: suppressed") ;
+  check (filter.deliver (dataFrame (0x100, false, 2, 7), 100), "both: after 100 ms") ;
+  check (!filter.deliver (dataFrame (0x100, false, 2, 7), 101), "both: suppressed after forced delivery") ;
+  check (!filter.deliver (dataFrame (0x100, false, 2, 7), 102), "both: suppressed") ;
+  check (filter.deliver (dataFrame (0x100, false, 2, 7), 103), "both: third frame") ;
+  cout << "  Ok" << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Random traffic against a reference model (map), with a full pool; CountOnly counts what Suppress suppresses
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+class ReferenceSlot {
+  public: uint64_t mData ;
+  public: uint8_t mLength ;
+  public: uint32_t mSuppressed ;
+} ;
+
+static void againstReference (const uint16_t inCapacity) {
+  cout << "Random traffic against a reference, capacity " << inCapacity << endl ;
+  vector <uint32_t> keys ;
+  for (uint32_t i=0 ; i<300 ; i++) {
+    keys.push_back (randomValue () & 0x7FF) ;
+  }
+  for (uint32_t i=0 ; i<700 ; i++) {
+    keys.push_back ((randomValue () & 0x1FFFFFFF) | 0x80000000) ;
+  }
+  ACANChangeFilter filter ;
+  ACANChangeFilter countOnly ;
+  check (filter.begin (inCapacity, ACANChangeFilter::Suppress, 10, 0), "cannot allocate") ;
+  check (countOnly.begin (inCapacity, ACANChangeFilter::CountOnly, 10, 0), "cannot allocate") ;
+  map <uint32_t, ReferenceSlot> reference ;
+  uint32_t untracked = 0 ;
+  for (uint32_t i=0 ; i<1000000 ; i++) {
+    const uint32_t key = keys [randomValue () % keys.size ()] ;
+    const uint8_t length = uint8_t (1 + (key % 8)) ;
+    const uint64_t data = ((randomValue () % 4) == 0) ? randomValue () % 3 : 0 ; // Mostly unchanged
+    const CANMessage frame = dataFrame (key & 0x1FFFFFFF, (key & 0x80000000) != 0, length, data | (0xA5ULL << 56)) ;
+    bool expected = true ;
+    auto slot = reference.find (key) ;
+    if ((slot == reference.end ()) && (reference.size () < inCapacity)) {
+      reference [key] = ReferenceSlot {data, length, 0} ;
+    }else if (slot == reference.end ()) {
+      untracked += 1 ;
+    }else if (slot->second.mData != data) {
+      slot->second.mData = data ;
+      slot->second.mSuppressed = 0 ;
+    }else if ((slot->second.mSuppressed + 1) >= 10) {
+      slot->second.mSuppressed = 0 ;
+    }else{
+      slot->second.mSuppressed += 1 ;
+      expected = false ;
+    }
+    check (filter.deliver (frame, i) == expected, "differs from the reference") ;
+    check (countOnly.deliver (frame, i), "CountOnly mode: frame not delivered") ;
+  }
+  check (filter.untrackedCount () == untracked, "untracked count") ;
+  check (filter.trackedIdentifierCount () == reference.size (), "tracked identifier count") ;
+  check (countOnly.suppressedCount () == filter.suppressedCount (), "CountOnly suppressed count") ;
+  check (countOnly.forcedCount () == filter.forcedCount (), "CountOnly forced count") ;
+  cout << "  " << filter.trackedIdentifierCount () << " identifiers tracked, " << untracked << " frames untracked, "
+       << (filter.suppressedCount () / 10000.0) << " % suppressed" << endl ;
+  cout << "  Ok" << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Traffic: recorded (J1939, candump format), and synthetic standard identifier cyclic traffic (10 s): 40 messages,
+//  10 ms ... 1 s periods; constant payloads, slow signals (a change every 2 ... 50 frames), counters
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+class TimedFrame {
+  public: uint32_t mDate ; // ms
+  public: CANMessage mFrame ;
+} ;
+
+static vector <TimedFrame> readRecording (const char * inPath) {
+  vector <TimedFrame> result ;
+  ifstream file (inPath) ;
+  check (file.good (), "cannot open recorded traffic") ;
+  string line ;
+  while (getline (file, line)) {
+    if ((line.size () > 0) && (line [0] == '(')) {
+      TimedFrame f ;
+      const size_t close = line.find (')') ;
+      f.mDate = (uint32_t) (strtod (line.c_str () + 1, NULL) * 1000.0 + 0.5) ;
+      istringstream fields (line.substr (close + 1)) ;
+      string itf, frame ;
+      fields >> itf >> frame ;
+      const size_t hash = frame.find ('#') ;
+      f.mFrame.id = (uint32_t) strtoul (frame.substr (0, hash).c_str (), NULL, 16) ;
+      f.mFrame.ext = hash > 3 ;
+      const string data = frame.substr (hash + 1) ;
+      f.mFrame.len = (uint8_t) (data.size () / 2) ;
+      for (uint8_t i=0 ; i<f.mFrame.len ; i++) {
+        f.mFrame.data [i] = (uint8_t) strtoul (data.substr (2 * i, 2).c_str (), NULL, 16) ;
+      }
+      result.push_back (f) ;
+    }
+  }
+  return result ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static vector <TimedFrame> syntheticTraffic (void) {
+  static const uint32_t kPeriods [] = {10, 20, 50, 100, 200, 500, 1000} ;
+  vector <TimedFrame> result ;
+  for (uint32_t m=0 ; m<40 ; m++) {
+    const uint32_t period = kPeriods [randomValue () % 7] ;
+    const uint32_t kind = randomValue () % 4 ; // 0, 1: constant, 2: slow signal, 3: counter
+    const uint32_t changeEvery = 2 + randomValue () % 49 ;
+    TimedFrame f ;
+    f.mFrame.id = 0x100 + m * 8 ;
+    f.mFrame.len = 8 ;
+    f.mFrame.data64 = (uint64_t (randomValue ()) << 32) | randomValue () ;
+    uint32_t n = 0 ;
+    for (uint32_t date=randomValue () % period ; date<10000 ; date+=period) {
+      if ((kind == 3) || ((kind == 2) && ((n % changeEvery) == 0))) {
+        f.mFrame.data [0] += 1 ;
+      }
+      f.mDate = date ;
+      result.push_back (f) ;
+      n += 1 ;
+    }
+  }
+  sort (result.begin (), result.end (), [] (const TimedFrame & a, const TimedFrame & b) { return a.mDate < b.mDate ; }) ;
+  return result ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Application decode: 8 signals of 8 bits, scaled (stands for a generated decoder)
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static volatile float gSink ;
+
+static void decode (const CANMessage & inFrame) {
+  const uint64_t word = ACANSignalCodec::intelWord (inFrame) ;
+  float sum = 0.0f ;
+  for (uint32_t s=0 ; s<8 ; s++) {
+    sum += float (ACANSignalCodec::extract (word, s * 8, 8)) * 0.5f - 40.0f ;
+  }
+  gSink = sum ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static double nanosecondsPerFrame (const vector <TimedFrame> & inTraffic, ACANChangeFilter * inFilter) {
+  const uint32_t kPasses = 200 ;
+  const auto start = chrono::steady_clock::now () ;
+  for (uint32_t p=0 ; p<kPasses ; p++) {
+    if (inFilter != nullptr) {
+      inFilter->reset () ;
+    }
+    for (size_t i=0 ; i<inTraffic.size () ; i++) {
+      const TimedFrame & f = inTraffic [i] ;
+      if ((inFilter == nullptr) || inFilter->deliver (f.mFrame, f.mDate)) {
+        decode (f.mFrame) ;
+      }
+    }
+  }
+  const double ns = chrono::duration <double, nano> (chrono::steady_clock::now () - start).count () ;
+  return ns / (double (kPasses) * inTraffic.size ()) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void decodeWorkSaved (const char * inTitle, const vector <TimedFrame> & inTraffic) {
+  cout << "Decode work saved, " << inTitle << ", " << inTraffic.size () << " frames" << endl ;
+  check (inTraffic.size () > 0, "no traffic") ;
+  ACANChangeFilter filter ;
+  check (filter.begin (256, ACANChangeFilter::Suppress, 0, 1000), "cannot allocate") ;
+  uint32_t delivered = 0 ;
+  for (size_t i=0 ; i<inTraffic.size () ; i++) {
+    delivered += filter.deliver (inTraffic [i].mFrame, inTraffic [i].mDate) ;
+  }
+  check (delivered == filter.deliveredCount (), "delivered count") ;
+  check (filter.untrackedCount () == 0, "untracked frames") ;
+  const double without = nanosecondsPerFrame (inTraffic, nullptr) ;
+  const double with = nanosecondsPerFrame (inTraffic, &filter) ;
+  cout << "  " << filter.trackedIdentifierCount () << " identifiers, " << delivered << " frames decoded ("
+       << (filter.forcedCount ()) << " forced, every 1 s), "
+       << (100.0 * filter.suppressedCount () / inTraffic.size ()) << " % suppressed" << endl ;
+  cout << "  decode all: " << without << " ns per frame, change filter + decode: " << with << " ns per frame" << endl ;
+  cout << "  Ok" << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+int main (int argc, const char * argv []) {
+  payloadComparison () ;
+  forcedDelivery () ;
+  againstReference (1000) ;
+  againstReference (500) ;
+  const char * path = (argc > 1) ? argv [1] : "../test-ACANJ1939-on-desktop/recorded-traffic.log" ;
+  decodeWorkSaved ("recorded J1939 traffic", readRecording (path)) ;
+  decodeWorkSaved ("synthetic cyclic traffic", syntheticTraffic ()) ;
+  cout << "All change filter tests Ok" << endl ;
+  return 0 ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
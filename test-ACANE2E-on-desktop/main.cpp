@@ -0,0 +1,403 @@
+/******************************************************************************/
+/* File name        : main.cpp                                                */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Compiler         : Desktop C++ COMPILER (Visual Studio Code)               */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation: E2E profiles and slice-by-4 CRC                       */
+/* ---------------------------------------------------------------------------*/
+
+/*------------------------------- Include files ------------------------------*/
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <stdlib.h>
+#include "../src/ACANE2E.cpp"
+#include "../simulation-on-desktop/VirtualCANBus.cpp"
+#include "../simulation-on-desktop/DesktopTest.h"
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+using namespace std;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   Bit by bit references
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static uint8_t bitwiseCRC8 (const uint8_t * inData, const uint32_t inLength, const uint8_t inPolynomial, uint8_t inCRC) {
+  for (uint32_t i=0 ; i<inLength ; i++) {
+    inCRC ^= inData [i] ;
+    for (uint8_t bit=0 ; bit<8 ; bit++) {
+      inCRC = (inCRC & 0x80) ? (uint8_t) ((inCRC << 1) ^ inPolynomial) : (uint8_t) (inCRC << 1) ;
+    }
+  }
+  return inCRC ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static uint16_t bitwiseCRC16 (const uint8_t * inData, const uint32_t inLength, uint16_t inCRC) {
+  for (uint32_t i=0 ; i<inLength ; i++) {
+    inCRC ^= (uint16_t) (inData [i] << 8) ;
+    for (uint8_t bit=0 ; bit<8 ; bit++) {
+      inCRC = (inCRC & 0x8000) ? (uint16_t) ((inCRC << 1) ^ 0x1021) : (uint16_t) (inCRC << 1) ;
+    }
+  }
+  return inCRC ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   Byte at a time, one table (for the benchmark)
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static uint16_t gByteTable16 [256] ;
+
+static uint16_t bytewiseCRC16 (const uint8_t * inData, const uint32_t inLength, uint16_t inCRC) {
+  for (uint32_t i=0 ; i<inLength ; i++) {
+    inCRC = (uint16_t) ((inCRC << 8) ^ gByteTable16 [inData [i] ^ (inCRC >> 8)]) ;
+  }
+  return inCRC ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   CRC
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void testCRC (void) {
+  cout << "CRC against bit by bit references" << endl ;
+  ACANCRC::begin () ;
+  const uint8_t checkString [9] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'} ;
+  check ((ACANCRC::crc8SAEJ1850 (checkString, 9, 0xFF) ^ 0xFF) == 0x4B, "CRC-8 SAE J1850 check value") ;
+  check ((ACANCRC::crc8H2F (checkString, 9, 0xFF) ^ 0xFF) == 0xDF, "CRC8H2F check value") ;
+  check (ACANCRC::crc16CCITT (checkString, 9, 0xFFFF) == 0x29B1, "CRC-16 CCITT check value") ;
+  uint8_t buffer [64] ;
+  for (uint32_t n=0 ; n<100000 ; n++) {
+    const uint32_t length = randomValue () % 65 ;
+    for (uint32_t i=0 ; i<length ; i++) {
+      buffer [i] = (uint8_t) randomValue () ;
+    }
+    const uint8_t start8 = (uint8_t) randomValue () ;
+    const uint16_t start16 = (uint16_t) randomValue () ;
+    check (ACANCRC::crc8SAEJ1850 (buffer, length, start8) == bitwiseCRC8 (buffer, length, 0x1D, start8), "CRC-8 SAE J1850") ;
+    check (ACANCRC::crc8H2F (buffer, length, start8) == bitwiseCRC8 (buffer, length, 0x2F, start8), "CRC8H2F") ;
+    check (ACANCRC::crc16CCITT (buffer, length, start16) == bitwiseCRC16 (buffer, length, start16), "CRC-16 CCITT") ;
+  //--- Chained calls
+    const uint32_t split = (length == 0) ? 0 : (randomValue () % length) ;
+    check (ACANCRC::crc16CCITT (buffer + split, length - split, ACANCRC::crc16CCITT (buffer, split, start16))
+           == bitwiseCRC16 (buffer, length, start16), "chained CRC-16") ;
+  }
+  cout << "  Ok" << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   PROFILES
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static const uint8_t kDataIDList [16] = {
+  0x10, 0x21, 0x32, 0x43, 0x54, 0x65, 0x76, 0x87, 0x98, 0xA9, 0xBA, 0xCB, 0xDC, 0xED, 0xFE, 0x0F
+} ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void testProfileLayouts (void) {
+  cout << "Profile layouts" << endl ;
+  ACANE2EChannel channels [3] ;
+  channels [0].mIdentifier = 0x300 ;
+  channels [0].mProfile = ACANE2EChannel::kProfile05 ;
+  channels [0].mDataID = 0x1234 ;
+  channels [1].mIdentifier = 0x100 ;
+  channels [1].mProfile = ACANE2EChannel::kProfile01 ;
+  channels [1].mDataID = 0x123 ;
+  channels [2].mIdentifier = 0x200 ;
+  channels [2].mProfile = ACANE2EChannel::kProfile02 ;
+  channels [2].mDataIDList = kDataIDList ;
+  ACANE2E e2e ;
+  check (e2e.begin (channels, 3) == 0, "begin") ;
+  check (e2e.channelIndex (0x100, false) == 0, "sorted channels") ;
+  check (e2e.channelIndex (0x100, true) == ACANE2E::kNoChannel, "extended identifier") ;
+//--- Profile 1, data identifier 0x123 (both bytes), zero data: CRC 0xCC with counter 0, 0x91 with counter 1
+  CANMessage frame ;
+  frame.id = 0x100 ;
+  check (e2e.protect (frame) == 0, "profile 1 channel") ;
+  check ((frame.len == 8) && (frame.data [0] == 0xCC) && (frame.data [1] == 0x00), "profile 1, counter 0") ;
+  e2e.advanceCounter (0) ;
+  frame.data64 = 0 ;
+  e2e.protect (frame) ;
+  check ((frame.data [0] == 0x91) && (frame.data [1] == 0x01), "profile 1, counter 1") ;
+//--- Profile 2: CRC8H2F over bytes 1 ... 7 and the data identifier of the counter
+  for (uint8_t counter=0 ; counter<16 ; counter++) {
+    frame.id = 0x200 ;
+    for (uint8_t i=0 ; i<8 ; i++) {
+      frame.data [i] = (uint8_t) randomValue () ;
+    }
+    e2e.protect (frame) ;
+    check ((frame.data [1] & 0x0F) == counter, "profile 2 counter") ;
+    uint8_t crc = bitwiseCRC8 (&frame.data [1], 7, 0x2F, 0xFF) ;
+    crc = bitwiseCRC8 (&kDataIDList [counter], 1, 0x2F, crc) ^ 0xFF ;
+    check (frame.data [0] == crc, "profile 2 CRC") ;
+    e2e.advanceCounter (1) ;
+  }
+  check (e2e.channel (1).mSendCounter == 0, "profile 2 counter wraps at 16") ;
+//--- Profile 5, data identifier 0x1234, zero data: CRC 0xCA1C, little endian, counter in byte 2
+  frame.id = 0x300 ;
+  frame.data64 = 0 ;
+  e2e.protect (frame) ;
+  check ((frame.data [0] == 0x1C) && (frame.data [1] == 0xCA) && (frame.data [2] == 0), "profile 5, counter 0") ;
+  for (uint32_t i=0 ; i<256 ; i++) {
+    e2e.advanceCounter (2) ;
+  }
+  check (e2e.channel (2).mSendCounter == 0, "profile 5 counter wraps at 256") ;
+//--- Profile 1 counter wraps at 15
+  for (uint32_t i=0 ; i<14 ; i++) {
+    e2e.advanceCounter (0) ;
+  }
+  check (e2e.channel (0).mSendCounter == 0, "profile 1 counter wraps at 15") ;
+//--- Unprotected frames are unchanged
+  frame.id = 0x400 ;
+  frame.len = 3 ;
+  frame.data64 = 0x1122334455667788ULL ;
+  check (e2e.protect (frame) == ACANE2E::kNoChannel, "unprotected") ;
+  check ((frame.len == 3) && (frame.data64 == 0x1122334455667788ULL), "unprotected frame changed") ;
+//--- Configuration errors
+  ACANE2EChannel bad [2] ;
+  bad [0].mIdentifier = 0x10 ;
+  bad [1].mIdentifier = 0x10 ;
+  bad [1].mProfile = ACANE2EChannel::kProfile02 ;
+  bad [1].mLength = 9 ;
+  ACANE2EStateMachineSettings settings ;
+  settings.mWindowSize = 33 ;
+  const uint32_t errorCode = e2e.begin (bad, 2, settings) ;
+  check (errorCode == (ACANE2E::kDuplicateIdentifier | ACANE2E::kInvalidLength | ACANE2E::kNoDataIDList
+                       | ACANE2E::kInvalidWindowSize), "error codes") ;
+  cout << "  Ok" << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   SEQUENCE CHECKS AND STATE MACHINE
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void testSequenceAndStateMachine (const ACANE2EChannel::Profile inProfile) {
+  cout << "Sequence and state machine, profile " << ((inProfile == ACANE2EChannel::kProfile01) ? 1 : (inProfile == ACANE2EChannel::kProfile02) ? 2 : 5) << endl ;
+  ACANE2EChannel txChannel ;
+  txChannel.mIdentifier = 0x123 ;
+  txChannel.mProfile = inProfile ;
+  txChannel.mDataID = 0xBEEF ;
+  txChannel.mDataIDList = kDataIDList ;
+  txChannel.mMaxDeltaCounter = 3 ;
+  ACANE2EChannel rxChannel = txChannel ;
+  ACANE2E tx ;
+  ACANE2E rx ;
+  check (tx.begin (&txChannel, 1) == 0, "tx begin") ;
+  check (rx.begin (&rxChannel, 1) == 0, "rx begin") ;
+  CANMessage frame ;
+  frame.id = 0x123 ;
+  uint16_t index ;
+  const bool counterChecked = inProfile == ACANE2EChannel::kProfile05 ;
+//--- First frames: profiles 1 and 2 accept the first counter (initial); NoData -> Init, then Valid after 2 ok
+  tx.protect (frame) ; tx.advanceCounter (0) ;
+  check (rx.check (frame, index) == (counterChecked ? kE2EOk : kE2EInitial), "first frame") ;
+  check (rxChannel.mState == kE2EStateInit, "init") ;
+  for (uint8_t i=0 ; i<2 ; i++) {
+    tx.protect (frame) ; tx.advanceCounter (0) ;
+    check (rx.check (frame, index) == kE2EOk, "next frames") ;
+  }
+  check (rxChannel.mState == kE2EStateValid, "valid") ;
+//--- Repeated, lost frames, wrong sequence
+  check (rx.check (frame, index) == kE2ERepeated, "repeated") ;
+  tx.advanceCounter (0) ;
+  tx.advanceCounter (0) ;
+  tx.protect (frame) ; tx.advanceCounter (0) ;
+  check (rx.check (frame, index) == kE2EOkSomeLost, "some lost") ;
+  check (rxChannel.mLostCount == 2, "lost count") ;
+  for (uint8_t i=0 ; i<4 ; i++) {
+    tx.advanceCounter (0) ;
+  }
+  tx.protect (frame) ; tx.advanceCounter (0) ;
+  check (rx.check (frame, index) == kE2EWrongSequence, "wrong sequence") ;
+  tx.protect (frame) ; tx.advanceCounter (0) ;
+  check (rx.check (frame, index) == kE2EOk, "resynchronised") ;
+//--- Missing cycles widen the accepted delta
+  for (uint8_t i=0 ; i<5 ; i++) {
+    tx.advanceCounter (0) ;
+    rx.noNewData (0) ;
+  }
+  check (rxChannel.mStatus == kE2ENoNewData, "no new data") ;
+  tx.protect (frame) ; tx.advanceCounter (0) ;
+  check (rx.check (frame, index) == kE2EOkSomeLost, "lost during missing cycles") ;
+  check (rxChannel.mAllowedDelta == 3, "allowed delta restored") ;
+  check (rxChannel.mState == kE2EStateInvalid, "no ok status in the window") ;
+  tx.protect (frame) ; tx.advanceCounter (0) ;
+  check (rx.check (frame, index) == kE2EOk, "ok after missing cycles") ;
+//--- Two corrupted frames in the window: Valid -> Invalid; back to Valid when the errors leave the window
+  check (rxChannel.mState == kE2EStateValid, "valid before errors") ;
+  tx.protect (frame) ; tx.advanceCounter (0) ;
+  frame.data [5] ^= 0x10 ;
+  check (rx.check (frame, index) == kE2EWrongCRC, "wrong CRC") ;
+  check (rxChannel.mState == kE2EStateValid, "one error is tolerated") ;
+  tx.protect (frame) ; tx.advanceCounter (0) ;
+  frame.len = 7 ;
+  check (rx.check (frame, index) == kE2EWrongLength, "wrong length") ;
+  check (rxChannel.mState == kE2EStateInvalid, "invalid") ;
+  check (rxChannel.mErrorCount == 2, "error count") ;
+  frame.len = 8 ;
+  for (uint8_t i=0 ; i<2 ; i++) {
+    tx.protect (frame) ; tx.advanceCounter (0) ;
+    check (rx.check (frame, index) == (i == 0 ? kE2EOkSomeLost : kE2EOk), "ok after errors") ;
+    check (rxChannel.mState == kE2EStateInvalid, "still invalid") ;
+  }
+  tx.protect (frame) ; tx.advanceCounter (0) ;
+  rx.check (frame, index) ;
+  check (rxChannel.mState == kE2EStateValid, "valid again") ;
+//--- Every single bit error of a protected frame is detected
+  tx.protect (frame) ;
+  for (uint32_t bit=0 ; bit<64 ; bit++) {
+    CANMessage corrupted = frame ;
+    corrupted.data64 ^= 1ULL << bit ;
+    check (rx.check (corrupted, index) == kE2EWrongCRC, "single bit error not detected") ;
+  }
+  cout << "  Ok" << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   INLINE WITH tryToSend / receive ON THE VIRTUAL BUS
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void testOnVirtualBus (void) {
+  cout << "Inline with tryToSend and receive on the virtual bus" << endl ;
+  VirtualCANBus bus (500 * 1000) ;
+  VirtualCANNode sender (2) ;
+  VirtualCANNode receiver ;
+  bus.attach (sender) ;
+  bus.attach (receiver) ;
+  ACANE2EChannel txChannels [2] ;
+  txChannels [0].mIdentifier = 0x18FF0010 ;
+  txChannels [0].mExtended = true ;
+  txChannels [0].mDataID = 0x0010 ;
+  txChannels [1].mIdentifier = 0x080 ;
+  txChannels [1].mProfile = ACANE2EChannel::kProfile01 ;
+  txChannels [1].mDataID = 0x0080 ;
+  txChannels [1].mDataIDMode = ACANE2EChannel::kDataIDAlternating ;
+  ACANE2EChannel rxChannels [2] = {txChannels [0], txChannels [1]} ;
+  ACANE2E tx ;
+  ACANE2E rx ;
+  check (tx.begin (txChannels, 2) == 0, "tx begin") ;
+  check (rx.begin (rxChannels, 2) == 0, "rx begin") ;
+  uint32_t okCount = 0 ;
+  uint32_t unprotectedCount = 0 ;
+  uint32_t refusedCount = 0 ;
+  uint64_t date = 0 ;
+  for (uint32_t n=0 ; n<3000 ; n++) {
+    CANMessage frame ;
+    const uint32_t kind = n % 3 ;
+    frame.id = (kind == 0) ? 0x18FF0010 : ((kind == 1) ? 0x080 : 0x7FF) ;
+    frame.ext = kind == 0 ;
+    frame.len = 8 ;
+    frame.data32 [1] = randomValue () ;
+    if (!tx.tryToSend (sender, frame)) { // Faster than the bus: the counter does not advance on refused frames
+      refusedCount += 1 ;
+    }
+    date += 150 * 1000 ;
+    bus.runUntil (date) ;
+    CANMessage received ;
+    uint16_t index ;
+    ACANE2EStatus status ;
+    while (rx.receive (receiver, received, index, status)) {
+      if (index == ACANE2E::kNoChannel) {
+        unprotectedCount += 1 ;
+      }else{
+        check ((status == kE2EOk) || (status == kE2EInitial), "status on the bus") ;
+        okCount += 1 ;
+      }
+    }
+  }
+  cout << "  " << okCount << " protected frames ok, " << unprotectedCount << " unprotected, "
+       << refusedCount << " refused by the driver" << endl ;
+  check (rxChannels [0].mState == kE2EStateValid, "channel 0 valid") ;
+  check (rxChannels [1].mState == kE2EStateValid, "channel 1 valid") ;
+  check ((unprotectedCount > 0) && (refusedCount > 0) && (okCount > 1000), "frame counts") ;
+  cout << "  Ok" << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   BENCHMARK
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void benchmark (void) {
+  cout << "CRC-16 CCITT throughput (host)" << endl ;
+  for (uint32_t b=0 ; b<256 ; b++) {
+    const uint8_t byte = (uint8_t) b ;
+    gByteTable16 [b] = bitwiseCRC16 (&byte, 1, 0) ;
+  }
+  vector <uint8_t> buffer (1 << 20) ;
+  for (size_t i=0 ; i<buffer.size () ; i++) {
+    buffer [i] = (uint8_t) randomValue () ;
+  }
+  const uint32_t rounds = 20 ;
+  uint16_t results [3] = {0, 0, 0} ;
+  double mbPerSecond [3] ;
+  for (uint32_t method=0 ; method<3 ; method++) {
+    const auto start = chrono::steady_clock::now () ;
+    for (uint32_t r=0 ; r<((method == 0) ? 2 : rounds) ; r++) {
+      uint16_t crc = 0xFFFF ;
+      switch (method) {
+      case 0 : crc = bitwiseCRC16 (buffer.data (), (uint32_t) buffer.size (), crc) ; break ;
+      case 1 : crc = bytewiseCRC16 (buffer.data (), (uint32_t) buffer.size (), crc) ; break ;
+      default : crc = ACANCRC::crc16CCITT (buffer.data (), (uint32_t) buffer.size (), crc) ; break ;
+      }
+      results [method] ^= crc ;
+    }
+    const double seconds = chrono::duration <double> (chrono::steady_clock::now () - start).count () ;
+    mbPerSecond [method] = (double) buffer.size () * ((method == 0) ? 2 : rounds) / seconds / 1.0e6 ;
+  }
+  check (results [1] == results [2], "benchmark results differ") ;
+  cout << "  bit by bit   : " << (int) mbPerSecond [0] << " MB/s" << endl ;
+  cout << "  byte table   : " << (int) mbPerSecond [1] << " MB/s" << endl ;
+  cout << "  slice-by-4   : " << (int) mbPerSecond [2] << " MB/s" << endl ;
+//--- Protect + check of 8-byte frames
+  ACANE2EChannel txChannel ;
+  txChannel.mIdentifier = 0x100 ;
+  ACANE2EChannel rxChannel = txChannel ;
+  ACANE2E tx ;
+  ACANE2E rx ;
+  tx.begin (&txChannel, 1) ;
+  rx.begin (&rxChannel, 1) ;
+  CANMessage frame ;
+  frame.id = 0x100 ;
+  const uint32_t frameCount = 1000 * 1000 ;
+  uint32_t okCount = 0 ;
+  const auto start = chrono::steady_clock::now () ;
+  for (uint32_t n=0 ; n<frameCount ; n++) {
+    frame.data32 [1] = n ;
+    tx.protect (frame) ;
+    tx.advanceCounter (0) ;
+    uint16_t index ;
+    okCount += rx.check (frame, index) == kE2EOk ;
+  }
+  const double seconds = chrono::duration <double> (chrono::steady_clock::now () - start).count () ;
+  check (okCount == frameCount, "benchmark frames") ;
+  cout << "  profile 5 protect + check: " << (int) (seconds * 1.0e9 / frameCount) << " ns per frame" << endl ;
+  cout << "  Ok" << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+int main (int /* argc */, const char * /* argv */ []) {
+  testCRC () ;
+  testProfileLayouts () ;
+  testSequenceAndStateMachine (ACANE2EChannel::kProfile01) ;
+  testSequenceAndStateMachine (ACANE2EChannel::kProfile02) ;
+  testSequenceAndStateMachine (ACANE2EChannel::kProfile05) ;
+  testOnVirtualBus () ;
+  benchmark () ;
+  cout << "All E2E tests Ok" << endl ;
+  return 0 ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
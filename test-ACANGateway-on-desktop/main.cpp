@@ -0,0 +1,152 @@
+/******************************************************************************/
+/* File name        : main.cpp                                                */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Compiler         : Desktop C++ COMPILER (Visual Studio Code)               */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation: gateway between two virtual buses at full load        */
+/* ---------------------------------------------------------------------------*/
+
+/*------------------------------- Include files ------------------------------*/
+#include <iostream>
+#include <stdlib.h>
+#include "../src/ACANGateway.cpp"
+#include "../simulation-on-desktop/VirtualCANBus.cpp"
+#include "../simulation-on-desktop/DesktopTest.h"
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+using namespace std;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static const uint64_t SIMULATION_STEP = 10 * 1000 ;                 // 10 µs, in ns: gateway poll period
+static const uint64_t TRAFFIC_DURATION = 1000ULL * 1000 * 1000 ;    // 1 s
+static const uint64_t DRAIN_DURATION = 50ULL * 1000 * 1000 ;        // 50 ms
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  A driver without in place access to its receive buffer (as ACAN2515): the gateway uses receive
+
+class ReceiveOnlyDriver {
+  public: ReceiveOnlyDriver (VirtualCANNode & inNode) : mNode (inNode) {}
+  public: bool tryToSend (const CANMessage & inMessage) { return mNode.tryToSend (inMessage) ; }
+  public: bool receive (CANMessage & outMessage) { return mNode.receive (outMessage) ; }
+  private: VirtualCANNode & mNode ;
+} ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Traffic: 1/3 standard 0x100...0x1FF (forwarded), 1/3 extended 0x18FF0000...0x18FF00FF (forwarded as standard
+//  0x600...0x6FF), 1/3 standard 0x700...0x7FF (not routed). The payload is the frame number.
+
+static CANMessage trafficFrame (const uint32_t inNumber) {
+  CANMessage frame ;
+  const uint32_t offset = (inNumber / 3) & 0xFF ;
+  switch (inNumber % 3) {
+  case 0 : frame.id = 0x100 + offset ; break ;
+  case 1 : frame.id = 0x18FF0000 + offset ; frame.ext = true ; break ;
+  default : frame.id = 0x700 + offset ; break ;
+  }
+  frame.len = 8 ;
+  frame.data32 [0] = inNumber ;
+  frame.data32 [1] = ~ inNumber ;
+  return frame ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void gatewayAtFullLoad (const uint32_t inSourceBitRate, const uint32_t inDestinationBitRate) {
+  cout << "Source " << (inSourceBitRate / 1000) << " kbit/s, destination " << (inDestinationBitRate / 1000)
+       << " kbit/s" << endl ;
+  VirtualCANBus source (inSourceBitRate) ;
+  VirtualCANBus destination (inDestinationBitRate) ;
+  VirtualCANNode generator ;
+  VirtualCANNode gatewaySourceNode ;
+  VirtualCANNode gatewayDestinationNode ;
+  VirtualCANNode sink (16, 1000) ;
+  source.attach (generator) ;
+  source.attach (gatewaySourceNode) ;
+  destination.attach (gatewayDestinationNode) ;
+  destination.attach (sink) ;
+  ReceiveOnlyDriver destinationDriver (gatewayDestinationNode) ;
+//--- Gateway: in place port on the source bus, receive port on the destination bus
+  ACANGateway gateway ;
+  check (gateway.initWithCapacity (4), "allocation") ;
+  const uint8_t in = gateway.addPort (gatewaySourceNode) ;
+  const uint8_t out = gateway.addPort (destinationDriver) ;
+  const uint16_t standardRoute = gateway.addRoute (in, out, 0x100, 0x1FF, false) ;
+  const uint16_t rewriteRoute = gateway.addRoute (in, out, 0x18FF0000, 0x18FF00FF, true, ACANGateway::key (0x600, false)) ;
+  check ((standardRoute != ACANGateway::kInvalidRoute) && (rewriteRoute != ACANGateway::kInvalidRoute), "route refused") ;
+  check (gateway.addRoute (in, out, 0x1F0, 0x200, false) == ACANGateway::kInvalidRoute, "overlapping route accepted") ;
+  check (gateway.addRoute (in, out, 0x18FF0000, 0x18FF0FFF, true, 0x700) == ACANGateway::kInvalidRoute,
+         "rewrite out of range accepted") ;
+//--- Run: the generator keeps its transmit buffer full (100 % source bus load)
+  uint32_t sentCount = 0 ;
+  uint32_t receivedCount = 0 ;
+  uint32_t lastNumber [2] = {0, 0} ;
+  uint64_t now = 0 ;
+  while (now < TRAFFIC_DURATION + DRAIN_DURATION) {
+    while ((now < TRAFFIC_DURATION) && generator.tryToSend (trafficFrame (sentCount))) {
+      sentCount += 1 ;
+    }
+    now += SIMULATION_STEP ;
+    source.runUntil (now) ;
+    gateway.poll ((uint32_t) (now / 1000)) ;
+    destination.runUntil (now) ;
+    CANMessage frame ;
+    while (sink.receive (frame)) {
+      receivedCount += 1 ;
+      const uint32_t number = frame.data32 [0] ;
+      check (frame.data32 [1] == ~ number, "corrupted payload") ;
+      check (!frame.ext, "rewrite did not change the format") ;
+      const uint32_t offset = (number / 3) & 0xFF ;
+      const uint32_t r = number % 3 ;
+      check (r != 2, "unrouted frame forwarded") ;
+      check (frame.id == ((r == 0) ? 0x100 : 0x600) + offset, "wrong identifier") ;
+      check ((lastNumber [r] == 0) || (number > lastNumber [r]), "frame order not kept") ;
+      lastNumber [r] = number ;
+    }
+  }
+//--- Every frame received by the gateway is forwarded, dropped, or not routed
+  const ACANGatewayRouteStatistics & s0 = gateway.routeStatistics (standardRoute) ;
+  const ACANGatewayRouteStatistics & s1 = gateway.routeStatistics (rewriteRoute) ;
+  const uint32_t forwarded = s0.mForwardedCount + s1.mForwardedCount ;
+  const uint32_t dropped = s0.mDroppedCount + s1.mDroppedCount ;
+  const uint32_t unrouted = gateway.unroutedCount (in) ;
+  cout << "  " << sentCount << " frames sent, source bus load "
+       << (100 * source.busyTime () / TRAFFIC_DURATION) << " %, " << gatewaySourceNode.mReceiveOverflowCount
+       << " receive overflows" << endl ;
+  cout << "  forwarded " << forwarded << ", dropped " << dropped << ", not routed " << unrouted
+       << ", backpressure " << (s0.mBackpressureCount + s1.mBackpressureCount) << endl ;
+  cout << "  latency: mean " << (s0.mLatencySum + s1.mLatencySum) / (forwarded ? forwarded : 1)
+       << " µs, max " << max (s0.mMaxLatency, s1.mMaxLatency) << " µs" << endl ;
+  check (gatewaySourceNode.mReceivedFrameCount == forwarded + dropped + unrouted, "frames lost in the gateway") ;
+  check (receivedCount == forwarded, "forwarded frames lost on the destination bus") ;
+  check (gatewaySourceNode.mReceivedFrameCount + gatewaySourceNode.mReceiveOverflowCount == sentCount,
+         "frames lost on the source bus") ;
+  if (inDestinationBitRate >= inSourceBitRate) {
+    check (dropped == 0, "drops without backpressure") ;
+    check (max (s0.mMaxLatency, s1.mMaxLatency) < 100, "latency over 100 µs") ;
+  }else{
+    check (dropped > 0, "no drop under backpressure") ;
+    check (max (s0.mMaxLatency, s1.mMaxLatency) < 1000 + SIMULATION_STEP / 1000, "latency over the hold time") ;
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+int main (int /* argc */, const char * /* argv */ []) {
+  gatewayAtFullLoad (1000 * 1000, 1000 * 1000) ;
+  gatewayAtFullLoad (500 * 1000, 500 * 1000) ;
+  gatewayAtFullLoad (1000 * 1000, 500 * 1000) ;
+  cout << "All gateway tests Ok" << endl ;
+  return 0 ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
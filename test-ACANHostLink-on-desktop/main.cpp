@@ -0,0 +1,617 @@
+/******************************************************************************/
+/* File name        : main.cpp                                                */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Compiler         : Desktop C++ COMPILER (Visual Studio Code)               */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation: binary host link                                      */
+/* ---------------------------------------------------------------------------*/
+
+// Linux (socket pair for the host side)
+
+/*------------------------------- Include files ------------------------------*/
+#include <iostream>
+#include <chrono>
+#include <deque>
+#include <vector>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include "../src/ACANHostLink.cpp"
+#include "../src/ACANE2E.cpp"
+#include "../host-link-on-desktop/ACANHostLinkHost.cpp"
+#include "../simulation-on-desktop/VirtualCANBus.cpp"
+#include "../simulation-on-desktop/DesktopTest.h"
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+using namespace std;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static CANMessage randomFrame (void) {
+  CANMessage frame ;
+  frame.ext = (randomValue () & 1) != 0 ;
+  frame.id = randomValue () & (frame.ext ? 0x1FFFFFFF : 0x7FF) ;
+  frame.rtr = (randomValue () % 8) == 0 ;
+  frame.len = uint8_t (randomValue () % 9) ;
+  if (!frame.rtr) {
+    for (uint8_t i=0 ; i<frame.len ; i++) {
+      frame.data [i] = uint8_t (randomValue ()) ;
+    }
+  }
+  return frame ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static bool sameFrame (const CANMessage & inA, const CANMessage & inB) {
+  bool same = (inA.id == inB.id) && (inA.ext == inB.ext) && (inA.rtr == inB.rtr) && (inA.len == inB.len) ;
+  for (uint8_t i=0 ; (i<inA.len) && same && !inA.rtr ; i++) {
+    same = inA.data [i] == inB.data [i] ;
+  }
+  return same ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static uint32_t slcanLength (const CANMessage & inFrame) { // With timestamp
+  return 1 + (inFrame.ext ? 8 : 3) + 1 + (inFrame.rtr ? 0 : 2 * inFrame.len) + 4 + 1 ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  COBS
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void cobs (void) {
+  cout << "COBS" << endl ;
+  for (uint32_t i=0 ; i<100 * 1000 ; i++) {
+    uint8_t data [ACANHostLink::kMaxPacketLength] ;
+    const uint16_t length = uint16_t (randomValue () % (ACANHostLink::kMaxPacketLength + 1)) ;
+    const uint32_t zeroRate = randomValue () % 4 ; // None, some, many, all
+    for (uint16_t j=0 ; j<length ; j++) {
+      const bool zero = (zeroRate == 3) || ((zeroRate > 0) && ((randomValue () % (zeroRate * 16)) == 0)) ;
+      data [j] = zero ? 0 : uint8_t (1 + randomValue () % 255) ;
+    }
+    uint8_t encoded [ACANHostLink::kMaxPacketLength + 2] ;
+    const uint16_t encodedLength = ACANHostLink::cobsEncode (data, length, encoded) ;
+    check (encodedLength <= length + 1 + length / 254, "encoded too long") ;
+    check (memchr (encoded, 0, encodedLength) == nullptr, "zero byte in encoded data") ;
+    uint8_t decoded [ACANHostLink::kMaxPacketLength + 2] ;
+    uint16_t decodedLength = 0 ;
+    check (ACANHostLink::cobsDecode (encoded, encodedLength, decoded, decodedLength), "encoded data not decoded") ;
+    check ((decodedLength == length) && (memcmp (data, decoded, length) == 0), "decoded data differs") ;
+  }
+//--- Malformed
+  uint8_t decoded [16] ;
+  uint16_t decodedLength = 0 ;
+  const uint8_t beyondEnd [] = {3, 1} ;
+  check (!ACANHostLink::cobsDecode (beyondEnd, 2, decoded, decodedLength), "code beyond the end accepted") ;
+  const uint8_t zero [] = {3, 1, 0} ;
+  check (!ACANHostLink::cobsDecode (zero, 3, decoded, decodedLength), "zero byte accepted") ;
+  cout << "  Ok" << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Frame records
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void records (void) {
+  cout << "Frame records" << endl ;
+  for (uint32_t i=0 ; i<100 * 1000 ; i++) {
+    const CANMessage frame = randomFrame () ;
+    const uint16_t delta = uint16_t (randomValue ()) ;
+    uint8_t record [ACANHostLink::kMaxFrameRecordLength] ;
+    const uint8_t length = ACANHostLink::encodeFrameRecord (frame, delta, record) ;
+    check (length == 1 + (frame.ext ? 4 : 2) + 2 + (frame.rtr ? 0 : frame.len), "record length") ;
+    CANMessage decoded ;
+    uint16_t decodedDelta = 0 ;
+    check (ACANHostLink::decodeFrameRecord (record, length, decoded, decodedDelta) == length, "record not decoded") ;
+    check (sameFrame (frame, decoded) && (decodedDelta == delta), "decoded record differs") ;
+    check (ACANHostLink::decodeFrameRecord (record, length - 1, decoded, decodedDelta) == 0, "truncated record accepted") ;
+  }
+//--- Malformed
+  CANMessage decoded ;
+  uint16_t delta = 0 ;
+  const uint8_t reservedFlag [] = {0x10, 0x23, 0x01, 0, 0} ;
+  check (ACANHostLink::decodeFrameRecord (reservedFlag, 5, decoded, delta) == 0, "reserved flag accepted") ;
+  const uint8_t length9 [] = {0x49, 0x23, 0x01, 0, 0} ;
+  check (ACANHostLink::decodeFrameRecord (length9, 5, decoded, delta) == 0, "length 9 accepted") ;
+  const uint8_t standardIdentifier [] = {0x00, 0x00, 0x08, 0, 0} ;
+  check (ACANHostLink::decodeFrameRecord (standardIdentifier, 5, decoded, delta) == 0, "identifier 0x800 accepted") ;
+  const uint8_t extendedIdentifier [] = {0x80, 0x00, 0x00, 0x00, 0x20, 0, 0} ;
+  check (ACANHostLink::decodeFrameRecord (extendedIdentifier, 7, decoded, delta) == 0, "identifier 2^29 accepted") ;
+  cout << "  Ok" << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Two endpoints, bytes passed without delay: order, timestamps (deltas beyond 16 bits), the receive ring of the
+//  receiver holds its credit only, the sender waits for credit.
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void transfer (ACANHostLink & ioFrom, ACANHostLink & ioTo) {
+  ioTo.receiveBytes (ioFrom.output (), ioFrom.outputLength ()) ;
+  ioFrom.consumeOutput (ioFrom.outputLength ()) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void loopback (void) {
+  cout << "Loopback, credits" << endl ;
+  ACANHostLink a ;
+  ACANHostLink b ;
+  check (a.begin (16) && b.begin (64), "begin") ;
+  check (!a.hasCredit () && !a.appendFrame (CANMessage (), 0), "frame sent without credit") ;
+  const uint32_t kFrameCount = 100 * 1000 ;
+  deque <pair <CANMessage, uint32_t>> sent ;
+  uint32_t date = 0xFFFF0000 ; // Wraps
+  uint32_t sentCount = 0 ;
+  uint32_t receivedCount = 0 ;
+  uint32_t maxRingCount = 0 ;
+  uint32_t step = 0 ;
+  while (receivedCount < kFrameCount) {
+    check (step < 10 * kFrameCount, "stalled") ;
+    step += 1 ;
+    date += 1000 ;
+    a.update (date) ;
+    b.update (date) ;
+    bool appended = true ;
+    while (appended && (sentCount < kFrameCount)) {
+      const CANMessage frame = randomFrame () ;
+      const uint32_t timestamp = date + (((randomValue () % 64) == 0) ? 100 * 1000 : (randomValue () % 16)) ;
+      appended = a.appendFrame (frame, timestamp) ;
+      if (appended) {
+        sent.push_back (make_pair (frame, timestamp)) ;
+        sentCount += 1 ;
+        date = timestamp ;
+      }
+    }
+    a.flush () ;
+    transfer (a, b) ;
+    transfer (b, a) ;
+    maxRingCount = max (maxRingCount, uint32_t (b.receiveCount ())) ;
+  //--- The receiver consumes some frames
+    const uint32_t n = randomValue () % 48 ;
+    CANMessage frame ;
+    uint32_t timestamp = 0 ;
+    for (uint32_t i=0 ; (i<n) && b.receive (frame, timestamp) ; i++) {
+      check (!sent.empty () && sameFrame (frame, sent.front ().first), "frame lost or out of order") ;
+      check (timestamp == sent.front ().second, "timestamp") ;
+      sent.pop_front () ;
+      receivedCount += 1 ;
+    }
+  }
+  check (maxRingCount == 64, "receive ring not filled") ;
+  check ((b.overflowFrameCount () == 0) && (b.corruptedPacketCount () == 0) && (b.lostPacketCount () == 0)
+         && (b.lostFrameCount () == 0), "link errors") ;
+  check ((a.corruptedPacketCount () == 0) && (a.lostPacketCount () == 0), "credit errors") ;
+  cout << "  " << kFrameCount << " frames in " << a.sentPacketCount () << " packets, "
+       << b.sentPacketCount () << " credit packets" << endl ;
+  cout << "  Ok" << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Simulated UART, one direction: the transmit buffer of the sender (bounded), bytes on the line at the baud rate
+//  (8N1: 10 bits), the receive buffer of the receiver (bytes beyond its size are lost). Every inCorruptionPeriod-th
+//  byte is corrupted (0: none).
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+class SimulatedUART {
+  public: SimulatedUART (const uint32_t inBaudRate,
+                         const size_t inTransmitBufferSize,
+                         const size_t inReceiveBufferSize,
+                         const uint32_t inCorruptionPeriod) :
+  mByteDuration (10ULL * 1000 * 1000 * 1000 / inBaudRate),
+  mTransmitBufferSize (inTransmitBufferSize),
+  mReceiveBufferSize (inReceiveBufferSize),
+  mCorruptionPeriod (inCorruptionPeriod) {
+  }
+
+  public: void runUntil (const uint64_t inDate) {
+    while (!mTransmitBuffer.empty () && ((max (mLineDate, mRunDate) + mByteDuration) <= inDate)) {
+      mLineDate = max (mLineDate, mRunDate) + mByteDuration ;
+      uint8_t byte = mTransmitBuffer.front () ;
+      mTransmitBuffer.pop_front () ;
+      mByteCount += 1 ;
+      if ((mCorruptionPeriod > 0) && ((mByteCount % mCorruptionPeriod) == 0)) {
+        byte ^= 0x10 ;
+      }
+      if (mReceiveBuffer.size () < mReceiveBufferSize) {
+        mReceiveBuffer.push_back (byte) ;
+      }else{
+        mReceiveOverflowCount += 1 ;
+      }
+    }
+    mRunDate = inDate ;
+  }
+
+  public: size_t write (const uint8_t * inBytes, const size_t inLength) {
+    const size_t n = min (inLength, mTransmitBufferSize - mTransmitBuffer.size ()) ;
+    mTransmitBuffer.insert (mTransmitBuffer.end (), inBytes, inBytes + n) ;
+    return n ;
+  }
+
+  public: size_t read (uint8_t * outBytes, const size_t inLength) {
+    const size_t n = min (inLength, mReceiveBuffer.size ()) ;
+    for (size_t i=0 ; i<n ; i++) {
+      outBytes [i] = mReceiveBuffer.front () ;
+      mReceiveBuffer.pop_front () ;
+    }
+    return n ;
+  }
+
+  private: const uint64_t mByteDuration ; // ns
+  public: const size_t mTransmitBufferSize ;
+  private: const size_t mReceiveBufferSize ;
+  private: const uint32_t mCorruptionPeriod ;
+  public: deque <uint8_t> mTransmitBuffer ;
+  public: deque <uint8_t> mReceiveBuffer ;
+  private: uint64_t mLineDate = 0 ;
+  private: uint64_t mRunDate = 0 ;
+  public: uint64_t mByteCount = 0 ;
+  public: uint64_t mReceiveOverflowCount = 0 ;
+} ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Device side of the UART, as HardwareSerial
+
+class DeviceStream {
+  public: DeviceStream (SimulatedUART & inToHost, SimulatedUART & inToDevice) :
+  mToHost (inToHost),
+  mToDevice (inToDevice) {
+  }
+
+  public: int available (void) { return int (mToDevice.mReceiveBuffer.size ()) ; }
+
+  public: size_t readBytes (char * outBuffer, const size_t inLength) {
+    return mToDevice.read ((uint8_t *) outBuffer, inLength) ;
+  }
+
+  public: int availableForWrite (void) {
+    return int (mToHost.mTransmitBufferSize - mToHost.mTransmitBuffer.size ()) ;
+  }
+
+  public: size_t write (const uint8_t * inBuffer, const size_t inLength) {
+    return mToHost.write (inBuffer, inLength) ;
+  }
+
+  private: SimulatedUART & mToHost ;
+  private: SimulatedUART & mToDevice ;
+} ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+class TrafficRecord {
+  public: const VirtualCANNode * mTrafficNode ;
+  public: deque <pair <CANMessage, uint64_t>> mSentFrames ; // By the traffic node, with their end date
+} ;
+
+static void recordTraffic (void * inContext, const VirtualCANNode & inSender, const CANMessage & inFrame,
+                           const uint64_t inEndDate) {
+  TrafficRecord * record = (TrafficRecord *) inContext ;
+  if (&inSender == record->mTrafficNode) {
+    record->mSentFrames.push_back (make_pair (inFrame, inEndDate)) ;
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  A 100 % loaded 1 Mbit/s bus through the device (polled every 50 µs, 2 KB UART transmit buffer) and a 2 Mbaud link
+//  to the host (reads every ms); the host sends one frame every 500 back to the bus. The driver receive buffer never
+//  overflows: no frame is dropped, all arrive in order, stamped after their end of frame.
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+typedef enum {kStandard8, kMixed, kStandard0} Traffic ;
+
+static CANMessage trafficFrame (const Traffic inTraffic, const uint32_t inIndex) {
+  CANMessage frame ;
+  switch (inTraffic) {
+  case kStandard8 :
+    frame.id = 0x100 + (inIndex & 0x3FF) ;
+    frame.len = 8 ;
+    frame.data32 [0] = inIndex ;
+    frame.data32 [1] = randomValue () ;
+    break ;
+  case kMixed :
+    frame = randomFrame () ;
+    if (!frame.ext && (frame.id < 0x100)) {
+      frame.id += 0x100 ; // The host frames (0x050) win arbitration
+    }
+    break ;
+  case kStandard0 :
+    frame.id = 0x100 + (inIndex & 0x3FF) ;
+    break ;
+  }
+  return frame ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void simulatedLink (const Traffic inTraffic, const char * inTitle) {
+  cout << "Simulated 2 Mbaud link, 100 % loaded 1 Mbit/s bus, " << inTitle << endl ;
+  const uint32_t kBaudRate = 2 * 1000 * 1000 ;
+  SimulatedUART toHost (kBaudRate, 2048, 1 << 20, 0) ;
+  SimulatedUART toDevice (kBaudRate, 4096, 1024, 0) ;
+  DeviceStream stream (toHost, toDevice) ;
+  VirtualCANBus bus (1000 * 1000) ;
+  VirtualCANNode traffic (16, 256) ;
+  VirtualCANNode driver (16, 512) ;
+  bus.attach (traffic) ;
+  bus.attach (driver) ;
+  TrafficRecord record ;
+  record.mTrafficNode = &traffic ;
+  bus.setObserver (recordTraffic, &record) ;
+  ACANHostLink device ;
+  ACANHostLink host ;
+  check (device.begin (64) && host.begin (1024), "begin") ;
+//--- Run
+  const uint32_t kTrafficFrameCount = 50 * 1000 ;
+  uint32_t queuedCount = 0 ;
+  uint32_t receivedCount = 0 ;
+  uint32_t hostSentCount = 0 ;
+  uint64_t slcanBytes = 0 ;
+  uint64_t maxLatency = 0 ;
+  uint32_t lastTimestamp = 0 ;
+  uint64_t date = 0 ;
+  while ((receivedCount < kTrafficFrameCount) || (traffic.mReceivedFrameCount < hostSentCount)) {
+    check (date < 60ULL * 1000 * 1000 * 1000, "stalled") ;
+    while ((queuedCount < kTrafficFrameCount) && traffic.tryToSend (trafficFrame (inTraffic, queuedCount))) {
+      queuedCount += 1 ;
+    }
+    date += 50 * 1000 ;
+    bus.runUntil (date) ;
+    toHost.runUntil (date) ;
+    toDevice.runUntil (date) ;
+    device.poll (driver, stream, uint32_t (date / 1000)) ;
+  //--- Host, every ms
+    if ((date % (1000 * 1000)) == 0) {
+      uint8_t buffer [4096] ;
+      size_t n = toHost.read (buffer, sizeof (buffer)) ;
+      while (n > 0) {
+        host.receiveBytes (buffer, n) ;
+        n = toHost.read (buffer, sizeof (buffer)) ;
+      }
+      CANMessage frame ;
+      uint32_t timestamp = 0 ;
+      while (host.receive (frame, timestamp)) {
+        check (!record.mSentFrames.empty () && sameFrame (frame, record.mSentFrames.front ().first),
+               "frame lost or out of order") ;
+        const uint64_t endDate = record.mSentFrames.front ().second / 1000 ;
+        check ((timestamp >= endDate) && (timestamp >= lastTimestamp), "timestamp before the end of frame") ;
+        maxLatency = max (maxLatency, timestamp - endDate) ;
+        lastTimestamp = timestamp ;
+        slcanBytes += slcanLength (frame) ;
+        record.mSentFrames.pop_front () ;
+        receivedCount += 1 ;
+      }
+      if ((hostSentCount < (receivedCount / 500)) && host.hasCredit ()) {
+        CANMessage hostFrame ;
+        hostFrame.id = 0x050 ;
+        hostFrame.len = 1 ;
+        hostFrame.data [0] = uint8_t (hostSentCount) ;
+        check (host.appendFrame (hostFrame, uint32_t (date / 1000)), "host frame not appended") ;
+        hostSentCount += 1 ;
+      }
+      host.flush () ;
+      host.update (uint32_t (date / 1000)) ;
+      host.consumeOutput (uint16_t (toDevice.write (host.output (), host.outputLength ()))) ;
+    }
+  }
+  check (driver.mReceiveOverflowCount == 0, "driver receive buffer overflow") ;
+  check (toDevice.mReceiveOverflowCount == 0, "device UART receive buffer overflow") ;
+  check ((host.overflowFrameCount () == 0) && (host.corruptedPacketCount () == 0) && (host.lostPacketCount () == 0)
+         && (host.lostFrameCount () == 0), "host link errors") ;
+  check ((device.overflowFrameCount () == 0) && (device.corruptedPacketCount () == 0)
+         && (device.lostPacketCount () == 0), "device link errors") ;
+  check ((hostSentCount > 0) && (driver.mSentFrameCount == hostSentCount), "host frames not sent") ;
+  const double seconds = date / 1.0e9 ;
+  const double busLoad = double (bus.busyTime ()) / double (date) ;
+  const double linkLoad = double (toHost.mByteCount) / (seconds * kBaudRate / 10.0) ;
+  cout << "  bus load " << (100.0 * busLoad) << " %, " << (kTrafficFrameCount / seconds) << " frames/s, "
+       << (double (device.sentFrameCount ()) / device.sentPacketCount ()) << " frames per packet (credit packets included)" << endl ;
+  cout << "  " << (double (toHost.mByteCount) / kTrafficFrameCount) << " bytes per frame (SLCAN: "
+       << (double (slcanBytes) / kTrafficFrameCount) << "), link load " << (100.0 * linkLoad)
+       << " %, max latency " << maxLatency << " µs" << endl ;
+  check (busLoad > 0.98, "bus not fully loaded") ;
+  check (linkLoad < 1.0, "link saturated") ;
+  cout << "  Ok" << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Corrupted bytes in both directions: the packets are dropped (CRC, COBS), the frames they carry are counted as lost,
+//  lost credit packets are repaired by the next ones; the link never stalls and the driver buffer never overflows.
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void corruptedLink (void) {
+  cout << "Corrupted link" << endl ;
+  const uint32_t kBaudRate = 2 * 1000 * 1000 ;
+  SimulatedUART toHost (kBaudRate, 2048, 1 << 20, 20011) ;
+  SimulatedUART toDevice (kBaudRate, 4096, 1024, 211) ;
+  DeviceStream stream (toHost, toDevice) ;
+  VirtualCANBus bus (1000 * 1000) ;
+  VirtualCANNode traffic (16, 256) ;
+  VirtualCANNode driver (16, 512) ;
+  bus.attach (traffic) ;
+  bus.attach (driver) ;
+  ACANHostLink device ;
+  ACANHostLink host ;
+  check (device.begin (64) && host.begin (1024), "begin") ;
+  const uint32_t kTrafficFrameCount = 50 * 1000 ;
+  uint32_t queuedCount = 0 ;
+  uint32_t receivedCount = 0 ;
+  int64_t lastIndex = -1 ;
+  uint64_t date = 0 ;
+  while ((receivedCount + host.lostFrameCount ()) < kTrafficFrameCount) {
+    check (date < 60ULL * 1000 * 1000 * 1000, "stalled") ;
+    while ((queuedCount < kTrafficFrameCount) && traffic.tryToSend (trafficFrame (kStandard8, queuedCount))) {
+      queuedCount += 1 ;
+    }
+    date += 50 * 1000 ;
+    bus.runUntil (date) ;
+    toHost.runUntil (date) ;
+    toDevice.runUntil (date) ;
+    device.poll (driver, stream, uint32_t (date / 1000)) ;
+    if ((date % (1000 * 1000)) == 0) {
+      uint8_t buffer [4096] ;
+      size_t n = toHost.read (buffer, sizeof (buffer)) ;
+      while (n > 0) {
+        host.receiveBytes (buffer, n) ;
+        n = toHost.read (buffer, sizeof (buffer)) ;
+      }
+      CANMessage frame ;
+      uint32_t timestamp = 0 ;
+      while (host.receive (frame, timestamp)) {
+        check (int64_t (frame.data32 [0]) > lastIndex, "frame out of order") ;
+        lastIndex = frame.data32 [0] ;
+        receivedCount += 1 ;
+      }
+      host.update (uint32_t (date / 1000)) ;
+      host.consumeOutput (uint16_t (toDevice.write (host.output (), host.outputLength ()))) ;
+    }
+  }
+  check (driver.mReceiveOverflowCount == 0, "driver receive buffer overflow") ;
+  check ((host.corruptedPacketCount () > 0) && (host.lostFrameCount () > 0), "no corruption seen by the host") ;
+  check (device.corruptedPacketCount () > 0, "no corruption seen by the device") ;
+  check (host.overflowFrameCount () == 0, "host receive ring overflow") ;
+  cout << "  host: " << host.corruptedPacketCount () << " corrupted packets, " << host.lostPacketCount ()
+       << " lost packets, " << host.lostFrameCount () << " lost frames of " << kTrafficFrameCount << endl ;
+  cout << "  device: " << device.corruptedPacketCount () << " corrupted credit packets of "
+       << device.receivedPacketCount () + device.corruptedPacketCount () << endl ;
+  cout << "  Ok" << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Host library: ACANHostLinkPort on one end of a socket pair, a device endpoint on the other; device timestamps wrap
+//  around 2^32 during the run and are extended to 64 bits.
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+class SocketStream {
+  public: SocketStream (const int inFileDescriptor) : mFileDescriptor (inFileDescriptor) {}
+
+  public: int available (void) {
+    int count = 0 ;
+    ioctl (mFileDescriptor, FIONREAD, &count) ;
+    return count ;
+  }
+
+  public: size_t readBytes (char * outBuffer, const size_t inLength) {
+    const ssize_t n = read (mFileDescriptor, outBuffer, inLength) ;
+    return (n > 0) ? size_t (n) : 0 ;
+  }
+
+  public: int availableForWrite (void) { return 4096 ; }
+
+  public: size_t write (const uint8_t * inBuffer, const size_t inLength) {
+    const ssize_t n = ::write (mFileDescriptor, inBuffer, inLength) ;
+    return (n > 0) ? size_t (n) : 0 ;
+  }
+
+  private: const int mFileDescriptor ;
+} ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+class QueueDriver {
+  public: bool tryToSend (const CANMessage & inFrame) {
+    mSentFrames.push_back (inFrame) ;
+    return true ;
+  }
+
+  public: bool receive (CANMessage & outFrame) {
+    const bool ok = !mReceivedFrames.empty () ;
+    if (ok) {
+      outFrame = mReceivedFrames.front () ;
+      mReceivedFrames.pop_front () ;
+    }
+    return ok ;
+  }
+
+  public: deque <CANMessage> mReceivedFrames ;
+  public: vector <CANMessage> mSentFrames ;
+} ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void hostPort (void) {
+  cout << "Host library, socket pair" << endl ;
+  int sockets [2] ;
+  check (socketpair (AF_UNIX, SOCK_STREAM, 0, sockets) == 0, "cannot create a socket pair") ;
+  fcntl (sockets [1], F_SETFL, fcntl (sockets [1], F_GETFL) | O_NONBLOCK) ;
+  ACANHostLinkPort port ;
+  check (port.attach (sockets [0], 256), "attach") ;
+  SocketStream stream (sockets [1]) ;
+  QueueDriver driver ;
+  ACANHostLink device ;
+  check (device.begin (32), "begin") ;
+  const uint32_t kFrameCount = 20 * 1000 ;
+  const uint32_t kHostFrameCount = 1000 ;
+  vector <CANMessage> deviceFrames ;
+  vector <CANMessage> hostFrames ;
+  for (uint32_t i=0 ; i<kFrameCount ; i++) {
+    deviceFrames.push_back (randomFrame ()) ;
+  }
+  for (uint32_t i=0 ; i<kHostFrameCount ; i++) {
+    hostFrames.push_back (randomFrame ()) ;
+  }
+  const uint32_t start = ACANHostLinkPort::nowMicros () ;
+  const uint32_t timestampOffset = 0xFFFFFFFFU - start - 2000 ; // Device timestamps wrap after 2 ms
+  uint32_t queuedCount = 0 ;
+  uint32_t receivedCount = 0 ;
+  uint32_t hostSentCount = 0 ;
+  uint64_t lastTimestamp = 0 ;
+  while ((receivedCount < kFrameCount) || (driver.mSentFrames.size () < kHostFrameCount)) {
+    const uint32_t now = ACANHostLinkPort::nowMicros () ;
+    check ((now - start) < 10 * 1000 * 1000, "stalled") ;
+  //--- Device: 20 frames per poll
+    for (uint32_t i=0 ; (i<20) && (queuedCount < kFrameCount) ; i++) {
+      driver.mReceivedFrames.push_back (deviceFrames [queuedCount]) ;
+      queuedCount += 1 ;
+    }
+    device.poll (driver, stream, now + timestampOffset) ;
+  //--- Host
+    check (port.poll (1), "host poll") ;
+    CANMessage frame ;
+    uint64_t timestamp = 0 ;
+    while (port.receive (frame, timestamp)) {
+      check (sameFrame (frame, deviceFrames [receivedCount]), "frame lost or out of order") ;
+      check (timestamp >= lastTimestamp, "timestamp not extended") ;
+      lastTimestamp = timestamp ;
+      receivedCount += 1 ;
+    }
+    while ((hostSentCount < kHostFrameCount) && port.send (hostFrames [hostSentCount])) {
+      hostSentCount += 1 ;
+    }
+  }
+  for (uint32_t i=0 ; i<kHostFrameCount ; i++) {
+    check (sameFrame (driver.mSentFrames [i], hostFrames [i]), "host frame lost or out of order") ;
+  }
+  check (lastTimestamp > 0xFFFFFFFFULL, "timestamps did not wrap") ;
+  check ((port.link ().corruptedPacketCount () == 0) && (port.link ().lostFrameCount () == 0), "host link errors") ;
+  port.close () ;
+  close (sockets [1]) ;
+  cout << "  Ok" << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+int main (int /* argc */, const char * /* argv */ []) {
+  cobs () ;
+  records () ;
+  loopback () ;
+  simulatedLink (kStandard8, "8 byte standard frames") ;
+  simulatedLink (kMixed, "mixed frames") ;
+  simulatedLink (kStandard0, "empty standard frames") ;
+  corruptedLink () ;
+  hostPort () ;
+  cout << "All host link tests Ok" << endl ;
+  return 0 ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
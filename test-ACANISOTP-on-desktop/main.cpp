@@ -0,0 +1,271 @@
+/******************************************************************************/
+/* File name        : main.cpp                                                */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Compiler         : Desktop C++ COMPILER (Visual Studio Code)               */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation: ISO-TP end to end against a simulated peer           */
+/* ---------------------------------------------------------------------------*/
+
+/*------------------------------- Include files ------------------------------*/
+#include <iostream>
+#include <vector>
+#include <stdlib.h>
+#include "../src/ACANISOTP.cpp"
+#include "../simulation-on-desktop/VirtualCANBus.cpp"
+#include "../simulation-on-desktop/DesktopTest.h"
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+using namespace std;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static const uint64_t SIMULATION_STEP = 10 * 1000 ;           // 10 µs, in ns
+static const uint64_t SIMULATION_LIMIT = 60ULL * 1000 * 1000 * 1000 ; // 60 s
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Two ISO-TP nodes on a virtual bus
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+class TestBench {
+  public: VirtualCANBus mBus ;
+  public: VirtualCANNode mNodeA ;
+  public: VirtualCANNode mNodeB ;
+  public: ACANISOTP mISOTPA ;
+  public: ACANISOTP mISOTPB ;
+
+  public: TestBench (const uint32_t inBitRate, const uint32_t inReceiveBufferSize) :
+  mBus (inBitRate),
+  mNodeA (),
+  mNodeB (),
+  mISOTPA (mNodeA),
+  mISOTPB (mNodeB) {
+    mBus.attach (mNodeA) ;
+    mBus.attach (mNodeB) ;
+    mISOTPA.begin (4, 4, inReceiveBufferSize) ;
+    mISOTPB.begin (4, 4, inReceiveBufferSize) ;
+  }
+
+  //--- Channel i of A sends to channel i of B on identifiers 0x700 + 2 i, B answers on 0x701 + 2 i
+  public: void addChannelPair (const uint8_t inBlockSize, const uint8_t inSeparationTime) {
+    ACANISOTPChannelSettings settings ;
+    const uint32_t base = 0x700 + 2 * mChannelPairCount ;
+    settings.mBlockSize = inBlockSize ;
+    settings.mSeparationTime = inSeparationTime ;
+    settings.mTransmitIdentifier = base ;
+    settings.mReceiveIdentifier = base + 1 ;
+    mISOTPA.addChannel (settings) ;
+    settings.mTransmitIdentifier = base + 1 ;
+    settings.mReceiveIdentifier = base ;
+    mISOTPB.addChannel (settings) ;
+    mChannelPairCount += 1 ;
+  }
+
+  public: inline uint32_t now (void) const { return (uint32_t) (mDate / 1000) ; } // µs
+
+  public: void step (void) {
+    mDate += SIMULATION_STEP ;
+    mBus.runUntil (mDate) ;
+    const uint32_t now = this->now () ;
+    CANMessage frame ;
+    while (mNodeA.receive (frame)) {
+      mISOTPA.handleReceivedFrame (frame, now) ;
+    }
+    while (mNodeB.receive (frame)) {
+      mISOTPB.handleReceivedFrame (frame, now) ;
+    }
+    mISOTPA.poll (now) ;
+    mISOTPB.poll (now) ;
+  }
+
+  public: uint64_t mDate = 0 ;
+  public: uint8_t mChannelPairCount = 0 ;
+} ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static vector <uint8_t> pattern (const uint32_t inLength, const uint32_t inSeed) {
+  vector <uint8_t> result (inLength) ;
+  uint32_t x = inSeed ;
+  for (uint32_t i=0 ; i<inLength ; i++) {
+    x = x * 1103515245 + 12345 ;
+    result [i] = (uint8_t) (x >> 16) ;
+  }
+  return result ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void checkReceived (ACANISOTP & ioISOTP, const uint8_t inChannel, const vector <uint8_t> & inExpected) {
+  const uint8_t * data ;
+  uint32_t length ;
+  check (ioISOTP.receive (inChannel, data, length), "no message received") ;
+  check (length == inExpected.size (), "wrong length") ;
+  check (memcmp (data, inExpected.data (), length) == 0, "wrong contents") ;
+  ioISOTP.release (inChannel) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  THROUGHPUT
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void throughput (const uint32_t inBitRate, const uint32_t inLength) {
+  TestBench bench (inBitRate, inLength) ;
+  bench.addChannelPair (0, 0) ;
+  const vector <uint8_t> message = pattern (inLength, inBitRate) ;
+  check (bench.mISOTPA.send (0, message.data (), inLength, bench.now ()), "send refused") ;
+  while ((bench.mISOTPA.transmitStatus (0) == ACANISOTP::kInProgress) && (bench.mDate < SIMULATION_LIMIT)) {
+    bench.step () ;
+  }
+  check (bench.mISOTPA.transmitStatus (0) == ACANISOTP::kDone, "transfer not completed") ;
+  while ((bench.mISOTPB.receivedMessageCount () == 0) && (bench.mDate < SIMULATION_LIMIT)) {
+    bench.step () ;
+  }
+  checkReceived (bench.mISOTPB, 0, message) ;
+  const double seconds = (double) bench.mDate / 1.0e9 ;
+  cout << "  " << (inBitRate / 1000) << " kbit/s, " << inLength << " bytes: "
+       << (uint64_t) (inLength / seconds) << " bytes/s, bus load "
+       << (100 * bench.mBus.busyTime () / bench.mDate) << "%" << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  CONCURRENT CHANNELS, BOTH DIRECTIONS, BLOCK SIZE AND STmin
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void concurrentChannels (void) {
+  cout << "Concurrent channels" << endl ;
+  TestBench bench (500 * 1000, 4095) ;
+  bench.addChannelPair (4, 0) ;       // BS = 4
+  bench.addChannelPair (0, 0xF5) ;    // STmin = 500 µs
+  bench.addChannelPair (8, 2) ;       // BS = 8, STmin = 2 ms
+  vector <uint8_t> messagesA [3] ;
+  vector <uint8_t> messagesB [3] ;
+  for (uint8_t c=0 ; c<3 ; c++) {
+    messagesA [c] = pattern (1000 + 1000 * c, c) ;
+    messagesB [c] = pattern (5 + 700 * c, 10 + c) ;
+    check (bench.mISOTPA.send (c, messagesA [c].data (), (uint32_t) messagesA [c].size (), bench.now ()),
+           "send A refused") ;
+    check (bench.mISOTPB.send (c, messagesB [c].data (), (uint32_t) messagesB [c].size (), bench.now ()),
+           "send B refused") ;
+  }
+  while (((bench.mISOTPA.receivedMessageCount () < 3) || (bench.mISOTPB.receivedMessageCount () < 3))
+      && (bench.mDate < SIMULATION_LIMIT)) {
+    bench.step () ;
+  }
+  for (uint8_t c=0 ; c<3 ; c++) {
+    check (bench.mISOTPA.transmitStatus (c) == ACANISOTP::kDone, "A transfer not completed") ;
+    check (bench.mISOTPB.transmitStatus (c) == ACANISOTP::kDone, "B transfer not completed") ;
+    checkReceived (bench.mISOTPB, c, messagesA [c]) ;
+    checkReceived (bench.mISOTPA, c, messagesB [c]) ;
+  }
+  check (bench.mISOTPA.receiveErrorCount () + bench.mISOTPB.receiveErrorCount () == 0, "receive errors") ;
+  cout << "  6 transfers in " << (bench.mDate / 1000) << " µs, Ok" << endl << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  ERROR CASES
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void errorCases (void) {
+  cout << "Error cases" << endl ;
+  { //--- Receiver pool buffers too small: FC.OVFLW
+    TestBench bench (500 * 1000, 100) ;
+    bench.addChannelPair (0, 0) ;
+    const vector <uint8_t> message = pattern (200, 1) ;
+    bench.mISOTPA.send (0, message.data (), 200, bench.now ()) ;
+    while ((bench.mISOTPA.transmitStatus (0) == ACANISOTP::kInProgress) && (bench.mDate < SIMULATION_LIMIT)) {
+      bench.step () ;
+    }
+    check (bench.mISOTPA.transmitStatus (0) == ACANISOTP::kReceiverOverflow, "overflow not reported") ;
+    check (bench.mISOTPB.receiveOverflowCount () == 1, "overflow not counted") ;
+    cout << "  Receiver overflow, Ok" << endl ;
+  }
+  { //--- Peer disconnected: N_Bs timeout
+    TestBench bench (500 * 1000, 4095) ;
+    bench.addChannelPair (0, 0) ;
+    bench.mNodeB.mConnected = false ;
+    const vector <uint8_t> message = pattern (100, 2) ;
+    bench.mISOTPA.send (0, message.data (), 100, bench.now ()) ;
+    while ((bench.mISOTPA.transmitStatus (0) == ACANISOTP::kInProgress) && (bench.mDate < SIMULATION_LIMIT)) {
+      bench.step () ;
+    }
+    check (bench.mISOTPA.transmitStatus (0) == ACANISOTP::kTimeout, "timeout not reported") ;
+    cout << "  Flow control timeout, Ok" << endl ;
+  }
+  { //--- Sender disconnected, transmit buffer full: the first frame is never accepted, N_As timeout
+    TestBench bench (500 * 1000, 4095) ;
+    bench.addChannelPair (0, 0) ;
+    bench.mNodeA.mConnected = false ;
+    CANMessage frame ;
+    while (bench.mNodeA.tryToSend (frame)) {}
+    const vector <uint8_t> message = pattern (100, 4) ;
+    bench.mISOTPA.send (0, message.data (), 100, bench.now ()) ;
+    while ((bench.mISOTPA.transmitStatus (0) == ACANISOTP::kInProgress) && (bench.mDate < SIMULATION_LIMIT)) {
+      bench.step () ;
+    }
+    check (bench.mISOTPA.transmitStatus (0) == ACANISOTP::kTimeout, "first frame timeout not reported") ;
+    check (bench.mDate < 2ULL * 1000 * 1000 * 1000, "first frame timeout late") ;
+    cout << "  First frame timeout, Ok" << endl ;
+  }
+  { //--- Send after 5 s without poll: the flow control timeout runs from the send date
+    TestBench bench (500 * 1000, 4095) ;
+    bench.addChannelPair (0, 0) ;
+    bench.mDate += 5ULL * 1000 * 1000 * 1000 ;
+    bench.mBus.runUntil (bench.mDate) ;
+    const vector <uint8_t> message = pattern (100, 3) ;
+    bench.mISOTPA.send (0, message.data (), 100, bench.now ()) ;
+    while ((bench.mISOTPA.transmitStatus (0) == ACANISOTP::kInProgress) && (bench.mDate < SIMULATION_LIMIT)) {
+      bench.step () ;
+    }
+    check (bench.mISOTPA.transmitStatus (0) == ACANISOTP::kDone, "send dated by the last poll") ;
+    cout << "  Send after an idle period, Ok" << endl ;
+  }
+  { //--- First frames with the 32-bit length escape and a length that fits in 12 bits: rejected, no flow control
+    TestBench bench (500 * 1000, 8192) ;
+    bench.addChannelPair (0, 0) ;
+    CANMessage frame ;
+    frame.id = 0x700 ;
+    frame.len = 8 ;
+    const uint32_t lengths [] = {8, 4095, 4096} ;
+    for (const uint32_t length : lengths) {
+      frame.data [0] = 0x10 ;
+      frame.data [1] = 0 ;
+      frame.data [2] = (uint8_t) (length >> 24) ;
+      frame.data [3] = (uint8_t) (length >> 16) ;
+      frame.data [4] = (uint8_t) (length >> 8) ;
+      frame.data [5] = (uint8_t) length ;
+      bench.mISOTPB.handleReceivedFrame (frame, bench.now ()) ;
+    }
+    check (bench.mISOTPB.receiveErrorCount () == 2, "non canonical escapes not rejected") ;
+    check (bench.mNodeB.transmitBufferCount () == 1, "flow control not sent for the 4096 byte message only") ;
+    cout << "  Non canonical 32-bit length escape, Ok" << endl << endl ;
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   MAIN
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+int main (int /* argc */, const char * /* argv */ []) {
+  cout << "Sustained throughput (BS = 0, STmin = 0)" << endl ;
+  const uint32_t bitRates [] = {125 * 1000, 250 * 1000, 500 * 1000, 1000 * 1000} ;
+  for (size_t i=0 ; i<4 ; i++) {
+    throughput (bitRates [i], 4095) ;
+  }
+  throughput (1000 * 1000, 100 * 1000) ; // 32-bit length first frame
+  cout << endl ;
+  concurrentChannels () ;
+  errorCases () ;
+  cout << "All ISO-TP tests Ok" << endl ;
+  return 0 ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
@@ -0,0 +1,375 @@
+/******************************************************************************/
+/* File name        : main.cpp                                                */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Compiler         : Desktop C++ COMPILER (Visual Studio Code)               */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation: J1939 engine driven by recorded traffic, and nodes    */
+/*          | on a virtual bus                                                */
+/* ---------------------------------------------------------------------------*/
+
+/*------------------------------- Include files ------------------------------*/
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <chrono>
+#include <algorithm>
+#include <stdlib.h>
+#include "../src/ACANJ1939.cpp"
+#include "../simulation-on-desktop/VirtualCANBus.cpp"
+#include "../simulation-on-desktop/DesktopTest.h"
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+using namespace std;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static const uint64_t NAME_UNDER_TEST = 0x80000A0001E00000ULL ; // Arbitrary address capable
+static const uint32_t PGN_EEC1 = 0xF004 ;
+static const uint32_t PGN_DM1 = 0xFECA ;
+static const uint32_t PGN_VI = 0xFEEC ;
+static const uint32_t PGN_PROPRIETARY_A = 0xEF00 ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Recorded traffic (candump -l format). Interface "dut": frame sent by the node under test (expected output),
+//  "can0": frame sent by the other nodes of the recorded bus.
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+class RecordedFrame {
+  public: uint32_t mDate ;   // ms
+  public: bool mSentByNodeUnderTest ;
+  public: CANMessage mFrame ;
+} ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static vector <RecordedFrame> readRecording (const char * inPath) {
+  vector <RecordedFrame> result ;
+  ifstream file (inPath) ;
+  check (file.good (), "cannot open recorded traffic") ;
+  string line ;
+  while (getline (file, line)) {
+    if ((line.size () > 0) && (line [0] == '(')) {
+      RecordedFrame f ;
+      const size_t close = line.find (')') ;
+      f.mDate = (uint32_t) (strtod (line.c_str () + 1, NULL) * 1000.0 + 0.5) ;
+      istringstream fields (line.substr (close + 1)) ;
+      string itf, frame ;
+      fields >> itf >> frame ;
+      f.mSentByNodeUnderTest = itf == "dut" ;
+      const size_t hash = frame.find ('#') ;
+      f.mFrame.id = (uint32_t) strtoul (frame.substr (0, hash).c_str (), NULL, 16) ;
+      f.mFrame.ext = hash > 3 ;
+      const string data = frame.substr (hash + 1) ;
+      f.mFrame.len = (uint8_t) (data.size () / 2) ;
+      for (uint8_t i=0 ; i<f.mFrame.len ; i++) {
+        f.mFrame.data [i] = (uint8_t) strtoul (data.substr (2 * i, 2).c_str (), NULL, 16) ;
+      }
+      result.push_back (f) ;
+    }
+  }
+  return result ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static bool captureFrame (void * inQueue, const CANMessage & inFrame) {
+  ((deque <CANMessage> *) inQueue)->push_back (inFrame) ;
+  return true ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static bool sameFrame (const CANMessage & inLeft, const CANMessage & inRight) {
+  return (inLeft.id == inRight.id) && (inLeft.ext == inRight.ext) && (inLeft.len == inRight.len)
+    && (memcmp (inLeft.data, inRight.data, inLeft.len) == 0) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+class ReceivedCounters {
+  public: uint32_t mEEC1 = 0 ;
+  public: uint32_t mDM1 = 0 ;
+  public: uint32_t mVI = 0 ;
+  public: uint32_t mOther = 0 ;
+  public: bool mContentsOk = true ;
+} ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void handleEEC1 (void * inContext, const ACANJ1939Message & inMessage) {
+  ReceivedCounters * counters = (ReceivedCounters *) inContext ;
+  counters->mEEC1 += 1 ;
+  counters->mContentsOk &= (inMessage.mLength == 8) && (inMessage.mSourceAddress == 0x00) && (inMessage.mPriority == 3) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void handleDM1 (void * inContext, const ACANJ1939Message & inMessage) {
+  ReceivedCounters * counters = (ReceivedCounters *) inContext ;
+  counters->mDM1 += 1 ;
+  counters->mContentsOk &= (inMessage.mLength == 14) && (inMessage.mData [2] == 0x64 + inMessage.mSourceAddress / 3)
+    && (inMessage.mData [13] == 0x02) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void handleVI (void * inContext, const ACANJ1939Message & inMessage) {
+  ReceivedCounters * counters = (ReceivedCounters *) inContext ;
+  counters->mVI += 1 ;
+  counters->mContentsOk &= (inMessage.mLength == 17) && (memcmp (inMessage.mData, "1FTEW1EP5JKD12345", 17) == 0)
+    && (inMessage.mSourceAddress == 0x03) && (inMessage.mDestinationAddress == 0x80) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void handleOther (void * inContext, const ACANJ1939Message & /* inMessage */) {
+  ((ReceivedCounters *) inContext)->mOther += 1 ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static ACANJ1939Route gRoutes [16] ;
+static ACANJ1939Session gSessions [4] ;
+
+static void beginUnderTest (ACANJ1939 & ioJ1939, ReceivedCounters & ioCounters) {
+  check (ioJ1939.begin (gRoutes, 16, gSessions, 4), "begin failed") ;
+  ioJ1939.addRoute (PGN_EEC1, handleEEC1, &ioCounters) ;
+  ioJ1939.addRoute (PGN_DM1, handleDM1, &ioCounters) ;
+  ioJ1939.addRoute (PGN_VI, handleVI, &ioCounters) ;
+  ioJ1939.setDefaultHandler (handleOther, &ioCounters) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  REPLAY: every frame of the node under test should be emitted by the engine, at the recorded position
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void replay (const vector <RecordedFrame> & inRecording) {
+  cout << "Replay of recorded traffic (" << inRecording.size () << " frames)" << endl ;
+  deque <CANMessage> emitted ;
+  ACANJ1939 j1939 (captureFrame, &emitted) ;
+  ReceivedCounters counters ;
+  beginUnderTest (j1939, counters) ;
+  j1939.claimAddress (NAME_UNDER_TEST, 0x80, 0) ;
+  for (size_t i=0 ; i<inRecording.size () ; i++) {
+    const RecordedFrame & f = inRecording [i] ;
+    j1939.poll (f.mDate) ;
+    if (f.mSentByNodeUnderTest) {
+      check (emitted.size () > 0, "expected frame not emitted") ;
+      check (sameFrame (emitted.front (), f.mFrame), "emitted frame differs from the recording") ;
+      emitted.pop_front () ;
+    }else{
+      j1939.handleReceivedFrame (f.mFrame, f.mDate) ;
+    }
+  }
+  check (emitted.size () == 0, "unexpected frame emitted") ;
+  check (counters.mContentsOk, "wrong message contents") ;
+  check (counters.mEEC1 == 970, "EEC1 count") ;
+  check (counters.mDM1 == 20, "DM1 count (BAM)") ;
+  check (counters.mVI == 2, "VI count (RTS/CTS)") ;
+  check (j1939.abortedSessionCount () == 0, "aborted sessions") ;
+  check (j1939.address () == 0x81, "address not changed after contention") ;
+  cout << "  " << j1939.routedMessageCount () << " routed, " << j1939.unroutedMessageCount ()
+       << " to default handler, Ok" << endl << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  HOST PROCESSING RATE, compared to a saturated bus
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static bool discardFrame (void * /* inDriver */, const CANMessage & /* inFrame */) {
+  return true ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void processingRate (const vector <RecordedFrame> & inRecording) {
+  cout << "Processing rate" << endl ;
+  const uint32_t ROUNDS = 2000 ;
+  ACANJ1939 j1939 (discardFrame, NULL) ;
+  ReceivedCounters counters ;
+  uint64_t frameCount = 0 ;
+  const auto start = chrono::steady_clock::now () ;
+  for (uint32_t r=0 ; r<ROUNDS ; r++) {
+    const uint32_t offset = r * 10000 ;
+    beginUnderTest (j1939, counters) ;
+    j1939.claimAddress (NAME_UNDER_TEST, 0x80, offset) ;
+    for (size_t i=0 ; i<inRecording.size () ; i++) {
+      const RecordedFrame & f = inRecording [i] ;
+      if (!f.mSentByNodeUnderTest) {
+        j1939.handleReceivedFrame (f.mFrame, f.mDate + offset) ;
+        j1939.poll (f.mDate + offset) ;
+        frameCount += 1 ;
+      }
+    }
+  }
+  const double seconds = chrono::duration <double> (chrono::steady_clock::now () - start).count () ;
+  CANMessage longest ;
+  longest.ext = true ;
+  longest.len = 8 ;
+  const double busFramesPerSecond = 500.0e3 / VirtualCANBus::frameBitLength (longest) ;
+  check (counters.mContentsOk && (counters.mVI == 2 * ROUNDS), "wrong messages") ;
+  cout << "  " << (uint64_t) (frameCount / seconds) << " frames/s on host, saturated 500 kbit/s bus: "
+       << (uint64_t) busFramesPerSecond << " frames/s" << endl << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  J1939 NODES ON A VIRTUAL BUS
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static const uint64_t SIMULATION_STEP = 100 * 1000 ;  // 100 µs, in ns
+
+class J1939Node {
+  public: VirtualCANNode mNode ;
+  public: ACANJ1939 mJ1939 ;
+  public: ACANJ1939Route mRoutes [8] ;
+  public: ACANJ1939Session mSessions [6] ;
+  public: vector <vector <uint8_t> > mReceived ;
+
+  public: J1939Node (void) :
+  mNode (),
+  mJ1939 (mNode) {
+    mJ1939.begin (mRoutes, 8, mSessions, 6) ;
+    mJ1939.addRoute (PGN_PROPRIETARY_A, store, this) ;
+    mJ1939.addRoute (PGN_DM1, store, this) ;
+  }
+
+  private: static void store (void * inContext, const ACANJ1939Message & inMessage) {
+    ((J1939Node *) inContext)->mReceived.push_back (vector <uint8_t> (inMessage.mData, inMessage.mData + inMessage.mLength)) ;
+  }
+} ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+class TestBench {
+  public: VirtualCANBus mBus ;
+  public: J1939Node mNodes [3] ;
+  public: uint64_t mDate = 0 ;
+
+  public: TestBench (const uint32_t inBitRate) :
+  mBus (inBitRate) {
+    for (uint8_t i=0 ; i<3 ; i++) {
+      mBus.attach (mNodes [i].mNode) ;
+    }
+  }
+
+  public: void run (const uint32_t inDurationMillis) {
+    const uint64_t end = mDate + inDurationMillis * 1000ULL * 1000ULL ;
+    while (mDate < end) {
+      mDate += SIMULATION_STEP ;
+      mBus.runUntil (mDate) ;
+      for (uint8_t i=0 ; i<3 ; i++) {
+        CANMessage frame ;
+        while (mNodes [i].mNode.receive (frame)) {
+          mNodes [i].mJ1939.handleReceivedFrame (frame, now ()) ;
+        }
+        mNodes [i].mJ1939.poll (now ()) ;
+      }
+    }
+  }
+
+  public: uint32_t now (void) const { return (uint32_t) (mDate / (1000 * 1000)) ; }
+} ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void addressClaimContention (void) {
+  cout << "Address claim contention" << endl ;
+  TestBench bench (250 * 1000) ;
+  bench.mNodes [0].mJ1939.claimAddress (0x8000000000000300ULL, 0x20, 0) ; // Arbitrary address capable, highest NAME
+  bench.mNodes [1].mJ1939.claimAddress (0x0000000000000100ULL, 0x20, 0) ; // Lowest NAME
+  bench.mNodes [2].mJ1939.claimAddress (0x0000000000000200ULL, 0x20, 0) ; // Not arbitrary address capable
+  bench.run (1000) ;
+  check (bench.mNodes [1].mJ1939.addressState () == ACANJ1939::kAddressClaimed, "node 1 state") ;
+  check (bench.mNodes [1].mJ1939.address () == 0x20, "node 1 address") ;
+  check (bench.mNodes [0].mJ1939.addressState () == ACANJ1939::kAddressClaimed, "node 0 state") ;
+  check (bench.mNodes [0].mJ1939.address () == 128, "node 0 address") ;
+  check (bench.mNodes [2].mJ1939.addressState () == ACANJ1939::kCannotClaim, "node 2 state") ;
+  cout << "  0x20 kept by the lowest NAME, 128 claimed, cannot claim sent, Ok" << endl << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static vector <uint8_t> pattern (const uint32_t inLength, const uint32_t inSeed) {
+  vector <uint8_t> result (inLength) ;
+  uint32_t x = inSeed ;
+  for (uint32_t i=0 ; i<inLength ; i++) {
+    x = x * 1103515245 + 12345 ;
+    result [i] = (uint8_t) (x >> 16) ;
+  }
+  return result ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void concurrentSessions (const uint32_t inBitRate) {
+  cout << "Concurrent sessions at " << (inBitRate / 1000) << " kbit/s" << endl ;
+  TestBench bench (inBitRate) ;
+  for (uint8_t i=0 ; i<3 ; i++) {
+    bench.mNodes [i].mJ1939.claimAddress (0x100 + i, 0x10 + i, 0) ;
+  }
+  bench.run (300) ;
+  const vector <uint8_t> m0to1 = pattern (ACANJ1939Session::kMaxMessageSize, 1) ;
+  const vector <uint8_t> m2to1 = pattern (600, 2) ;
+  const vector <uint8_t> m1to0 = pattern (9, 3) ;
+  const vector <uint8_t> bam0 = pattern (100, 4) ;
+  const vector <uint8_t> bam2 = pattern (40, 5) ;
+  const uint32_t start = bench.now () ;
+  check (bench.mNodes [0].mJ1939.send (PGN_PROPRIETARY_A, 6, 0x11, m0to1.data (), (uint16_t) m0to1.size (), start), "send 0 -> 1") ;
+  check (bench.mNodes [2].mJ1939.send (PGN_PROPRIETARY_A, 6, 0x11, m2to1.data (), (uint16_t) m2to1.size (), start), "send 2 -> 1") ;
+  check (bench.mNodes [1].mJ1939.send (PGN_PROPRIETARY_A, 6, 0x10, m1to0.data (), (uint16_t) m1to0.size (), start), "send 1 -> 0") ;
+  check (bench.mNodes [0].mJ1939.send (PGN_DM1, 6, 0xFF, bam0.data (), (uint16_t) bam0.size (), start), "BAM 0") ;
+  check (bench.mNodes [2].mJ1939.send (PGN_DM1, 6, 0xFF, bam2.data (), (uint16_t) bam2.size (), start), "BAM 2") ;
+  uint32_t sessions = 1 ;
+  while ((sessions > 0) && (bench.now () < start + 10000)) {
+    bench.run (1) ;
+    sessions = 0 ;
+    for (uint8_t i=0 ; i<3 ; i++) {
+      sessions += bench.mNodes [i].mJ1939.transmitSessionCount () ;
+    }
+  }
+  check (sessions == 0, "transfers not completed") ;
+  bench.run (10) ; //--- Last data packets still in the transmit buffers
+  const vector <vector <uint8_t> > & r0 = bench.mNodes [0].mReceived ;
+  const vector <vector <uint8_t> > & r1 = bench.mNodes [1].mReceived ;
+  const vector <vector <uint8_t> > & r2 = bench.mNodes [2].mReceived ;
+  check ((r0.size () == 2) && (r1.size () == 4) && (r2.size () == 1), "message counts") ;
+  check (find (r0.begin (), r0.end (), m1to0) != r0.end (), "RTS/CTS 1 -> 0") ;
+  check (find (r0.begin (), r0.end (), bam2) != r0.end (), "BAM 2 -> 0") ;
+  check (find (r1.begin (), r1.end (), m0to1) != r1.end (), "RTS/CTS 0 -> 1") ;
+  check (find (r1.begin (), r1.end (), m2to1) != r1.end (), "RTS/CTS 2 -> 1") ;
+  check (find (r1.begin (), r1.end (), bam0) != r1.end (), "BAM 0 -> 1") ;
+  check (find (r1.begin (), r1.end (), bam2) != r1.end (), "BAM 2 -> 1") ;
+  check (r2 [0] == bam0, "BAM 0 -> 2") ;
+  cout << "  3 RTS/CTS and 2 BAM transfers in " << (bench.now () - start) << " ms, bus load "
+       << (100 * bench.mBus.busyTime () / bench.mDate) << "%, Ok" << endl << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   MAIN
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+int main (int argc, const char * argv []) {
+  const char * path = (argc > 1) ? argv [1] : "recorded-traffic.log" ;
+  const vector <RecordedFrame> recording = readRecording (path) ;
+  replay (recording) ;
+  processingRate (recording) ;
+  addressClaimContention () ;
+  concurrentSessions (250 * 1000) ;
+  concurrentSessions (500 * 1000) ;
+  cout << "All J1939 tests Ok" << endl ;
+  return 0 ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
@@ -0,0 +1,139 @@
+/******************************************************************************/
+/* File name        : main.cpp                                                */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Compiler         : Desktop C++ COMPILER (Visual Studio Code)               */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation: latest value mailboxes under a receive burst          */
+/* ---------------------------------------------------------------------------*/
+
+/*------------------------------- Include files ------------------------------*/
+#include <iostream>
+#include <stdlib.h>
+#include "../src/ACANMailboxes.h"
+#include "../simulation-on-desktop/VirtualCANBus.cpp"
+#include "../simulation-on-desktop/DesktopTest.h"
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+using namespace std;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Registration: sorted, duplicates removed, standard and extended identifiers are distinct
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void registration (void) {
+  cout << "Registration" << endl ;
+  const uint32_t keys [] = {
+    ACANMailboxes::key (0x300, false),
+    ACANMailboxes::key (0x100, false),
+    ACANMailboxes::key (0x100, true),
+    ACANMailboxes::key (0x300, false),
+    ACANMailboxes::key (0x200, false)
+  } ;
+  ACANMailboxes mailboxes ;
+  check (mailboxes.initWithKeys (keys, 5), "allocation") ;
+  check (mailboxes.count () == 4, "duplicate not removed") ;
+  for (uint16_t i=1 ; i<mailboxes.count () ; i++) {
+    check (mailboxes.keyAtIndex (i-1) < mailboxes.keyAtIndex (i), "keys not sorted") ;
+  }
+  check (mailboxes.indexOfKey (ACANMailboxes::key (0x100, false)) != mailboxes.indexOfKey (ACANMailboxes::key (0x100, true)),
+         "standard and extended share a mailbox") ;
+  check (mailboxes.indexOfKey (ACANMailboxes::key (0x101, false)) == ACANMailboxes::kNoMailbox, "unknown key found") ;
+  CANMessage frame ;
+  frame.id = 0x555 ;
+  check (!mailboxes.store (frame), "frame without mailbox stored") ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Burst on the virtual bus: 3 senders, 50 mailboxes, the consumer reads only once the burst is over.
+//  Each mailbox must hold the last value sent, its sequence must count every frame, and memory stays 50 slots.
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void burst (void) {
+  cout << "Burst at 500 kbit/s" << endl ;
+  static const uint16_t MAILBOX_COUNT = 50 ;
+  static const uint32_t ROUNDS = 40 ;
+  VirtualCANBus bus (500 * 1000) ;
+  VirtualCANNode senders [3] ;
+  VirtualCANNode receiver ;
+  for (uint32_t s=0 ; s<3 ; s++) {
+    bus.attach (senders [s]) ;
+  }
+  bus.attach (receiver) ;
+  uint32_t keys [MAILBOX_COUNT] ;
+  for (uint16_t i=0 ; i<MAILBOX_COUNT ; i++) {
+    keys [i] = ACANMailboxes::key (0x18FF0000 + i, true) ;
+  }
+  ACANMailboxes mailboxes ;
+  check (mailboxes.initWithKeys (keys, MAILBOX_COUNT), "allocation") ;
+//--- Sender s sends identifiers i with i % 3 == s, payload = round
+  uint64_t now = 0 ;
+  uint32_t sent = 0 ;
+  uint32_t stored = 0 ;
+  for (uint32_t round=0 ; round<ROUNDS ; round++) {
+    for (uint16_t i=0 ; i<MAILBOX_COUNT ; i++) {
+      CANMessage frame ;
+      frame.id = 0x18FF0000 + i ;
+      frame.ext = true ;
+      frame.len = 4 ;
+      frame.data32 [0] = round ;
+      while (!senders [i % 3].tryToSend (frame)) {
+        now += 10 * 1000 ;
+        bus.runUntil (now) ;
+        CANMessage received ;
+        while (receiver.receive (received)) {
+          stored += mailboxes.store (received) ;
+        }
+      }
+      sent += 1 ;
+    }
+  }
+  CANMessage frame ;
+  now += 100ULL * 1000 * 1000 ;
+  bus.runUntil (now) ;
+  while (receiver.receive (frame)) {
+    stored += mailboxes.store (frame) ;
+  }
+  check (stored == sent, "frames lost on the bus") ;
+  cout << "  " << sent << " frames stored in " << mailboxes.count () << " mailboxes, "
+       << mailboxes.overwriteCount () << " overwrites" << endl ;
+  check (mailboxes.overwriteCount () == sent - MAILBOX_COUNT, "wrong overwrite count") ;
+//--- Drain: every mailbox exactly once, with the last round
+  uint16_t index ;
+  uint32_t sequence ;
+  uint32_t visited = 0 ;
+  while (mailboxes.readNextUpdated (index, frame, sequence)) {
+    check (frame.id == 0x18FF0000UL + index, "wrong mailbox") ;
+    check (frame.data32 [0] == ROUNDS - 1, "not the latest value") ;
+    check (sequence == ROUNDS, "wrong sequence") ;
+    visited += 1 ;
+  }
+  check (visited == MAILBOX_COUNT, "updated mailboxes not all visited") ;
+  check (!mailboxes.read (0, frame, sequence), "mailbox still dirty after read") ;
+//--- A single update is the only one reported
+  frame.id = 0x18FF0000 + 42 ;
+  frame.data32 [0] = 1000 ;
+  mailboxes.store (frame) ;
+  check (mailboxes.readNextUpdated (index, frame, sequence), "update not reported") ;
+  check ((index == 42) && (sequence == ROUNDS + 1), "wrong update") ;
+  check (!mailboxes.readNextUpdated (index, frame, sequence), "spurious update") ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+int main (int /* argc */, const char * /* argv */ []) {
+  registration () ;
+  burst () ;
+  cout << "All mailbox tests Ok" << endl ;
+  return 0 ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
@@ -0,0 +1,227 @@
+/******************************************************************************/
+/* File name        : main.cpp                                                */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Compiler         : Desktop C++ COMPILER (Visual Studio Code)               */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation: interrupt handler and critical section profile        */
+/* ---------------------------------------------------------------------------*/
+
+// Build with -pthread
+
+/*------------------------------- Include files ------------------------------*/
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <stdlib.h>
+#include <string.h>
+#include "../src/ACANTrace.cpp"
+#include "../src/ACANProfiler.cpp"
+#include "../simulation-on-desktop/DesktopTest.h"
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+using namespace std;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Log2 buckets
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void buckets (void) {
+  cout << "Log2 buckets" << endl ;
+  check (ACANProfileStatistics::bucket (0) == 0, "bucket of 0") ;
+  check (ACANProfileStatistics::bucket (1) == 1, "bucket of 1") ;
+  check ((ACANProfileStatistics::bucket (2) == 2) && (ACANProfileStatistics::bucket (3) == 2), "bucket of 2, 3") ;
+  check (ACANProfileStatistics::bucket (UINT32_MAX) == 32, "bucket of UINT32_MAX") ;
+  for (uint8_t i=0 ; i<ACANProfileStatistics::kBucketCount ; i++) {
+    const uint32_t lower = ACANProfileStatistics::bucketLowerBound (i) ;
+    const uint32_t upper = ACANProfileStatistics::bucketUpperBound (i) ;
+    check (ACANProfileStatistics::bucket (lower) == i, "lower bound not in its bucket") ;
+    check (ACANProfileStatistics::bucket (upper) == i, "upper bound not in its bucket") ;
+    check ((i == 32) || (ACANProfileStatistics::bucket (upper + 1) == i + 1), "bucket bounds not contiguous") ;
+  }
+//--- Every value against a reference loop
+  for (uint32_t n=0 ; n<100000 ; n++) {
+    const uint32_t value = randomValue () >> (randomValue () % 24) ;
+    uint8_t reference = 0 ;
+    while ((reference < 32) && (value >= (uint64_t (1) << reference))) {
+      reference += 1 ;
+    }
+    check (ACANProfileStatistics::bucket (value) == reference, "bucket against the reference") ;
+  }
+  cout << "  Ok" << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Statistics against the exact values
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void statistics (void) {
+  cout << "Statistics" << endl ;
+  ACANProfileStatistics s ;
+  check ((s.count () == 0) && (s.minimum () == 0) && (s.maximum () == 0) && (s.mean () == 0), "empty statistics") ;
+  check (s.percentile (990) == 0, "empty percentile") ;
+  vector <uint32_t> durations ;
+  uint64_t total = 0 ;
+  for (uint32_t n=0 ; n<50000 ; n++) {
+    const uint32_t d = 100 + (randomValue () >> (8 + randomValue () % 14)) ; // Log spread, as interrupt durations
+    durations.push_back (d) ;
+    total += d ;
+    s.add (d) ;
+  }
+  sort (durations.begin (), durations.end ()) ;
+  check (s.count () == durations.size (), "count") ;
+  check (s.minimum () == durations.front (), "minimum") ;
+  check (s.maximum () == durations.back (), "maximum") ;
+  check (s.total () == total, "total") ;
+  check (s.mean () == uint32_t (total / durations.size ()), "mean") ;
+  uint32_t histogramTotal = 0 ;
+  for (uint8_t i=0 ; i<ACANProfileStatistics::kBucketCount ; i++) {
+    histogramTotal += s.bucketCount (i) ;
+  }
+  check (histogramTotal == s.count (), "histogram total") ;
+  const uint32_t perThousand [] = {500, 900, 990, 999, 1000} ;
+  for (uint32_t p : perThousand) {
+    const uint32_t exact = durations [(durations.size () * p + 999) / 1000 - 1] ;
+    const uint32_t estimated = s.percentile (p) ;
+    check ((estimated >= exact) && (estimated < 2 * exact), "percentile not within a factor 2") ;
+    check (estimated <= s.maximum (), "percentile above the maximum") ;
+    cout << "  p" << (p / 10.0) << ": exact " << exact << ", bucket bound " << estimated << endl ;
+  }
+  check (s.percentile (1000) == s.maximum (), "p100 is not the maximum") ;
+  s.reset () ;
+  check ((s.count () == 0) && (s.total () == 0) && (s.bucketCount (10) == 0), "reset") ;
+  cout << "  Ok" << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Profiler sections, monotonic clock dates (ns)
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void busyWait (const uint32_t inNanoseconds) {
+  const uint32_t start = ACANProfiler::date () ;
+  while ((ACANProfiler::date () - start) < inNanoseconds) {
+  }
+}
+
+//······················································································································
+
+static void sections (void) {
+  cout << "Profiler sections" << endl ;
+  ACANProfiler profiler ;
+  check (ACANProfiler::ticksPerMicrosecond () == 1000, "desktop date unit") ;
+  for (uint32_t n=0 ; n<1000 ; n++) {
+    const uint32_t start = ACANProfiler::date () ;
+    busyWait (2000) ;
+    profiler.record (ACANProfiler::RXHandler, start) ;
+  }
+  profiler.recordDuration (ACANProfiler::InterruptHandler, 5000) ;
+  const ACANProfileStatistics & rx = profiler.statistics (ACANProfiler::RXHandler) ;
+  check (rx.count () == 1000, "RX handler count") ;
+  check (rx.minimum () >= 2000, "RX handler duration below the busy wait") ;
+  check (rx.percentile (500) >= 2000, "RX handler median below the busy wait") ;
+  check (profiler.statistics (ACANProfiler::InterruptHandler).maximum () == 5000, "deferred duration") ;
+  check (profiler.statistics (ACANProfiler::TXHandler).count () == 0, "other section recorded") ;
+  cout << "  RX handler (2 µs busy wait): min " << rx.minimum () << " ns, mean " << rx.mean ()
+       << " ns, p99 " << rx.percentile (990) << " ns, max " << rx.maximum () << " ns" << endl ;
+  check (strcmp (ACANProfiler::sectionName (ACANProfiler::SendCriticalSection), "tryToSend critical section") == 0,
+         "section name") ;
+  profiler.reset () ;
+  for (uint8_t i=0 ; i<ACANProfiler::kSectionCount ; i++) {
+    check (profiler.statistics (ACANProfiler::Section (i)).count () == 0, "reset") ;
+  }
+  cout << "  Ok" << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Lock hold times: an interrupt thread and a task thread share a lock, as the driver spinlock; every record is made
+//  while holding it, as ESP32ACAN does
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static const uint32_t kSectionCount = 100000 ;
+
+static void lockHoldTimes (void) {
+  cout << "Lock hold times" << endl ;
+  ACANProfiler profiler ;
+  mutex lock ;
+  thread interrupt ([&] () {
+    for (uint32_t n=0 ; n<kSectionCount ; n++) {
+      lock.lock () ;
+      const uint32_t lockDate = ACANProfiler::date () ;
+      busyWait ((n % 16 == 0) ? 1000 : 100) ; // Some interrupts handle a burst
+      profiler.record (ACANProfiler::InterruptCriticalSection, lockDate) ;
+      lock.unlock () ;
+    }
+  }) ;
+  thread task ([&] () {
+    for (uint32_t n=0 ; n<kSectionCount ; n++) {
+      lock.lock () ;
+      const uint32_t lockDate = ACANProfiler::date () ;
+      profiler.record (ACANProfiler::SendCriticalSection, lockDate) ;
+      lock.unlock () ;
+    }
+  }) ;
+  interrupt.join () ;
+  task.join () ;
+  const ACANProfileStatistics & isr = profiler.statistics (ACANProfiler::InterruptCriticalSection) ;
+  const ACANProfileStatistics & send = profiler.statistics (ACANProfiler::SendCriticalSection) ;
+  check ((isr.count () == kSectionCount) && (send.count () == kSectionCount), "lost records") ;
+  check (isr.minimum () >= 100, "interrupt hold time below the busy wait") ;
+  check (isr.maximum () >= 1000, "burst hold time not seen") ;
+  check (isr.percentile (999) >= 1000, "burst hold times not in the tail") ;
+  for (const ACANProfileStatistics * s : {& isr, & send}) {
+    cout << "  min " << s->minimum () << " ns, mean " << s->mean () << " ns, p99.9 " << s->percentile (999)
+         << " ns, max " << s->maximum () << " ns; histogram:" ;
+    for (uint8_t i=0 ; i<ACANProfileStatistics::kBucketCount ; i++) {
+      if (s->bucketCount (i) > 0) {
+        cout << " [" << ACANProfileStatistics::bucketLowerBound (i) << "]" << s->bucketCount (i) ;
+      }
+    }
+    cout << endl ;
+  }
+  cout << "  Ok" << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Cost of a profile point: date read and record
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void cost (void) {
+  cout << "Profile point cost" << endl ;
+  ACANProfiler profiler ;
+  const uint32_t kCount = 4 * 1000 * 1000 ;
+  const auto start = chrono::steady_clock::now () ;
+  for (uint32_t i=0 ; i<kCount ; i++) {
+    const uint32_t date = ACANProfiler::date () ;
+    profiler.record (ACANProfiler::ReceiveCriticalSection, date) ;
+  }
+  const double ns = double (chrono::duration_cast <chrono::nanoseconds> (chrono::steady_clock::now () - start).count ()) ;
+  check (profiler.statistics (ACANProfiler::ReceiveCriticalSection).count () == kCount, "record count") ;
+  cout << "  " << (ns / kCount) << " ns per profile point (two steady_clock reads; two cycle counter reads on the ESP32)"
+       << endl ;
+  cout << "  Ok" << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+int main (int /* argc */, const char * /* argv */ []) {
+  buckets () ;
+  statistics () ;
+  sections () ;
+  lockHoldTimes () ;
+  cost () ;
+  cout << "All profiler tests Ok" << endl ;
+  return 0 ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
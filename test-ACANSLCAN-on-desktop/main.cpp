@@ -0,0 +1,442 @@
+/******************************************************************************/
+/* File name        : main.cpp                                                */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Compiler         : Desktop C++ COMPILER (Visual Studio Code)               */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation: SLCAN bridge                                          */
+/* ---------------------------------------------------------------------------*/
+
+// Linux (pseudo terminal)
+
+/*------------------------------- Include files ------------------------------*/
+#include <iostream>
+#include <chrono>
+#include <deque>
+#include <string>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include <sys/ioctl.h>
+#include "../src/ACANSLCAN.cpp"
+#include "../simulation-on-desktop/VirtualCANBus.cpp"
+#include "../simulation-on-desktop/DesktopTest.h"
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+using namespace std;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static CANMessage randomFrame (void) {
+  CANMessage frame ;
+  frame.ext = (randomValue () & 1) != 0 ;
+  frame.id = randomValue () & (frame.ext ? 0x1FFFFFFF : 0x7FF) ;
+  frame.rtr = (randomValue () % 8) == 0 ;
+  frame.len = uint8_t (randomValue () % 9) ;
+  if (!frame.rtr) {
+    for (uint8_t i=0 ; i<frame.len ; i++) {
+      frame.data [i] = uint8_t (randomValue ()) ;
+    }
+  }
+  return frame ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static bool sameFrame (const CANMessage & inA, const CANMessage & inB) {
+  bool same = (inA.id == inB.id) && (inA.ext == inB.ext) && (inA.rtr == inB.rtr) && (inA.len == inB.len) ;
+  for (uint8_t i=0 ; (i<inA.len) && same && !inA.rtr ; i++) {
+    same = inA.data [i] == inB.data [i] ;
+  }
+  return same ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Reference: one printf per field, as the Serial.print based bridges
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static size_t referenceEncode (const CANMessage & inFrame, const uint16_t inTimestamp, char outText [40]) {
+  size_t n = inFrame.ext
+    ? size_t (snprintf (outText, 40, "%c%08X%u", inFrame.rtr ? 'R' : 'T', unsigned (inFrame.id), unsigned (inFrame.len)))
+    : size_t (snprintf (outText, 40, "%c%03X%u", inFrame.rtr ? 'r' : 't', unsigned (inFrame.id), unsigned (inFrame.len))) ;
+  for (uint8_t i=0 ; (i<inFrame.len) && !inFrame.rtr ; i++) {
+    n += size_t (snprintf (&outText [n], 40 - n, "%02X", unsigned (inFrame.data [i]))) ;
+  }
+  if (inTimestamp != ACANSLCAN::kNoTimestamp) {
+    n += size_t (snprintf (&outText [n], 40 - n, "%04X", unsigned (inTimestamp))) ;
+  }
+  outText [n] = '\r' ;
+  return n + 1 ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Frame encoding and decoding
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void frameCoding (void) {
+  cout << "Frame encoding and decoding" << endl ;
+  for (uint32_t i=0 ; i<100 * 1000 ; i++) {
+    const CANMessage frame = randomFrame () ;
+    const uint16_t timestamp = ((i % 2) == 0) ? ACANSLCAN::kNoTimestamp : uint16_t (randomValue () % 60000) ;
+    uint8_t text [ACANSLCAN::kMaxEncodedFrameLength] ;
+    const uint8_t length = ACANSLCAN::encodeFrame (frame, timestamp, text) ;
+    char reference [40] ;
+    const size_t referenceLength = referenceEncode (frame, timestamp, reference) ;
+    check ((length == referenceLength) && (memcmp (text, reference, length) == 0), "encoding differs from the reference") ;
+    const uint8_t commandLength = uint8_t (length - 1 - ((timestamp == ACANSLCAN::kNoTimestamp) ? 0 : 4)) ;
+    CANMessage decoded ;
+    check (ACANSLCAN::decodeFrame (text, commandLength, decoded), "encoded frame not decoded") ;
+    check (sameFrame (frame, decoded), "decoded frame differs") ;
+  }
+//--- Lower case hex digits accepted
+  CANMessage frame ;
+  check (ACANSLCAN::decodeFrame ((const uint8_t *) "T01abcdef2fF00", 14, frame), "lower case hex digits rejected") ;
+  check ((frame.id == 0x1ABCDEF) && frame.ext && (frame.len == 2) && (frame.data [0] == 0xFF), "lower case decoding") ;
+//--- Malformed commands
+  const char * malformed [] = {
+    "", "t", "t12", "t123", "t12345", "t800", "t12G0", "t1231", "t1231123", "t1239", "t123:",
+    "T1234567", "T200000000", "T1234567G0", "r1231AA", "x1230", "t12312G"
+  } ;
+  for (const char * text : malformed) {
+    check (!ACANSLCAN::decodeFrame ((const uint8_t *) text, uint8_t (strlen (text)), frame), text) ;
+  }
+  cout << "  Ok" << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Bridge driver: a node of the virtual bus, with the SLCAN open / close interface of ESP32ACAN
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+class SimulatedDriver : public VirtualCANNode {
+  public: SimulatedDriver (const VirtualCANBus & inBus) :
+  VirtualCANNode (16, 512),
+  mBus (inBus) {
+  }
+
+  public: bool slcanOpen (const uint32_t inBitRate, const bool inListenOnly) {
+    const bool ok = inBitRate == mBus.bitRate () ;
+    if (ok) {
+      mOpenCount += 1 ;
+      mListenOnly = inListenOnly ;
+    }
+    return ok ;
+  }
+
+  public: void slcanClose (void) {
+    mCloseCount += 1 ;
+  }
+
+  public: uint32_t slcanReceiveDropCount (void) const {
+    return uint32_t (mReceiveOverflowCount) ;
+  }
+
+  private: const VirtualCANBus & mBus ;
+  public: uint32_t mOpenCount = 0 ;
+  public: uint32_t mCloseCount = 0 ;
+  public: bool mListenOnly = false ;
+} ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static string command (ACANSLCAN & ioBridge, const char * inCommand) {
+  ioBridge.receiveFromHost ((const uint8_t *) inCommand, strlen (inCommand)) ;
+  const string replies ((const char *) ioBridge.output (), ioBridge.outputLength ()) ;
+  ioBridge.consumeOutput (ioBridge.outputLength ()) ;
+  return replies ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Commands
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+class StalledStream {
+  public: int available (void) { return 16 ; }
+  public: size_t readBytes (char *, const size_t) { mReadCount += 1 ; return 0 ; }
+  public: int availableForWrite (void) { return 0 ; }
+  public: size_t write (const uint8_t *, const size_t) { return 0 ; }
+  public: uint32_t mReadCount = 0 ;
+} ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void commands (void) {
+  cout << "Commands" << endl ;
+  VirtualCANBus bus (500 * 1000) ;
+  SimulatedDriver driver (bus) ;
+  VirtualCANNode peer ;
+  bus.attach (driver) ;
+  bus.attach (peer) ;
+  ACANSLCAN bridge (driver) ;
+  check (command (bridge, "V\r") == "V1013\r", "V") ;
+  check (command (bridge, "N\r") == "NE32A\r", "N") ;
+  check (command (bridge, "t1230\r") == "\a", "send accepted while closed") ;
+  check (command (bridge, "S9\r") == "\a", "S9 accepted") ;
+  check (command (bridge, "S8\r") == "\r", "S8") ;
+  check (bridge.bitRate () == 1000 * 1000, "S8 bit rate") ;
+  check (command (bridge, "O\r") == "\a", "opened at a wrong bit rate") ;
+  check (command (bridge, "s011C\r") == "\r", "s") ; // BRP 2, TSEG1 13, TSEG2 2: 16 tq of 250 ns
+  check (bridge.bitRate () == 250 * 1000, "s bit rate") ;
+  check (command (bridge, "S6\r") == "\r", "S6") ;
+  check (command (bridge, "M00000000\rmFFFFFFFF\r") == "\r\r", "M m") ;
+  check (command (bridge, "Z1\r") == "\r", "Z1") ;
+  check (command (bridge, "L\r") == "\r", "L") ;
+  check (driver.mListenOnly && bridge.isOpen (), "listen only") ;
+  check (command (bridge, "t1230\r") == "\a", "send accepted in listen only mode") ;
+  check (command (bridge, "O\r") == "\a", "opened twice") ;
+  check (command (bridge, "S4\r") == "\a", "bit rate changed while open") ;
+  check (command (bridge, "C\r") == "\r", "C") ;
+  check (driver.mCloseCount == 1, "driver not closed") ;
+  check (command (bridge, "O\r") == "\r", "O") ;
+  check (!driver.mListenOnly && (driver.mOpenCount == 2), "normal mode") ;
+//--- Send, several commands in one read, LF ignored, command split across reads
+  check (command (bridge, "t12321122\rT123456780\r\n") == "z\rZ\r", "send") ;
+  check (command (bridge, "r7F") == "", "partial command answered") ;
+  check (command (bridge, "F0\r") == "z\r", "split command") ;
+  check (bridge.sentFrameCount () == 3, "sent frame count") ;
+//--- Transmit buffer full, status flags
+  string replies ;
+  for (uint32_t i=0 ; i<20 ; i++) {
+    replies += command (bridge, "t0010\r") ;
+  }
+  string expectedReplies ;
+  for (uint32_t i=0 ; i<20 ; i++) {
+    expectedReplies += (i < 13) ? "z\r" : "\a" ; // 3 frames already in the transmit buffer of 16
+  }
+  check (replies == expectedReplies, "transmit buffer full") ;
+  check (bridge.refusedFrameCount () == 7, "refused frame count") ;
+  check (command (bridge, "F\r") == "F02\r", "F after refused frames") ;
+  check (command (bridge, "F\r") == "F00\r", "F not cleared") ;
+  const string longCommand = string (40, 'x') + "\r" ;
+  check (command (bridge, longCommand.c_str ()) == "\a", "long command accepted") ;
+  check (command (bridge, "F\r") == "F10\r", "F after long command") ;
+  check (command (bridge, "X\r") == "\a", "unknown command accepted") ;
+//--- Frames to the host, with timestamps
+  bus.runUntil (100 * 1000 * 1000) ;
+  check (peer.mReceivedFrameCount == 16, "frames not on the bus") ;
+  CANMessage frame ;
+  frame.id = 0x456 ;
+  frame.len = 1 ;
+  frame.data [0] = 0xA5 ;
+  peer.tryToSend (frame) ;
+  bus.runUntil (200 * 1000 * 1000) ;
+  bridge.fillOutput (61234) ;
+  check (string ((const char *) bridge.output (), bridge.outputLength ()) == "t4561A504D2\r", "frame with timestamp") ;
+  bridge.consumeOutput (bridge.outputLength ()) ;
+//--- Driver receive buffer full (not drained by fillOutput): F bit 0, once
+  check (command (bridge, "F\r") == "F00\r", "F before receive drops") ;
+  for (uint32_t i=0 ; (i<1000) && (driver.mReceiveOverflowCount == 0) ; i++) {
+    peer.tryToSend (frame) ;
+    bus.runUntil (bus.date () + 1000 * 1000) ;
+  }
+  check (driver.mReceiveOverflowCount > 0, "driver receive buffer not full") ;
+  check (command (bridge, "F\r") == "F01\r", "F after receive drops") ;
+  check (command (bridge, "F\r") == "F00\r", "receive drops reported twice") ;
+//--- A stream whose readBytes times out although available is not zero: poll returns, and reads at the next call
+  StalledStream stalled ;
+  bridge.poll (stalled, 0) ;
+  check (stalled.mReadCount == 1, "poll does not return on a stalled stream") ;
+  cout << "  Ok" << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Encoding cost: table driven against printf
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void encodingCost (void) {
+  cout << "Encoding cost (8 byte standard frames with timestamp)" << endl ;
+  const uint32_t kFrameCount = 2 * 1000 * 1000 ;
+  CANMessage frame ;
+  frame.len = 8 ;
+  uint8_t text [ACANSLCAN::kMaxEncodedFrameLength] ;
+  char reference [40] ;
+  uint32_t sum = 0 ;
+  const auto start = chrono::steady_clock::now () ;
+  for (uint32_t i=0 ; i<kFrameCount ; i++) {
+    frame.id = i & 0x7FF ;
+    frame.data32 [0] = i ;
+    sum += ACANSLCAN::encodeFrame (frame, uint16_t (i % 60000), text) + text [5] ;
+  }
+  const double tableNs = chrono::duration <double, nano> (chrono::steady_clock::now () - start).count () / kFrameCount ;
+  const auto referenceStart = chrono::steady_clock::now () ;
+  for (uint32_t i=0 ; i<kFrameCount ; i++) {
+    frame.id = i & 0x7FF ;
+    frame.data32 [0] = i ;
+    sum += uint32_t (referenceEncode (frame, uint16_t (i % 60000), reference)) + uint8_t (reference [5]) ;
+  }
+  const double referenceNs = chrono::duration <double, nano> (chrono::steady_clock::now () - referenceStart).count () / kFrameCount ;
+  cout << "  table: " << tableNs << " ns/frame, printf: " << referenceNs << " ns/frame (" << (referenceNs / tableNs)
+       << " x) [" << (sum & 1) << "]" << endl ;
+  cout << "  Ok" << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Pseudo terminal: the bridge writes to the master side, the host peer reads and writes the slave side (raw mode)
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+class PseudoTerminalStream {
+  public: PseudoTerminalStream (const int inFileDescriptor) : mFileDescriptor (inFileDescriptor) {}
+
+  public: int available (void) {
+    int count = 0 ;
+    ioctl (mFileDescriptor, FIONREAD, &count) ;
+    return count ;
+  }
+
+  public: size_t readBytes (char * outBuffer, const size_t inLength) {
+    const ssize_t n = read (mFileDescriptor, outBuffer, inLength) ;
+    return (n > 0) ? size_t (n) : 0 ;
+  }
+
+  public: int availableForWrite (void) { return 4096 ; } // Non blocking: write accepts what the terminal holds
+
+  public: size_t write (const uint8_t * inBuffer, const size_t inLength) {
+    const ssize_t n = ::write (mFileDescriptor, inBuffer, inLength) ;
+    if (n > 0) {
+      mWriteCount += 1 ;
+    }
+    return (n > 0) ? size_t (n) : 0 ;
+  }
+
+  private: const int mFileDescriptor ;
+  public: uint32_t mWriteCount = 0 ;
+} ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+class TrafficRecord {
+  public: const VirtualCANNode * mTrafficNode ;
+  public: deque <CANMessage> mSentFrames ; // By the traffic node, not yet decoded by the host
+} ;
+
+static void recordTraffic (void * inContext, const VirtualCANNode & inSender, const CANMessage & inFrame, const uint64_t) {
+  TrafficRecord * record = (TrafficRecord *) inContext ;
+  if (&inSender == record->mTrafficNode) {
+    record->mSentFrames.push_back (inFrame) ;
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  A 100 % loaded 1 Mbit/s bus (back to back 8 byte standard frames) through the bridge and the pseudo terminal; the
+//  host peer sends frames back. Every frame arrives in order; the frame rate of the whole path (bridge, link, host
+//  decoding) is measured in real time.
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void pseudoTerminal (void) {
+  cout << "Pseudo terminal, 100 % loaded 1 Mbit/s bus" << endl ;
+  const int master = posix_openpt (O_RDWR | O_NOCTTY) ;
+  check ((master >= 0) && (grantpt (master) == 0) && (unlockpt (master) == 0), "cannot open a pseudo terminal") ;
+  const int slave = open (ptsname (master), O_RDWR | O_NOCTTY) ;
+  check (slave >= 0, "cannot open the slave side") ;
+  struct termios attributes ;
+  tcgetattr (slave, &attributes) ;
+  cfmakeraw (&attributes) ;
+  tcsetattr (slave, TCSANOW, &attributes) ;
+  fcntl (master, F_SETFL, fcntl (master, F_GETFL) | O_NONBLOCK) ;
+  fcntl (slave, F_SETFL, fcntl (slave, F_GETFL) | O_NONBLOCK) ;
+  PseudoTerminalStream stream (master) ;
+//--- Bus, traffic node, bridge
+  VirtualCANBus bus (1000 * 1000) ;
+  VirtualCANNode traffic (16, 256) ;
+  SimulatedDriver driver (bus) ;
+  bus.attach (traffic) ;
+  bus.attach (driver) ;
+  TrafficRecord record ;
+  record.mTrafficNode = &traffic ;
+  bus.setObserver (recordTraffic, &record) ;
+  ACANSLCAN bridge (driver) ;
+  const char * openCommands = "S8\rZ1\rO\r" ;
+  check (::write (slave, openCommands, strlen (openCommands)) == ssize_t (strlen (openCommands)), "cannot write") ;
+//--- Run
+  const uint32_t kTrafficFrameCount = 50 * 1000 ;
+  const uint32_t kHostFrameCount = 100 ;
+  uint32_t queuedCount = 0 ;
+  uint32_t hostReceivedCount = 0 ;
+  uint32_t hostSentCount = 0 ;
+  uint32_t replyCount = 0 ;
+  uint64_t linkBytes = 0 ;
+  string line ;
+  uint64_t date = 0 ;
+  const auto start = chrono::steady_clock::now () ;
+  while ((hostReceivedCount < kTrafficFrameCount) || (traffic.mReceivedFrameCount < hostSentCount)) {
+    check (chrono::steady_clock::now () - start < chrono::seconds (60), "stalled") ;
+    while ((queuedCount < kTrafficFrameCount) && traffic.tryToSend ([&] {
+        CANMessage frame ;
+        frame.id = 0x100 + (queuedCount & 0x3FF) ;
+        frame.len = 8 ;
+        frame.data32 [0] = queuedCount ;
+        frame.data32 [1] = ~ queuedCount ;
+        return frame ;
+      } ())) {
+      queuedCount += 1 ;
+    }
+    date += 1000 * 1000 ; // 1 ms
+    bus.runUntil (date) ;
+    bridge.poll (stream, uint32_t (date / 1000000)) ;
+  //--- Host: one frame every 500 traffic frames
+    if ((hostSentCount < kHostFrameCount) && (hostReceivedCount >= (hostSentCount * 500))) {
+      char text [32] ;
+      const int n = snprintf (text, 32, "T%08X1%02X\r", unsigned (0x1000000 + hostSentCount), unsigned (hostSentCount & 0xFF)) ;
+      check (::write (slave, text, size_t (n)) == n, "cannot write") ;
+      hostSentCount += 1 ;
+    }
+  //--- Host: decode what is there
+    char buffer [4096] ;
+    const ssize_t n = read (slave, buffer, sizeof (buffer)) ;
+    for (ssize_t i=0 ; i<n ; i++) {
+      linkBytes += 1 ;
+      if (buffer [i] != '\r') {
+        line += buffer [i] ;
+      }else if ((line == "") || (line == "Z") || (line == "z")) {
+        replyCount += 1 ;
+        line.clear () ;
+      }else{
+        CANMessage frame ;
+        check (ACANSLCAN::decodeFrame ((const uint8_t *) line.data (), uint8_t (line.size () - 4), frame), "host cannot decode") ;
+        check (!record.mSentFrames.empty () && sameFrame (frame, record.mSentFrames.front ()), "frame lost or out of order") ;
+        record.mSentFrames.pop_front () ;
+        hostReceivedCount += 1 ;
+        line.clear () ;
+      }
+    }
+  }
+  const double seconds = chrono::duration <double> (chrono::steady_clock::now () - start).count () ;
+  close (slave) ;
+  close (master) ;
+  check (driver.mReceiveOverflowCount == 0, "bridge driver receive buffer overflow") ;
+  check (replyCount == 3 + kHostFrameCount, "replies") ;
+  check (bridge.sentFrameCount () == kHostFrameCount, "host frames not sent") ;
+  const double busFrameRate = kTrafficFrameCount / (date / 1.0e9) ;
+  const double bytesPerFrame = double (linkBytes) / kTrafficFrameCount ;
+  cout << "  " << kTrafficFrameCount << " frames to the host, " << kHostFrameCount << " from the host, "
+       << bytesPerFrame << " bytes per frame, " << (double (bridge.encodedFrameCount ()) / stream.mWriteCount)
+       << " frames per write" << endl ;
+  cout << "  bus: " << busFrameRate << " frames/s, link needs " << (busFrameRate * bytesPerFrame * 10.0 / 1.0e6)
+       << " Mbaud (8N1)" << endl ;
+  cout << "  sustained by bridge + pseudo terminal + host: " << (kTrafficFrameCount / seconds) << " frames/s" << endl ;
+  cout << "  Ok" << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+int main (int /* argc */, const char * /* argv */ []) {
+  frameCoding () ;
+  commands () ;
+  encodingCost () ;
+  pseudoTerminal () ;
+  cout << "All SLCAN tests Ok" << endl ;
+  return 0 ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
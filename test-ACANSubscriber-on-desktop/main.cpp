@@ -0,0 +1,252 @@
+/******************************************************************************/
+/* File name        : main.cpp                                                */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Compiler         : Desktop C++ COMPILER (Visual Studio Code)               */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation: multi-subscriber fan-out                              */
+/* ---------------------------------------------------------------------------*/
+
+// Build with -pthread
+
+/*------------------------------- Include files ------------------------------*/
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <stdlib.h>
+#include "../src/ACANSubscriber.h"
+#include "../simulation-on-desktop/DesktopTest.h"
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+using namespace std;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static CANMessage frameWithIdentifier (const uint32_t inIdentifier, const bool inExtended, const uint64_t inData) {
+  CANMessage frame ;
+  frame.id = inIdentifier ;
+  frame.ext = inExtended ;
+  frame.len = 8 ;
+  frame.data64 = inData ;
+  return frame ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Identifier filters
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void filters (void) {
+  cout << "Identifier filters" << endl ;
+  ACANSubscriber subscriber ;
+  check (subscriber.matches (frameWithIdentifier (0x123, false, 0)), "no filter: standard frame rejected") ;
+  check (subscriber.matches (frameWithIdentifier (0x1234567, true, 0)), "no filter: extended frame rejected") ;
+  check (subscriber.addIdentifier (0x123, false), "cannot add a standard identifier") ;
+  check (subscriber.addFilter (0x18FEF100, 0x1FFFFF00, true), "cannot add an extended filter") ;
+  check (subscriber.matches (frameWithIdentifier (0x123, false, 0)), "identifier rejected") ;
+  check (!subscriber.matches (frameWithIdentifier (0x124, false, 0)), "other identifier accepted") ;
+  check (!subscriber.matches (frameWithIdentifier (0x123, true, 0)), "extended frame accepted by a standard filter") ;
+  check (subscriber.matches (frameWithIdentifier (0x18FEF1FE, true, 0)), "masked bits compared") ;
+  check (!subscriber.matches (frameWithIdentifier (0x18FEF200, true, 0)), "unmasked bits ignored") ;
+  check (!subscriber.matches (frameWithIdentifier (0x00FEF100, false, 0)), "standard frame accepted by an extended filter") ;
+  while (subscriber.filterCount () < ACANSubscriber::kMaxFilterCount) {
+    check (subscriber.addIdentifier (0x200 + subscriber.filterCount (), false), "cannot add a filter") ;
+  }
+  check (!subscriber.addIdentifier (0x300, false), "too many filters accepted") ;
+  cout << "  Ok" << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Ring: capacity, order, drops
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void ring (void) {
+  cout << "Ring" << endl ;
+  ACANSubscriber subscriber ;
+  check (subscriber.capacity () == 0, "capacity before begin") ;
+  check (subscriber.begin (100), "cannot allocate") ;
+  check (subscriber.capacity () == 128, "capacity not rounded up to a power of two") ;
+  CANMessage frame ;
+  check (!subscriber.receive (frame), "frame received from an empty ring") ;
+  uint32_t next = 0 ;
+  uint32_t expected = 0 ;
+  for (uint32_t round=0 ; round<1000 ; round++) {
+    const uint32_t pushes = randomValue () % 200 ;
+    for (uint32_t i=0 ; i<pushes ; i++) {
+      if (subscriber.count () < subscriber.capacity ()) {
+        check (subscriber.push (frameWithIdentifier (next & 0x7FF, false, next)), "push failed, ring not full") ;
+        next += 1 ;
+      }else{
+        check (!subscriber.push (frameWithIdentifier (0, false, 0)), "push accepted, ring full") ;
+      }
+    }
+    const uint32_t receives = randomValue () % 200 ;
+    for (uint32_t i=0 ; (i<receives) && subscriber.receive (frame) ; i++) {
+      check (frame.data64 == expected, "frame order") ;
+      expected += 1 ;
+    }
+  }
+  while (subscriber.receive (frame)) {
+    check (frame.data64 == expected, "frame order") ;
+    expected += 1 ;
+  }
+  check (expected == next, "frames lost") ;
+  check (subscriber.deliveredCount () == next, "delivered count") ;
+  cout << "  " << next << " frames, " << subscriber.dropCount () << " dropped (ring full)" << endl ;
+  cout << "  Ok" << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Fan-out: subscription rules, every frame to every matching subscriber, unmatched frames reported
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void fanOut (void) {
+  cout << "Fan-out" << endl ;
+  ACANFanOut fanOut ;
+  ACANSubscriber notBegun ;
+  check (!fanOut.subscribe (&notBegun), "subscriber without ring accepted") ;
+  check (!fanOut.subscribe (nullptr), "null subscriber accepted") ;
+  ACANSubscriber subscribers [ACANFanOut::kMaxSubscriberCount + 1] ;
+  for (uint8_t i=0 ; i<=ACANFanOut::kMaxSubscriberCount ; i++) {
+    check (subscribers [i].begin (64), "cannot allocate") ;
+    subscribers [i].addFilter (i, 0x7, false) ; // Identifiers whose 3 low bits are i
+  }
+  for (uint8_t i=0 ; i<ACANFanOut::kMaxSubscriberCount ; i++) {
+    check (fanOut.subscribe (&subscribers [i]), "cannot subscribe") ;
+  }
+  check (!fanOut.subscribe (&subscribers [0]), "subscribed twice") ;
+  check (!fanOut.subscribe (&subscribers [ACANFanOut::kMaxSubscriberCount]), "too many subscribers accepted") ;
+  check (fanOut.unsubscribe (&subscribers [3]), "cannot unsubscribe") ;
+  check (!fanOut.unsubscribe (&subscribers [3]), "unsubscribed twice") ;
+  check (fanOut.subscriberCount () == ACANFanOut::kMaxSubscriberCount - 1, "subscriber count") ;
+  check (fanOut.subscriberAtIndex (3) == &subscribers [4], "subscriber order after unsubscribe") ;
+//--- An extra subscriber for every identifier
+  ACANSubscriber logger ;
+  check (logger.begin (16), "cannot allocate") ;
+  check (fanOut.subscribe (&logger), "cannot subscribe the logger") ;
+  uint32_t unmatchedCount = 0 ;
+  uint32_t withoutLoggerUnmatched = 0 ;
+  for (uint32_t id=0 ; id<40 ; id++) {
+    uint32_t pushed = 0 ;
+    const bool matched = fanOut.dispatch (frameWithIdentifier (id, false, id), pushed) ;
+    check (matched, "frame not matched by the logger") ;
+    const uint8_t owner = id & 7 ;
+    const bool ownerSubscribed = owner != 3 ;
+    const uint8_t ownerIndex = (owner < 3) ? owner : uint8_t (owner - 1) ;
+    const uint32_t expectedPushed = (ownerSubscribed ? (1UL << ownerIndex) : 0)
+                                  | ((id < 16) ? (1UL << (ACANFanOut::kMaxSubscriberCount - 1)) : 0) ;
+    check (pushed == expectedPushed, "pushed subscribers") ;
+    withoutLoggerUnmatched += !ownerSubscribed ;
+  }
+  check (logger.dropCount () == 24, "logger drops") ;
+  check (subscribers [3].deliveredCount () == 0, "frame pushed to an unsubscribed subscriber") ;
+  for (uint8_t i=0 ; i<8 ; i++) {
+    check (subscribers [i].deliveredCount () == ((i == 3) ? 0 : 5), "frames per subscriber") ;
+    check (subscribers [i].dropCount () == 0, "subscriber drops") ;
+  }
+  check (fanOut.unsubscribe (&logger), "cannot unsubscribe the logger") ;
+  for (uint32_t id=0 ; id<40 ; id++) {
+    uint32_t pushed = 0 ;
+    unmatchedCount += !fanOut.dispatch (frameWithIdentifier (id, false, id), pushed) ;
+  }
+  check (unmatchedCount == withoutLoggerUnmatched, "unmatched frames") ;
+  cout << "  Ok" << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Threads: the producer dispatches a 1 Mbit/s bus worth of frames (one every 8 µs); a control loop task reads
+//  its identifiers at once, a logger reads every frame but stalls 20 ms every 500 frames. Every subscriber gets its
+//  frames in order, received + dropped = matched; the logger drops, the control loop does not.
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static const uint32_t kThreadFrameCount = 200 * 1000 ;
+
+class Consumer {
+  public: ACANSubscriber mSubscriber ;
+  public: uint32_t mReceivedCount = 0 ;
+  public: uint32_t mOrderErrorCount = 0 ;
+  public: uint32_t mStallEvery = 0 ;
+
+  public: void run (const atomic <bool> & inProducerDone) {
+    int64_t last = -1 ;
+    CANMessage frame ;
+    bool done = false ;
+    while (!done) {
+      const bool producerDone = inProducerDone ;
+      while (mSubscriber.receive (frame)) {
+        mOrderErrorCount += int64_t (frame.data64) <= last ;
+        last = int64_t (frame.data64) ;
+        mReceivedCount += 1 ;
+        if ((mStallEvery > 0) && ((mReceivedCount % mStallEvery) == 0)) {
+          this_thread::sleep_for (chrono::milliseconds (20)) ;
+        }
+      }
+      done = producerDone ;
+      if (!done) {
+        this_thread::yield () ;
+      }
+    }
+  }
+} ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void threads (void) {
+  cout << "Producer and consumer threads" << endl ;
+  ACANFanOut fanOut ;
+  Consumer control ;
+  check (control.mSubscriber.begin (4096), "cannot allocate") ;
+  control.mSubscriber.addFilter (0x100, 0x700, false) ; // 0x100 ... 0x1FF
+  Consumer logger ;
+  check (logger.mSubscriber.begin (256), "cannot allocate") ;
+  logger.mStallEvery = 500 ;
+  check (fanOut.subscribe (&control.mSubscriber), "cannot subscribe") ;
+  check (fanOut.subscribe (&logger.mSubscriber), "cannot subscribe") ;
+  atomic <bool> producerDone (false) ;
+  thread controlThread ([&] { control.run (producerDone) ; }) ;
+  thread loggerThread ([&] { logger.run (producerDone) ; }) ;
+  uint32_t controlMatchedCount = 0 ;
+  uint32_t unmatchedCount = 0 ;
+  const auto start = chrono::steady_clock::now () ;
+  for (uint32_t i=0 ; i<kThreadFrameCount ; i++) {
+    while ((chrono::steady_clock::now () - start) < chrono::microseconds (8ULL * i)) {
+    }
+    const CANMessage frame = frameWithIdentifier (randomValue () & 0x3FF, false, i) ;
+    controlMatchedCount += control.mSubscriber.matches (frame) ;
+    uint32_t pushed = 0 ;
+    unmatchedCount += !fanOut.dispatch (frame, pushed) ;
+  }
+  producerDone = true ;
+  controlThread.join () ;
+  loggerThread.join () ;
+  check (unmatchedCount == 0, "frame matched by no subscriber (the logger takes every frame)") ;
+  check ((control.mOrderErrorCount == 0) && (logger.mOrderErrorCount == 0), "frame order") ;
+  check (control.mReceivedCount + control.mSubscriber.dropCount () == controlMatchedCount, "control: frames lost") ;
+  check (logger.mReceivedCount + logger.mSubscriber.dropCount () == kThreadFrameCount, "logger: frames lost") ;
+  check (control.mSubscriber.dropCount () == 0, "control loop frames dropped") ;
+  check (logger.mSubscriber.dropCount () > 0, "logger stalls without drop") ;
+  cout << "  control: " << control.mReceivedCount << " received, " << control.mSubscriber.dropCount () << " dropped" << endl ;
+  cout << "  logger: " << logger.mReceivedCount << " received, " << logger.mSubscriber.dropCount () << " dropped" << endl ;
+  cout << "  Ok" << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+int main (int /* argc */, const char * /* argv */ []) {
+  filters () ;
+  ring () ;
+  fanOut () ;
+  threads () ;
+  cout << "All subscriber tests Ok" << endl ;
+  return 0 ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
@@ -0,0 +1,204 @@
+/******************************************************************************/
+/* File name        : main.cpp                                                */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Compiler         : Desktop C++ COMPILER (Visual Studio Code)               */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation: driver event trace ring                               */
+/* ---------------------------------------------------------------------------*/
+
+// Build with -pthread
+
+/*------------------------------- Include files ------------------------------*/
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <stdlib.h>
+#include <string.h>
+#include "../src/ACANTrace.cpp"
+#include "../simulation-on-desktop/DesktopTest.h"
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+using namespace std;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Ring: capacity, order, overwrite of the oldest records
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void ring (void) {
+  cout << "Ring" << endl ;
+  ACANTrace trace ;
+  check (trace.capacity () == 0, "capacity before begin") ;
+  check (trace.begin (100), "begin") ;
+  check (trace.capacity () == 128, "capacity not rounded up to a power of two") ;
+  ACANTraceRecord records [200] ;
+  uint32_t lost = 1 ;
+  check ((trace.snapshot (records, 200, lost) == 0) && (lost == 0), "empty trace") ;
+//--- Without overwrite
+  for (uint16_t i=0 ; i<100 ; i++) {
+    trace.record (kTraceRXDrain, i) ;
+  }
+  uint32_t count = trace.snapshot (records, 200, lost) ;
+  check ((count == 100) && (lost == 0), "snapshot count") ;
+  for (uint16_t i=0 ; i<100 ; i++) {
+    check ((records [i].mEvent == kTraceRXDrain) && (records [i].mPayload == i), "record order") ;
+    check ((i == 0) || (int32_t (records [i].mDate - records [i-1].mDate) >= 0), "dates not increasing") ;
+  }
+//--- Snapshot shorter than the trace: the latest records
+  count = trace.snapshot (records, 10, lost) ;
+  check ((count == 10) && (lost == 90) && (records [0].mPayload == 90), "partial snapshot") ;
+//--- Overwrite: the latest 128 records remain
+  for (uint16_t i=100 ; i<300 ; i++) {
+    trace.record (kTraceTXLoad, i) ;
+  }
+  count = trace.snapshot (records, 200, lost) ;
+  check ((count == 128) && (lost == 172), "overwrite count") ;
+  for (uint32_t i=0 ; i<count ; i++) {
+    check (records [i].mPayload == 172 + i, "overwrite order") ;
+  }
+  trace.clear () ;
+  check ((trace.recordCount () == 0) && (trace.snapshot (records, 200, lost) == 0), "clear") ;
+//--- Capacity limit
+  ACANTrace large ;
+  check (large.begin (100000) && (large.capacity () == 65536), "capacity limit") ;
+  cout << "  Ok" << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Dump coding
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+class StringStream {
+  public: string mText ;
+
+  public: size_t write (const uint8_t * inBytes, const size_t inCount) {
+    mText.append ((const char *) inBytes, inCount) ;
+    return inCount ;
+  }
+} ;
+
+//······················································································································
+
+static void coding (void) {
+  cout << "Dump coding" << endl ;
+//--- Record lines
+  for (uint32_t i=0 ; i<10000 ; i++) {
+    ACANTraceRecord record ;
+    record.mDate = randomValue () ^ (randomValue () << 24) ;
+    record.mPayload = uint16_t (randomValue ()) ;
+    record.mEvent = uint8_t (1 + randomValue () % 255) ;
+    record.mCore = uint8_t (randomValue () % 2) ;
+    char line [ACANTrace::kDumpLineLength] ;
+    ACANTrace::encodeRecord (record, line) ;
+    check (line [ACANTrace::kDumpLineLength - 1] == '\n', "record line end") ;
+    ACANTraceRecord decoded ;
+    check (ACANTrace::decodeRecord (line, decoded), "record line not decoded") ;
+    check ((decoded.mDate == record.mDate) && (decoded.mPayload == record.mPayload)
+        && (decoded.mEvent == record.mEvent) && (decoded.mCore == record.mCore), "record round trip") ;
+  }
+  ACANTraceRecord decoded ;
+  check (!ACANTrace::decodeRecord ("0000000G00000100", decoded), "malformed line decoded") ;
+  check (!ACANTrace::decodeRecord ("0000000000000000", decoded), "event 0 decoded") ;
+  check (strcmp (ACANTrace::eventName (kTraceISREntry), "ISR_ENTRY") == 0, "event name") ;
+  check (strcmp (ACANTrace::eventName (0x85), "USER") == 0, "user event name") ;
+  check (strcmp (ACANTrace::eventName (0x7F), "?") == 0, "unknown event name") ;
+//--- Dump, then parse it as the host decoder does
+  ACANTrace trace ;
+  trace.begin (16) ;
+  for (uint16_t i=0 ; i<20 ; i++) {
+    trace.record (uint8_t (kTraceISREntry + i % 10), uint16_t (i * 1000)) ;
+  }
+  StringStream stream ;
+  stream.mText = "boot message\n" ;
+  check (trace.dump (stream) == 16, "dump count") ;
+  const size_t header = stream.mText.find ("ACANTRACE 01 ") ;
+  check (header != string::npos, "no dump header") ;
+  const string headerLine = stream.mText.substr (header, ACANTrace::kDumpHeaderLength) ;
+  check (headerLine == "ACANTRACE 01 000003E8 00000010 00000004\n", "dump header") ;
+  size_t position = header + ACANTrace::kDumpHeaderLength ;
+  for (uint16_t i=4 ; i<20 ; i++) {
+    check (ACANTrace::decodeRecord (stream.mText.c_str () + position, decoded), "dump record") ;
+    check ((decoded.mEvent == kTraceISREntry + i % 10) && (decoded.mPayload == i * 1000), "dump record value") ;
+    position += ACANTrace::kDumpLineLength ;
+  }
+  check (stream.mText.substr (position) == "ACANTRACE END\n", "dump end") ;
+  cout << "  Ok" << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Concurrent producers (interrupt and tasks on two cores): every record gets its own slot
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static const uint32_t kThreadCount = 4 ;
+static const uint32_t kRecordsPerThread = 16000 ;
+
+static void threads (void) {
+  cout << "Concurrent producers" << endl ;
+  ACANTrace trace ;
+  trace.begin (kThreadCount * kRecordsPerThread) ;
+  vector <thread> producers ;
+  for (uint32_t t=0 ; t<kThreadCount ; t++) {
+    producers.push_back (thread ([&trace, t] () {
+      for (uint32_t i=0 ; i<kRecordsPerThread ; i++) {
+        trace.record (uint8_t (kTraceUser + t), uint16_t (i)) ;
+      }
+    })) ;
+  }
+  for (auto & producer : producers) {
+    producer.join () ;
+  }
+  vector <ACANTraceRecord> records (trace.capacity ()) ;
+  uint32_t lost = 0 ;
+  const uint32_t count = trace.snapshot (records.data (), trace.capacity (), lost) ;
+  check ((count == kThreadCount * kRecordsPerThread) && (lost == 0), "record count") ;
+  uint32_t next [kThreadCount] = {0} ;
+  for (uint32_t i=0 ; i<count ; i++) {
+    const uint32_t t = uint32_t (records [i].mEvent - kTraceUser) ;
+    check (t < kThreadCount, "record overwritten by another producer") ;
+    check (records [i].mPayload == next [t], "records of a producer lost or out of order") ;
+    next [t] += 1 ;
+  }
+  cout << "  Ok" << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Cost of a record
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void cost (void) {
+  cout << "Record cost" << endl ;
+  ACANTrace trace ;
+  trace.begin (1024) ;
+  const uint32_t kCount = 4 * 1000 * 1000 ;
+  const auto start = chrono::steady_clock::now () ;
+  for (uint32_t i=0 ; i<kCount ; i++) {
+    trace.record (kTraceISREntry, uint16_t (i)) ;
+  }
+  const double ns = double (chrono::duration_cast <chrono::nanoseconds> (chrono::steady_clock::now () - start).count ()) ;
+  check (trace.recordCount () == kCount, "record count") ;
+  cout << "  " << (ns / kCount) << " ns per record (steady_clock date; a cycle counter read on the ESP32)" << endl ;
+  cout << "  Ok" << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+int main (int /* argc */, const char * /* argv */ []) {
+  ring () ;
+  coding () ;
+  threads () ;
+  cost () ;
+  cout << "All trace tests Ok" << endl ;
+  return 0 ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
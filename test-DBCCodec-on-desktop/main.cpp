@@ -0,0 +1,234 @@
+/******************************************************************************/
+/* File name        : main.cpp                                                */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Compiler         : Desktop C++ COMPILER (Visual Studio Code)               */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation: codec generated from vehicle.dbc, checked against a   */
+/*          | bit by bit decoder, and decoding benchmark                      */
+/* ---------------------------------------------------------------------------*/
+// vehicle.h is generated by:
+//   dbc-codec-generator vehicle.dbc vehicle.h vehicle --include-prefix ../src/
+
+/*------------------------------- Include files ------------------------------*/
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../src/ACANSignalCodec.h"
+#include "vehicle.h"
+#include "../simulation-on-desktop/DesktopTest.h"
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+using namespace std;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Signal routines are constexpr: checked at compile time
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static_assert (vehicle::EEC1::decodeEngineSpeed (vehicle::EEC1::encodeEngineSpeed (1234.5f)) == 1234.5f, "EEC1") ;
+static_assert (vehicle::ET1::decodeCoolantTemperature (vehicle::ET1::encodeCoolantTemperature (-40)) == -40, "ET1") ;
+static_assert (vehicle::Chassis::decodeYawRate (vehicle::Chassis::encodeYawRate (-12.5f)) == -12.5f, "Chassis") ;
+static_assert (vehicle::Chassis::encodeGear (3) == (3ULL << 23), "Chassis gear, Motorola word") ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static uint64_t randomWord (void) {
+  static uint64_t x = 88172645463325252ULL ;
+  x ^= x << 13 ;
+  x ^= x >> 7 ;
+  x ^= x << 17 ;
+  return x ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Reference: bit by bit extraction, following the .dbc definition
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static double referenceValue (const CANMessage & inFrame, const uint32_t inStartBit, const uint32_t inLength,
+                              const bool inIntel, const bool inSigned, const double inFactor, const double inOffset) {
+  uint64_t raw = 0 ;
+  uint32_t position = inStartBit ;
+  for (uint32_t i=0 ; i<inLength ; i++) {
+    const uint64_t bit = (inFrame.data [position / 8] >> (position % 8)) & 1 ;
+    if (inIntel) {
+      raw |= bit << i ;
+      position += 1 ;
+    }else{
+      raw = (raw << 1) | bit ;
+      position = ((position % 8) == 0) ? (position + 15) : (position - 1) ;
+    }
+  }
+  double value = (double) raw ;
+  if (inSigned && (inLength < 64) && ((raw >> (inLength - 1)) & 1)) {
+    value -= (double) (1ULL << inLength) ;
+  }
+  return value * inFactor + inOffset ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+typedef double (*Getter) (const CANMessage & inFrame) ;
+
+class ReferenceSignal {
+  public: const char * mName ;
+  public: uint32_t mStartBit ;
+  public: uint32_t mLength ;
+  public: bool mIntel ;
+  public: bool mSigned ;
+  public: double mFactor ;
+  public: double mOffset ;
+  public: Getter mGenerated ;
+} ;
+
+#define UNPACK(MESSAGE, SIGNAL) [] (const CANMessage & inFrame) -> double { \
+  vehicle::MESSAGE m ; vehicle::MESSAGE::unpack (inFrame, m) ; return (double) m.SIGNAL ; }
+
+static const ReferenceSignal kReferenceSignals [] = {
+  {"EEC1.DriverDemandTorque", 8, 8, true, false, 1, -125, UNPACK (EEC1, DriverDemandTorque)},
+  {"EEC1.EngineSpeed", 24, 16, true, false, 0.125, 0, UNPACK (EEC1, EngineSpeed)},
+  {"ET1.OilTemperature", 16, 16, true, false, 0.03125, -273, UNPACK (ET1, OilTemperature)},
+  {"WheelSpeeds.FrontLeft", 7, 16, false, false, 0.01, 0, UNPACK (WheelSpeeds, FrontLeft)},
+  {"WheelSpeeds.RearRight", 55, 16, false, false, 0.01, 0, UNPACK (WheelSpeeds, RearRight)},
+  {"Chassis.SteeringAngle", 7, 14, false, true, 0.1, 0, UNPACK (Chassis, SteeringAngle)},
+  {"Chassis.YawRate", 9, 12, false, true, 0.05, 0, UNPACK (Chassis, YawRate)},
+  {"Chassis.LateralAcceleration", 29, 10, false, true, 0.01, 0, UNPACK (Chassis, LateralAcceleration)},
+  {"Chassis.BrakePressed", 35, 1, false, false, 1, 0, UNPACK (Chassis, BrakePressed)},
+  {"Chassis.Gear", 33, 3, false, false, 1, 0, UNPACK (Chassis, Gear)},
+  {"Chassis.Checksum", 63, 8, false, false, 1, 0, UNPACK (Chassis, Checksum)},
+  {"Battery.Current", 16, 16, true, true, 0.05, 0, UNPACK (Battery, Current)},
+  {"Battery.Temperature", 40, 8, true, true, 1, 0, UNPACK (Battery, Temperature)},
+  {"Diagnostics.FaultCode", 40, 24, true, false, 1, 0, UNPACK (Diagnostics, FaultCode)},
+  {"Timestamp.Microseconds", 0, 64, true, false, 1, 0, UNPACK (Timestamp, Microseconds)},
+  {"Extended1000.Position", 0, 24, true, true, 0.001, -100, UNPACK (Extended1000, Position)},
+  {"Extended1000.Speed", 31, 20, false, true, 0.01, 0, UNPACK (Extended1000, Speed)},
+  {"Extended1000.Status", 59, 4, false, false, 1, 0, UNPACK (Extended1000, Status)}
+} ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void checkAgainstReference (void) {
+  cout << "Unpack, against the bit by bit decoder" << endl ;
+  const size_t signalCount = sizeof (kReferenceSignals) / sizeof (kReferenceSignals [0]) ;
+  for (uint32_t i=0 ; i<100000 ; i++) {
+    CANMessage frame ;
+    frame.len = 8 ;
+    frame.data64 = randomWord () ;
+    for (size_t s=0 ; s<signalCount ; s++) {
+      const ReferenceSignal & r = kReferenceSignals [s] ;
+      const double expected = referenceValue (frame, r.mStartBit, r.mLength, r.mIntel, r.mSigned, r.mFactor, r.mOffset) ;
+      const double obtained = r.mGenerated (frame) ;
+      const double magnitude = 1.0 + fabs (expected - r.mOffset) + fabs (r.mOffset) ; // float precision
+      if (fabs (expected - obtained) > 1.0e-6 * magnitude) {
+        cout << "  " << r.mName << ": " << obtained << ", expected " << expected << endl ;
+        check (false, "decoded value") ;
+      }
+    }
+  }
+  cout << "  " << signalCount << " signals x 100000 frames, Ok" << endl << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+// Messages whose raw values are exactly representable as float: pack (unpack (frame)) restores every signal bit
+
+template <typename MESSAGE> static void checkRoundTrip (const char * inName, const uint64_t inSignalBits) {
+  for (uint32_t i=0 ; i<100000 ; i++) {
+    CANMessage frame ;
+    frame.id = MESSAGE::kIdentifier ;
+    frame.ext = MESSAGE::kExtended ;
+    frame.len = MESSAGE::kLength ;
+    frame.data64 = randomWord () ;
+    MESSAGE message ;
+    MESSAGE::unpack (frame, message) ;
+    CANMessage packed ;
+    message.pack (packed) ;
+    check ((packed.id == frame.id) && (packed.ext == frame.ext) && (packed.len == frame.len), "pack header") ;
+    if ((packed.data64 ^ frame.data64) & inSignalBits) {
+      cout << "  " << inName << hex << ": " << frame.data64 << " -> " << packed.data64 << dec << endl ;
+      check (false, "round trip") ;
+    }
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void checkRoundTrips (void) {
+  cout << "Pack (unpack (frame))" << endl ;
+  checkRoundTrip <vehicle::EEC1> ("EEC1", 0xFF0FFFFFFFFFFF0FULL) ;
+  checkRoundTrip <vehicle::ET1> ("ET1", 0x00FFFFFFFFFFFFFFULL) ;
+  checkRoundTrip <vehicle::WheelSpeeds> ("WheelSpeeds", ~ 0ULL) ;
+  checkRoundTrip <vehicle::Chassis> ("Chassis", 0xFF0F003FFFFFFFFFULL) ;
+  checkRoundTrip <vehicle::Battery> ("Battery", 0x0000FFFFFFFFFFFFULL) ;
+  checkRoundTrip <vehicle::Timestamp> ("Timestamp", ~ 0ULL) ;
+  cout << "  6 messages x 100000 frames, Ok" << endl << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  DISPATCH BENCHMARK
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static float gSink ;
+static uint32_t gDecodedCount ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void benchmark (void) {
+  cout << "Dispatch and decode" << endl ;
+  vehicle::Handlers handlers ;
+  handlers.mEEC1 = [] (const vehicle::EEC1 & m) { gSink += m.EngineSpeed + (float) m.ActualEngineTorque ; gDecodedCount += 1 ; } ;
+  handlers.mET1 = [] (const vehicle::ET1 & m) { gSink += m.OilTemperature ; gDecodedCount += 1 ; } ;
+  handlers.mWheelSpeeds = [] (const vehicle::WheelSpeeds & m) { gSink += m.FrontLeft + m.RearRight ; gDecodedCount += 1 ; } ;
+  handlers.mChassis = [] (const vehicle::Chassis & m) { gSink += m.SteeringAngle + m.YawRate ; gDecodedCount += 1 ; } ;
+  handlers.mBattery = [] (const vehicle::Battery & m) { gSink += m.Voltage * m.Current ; gDecodedCount += 1 ; } ;
+  handlers.mExtended1000 = [] (const vehicle::Extended1000 & m) { gSink += m.Speed ; gDecodedCount += 1 ; } ;
+//--- Traffic: the messages of the database, and unknown identifiers
+  const uint32_t keys [] = {
+    vehicle::EEC1::kIdentifier | 0x80000000UL, vehicle::ET1::kIdentifier | 0x80000000UL,
+    vehicle::WheelSpeeds::kIdentifier, vehicle::Chassis::kIdentifier, vehicle::Battery::kIdentifier,
+    vehicle::Extended1000::kIdentifier | 0x80000000UL, 0x7DF, 0x18DAF100UL | 0x80000000UL
+  } ;
+  vector <CANMessage> traffic (4096) ;
+  for (size_t i=0 ; i<traffic.size () ; i++) {
+    const uint32_t key = keys [randomWord () % 8] ;
+    traffic [i].id = key & 0x1FFFFFFFUL ;
+    traffic [i].ext = (key & 0x80000000UL) != 0 ;
+    traffic [i].len = 8 ;
+    traffic [i].data64 = randomWord () ;
+  }
+  const uint32_t ROUNDS = 5000 ;
+  const auto start = chrono::steady_clock::now () ;
+  for (uint32_t r=0 ; r<ROUNDS ; r++) {
+    for (size_t i=0 ; i<traffic.size () ; i++) {
+      vehicle::dispatch (traffic [i], handlers) ;
+    }
+  }
+  const double seconds = chrono::duration <double> (chrono::steady_clock::now () - start).count () ;
+  const double frameCount = (double) ROUNDS * (double) traffic.size () ;
+  check (gDecodedCount > (uint32_t) (frameCount * 0.7), "frames not decoded") ;
+  cout << "  " << (uint64_t) (frameCount / seconds) << " frames/s, " << (seconds * 1.0e9 / frameCount)
+       << " ns/frame (" << gDecodedCount << " decoded, sink " << gSink << ")" << endl << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   MAIN
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+int main (int /* argc */, const char * /* argv */ []) {
+  checkAgainstReference () ;
+  checkRoundTrips () ;
+  benchmark () ;
+  cout << "All signal codec tests Ok" << endl ;
+  return 0 ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
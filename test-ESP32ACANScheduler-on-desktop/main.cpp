@@ -0,0 +1,288 @@
+/******************************************************************************/
+/* File name        : main.cpp                                                */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Compiler         : Desktop C++ COMPILER (Visual Studio Code)               */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation: release order, wrap around, offset spreading        */
+/* ---------------------------------------------------------------------------*/
+
+/*------------------------------- Include files ------------------------------*/
+#include <iostream>
+#include <vector>
+#include <stdlib.h>
+#include "../src/ESP32ACANScheduler.cpp"
+#include "../simulation-on-desktop/DesktopTest.h"
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+using namespace std;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Driver stand-in: records the released frames with the tick date, refuses them when mAccept is false
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+class Release {
+  public: uint32_t mIdentifier ;
+  public: uint32_t mTickDate ;
+} ;
+
+class RecordingDriver {
+  public: vector <Release> mReleases ;
+  public: uint32_t mNow = 0 ;
+  public: bool mAccept = true ;
+  public: void (* mHook) (RecordingDriver & ioDriver, const CANMessage & inMessage) = nullptr ;
+  public: ESP32ACANScheduler * mScheduler = nullptr ;
+  public: uint16_t mHandle = ESP32ACANScheduler::kInvalidHandle ;
+} ;
+
+static bool sendRoutine (void * inDriver, const CANMessage & inMessage) {
+  RecordingDriver * driver = (RecordingDriver *) inDriver ;
+  driver->mReleases.push_back ({inMessage.id, driver->mNow}) ;
+  if (driver->mHook != nullptr) {
+    driver->mHook (*driver, inMessage) ;
+  }
+  return driver->mAccept ;
+}
+
+//······················································································································
+
+static CANMessage frameWithIdentifier (const uint32_t inIdentifier) {
+  CANMessage frame ;
+  frame.id = inIdentifier ;
+  frame.len = 8 ;
+  return frame ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Heap ordering: random periods and offsets, ticks every 1 ms (every release on its date) then every 7 ms (several
+//  releases per tick, handed to the driver in release date order)
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static const uint16_t kMessageCount = 200 ;
+
+static void heapOrdering (const uint32_t inTickStep) {
+  cout << "Heap ordering, tick every " << inTickStep << " ms" << endl ;
+  RecordingDriver driver ;
+  ESP32ACANScheduler scheduler (&driver, sendRoutine) ;
+  check (scheduler.initWithCapacity (kMessageCount), "cannot allocate") ;
+  check (scheduler.addPeriodicMessage (frameWithIdentifier (0), 0, 0) == ESP32ACANScheduler::kInvalidHandle,
+         "null period accepted") ;
+  vector <uint32_t> periods ;
+  vector <uint32_t> offsets ;
+  for (uint16_t i=0 ; i<kMessageCount ; i++) {
+    const uint32_t period = 10 + randomValue () % 991 ;
+    const uint32_t offset = randomValue () % period ;
+    check (scheduler.addPeriodicMessage (frameWithIdentifier (i), period, offset) == i, "handle") ;
+    periods.push_back (period) ;
+    offsets.push_back (offset) ;
+  }
+  check (scheduler.addPeriodicMessage (frameWithIdentifier (0), 10, 0) == ESP32ACANScheduler::kInvalidHandle,
+         "full scheduler accepted a message") ;
+  const uint32_t startDate = 5000 ;
+  const uint32_t duration = 20 * 1000 ;
+  for (driver.mNow = startDate ; driver.mNow <= startDate + duration ; driver.mNow += inTickStep) {
+    scheduler.tick (driver.mNow) ;
+  }
+  const uint32_t lastTick = driver.mNow - inTickStep ;
+//--- Every release of every message, in release date order
+  vector <uint32_t> releaseIndex (kMessageCount, 0) ;
+  uint32_t previousReleaseDate = 0 ;
+  for (const Release & release : driver.mReleases) {
+    const uint32_t i = release.mIdentifier ;
+    const uint32_t releaseDate = startDate + offsets [i] + releaseIndex [i] * periods [i] ;
+    releaseIndex [i] += 1 ;
+    check (release.mTickDate >= releaseDate, "released before its date") ;
+    check ((release.mTickDate - releaseDate) < inTickStep, "released later than the next tick") ;
+    check (releaseDate >= previousReleaseDate, "releases not in date order") ;
+    previousReleaseDate = releaseDate ;
+  }
+  for (uint16_t i=0 ; i<kMessageCount ; i++) {
+    const uint32_t expected = (lastTick - startDate - offsets [i]) / periods [i] + 1 ;
+    check (releaseIndex [i] == expected, "release count") ;
+    ESP32ACANPeriodicStatistics s ;
+    check (scheduler.statistics (i, s), "statistics") ;
+    check (s.mReleaseCount == expected, "statistics release count") ;
+    check (s.mMissedDeadlineCount == 0, "missed deadline without late tick") ;
+    check (s.mMaxJitter < inTickStep, "jitter above the tick step") ;
+  }
+  check (scheduler.missedDeadlineCount () == 0, "missed deadlines") ;
+  cout << "  " << driver.mReleases.size () << " releases of " << kMessageCount << " messages" << endl ;
+//--- Removal keeps the heap ordered
+  for (uint16_t i=0 ; i<kMessageCount ; i+=2) {
+    check (scheduler.removePeriodicMessage (i), "remove") ;
+  }
+  check (!scheduler.removePeriodicMessage (0), "removed twice") ;
+  check (scheduler.count () == kMessageCount / 2, "count after removal") ;
+  driver.mReleases.clear () ;
+  const uint32_t restartDate = driver.mNow ;
+  for ( ; driver.mNow <= restartDate + duration ; driver.mNow += inTickStep) {
+    scheduler.tick (driver.mNow) ;
+  }
+  for (const Release & release : driver.mReleases) {
+    const uint32_t i = release.mIdentifier ;
+    check ((i % 2) == 1, "removed message released") ;
+    const uint32_t phase = (release.mTickDate - startDate - offsets [i]) % periods [i] ;
+    check (phase < inTickStep, "release off its grid after removal") ;
+  }
+  cout << "  Ok" << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  millis () wrap around: first tick 500 ms before 2^32, release dates across it
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void wrapAround (void) {
+  cout << "millis () wrap around" << endl ;
+  RecordingDriver driver ;
+  ESP32ACANScheduler scheduler (&driver, sendRoutine) ;
+  check (scheduler.initWithCapacity (4), "cannot allocate") ;
+  const uint32_t periods [3] = {10, 100, 333} ;
+  for (uint32_t i=0 ; i<3 ; i++) {
+    scheduler.addPeriodicMessage (frameWithIdentifier (i), periods [i], i) ;
+  }
+  const uint32_t startDate = UINT32_MAX - 499 ;
+  uint32_t releaseCount [3] = {0, 0, 0} ;
+  driver.mNow = startDate ;
+  for (uint32_t n=0 ; n<=1000 ; n++) {
+    scheduler.tick (driver.mNow) ;
+    for (const Release & release : driver.mReleases) {
+      const uint32_t i = release.mIdentifier ;
+      check (release.mTickDate == startDate + i + releaseCount [i] * periods [i], "release date across the wrap around") ;
+      releaseCount [i] += 1 ;
+    }
+    driver.mReleases.clear () ;
+    driver.mNow += 1 ;
+  }
+  for (uint32_t i=0 ; i<3 ; i++) {
+    check (releaseCount [i] == (1000 - i) / periods [i] + 1, "release count across the wrap around") ;
+  }
+  check (scheduler.missedDeadlineCount () == 0, "missed deadlines across the wrap around") ;
+//--- A tick 3.5 periods after the next release of the 10 ms message: sent once, 3 periods missed
+  driver.mNow = startDate + 1010 + 35 ;
+  scheduler.tick (driver.mNow) ;
+  ESP32ACANPeriodicStatistics s ;
+  scheduler.statistics (0, s) ;
+  check (s.mMissedDeadlineCount == 3, "missed periods of a late tick") ;
+  uint32_t sentCount = 0 ;
+  for (const Release & release : driver.mReleases) {
+    sentCount += (release.mIdentifier == 0) ? 1 : 0 ;
+  }
+  check (sentCount == 1, "late release not sent once") ;
+//--- Frames refused by the driver count as missed deadlines
+  driver.mAccept = false ;
+  const uint32_t missedBefore = scheduler.missedDeadlineCount () ;
+  for (uint32_t n=0 ; n<10 ; n++) {
+    driver.mNow += 1 ;
+    scheduler.tick (driver.mNow) ;
+  }
+  check (scheduler.missedDeadlineCount () == missedBefore + 1, "refused frame not counted") ;
+  cout << "  Ok" << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Offset spreading: messages added without offset share no release date while the load allows it
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static uint32_t maxReleasesPerTick (RecordingDriver & ioDriver, ESP32ACANScheduler & ioScheduler) {
+  uint32_t result = 0 ;
+  for (uint32_t n=0 ; n<2000 ; n++) {
+    ioDriver.mReleases.clear () ;
+    ioScheduler.tick (ioDriver.mNow) ;
+    result = max (result, uint32_t (ioDriver.mReleases.size ())) ;
+    ioDriver.mNow += 1 ;
+  }
+  return result ;
+}
+
+//······················································································································
+
+static void offsetSpreading (void) {
+  cout << "Offset spreading" << endl ;
+  RecordingDriver driver ;
+  ESP32ACANScheduler scheduler (&driver, sendRoutine) ;
+  check (scheduler.initWithCapacity (32), "cannot allocate") ;
+//--- Ten 10 ms messages: one per ms
+  for (uint32_t i=0 ; i<10 ; i++) {
+    check (scheduler.addPeriodicMessage (frameWithIdentifier (i), 10) != ESP32ACANScheduler::kInvalidHandle, "add") ;
+  }
+  check (maxReleasesPerTick (driver, scheduler) == 1, "10 ms messages not spread") ;
+//--- Harmonic periods, 62 % of the release slots: still one per ms (added to a started scheduler)
+  for (uint32_t i=0 ; i<10 ; i++) {
+    scheduler.removePeriodicMessage (uint16_t (i)) ;
+  }
+  const uint32_t periods [] = {10, 10, 20, 20, 20, 40, 40, 40, 40, 40, 40, 80, 80, 80, 80, 80, 80, 80, 80, 80, 80} ;
+  uint32_t load = 0 ;
+  for (const uint32_t period : periods) {
+    check (scheduler.addPeriodicMessage (frameWithIdentifier (period), period) != ESP32ACANScheduler::kInvalidHandle,
+           "add") ;
+    load += 80 / period ;
+  }
+  check (maxReleasesPerTick (driver, scheduler) == 1, "harmonic messages not spread") ;
+  cout << "  " << (load * 100 / 80) << " % of the 1 ms slots used, one release per tick" << endl ;
+//--- Same messages at offset 0 for comparison
+  ESP32ACANScheduler unspread (&driver, sendRoutine) ;
+  unspread.initWithCapacity (32) ;
+  for (const uint32_t period : periods) {
+    unspread.addPeriodicMessage (frameWithIdentifier (period), period, 0) ;
+  }
+  cout << "  at offset 0: " << maxReleasesPerTick (driver, unspread) << " releases in one tick" << endl ;
+  cout << "  Ok" << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//  Message removed while its frame is handed to the driver, slot given to a new message: the release is not counted
+//  on the new message
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void replaceDuringSend (RecordingDriver & ioDriver, const CANMessage & inMessage) {
+  if (inMessage.id == 1) {
+    ioDriver.mScheduler->removePeriodicMessage (0) ;
+    ioDriver.mHandle = ioDriver.mScheduler->addPeriodicMessage (frameWithIdentifier (2), 1000, 500) ;
+  }
+}
+
+//······················································································································
+
+static void removalDuringSend (void) {
+  cout << "Removal during send" << endl ;
+  RecordingDriver driver ;
+  ESP32ACANScheduler scheduler (&driver, sendRoutine) ;
+  scheduler.initWithCapacity (1) ;
+  driver.mScheduler = &scheduler ;
+  driver.mHook = replaceDuringSend ;
+  check (scheduler.addPeriodicMessage (frameWithIdentifier (1), 10, 0) == 0, "handle") ;
+  scheduler.tick (0) ;
+  check (driver.mHandle == 0, "slot not reused") ;
+  ESP32ACANPeriodicStatistics s ;
+  check (scheduler.statistics (0, s), "statistics") ;
+  check (s.mReleaseCount == 0, "release of the removed message counted on the new one") ;
+  driver.mHook = nullptr ;
+  for (driver.mNow = 1 ; driver.mNow <= 500 ; driver.mNow += 1) {
+    scheduler.tick (driver.mNow) ;
+  }
+  check (scheduler.statistics (0, s) && (s.mReleaseCount == 1), "new message release") ;
+  check (driver.mReleases.size () == 2, "releases") ;
+  cout << "  Ok" << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+int main (int /* argc */, const char * /* argv */ []) {
+  heapOrdering (1) ;
+  heapOrdering (7) ;
+  wrapAround () ;
+  offsetSpreading () ;
+  removalDuringSend () ;
+  cout << "All scheduler tests Ok" << endl ;
+  return 0 ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
@@ -0,0 +1,347 @@
+/******************************************************************************/
+/* File name        : main.cpp                                                */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Compiler         : Desktop C++ COMPILER (Visual Studio Code)               */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation: response time analysis against the virtual bus       */
+/* ---------------------------------------------------------------------------*/
+
+/*------------------------------- Include files ------------------------------*/
+#include <iostream>
+#include <vector>
+#include <map>
+#include <deque>
+#include <chrono>
+#include <stdlib.h>
+#include "../response-time-analysis-on-desktop/CANResponseTimeAnalysis.cpp"
+#include "../simulation-on-desktop/VirtualCANBus.cpp"
+#include "../simulation-on-desktop/DesktopTest.h"
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+using namespace std;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static const uint64_t MS = 1000 * 1000 ; // In ns
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   Simulation: one node per message, releases at k T + offset, queued after a random jitter in [0, J]
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+class SimulatedMessage {
+  public: VirtualCANNode * mNode = NULL ;
+  public: uint64_t mNextRelease = 0 ;       // Nominal
+  public: uint64_t mNextQueuing = 0 ;       // Nominal + jitter
+  public: deque <uint64_t> mPendingReleases ;
+  public: uint64_t mMaxResponseTime = 0 ;
+  public: uint64_t mCompletedCount = 0 ;
+} ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+class Simulation {
+  public: vector <CANAnalysedMessage> mMessages ;
+  public: vector <SimulatedMessage> mSimulated ;
+  public: map <uint64_t, size_t> mIndexFromKey ;
+} ;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static uint64_t frameKey (const uint32_t inIdentifier, const bool inExtended) {
+  return ((uint64_t) inIdentifier << 1) | (inExtended ? 1 : 0) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void frameCompleted (void * inContext,
+                            const VirtualCANNode & /* inSender */,
+                            const CANMessage & inFrame,
+                            const uint64_t inEndDate) {
+  Simulation * simulation = (Simulation *) inContext ;
+  SimulatedMessage & sm = simulation->mSimulated [simulation->mIndexFromKey [frameKey (inFrame.id, inFrame.ext)]] ;
+  const uint64_t release = sm.mPendingReleases.front () ;
+  sm.mPendingReleases.pop_front () ;
+  const uint64_t response = inEndDate - release ;
+  if (sm.mMaxResponseTime < response) {
+    sm.mMaxResponseTime = response ;
+  }
+  sm.mCompletedCount += 1 ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static uint64_t randomBelowOrEqual (const uint64_t inMax) {
+  return (inMax == 0) ? 0 : (((uint64_t) randomValue () * 65536 + (randomValue () & 0xFFFF)) % (inMax + 1)) ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+// inMessages are analysed (priority order); inRandomPhases false: all first releases at 0 (critical instant).
+// Frames carry all zero data: long stuffed frames.
+
+static void simulate (Simulation & ioSimulation,
+                      const uint32_t inBitRate,
+                      const uint64_t inDuration,
+                      const bool inRandomPhases) {
+  const size_t n = ioSimulation.mMessages.size () ;
+  VirtualCANBus bus (inBitRate) ;
+  bus.setObserver (frameCompleted, &ioSimulation) ;
+  ioSimulation.mSimulated.clear () ;
+  ioSimulation.mSimulated.resize (n) ;
+  ioSimulation.mIndexFromKey.clear () ;
+  for (size_t m=0 ; m<n ; m++) {
+    const CANAnalysedMessage & message = ioSimulation.mMessages [m] ;
+    SimulatedMessage & sm = ioSimulation.mSimulated [m] ;
+    sm.mNode = new VirtualCANNode (256, 1) ;
+    bus.attach (*sm.mNode) ;
+    ioSimulation.mIndexFromKey [frameKey (message.mIdentifier, message.mExtended)] = m ;
+    sm.mNextRelease = inRandomPhases ? randomBelowOrEqual (message.mPeriod - 1) : 0 ;
+    sm.mNextQueuing = sm.mNextRelease + randomBelowOrEqual (message.mJitter) ;
+  }
+  bool loop = true ;
+  while (loop) {
+    uint64_t date = UINT64_MAX ;
+    for (size_t m=0 ; m<n ; m++) {
+      date = min (date, ioSimulation.mSimulated [m].mNextQueuing) ;
+    }
+    loop = date < inDuration ;
+    if (loop) {
+      bus.runUntil (date) ;
+      for (size_t m=0 ; m<n ; m++) {
+        const CANAnalysedMessage & message = ioSimulation.mMessages [m] ;
+        SimulatedMessage & sm = ioSimulation.mSimulated [m] ;
+        if (sm.mNextQueuing == date) {
+          CANMessage frame ;
+          frame.id = message.mIdentifier ;
+          frame.ext = message.mExtended ;
+          frame.rtr = message.mRemote ;
+          frame.len = message.mLength ;
+          sm.mPendingReleases.push_back (sm.mNextRelease) ;
+          check (sm.mNode->tryToSend (frame), "node transmit buffer full") ;
+          sm.mNextRelease += message.mPeriod ;
+          sm.mNextQueuing = sm.mNextRelease + randomBelowOrEqual (message.mJitter) ;
+        }
+      }
+    }
+  }
+  bus.runUntil (UINT64_MAX - 1) ;
+  for (size_t m=0 ; m<n ; m++) {
+    check (ioSimulation.mSimulated [m].mPendingReleases.empty (), "frame not sent") ;
+    delete ioSimulation.mSimulated [m].mNode ;
+    ioSimulation.mSimulated [m].mNode = NULL ;
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static CANAnalysedMessage message (const uint32_t inIdentifier,
+                                   const bool inExtended,
+                                   const uint8_t inLength,
+                                   const uint64_t inPeriod,
+                                   const uint64_t inJitter,
+                                   const uint64_t inDeadline = 0) {
+  CANAnalysedMessage result ;
+  result.mIdentifier = inIdentifier ;
+  result.mExtended = inExtended ;
+  result.mLength = inLength ;
+  result.mPeriod = inPeriod ;
+  result.mJitter = inJitter ;
+  result.mDeadline = inDeadline ;
+  return result ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   HAND COMPUTED
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void testHandComputed (void) {
+  cout << "Hand computed response times" << endl ;
+//--- 1 Mbit/s, two 8-byte standard frames (135 bits worst case): each is blocked or delayed by the other
+  vector <CANAnalysedMessage> messages ;
+  messages.push_back (message (0x200, false, 8, 1 * MS, 0)) ;
+  messages.push_back (message (0x100, false, 8, 1 * MS, 0)) ;
+  check (CANResponseTimeAnalysis::analyse (messages, 1000 * 1000) == 0, "unschedulable") ;
+  check (messages [0].mIdentifier == 0x100, "priority order") ;
+  check (messages [0].mTransmissionTime == 135 * 1000, "C") ;
+  check (messages [0].mBlockingTime == 135 * 1000, "B (0x100)") ;
+  check (messages [1].mBlockingTime == 0, "B (0x200)") ;
+  check (messages [0].mResponseTime == 270 * 1000, "R (0x100)") ;
+  check (messages [1].mResponseTime == 270 * 1000, "R (0x200)") ;
+//--- Standard before extended with the same base identifier; jitter adds to the response time
+  messages.clear () ;
+  messages.push_back (message (0x100 << 18, true, 0, 10 * MS, 0)) ;
+  messages.push_back (message (0x100, false, 0, 10 * MS, 1 * MS)) ;
+  CANResponseTimeAnalysis::analyse (messages, 500 * 1000) ;
+  check (!messages [0].mExtended && messages [1].mExtended, "standard wins") ;
+  check (messages [0].mFrameBits == 55, "empty standard frame bits") ;
+  check (messages [1].mFrameBits == 80, "empty extended frame bits") ;
+  check (messages [0].mResponseTime == 1 * MS + 160 * 1000 + 110 * 1000, "R with jitter") ;
+//--- Utilisation >= 1: unbounded
+  messages.clear () ;
+  messages.push_back (message (0x001, false, 8, 540 * 1000, 0)) ;
+  messages.push_back (message (0x002, false, 8, 540 * 1000, 0)) ;
+  check (CANResponseTimeAnalysis::analyse (messages, 500 * 1000) == 1, "unbounded count") ;
+  check (messages [0].mSchedulable, "0x001 schedulable") ;
+  check (messages [1].mResponseTime == CANResponseTimeAnalysis::kUnbounded, "0x002 unbounded") ;
+//--- Duplicate identifiers
+  messages.push_back (message (0x001, false, 2, 10 * MS, 0)) ;
+  CANResponseTimeAnalysis::analyse (messages, 500 * 1000) ;
+  check (CANResponseTimeAnalysis::duplicateIdentifierIndex (messages) == 1, "duplicate identifier") ;
+  cout << "  Ok" << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   SIMULATION NEVER EXCEEDS THE BOUND
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void testAgainstSimulation (const uint32_t inBitRate, const double inTargetUtilisation) {
+  cout << "Simulation at " << (inBitRate / 1000) << " kbit/s, utilisation about "
+       << (int) (inTargetUtilisation * 100.0) << "%" << endl ;
+  static const uint64_t periods [] = {5 * MS, 10 * MS, 20 * MS, 50 * MS, 100 * MS, 200 * MS} ;
+  Simulation simulation ;
+  map <uint64_t, bool> used ;
+  double utilisation = 0.0 ;
+  while (utilisation < inTargetUtilisation) {
+    const bool extended = (randomValue () % 4) == 0 ;
+    const uint32_t identifier = extended ? (randomValue () & 0x1FFFFFFF) : (randomValue () & 0x7FF) ;
+    if (!used [frameKey (identifier, extended)]) {
+      used [frameKey (identifier, extended)] = true ;
+      const uint64_t period = periods [randomValue () % 6] ;
+      const uint64_t jitter = (randomValue () % 2) ? (period / (2 + randomValue () % 8)) : 0 ;
+      simulation.mMessages.push_back (message (identifier, extended, (uint8_t) (randomValue () % 9), period, jitter)) ;
+      const CANAnalysedMessage & m = simulation.mMessages.back () ;
+      CANMessage frame ;
+      frame.ext = m.mExtended ;
+      frame.len = m.mLength ;
+      utilisation += (double) ACANFrameLength::bitLength (frame, ACANFrameLength::WorstCaseStuffing) * 1.0e9
+                   / ((double) inBitRate * (double) period) ;
+    }
+  }
+  CANResponseTimeAnalysis::analyse (simulation.mMessages, inBitRate) ;
+  const size_t n = simulation.mMessages.size () ;
+  vector <uint64_t> observed (n, 0) ;
+  for (uint32_t run=0 ; run<4 ; run++) {
+    simulate (simulation, inBitRate, 2000 * MS, run > 0) ;
+    for (size_t m=0 ; m<n ; m++) {
+      check (simulation.mSimulated [m].mCompletedCount > 0, "message never sent") ;
+      observed [m] = max (observed [m], simulation.mSimulated [m].mMaxResponseTime) ;
+    }
+  }
+  double ratioSum = 0.0 ;
+  uint32_t multipleInstanceCount = 0 ;
+  for (size_t m=0 ; m<n ; m++) {
+    const CANAnalysedMessage & message = simulation.mMessages [m] ;
+    check (message.mResponseTime != CANResponseTimeAnalysis::kUnbounded, "unbounded") ;
+    if (observed [m] > message.mResponseTime) {
+      cout << "  0x" << hex << message.mIdentifier << dec << ": observed " << observed [m]
+           << " ns, bound " << message.mResponseTime << " ns" << endl ;
+    }
+    check (observed [m] <= message.mResponseTime, "observed response time above the bound") ;
+    ratioSum += (double) observed [m] / (double) message.mResponseTime ;
+    if (message.mInstanceCount > 1) {
+      multipleInstanceCount += 1 ;
+    }
+  }
+  cout << "  " << n << " messages, observed / bound: " << (int) (100.0 * ratioSum / (double) n)
+       << "% on average, " << multipleInstanceCount << " with more than one instance in the busy period" << endl ;
+  cout << "  Ok" << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   UNSCHEDULABLE MESSAGE MISSES ITS DEADLINE IN SIMULATION
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+// 0x100 (deadline 700 µs) is released just after 0x200 starts, together with 0x010: it waits for both frames.
+
+static void testUnschedulable (void) {
+  cout << "Unschedulable message" << endl ;
+  Simulation simulation ;
+  simulation.mMessages.push_back (message (0x010, false, 8, 10 * MS, 0)) ;
+  simulation.mMessages.push_back (message (0x100, false, 8, 10 * MS, 0, 700 * 1000)) ;
+  simulation.mMessages.push_back (message (0x200, false, 8, 10 * MS, 0)) ;
+  check (CANResponseTimeAnalysis::analyse (simulation.mMessages, 500 * 1000) == 1, "unschedulable count") ;
+  check (!simulation.mMessages [1].mSchedulable, "0x100 schedulable") ;
+  check (simulation.mMessages [1].mResponseTime == 810 * 1000, "0x100 response time") ;
+//--- 0x200 released at 0, 0x010 and 0x100 1 ns later
+  VirtualCANBus bus (500 * 1000) ;
+  bus.setObserver (frameCompleted, &simulation) ;
+  simulation.mSimulated.resize (3) ;
+  for (size_t m=0 ; m<3 ; m++) {
+    simulation.mSimulated [m].mNode = new VirtualCANNode (4, 1) ;
+    bus.attach (*simulation.mSimulated [m].mNode) ;
+    simulation.mIndexFromKey [frameKey (simulation.mMessages [m].mIdentifier, false)] = m ;
+  }
+  CANMessage frame ;
+  frame.len = 8 ;
+  frame.id = 0x200 ;
+  simulation.mSimulated [2].mPendingReleases.push_back (0) ;
+  simulation.mSimulated [2].mNode->tryToSend (frame) ;
+  bus.runUntil (1) ;
+  for (size_t m=0 ; m<2 ; m++) {
+    frame.id = simulation.mMessages [m].mIdentifier ;
+    simulation.mSimulated [m].mPendingReleases.push_back (1) ;
+    simulation.mSimulated [m].mNode->tryToSend (frame) ;
+  }
+  bus.runUntil (10 * MS) ;
+  const uint64_t observed = simulation.mSimulated [1].mMaxResponseTime ;
+  cout << "  0x100: bound " << simulation.mMessages [1].mResponseTime << " ns, observed " << observed
+       << " ns, deadline 700000 ns" << endl ;
+  check (observed > 700 * 1000, "deadline met in simulation") ;
+  check (observed <= simulation.mMessages [1].mResponseTime, "observed above the bound") ;
+  for (size_t m=0 ; m<3 ; m++) {
+    delete simulation.mSimulated [m].mNode ;
+  }
+  cout << "  Ok" << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   LARGE MATRIX
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static void benchmark (const size_t inMessageCount) {
+  cout << "Analysis of " << inMessageCount << " messages at 1 Mbit/s" << endl ;
+  vector <CANAnalysedMessage> messages ;
+  map <uint32_t, bool> used ;
+  while (messages.size () < inMessageCount) {
+    const uint32_t identifier = randomValue () & 0x1FFFFFFF ;
+    if (!used [identifier]) {
+      used [identifier] = true ;
+      const uint64_t period = (1000 + 10 * (randomValue () % 900)) * MS ;
+      const uint64_t jitter = (randomValue () % 2) ? (period / 10) : 0 ;
+      messages.push_back (message (identifier, true, (uint8_t) (randomValue () % 9), period, jitter)) ;
+    }
+  }
+  const auto start = chrono::steady_clock::now () ;
+  const uint32_t unschedulableCount = CANResponseTimeAnalysis::analyse (messages, 1000 * 1000) ;
+  const auto duration = chrono::duration_cast <chrono::microseconds> (chrono::steady_clock::now () - start) ;
+  double utilisation = 0.0 ;
+  for (size_t m=0 ; m<messages.size () ; m++) {
+    utilisation += (double) messages [m].mTransmissionTime / (double) messages [m].mPeriod ;
+    check (messages [m].mResponseTime != CANResponseTimeAnalysis::kUnbounded, "unbounded") ;
+  }
+  cout << "  Utilisation " << (int) (utilisation * 100.0) << "%, " << unschedulableCount << " unschedulable, "
+       << (double) duration.count () / 1000.0 << " ms" << endl ;
+  cout << "  Ok" << endl ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+int main (int /* argc */, const char * /* argv */ []) {
+  testHandComputed () ;
+  testUnschedulable () ;
+  testAgainstSimulation (500 * 1000, 0.6) ;
+  testAgainstSimulation (500 * 1000, 0.9) ;
+  testAgainstSimulation (125 * 1000, 0.8) ;
+  benchmark (5000) ;
+  cout << "All response time analysis tests Ok" << endl ;
+  return 0 ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
@@ -0,0 +1,226 @@
+/******************************************************************************/
+/* File name        : main.cpp                                                */
+/* Project          : ESP32-CAN-DRIVER                                        */
+/* Compiler         : Desktop C++ COMPILER (Visual Studio Code)               */
+/* ---------------------------------------------------------------------------*/
+/* Copyright        : Copyright © 2019 Pierre Molinaro. All rights reserved.  */
+/* ---------------------------------------------------------------------------*/
+/* Author           : Mohamed Irfanulla                                       */
+/* Supervisor       : Prof. Pierre Molinaro                                   */
+/* Institution      : Ecole Centrale de Nantes                                */
+/* ---------------------------------------------------------------------------*/
+/*  Version | Change                                                          */
+/* ---------------------------------------------------------------------------*/
+/*   V1.0   | Creation                                                        */
+/* ---------------------------------------------------------------------------*/
+
+// Usage: trace-decoder [capture file, default stdin]
+// Decodes the ACANTrace dumps (examples/DriverTrace, ACANTrace::dump) found in a serial monitor capture; other lines
+// are ignored. For each dump, one line per record:
+//   time (µs since the first record of the dump)  core  event  decoded payload
+// then the count of each event and the interrupt handler duration (ISR_ENTRY to ISR_EXIT, same core). Dates are the
+// cycle counter of each core, unwrapped record to record: a gap longer than one counter period (17.9 s at 240 MHz)
+// is not seen. Build: g++ -std=c++11 -O2 main.cpp -o trace-decoder
+
+/*------------------------------- Include files ------------------------------*/
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "../src/ACANTrace.cpp"
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+using namespace std;
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   Payload decoding (register bits: ESP32CANRegisters.h)
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+static string bitNames (const uint16_t inValue, const char * const inNames [8]) {
+  string result ;
+  for (uint8_t bit=0 ; bit<8 ; bit++) {
+    if (((inValue >> bit) & 1) != 0) {
+      result += result.empty () ? "" : "|" ;
+      result += (inNames [bit] != nullptr) ? inNames [bit] : ("bit" + to_string (bit)) ;
+    }
+  }
+  return result.empty () ? "-" : result ;
+}
+
+//······················································································································
+
+static const char * const gInterruptNames [8] = {
+  "RX", "TX", "ERR_WARN", "DATA_OVERRUN", nullptr, "ERR_PASSIVE", "ARB_LOST", "BUS_ERR"
+} ;
+
+static const char * const gModeNames [8] = {
+  "RESET", "LISTEN_ONLY", "SELF_TEST", "SINGLE_FILTER", nullptr, nullptr, nullptr, nullptr
+} ;
+
+//······················································································································
+
+static string payloadText (const ACANTraceRecord & inRecord) {
+  char text [64] ;
+  switch (inRecord.mEvent) {
+  case kTraceISREntry :
+    return "flags " + bitNames (inRecord.mPayload, gInterruptNames) ;
+  case kTraceModeChange :
+    if ((inRecord.mPayload & 0x01) != 0) {
+      return "stopped" ;
+    }
+    return "mode " + ((inRecord.mPayload == 0) ? string ("NORMAL") : bitNames (inRecord.mPayload, gModeNames)) ;
+  case kTraceTXLoad :
+  case kTraceReceiveBufferFull :
+    snprintf (text, sizeof (text), "id 0x%04X (low 16 bits)", unsigned (inRecord.mPayload)) ;
+    return text ;
+  case kTraceISRExit :
+    return "receive buffer " + to_string (inRecord.mPayload) ;
+  case kTraceRXDrain :
+    return to_string (inRecord.mPayload) + " frames" ;
+  case kTraceTXComplete :
+  case kTraceTXQueued :
+  case kTraceTXBufferFull :
+    return "transmit buffer " + to_string (inRecord.mPayload) ;
+  case kTraceDataOverrun :
+    return "overrun " + to_string (inRecord.mPayload) ;
+  default :
+    snprintf (text, sizeof (text), "0x%04X", unsigned (inRecord.mPayload)) ;
+    return text ;
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+//   One dump
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+class Duration {
+  public: uint64_t mMin = UINT64_MAX ;
+  public: uint64_t mMax = 0 ;
+  public: uint64_t mSum = 0 ;
+  public: uint32_t mCount = 0 ;
+
+  public: void add (const uint64_t inTicks) {
+    mMin = (inTicks < mMin) ? inTicks : mMin ;
+    mMax = (inTicks > mMax) ? inTicks : mMax ;
+    mSum += inTicks ;
+    mCount += 1 ;
+  }
+} ;
+
+//······················································································································
+
+static void decodeDump (const uint32_t inTicksPerMicrosecond,
+                        const uint32_t inLostCount,
+                        const vector <ACANTraceRecord> & inRecords) {
+  const double ticksPerMicrosecond = (inTicksPerMicrosecond > 0) ? double (inTicksPerMicrosecond) : 1.0 ;
+  printf ("==== %u records, %u older records overwritten, %u ticks/us\n",
+          unsigned (inRecords.size ()), unsigned (inLostCount), unsigned (inTicksPerMicrosecond)) ;
+  int64_t date [256] = {0} ;           // Ticks since the first record, unwrapped per core
+  uint32_t lastDate [256] = {0} ;
+  bool known [256] = {false} ;
+  bool inISR [256] = {false} ;
+  int64_t isrEntry [256] = {0} ;
+  uint32_t eventCount [256] = {0} ;
+  Duration isr ;
+  for (size_t i=0 ; i<inRecords.size () ; i++) {
+    const ACANTraceRecord & r = inRecords [i] ;
+    const uint8_t core = r.mCore ;
+    if (known [core]) {
+      date [core] += r.mDate - lastDate [core] ;
+    }else{ //--- First record of this core: its counter is close to the one of the previous record
+      known [core] = true ;
+      const ACANTraceRecord & previous = inRecords [(i > 0) ? (i - 1) : 0] ;
+      date [core] = (i > 0) ? (date [previous.mCore] + int32_t (r.mDate - previous.mDate)) : 0 ;
+    }
+    lastDate [core] = r.mDate ;
+    eventCount [r.mEvent] += 1 ;
+    if (r.mEvent == kTraceISREntry) {
+      inISR [core] = true ;
+      isrEntry [core] = date [core] ;
+    }else if ((r.mEvent == kTraceISRExit) && inISR [core]) {
+      inISR [core] = false ;
+      isr.add (uint64_t (date [core] - isrEntry [core])) ;
+    }
+    printf ("%12.3f  %u  %-15s %s\n", double (date [core]) / ticksPerMicrosecond, unsigned (core),
+            ACANTrace::eventName (r.mEvent), payloadText (r).c_str ()) ;
+  }
+  printf ("---- events\n") ;
+  for (uint32_t e=0 ; e<256 ; e++) {
+    if (eventCount [e] > 0) {
+      printf ("  %-15s %u\n", ACANTrace::eventName (uint8_t (e)), unsigned (eventCount [e])) ;
+    }
+  }
+  if (isr.mCount > 0) {
+    printf ("---- interrupt handler: %u runs, min %.3f us, mean %.3f us, max %.3f us\n", unsigned (isr.mCount),
+            double (isr.mMin) / ticksPerMicrosecond, double (isr.mSum) / isr.mCount / ticksPerMicrosecond,
+            double (isr.mMax) / ticksPerMicrosecond) ;
+  }
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+
+int main (int argc, const char * argv []) {
+  if (argc > 2) {
+    fprintf (stderr, "Usage: %s [capture file]\n", argv [0]) ;
+    return 2 ;
+  }
+  FILE * f = (argc == 2) ? fopen (argv [1], "r") : stdin ;
+  if (f == nullptr) {
+    perror (argv [1]) ;
+    return 2 ;
+  }
+  uint32_t dumpCount = 0 ;
+  bool inDump = false ;
+  uint32_t ticksPerMicrosecond = 0 ;
+  uint32_t lostCount = 0 ;
+  uint32_t malformedCount = 0 ;
+  vector <ACANTraceRecord> records ;
+  char line [256] ;
+  while (fgets (line, sizeof (line), f) != nullptr) {
+    const char * header = strstr (line, "ACANTRACE ") ; // Possibly after other output on the same line
+    unsigned version = 0 ;
+    unsigned ticks = 0 ;
+    unsigned count = 0 ;
+    unsigned lost = 0 ;
+    if ((header != nullptr) && (strncmp (header, "ACANTRACE END", 13) == 0)) {
+      if (inDump) {
+        decodeDump (ticksPerMicrosecond, lostCount, records) ;
+        dumpCount += 1 ;
+      }
+      inDump = false ;
+    }else if ((header != nullptr) && (sscanf (header, "ACANTRACE %x %x %x %x", &version, &ticks, &count, &lost) == 4)) {
+      if (inDump) {
+        fprintf (stderr, "Dump without end (%u records read)\n", unsigned (records.size ())) ;
+      }
+      inDump = version == 1 ;
+      ticksPerMicrosecond = ticks ;
+      lostCount = lost ;
+      records.clear () ;
+      records.reserve (count) ;
+      if (!inDump) {
+        fprintf (stderr, "Unknown trace dump version %u\n", version) ;
+      }
+    }else if (inDump) {
+      ACANTraceRecord record ;
+      if ((strlen (line) >= 16) && ACANTrace::decodeRecord (line, record)) {
+        records.push_back (record) ;
+      }else{
+        malformedCount += 1 ;
+      }
+    }
+  }
+  if (f != stdin) {
+    fclose (f) ;
+  }
+  if (malformedCount > 0) {
+    fprintf (stderr, "%u malformed record lines skipped\n", unsigned (malformedCount)) ;
+  }
+  if (dumpCount == 0) {
+    fprintf (stderr, "No trace dump found\n") ;
+    return 1 ;
+  }
+  return 0 ;
+}
+
+//——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————